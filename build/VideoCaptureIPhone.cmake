@@ -23,9 +23,51 @@ set(id ${bd}/include/)
 
 set(videocapture_sources 
   ${sd}/videocapture/Base.cpp
+  ${sd}/videocapture/CaptureStats.cpp
+  ${sd}/videocapture/LatencyHistogram.cpp
+  ${sd}/videocapture/Trace.cpp
+  ${sd}/videocapture/Log.cpp
+  ${sd}/videocapture/Error.cpp
+  ${sd}/videocapture/Metrics.cpp
   ${sd}/videocapture/Capture.cpp
   ${sd}/videocapture/Types.cpp
   ${sd}/videocapture/Utils.cpp
+  ${sd}/videocapture/Thread.cpp
+  ${sd}/videocapture/ThreadPool.cpp
+  ${sd}/videocapture/SliceScheduler.cpp
+  ${sd}/videocapture/Convert.cpp
+  ${sd}/videocapture/ConvertPlan.cpp
+  ${sd}/videocapture/PixelBufferPool.cpp
+  ${sd}/videocapture/MjpegDecoder.cpp
+  ${sd}/videocapture/MjpegDecoderPool.cpp
+  ${sd}/videocapture/H264Decoder.cpp
+  ${sd}/videocapture/JpegMarkers.cpp
+  ${sd}/videocapture/H264Parser.cpp
+  ${sd}/videocapture/FileWriter.cpp
+  ${sd}/videocapture/ContainerWriter.cpp
+  ${sd}/videocapture/AviWriter.cpp
+  ${sd}/videocapture/MkvWriter.cpp
+  ${sd}/videocapture/Mp4Writer.cpp
+  ${sd}/videocapture/Recorder.cpp
+  ${sd}/videocapture/VideoEncoder.cpp
+  ${sd}/videocapture/X264Encoder.cpp
+  ${sd}/videocapture/X265Encoder.cpp
+  ${sd}/videocapture/EncoderSink.cpp
+  ${sd}/videocapture/FrameFile.cpp
+  ${sd}/videocapture/FrameFileReader.cpp
+  ${sd}/videocapture/FrameFileWriter.cpp
+  ${sd}/videocapture/LosslessCodec.cpp
+  ${sd}/videocapture/LosslessRecorder.cpp
+  ${sd}/videocapture/replay/ReplaySource.cpp
+  ${sd}/videocapture/replay/Replay_Capture.cpp
+  ${sd}/videocapture/synthetic/SyntheticPattern.cpp
+  ${sd}/videocapture/synthetic/Synthetic_Capture.cpp
+  ${sd}/videocapture/FramePipeline.cpp
+  ${sd}/videocapture/Rotate.cpp
+  ${sd}/videocapture/Scale.cpp
+  ${sd}/videocapture/Cpu.cpp
+  ${sd}/videocapture/simd/SIMD_Convert_NEON.cpp
+  ${sd}/videocapture/simd/SIMD_Rotate_NEON.cpp
   ${sd}/videocapture/mac/AVFoundation_Capture.cpp
   ${sd}/videocapture/mac/AVFoundation_Implementation.mmo
 )
@@ -10,16 +10,66 @@ set(videocapture_include_dirs
 
 set(videocapture_sources 
   ${sd}/videocapture/Base.cpp
+  ${sd}/videocapture/CaptureStats.cpp
+  ${sd}/videocapture/LatencyHistogram.cpp
+  ${sd}/videocapture/Trace.cpp
+  ${sd}/videocapture/Log.cpp
+  ${sd}/videocapture/Error.cpp
+  ${sd}/videocapture/Metrics.cpp
   ${sd}/videocapture/Capture.cpp
   ${sd}/videocapture/Types.cpp
   ${sd}/videocapture/Utils.cpp
   ${sd}/videocapture/CapabilityFinder.cpp
+  ${sd}/videocapture/Thread.cpp
+  ${sd}/videocapture/ThreadPool.cpp
+  ${sd}/videocapture/SliceScheduler.cpp
+  ${sd}/videocapture/Convert.cpp
+  ${sd}/videocapture/ConvertPlan.cpp
+  ${sd}/videocapture/PixelBufferPool.cpp
+  ${sd}/videocapture/MjpegDecoder.cpp
+  ${sd}/videocapture/MjpegDecoderPool.cpp
+  ${sd}/videocapture/H264Decoder.cpp
+  ${sd}/videocapture/JpegMarkers.cpp
+  ${sd}/videocapture/H264Parser.cpp
+  ${sd}/videocapture/FileWriter.cpp
+  ${sd}/videocapture/ContainerWriter.cpp
+  ${sd}/videocapture/AviWriter.cpp
+  ${sd}/videocapture/MkvWriter.cpp
+  ${sd}/videocapture/Mp4Writer.cpp
+  ${sd}/videocapture/Recorder.cpp
+  ${sd}/videocapture/VideoEncoder.cpp
+  ${sd}/videocapture/X264Encoder.cpp
+  ${sd}/videocapture/X265Encoder.cpp
+  ${sd}/videocapture/EncoderSink.cpp
+  ${sd}/videocapture/FrameFile.cpp
+  ${sd}/videocapture/FrameFileReader.cpp
+  ${sd}/videocapture/FrameFileWriter.cpp
+  ${sd}/videocapture/LosslessCodec.cpp
+  ${sd}/videocapture/LosslessRecorder.cpp
+  ${sd}/videocapture/replay/ReplaySource.cpp
+  ${sd}/videocapture/replay/Replay_Capture.cpp
+  ${sd}/videocapture/synthetic/SyntheticPattern.cpp
+  ${sd}/videocapture/synthetic/Synthetic_Capture.cpp
+  ${sd}/videocapture/FramePipeline.cpp
+  ${sd}/videocapture/Rotate.cpp
+  ${sd}/videocapture/Scale.cpp
+  ${sd}/videocapture/Cpu.cpp
+  ${sd}/videocapture/simd/SIMD_Convert_NEON.cpp
+  ${sd}/videocapture/simd/SIMD_Rotate_NEON.cpp
   ${sd}/videocapture/linux/V4L2_Capture.cpp
   ${sd}/videocapture/linux/V4L2_Types.cpp
   ${sd}/videocapture/linux/V4L2_Utils.cpp
+  ${sd}/videocapture/linux/V4L2_Backend.cpp
+  ${sd}/videocapture/linux/V4L2_FakeDevice.cpp
   ${sd}/videocapture/linux/V4L2_Devices_Default.cpp 
 )
 
+# The NEON kernels are only called when the CPU supports NEON (see Cpu.h).
+if(NOT CMAKE_SYSTEM_PROCESSOR MATCHES "aarch64")
+  set_source_files_properties(${sd}/videocapture/simd/SIMD_Convert_NEON.cpp PROPERTIES COMPILE_FLAGS "-mfpu=neon")
+  set_source_files_properties(${sd}/videocapture/simd/SIMD_Rotate_NEON.cpp PROPERTIES COMPILE_FLAGS "-mfpu=neon")
+endif()
+
 list(APPEND videocapture_libraries
   dl
   rt
@@ -27,6 +77,116 @@ list(APPEND videocapture_libraries
   pthread
   )
 
+if (USE_JPEG)
+
+  # MJPEG decoding, see MjpegDecoder.h
+  find_library(libjpeg jpeg PATHS ${EXTERN_LIB_DIR})
+
+  list(APPEND videocapture_libraries
+    ${libjpeg}
+    )
+
+  add_definitions(
+    -DUSE_JPEG=1
+    )
+
+endif()
+
+if (USE_AVCODEC)
+
+  # H.264 decoding, see H264Decoder.h
+  find_library(libavcodec avcodec PATHS ${EXTERN_LIB_DIR})
+  find_library(libavutil avutil PATHS ${EXTERN_LIB_DIR})
+
+  list(APPEND videocapture_libraries
+    ${libavcodec}
+    ${libavutil}
+    )
+
+  add_definitions(
+    -DUSE_AVCODEC=1
+    )
+
+endif()
+
+if (USE_X264)
+
+  # H.264 encoding, see X264Encoder.h
+  find_library(libx264 x264 PATHS ${EXTERN_LIB_DIR})
+
+  list(APPEND videocapture_libraries
+    ${libx264}
+    )
+
+  add_definitions(
+    -DUSE_X264=1
+    )
+
+endif()
+
+if (USE_X265)
+
+  # H.265 encoding, see X265Encoder.h
+  find_library(libx265 x265 PATHS ${EXTERN_LIB_DIR})
+
+  list(APPEND videocapture_libraries
+    ${libx265}
+    )
+
+  add_definitions(
+    -DUSE_X265=1
+    )
+
+endif()
+
+if (USE_LZ4)
+
+  # Lossless recording, see LosslessCodec.h
+  find_library(liblz4 lz4 PATHS ${EXTERN_LIB_DIR})
+
+  list(APPEND videocapture_libraries
+    ${liblz4}
+    )
+
+  add_definitions(
+    -DUSE_LZ4=1
+    )
+
+endif()
+
+if (USE_ZSTD)
+
+  # Lossless recording, see LosslessCodec.h
+  find_library(libzstd zstd PATHS ${EXTERN_LIB_DIR})
+
+  list(APPEND videocapture_libraries
+    ${libzstd}
+    )
+
+  add_definitions(
+    -DUSE_ZSTD=1
+    )
+
+endif()
+
+if (USE_TRACE)
+
+  # Trace points, see Trace.h
+  add_definitions(
+    -DUSE_TRACE=1
+    )
+
+endif()
+
+if (USE_METRICS)
+
+  # The Prometheus metrics server, see Metrics.h
+  add_definitions(
+    -DUSE_METRICS=1
+    )
+
+endif()
+
 # Video Capture library
 include_directories(${videocapture_include_dirs})
 add_library(videocapture ${videocapture_sources})
@@ -35,5 +195,5 @@ install(TARGETS videocapture ARCHIVE DESTINATION lib)
 
 # API example
 add_executable(api_example ${sd}/api_example.cpp)
-target_link_libraries(api_example ${videocapture_libraries} videocapture)
+target_link_libraries(api_example videocapture ${videocapture_libraries})
 install(TARGETS api_example RUNTIME DESTINATION bin)
\ No newline at end of file
@@ -8,12 +8,84 @@ endif()
 
 set(videocapture_sources 
   ${sd}/videocapture/Base.cpp
+  ${sd}/videocapture/CaptureStats.cpp
+  ${sd}/videocapture/LatencyHistogram.cpp
+  ${sd}/videocapture/Trace.cpp
+  ${sd}/videocapture/Log.cpp
+  ${sd}/videocapture/Error.cpp
+  ${sd}/videocapture/Metrics.cpp
   ${sd}/videocapture/Capture.cpp
   ${sd}/videocapture/Types.cpp
   ${sd}/videocapture/Utils.cpp
   ${sd}/videocapture/CapabilityFinder.cpp
+  ${sd}/videocapture/Thread.cpp
+  ${sd}/videocapture/ThreadPool.cpp
+  ${sd}/videocapture/SliceScheduler.cpp
+  ${sd}/videocapture/Convert.cpp
+  ${sd}/videocapture/ConvertPlan.cpp
+  ${sd}/videocapture/PixelBufferPool.cpp
+  ${sd}/videocapture/MjpegDecoder.cpp
+  ${sd}/videocapture/MjpegDecoderPool.cpp
+  ${sd}/videocapture/H264Decoder.cpp
+  ${sd}/videocapture/JpegMarkers.cpp
+  ${sd}/videocapture/H264Parser.cpp
+  ${sd}/videocapture/FileWriter.cpp
+  ${sd}/videocapture/ContainerWriter.cpp
+  ${sd}/videocapture/AviWriter.cpp
+  ${sd}/videocapture/MkvWriter.cpp
+  ${sd}/videocapture/Mp4Writer.cpp
+  ${sd}/videocapture/Recorder.cpp
+  ${sd}/videocapture/VideoEncoder.cpp
+  ${sd}/videocapture/X264Encoder.cpp
+  ${sd}/videocapture/X265Encoder.cpp
+  ${sd}/videocapture/EncoderSink.cpp
+  ${sd}/videocapture/FrameFile.cpp
+  ${sd}/videocapture/FrameFileReader.cpp
+  ${sd}/videocapture/FrameFileWriter.cpp
+  ${sd}/videocapture/LosslessCodec.cpp
+  ${sd}/videocapture/LosslessRecorder.cpp
+  ${sd}/videocapture/replay/ReplaySource.cpp
+  ${sd}/videocapture/replay/Replay_Capture.cpp
+  ${sd}/videocapture/synthetic/SyntheticPattern.cpp
+  ${sd}/videocapture/synthetic/Synthetic_Capture.cpp
+  ${sd}/videocapture/FramePipeline.cpp
+  ${sd}/videocapture/Rotate.cpp
+  ${sd}/videocapture/Scale.cpp
+  ${sd}/videocapture/Cpu.cpp
 )
 
+# Each SIMD kernel file is compiled for its own instruction set; the kernels
+# are only called when the CPU supports them (see Cpu.h).
+if(CMAKE_SYSTEM_PROCESSOR MATCHES "arm|aarch64|ARM64")
+
+  list(APPEND videocapture_sources
+    ${sd}/videocapture/simd/SIMD_Convert_NEON.cpp
+    ${sd}/videocapture/simd/SIMD_Rotate_NEON.cpp
+    )
+
+else()
+
+  list(APPEND videocapture_sources
+    ${sd}/videocapture/simd/SIMD_Convert_SSE2.cpp
+    ${sd}/videocapture/simd/SIMD_Convert_SSSE3.cpp
+    ${sd}/videocapture/simd/SIMD_Convert_AVX2.cpp
+    ${sd}/videocapture/simd/SIMD_Convert_AVX512.cpp
+    ${sd}/videocapture/simd/SIMD_Rotate_SSE2.cpp
+    )
+
+  if(MSVC)
+    set_source_files_properties(${sd}/videocapture/simd/SIMD_Convert_AVX2.cpp PROPERTIES COMPILE_FLAGS "/arch:AVX2")
+    set_source_files_properties(${sd}/videocapture/simd/SIMD_Convert_AVX512.cpp PROPERTIES COMPILE_FLAGS "/arch:AVX512")
+  else()
+    set_source_files_properties(${sd}/videocapture/simd/SIMD_Convert_SSE2.cpp PROPERTIES COMPILE_FLAGS "-msse2")
+    set_source_files_properties(${sd}/videocapture/simd/SIMD_Convert_SSSE3.cpp PROPERTIES COMPILE_FLAGS "-mssse3")
+    set_source_files_properties(${sd}/videocapture/simd/SIMD_Convert_AVX2.cpp PROPERTIES COMPILE_FLAGS "-mavx2")
+    set_source_files_properties(${sd}/videocapture/simd/SIMD_Convert_AVX512.cpp PROPERTIES COMPILE_FLAGS "-mavx512f -mavx512bw")
+    set_source_files_properties(${sd}/videocapture/simd/SIMD_Rotate_SSE2.cpp PROPERTIES COMPILE_FLAGS "-msse2")
+  endif()
+
+endif()
+
 set(videocapture_include_dirs 
   ${id}
   ${EXTERN_INC_DIR}
@@ -24,6 +96,116 @@ set(gl_sources
   ${EXTERN_SRC_DIR}/glad.c
   )
 
+if (USE_JPEG)
+
+  # MJPEG decoding, see MjpegDecoder.h
+  find_library(libjpeg jpeg PATHS ${EXTERN_LIB_DIR})
+
+  list(APPEND videocapture_libraries
+    ${libjpeg}
+    )
+
+  add_definitions(
+    -DUSE_JPEG=1
+    )
+
+endif()
+
+if (USE_AVCODEC)
+
+  # H.264 decoding, see H264Decoder.h
+  find_library(libavcodec avcodec PATHS ${EXTERN_LIB_DIR})
+  find_library(libavutil avutil PATHS ${EXTERN_LIB_DIR})
+
+  list(APPEND videocapture_libraries
+    ${libavcodec}
+    ${libavutil}
+    )
+
+  add_definitions(
+    -DUSE_AVCODEC=1
+    )
+
+endif()
+
+if (USE_X264)
+
+  # H.264 encoding, see X264Encoder.h
+  find_library(libx264 x264 PATHS ${EXTERN_LIB_DIR})
+
+  list(APPEND videocapture_libraries
+    ${libx264}
+    )
+
+  add_definitions(
+    -DUSE_X264=1
+    )
+
+endif()
+
+if (USE_X265)
+
+  # H.265 encoding, see X265Encoder.h
+  find_library(libx265 x265 PATHS ${EXTERN_LIB_DIR})
+
+  list(APPEND videocapture_libraries
+    ${libx265}
+    )
+
+  add_definitions(
+    -DUSE_X265=1
+    )
+
+endif()
+
+if (USE_LZ4)
+
+  # Lossless recording, see LosslessCodec.h
+  find_library(liblz4 lz4 PATHS ${EXTERN_LIB_DIR})
+
+  list(APPEND videocapture_libraries
+    ${liblz4}
+    )
+
+  add_definitions(
+    -DUSE_LZ4=1
+    )
+
+endif()
+
+if (USE_ZSTD)
+
+  # Lossless recording, see LosslessCodec.h
+  find_library(libzstd zstd PATHS ${EXTERN_LIB_DIR})
+
+  list(APPEND videocapture_libraries
+    ${libzstd}
+    )
+
+  add_definitions(
+    -DUSE_ZSTD=1
+    )
+
+endif()
+
+if (USE_TRACE)
+
+  # Trace points, see Trace.h
+  add_definitions(
+    -DUSE_TRACE=1
+    )
+
+endif()
+
+if (USE_METRICS)
+
+  # The Prometheus metrics server, see Metrics.h
+  add_definitions(
+    -DUSE_METRICS=1
+    )
+
+endif()
+
 if (USE_DECKLINK)
 
   list(APPEND videocapture_sources
@@ -90,6 +272,8 @@ if(UNIX AND NOT APPLE)
     ${sd}/videocapture/linux/V4L2_Capture.cpp
     ${sd}/videocapture/linux/V4L2_Types.cpp
     ${sd}/videocapture/linux/V4L2_Utils.cpp
+    ${sd}/videocapture/linux/V4L2_Backend.cpp
+    ${sd}/videocapture/linux/V4L2_FakeDevice.cpp
     )
 
   # Use the Udev backend to query for capture devices; otherwise use V4L2 defaults.
@@ -111,6 +295,10 @@ if(UNIX AND NOT APPLE)
 
   add_definitions(-D__STDC_CONSTANT_MACROS)
 
+  list(APPEND videocapture_libraries
+    pthread
+    )
+
   if(USE_OPENGL)
     list(APPEND videocapture_libraries
       ${EXTERN_LIB_DIR}/libglfw3.a
@@ -204,13 +392,13 @@ if(USE_OPENGL AND NOT USE_IOS)
 
   # Plain OpenGL example
   # add_executable(opengl_example ${sd}/opengl_example.cpp) 
-  # target_link_libraries(opengl_example ${videocapture_libraries} videocapture)
+  # target_link_libraries(opengl_example videocapture ${videocapture_libraries})
   # add_dependencies(opengl_example videocapture)
   # install(TARGETS opengl_example RUNTIME DESTINATION bin)
 
   # Using the simple wrapper
   add_executable(easy_opengl_example ${sd}/easy_opengl_example.cpp ${gl_sources}) 
-  target_link_libraries(easy_opengl_example ${videocapture_libraries} videocapture${debug_flag})
+  target_link_libraries(easy_opengl_example videocapture${debug_flag} ${videocapture_libraries})
   add_dependencies(easy_opengl_example videocapture${debug_flag})
   install(TARGETS easy_opengl_example RUNTIME DESTINATION bin)
 
@@ -218,16 +406,24 @@ endif()
 
 if (NOT USE_IOS)
   add_executable(api_example ${sd}/api_example.cpp)
-  target_link_libraries(api_example ${videocapture_libraries} videocapture${debug_flag})
+  target_link_libraries(api_example videocapture${debug_flag} ${videocapture_libraries})
   install(TARGETS api_example RUNTIME DESTINATION bin)
 
   add_executable(test_conversion ${sd}/test_conversion.cpp)
-  target_link_libraries(test_conversion ${videocapture_libraries} videocapture${debug_flag})
+  target_link_libraries(test_conversion videocapture${debug_flag} ${videocapture_libraries})
   install(TARGETS test_conversion RUNTIME DESTINATION bin)
 
   add_executable(test_capability_filter ${sd}/test_capability_filter.cpp)
-  target_link_libraries(test_capability_filter ${videocapture_libraries} videocapture${debug_flag})
+  target_link_libraries(test_capability_filter videocapture${debug_flag} ${videocapture_libraries})
   install(TARGETS test_capability_filter RUNTIME DESTINATION bin)
+
+  add_executable(test_cpu_dispatch ${sd}/test_cpu_dispatch.cpp)
+  target_link_libraries(test_cpu_dispatch videocapture${debug_flag} ${videocapture_libraries})
+  install(TARGETS test_cpu_dispatch RUNTIME DESTINATION bin)
+
+  add_executable(test_kernel_benchmark ${sd}/test_kernel_benchmark.cpp)
+  target_link_libraries(test_kernel_benchmark videocapture${debug_flag} ${videocapture_libraries})
+  install(TARGETS test_kernel_benchmark RUNTIME DESTINATION bin)
       
 endif()
 
@@ -235,18 +431,28 @@ if (UNIX AND NOT APPLE)
   
   # Experiment to retrieve device information using udev.
   add_executable(test_v4l2_devices ${sd}/test_v4l2_devices.cpp)
-  target_link_libraries(test_v4l2_devices ${videocapture_libraries} videocapture${debug_flag})
+  target_link_libraries(test_v4l2_devices videocapture${debug_flag} ${videocapture_libraries})
   install(TARGETS test_v4l2_devices RUNTIME DESTINATION bin)
 
   # Test device list 
   add_executable(test_linux_device_list ${sd}/test_linux_device_list.cpp)
-  target_link_libraries(test_linux_device_list ${videocapture_libraries} videocapture${debug_flag})
+  target_link_libraries(test_linux_device_list videocapture${debug_flag} ${videocapture_libraries})
   install(TARGETS test_linux_device_list RUNTIME DESTINATION bin)
+
+  # Throughput and latency benchmark against vivid or fake V4L2 devices, see benchmark_v4l2.sh
+  add_executable(test_v4l2_benchmark ${sd}/test_v4l2_benchmark.cpp)
+  target_link_libraries(test_v4l2_benchmark videocapture${debug_flag} ${videocapture_libraries})
+  install(TARGETS test_v4l2_benchmark RUNTIME DESTINATION bin)
+
+  # Stall watchdog recovery against a fake V4L2 device
+  add_executable(test_v4l2_watchdog ${sd}/test_v4l2_watchdog.cpp)
+  target_link_libraries(test_v4l2_watchdog videocapture${debug_flag} ${videocapture_libraries})
+  install(TARGETS test_v4l2_watchdog RUNTIME DESTINATION bin)
   
 endif()
 
 if (USE_DECKLINK)
   add_executable(decklink_example ${sd}/decklink_example.cpp)
-  target_link_libraries(decklink_example ${videocapture_libraries} videocapture${debug_flag})
+  target_link_libraries(decklink_example videocapture${debug_flag} ${videocapture_libraries})
   install(TARGETS decklink_example RUNTIME DESTINATION bin)
 endif()
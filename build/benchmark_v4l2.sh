@@ -0,0 +1,39 @@
+#!/bin/bash
+
+# Runs the V4L2 benchmark (test_v4l2_benchmark) against the vivid virtual
+# video driver and writes the results to benchmark_v4l2_<date>.json. We
+# load vivid with as many devices as we benchmark when it's not loaded
+# yet (that needs sudo); without vivid the benchmark uses fake devices.
+#
+#   ./benchmark_v4l2.sh
+#   num_devs=2 ./benchmark_v4l2.sh --formats yuyv422 --duration 10
+#   bin_dir=/opt/videocapture/bin ./benchmark_v4l2.sh
+#
+# Extra arguments are passed to test_v4l2_benchmark, see its --help.
+
+d=${PWD}
+
+if [ "${num_devs}" = "" ] ; then
+    num_devs=4
+fi
+
+if [ "${bin_dir}" = "" ] ; then
+    bin_dir=${d}/../install/linux-gcc-x86_64/bin
+fi
+
+# vivid: every device is a webcam-like capture device (node_types=0x1).
+if [ ! -d /sys/module/vivid ] ; then
+    opts=""
+    for (( i=0; i<${num_devs}; i++ )) ; do
+        if [ "${opts}" != "" ] ; then
+            opts="${opts},"
+        fi
+        opts="${opts}0x1"
+    done
+    sudo modprobe vivid n_devs=${num_devs} node_types=${opts} || echo "Warning: cannot load vivid; we use fake devices."
+fi
+
+result=${d}/benchmark_v4l2_$(date +%Y%m%d_%H%M%S).json
+
+cd ${bin_dir}
+./test_v4l2_benchmark --devices ${num_devs} --json ${result} "$@"
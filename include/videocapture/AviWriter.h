@@ -0,0 +1,85 @@
+/*
+
+  AviWriter
+  ---------
+
+  Writes MJPEG frames into an AVI file with the OpenDML (AVI 2.0)
+  extensions, so recordings aren't limited to 1 GB (or 2 GB):
+
+     - The file is split into RIFF segments of at most 1 GB: the first
+       one is a normal 'AVI ' RIFF that old players can read, the others
+       are 'AVIX' RIFFs.
+     - Every segment ends with a standard index ('ix00') and the header
+       has a super index ('indx') that points to them. The first segment
+       also gets the legacy 'idx1' index.
+
+  The index of the current segment is the only thing that grows while
+  recording. It's reserved when the file is opened and reused for every
+  segment, so we don't allocate per frame.
+
+  AVI has a constant frame rate. To keep the file in sync with the
+  timestamps we insert empty frames (0 byte chunks, which players show as
+  a repeated frame) when the camera dropped frames.
+
+ */
+#ifndef VIDEO_CAPTURE_AVI_WRITER_H
+#define VIDEO_CAPTURE_AVI_WRITER_H
+
+#include <vector>
+#include <videocapture/FileWriter.h>
+#include <videocapture/ContainerWriter.h>
+
+namespace ca {
+
+  struct AviIndexEntry {                                                            /* A frame in the current RIFF segment. */
+    uint64_t offset;                                                                /* File offset of the chunk header. */
+    uint32_t size;                                                                  /* Size of the chunk data. */
+    bool keyframe;                                                                  /* Is true for key frames. */
+  };
+
+  struct AviSuperIndexEntry {                                                       /* A standard index ('ix00') of a RIFF segment. */
+    uint64_t offset;                                                                /* File offset of the 'ix00' chunk. */
+    uint32_t size;                                                                  /* Size of the chunk, including its header. */
+    uint32_t duration;                                                              /* The number of frames it indexes. */
+  };
+
+  class AviWriter : public ContainerWriter {
+  public:
+    AviWriter();
+    ~AviWriter();
+    int open(const std::string& filepath, int width, int height, int fmt, int fps);
+    int close();
+    int writeFrame(const DataChunk* chunks, int nchunks, uint64_t timestamp, bool keyframe);
+    uint64_t getNumFrames();
+
+  private:
+    int writeHeader();                                                              /* Writes the 'AVI ' RIFF header and starts the first 'movi' list. */
+    int writeChunk(const DataChunk* chunks, int nchunks, bool keyframe);            /* Writes a '00dc' chunk and adds it to the index; starts a new segment when the current one is full. */
+    int beginSegment();                                                             /* Starts an 'AVIX' RIFF with a 'movi' list. */
+    int endSegment();                                                               /* Writes the indices of the current segment and patches its sizes. */
+
+  private:
+    FileWriter file;                                                                /* The output. */
+    std::vector<AviIndexEntry> index;                                               /* The frames in the current segment. */
+    std::vector<AviSuperIndexEntry> super_index;                                    /* The standard indices of the finished segments. */
+    int width;                                                                      /* The frame width. */
+    int height;                                                                     /* The frame height. */
+    uint32_t rate;                                                                  /* The frame rate times 100, e.g. 2997; the scale is 100 (see CA_FPS_*). */
+    uint64_t frame_duration;                                                        /* The duration of a frame in nanoseconds. */
+    uint64_t first_timestamp;                                                       /* The timestamp of the first frame. */
+    uint64_t num_frames;                                                            /* The number of frames (including the empty ones we inserted). */
+    uint64_t num_first_frames;                                                      /* The number of frames in the first segment. */
+    uint32_t max_chunk_size;                                                        /* The size of the largest frame; used for the suggested buffer size. */
+    uint64_t riff_offset;                                                           /* File offset of the current 'RIFF'. */
+    uint64_t movi_offset;                                                           /* File offset of the current 'LIST' 'movi'. */
+    uint64_t hdrl_offset;                                                           /* File offset of the 'LIST' 'hdrl'. */
+    uint64_t avih_offset;                                                           /* File offset of the 'avih' data. */
+    uint64_t strh_offset;                                                           /* File offset of the 'strh' data. */
+    uint64_t indx_offset;                                                           /* File offset of the 'indx' data. */
+    uint64_t dmlh_offset;                                                           /* File offset of the 'dmlh' data. */
+    bool is_first_segment;                                                          /* Is true while we write into the 'AVI ' RIFF. */
+  };
+
+} /* namespace ca */
+
+#endif
@@ -17,6 +17,7 @@
 #include <vector>
 #include <videocapture/Types.h>
 #include <videocapture/Utils.h>
+#include <videocapture/CaptureStats.h>
 
 namespace ca {
   
@@ -38,10 +39,14 @@ namespace ca {
     int listCapabilities(int device);                                            /* List the available capabilities for the given device. */
     int listOutputFormats();                                                     /* List the available output formats the at SDK of the OS/.. supports. On mac these are the output formats of the AVCaptureVideoDataOutput */
     int findCapability(int device, int width, int height, int fmt);              /* Get the best matching capability for the given format and dimensions. We return the capability index or -1 if not found. */
+    int getStats(StreamStats& result);                                           /* Copies the stats of the stream, see CaptureStats.h. Can be called from any thread. Returns 0 on success. */
+    int getLatency(int which, LatencyHistogram& result);                         /* Copies a CA_LATENCY_* histogram, see CaptureStats.h. Can be called from any thread. Returns 0 on success. */
+    int resetLatency();                                                          /* Clears the latency histograms. Can be called from any thread. Returns 0 on success. */
 
   public:
     frame_callback cb_frame;                                                      /* The frame callback. */
     void* cb_user;                                                                /* The user pointer that is passed into the frame callback. */
+    CaptureStats stats;                                                           /* Updated by the implementation on the capture thread, see CaptureStats.h. */
   };
 
 }; // namespace ca
@@ -25,6 +25,12 @@
   conversion from CA_JPEG_OPENDML to CA_YUYV422. In this case we set the format
   member of the given `Settings` parameter in `findSettingsForFormat()`.
 
+  When several capabilities match the filters equally well (same score and
+  fps), `findSettingsForFormat()` picks the one that is cheapest to deliver
+  in the requested format: a native one when possible, otherwise the one
+  with the cheapest conversion according to the conversion planner (see
+  ConvertPlan.h).
+
   Quick Tip!
   ----------
   
@@ -54,6 +60,7 @@ class CapabilityFinder {
   int addFilter(int attribute, double value, int priority);               /* Add a filter, see the info at the top of this document for more info. */
   int findSettingsForFormat(int device, int format, Settings& result);    /* Will return the best matching Settings (if found) based on the added filters. */ 
   std::vector<Capability> filterCapabilities(int device);                 /* Returns an vector of capabilities that matches any of the added filters. */
+  double conversionCost(const Capability& capability, int format);        /* Returns the cost to deliver frames of the capability in `format`; 0 when it's native, < 0 when it can't be delivered in that format. */
   
  public:
   Capture& cap;                                                           /* Reference to the capture instance. */
@@ -20,6 +20,8 @@
 #include <stdio.h>
 #include <vector>
 #include <videocapture/Types.h>
+#include <videocapture/Log.h>
+#include <videocapture/Error.h>
 
 #if defined(__APPLE__)
 #  include <videocapture/mac/AVFoundation_Capture.h>
@@ -33,6 +35,9 @@
 #  include <videocapture/decklink/Decklink.h>
 #endif
 
+#include <videocapture/replay/Replay_Capture.h>
+#include <videocapture/synthetic/Synthetic_Capture.h>
+
 namespace ca {
 
   class Capture {
@@ -61,6 +66,11 @@ namespace ca {
     int findCapability(int device, int width, int height, int* fmt, int nfmts);                 /* Test several different capture formats. */
     int findCapability(int device, std::vector<Capability> caps);                               /* Test the given capabilities in order and return the best one available. It wil the first found capability or -1 when none was found. */
 
+    /* Monitoring */
+    int getStats(StreamStats& result);                                                          /* Copies the frame rate, drops, callback time, etc. of the stream; lock free, can be called from any thread. See CaptureStats.h. */
+    int getLatency(int which, LatencyHistogram& result);                                        /* Copies the latency histogram CA_LATENCY_DEQUEUE, CA_LATENCY_DELIVER, CA_LATENCY_CALLBACK or CA_LATENCY_CONVERT; lock free, can be called from any thread. See CaptureStats.h. */
+    int resetLatency();                                                                         /* Clears the latency histograms, e.g. after warming up; can be called from any thread. */
+
   public:
     Base* cap;                                                                                  /* The capture implementation */
   };
@@ -79,6 +79,7 @@
 #  define GL_RGB_RAW_422_APPLE 0x8A51
 #endif
 
+#include <videocapture/Log.h>
 #include <videocapture/Utils.h>
 #include <videocapture/Types.h>
 #include <videocapture/Capture.h>
@@ -379,7 +380,7 @@ namespace ca {
       glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, frame.width[0], frame.height[0], GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, pixels);
     }
     else {
-      printf("Unhandled pixel format in updateYUYV.\n");
+      CA_LOG_ERROR("Unhandled pixel format in updateYUYV.");
     }
   }
 
@@ -451,7 +452,7 @@ namespace ca {
       gl->unlockMutex(gl->mutex);
     }
     else {
-      printf("Error: pixels not handled in capturegl_on_frame(), format: %s.\n", format_to_string(pixbuf.pixel_format).c_str());
+      CA_LOG_ERROR("pixels not handled in capturegl_on_frame(), format: %s.", format_to_string(pixbuf.pixel_format).c_str());
     }
   }
 
@@ -540,7 +541,7 @@ namespace ca {
     }
 
     if (false == found_format) {
-      printf("Error: failed to find a capability for the given width/height and supported formats.\n");
+      CA_LOG_ERROR("failed to find a capability for the given width/height and supported formats.");
       return -1;
     }
 
@@ -554,18 +555,18 @@ namespace ca {
   int CaptureGL::open(Settings cfg) {
 
     if (CA_NONE == cfg.capability) {
-      printf("Error: trying to open the CaptureGL with a Settings object which doesn't have a capability set.\n");
+      CA_LOG_ERROR("trying to open the CaptureGL with a Settings object which doesn't have a capability set.");
       return -1;
     }
 
     if (CA_NONE == cfg.device) {
-      printf("Error: not device id given, cannot open capture device.\n");
+      CA_LOG_ERROR("not device id given, cannot open capture device.");
       return -2;
     }
 
     std::vector<Capability> caps = getCapabilities(cfg.device);
     if (cfg.capability >= caps.size()) {
-      printf("Error: the set capability index is out of bounds.\n");
+      CA_LOG_ERROR("the set capability index is out of bounds.");
       return -3;
     }
 
@@ -580,17 +581,17 @@ namespace ca {
       pixel_format = found_cap.pixel_format;
     }
 
-    printf("Using format: %s, capability: %d\n", format_to_string(pixel_format).c_str(), cfg.capability);
+    CA_LOG_INFO("Using format: %s, capability: %d", format_to_string(pixel_format).c_str(), cfg.capability);
 
     if(cap.open(cfg) < 0) {
-      printf("Error: cannot open the capture device.\n");
+      CA_LOG_ERROR("cannot open the capture device.");
       return -3;
     }
 
     /* After opening we need to update the format because some SDKs can convert the format. */
 
     if(setupGraphics() < 0) {
-      printf("Error: cannot setup the GL graphics.\n");
+      CA_LOG_ERROR("cannot setup the GL graphics.");
       return -4;
     }
 
@@ -671,7 +672,7 @@ namespace ca {
         setRenderingType(CA_RENDERING_TYPE_YUYV422_APPLE);
       }
       else {
-        printf("Unhandled pixel format in setupGraphics(), %s.\n", format_to_string(pixel_format).c_str());
+        CA_LOG_ERROR("Unhandled pixel format in setupGraphics(), %s.", format_to_string(pixel_format).c_str());
         exit(1);
       }
     }
@@ -687,7 +688,7 @@ namespace ca {
         setRenderingType(CA_RENDERING_TYPE_YUV420P_GENERIC);
       }
       else {
-        printf("Unhandled pixel format in setupGraphics(), %s.\n", format_to_string(pixel_format).c_str());
+        CA_LOG_ERROR("Unhandled pixel format in setupGraphics(), %s.", format_to_string(pixel_format).c_str());
         exit(1);
       }
     }
@@ -726,7 +727,7 @@ namespace ca {
         return CAPTURE_GL_YUV420P_GENERIC_FS;
       }
       case CA_RENDERING_TYPE_NONE: {
-        printf("Error: cannot find rendering type and therefore no shader source.\n");
+        CA_LOG_ERROR("cannot find rendering type and therefore no shader source.");
         return NULL;
       }
     }
@@ -737,7 +738,7 @@ namespace ca {
 
     const char* fragment_source = getFragmentShaderSource();
     if (fragment_source == NULL) {
-      printf("Error: cannot retrieve a fragment shahder source for the current rendering type.\n");
+      CA_LOG_ERROR("cannot retrieve a fragment shahder source for the current rendering type.");
       return -1;
     }
 
@@ -776,7 +777,7 @@ namespace ca {
   int CaptureGL::setupTextures() {
 
     if(frame.set(width, height, pixel_format) < 0) {
-      printf("Error: cannot set the frame object.\n");
+      CA_LOG_ERROR("cannot set the frame object.");
       return -1;
     }
     
@@ -828,7 +829,7 @@ namespace ca {
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB_422_APPLE, GL_UNSIGNED_SHORT_8_8_APPLE, pixels);
       }
       else {
-        printf("Error: unhandled pixel format, cannot create a texture.\n");
+        CA_LOG_ERROR("unhandled pixel format, cannot create a texture.");
         return -1;
       }
 
@@ -839,7 +840,7 @@ namespace ca {
 
     }
     else {
-      printf("Error: unhandled pixel format in CaptureGL.\n");
+      CA_LOG_ERROR("unhandled pixel format in CaptureGL.");
       return -1;
     }
 
@@ -856,7 +857,7 @@ namespace ca {
     float tex_verthori[] =   { 1.0, 1.0, 1.0, 0.0, 0.0, 1.0, 0.0, 0.0 } ;
 
     if (NULL == pixels || 0 == prog) {
-      printf("You're trying to flip the capture device but we're not yet setup.");
+      CA_LOG_ERROR("You're trying to flip the capture device but we're not yet setup.");
       return;
     }
 
@@ -874,7 +875,7 @@ namespace ca {
     }
     
     if (NULL == texcoords) {
-      printf("Error: texcoords == NULL\n");
+      CA_LOG_ERROR("texcoords == NULL");
       return;
     }
 
@@ -944,7 +945,7 @@ namespace ca {
   int CaptureGL::createMutex(CaptureMutex& m) {
     
     if (0 != pthread_mutex_init(&m.handle, NULL)) {
-      printf("Error: failed to create the mutex to sync the pixel data in CaptureGL.\n");
+      CA_LOG_ERROR("failed to create the mutex to sync the pixel data in CaptureGL.");
       return -1;
     }
     
@@ -954,7 +955,7 @@ namespace ca {
   int CaptureGL::lockMutex(CaptureMutex& m) {
     
     if (0 != pthread_mutex_lock(&m.handle)) {
-      printf("Error: failed to lock the mutex to sync the pixel data in CaptureGL.\n");
+      CA_LOG_ERROR("failed to lock the mutex to sync the pixel data in CaptureGL.");
       return -1;
     }
     
@@ -964,7 +965,7 @@ namespace ca {
   int CaptureGL::unlockMutex(CaptureMutex& m) {
     
     if (0 != pthread_mutex_unlock(&m.handle)) {
-      printf("Error: failed to unlock the mutex to sync the pixel data in CaptureGL.\n");
+      CA_LOG_ERROR("failed to unlock the mutex to sync the pixel data in CaptureGL.");
       return -1;
     }
 
@@ -974,7 +975,7 @@ namespace ca {
   int CaptureGL::destroyMutex(CaptureMutex& m) {
     
     if (0 != pthread_mutex_destroy(&m.handle)) {
-      printf("Error: failed to destroy the mutex to sync the pixel data in CaptureGL.\n");
+      CA_LOG_ERROR("failed to destroy the mutex to sync the pixel data in CaptureGL.");
       return -2;
     }
 
@@ -1004,10 +1005,7 @@ namespace ca {
       }
  
       glGetShaderInfoLog(shader, count, NULL, error);
-      printf("\nSHADER COMPILE ERROR");
-      printf("\n--------------------------------------------------------\n");
-      printf("%s", error);
-      printf("--------------------------------------------------------\n\n");
+      CA_LOG_ERROR("cannot compile the shader:\n%s", error);
  
       free(error);
       error = NULL;
@@ -1039,10 +1037,7 @@ namespace ca {
       return -1;
     }
 
-    printf("\nPROGRAM LINK ERROR");
-    printf("\n--------------------------------------------------------\n");
-    printf("%s", error);
-    printf("--------------------------------------------------------\n\n");
+    CA_LOG_ERROR("cannot link the program:\n%s", error);
 
     free(error);
     error = NULL;
@@ -1081,7 +1076,7 @@ namespace ca {
 
     extensions = glGetStringi(GL_EXTENSIONS, 0);
     if (extensions == NULL) {
-      printf("Error: cannot query extensions.\n");
+      CA_LOG_ERROR("cannot query extensions.");
       return -1;
     }
 
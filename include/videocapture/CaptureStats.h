@@ -0,0 +1,142 @@
+/*
+
+  CaptureStats
+  ------------
+
+  How a capture stream is doing: the frames we captured, delivered and
+  dropped, the frame rate and jitter, the time the frame callback takes
+  and, for drivers with a buffer queue (V4L2), how many buffers the
+  driver can fill and how many we hold. Every `Base` has a `stats`
+  member that the driver updates; read it with `Capture::getStats()`:
+
+     StreamStats s;
+     cap.getStats(s);
+     printf("%.2f fps, %llu dropped\n", s.fps, (unsigned long long)s.num_dropped);
+
+  The capture thread is the only writer; it never waits for a reader.
+  Reading is lock free from any thread: we use a sequence counter (a
+  seqlock) and a reader copies the values again when the writer changed
+  them while it was copying. So polling the stats of every camera from
+  a monitoring thread doesn't slow down capturing.
+
+  The frame rate and jitter are measured from the capture timestamps
+  (`PixelBuffer.timestamp`) and smoothed with an exponentially weighted
+  moving average (CA_STATS_EWMA_WEIGHT). The jitter is the average
+  deviation of the frame interval from the average interval, like RFC
+  3550 does for RTP. Drops are gaps in `PixelBuffer.sequence` plus the
+  frames we dropped ourself (see `Settings.drop_policy`).
+
+  We also keep a latency histogram (see LatencyHistogram.h) of every
+  step a frame takes, from which you get the percentiles:
+
+     CA_LATENCY_DEQUEUE   From the capture timestamp of the driver until
+                          we dequeued the frame (V4L2: VIDIOC_DQBUF
+                          returned). Only when the driver timestamps on
+                          our clock (V4L2: monotonic timestamps).
+     CA_LATENCY_DELIVER   From dequeueing until the frame callback is
+                          called: decoding, converting, rotating and
+                          waiting for the decode threads.
+     CA_LATENCY_CALLBACK  The time the frame callback takes.
+     CA_LATENCY_CONVERT   The time we take to convert and rotate a
+                          decoded frame into the output format; only
+                          recorded when the pipeline converts or
+                          rotates.
+
+     LatencyHistogram h;
+     cap.getLatency(CA_LATENCY_DEQUEUE, h);
+     printf("p50 %llu, p99 %llu\n", (unsigned long long)h.getPercentile(50.0), (unsigned long long)h.getPercentile(99.0));
+     cap.resetLatency();
+
+  The histograms are copied under the same seqlock. `resetLatency()`
+  only asks the capture thread to clear them before it records the
+  next value, so the writer stays the only one that changes them.
+
+  `num_opened` counts how often the device was opened and isn't cleared
+  when it's opened again; an application that reopens a camera after
+  it was unplugged can tell how often that happened. The same holds
+  for the recoveries of a stalled stream (see the watchdog in
+  V4L2_Capture.h): `num_recoveries[CA_RECOVER_*]` counts every attempt
+  and `last_recovery[CA_RECOVER_*]` has the `time_now_ns()` of the last
+  one.
+
+  The V4L2, synthetic and replay drivers fill all values (only V4L2
+  has buffers; the replay driver has no dequeue latency), Media
+  Foundation fills all but the drops and has only the callback
+  latency; the other drivers don't fill them yet.
+
+ */
+#ifndef VIDEO_CAPTURE_CAPTURE_STATS_H
+#define VIDEO_CAPTURE_CAPTURE_STATS_H
+
+#include <stdint.h>
+#include <videocapture/LatencyHistogram.h>
+
+#define CA_STATS_EWMA_WEIGHT 0.0625                                                 /* The weight of a new sample in the moving averages; about the last 16 frames count. */
+
+#define CA_LATENCY_DEQUEUE 0                                                        /* Capture timestamp -> frame dequeued from the driver. */
+#define CA_LATENCY_DELIVER 1                                                        /* Frame dequeued -> frame callback called. */
+#define CA_LATENCY_CALLBACK 2                                                       /* The duration of the frame callback. */
+#define CA_LATENCY_CONVERT 3                                                        /* The time we take to convert and rotate a decoded frame. */
+#define CA_LATENCY_COUNT 4
+
+#define CA_RECOVER_RESTART 0                                                        /* A stalled stream was restarted (V4L2: STREAMOFF, STREAMON). */
+#define CA_RECOVER_REALLOCATE 1                                                     /* A stalled stream got new buffers (V4L2: REQBUFS). */
+#define CA_RECOVER_REOPEN 2                                                         /* A stalled device was closed and opened again. */
+#define CA_RECOVER_COUNT 3
+
+namespace ca {
+
+  struct StreamStats {                                                              /* A copy of the stats of a stream. */
+    StreamStats();
+    uint64_t num_captured;                                                          /* The frames we received from the device. */
+    uint64_t num_delivered;                                                         /* The frames we passed to the frame callback. */
+    uint64_t num_dropped;                                                           /* Gaps in the sequence numbers plus the frames we dropped (e.g. no free decode buffer). */
+    double fps;                                                                     /* The moving average of the frame rate, from the capture timestamps. */
+    double jitter_ns;                                                               /* The moving average of |interval - average interval|, in nanoseconds. */
+    uint64_t callback_ns;                                                           /* The time the last frame callback took. */
+    double callback_avg_ns;                                                         /* The moving average of `callback_ns`. */
+    uint64_t callback_max_ns;                                                       /* The longest frame callback since we opened the device. */
+    uint64_t last_delivered;                                                        /* `time_now_ns()` when the last frame callback returned; 0 when there was none yet. */
+    int num_buffers;                                                                /* The buffers of the driver; 0 when the driver doesn't have a queue we know of. */
+    int num_queued;                                                                 /* The buffers the driver can capture into. */
+    int num_held;                                                                   /* The buffers we hold: dequeued and not given back yet (i.e. in the pipeline or frame callback). */
+    uint64_t num_opened;                                                            /* How often the device was opened; kept when it's opened again, so > 1 means it was reopened. */
+    uint64_t num_recoveries[CA_RECOVER_COUNT];                                      /* How often we tried to recover a stalled stream, per CA_RECOVER_*; kept when the device is opened again. */
+    uint64_t last_recovery[CA_RECOVER_COUNT];                                       /* `time_now_ns()` of the last attempt per CA_RECOVER_*; 0 when there was none. */
+  };
+
+  class CaptureStats {
+  public:
+    CaptureStats();
+    void reset();                                                                   /* Clears everything but `num_opened`, which it increments, and the recoveries; call it when a device is opened. */
+    void frameCaptured(uint64_t timestamp, uint64_t sequence);                      /* We received a frame with the given capture timestamp (ns) and sequence number. */
+    void frameCaptured(uint64_t timestamp);                                         /* Same, for drivers without sequence numbers; we can't detect drops then. */
+    void framesDropped(uint64_t n);                                                 /* We dropped `n` frames ourself. */
+    void frameDelivered(uint64_t start, uint64_t end);                              /* A frame callback ran from `start` until `end` (`time_now_ns()`). */
+    void setBuffers(int total, int queued);                                         /* The driver has `total` buffers of which `queued` can be filled; the others are held by us. */
+    void recoveryStarted(int which, uint64_t time);                                 /* The watchdog tries to recover a stalled stream with CA_RECOVER_* `which` at `time` (`time_now_ns()`). */
+    void recordLatency(int which, uint64_t ns);                                     /* Adds a duration to the CA_LATENCY_* histogram `which`. `frameDelivered()` records CA_LATENCY_CALLBACK. */
+    void get(StreamStats& result);                                                  /* Copies the stats; can be called from any thread. */
+    int getLatency(int which, LatencyHistogram& result);                            /* Copies the CA_LATENCY_* histogram `which`; can be called from any thread. Returns 0 on success, < 0 when `which` is invalid. */
+    void resetLatency();                                                            /* Clears the latency histograms; can be called from any thread. */
+
+  private:
+    void beginWrite();                                                              /* Makes the sequence counter odd; readers retry until it's even again. */
+    void endWrite();
+    void clearLatency();                                                            /* Resets the histograms; call it between `beginWrite()` and `endWrite()`. */
+    void addInterval(uint64_t timestamp);                                           /* Updates the frame rate and jitter. */
+
+  private:
+    volatile uint32_t version;                                                      /* The seqlock counter; odd while the writer changes `values` or `latency`. */
+    volatile int must_reset_latency;                                                /* Set by `resetLatency()`; the writer clears the histograms before it records the next value. */
+    StreamStats values;
+    LatencyHistogram latency[CA_LATENCY_COUNT];
+    uint64_t last_timestamp;                                                        /* The capture timestamp of the previous frame; 0 when there was none. */
+    uint64_t last_sequence;
+    bool has_sequence;                                                              /* Is true when `last_sequence` is set. */
+    double avg_interval;                                                            /* The moving average of the frame interval in ns. */
+  };
+
+} /* namespace ca */
+
+#endif
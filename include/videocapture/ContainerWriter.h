@@ -0,0 +1,49 @@
+/*
+
+  ContainerWriter
+  ---------------
+
+  Interface for the writers that store compressed frames, as delivered
+  by the camera, in a container file without decoding them; see AviWriter.h,
+  MkvWriter.h and Mp4Writer.h. Use a `Recorder` (Recorder.h) to pick one by
+  CA_CONTAINER_* and to feed it from the frame callback.
+
+  Frames are passed as chunks (scatter-gather, see `DataChunk` in Types.h)
+  so a frame that needs extra data, e.g. the default Huffman tables of an
+  MJPEG frame (see JpegMarkers.h), doesn't have to be copied first. The
+  timestamp is in nanoseconds on any monotonic clock (`PixelBuffer::timestamp`);
+  the writers store the time relative to the first frame.
+
+  H.264 frames (CA_H264) are access units with 4 byte big endian lengths
+  instead of Annex-B start codes, and the decoder configuration (avcC, see
+  `h264_get_avcc()` in H264Parser.h) must be set with `setCodecPrivate()`
+  before `open()`. The same goes for H.265 (CA_H265, hvcC), which only
+  Matroska and MP4 can store.
+
+ */
+#ifndef VIDEO_CAPTURE_CONTAINER_WRITER_H
+#define VIDEO_CAPTURE_CONTAINER_WRITER_H
+
+#include <string>
+#include <vector>
+#include <videocapture/Types.h>
+
+namespace ca {
+
+  class ContainerWriter {
+  public:
+    ContainerWriter();
+    virtual ~ContainerWriter();
+    virtual int open(const std::string& filepath, int width, int height, int fmt, int fps) = 0; /* Creates the file for a stream of `fmt` frames (CA_MJPEG, CA_JPEG_OPENDML, CA_H264 or CA_H265) at the given frame rate (CA_FPS_*). Returns 0 on success, < 0 on error. */
+    virtual int close() = 0;                                                        /* Writes the index, patches the headers and closes the file. */
+    virtual int writeFrame(const DataChunk* chunks, int nchunks, uint64_t timestamp, bool keyframe) = 0; /* Appends one frame. Returns 0 on success, < 0 on error. */
+    virtual uint64_t getNumFrames() = 0;                                            /* The number of frames that were written. */
+    void setCodecPrivate(const uint8_t* data, size_t nbytes);                       /* Sets the codec specific data that the writer stores in the header; e.g. the avcC for H.264. */
+
+  public:
+    std::vector<uint8_t> codec_private;                                             /* The codec specific data, see `setCodecPrivate()`. */
+  };
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,59 @@
+/*
+
+  Pixel Format Conversion
+  -----------------------
+
+  CPU kernels that convert between the uncompressed CA_* pixel formats.
+  Some capture SDKs (AVFoundation, Media Foundation) convert for you, see
+  `getOutputFormats()`; these kernels are used where the SDK can't.
+
+  Every kernel is a `pixel_kernel` that converts a band of rows, so a frame
+  can be spread over several cores using a `SliceScheduler`. Both buffers
+  must be set up with the same width and height (see `PixelBuffer::setup()`
+  and `PixelBuffer::setPixels()`); the kernels use `plane[]` and `stride[]`
+  so rows with padding are fine.
+
+  YUV to RGB conversions use the BT.601 video range matrix with 8 bit fixed
+  point coefficients, the same matrix as the shaders in CaptureGL.h.
+
+  Supported conversions:
+
+     - CA_YUYV422, CA_UYVY422  > CA_YUV420P, CA_YUV422P, CA_BGRA32, CA_RGBA32, CA_RGB24
+     - CA_YUV422P              > CA_YUV420P
+     - CA_YUV420P              > CA_YUV420BP, CA_BGRA32, CA_RGBA32, CA_RGB24
+     - CA_YUV420BP             > CA_YUV420P
+     - CA_RGB24                > CA_BGRA32, CA_RGBA32
+
+  Some kernels have SIMD variants (see Cpu.h and simd/SIMD_Convert.h):
+  the packed 4:2:2 > planar kernels, the YUV420P <> YUV420BP chroma
+  (de)interleave and YUV420P > BGRA32/RGBA32. `convert_get_kernel()`
+  returns the best variant for the CPU level that is returned by
+  `cpu_get_level()`. All variants produce the same output as the scalar
+  kernel; run `convert_selftest()` to verify this on a new platform.
+
+ */
+#ifndef VIDEO_CAPTURE_CONVERT_H
+#define VIDEO_CAPTURE_CONVERT_H
+
+#include <vector>
+#include <videocapture/Types.h>
+#include <videocapture/SliceScheduler.h>
+
+namespace ca {
+
+  struct ConvertKernel {                                                            /* Describes one variant of a conversion kernel. */
+    int src_format;                                                                 /* The CA_* pixel format we convert from. */
+    int dst_format;                                                                 /* The CA_* pixel format we convert to. */
+    int cpu_level;                                                                  /* The CA_CPU_* level the kernel needs. */
+    pixel_kernel kernel;                                                            /* The kernel. */
+  };
+
+  pixel_kernel convert_get_kernel(int srcfmt, int dstfmt);                          /* Returns the best kernel for `cpu_get_level()` that converts directly from `srcfmt` to `dstfmt`, or NULL when there is none. */
+  pixel_kernel convert_get_kernel(int srcfmt, int dstfmt, int cpulevel);            /* Returns the best kernel that can be used at the given CA_CPU_* level, or NULL when there is none or when the CPU doesn't support the level. */
+  std::vector<ConvertKernel> convert_get_kernels();                                 /* Returns all kernel variants that are compiled in, including the ones the CPU doesn't support. */
+  int convert(const PixelBuffer& src, PixelBuffer& dst, SliceScheduler* scheduler = NULL); /* Converts `src` into `dst` (using the pixel_format of both). When `scheduler` is NULL we convert on the calling thread. Returns 0 on success, < 0 on error. */
+  int convert_selftest();                                                           /* Compares the output of every SIMD variant the CPU supports with the scalar kernel. Returns the number of variants that differ, 0 when all are bit exact. */
+
+} /* namespace ca */
+
+#endif
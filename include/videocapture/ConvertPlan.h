@@ -0,0 +1,107 @@
+/*
+
+  Conversion Planning
+  -------------------
+
+  Not every pair of pixel formats has a direct kernel (see Convert.h); e.g.
+  CA_YUV422P > CA_YUV420BP is done via CA_YUV420P. The `ConvertPlanner`
+  models every kernel as an edge between two formats with a cost and finds
+  the cheapest chain of kernels between any two formats. Found chains are
+  cached.
+
+  The default costs are the number of bytes a kernel reads and writes per
+  pixel. Call `calibrate()` to replace them with the measured nanoseconds
+  per pixel of the kernels that are selected for this CPU (see Cpu.h).
+
+  A `ConvertPlan` is the result of planning a conversion for a specific
+  size. It allocates the intermediate buffers and selects the kernels for
+  the current CPU level once in `init()` so that `execute()` doesn't
+  allocate or search anything per frame.
+
+  Example:
+
+     ConvertPlan plan;
+     plan.init(CA_YUV422P, CA_YUV420BP, 1280, 720);
+
+     // for every frame
+     plan.execute(src, dst, &scheduler);
+
+ */
+#ifndef VIDEO_CAPTURE_CONVERT_PLAN_H
+#define VIDEO_CAPTURE_CONVERT_PLAN_H
+
+#include <map>
+#include <vector>
+#include <videocapture/Types.h>
+#include <videocapture/Thread.h>
+#include <videocapture/Convert.h>
+#include <videocapture/SliceScheduler.h>
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  struct ConvertEdge {                                                              /* A kernel in the conversion graph. */
+    int src_format;                                                                 /* The CA_* format we convert from. */
+    int dst_format;                                                                 /* The CA_* format we convert to. */
+    double cost;                                                                    /* Cost per pixel; bytes touched, or nanoseconds after calibration. */
+  };
+
+  struct ConvertPath {                                                              /* A cached result of the planner. */
+    std::vector<int> edges;                                                         /* Indices into `ConvertPlanner::edges`, in the order they must be executed. */
+    double cost;                                                                    /* The summed cost per pixel of all edges. */
+  };
+
+  /* ------------------------------------------------------------------------- */
+
+  class ConvertPlanner {
+  public:
+    ConvertPlanner();
+    ~ConvertPlanner();
+    int calibrate(int width = 640, int height = 480);                               /* Measures the ns/pixel of every edge on frames of the given size and uses that as cost. Returns 0 on success. */
+    int findPath(int srcfmt, int dstfmt, ConvertPath& result);                      /* Finds the cheapest chain of kernels; returns 0 on success, < 0 when `dstfmt` can't be reached from `srcfmt`. */
+    double getCost(int srcfmt, int dstfmt);                                         /* Returns the cost per pixel to convert from `srcfmt` to `dstfmt`; 0.0 when they're the same and < 0 when we can't convert. */
+    bool canConvert(int srcfmt, int dstfmt);                                        /* Returns true when there is a chain from `srcfmt` to `dstfmt`. */
+    std::vector<ConvertEdge> getEdges();                                            /* Returns a copy of the edges. */
+
+  private:
+    void createEdges();                                                             /* Creates an edge for every direct conversion in Convert.h; the mutex must be locked. */
+    int dijkstra(int srcfmt, int dstfmt, ConvertPath& result);                      /* Finds the cheapest path; the mutex must be locked. */
+
+  public:
+    std::vector<ConvertEdge> edges;                                                 /* The kernels, see `createEdges()`. */
+    std::map<std::pair<int, int>, ConvertPath> paths;                               /* Cached paths, indexed by source and destination format. */
+    std::map<std::pair<int, int>, bool> unreachable;                                /* Cached pairs for which there is no path. */
+    bool is_calibrated;                                                             /* Is set to true when the costs are measured. */
+    Mutex mutex;                                                                    /* The planner is shared; the capture threads and the user may plan at the same time. */
+  };
+
+  ConvertPlanner& convert_get_planner();                                            /* Returns the planner that is shared by the library. */
+
+  /* ------------------------------------------------------------------------- */
+
+  class ConvertPlan {
+  public:
+    ConvertPlan();
+    ~ConvertPlan();
+    int init(int srcfmt, int dstfmt, int width, int height, ConvertPlanner* planner = NULL); /* Plans the conversion and allocates the intermediate buffers. When `planner` is NULL we use `convert_get_planner()`. Returns 0 on success. */
+    int shutdown();                                                                 /* Frees the intermediate buffers. */
+    int execute(const PixelBuffer& src, PixelBuffer& dst, SliceScheduler* scheduler = NULL); /* Converts `src` into `dst`, both must match the formats and size from `init()`. Returns 0 on success. */
+    size_t getNumSteps();                                                           /* Returns the number of kernels we execute; 0 when the source and destination formats are the same. */
+    double getCost();                                                               /* Returns the cost per pixel of the plan. */
+
+  public:
+    int src_format;                                                                 /* The format we convert from. */
+    int dst_format;                                                                 /* The format we convert to. */
+    int width;                                                                      /* The width of the frames. */
+    int height;                                                                     /* The height of the frames. */
+    double cost;                                                                    /* The cost per pixel, see `ConvertEdge`. */
+    std::vector<pixel_kernel> kernels;                                              /* The kernels we execute, in order. */
+    std::vector<PixelBuffer> intermediates;                                         /* The output buffers of all kernels except the last one. */
+    std::vector<uint8_t*> memory;                                                   /* The pixels of the intermediates. */
+    bool is_init;                                                                   /* Is set to true when initialized. */
+  };
+
+} /* namespace ca */
+
+#endif
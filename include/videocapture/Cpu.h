@@ -0,0 +1,41 @@
+/*
+
+  CPU Feature Detection
+  ---------------------
+
+  The pixel kernels (see Convert.h) come in several variants: a scalar one
+  that works everywhere and SIMD variants for SSE2, SSSE3, AVX2, AVX-512 and
+  NEON. At runtime we detect what the CPU (and OS) supports and use the best
+  variant, so one binary runs on old Atoms, new Xeons and Raspberry PIs.
+
+  You can force a lower level, e.g. to test or benchmark a specific
+  variant, by calling `cpu_set_level()` or by setting the `CA_CPU_LEVEL`
+  environment variable to one of: scalar, sse2, ssse3, avx2, avx512, neon.
+  Forcing a level that the CPU does not support fails and keeps the
+  detected level.
+
+ */
+#ifndef VIDEO_CAPTURE_CPU_H
+#define VIDEO_CAPTURE_CPU_H
+
+#include <string>
+#include <videocapture/Types.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#  define CA_ARCH_X86 1
+#elif defined(__aarch64__) || defined(__arm__) || defined(_M_ARM)
+#  define CA_ARCH_ARM 1
+#endif
+
+namespace ca {
+
+  int cpu_detect_level();                                                          /* Returns the highest CA_CPU_* level that is supported by the CPU and OS. */
+  int cpu_get_level();                                                             /* Returns the level that is used to select kernels; the detected level unless it was forced. */
+  int cpu_set_level(int level);                                                    /* Force the given CA_CPU_* level; CA_NONE resets to the detected level. Returns 0 on success, < 0 when the level is not supported. */
+  bool cpu_supports_level(int level);                                              /* Returns true when kernels of the given level can be executed on this CPU. */
+  std::string cpu_level_to_string(int level);                                      /* Returns e.g. "avx2" */
+  int cpu_level_from_string(const std::string& name);                              /* Returns the CA_CPU_* level for e.g. "avx2" or CA_NONE. */
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,83 @@
+/*
+
+  EncoderSink
+  -----------
+
+  Encodes the frames of a camera that delivers raw pixels (e.g. CA_YUYV422)
+  with x264 (CA_H264) or x265 (CA_H265) and stores them in a Matroska or
+  MP4 file (see MkvWriter.h and Mp4Writer.h). Pass the frames from the
+  frame callback to `write()`:
+
+     EncoderSettings cfg;
+     cfg.codec = CA_H264;
+     cfg.preset = "veryfast";
+     cfg.num_cameras = 12;
+
+     EncoderSink sink;
+     sink.open("cam0.mp4", CA_CONTAINER_MP4, 1280, 720, CA_YUYV422, CA_FPS_30_00, cfg);
+
+     void on_frame(PixelBuffer& buffer) {
+       sink.write(buffer);
+     }
+
+  I420 frames (CA_YUV420P, CA_YUVJ420P), and NV12 frames (CA_YUV420BP,
+  CA_YUVJ420BP) for x264, are passed to the encoder as they are; the
+  encoder reads the planes of the captured buffer. Other formats are
+  converted into CA_YUV420P first (see ConvertPlan.h), on the threads of
+  `scheduler` when it's set. See `isZeroCopy()`.
+
+  Encoding is by far the most expensive thing we do with a frame. When
+  you record several cameras, set `EncoderSettings.num_cameras` so every
+  encoder gets its share of the cores instead of one thread per core
+  each; see VideoEncoder.h.
+
+  The frame timestamps (`PixelBuffer::timestamp`) are stored in the file.
+  The encoder holds on to a few frames (lookahead, frame threads), which
+  are flushed by `close()`.
+
+ */
+#ifndef VIDEO_CAPTURE_ENCODER_SINK_H
+#define VIDEO_CAPTURE_ENCODER_SINK_H
+
+#include <string>
+#include <videocapture/Types.h>
+#include <videocapture/ConvertPlan.h>
+#include <videocapture/PixelBufferPool.h>
+#include <videocapture/SliceScheduler.h>
+#include <videocapture/ContainerWriter.h>
+#include <videocapture/VideoEncoder.h>
+
+namespace ca {
+
+  class EncoderSink {
+  public:
+    EncoderSink();
+    ~EncoderSink();                                                                 /* Closes the file when it's still open. */
+    int open(const std::string& filepath, int container, int width, int height, int fmt, int fps, const EncoderSettings& cfg); /* Creates the encoder for `fmt` frames and a file of the given container (CA_CONTAINER_MKV or CA_CONTAINER_MP4). Returns 0 on success, < 0 on error. */
+    int close();                                                                    /* Flushes the encoder and finishes the file. */
+    int write(PixelBuffer& buffer);                                                 /* Encodes a frame and writes the frames that come out of the encoder. Returns 0 on success, < 0 on error. */
+    bool isZeroCopy();                                                              /* Returns true when the frames are passed to the encoder without converting them. */
+    int getNumThreads();                                                            /* The number of threads of the encoder. */
+    uint64_t getNumFrames();                                                        /* The number of frames in the file. */
+
+  private:
+    int encode(const PixelBuffer* pic, uint64_t timestamp);                         /* Passes `pic` to the encoder, NULL to flush, and writes the frames that come out. */
+
+  public:
+    SliceScheduler* scheduler;                                                      /* When set, the conversion is spread over its threads. Not owned. */
+
+  private:
+    VideoEncoder* encoder;                                                          /* x264 or x265. */
+    ContainerWriter* writer;                                                        /* The container implementation. */
+    ConvertPlan convert_plan;                                                       /* Converts the frames into CA_YUV420P, unless we're zero copy. */
+    PixelBufferPool convert_pool;                                                   /* The buffer we convert into. */
+    EncodedFrame frame;                                                             /* The frame that came out of the encoder; a member because it's large. */
+    int input_format;                                                               /* The format of the frames we accept. */
+    int width;                                                                      /* The frame width. */
+    int height;                                                                     /* The frame height. */
+    bool is_zero_copy;                                                              /* Is true when we don't convert. */
+  };
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,50 @@
+/*
+
+  Error
+  -----
+
+  The functions of the library return < 0 on error, with a value that
+  only tells you where in the function it failed. To tell *why* a call
+  failed, we also set an error code for the calling thread, like errno:
+
+     if (0 > cap.open(settings)) {
+       if (CA_ERR_DEVICE_LOST == error_get_code()) {
+         ...
+       }
+       printf("open failed: %s (errno %d)\n", error_to_string(error_get_code()), error_get_system());
+     }
+
+  The code stays set until the next error on this thread or until you
+  call `error_clear()`; a call that succeeds doesn't clear it. When the
+  error came from a system call, `error_get_system()` returns its errno,
+  otherwise 0.
+
+  The V4L2 driver sets the codes; the other drivers only log for now.
+
+ */
+#ifndef VIDEO_CAPTURE_ERROR_H
+#define VIDEO_CAPTURE_ERROR_H
+
+#define CA_ERR_NONE 0                                                               /* No error. */
+#define CA_ERR_INVALID_ARGUMENT 1                                                   /* An invalid argument, e.g. a device or capability index that doesn't exist. */
+#define CA_ERR_INVALID_STATE 2                                                      /* The call isn't allowed now, e.g. starting a device that isn't opened. */
+#define CA_ERR_NOT_FOUND 3                                                          /* The device, format or file doesn't exist. */
+#define CA_ERR_NOT_SUPPORTED 4                                                      /* The device can't do what we need, e.g. streaming I/O. */
+#define CA_ERR_SYSTEM 5                                                             /* A system call failed; see `error_get_system()`. */
+#define CA_ERR_IO 6                                                                 /* The device reported an I/O error (EIO), e.g. a USB transfer error. */
+#define CA_ERR_DEVICE_LOST 7                                                        /* The device is gone (ENODEV), e.g. it was unplugged. */
+#define CA_ERR_NO_MEMORY 8                                                          /* We, or the driver, ran out of memory. */
+#define CA_ERR_BUSY 9                                                               /* The device is used by another process (EBUSY). */
+
+namespace ca {
+
+  void error_set(int code, int sys_error);                                          /* Sets the error of the calling thread; `sys_error` is the errno of the call that failed, or 0. */
+  void error_set_system(int sys_error);                                             /* Sets the error for a failed system call, with the code that matches the errno. */
+  void error_clear();                                                               /* Sets the error of the calling thread to CA_ERR_NONE. */
+  int error_get_code();                                                             /* The CA_ERR_* of the last error on the calling thread. */
+  int error_get_system();                                                           /* The errno of the last error on the calling thread; 0 when it wasn't a system call. */
+  const char* error_to_string(int code);                                            /* A description of a CA_ERR_* code. */
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,79 @@
+/*
+
+  FileWriter
+  ----------
+
+  Buffered, append only file output for the container writers (see
+  ContainerWriter.h). All writes go into one buffer that is allocated in
+  `open()` and written to disk when it's full, so recording a frame costs
+  a memcpy and, once every few frames, one large write. Writes that are
+  larger than the buffer go to disk directly.
+
+  Containers have sizes and counts in their headers that we only know at
+  the end; `patch()` overwrites bytes that were written before. When they
+  are still in the buffer we patch them in memory, otherwise we seek back
+  in the file. Offsets are 64 bit so files can grow beyond 4 GB.
+
+  The numeric helpers write little endian, like AVI; the `BE` variants
+  write big endian, like MP4.
+
+ */
+#ifndef VIDEO_CAPTURE_FILE_WRITER_H
+#define VIDEO_CAPTURE_FILE_WRITER_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <videocapture/Types.h>
+
+#define CA_FILE_WRITER_BUFFER_SIZE (4 * 1024 * 1024)                               /* The default size of the write buffer. */
+
+namespace ca {
+
+  class FileWriter {
+  public:
+    FileWriter();
+    ~FileWriter();                                                                  /* Closes the file when it's still open. */
+    int open(const std::string& filepath, size_t buffersize = CA_FILE_WRITER_BUFFER_SIZE); /* Creates (or truncates) the file. Returns 0 on success, < 0 on error. */
+    int close();                                                                    /* Flushes and closes the file. */
+    int write(const void* data, size_t nbytes);                                     /* Appends the bytes. Returns 0 on success, < 0 on error. */
+    int write(const DataChunk* chunks, int nchunks);                                /* Appends the chunks in order. */
+    int writeZeros(size_t nbytes);                                                  /* Appends `nbytes` zeros; used for padding and reserved space. */
+    int writeU8(uint8_t v);
+    int writeU16(uint16_t v);                                                       /* Little endian. */
+    int writeU32(uint32_t v);                                                       /* Little endian. */
+    int writeU64(uint64_t v);                                                       /* Little endian. */
+    int writeU16BE(uint16_t v);                                                     /* Big endian. */
+    int writeU32BE(uint32_t v);                                                     /* Big endian. */
+    int writeU64BE(uint64_t v);                                                     /* Big endian. */
+    int writeFourCC(const char* fourcc);                                            /* Writes the 4 characters of `fourcc`. */
+    int patch(uint64_t offset, const void* data, size_t nbytes);                    /* Overwrites bytes that were written before; `offset + nbytes` must be <= `tell()`. */
+    int patchU32(uint64_t offset, uint32_t v);                                      /* Little endian. */
+    int patchU64(uint64_t offset, uint64_t v);                                      /* Little endian. */
+    int patchU32BE(uint64_t offset, uint32_t v);                                    /* Big endian. */
+    int flush();                                                                    /* Writes the buffer to disk. */
+    uint64_t tell();                                                                /* The offset of the next byte we write, i.e. the size of the file. */
+    bool isOpen();                                                                  /* Returns true when a file is open. */
+
+  private:
+    int seek(uint64_t offset);                                                      /* Seeks in the file; 64 bit on all platforms. */
+
+  private:
+    FILE* fp;                                                                       /* The file handle. */
+    std::vector<uint8_t> buffer;                                                    /* The write buffer, allocated in `open()`. */
+    size_t buffer_used;                                                             /* The number of bytes in `buffer`. */
+    uint64_t buffer_offset;                                                         /* The file offset of `buffer[0]`, i.e. the number of bytes on disk. */
+  };
+
+  inline bool FileWriter::isOpen() {
+    return NULL != fp;
+  }
+
+  inline uint64_t FileWriter::tell() {
+    return buffer_offset + buffer_used;
+  }
+
+} /* namespace ca */
+
+#endif
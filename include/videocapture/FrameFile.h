@@ -0,0 +1,124 @@
+/*
+
+  FrameFile
+  ---------
+
+  A container for raw (uncompressed or losslessly compressed) frames.
+  Frames are stored bit exact, plane by plane without the row padding of
+  the capture buffers, so a recording can be replayed into the same
+  processing as the live camera. Write them with FrameFileWriter.h
+  (uncompressed) or LosslessRecorder.h (compressed), read them with
+  FrameFileReader.h.
+
+  Layout (all numbers little endian):
+
+     header        CA_FRAME_FILE_HEADER_SIZE bytes: magic, version, the
+                   format and geometry, how the planes are compressed and
+                   filtered, and the position of the index (see
+                   `FrameFileHeader`).
+
+     frames        For every frame a record of CA_FRAME_FILE_RECORD_SIZE
+                   bytes (magic 'CAFR', flags, sequence, timestamp and
+                   the stored size of every plane), padding up to
+                   `alignment`, then the planes one after another.
+
+     index         Magic 'CAIX', 4 reserved bytes, the number of frames
+                   (u64) and for every frame an entry of
+                   CA_FRAME_FILE_ENTRY_SIZE bytes: the payload offset
+                   (u64), sequence (u64), timestamp (u64), the stored
+                   plane sizes (3 x u32), flags (u32) and 8 reserved
+                   bytes.
+
+  The header:
+
+     0    magic "CAFRAMES"          44   plane_stride, 3 x u32
+     8    version, u32              56   plane_height, 3 x u32
+     12   pixel_format, u32         68   reserved, u32
+     16   width, u32                72   num_frames, u64
+     20   height, u32               80   index_offset, u64
+     24   fps, u32                  88   reserved up to 128
+     28   compression, u32
+     32   filter, u32
+     36   alignment, u32
+     40   num_planes, u32
+
+  The header holds the offset of the index and the number of frames; both
+  are 0 until the writer is closed. The records repeat what the index
+  says, so the frames of a file that wasn't closed can still be found by
+  walking the records.
+
+  Compression and filters
+  -----------------------
+
+  Every plane is compressed on its own with the method in the header
+  (CA_COMPRESS_*). A plane that doesn't get smaller is stored as is and
+  flagged with `CA_FRAME_FLAG_RAW_PLANE(i)`. Before compressing, the
+  planes can be filtered (CA_FILTER_*, see LosslessCodec.h) which turns
+  smooth images into mostly small numbers that compress a lot better:
+
+     - CA_FILTER_ROW_DELTA      Every row minus the row above it.
+     - CA_FILTER_FRAME_DELTA    Every frame minus the previous frame,
+                                except for key frames (CA_FRAME_FLAG_KEY);
+                                to decode frame N you start at the key
+                                frame before it.
+
+ */
+#ifndef VIDEO_CAPTURE_FRAME_FILE_H
+#define VIDEO_CAPTURE_FRAME_FILE_H
+
+#include <stdint.h>
+#include <videocapture/Types.h>
+
+#define CA_FRAME_FILE_MAGIC "CAFRAMES"                                              /* The first 8 bytes of a file. */
+#define CA_FRAME_FILE_VERSION 1
+#define CA_FRAME_FILE_HEADER_SIZE 128                                               /* The size of the header, including reserved bytes. */
+#define CA_FRAME_FILE_RECORD_SIZE 48                                                /* The size of the record before every frame. */
+#define CA_FRAME_FILE_ENTRY_SIZE 48                                                 /* The size of an index entry. */
+#define CA_FRAME_FILE_MAX_PLANES 3
+#define CA_FRAME_FILE_ALIGNMENT 4096                                                /* The default alignment of the frame payloads; a page, so the reader can map them (see FrameFileReader.h). */
+
+/* Compression methods. */
+#define CA_COMPRESS_NONE 0                                                          /* The planes are stored as is. */
+#define CA_COMPRESS_LZ4 1                                                           /* LZ4, compiled with USE_LZ4; fast enough for several cameras per core. */
+#define CA_COMPRESS_ZSTD 2                                                          /* Zstandard, compiled with USE_ZSTD; smaller files, slower. */
+
+/* Filters; can be combined. */
+#define CA_FILTER_NONE 0x00
+#define CA_FILTER_ROW_DELTA 0x01                                                    /* Store every row as the difference with the row above. */
+#define CA_FILTER_FRAME_DELTA 0x02                                                  /* Store every frame, except key frames, as the difference with the previous one. */
+
+/* Frame flags. */
+#define CA_FRAME_FLAG_KEY 0x01                                                      /* The frame doesn't depend on the previous frame. */
+#define CA_FRAME_FLAG_RAW_PLANE(i) (0x10 << (i))                                    /* Plane `i` is stored uncompressed (but filtered) because it didn't compress. */
+
+namespace ca {
+
+  struct FrameFileHeader {                                                          /* The header, see the layout above. */
+    FrameFileHeader();
+    int pixel_format;                                                               /* The CA_* format of the frames. */
+    int width;                                                                      /* The frame width. */
+    int height;                                                                     /* The frame height. */
+    int fps;                                                                        /* The frame rate (CA_FPS_*) of the camera; the timestamps are what counts. */
+    int compression;                                                                /* CA_COMPRESS_*. */
+    int filter;                                                                     /* A combination of CA_FILTER_*. */
+    uint32_t alignment;                                                             /* The frame payloads start at a multiple of this. */
+    int num_planes;                                                                 /* The number of planes per frame. */
+    uint32_t plane_stride[CA_FRAME_FILE_MAX_PLANES];                                /* The number of bytes per row of every plane, without padding. */
+    uint32_t plane_height[CA_FRAME_FILE_MAX_PLANES];                                /* The number of rows of every plane. */
+    uint64_t num_frames;                                                            /* The number of frames; 0 when the file wasn't closed. */
+    uint64_t index_offset;                                                          /* The offset of the index; 0 when the file wasn't closed. */
+  };
+
+  struct FrameFileEntry {                                                           /* A frame in the index. */
+    uint64_t offset;                                                                /* The offset of the first plane. */
+    uint64_t sequence;                                                              /* `PixelBuffer::sequence` of the frame. */
+    uint64_t timestamp;                                                             /* `PixelBuffer::timestamp` of the frame. */
+    uint32_t plane_nbytes[CA_FRAME_FILE_MAX_PLANES];                                /* The stored size of every plane. */
+    uint32_t flags;                                                                 /* A combination of CA_FRAME_FLAG_*. */
+  };
+
+  int frame_file_get_layout(int width, int height, int fmt, FrameFileHeader& hdr);  /* Sets the planes, strides and heights of `hdr` for frames of the given size and format. Returns 0 on success, < 0 when the format isn't raw. */
+
+} /* namespace ca */
+
+#endif
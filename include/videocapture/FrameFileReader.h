@@ -0,0 +1,111 @@
+/*
+
+  FrameFileReader
+  ---------------
+
+  Reads the frame files of `FrameFileWriter` and `LosslessRecorder` (see
+  FrameFile.h) for replay and offline processing. The file is mapped into
+  memory and the index is read once, so jumping to any frame is O(1)
+  and reading it costs no system call:
+
+     FrameFileReader reader;
+     reader.open("cam0.caf");
+
+     PixelBuffer frame;
+     for (uint64_t i = 0; i < reader.getNumFrames(); ++i) {
+       reader.readFrame(i, frame);
+       process(frame);
+     }
+
+  Uncompressed, unfiltered frames (`isZeroCopy()`) are handed out as they
+  are: the planes of the `PixelBuffer` point into the mapping, and the
+  operating system reads the pages when you touch them. The mapping is
+  private, so writing into a frame (e.g. an in place conversion) copies
+  the touched pages and never changes the file. Use `prefetch()` to read
+  ahead of the frames you're processing.
+
+  Compressed or filtered frames are decoded into a buffer of the reader;
+  it holds one frame and is reused by the next `readFrame()`. With
+  CA_FILTER_FRAME_DELTA a frame depends on the frames before it, back to
+  the previous key frame, so reading in order is cheap and a random read
+  decodes up to `keyint` frames.
+
+  A file that wasn't closed (e.g. the recording process crashed) has no
+  index; we find the frames by walking their records, up to the first
+  one that's incomplete.
+
+  The whole file is mapped, so files larger than a few GB need a 64 bit
+  process. Split long recordings into files of, say, an hour.
+
+ */
+#ifndef VIDEO_CAPTURE_FRAME_FILE_READER_H
+#define VIDEO_CAPTURE_FRAME_FILE_READER_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <videocapture/Types.h>
+#include <videocapture/FrameFile.h>
+
+namespace ca {
+
+  class FrameFileReader {
+  public:
+    FrameFileReader();
+    ~FrameFileReader();                                                             /* Closes the file when it's still open. */
+    int open(const std::string& filepath);                                          /* Maps the file and reads the header and index. Returns 0 on success, < 0 on error. */
+    int close();                                                                    /* Unmaps the file; frames that were handed out are no longer valid. */
+    int readFrame(uint64_t index, PixelBuffer& buffer);                             /* Sets up `buffer` with the frame at `index`, its sequence and timestamp. Returns 0 on success, < 0 on error. */
+    int findFrame(uint64_t timestamp, uint64_t& index);                             /* Finds the last frame with a timestamp <= `timestamp`. Returns 0 on success, < 0 when all frames are later. */
+    int getEntry(uint64_t index, FrameFileEntry& entry);                            /* Gets the index entry of a frame. */
+    int prefetch(uint64_t index, uint64_t count);                                   /* Tells the operating system we'll read the frames [index, index + count) soon. */
+    uint64_t getNumFrames();                                                        /* The number of frames in the file. */
+    const FrameFileHeader& getHeader();                                             /* The format and geometry of the frames. */
+    bool isZeroCopy();                                                              /* Returns true when the frames point into the mapping. */
+    bool isRecovered();                                                             /* Returns true when the file had no index and we walked the records. */
+
+  private:
+    int readHeader();                                                               /* Parses the header. */
+    int readIndex();                                                                /* Parses the index. */
+    int scanRecords();                                                              /* Rebuilds the index from the frame records. */
+    int decodeFrame(uint64_t index);                                                /* Decodes frame `index` into `decoded`, starting at the key frame before it when needed. */
+    int decodeOne(uint64_t index);                                                  /* Decompresses and unfilters one frame into `decoded`, which must hold the frame before it unless it's a key frame. */
+    int unmap();                                                                    /* Unmaps and closes the file. */
+
+  private:
+    FrameFileHeader header;                                                         /* The parsed header. */
+    std::vector<FrameFileEntry> entries;                                            /* The index. */
+    std::vector<uint8_t> decoded;                                                   /* The last decoded frame, for compressed or filtered files. */
+    std::vector<uint8_t> scratch;                                                   /* The frame difference we add to `decoded`, for CA_FILTER_FRAME_DELTA. */
+    uint8_t* mapping;                                                               /* The mapped file. */
+    uint64_t mapping_size;                                                          /* The size of the file. */
+    void* file_handle;                                                              /* Windows only: the file and mapping handles. */
+    void* mapping_handle;
+    int fd;                                                                         /* POSIX: the file descriptor. */
+    size_t plane_offset[CA_FRAME_FILE_MAX_PLANES];                                  /* The offset of every plane in a frame. */
+    size_t frame_nbytes;                                                            /* The raw size of a frame. */
+    uint64_t decoded_index;                                                         /* The frame in `decoded`. */
+    bool has_decoded;                                                               /* Is true when `decoded` holds a frame. */
+    bool is_zero_copy;                                                              /* See `isZeroCopy()`. */
+    bool is_recovered;                                                              /* See `isRecovered()`. */
+  };
+
+  inline uint64_t FrameFileReader::getNumFrames() {
+    return (uint64_t)entries.size();
+  }
+
+  inline const FrameFileHeader& FrameFileReader::getHeader() {
+    return header;
+  }
+
+  inline bool FrameFileReader::isZeroCopy() {
+    return is_zero_copy;
+  }
+
+  inline bool FrameFileReader::isRecovered() {
+    return is_recovered;
+  }
+
+} /* namespace ca */
+
+#endif
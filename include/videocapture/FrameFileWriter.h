@@ -0,0 +1,67 @@
+/*
+
+  FrameFileWriter
+  ---------------
+
+  Writes a frame file (see FrameFile.h). It doesn't compress anything; it
+  stores the planes the way they're given, so `LosslessRecorder` does the
+  compression on its own threads and only the ordered writes happen here.
+
+  To record the frames exactly as they are captured, without compression,
+  pass them to `writeFrame(PixelBuffer&)` from the frame callback; the
+  frame payloads are page aligned so `FrameFileReader` can hand them out
+  without copying:
+
+     FrameFileHeader hdr;
+     frame_file_get_layout(1920, 1080, CA_YUYV422, hdr);
+     hdr.fps = CA_FPS_30_00;
+
+     FrameFileWriter writer;
+     writer.open("cam0.caf", hdr);
+
+     void on_frame(PixelBuffer& buffer) {
+       writer.writeFrame(buffer);
+     }
+
+     writer.close();
+
+  Writing costs a memcpy into the buffer of `FileWriter` per frame and,
+  every few frames, one large write. The index is kept in memory (48
+  bytes per frame) and written by `close()`.
+
+ */
+#ifndef VIDEO_CAPTURE_FRAME_FILE_WRITER_H
+#define VIDEO_CAPTURE_FRAME_FILE_WRITER_H
+
+#include <string>
+#include <vector>
+#include <videocapture/Types.h>
+#include <videocapture/FileWriter.h>
+#include <videocapture/FrameFile.h>
+
+namespace ca {
+
+  class FrameFileWriter {
+  public:
+    FrameFileWriter();
+    ~FrameFileWriter();                                                             /* Closes the file when it's still open. */
+    int open(const std::string& filepath, const FrameFileHeader& hdr);              /* Creates the file and writes the header. Returns 0 on success, < 0 on error. */
+    int close();                                                                    /* Writes the index and patches the header. */
+    int writeFrame(FrameFileEntry& entry, const DataChunk* planes);                 /* Writes a frame; `entry.plane_nbytes[i]` must equal `planes[i].nbytes` for the planes of the header. Sets `entry.offset`. Returns 0 on success, < 0 on error. */
+    int writeFrame(PixelBuffer& buffer);                                            /* Writes a captured frame as it is, without its row padding; only for CA_COMPRESS_NONE and CA_FILTER_NONE. */
+    uint64_t getNumFrames();                                                        /* The number of frames written so far. */
+    uint64_t getNumBytes();                                                         /* The size of the file so far. */
+
+  private:
+    int writeRecord(FrameFileEntry& entry);                                         /* Writes the record of a frame and the padding; sets `entry.offset`. */
+
+  private:
+    FileWriter file;                                                                /* The buffered output. */
+    FrameFileHeader header;                                                         /* A copy of the header we wrote. */
+    std::vector<FrameFileEntry> entries;                                            /* The index, written by `close()`. */
+    std::vector<DataChunk> row_chunks;                                              /* The rows of a padded PixelBuffer; see `writeFrame(PixelBuffer&)`. */
+  };
+
+} /* namespace ca */
+
+#endif
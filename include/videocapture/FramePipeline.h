@@ -0,0 +1,131 @@
+/*
+
+  FramePipeline
+  -------------
+
+  The software steps between a captured frame and the frame callback, for
+  the capture backends that can't let the OS do them (V4L2). A frame is
+  decoded when it's CA_MJPEG or CA_JPEG_OPENDML (see MjpegDecoder.h), then
+  converted into the output format (see ConvertPlan.h) and then rotated
+  (see Rotate.h). Every step writes into a buffer from its own
+  `PixelBufferPool` so there are no allocations per frame. When there is
+  nothing to do the captured frame is passed to the callback as is.
+
+  JPEG frames are only decoded when an output format or rotation is set,
+  otherwise they're passed on compressed. They're decoded straight into
+  the output format when the decoder supports it, otherwise into the first
+  decoder format we can convert from (e.g. CA_YUV422P for CA_YUYV422). `jpegscale` selects the DCT scaling
+  of the decoder; the output is 1/2, 1/4 or 1/8 of the captured size.
+
+  With `decodethreads` > 0 the JPEG frames are decoded by a
+  `MjpegDecoderPool`, several at once. `process()` then queues the frame
+  and delivers the frames that were decoded since the last call (in
+  capture order); the converting and rotating still happens on the
+  calling thread. Call `poll()` regularly to deliver frames that finished
+  between two captured frames. `droppolicy` is one of CA_DROP_*.
+
+  CA_H264 frames are decoded by a `H264Decoder` when an output format or
+  rotation is set (and the library is compiled with USE_AVCODEC). It
+  uses `decodethreads` libavcodec threads of the kinds in `threadtype`
+  (CA_DECODE_THREAD_*). The decoded pictures aren't copied; the convert
+  and rotate steps read them from the buffers of libavcodec. We only
+  know the format of the pictures once the first one is decoded, so the
+  steps after the decoder are planned again when it differs from
+  CA_YUV420P. With frame threads a picture leaves the decoder a few
+  frames after it was captured, so call `poll()` as with `decodethreads`.
+
+  The 4:2:2 formats can't be rotated by 90 or 270 degrees; when no output
+  format is set we convert them into CA_YUV420P before rotating them.
+
+  When `stats` is set we count every frame we get, drop and deliver and
+  time the frame callback (see CaptureStats.h); the drivers point it to
+  their `Base::stats`.
+
+  Example
+  -------
+
+      FramePipeline pipeline;
+      pipeline.init(1280, 720, CA_YUYV422, CA_NONE, CA_ROTATE_90);
+
+      // for every frame; the callback receives a 720 x 1280 CA_YUV420P frame.
+      pipeline.process(captured, on_frame);
+
+ */
+#ifndef VIDEO_CAPTURE_FRAME_PIPELINE_H
+#define VIDEO_CAPTURE_FRAME_PIPELINE_H
+
+#include <videocapture/Types.h>
+#include <videocapture/ConvertPlan.h>
+#include <videocapture/MjpegDecoder.h>
+#include <videocapture/MjpegDecoderPool.h>
+#include <videocapture/H264Decoder.h>
+#include <videocapture/PixelBufferPool.h>
+#include <videocapture/SliceScheduler.h>
+#include <videocapture/CaptureStats.h>
+
+namespace ca {
+
+  class FramePipeline {
+  public:
+    FramePipeline();
+    ~FramePipeline();
+    int init(int width, int height, int infmt, int outfmt, int rot, int jpegscale = 1, int decodethreads = 0, int droppolicy = CA_DROP_NEWEST, int threadtype = CA_DECODE_THREAD_FRAME | CA_DECODE_THREAD_SLICE); /* Plans the steps from `infmt` into `outfmt` (CA_NONE keeps the format) rotated by `rot` (CA_ROTATE_*). Returns 0 on success, < 0 when we can't. */
+    int shutdown();                                                                 /* Frees the plan and buffers; frames that are still being decoded are discarded. */
+    int process(PixelBuffer& in, frame_callback cb);                                /* Runs the steps and calls `cb` with the result. Returns 0 on success, < 0 when a frame was dropped. */
+    int poll(frame_callback cb);                                                    /* Delivers the frames that the decode threads or the H.264 decoder finished; does nothing without them. Returns the number of delivered frames. */
+    bool isPassThrough();                                                           /* Returns true when frames are passed to the callback unmodified. */
+    int getOutputFormat();                                                          /* The format of the frames we pass to the callback. */
+    int getOutputWidth();                                                           /* The width of the frames we pass to the callback. */
+    int getOutputHeight();                                                          /* The height of the frames we pass to the callback. */
+
+  public:
+    SliceScheduler* scheduler;                                                      /* When set, the kernels are spread over its threads. Not owned. */
+    CaptureStats* stats;                                                            /* When set, we update it for every frame. Not owned. */
+
+  private:
+    int planSteps(int fmt, int w, int h);                                           /* Plans the convert and rotate steps for `fmt` frames of `w` x `h`. Returns 0 on success, < 0 when we can't. */
+    int processFrame(PixelBuffer& in, frame_callback cb);                           /* Decodes, converts and rotates a captured frame; see `process()`. */
+    int processDecoded(PixelBuffer& in, frame_callback cb);                         /* Converts and rotates a decoded (or raw) frame and calls `cb` with the result. */
+    void deliver(PixelBuffer& out, frame_callback cb);                              /* Calls `cb`, timed when we have `stats`. */
+
+  private:
+    int input_format;                                                               /* The format we receive. */
+    int decode_format;                                                              /* The format we decode into, CA_NONE when we don't decode. */
+    int convert_format;                                                             /* The format we convert into, CA_NONE when we don't convert. */
+    int rotate_format;                                                              /* The format after decoding and converting, which is the format we deliver. */
+    int rotation;                                                                   /* One of CA_ROTATE_*. */
+    int drop_policy;                                                                /* One of CA_DROP_*, used when we decode on multiple threads. */
+    int output_width;                                                               /* The width after rotating. */
+    int output_height;                                                              /* The height after rotating. */
+    int requested_format;                                                           /* The `outfmt` that was passed into `init()`. */
+    int plan_width;                                                                 /* The width the convert and rotate steps are planned for; 0 when planning failed. */
+    int plan_height;                                                                /* The height the convert and rotate steps are planned for. */
+    MjpegDecoder decoder;                                                           /* Decodes into `decode_format`. */
+    PixelBufferPool decode_pool;                                                    /* The buffers we decode into. */
+    MjpegDecoderPool decoder_pool;                                                  /* Decodes on multiple threads; used instead of `decoder` when `decodethreads` > 0. */
+    bool use_decoder_pool;                                                          /* Is true when we decode with `decoder_pool`. */
+    H264Decoder h264_decoder;                                                       /* Decodes CA_H264 frames. */
+    bool use_h264_decoder;                                                          /* Is true when we decode with `h264_decoder`. */
+    ConvertPlan convert_plan;                                                       /* Converts into `convert_format`. */
+    PixelBufferPool convert_pool;                                                   /* The buffers we convert into. */
+    PixelBufferPool rotate_pool;                                                    /* The buffers we rotate into. */
+    bool is_init;                                                                   /* Is set to true when initialized. */
+  };
+
+  bool frame_pipeline_can_deliver(int infmt, int outfmt);                           /* Returns true when a pipeline can turn `infmt` frames into `outfmt`. */
+
+  inline bool FramePipeline::isPassThrough() {
+    return CA_NONE == decode_format && CA_NONE == convert_format && CA_ROTATE_NONE == rotation;
+  }
+
+  inline int FramePipeline::getOutputWidth() {
+    return output_width;
+  }
+
+  inline int FramePipeline::getOutputHeight() {
+    return output_height;
+  }
+
+} /* namespace ca */
+
+#endif
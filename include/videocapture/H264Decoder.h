@@ -0,0 +1,101 @@
+/*
+
+  H264Decoder
+  -----------
+
+  Decodes CA_H264 frames with libavcodec. Only available when the library
+  is compiled with USE_AVCODEC (see build/CMakeLists.txt); without it
+  `init()` fails and `h264_decoder_is_available()` returns false.
+
+  libavcodec can use two kinds of threads (CA_DECODE_THREAD_*):
+
+     - Frame threads decode several frames at once. This scales with the
+       number of threads, but a frame leaves the decoder one frame later
+       for every extra thread.
+     - Slice threads decode the slices of one frame at once. They don't
+       add latency, but only help when the camera encodes a frame as
+       several slices.
+
+  With frame threads `submit()` often doesn't return a picture yet; call
+  `acquireDecoded()` after every `submit()` until it returns NULL.
+
+  Decoded pictures aren't copied: the `PixelBuffer` that we return points
+  into the frame buffer of libavcodec (using the planes and strides of
+  the picture; the strides are larger than the width) and holds a
+  reference to it until you `release()` it. Keep the number of buffers
+  you hold small; libavcodec needs its own reference frames too.
+
+  The sequence, timestamps and user pointer of the submitted frame are
+  copied into the decoded picture. `PixelBuffer::decode_time` is the time
+  between `submit()` and the picture leaving the decoder, so it includes
+  the time a frame waits for the frame threads.
+
+  Example
+  -------
+
+      H264Decoder decoder;
+      decoder.init(4, CA_DECODE_THREAD_FRAME | CA_DECODE_THREAD_SLICE);
+
+      // for every captured frame:
+      decoder.submit(captured);
+
+      while (NULL != (pic = decoder.acquireDecoded())) {
+        // use pic, which is CA_YUV420P or CA_YUVJ420P
+        decoder.release(pic);
+      }
+
+ */
+#ifndef VIDEO_CAPTURE_H264_DECODER_H
+#define VIDEO_CAPTURE_H264_DECODER_H
+
+#include <vector>
+#include <videocapture/Types.h>
+
+#define CA_H264_DECODER_MAX_FRAMES 4                                                /* The number of decoded pictures the user can hold at once. */
+#define CA_H264_DECODER_MAX_PENDING 64                                              /* The number of submitted frames we keep the timestamps of; more than the frame threads can hold. */
+
+namespace ca {
+
+  struct H264DecoderState;                                                          /* The libavcodec state, see H264Decoder.cpp. */
+
+  struct H264PendingFrame {                                                         /* What we remember of a submitted frame until its picture is decoded. */
+    uint64_t sequence;                                                              /* The `PixelBuffer::sequence` of the submitted frame. */
+    uint64_t timestamp;                                                             /* The `PixelBuffer::timestamp` of the submitted frame. */
+    uint64_t receive_time;                                                          /* The `PixelBuffer::receive_time` of the submitted frame. */
+    uint64_t submit_time;                                                           /* When the frame was submitted, see `time_now_ns()`. */
+    void* user;                                                                     /* The `PixelBuffer::user` of the submitted frame. */
+  };
+
+  class H264Decoder {
+  public:
+    H264Decoder();
+    ~H264Decoder();
+    int init(int nthreads = 0, int threadtype = CA_DECODE_THREAD_FRAME | CA_DECODE_THREAD_SLICE); /* Creates the decoder; `nthreads` 0 decodes on the calling thread, `threadtype` is a combination of CA_DECODE_THREAD_*. Returns 0 on success, < 0 on error. */
+    int shutdown();                                                                 /* Destroys the decoder; all decoded pictures must be released. */
+    int submit(const PixelBuffer& in);                                              /* Passes one access unit (Annex B) to the decoder. Returns 0 on success, < 0 when the decoder rejected it (e.g. a corrupt frame). */
+    PixelBuffer* acquireDecoded();                                                  /* Returns the next decoded picture, or NULL when there is none (yet). */
+    int release(PixelBuffer* buf);                                                  /* Gives a picture from `acquireDecoded()` back to the decoder. */
+    int getNumThreads();                                                            /* The number of threads libavcodec uses. */
+    uint64_t getNumDecoded();                                                       /* The number of pictures we returned. */
+    uint64_t getNumFailed();                                                        /* The number of frames the decoder rejected, and pictures we couldn't wrap. */
+
+  private:
+    int wrapFrame(int slot);                                                        /* Points `frames[slot]` to the planes of the decoded picture in the same slot. Returns 0 on success, < 0 when the format is unsupported. */
+
+  private:
+    H264DecoderState* state;                                                        /* The decoder; NULL when not initialized. */
+    PixelBuffer frames[CA_H264_DECODER_MAX_FRAMES];                                 /* The decoded pictures we hand out. */
+    bool frame_in_use[CA_H264_DECODER_MAX_FRAMES];                                  /* Is true when the user holds `frames[i]`. */
+    H264PendingFrame pending[CA_H264_DECODER_MAX_PENDING];                          /* The submitted frames, indexed by the packet number modulo CA_H264_DECODER_MAX_PENDING. */
+    uint64_t num_submitted;                                                         /* The number of frames we passed to libavcodec; used as packet number. */
+    uint64_t num_decoded;                                                           /* The number of pictures we returned. */
+    uint64_t num_failed;                                                            /* The number of frames or pictures we dropped. */
+    int num_threads;                                                                /* The number of threads libavcodec uses. */
+  };
+
+  bool h264_decoder_is_available();                                                 /* Returns true when we're compiled with libavcodec. */
+  std::vector<int> h264_decoder_get_formats();                                      /* The formats of the pictures we return; empty when we're not available. */
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,104 @@
+/*
+
+  H264Parser
+  ----------
+
+  UVC cameras with H.264 support (CA_H264) deliver an Annex-B elementary
+  stream: every buffer is one access unit, i.e. a list of NAL units that
+  are separated by 00 00 01 (or 00 00 00 01) start codes. Key frames (IDR)
+  are usually preceded by the sequence and picture parameter sets (SPS and
+  PPS) so a decoder can start there.
+
+  `h264_scan_frame()` splits a buffer into NAL units, without copying,
+  and tells you whether it's a key frame and where the parameter sets are.
+  `h264_parse_sps()` reads the profile, level and the frame size (after
+  cropping) from an SPS. That's all a container needs to store the stream
+  as is, without transcoding:
+
+     - `h264_get_avcc()` creates the decoder configuration record (avcC)
+       that MP4 and Matroska store in their header.
+     - `h264_get_chunks()` describes the access unit in the length prefixed
+       format that MP4 and Matroska use instead of start codes. Like
+       `jpeg_get_chunks()` (JpegMarkers.h) the chunks point into the frame
+       and only the 4 byte lengths are written into memory you provide.
+
+  The encoder sink (EncoderSink.h) can also write H.265 (CA_H265), which
+  uses the same length prefixed format; `h265_get_hvcc()` creates the
+  HEVC decoder configuration record (hvcC) from its parameter sets.
+
+  Example
+  -------
+
+      H264FrameInfo info;
+      uint8_t lengths[CA_H264_MAX_NAL_UNITS * 4];
+      DataChunk chunks[CA_H264_MAX_CHUNKS];
+
+      if (0 == h264_scan_frame(frame.plane[0], frame.nbytes, info)) {
+        int n = h264_get_chunks(frame.plane[0], info, lengths, chunks);
+        writer->writeFrame(chunks, n, frame.timestamp, info.is_idr);
+      }
+
+ */
+#ifndef VIDEO_CAPTURE_H264_PARSER_H
+#define VIDEO_CAPTURE_H264_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <videocapture/Types.h>
+
+#define CA_H264_MAX_NAL_UNITS 64                                                    /* The maximum number of NAL units we handle in one access unit; cameras send one slice per picture and a few parameter sets. */
+#define CA_H264_MAX_CHUNKS (2 * CA_H264_MAX_NAL_UNITS)                              /* The maximum number of chunks that `h264_get_chunks()` returns. */
+
+/* NAL unit types. */
+#define CA_H264_NAL_SLICE 1                                                         /* Coded slice of a non-IDR picture. */
+#define CA_H264_NAL_IDR 5                                                           /* Coded slice of an IDR picture; a key frame. */
+#define CA_H264_NAL_SEI 6                                                           /* Supplemental enhancement information. */
+#define CA_H264_NAL_SPS 7                                                           /* Sequence parameter set. */
+#define CA_H264_NAL_PPS 8                                                           /* Picture parameter set. */
+#define CA_H264_NAL_AUD 9                                                           /* Access unit delimiter. */
+
+/* H.265 NAL unit types; the H.265 NAL header is 2 bytes with the type in bits 1-6 of the first. */
+#define CA_H265_NAL_VPS 32                                                          /* Video parameter set. */
+#define CA_H265_NAL_SPS 33                                                          /* Sequence parameter set. */
+#define CA_H265_NAL_PPS 34                                                          /* Picture parameter set. */
+
+namespace ca {
+
+  struct H264NalUnit {                                                              /* A NAL unit in a buffer. */
+    size_t offset;                                                                  /* Offset of the NAL unit header, i.e. the byte after the start code. */
+    size_t nbytes;                                                                  /* The size of the NAL unit, without the start code and trailing zeros. */
+    int type;                                                                       /* The nal_unit_type, CA_H264_NAL_*. */
+    int ref_idc;                                                                    /* The nal_ref_idc; 0 when no other picture refers to it. */
+  };
+
+  struct H264FrameInfo {                                                            /* What `h264_scan_frame()` found. */
+    H264NalUnit units[CA_H264_MAX_NAL_UNITS];                                       /* The NAL units, in stream order. */
+    int num_units;                                                                  /* The number of NAL units in `units`. */
+    int sps_index;                                                                  /* Index into `units` of the first SPS; -1 when there is none. */
+    int pps_index;                                                                  /* Index into `units` of the first PPS; -1 when there is none. */
+    bool is_idr;                                                                    /* Is true when the access unit has an IDR slice. */
+    bool has_slice;                                                                 /* Is true when the access unit has a picture (an IDR or non-IDR slice). */
+  };
+
+  struct H264Sps {                                                                  /* The fields of a sequence parameter set that we use. */
+    int profile_idc;                                                                /* e.g. 66 for Baseline, 77 for Main and 100 for High. */
+    int constraint_flags;                                                           /* The constraint_set flags byte, which the avcC calls profile compatibility. */
+    int level_idc;                                                                  /* The level times 10, e.g. 31 for 3.1. */
+    int sps_id;                                                                     /* The seq_parameter_set_id. */
+    int chroma_format_idc;                                                          /* 1 for 4:2:0; 0 for monochrome, 2 for 4:2:2 and 3 for 4:4:4 in the high profiles. */
+    int bit_depth_luma;                                                             /* Bits per luma sample, 8 for all but the high profiles. */
+    int bit_depth_chroma;                                                           /* Bits per chroma sample. */
+    int width;                                                                      /* The frame width after cropping. */
+    int height;                                                                     /* The frame height after cropping. */
+    bool frame_mbs_only;                                                            /* Is false when the stream can be interlaced. */
+  };
+
+  int h264_scan_frame(const uint8_t* data, size_t nbytes, H264FrameInfo& info);    /* Splits the Annex-B access unit into NAL units. Returns 0 on success, < 0 when there's no start code or more than CA_H264_MAX_NAL_UNITS units. */
+  int h264_parse_sps(const uint8_t* nal, size_t nbytes, H264Sps& sps);             /* Parses the SPS NAL unit (starting with the NAL header). Returns 0 on success, < 0 when it's not an SPS or it's truncated. */
+  size_t h264_get_avcc(const uint8_t* sps, size_t spsbytes, const uint8_t* pps, size_t ppsbytes, uint8_t* dst, size_t capacity); /* Writes the AVCDecoderConfigurationRecord for the SPS and PPS NAL units into `dst`, with 4 byte NAL lengths. Returns the number of bytes or 0 on error. */
+  size_t h265_get_hvcc(const uint8_t* vps, size_t vpsbytes, const uint8_t* sps, size_t spsbytes, const uint8_t* pps, size_t ppsbytes, uint8_t* dst, size_t capacity); /* Writes the HEVCDecoderConfigurationRecord for the H.265 VPS, SPS and PPS NAL units into `dst`, with 4 byte NAL lengths. Returns the number of bytes or 0 on error. */
+  int h264_get_chunks(const uint8_t* data, const H264FrameInfo& info, uint8_t* lengths, DataChunk* chunks); /* Fills `chunks` (at least CA_H264_MAX_CHUNKS) with the access unit in length prefixed format; `lengths` must hold 4 bytes per NAL unit. Access unit delimiters are dropped. Returns the number of chunks. */
+
+} /* namespace ca */
+
+#endif
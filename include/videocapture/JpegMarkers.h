@@ -0,0 +1,69 @@
+/*
+
+  JpegMarkers
+  -----------
+
+  Many UVC webcams deliver "AVI1" style MJPEG (CA_JPEG_OPENDML): every
+  frame uses the default Huffman tables from the JPEG standard (ITU T.81,
+  Annex K.3) but the DHT segment itself is left out to save bandwidth. Our
+  decoder doesn't care, but most image viewers, browsers and file formats
+  do. Cameras also often pad the frame with garbage after the EOI marker
+  or cut it off before it.
+
+  `jpeg_scan_markers()` walks the marker segments up to the start of the
+  scan (and looks for the EOI from the end) without allocating or copying.
+  `jpeg_get_chunks()` then describes a standards compliant JPEG as a list
+  of chunks (scatter-gather): the header of the frame, the default DHT
+  segment when it's missing, the scan up to and including the EOI and an
+  EOI when it's missing. The chunks point into the frame and into static
+  memory, so you can write them with `writev()` or to a socket without
+  copying the frame. Use `jpeg_copy_chunks()` when you need one block.
+
+  Example
+  -------
+
+      JpegMarkerInfo info;
+      JpegChunk chunks[CA_JPEG_MAX_CHUNKS];
+
+      if (0 == jpeg_scan_markers(frame.plane[0], frame.nbytes, info)) {
+        int n = jpeg_get_chunks(frame.plane[0], frame.nbytes, info, chunks);
+        for (int i = 0; i < n; ++i) {
+          fwrite(chunks[i].data, 1, chunks[i].nbytes, fp);
+        }
+      }
+
+ */
+#ifndef VIDEO_CAPTURE_JPEG_MARKERS_H
+#define VIDEO_CAPTURE_JPEG_MARKERS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <videocapture/Types.h>
+
+#define CA_JPEG_MAX_CHUNKS 4                                                        /* The maximum number of chunks that `jpeg_get_chunks()` returns. */
+
+namespace ca {
+
+  struct JpegMarkerInfo {                                                           /* What `jpeg_scan_markers()` found; offsets are in bytes from the start of the frame. */
+    size_t sof_offset;                                                              /* Offset of the SOFn marker. */
+    size_t sos_offset;                                                              /* Offset of the first SOS marker; the entropy coded data follows its header. */
+    size_t eoi_offset;                                                              /* Offset of the EOI marker; 0 when the frame is cut off. */
+    int sof_marker;                                                                 /* The SOFn marker, e.g. 0xC0 for baseline. */
+    int width;                                                                      /* From the SOF segment. */
+    int height;                                                                     /* From the SOF segment. */
+    int num_components;                                                             /* From the SOF segment; 1 (grayscale) or 3 for webcams. */
+    bool has_dht;                                                                   /* Is true when the header has a DHT segment. */
+    bool has_dqt;                                                                   /* Is true when the header has a DQT segment. */
+  };
+
+  typedef DataChunk JpegChunk;                                                      /* A piece of a JPEG that points into the frame or into static memory; see `jpeg_get_chunks()`. */
+
+  int jpeg_scan_markers(const uint8_t* data, size_t nbytes, JpegMarkerInfo& info); /* Parses the marker segments up to the first SOS. Returns 0 on success, < 0 when the frame isn't a JPEG we can use (no SOI, SOF or SOS, or a segment runs past the end). */
+  int jpeg_get_chunks(const uint8_t* data, size_t nbytes, const JpegMarkerInfo& info, JpegChunk* chunks); /* Fills `chunks` (at least CA_JPEG_MAX_CHUNKS) with a complete JPEG; inserts the default DHT and EOI when missing and drops the bytes after the EOI. Returns the number of chunks. */
+  size_t jpeg_get_chunks_size(const JpegChunk* chunks, int nchunks);               /* Returns the total number of bytes of the chunks. */
+  size_t jpeg_copy_chunks(const JpegChunk* chunks, int nchunks, uint8_t* dst, size_t capacity); /* Copies the chunks into `dst`. Returns the number of bytes copied or 0 when `capacity` is too small. */
+  const uint8_t* jpeg_get_default_dht(size_t& nbytes);                              /* Returns the DHT segment (with marker) that holds the four default Huffman tables. */
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,73 @@
+/*
+
+  LatencyHistogram
+  ----------------
+
+  A fixed size histogram of durations in nanoseconds, like HdrHistogram:
+  values below 64 ns have their own bucket and every power of two above
+  that is split into 32 buckets, so a percentile is at most ~3% (1/32)
+  off, from nanoseconds up to 2^40 ns (~18 minutes; longer durations
+  count as the maximum). It's 1152 counters, no allocations, and
+  `record()` is a bit scan and an increment, so we can record every
+  frame:
+
+     LatencyHistogram h;
+     h.record(time_now_ns() - buffer.timestamp);
+     ...
+     printf("p99: %llu ns\n", (unsigned long long)h.getPercentile(99.0));
+
+  The capture drivers keep histograms for the steps a frame takes, see
+  CaptureStats.h and `Capture::getLatency()`.
+
+  A histogram isn't thread safe by itself; `CaptureStats` makes sure
+  only the capture thread writes and readers copy it.
+
+ */
+#ifndef VIDEO_CAPTURE_LATENCY_HISTOGRAM_H
+#define VIDEO_CAPTURE_LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+
+#define CA_LATENCY_SUB_BITS 5                                                       /* Every power of two has 2^5 buckets; the relative error is at most 1/32. */
+#define CA_LATENCY_MAX_BITS 40                                                      /* We count durations up to 2^40 ns. */
+#define CA_LATENCY_NUM_BUCKETS ((CA_LATENCY_MAX_BITS - CA_LATENCY_SUB_BITS + 1) << CA_LATENCY_SUB_BITS)
+
+namespace ca {
+
+  class LatencyHistogram {
+  public:
+    LatencyHistogram();
+    void reset();                                                                   /* Clears all counts. */
+    void record(uint64_t ns);                                                       /* Adds a duration. */
+    uint64_t getCount();                                                            /* The number of recorded durations. */
+    uint64_t getMin();                                                              /* The shortest duration (exact); 0 when empty. */
+    uint64_t getMax();                                                              /* The longest duration (exact); 0 when empty. */
+    double getMean();                                                               /* The average duration (exact); 0 when empty. */
+    uint64_t getPercentile(double p);                                               /* The duration `p` percent (0 - 100) of the recorded durations are at or below; the upper edge of its bucket, so it's at most ~3% too high. 0 when empty. */
+
+  private:
+    uint64_t counts[CA_LATENCY_NUM_BUCKETS];
+    uint64_t total;                                                                 /* The sum of `counts`. */
+    uint64_t min;
+    uint64_t max;
+    uint64_t sum;                                                                   /* The sum of all durations, for `getMean()`. */
+  };
+
+  int latency_histogram_get_bucket(uint64_t ns);                                    /* The index of the bucket that counts `ns`. */
+  uint64_t latency_histogram_get_bucket_max(int bucket);                            /* The largest duration that is counted by `bucket`. */
+
+  inline uint64_t LatencyHistogram::getCount() {
+    return total;
+  }
+
+  inline uint64_t LatencyHistogram::getMin() {
+    return min;
+  }
+
+  inline uint64_t LatencyHistogram::getMax() {
+    return max;
+  }
+
+} /* namespace ca */
+
+#endif
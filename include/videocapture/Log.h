@@ -0,0 +1,98 @@
+/*
+
+  Log
+  ---
+
+  The library logs its errors and warnings through these macros instead
+  of calling printf():
+
+     CA_LOG_ERROR("cannot open %s: %s.", path.c_str(), strerror(errno));
+     CA_LOG_WARNING("...");
+     CA_LOG_INFO("...");
+     CA_LOG_DEBUG("...");
+
+  By default messages go to stdout with an "Error: " / "Warning: "
+  prefix, like they always did. You can change that:
+
+     - `log_set_level()` sets the most verbose level that is logged
+       (default CA_LOG_LEVEL_INFO); CA_LOG_LEVEL_NONE turns logging off.
+
+     - `log_set_callback()` passes the messages to your own function,
+       e.g. to forward them to syslog or the log of your application.
+       Set it before you start capturing.
+
+     - `log_start_async()` makes logging non blocking: the messages are
+       copied into a queue of CA_LOG_QUEUE_SIZE messages and a log
+       thread calls the callback, so a slow stdout or log file never
+       stalls the capture loop. When the queue is full we drop the
+       message and the log thread reports how many it dropped.
+       `log_stop_async()` writes the queued messages and stops the
+       thread.
+
+  Every CA_LOG_* call site logs at most CA_LOG_RATE_LIMIT messages per
+  CA_LOG_RATE_WINDOW_NS; when a camera starts failing on every frame we
+  log a few messages per second instead of thousands. The first message
+  of the next window says how many were suppressed. The counters of a
+  site aren't atomic, when several threads log from the same site at the
+  same time the limit is approximate.
+
+  Log messages are about what went wrong; to handle an error in code,
+  use the error code of the failed call, see Error.h.
+
+ */
+#ifndef VIDEO_CAPTURE_LOG_H
+#define VIDEO_CAPTURE_LOG_H
+
+#include <stdint.h>
+
+#define CA_LOG_LEVEL_NONE 0                                                         /* Nothing is logged. */
+#define CA_LOG_LEVEL_ERROR 1                                                        /* Something failed. */
+#define CA_LOG_LEVEL_WARNING 2                                                      /* Something unexpected that we handled. */
+#define CA_LOG_LEVEL_INFO 3                                                         /* What we're doing; e.g. the format we selected. */
+#define CA_LOG_LEVEL_DEBUG 4                                                        /* Details for developers. */
+
+#define CA_LOG_MAX_MESSAGE 512                                                      /* Longer messages are truncated. */
+#define CA_LOG_QUEUE_SIZE 256                                                       /* The number of messages the async queue holds. */
+#define CA_LOG_RATE_LIMIT 10                                                        /* The number of messages a call site may log per window. */
+#define CA_LOG_RATE_WINDOW_NS 1000000000ull                                         /* The rate limit window: one second. */
+
+#if defined(__GNUC__)
+#  define CA_LOG_PRINTF_FORMAT(fmt, args) __attribute__((format(printf, fmt, args)))
+#else
+#  define CA_LOG_PRINTF_FORMAT(fmt, args)
+#endif
+
+#define CA_LOG_AT(level, ...)                                                       \
+  do {                                                                              \
+    static ca::LogSite ca_log_site = { 0, 0, 0 };                                   \
+    ca::log_write(&ca_log_site, level, __VA_ARGS__);                                \
+  } while (0)
+
+#define CA_LOG_ERROR(...) CA_LOG_AT(CA_LOG_LEVEL_ERROR, __VA_ARGS__)
+#define CA_LOG_WARNING(...) CA_LOG_AT(CA_LOG_LEVEL_WARNING, __VA_ARGS__)
+#define CA_LOG_INFO(...) CA_LOG_AT(CA_LOG_LEVEL_INFO, __VA_ARGS__)
+#define CA_LOG_DEBUG(...) CA_LOG_AT(CA_LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+namespace ca {
+
+  typedef void(*log_callback)(int level, const char* message, void* user);         /* Receives a message (without a newline) of the given CA_LOG_LEVEL_*. */
+
+  struct LogSite {                                                                  /* The rate limit state of a call site; a static in CA_LOG_AT(). */
+    uint64_t window_start;                                                          /* When the current window started; 0 before the first message. */
+    uint32_t count;                                                                 /* The messages we logged in the current window. */
+    uint32_t suppressed;                                                            /* The messages we suppressed in the current window. */
+  };
+
+  void log_set_level(int level);                                                    /* Sets the most verbose CA_LOG_LEVEL_* we log. */
+  int log_get_level();
+  void log_set_callback(log_callback cb, void* user);                               /* Receive the messages; NULL restores the default that prints to stdout. */
+  int log_start_async();                                                            /* Starts the log thread; from now on logging only copies the message. Returns 0 on success, < 0 on error. */
+  int log_stop_async();                                                             /* Writes the queued messages and stops the log thread. Returns 0 on success, < 0 on error. */
+  uint64_t log_get_num_dropped();                                                   /* The messages we dropped because the async queue was full. */
+  uint64_t log_get_num_suppressed();                                                /* The messages the rate limit suppressed. */
+  const char* log_level_to_string(int level);
+  void log_write(LogSite* site, int level, const char* fmt, ...) CA_LOG_PRINTF_FORMAT(3, 4); /* Use the CA_LOG_* macros; `site` may be NULL to log without a rate limit. */
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,63 @@
+/*
+
+  LosslessCodec
+  -------------
+
+  The compression and filters of the frame files (see FrameFile.h). LZ4
+  (CA_COMPRESS_LZ4) and Zstandard (CA_COMPRESS_ZSTD) are optional, see
+  USE_LZ4 and USE_ZSTD in build/CMakeLists.txt; CA_COMPRESS_NONE always
+  works.
+
+  A `LosslessCompressor` keeps the state of the compression library, so
+  compressing a plane doesn't allocate; use one per thread. The `level` of
+  `init()` is the acceleration for LZ4 (1 is the default, higher is faster
+  and larger) and the compression level for Zstandard (1 is the fastest,
+  19 the smallest); 0 picks 1 for both, which is what you want at line
+  rate.
+
+  The filters work on bytes with wrap around arithmetic, so they're
+  exactly reversible for every format and compile into plain SIMD
+  subtractions:
+
+     - `lossless_delta_rows()` replaces every row, bottom to top, by its
+       difference with the row above. Works in place.
+     - `lossless_delta_frame()` stores the difference of a frame with the
+       previous one and updates the previous frame, in one pass.
+
+ */
+#ifndef VIDEO_CAPTURE_LOSSLESS_CODEC_H
+#define VIDEO_CAPTURE_LOSSLESS_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <videocapture/FrameFile.h>
+
+namespace ca {
+
+  struct LosslessCompressorState;                                                   /* The state of the compression library, see LosslessCodec.cpp. */
+
+  class LosslessCompressor {
+  public:
+    LosslessCompressor();
+    ~LosslessCompressor();
+    int init(int method, int level = 0);                                            /* Prepares for CA_COMPRESS_* `method`. Returns 0 on success, < 0 when the method isn't available. */
+    int shutdown();
+    size_t compress(const uint8_t* src, size_t nbytes, uint8_t* dst, size_t capacity); /* Compresses `src` into `dst`. Returns the compressed size, or 0 on error or when it doesn't fit in `capacity`. */
+
+  private:
+    LosslessCompressorState* state;                                                 /* NULL when not initialized. */
+    int method;                                                                     /* CA_COMPRESS_*. */
+    int level;                                                                      /* See above. */
+  };
+
+  bool lossless_is_available(int method);                                           /* Returns true when we're compiled with the CA_COMPRESS_* method. */
+  size_t lossless_get_bound(int method, size_t nbytes);                             /* The largest compressed size of `nbytes`. */
+  int lossless_decompress(int method, const uint8_t* src, size_t nbytes, uint8_t* dst, size_t rawbytes); /* Decompresses into exactly `rawbytes` bytes. Returns 0 on success, < 0 when the data is corrupt. */
+  void lossless_delta_rows(uint8_t* data, size_t stride, size_t height);            /* Replaces every row except the first by its difference with the row above. */
+  void lossless_undelta_rows(uint8_t* data, size_t stride, size_t height);          /* Reverts `lossless_delta_rows()`. */
+  void lossless_delta_frame(const uint8_t* cur, uint8_t* prev, uint8_t* dst, size_t nbytes); /* Writes `cur - prev` into `dst` and copies `cur` into `prev`. */
+  void lossless_undelta_frame(uint8_t* data, uint8_t* prev, size_t nbytes);         /* Adds `prev` to the difference in `data` and copies the result into `prev`. */
+
+} /* namespace ca */
+
+#endif
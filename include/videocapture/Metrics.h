@@ -0,0 +1,109 @@
+/*
+
+  Metrics
+  -------
+
+  Exposes the stats of your capture devices (see CaptureStats.h) in the
+  Prometheus text format, so a fleet of capture machines can be scraped
+  and alerted on without extra code in every application:
+
+     MetricsExporter metrics;
+     metrics.addCapture("front", &cap_front);
+     metrics.addCapture("back", &cap_back);
+     metrics.listen(9464);                          // http://127.0.0.1:9464/metrics
+     ...
+     metrics.stop();
+
+  Or serve them on a Unix socket, e.g. for a node exporter side car:
+
+     metrics.listenUnix("/run/videocapture/metrics.sock");
+
+  The server is a small HTTP/1.0 responder on its own thread, without
+  external dependencies; it answers `GET /metrics` (and `GET /`) and
+  closes the connection. A scrape only reads the lock free stats, so
+  it doesn't slow down capturing. The TCP server only binds to
+  127.0.0.1; put a reverse proxy in front when you must scrape from
+  another host. You can also call `render()` and serve the text
+  yourself.
+
+  Every metric has a `device` label with the name you passed into
+  `addCapture()`:
+
+     videocapture_frames_captured_total      counter  Frames received from the device.
+     videocapture_frames_delivered_total     counter  Frames passed to the frame callback.
+     videocapture_frames_dropped_total       counter  Frames lost or dropped.
+     videocapture_fps                        gauge    The moving average of the frame rate.
+     videocapture_jitter_seconds             gauge    The moving average of the frame interval jitter.
+     videocapture_reconnects_total           counter  How often the device was opened again.
+     videocapture_recoveries_total           counter  How often the watchdog recovered a stalled
+                                                      stream, with an `action` label: restart,
+                                                      reallocate or reopen.
+     videocapture_buffers                    gauge    The buffers of the driver.
+     videocapture_buffers_queued             gauge    The buffers the driver can capture into.
+     videocapture_buffers_held               gauge    The buffers held by the pipeline and callback.
+     videocapture_latency_seconds            summary  The p50, p90, p99 and p99.9 of every step
+                                                      a frame takes, with a `stage` label:
+                                                      dequeue, deliver, callback or convert (the
+                                                      conversion and rotation time).
+
+  The latency quantiles are over everything recorded since the device
+  was opened or `Capture::resetLatency()` was called.
+
+  The HTTP server is only compiled with USE_METRICS (a library that can
+  open a port is something you opt in to when you build it); without it
+  `listen()` and `listenUnix()` fail, `render()` always works. The
+  server isn't available on Windows yet.
+
+ */
+#ifndef VIDEO_CAPTURE_METRICS_H
+#define VIDEO_CAPTURE_METRICS_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <videocapture/Thread.h>
+
+#define CA_METRICS_POLL_MS 250                                                      /* How often the server thread checks if it must stop. */
+#define CA_METRICS_MAX_REQUEST 4096                                                 /* We don't read more of a request than this. */
+#define CA_METRICS_TIMEOUT_SEC 2                                                    /* A client that doesn't send its request (or read the response) in time is dropped. */
+
+namespace ca {
+
+  class Capture;
+
+  struct MetricsDevice {
+    std::string name;                                                               /* The value of the `device` label. */
+    Capture* cap;                                                                   /* Not owned. */
+  };
+
+  class MetricsExporter {
+  public:
+    MetricsExporter();
+    ~MetricsExporter();                                                             /* Stops the server. */
+    int addCapture(const std::string& name, Capture* cap);                          /* Exports the stats of `cap` with the label device="name"; `cap` must stay alive until it's removed. Returns 0 on success, < 0 when the name is used or invalid. */
+    int removeCapture(const std::string& name);                                     /* Stops exporting a capture. Returns 0 on success, < 0 when we don't know the name. */
+    int render(std::string& result);                                                /* Writes the metrics of all captures in the Prometheus text format into `result`. Returns 0 on success. */
+    int listen(int port);                                                           /* Starts serving the metrics on 127.0.0.1:port. Returns 0 on success, < 0 on error. */
+    int listenUnix(const std::string& path);                                        /* Starts serving the metrics on a Unix socket; an existing socket file is replaced. Returns 0 on success, < 0 on error. */
+    int stop();                                                                     /* Stops the server; returns 0 on success, also when it wasn't running. */
+    bool isListening();
+
+  public:
+    void serve();                                                                   /* The loop of the server thread; don't call it yourself. */
+
+  private:
+    int startServer(int fd);                                                        /* Starts the thread that accepts connections on `fd`. */
+    void handleClient(int fd);                                                      /* Reads the request and writes the response. */
+
+  private:
+    Mutex mutex;                                                                    /* Protects `devices`; the server thread renders while you add or remove captures. */
+    std::vector<MetricsDevice> devices;
+    Thread thread;                                                                  /* The server thread. */
+    int listen_fd;                                                                  /* The listening socket; -1 when we're not serving. */
+    std::string unix_path;                                                          /* The socket file we created; removed by `stop()`. */
+    volatile int must_stop;                                                         /* Tells the server thread to stop. */
+  };
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,88 @@
+/*
+
+  MjpegDecoder
+  ------------
+
+  Decodes CA_MJPEG and CA_JPEG_OPENDML frames, as delivered by most USB
+  webcams at high resolutions, using libjpeg-turbo. Only available when the
+  library is compiled with USE_JPEG (see build/CMakeLists.txt); without it
+  `init()` fails and `mjpeg_decoder_is_available()` returns false.
+
+  The decompressor is created once in `init()` and reused for every frame,
+  so are the internal buffers; `decode()` doesn't allocate once the buffers
+  have grown to the frame size.
+
+  Output formats:
+
+     - CA_YUVJ420P                    The full range YCbCr of the JPEG.
+     - CA_YUV420P, CA_YUV422P         Mapped into video range so they work
+                                      with the kernels in Convert.h.
+     - CA_RGB24, CA_BGRA32,           Converted by libjpeg-turbo, with
+       CA_RGBA32, CA_ARGB32           fancy upsampling.
+
+  The YUV outputs are decoded as raw (downsampled) data; we resample the
+  chroma ourself when the sampling of the JPEG (mostly 4:2:2 for webcams)
+  differs from the output.
+
+  Scaling
+  -------
+
+  libjpeg-turbo can skip the high frequencies of every 8x8 block and decode
+  at 1/2, 1/4 or 1/8 of the size, which is a lot cheaper than decoding at
+  full size and scaling down. Pass the denominator to `init()` and use
+  `mjpeg_get_scaled_size()` to get the size of the output buffer.
+
+  Example
+  -------
+
+      MjpegDecoder decoder;
+      decoder.init(CA_YUV420P, 2);
+
+      PixelBuffer out;
+      mjpeg_get_scaled_size(1920, 1080, 2, w, h);
+      out.setup(w, h, CA_YUV420P);
+      ...
+      decoder.decode(jpeg_bytes, jpeg_nbytes, out);
+
+ */
+#ifndef VIDEO_CAPTURE_MJPEG_DECODER_H
+#define VIDEO_CAPTURE_MJPEG_DECODER_H
+
+#include <vector>
+#include <videocapture/Types.h>
+
+namespace ca {
+
+  struct MjpegDecoderState;                                                         /* The libjpeg-turbo state, see MjpegDecoder.cpp. */
+
+  class MjpegDecoder {
+  public:
+    MjpegDecoder();
+    ~MjpegDecoder();
+    int init(int outfmt, int scaledenom = 1);                                       /* Creates the decompressor; `outfmt` must be one of `mjpeg_decoder_get_formats()` and `scaledenom` 1, 2, 4 or 8. Returns 0 on success, < 0 on error. */
+    int shutdown();                                                                 /* Destroys the decompressor and frees the buffers. */
+    int decode(const uint8_t* data, size_t nbytes, PixelBuffer& out);               /* Decodes one JPEG into `out`, which must be set up for the scaled size and output format. Returns 0 on success, < 0 on error (e.g. a corrupt frame). */
+    int getOutputFormat();                                                          /* The format we decode into. */
+    int getScaleDenom();                                                            /* The scale denominator that was passed into `init()`. */
+
+  private:
+    int decodeRaw(PixelBuffer& out);                                                /* Decodes the YCbCr planes and resamples them into `out`; the header must be read. */
+    int decodeColor(PixelBuffer& out);                                              /* Decodes into the packed RGB formats; the header must be read. */
+
+  private:
+    MjpegDecoderState* state;                                                       /* The decompressor; NULL when not initialized. */
+    int output_format;                                                              /* The CA_* format we decode into. */
+    int scale_denom;                                                                /* 1, 2, 4 or 8. */
+    std::vector<uint8_t> raw_memory;                                                /* The full frame, downsampled, YCbCr planes. Reused between frames. */
+    uint8_t luma_lut[256];                                                          /* Maps the full range luma into video range. */
+    uint8_t chroma_lut[256];                                                        /* Maps the full range chroma into video range. */
+  };
+
+  bool mjpeg_decoder_is_available();                                                /* Returns true when we're compiled with libjpeg-turbo. */
+  std::vector<int> mjpeg_decoder_get_formats();                                     /* The formats we can decode into; empty when we're not available. */
+  bool mjpeg_decoder_can_decode_into(int fmt);                                      /* Returns true when `fmt` is one of `mjpeg_decoder_get_formats()`. */
+  int mjpeg_get_scaled_size(int width, int height, int scaledenom, int& outwidth, int& outheight); /* Returns the size of a frame decoded with the given denominator. Returns 0 on success, < 0 when the denominator is invalid. */
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,112 @@
+/*
+
+  MjpegDecoderPool
+  ----------------
+
+  Decodes consecutive MJPEG frames on several threads at once. One core
+  can't decode 4K MJPEG at 30 fps, but because every JPEG is independent
+  we can decode frame N+1 while frame N is still being decoded. Every
+  worker thread has its own `MjpegDecoder`.
+
+  `submit()` copies the compressed frame (so the capture driver can reuse
+  its buffer right away) and queues it. `acquireDecoded()` returns the
+  decoded frames in the order they were submitted; a frame that finished
+  early waits until the frames before it are done. Call `release()` when
+  you're done with a frame. Both `submit()` and `acquireDecoded()` are
+  meant to be called from the capture thread, so the frame callback runs
+  on the same thread as without the pool.
+
+  The number of frames in flight (queued, decoding, decoded or acquired)
+  is bounded by `maxframes`. When all of them are in use `submit()` applies
+  the drop policy:
+
+     - CA_DROP_NEWEST     The submitted frame is dropped.
+     - CA_DROP_OLDEST     The oldest frame that isn't being decoded is
+                          dropped and the submitted frame takes its place.
+                          When all frames are being decoded we drop the
+                          submitted frame.
+     - CA_DROP_NONE       Nothing is dropped; the caller must acquire the
+                          oldest frame first (`acquireDecoded(true)`
+                          waits for it), see `FramePipeline::process()`.
+
+  Every decoded frame has `PixelBuffer::decode_time` set to the time the
+  decoder spent on it; `timestamp`, `receive_time`, `sequence` and `user`
+  are copied from the submitted frame, so `time_now_ns() - timestamp` in
+  the frame callback is the latency from capture to delivery.
+
+ */
+#ifndef VIDEO_CAPTURE_MJPEG_DECODER_POOL_H
+#define VIDEO_CAPTURE_MJPEG_DECODER_POOL_H
+
+#include <vector>
+#include <videocapture/Types.h>
+#include <videocapture/Thread.h>
+#include <videocapture/MjpegDecoder.h>
+#include <videocapture/PixelBufferPool.h>
+
+namespace ca {
+
+  class MjpegDecoderPool;
+
+  /* -------------------------------------- */
+
+  struct MjpegDecodeFrame {                                                         /* A frame in flight. */
+    int state;                                                                      /* Where the frame is, see MjpegDecoderPool.cpp. */
+    uint64_t order;                                                                 /* The order in which the frame was submitted; we deliver in this order. */
+    std::vector<uint8_t> data;                                                      /* The compressed frame; grows to the largest frame and is reused. */
+    size_t nbytes;                                                                  /* The number of bytes in `data`. */
+    PixelBuffer* output;                                                            /* The buffer we decode into. */
+    uint64_t sequence;                                                              /* Copied from the submitted frame. */
+    uint64_t timestamp;                                                             /* Copied from the submitted frame. */
+    uint64_t receive_time;                                                          /* Copied from the submitted frame. */
+    uint64_t decode_time;                                                           /* The time it took to decode this frame, in nanoseconds. */
+    void* user;                                                                     /* Copied from the submitted frame. */
+  };
+
+  struct MjpegDecodeWorker {                                                        /* A decode thread. */
+    Thread thread;                                                                  /* The thread handle. */
+    MjpegDecoder decoder;                                                           /* The decoder that is only used by this thread. */
+    MjpegDecoderPool* pool;                                                         /* The pool we get our frames from. */
+  };
+
+  /* -------------------------------------- */
+
+  class MjpegDecoderPool {
+  public:
+    MjpegDecoderPool();
+    ~MjpegDecoderPool();                                                            /* Stops and joins the workers. */
+    int init(int width, int height, int outfmt, int scaledenom, int nthreads, int maxframes, int droppolicy); /* `width` and `height` are the size of the captured frames, `outfmt` and `scaledenom` as for `MjpegDecoder::init()`. `nthreads` 0 means one per core, `maxframes` 0 means two per thread. Returns 0 on success, < 0 on error. */
+    int shutdown();                                                                 /* Stops and joins the workers; frames that weren't delivered are discarded. Make sure none is still acquired. */
+    int submit(PixelBuffer& in);                                                    /* Queues a copy of the compressed frame. Returns 0 when queued, < 0 when a frame (this one or, with CA_DROP_OLDEST, the oldest) was dropped. */
+    PixelBuffer* acquireDecoded(bool wait = false);                                 /* Returns the next decoded frame in order, or NULL when it's not decoded yet. When `wait` is true we wait for it; we only return NULL when nothing is in flight. */
+    int release(PixelBuffer* buffer);                                               /* Gives an acquired frame back. Returns 0 on success, < 0 when it isn't ours. */
+    int getNumFree();                                                               /* The number of frames that can be submitted before we drop. */
+    int getNumThreads();                                                            /* The number of decode threads. */
+    uint64_t getNumDecoded();                                                       /* The number of frames that were decoded. */
+    uint64_t getNumDropped();                                                       /* The number of frames that were dropped because all frames were in flight. */
+    uint64_t getNumFailed();                                                        /* The number of frames that couldn't be decoded (e.g. corrupt). */
+
+  private:
+    static void workerMain(void* user);                                             /* Entry point of the decode threads. */
+    MjpegDecodeFrame* findOldest(int state);                                        /* Returns the frame with the lowest order in the given state, or NULL. Expects `mutex` to be locked. */
+    MjpegDecodeFrame* findHead();                                                   /* Returns the oldest frame that is queued, decoding, decoded or failed, or NULL. Expects `mutex` to be locked. */
+
+  private:
+    std::vector<MjpegDecodeWorker*> workers;                                        /* The decode threads. */
+    std::vector<MjpegDecodeFrame*> frames;                                          /* All frames, `maxframes` of them. */
+    PixelBufferPool output_pool;                                                    /* Holds the buffers we decode into; every frame owns one. */
+    Mutex mutex;                                                                    /* Protects the frame states and counters. */
+    Cond cond_work;                                                                 /* Signalled when a frame is queued or when the workers must stop. */
+    Cond cond_done;                                                                 /* Signalled when a frame was decoded. */
+    int drop_policy;                                                                /* One of CA_DROP_*. */
+    uint64_t next_order;                                                            /* The order of the next submitted frame. */
+    uint64_t num_decoded;                                                           /* See `getNumDecoded()`. */
+    uint64_t num_dropped;                                                           /* See `getNumDropped()`. */
+    uint64_t num_failed;                                                            /* See `getNumFailed()`. */
+    bool is_init;                                                                   /* Set to true in `init()`. */
+    bool must_stop;                                                                 /* Set to true when the workers must exit. */
+  };
+
+} /* namespace ca */
+
+#endif
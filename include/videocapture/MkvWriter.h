@@ -0,0 +1,88 @@
+/*
+
+  MkvWriter
+  ---------
+
+  Writes MJPEG, H.264 or H.265 frames into a Matroska file. Unlike AVI, Matroska
+  stores a timestamp per frame, so dropped frames simply leave a gap and
+  there's no size limit.
+
+  The file is written in one pass:
+
+     - The Segment, the Clusters and the values we only know at the end
+       (the duration, the position of the Cues) are written with a fixed
+       size of 8 bytes and patched afterwards.
+     - Frames are stored as SimpleBlocks. A new Cluster starts on a key
+       frame once the current one holds a second of video, or when the
+       16 bit relative timecode of a block would overflow. With H.264/5
+       every Cluster starts with a key frame, unless the camera sends
+       them less than every 32 seconds.
+     - Every Cluster that starts with a key frame gets a CuePoint, so a
+       player only seeks to a position it can decode from. The Cues are
+       kept in memory (reserved in `open()`) and written at the end,
+       followed by the SeekHead entry that points to them.
+
+  Timestamps are stored with a millisecond resolution (the default
+  TimecodeScale).
+
+ */
+#ifndef VIDEO_CAPTURE_MKV_WRITER_H
+#define VIDEO_CAPTURE_MKV_WRITER_H
+
+#include <vector>
+#include <videocapture/FileWriter.h>
+#include <videocapture/ContainerWriter.h>
+
+namespace ca {
+
+  struct MkvCuePoint {                                                              /* A Cluster, for the Cues. */
+    uint64_t time;                                                                  /* The timecode of the Cluster in milliseconds. */
+    uint64_t position;                                                              /* The offset of the Cluster, relative to the Segment data. */
+  };
+
+  class MkvWriter : public ContainerWriter {
+  public:
+    MkvWriter();
+    ~MkvWriter();
+    int open(const std::string& filepath, int width, int height, int fmt, int fps);
+    int close();
+    int writeFrame(const DataChunk* chunks, int nchunks, uint64_t timestamp, bool keyframe);
+    uint64_t getNumFrames();
+
+  private:
+    int writeHeader();                                                              /* Writes the EBML header, the SeekHead, the Info and the Tracks. */
+    int beginCluster(uint64_t time, bool keyframe);                                 /* Starts a Cluster at `time` (ms); adds a CuePoint when its first frame is a `keyframe`. */
+    int endCluster();                                                               /* Patches the size of the current Cluster. */
+    int writeCues();                                                                /* Writes the Cues and points the SeekHead to them. */
+    int writeId(uint32_t id);                                                       /* Writes an element ID (which already contains its length marker). */
+    int writeSize(uint64_t size);                                                   /* Writes a size as an EBML variable length integer. */
+    int writeUnknownSize();                                                         /* Writes an 8 byte size placeholder that we patch with `patchSize()`. */
+    int patchSize(uint64_t offset, uint64_t size);                                  /* Patches an 8 byte size that was written with `writeUnknownSize()`. */
+    int writeUInt(uint32_t id, uint64_t v);                                         /* Writes an unsigned integer element. */
+    int writeString(uint32_t id, const char* str);                                  /* Writes a string element. */
+    int writeFloat(uint32_t id, double v);                                          /* Writes an 8 byte float element. */
+    int writeBigEndian(uint64_t v, int nbytes);                                     /* Writes the lower `nbytes` bytes of `v`, big endian. */
+    int patchBigEndian(uint64_t offset, uint64_t v);                                /* Overwrites 8 bytes at `offset` with `v`, big endian. */
+
+  private:
+    FileWriter file;                                                                /* The output. */
+    std::vector<MkvCuePoint> cues;                                                  /* A CuePoint per Cluster that starts with a key frame. */
+    int width;                                                                      /* The frame width. */
+    int height;                                                                     /* The frame height. */
+    int fps;                                                                        /* The frame rate (CA_FPS_*). */
+    int pixel_format;                                                               /* CA_MJPEG, CA_JPEG_OPENDML, CA_H264 or CA_H265. */
+    uint64_t first_timestamp;                                                       /* The timestamp of the first frame in nanoseconds. */
+    uint64_t last_time;                                                             /* The time of the last frame in milliseconds. */
+    uint64_t num_frames;                                                            /* The number of frames we wrote. */
+    uint64_t segment_offset;                                                        /* File offset of the Segment size. */
+    uint64_t segment_data_offset;                                                   /* File offset of the Segment data; positions in the SeekHead and Cues are relative to it. */
+    uint64_t duration_offset;                                                       /* File offset of the Duration value. */
+    uint64_t cues_seek_offset;                                                      /* File offset of the SeekPosition value of the Cues. */
+    uint64_t cluster_offset;                                                        /* File offset of the size of the current Cluster. */
+    uint64_t cluster_time;                                                          /* The timecode of the current Cluster in milliseconds. */
+    bool has_cluster;                                                               /* Is true when a Cluster is open. */
+  };
+
+} /* namespace ca */
+
+#endif
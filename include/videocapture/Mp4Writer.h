@@ -0,0 +1,75 @@
+/*
+
+  Mp4Writer
+  ---------
+
+  Writes H.264 or H.265 frames into a fragmented MP4 file (ISO BMFF with movie
+  fragments, as used by DASH, HLS and Media Source Extensions):
+
+     - The header ('ftyp' and 'moov') only describes the track; it has no
+       samples, so we write it in `open()` and never have to patch it.
+     - The frames are stored in fragments ('moof' and 'mdat'). A fragment
+       starts with a key frame once the current one holds a second of
+       video, so every fragment can be decoded on its own and a file that
+       wasn't closed (e.g. after a crash) is playable up to the last
+       complete fragment.
+
+  A 'moof' must be written before its samples, so the frames of the
+  current fragment are collected in a buffer that we reuse; after the
+  first few fragments recording a frame doesn't allocate.
+
+  Timestamps are stored with a 90 kHz timescale. The duration of a frame
+  is the time until the next one, so dropped frames don't shift the
+  timeline. We assume the stream has no B-frames (decode order is
+  presentation order), which is true for the UVC cameras we know.
+
+ */
+#ifndef VIDEO_CAPTURE_MP4_WRITER_H
+#define VIDEO_CAPTURE_MP4_WRITER_H
+
+#include <vector>
+#include <videocapture/FileWriter.h>
+#include <videocapture/ContainerWriter.h>
+
+namespace ca {
+
+  struct Mp4Sample {                                                                /* A frame in the current fragment. */
+    uint64_t time;                                                                  /* The decode time in 90 kHz ticks since the first frame. */
+    uint32_t size;                                                                  /* The size of the frame. */
+    bool keyframe;                                                                  /* Is true for key frames. */
+  };
+
+  class Mp4Writer : public ContainerWriter {
+  public:
+    Mp4Writer();
+    ~Mp4Writer();
+    int open(const std::string& filepath, int width, int height, int fmt, int fps);
+    int close();
+    int writeFrame(const DataChunk* chunks, int nchunks, uint64_t timestamp, bool keyframe);
+    uint64_t getNumFrames();
+
+  private:
+    int writeHeader();                                                              /* Writes the 'ftyp' and 'moov' boxes. */
+    int writeFragment(uint64_t endtime);                                            /* Writes the 'moof' and 'mdat' of the collected frames; `endtime` is the time of the frame that follows. */
+    uint64_t beginBox(const char* type);                                            /* Writes a box header with a size that `endBox()` patches; returns the offset of the box. */
+    uint64_t beginFullBox(const char* type, uint8_t version, uint32_t flags);        /* Like `beginBox()` for a box with a version and flags. */
+    int endBox(uint64_t offset);                                                    /* Patches the size of the box that starts at `offset`. */
+
+  private:
+    FileWriter file;                                                                /* The output. */
+    std::vector<Mp4Sample> samples;                                                 /* The frames in the current fragment. */
+    std::vector<uint8_t> fragment;                                                  /* The data of the frames in the current fragment. */
+    size_t fragment_used;                                                           /* The number of bytes in `fragment`. */
+    int width;                                                                      /* The frame width. */
+    int height;                                                                     /* The frame height. */
+    int pixel_format;                                                               /* CA_H264 or CA_H265. */
+    uint32_t frame_duration;                                                        /* The duration of a frame in ticks according to the frame rate; used for the last frame. */
+    uint64_t first_timestamp;                                                       /* The timestamp of the first frame in nanoseconds. */
+    uint64_t last_time;                                                             /* The time of the last frame in ticks. */
+    uint64_t num_frames;                                                            /* The number of frames we wrote. */
+    uint32_t sequence_number;                                                       /* The number of fragments we wrote. */
+  };
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,44 @@
+/*
+
+  PixelBufferPool
+  ---------------
+
+  A fixed set of preallocated `PixelBuffer`s with the same size and pixel
+  format. The capture backends use this when they convert or decode frames
+  so that no memory is allocated per frame. `acquire()` returns a free
+  buffer or NULL when all buffers are in use, `release()` gives it back.
+  Both are thread safe. The pixels are 64 byte aligned, so the SIMD kernels
+  (see Cpu.h) can use aligned loads on the first row.
+
+ */
+#ifndef VIDEO_CAPTURE_PIXEL_BUFFER_POOL_H
+#define VIDEO_CAPTURE_PIXEL_BUFFER_POOL_H
+
+#include <vector>
+#include <videocapture/Types.h>
+#include <videocapture/Thread.h>
+
+namespace ca {
+
+  class PixelBufferPool {
+  public:
+    PixelBufferPool();
+    ~PixelBufferPool();
+    int init(int width, int height, int fmt, int count);                            /* Allocates `count` buffers; returns 0 on success, < 0 on error. */
+    int shutdown();                                                                 /* Frees all buffers; make sure none of them is still in use. */
+    PixelBuffer* acquire();                                                         /* Returns a free buffer or NULL when all buffers are in use. */
+    int release(PixelBuffer* buffer);                                               /* Gives a buffer back to the pool. Returns 0 on success, < 0 when the buffer isn't ours. */
+    int getNumFree();                                                               /* Returns the number of buffers that can be acquired. */
+    int getNumBuffers();                                                            /* Returns the total number of buffers. */
+
+  public:
+    std::vector<PixelBuffer*> buffers;                                              /* All buffers. */
+    std::vector<PixelBuffer*> free_buffers;                                         /* The buffers that can be acquired. */
+    std::vector<uint8_t*> memory;                                                   /* The (unaligned) allocations that hold the pixels. */
+    Mutex mutex;                                                                    /* Protects `free_buffers`. */
+    bool is_init;                                                                   /* Is set to true when initialized. */
+  };
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,73 @@
+/*
+
+  Recorder
+  --------
+
+  Records the compressed frames of a camera into a container file without
+  decoding them; open the capture device with CA_MJPEG or CA_H264 as output
+  format and pass the frames from the frame callback to `write()`:
+
+     Recorder rec;
+     rec.open("out.mkv", CA_CONTAINER_MKV, 1280, 720, CA_MJPEG, CA_FPS_30_00);
+
+     void on_frame(PixelBuffer& buffer) {
+       rec.write(buffer);
+     }
+
+  Many cameras send MJPEG frames without Huffman tables, or with garbage
+  after the EOI. We check every frame with `jpeg_scan_markers()` and let
+  the writer splice in the default tables (see JpegMarkers.h); frames that
+  aren't a JPEG are skipped and counted.
+
+  H.264 can be stored in Matroska and fragmented MP4. The container needs
+  the SPS and PPS in its header, so the file is created when the first key
+  frame with parameter sets arrives; frames before it can't be decoded and
+  are skipped. The frame size is taken from the SPS.
+
+  The frame timestamps (`PixelBuffer::timestamp`) are stored in the file,
+  so the recording keeps the timing of the camera; AVI, which has a
+  constant frame rate, repeats frames to fill gaps.
+
+ */
+#ifndef VIDEO_CAPTURE_RECORDER_H
+#define VIDEO_CAPTURE_RECORDER_H
+
+#include <string>
+#include <vector>
+#include <videocapture/Types.h>
+#include <videocapture/ContainerWriter.h>
+#include <videocapture/H264Parser.h>
+
+namespace ca {
+
+  class Recorder {
+  public:
+    Recorder();
+    ~Recorder();                                                                    /* Closes the file when it's still open. */
+    int open(const std::string& filepath, int container, int width, int height, int fmt, int fps); /* Prepares a file of the given container (CA_CONTAINER_*). Returns 0 on success, < 0 on error. */
+    int close();                                                                    /* Finishes the file. */
+    int write(PixelBuffer& buffer);                                                 /* Appends a frame. Returns 0 on success, < 0 on error, 1 when the frame was skipped. */
+    uint64_t getNumFrames();                                                        /* The number of frames in the file. */
+    uint64_t getNumCorrupt();                                                       /* The number of frames we skipped because they're corrupt. */
+    uint64_t getNumSkipped();                                                       /* The number of H.264 frames we skipped because we were waiting for a key frame. */
+
+  private:
+    int writeJpeg(PixelBuffer& buffer);                                             /* Checks the MJPEG frame and writes it. */
+    int writeH264(PixelBuffer& buffer);                                             /* Converts the H.264 access unit to length prefixed NAL units and writes it. */
+    int openH264(const uint8_t* data, const H264FrameInfo& info);                   /* Creates the file with the SPS and PPS of the first key frame. */
+
+  public:
+    ContainerWriter* writer;                                                        /* The container implementation. */
+    std::string filepath;                                                           /* The file we write. */
+    int pixel_format;                                                               /* The format of the frames we accept. */
+    int fps;                                                                        /* The frame rate (CA_FPS_*). */
+    bool is_writer_open;                                                            /* Is false until the writer created the file; for H.264 that's at the first key frame. */
+    uint64_t num_corrupt;                                                           /* The number of frames we skipped because they're corrupt. */
+    uint64_t num_skipped;                                                           /* The number of frames we skipped before the first key frame. */
+    H264FrameInfo h264_info;                                                        /* The NAL units of the current H.264 frame; a member because it's large. */
+    std::vector<uint8_t> avcc;                                                      /* The avcC that we create from the first key frame. */
+  };
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,51 @@
+/*
+
+  Rotate
+  ------
+
+  CPU kernels that rotate a frame by 90, 180 or 270 degrees clockwise.
+  This is the CPU equivalent of the texture coordinate tricks that
+  `CaptureGL::flip()` uses; e.g. for cameras that are mounted in portrait
+  orientation and feed analytics that don't use the GPU.
+
+  A per pixel 90 degree rotate reads the source column by column and misses
+  the cache on every pixel for large frames. We rotate in tiles that fit in
+  the L1 cache and transpose every tile in 8x8 (or 4x4) blocks in SIMD
+  registers (see simd/SIMD_Rotate.h). A rotation is a transpose with
+  mirrored rows or columns, so the kernels only walk the source or
+  destination with a negative stride. 180 degrees reverses every row.
+
+  Every kernel is a `pixel_kernel` that rotates a band of destination rows,
+  so a frame can be spread over several cores using a `SliceScheduler`.
+  For 90 and 270 degrees the destination must be set up with the width and
+  height swapped, e.g. `dst.setup(src.height[0], src.width[0], fmt)`; the
+  pixel format doesn't change.
+
+  Supported formats:
+
+     - 90, 180, 270:  CA_YUV420P, CA_YUVJ420P, CA_YUV420BP, CA_YUVJ420BP,
+                      CA_ARGB32, CA_BGRA32, CA_RGBA32, CA_RGB24
+     - 180:           CA_YUV422P, CA_YUYV422, CA_UYVY422
+
+  The 4:2:2 formats can't be rotated by 90 degrees without resampling the
+  chroma (it's subsampled horizontally only); convert them into CA_YUV420P
+  first, `FramePipeline` does this for you.
+
+ */
+#ifndef VIDEO_CAPTURE_ROTATE_H
+#define VIDEO_CAPTURE_ROTATE_H
+
+#include <videocapture/Types.h>
+#include <videocapture/SliceScheduler.h>
+
+namespace ca {
+
+  pixel_kernel rotate_get_kernel(int fmt, int degrees);                             /* Returns the kernel that rotates `fmt` by `degrees` (one of CA_ROTATE_*), or NULL when we can't. CA_ROTATE_NONE returns a copy kernel. */
+  bool rotate_is_supported(int fmt, int degrees);                                   /* Returns true when `rotate_get_kernel()` has a kernel for the format and rotation. */
+  int rotate_get_size(int width, int height, int degrees, int& outwidth, int& outheight); /* Sets the size of the rotated frame. Returns 0 on success, < 0 when `degrees` is invalid. */
+  int rotate(const PixelBuffer& src, PixelBuffer& dst, int degrees, SliceScheduler* scheduler = NULL); /* Rotates `src` into `dst`, both must have the same pixel format. When `scheduler` is NULL we rotate on the calling thread. Returns 0 on success, < 0 on error. */
+  int rotate_selftest();                                                            /* Compares the SIMD transposes the CPU supports and all rotate kernels with a per pixel reference. Returns the number of failed tests, 0 when all are bit exact. */
+
+} /* namespace ca */
+
+#endif
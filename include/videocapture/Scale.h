@@ -0,0 +1,32 @@
+/*
+
+  Scaling
+  -------
+
+  Bilinear CPU scaling kernels. Like the conversion kernels these are
+  `pixel_kernel`s which scale a band of destination rows, so they can be
+  executed in parallel by a `SliceScheduler`. The source and destination
+  must have the same pixel format; the destination size is taken from the
+  destination buffer (see `PixelBuffer::setup()`).
+
+  Supported pixel formats:
+
+     - CA_YUV420P, CA_YUVJ420P, CA_YUV422P  (each plane is scaled)
+     - CA_YUV420BP, CA_YUVJ420BP            (Cb/Cr are scaled as pairs)
+     - CA_ARGB32, CA_BGRA32, CA_RGBA32, CA_RGB24
+
+ */
+#ifndef VIDEO_CAPTURE_SCALE_H
+#define VIDEO_CAPTURE_SCALE_H
+
+#include <videocapture/Types.h>
+#include <videocapture/SliceScheduler.h>
+
+namespace ca {
+
+  pixel_kernel scale_get_kernel(int fmt);                                           /* Returns the scale kernel for the given pixel format or NULL when we can't scale it. */
+  int scale(const PixelBuffer& src, PixelBuffer& dst, SliceScheduler* scheduler = NULL); /* Scales `src` into `dst`. When `scheduler` is NULL we scale on the calling thread. Returns 0 on success, < 0 on error. */
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,62 @@
+/*
+
+  SliceScheduler
+  --------------
+
+  Splits a frame into horizontal bands and runs a `pixel_kernel` over these
+  bands on a `ThreadPool`. All CPU kernels of the library (conversion,
+  scaling, ...) have the `pixel_kernel` signature which processes a range
+  of destination rows, so any of them can be executed in parallel.
+
+  Bands always start on a row that is a multiple of the vertical chroma
+  subsampling of both the source and destination format (e.g. even rows for
+  CA_YUV420P) so a kernel never has to share a chroma row with another
+  thread.
+
+  Frames with less than `min_pixels` destination pixels are processed on the
+  calling thread because for small frames waking up the workers costs more
+  than it saves.
+
+  Example
+  -------
+
+      SliceScheduler scheduler;
+      scheduler.init(4);
+      convert(src, dst, &scheduler);
+
+ */
+#ifndef VIDEO_CAPTURE_SLICE_SCHEDULER_H
+#define VIDEO_CAPTURE_SLICE_SCHEDULER_H
+
+#include <vector>
+#include <videocapture/Types.h>
+#include <videocapture/ThreadPool.h>
+
+namespace ca {
+
+  typedef void(*pixel_kernel)(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);     /* A CPU kernel that processes the destination rows [y0, y1). */
+
+  class SliceScheduler {
+  public:
+    SliceScheduler();
+    ~SliceScheduler();
+    int init(int nthreads, std::vector<int> cpus = std::vector<int>());            /* Start the worker threads; see `ThreadPool::init()`. When not initialized, `run()` executes kernels inline. */
+    int shutdown();                                                                 /* Stop the worker threads. */
+    int run(pixel_kernel kernel, const PixelBuffer& src, PixelBuffer& dst);         /* Runs the kernel for all rows of `dst`, spread over the worker threads. Returns 0 on success, < 0 on error. */
+    int getNumThreads();                                                            /* The number of threads that execute bands. */
+
+  public:
+    int min_pixels;                                                                 /* Destinations with fewer pixels are processed on the calling thread. */
+    int slices_per_thread;                                                          /* Number of bands per thread; more bands balance better when cores are busy with other work. */
+
+  private:
+    static void executeSlice(void* user, int index);                                /* Pool job that executes one band. */
+
+  private:
+    ThreadPool pool;
+    bool is_init;
+  };
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,74 @@
+/*
+
+  Threading
+  ---------
+
+  Thin wrappers around the native threading primitives (pthreads on Linux
+  and Mac, the Win32 API on Windows). These are used by the internal worker
+  pools of the library; they are not meant to be a complete threading
+  library. All functions return 0 on success and < 0 on error.
+
+ */
+#ifndef VIDEO_CAPTURE_THREAD_H
+#define VIDEO_CAPTURE_THREAD_H
+
+#if defined(_WIN32)
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#else
+#  include <pthread.h>
+#endif
+
+namespace ca {
+
+  typedef void(*thread_function)(void* user);                                      /* Signature of the function that is executed by a thread. */
+
+#if defined(_WIN32)
+  struct Mutex {
+    CRITICAL_SECTION handle;
+  };
+
+  struct Cond {
+    CONDITION_VARIABLE handle;
+  };
+
+  struct Thread {
+    HANDLE handle;
+    thread_function func;
+    void* user;
+  };
+#else
+  struct Mutex {
+    pthread_mutex_t handle;
+  };
+
+  struct Cond {
+    pthread_cond_t handle;
+  };
+
+  struct Thread {
+    pthread_t handle;
+    thread_function func;
+    void* user;
+  };
+#endif
+
+  int mutex_create(Mutex& m);
+  int mutex_destroy(Mutex& m);
+  int mutex_lock(Mutex& m);
+  int mutex_unlock(Mutex& m);
+
+  int cond_create(Cond& c);
+  int cond_destroy(Cond& c);
+  int cond_wait(Cond& c, Mutex& m);                                                 /* Wait until signalled; the mutex must be locked by the caller. */
+  int cond_signal(Cond& c);
+  int cond_broadcast(Cond& c);
+
+  int thread_create(Thread& t, thread_function func, void* user);                   /* Starts a new thread that calls func(user). The Thread object must stay alive until you joined it. */
+  int thread_join(Thread& t);                                                       /* Waits until the thread exits. */
+  int thread_set_affinity(Thread& t, int cpu);                                      /* Pin the thread to the given cpu index. Returns -1 when not supported on this OS. */
+  int cpu_count();                                                                  /* Returns the number of online logical cpus (at least 1). */
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,57 @@
+/*
+
+  ThreadPool
+  ----------
+
+  A small fork/join thread pool. `run()` hands out `njobs` job indices to the
+  worker threads and the calling thread and returns once all of them have
+  been executed. This is what the `SliceScheduler` uses to spread a pixel
+  kernel over several cores; it's not a generic task queue.
+
+  The thread that calls `run()` participates in the work, so a pool that
+  was initialized with 4 threads creates 3 workers.
+
+ */
+#ifndef VIDEO_CAPTURE_THREAD_POOL_H
+#define VIDEO_CAPTURE_THREAD_POOL_H
+
+#include <vector>
+#include <stdint.h>
+#include <videocapture/Thread.h>
+
+namespace ca {
+
+  typedef void(*pool_job)(void* user, int index);                                  /* A job; `index` is in the range [0, njobs) as passed into `run()`. */
+
+  class ThreadPool {
+  public:
+    ThreadPool();
+    ~ThreadPool();                                                                  /* Stops and joins the workers. */
+    int init(int nthreads, std::vector<int> cpus = std::vector<int>());             /* Start the pool; `nthreads` includes the calling thread, 0 means one per core. When `cpus` is given, worker N is pinned to cpus[N % cpus.size()]. */
+    int shutdown();                                                                 /* Stops and joins all workers. */
+    int run(pool_job job, void* user, int njobs);                                   /* Executes job(user, i) for every i in [0, njobs) and blocks until all jobs are done. Safe to call from multiple threads (calls are serialized). */
+    int getNumThreads();                                                            /* Returns the number of threads that execute jobs, including the caller of `run()`. */
+
+  private:
+    static void workerMain(void* user);                                             /* Entry point of the worker threads. */
+    void executeJobs();                                                             /* Grabs and executes job indices until none are left. Expects `mutex` to be locked. */
+
+  private:
+    std::vector<Thread*> threads;                                                   /* The worker threads. */
+    Mutex mutex;                                                                    /* Protects the job state below. */
+    Mutex run_mutex;                                                                /* Serializes calls to `run()`. */
+    Cond cond_work;                                                                 /* Signalled when a new batch of jobs is available. */
+    Cond cond_done;                                                                 /* Signalled when the last job of a batch finished. */
+    pool_job job;                                                                   /* The job of the current batch. */
+    void* job_user;                                                                 /* User pointer for the current batch. */
+    int job_count;                                                                  /* Number of jobs in the current batch. */
+    int job_next;                                                                   /* Next job index to hand out. */
+    int job_done;                                                                   /* Number of finished jobs in the current batch. */
+    uint64_t generation;                                                            /* Incremented for every batch; used by workers to detect new work. */
+    bool is_init;                                                                   /* Set to true in `init()`. */
+    bool must_stop;                                                                 /* Set to true when the workers must exit. */
+  };
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,121 @@
+/*
+
+  Trace
+  -----
+
+  Trace points for the capture and processing pipeline that you can open
+  in chrome://tracing or https://ui.perfetto.dev to see which thread did
+  what and when, e.g. which of the 16 cameras stalled and whether it was
+  waiting for the driver, a decoder or the frame callback.
+
+  The trace points are only compiled in when the library is built with
+  USE_TRACE (cmake -DUSE_TRACE=On); otherwise the CA_TRACE_* macros are
+  empty. When they're compiled in, nothing is recorded until you call
+  `trace_start()`:
+
+     trace_start();
+     ...
+     trace_stop();
+     trace_save("capture.json");
+
+  Every thread that records an event gets its own ring buffer of
+  CA_TRACE_MAX_EVENTS events, so recording is lock free and never
+  allocates after the first event of a thread: an event is a couple of
+  `time_now_ns()` calls and a few stores. When a ring buffer is full the
+  oldest events are overwritten, so you always have the last few seconds
+  of every thread. When a thread exits its events are kept until the
+  next `trace_save()` or `trace_clear()`; after that its ring buffer is
+  handed to the next new thread. We never allocate more than
+  CA_TRACE_MAX_THREADS ring buffers; the events of threads beyond that
+  aren't recorded until a save or clear frees a buffer.
+
+  The trace points we record, with their argument:
+
+     v4l2.dqbuf      VIDIOC_DQBUF that returned a frame; the sequence.
+     v4l2.qbuf       VIDIOC_QBUF; the sequence.
+     v4l2.corrupt    (instant) the driver returned a buffer with an error.
+     decode          Decoding a MJPEG or H.264 frame; the sequence.
+     convert         Converting a frame; the sequence.
+     rotate          Rotating a frame; the sequence.
+     callback        The frame callback; the sequence.
+     sink.write      Writing a frame to a Recorder, EncoderSink or
+                     LosslessRecorder; the sequence.
+     file.write      Writing buffered data to disk (FileWriter); the
+                     number of bytes.
+
+  `trace_save()` writes the Chrome Trace Event Format (JSON), which the
+  Perfetto UI opens as well. Save after `trace_stop()`; saving while the
+  threads are recording works, but we skip the events that were being
+  overwritten while we copied them.
+
+  The names you pass to the macros must stay valid until the trace is
+  saved; use string literals.
+
+ */
+#ifndef VIDEO_CAPTURE_TRACE_H
+#define VIDEO_CAPTURE_TRACE_H
+
+#include <stdint.h>
+#include <string>
+
+#define CA_TRACE_MAX_EVENTS 16384                                                   /* The size of the ring buffer of a thread; 40 bytes per event. */
+#define CA_TRACE_MAX_THREADS 64                                                     /* The maximum number of ring buffers; about 40 MB. */
+#define CA_TRACE_MAX_NAME 32                                                        /* The longest thread name we store, including the terminating zero. */
+
+#define CA_TRACE_COMPLETE 0                                                         /* An event with a duration ("X"). */
+#define CA_TRACE_INSTANT 1                                                          /* An event without a duration ("i"). */
+
+#if defined(USE_TRACE)
+#  define CA_TRACE_CONCAT_(a, b) a##b
+#  define CA_TRACE_CONCAT(a, b) CA_TRACE_CONCAT_(a, b)
+#  define CA_TRACE_SCOPE(name, arg) ca::TraceScope CA_TRACE_CONCAT(ca_trace_scope_, __LINE__)(name, (int64_t)(arg))   /* Records an event from here until the end of the scope. */
+#  define CA_TRACE_BEGIN(var) uint64_t var = ca::trace_begin()                                                      /* Starts an event that is recorded by CA_TRACE_END(var, ...); for when the argument is only known at the end. */
+#  define CA_TRACE_END(var, name, arg) ca::trace_end(var, name, (int64_t)(arg))
+#  define CA_TRACE_INSTANT_EVENT(name, arg) ca::trace_instant(name, (int64_t)(arg))
+#  define CA_TRACE_THREAD_NAME(name) ca::trace_set_thread_name(name)
+#else
+#  define CA_TRACE_SCOPE(name, arg)
+#  define CA_TRACE_BEGIN(var)
+#  define CA_TRACE_END(var, name, arg)
+#  define CA_TRACE_INSTANT_EVENT(name, arg)
+#  define CA_TRACE_THREAD_NAME(name)
+#endif
+
+namespace ca {
+
+  bool trace_is_available();                                                        /* Returns true when the library was built with USE_TRACE. */
+  int trace_start();                                                                /* Starts recording; the events that were recorded before are kept. Returns 0 on success, < 0 when tracing isn't available. */
+  int trace_stop();                                                                 /* Stops recording. Returns 0 on success. */
+  void trace_clear();                                                               /* Forgets the recorded events. */
+  int trace_save(const std::string& filepath);                                      /* Writes the recorded events as Chrome Trace Event JSON. Returns 0 on success, < 0 on error. */
+
+  void trace_set_thread_name(const char* name);                                     /* Names the calling thread in the trace; the name is copied. */
+  uint64_t trace_begin();                                                           /* Returns `time_now_ns()`, or 0 when we're not recording. */
+  void trace_end(uint64_t start, const char* name, int64_t arg);                    /* Records a CA_TRACE_COMPLETE event from `start` (see `trace_begin()`) until now; does nothing when `start` is 0. */
+  void trace_instant(const char* name, int64_t arg);                                /* Records a CA_TRACE_INSTANT event. */
+
+  class TraceScope {                                                                /* Records a CA_TRACE_COMPLETE event for its lifetime; use CA_TRACE_SCOPE(). */
+  public:
+    TraceScope(const char* name, int64_t arg);
+    ~TraceScope();
+
+  private:
+    const char* name;
+    int64_t arg;
+    uint64_t start;                                                                 /* 0 when we weren't recording when we were created. */
+  };
+
+  inline TraceScope::TraceScope(const char* name, int64_t arg)
+    :name(name)
+    ,arg(arg)
+    ,start(trace_begin())
+  {
+  }
+
+  inline TraceScope::~TraceScope() {
+    trace_end(start, name, arg);
+  }
+
+} /* namespace ca */
+
+#endif
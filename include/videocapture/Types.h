@@ -14,6 +14,8 @@
 #define CA_AV_FOUNDATION 2                                                          /* Mac:     Capture using AVFoundation. */
 #define CA_V4L2 3                                                                   /* Linux:   Capture using Video4Linux 2. */
 #define CA_DECKLINK 4                                                               /* All:     Capture using a Decklink device. */  
+#define CA_REPLAY 5                                                                 /* All:     Play back recorded files as if they were cameras, see replay/Replay_Capture.h. */
+#define CA_SYNTHETIC 6                                                              /* All:     Generate test patterns, for load tests without cameras, see synthetic/Synthetic_Capture.h. */
 
 /* Default driver per OS */
 #if defined(__APPLE__)
@@ -41,6 +43,7 @@
 #define CA_JPEG_OPENDML 12                                                          /* JPEG with Open-DML extensions */
 #define CA_H264 13                                                                  /* H264 */
 #define CA_MJPEG 14                                                                 /* MJPEG 2*/
+#define CA_H265 15                                                                  /* H265 (HEVC); only produced by the encoder sink (see EncoderSink.h). */
 
 /* Frame rates (IMPORANTANT: higher framerates MUST have a higher integer value for capability filtering)*/
 #define CA_FPS_60_00   6000
@@ -67,6 +70,34 @@
 #define CA_STATE_OPENED 0x01                                                       /* The user opened a device */
 #define CA_STATE_CAPTUREING 0x02                                                   /* The user started captureing */
 
+/* CPU feature levels, used to select the pixel kernels (see Cpu.h). The x86 levels are ordered; each one includes the ones before it. */
+#define CA_CPU_SCALAR 0                                                            /* Plain C++, works everywhere. */
+#define CA_CPU_SSE2 1                                                              /* x86: SSE2 */
+#define CA_CPU_SSSE3 2                                                             /* x86: SSSE3 (pshufb) */
+#define CA_CPU_AVX2 3                                                              /* x86: AVX2 */
+#define CA_CPU_AVX512 4                                                            /* x86: AVX-512 F + BW */
+#define CA_CPU_NEON 5                                                              /* ARM: NEON (Raspberry PI 2 and up, all aarch64) */
+
+/* Rotations, clockwise (see Rotate.h and `Settings.rotation`). */
+#define CA_ROTATE_NONE 0                                                           /* Deliver frames as captured. */
+#define CA_ROTATE_90 90                                                            /* Rotate 90 degrees clockwise; the width and height are swapped. */
+#define CA_ROTATE_180 180                                                          /* Rotate 180 degrees (upside down). */
+#define CA_ROTATE_270 270                                                          /* Rotate 270 degrees clockwise (90 counter clockwise); the width and height are swapped. */
+
+/* What the MJPEG decoder pool does when all its frames are in flight (see MjpegDecoderPool.h and `Settings.drop_policy`). */
+#define CA_DROP_NEWEST 0                                                           /* Drop the frame that was just captured; no decoding work is wasted. */
+#define CA_DROP_OLDEST 1                                                           /* Drop the oldest frame that isn't being decoded; keeps the latency low. */
+#define CA_DROP_NONE 2                                                             /* Block the capture thread until a frame is delivered; the driver drops frames instead. */
+
+/* The threads the H.264 decoder may use (see H264Decoder.h and `Settings.decode_thread_type`); can be combined. */
+#define CA_DECODE_THREAD_FRAME 0x01                                                /* Decode several frames at once; scales well but every thread adds a frame of latency. */
+#define CA_DECODE_THREAD_SLICE 0x02                                                /* Decode the slices of a frame at once; no extra latency, but only helps when the camera encodes several slices per frame. */
+
+/* Containers the `Recorder` can write (see Recorder.h). */
+#define CA_CONTAINER_AVI 1                                                         /* AVI with the OpenDML extensions, so files can grow beyond 1 GB; MJPEG only. */
+#define CA_CONTAINER_MKV 2                                                         /* Matroska; MJPEG or H.264. */
+#define CA_CONTAINER_MP4 3                                                         /* Fragmented MP4; H.264 only. */
+
 /* Capability Filter Attributes. */
 #define CA_WIDTH 0                                                                 /* Used by the `filterCapabilities()` feature; filter on width. */
 #define CA_HEIGHT 1                                                                /* Used by the `filterCapabilities()` feature; filter on height. */
@@ -86,6 +117,7 @@ namespace ca {
   public:
     PixelBuffer();
     int setup(int w, int h, int fmt);                                              /* Set the strides, widths, heights, nbyte values for the given pixel format (CA_UYVY422, CA_YUV420P etc..) and video frame size.. Returns 0 on success otherwise < 0. */
+    int setPixels(uint8_t* data);                                                  /* Points `pixels` and `plane[]` into `data` using the offsets that were set by `setup()`. `data` must hold at least `nbytes` bytes. Returns 0 on success otherwise < 0. */
 
   public:
     uint8_t* pixels;                                                                /* When data is one continuous block of member you can use this, otherwise it points to the same location as plane[0]. */
@@ -96,11 +128,22 @@ namespace ca {
     size_t offset[3];                                                               /* When the data is planar but packed, these contains the byte offsets from the first byte / plane. e.g. you can use this with YUV420P. */ 
     size_t nbytes;                                                                  /* The total number of bytes that make up the frame. This doesn't have to be one continuous array when the data is planar. */
     int pixel_format;                                                               /* The pixel format of the buffer; e.g. CA_YUYV422, CA_UYVY422, CA_JPEG_OPENDML, etc.. */
+    uint64_t sequence;                                                              /* The frame number as counted by the capture driver, when it provides one. Gaps mean that frames were dropped. */
+    uint64_t timestamp;                                                             /* When the frame was captured in nanoseconds on the clock of `time_now_ns()`; the driver time when available (V4L2), 0 when the driver doesn't set it. */
+    uint64_t decode_time;                                                           /* The time in nanoseconds it took to decode this frame (see MjpegDecoder.h); 0 when it wasn't decoded. */
+    uint64_t receive_time;                                                          /* When we got the frame from the driver (V4L2: when VIDIOC_DQBUF returned) on the clock of `time_now_ns()`; 0 when the driver doesn't set it. */
     void* user;                                                                     /* Can be set to any user data that can be used in the frame callback. */
   };
 
   /* -------------------------------------- */
 
+  struct DataChunk {                                                                /* A piece of memory that isn't owned; used to write a frame in parts (scatter-gather) without copying it first. */
+    const uint8_t* data;                                                            /* Points to the bytes. */
+    size_t nbytes;                                                                  /* The number of bytes. */
+  };
+
+  /* -------------------------------------- */
+
   class Capability {                                                                /* Capability represents a possibility for a capture device. It often is related to a width/height/fps. */
   public:
     Capability();
@@ -178,6 +221,13 @@ namespace ca {
     int capability;                                                                 /* Number of the capability you want to use. See listCapabilities(). */
     int device;                                                                     /* Number of the device you want to use. See listDevices(). */
     int format;                                                                     /* The output format, e.g. CA_YUV422. This can be used when the capture SDK supports automatic conversion (mac/win). Some cameras capture in JPEG/H264 and the SDK can convert this to e.g. CA_YUYV422. Set the format here */
+    int rotation;                                                                   /* Rotate the frames before they're passed to the frame callback, one of CA_ROTATE_*. Only drivers that deliver through a FramePipeline (V4L2) support this. */
+    int jpeg_scale;                                                                 /* When we decode CA_MJPEG captures (see MjpegDecoder.h) we can decode at 1/2, 1/4 or 1/8 of the size; set to 2, 4 or 8. Default is 1. */
+    int decode_threads;                                                             /* When > 0 we decode CA_MJPEG captures on this many threads, several frames at once (see MjpegDecoderPool.h), and CA_H264 captures with this many libavcodec threads (see H264Decoder.h). Default is 0, decode on the capture thread. */
+    int decode_thread_type;                                                         /* How the H.264 decoder uses its threads, a combination of CA_DECODE_THREAD_*. Default is both. */
+    int drop_policy;                                                                /* What to do when the decode threads fall behind, one of CA_DROP_*. Default is CA_DROP_NEWEST. */
+    int replay_speed;                                                               /* CA_REPLAY: the playback speed in percent; 100 is the speed of the recording, 200 twice as fast, 0 as fast as possible. Default is 100. */
+    int replay_loop;                                                                /* CA_REPLAY: when 1 we start over at the end of the file. Default is 0. */
   };
 
   /* -------------------------------------- */
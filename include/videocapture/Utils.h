@@ -10,6 +10,8 @@ namespace ca {
   
   int fps_from_rational(uint64_t num, uint64_t den);          /* Converts a rational value to one of the CA_FPS_* values defined in Types.h */
   std::string format_to_string(int fmt);
+  int format_vertical_subsampling(int fmt);                   /* Returns the vertical chroma subsampling factor of the given pixel format; 2 for e.g. CA_YUV420P, otherwise 1. */
+  uint64_t time_now_ns();                                     /* Returns a monotonic timestamp in nanoseconds; only useful to measure durations. */
   
 }; // namespace ca
 
@@ -0,0 +1,85 @@
+/*
+
+  VideoEncoder
+  ------------
+
+  Interface for the software encoders that the encoder sink (EncoderSink.h)
+  uses: x264 for CA_H264 (X264Encoder.h, compiled with USE_X264) and x265
+  for CA_H265 (X265Encoder.h, compiled with USE_X265).
+
+  The encoders take 8 bit 4:2:0 pictures (see `canEncode()`) and return
+  frames with 4 byte big endian NAL lengths, which is what the container
+  writers expect (see ContainerWriter.h); the decoder configuration (avcC
+  or hvcC) is in `codec_private` after `open()`. The frame points into the
+  memory of the encoder and is valid until the next call to `encode()`.
+
+  We configure the encoders without B-frames, because the writers store
+  frames in decode order; frames come out in the order they went in,
+  though a few frames later when the encoder uses frame threads or a
+  lookahead. The timestamp of a picture is passed through to its frame.
+  Call `encode()` with NULL until it returns 0 to get the delayed frames.
+
+  The encoders copy the picture into their own frame, so the caller can
+  reuse the buffer as soon as `encode()` returns.
+
+  Threads
+  -------
+
+  x264 and x265 create as many threads as there are cores by default,
+  which is fine for one camera but not for twelve. `EncoderSettings.threads`
+  limits the threads of one encoder; when it's 0 we divide the cores by
+  `EncoderSettings.num_cameras` (see `encoder_get_thread_budget()`).
+
+ */
+#ifndef VIDEO_CAPTURE_VIDEO_ENCODER_H
+#define VIDEO_CAPTURE_VIDEO_ENCODER_H
+
+#include <string>
+#include <vector>
+#include <videocapture/Types.h>
+
+#define CA_ENCODER_MAX_CHUNKS 64                                                    /* The maximum number of separate pieces of memory an encoded frame can consist of. */
+
+namespace ca {
+
+  struct EncoderSettings {
+    EncoderSettings();
+    int codec;                                                                      /* CA_H264 (x264) or CA_H265 (x265). Default is CA_H264. */
+    std::string preset;                                                             /* The x264/x265 speed preset: ultrafast, superfast, veryfast, faster, fast, medium, slow, slower or veryslow. Default is veryfast. */
+    std::string tune;                                                               /* The x264/x265 tuning, e.g. zerolatency; empty for none (the default). */
+    int bitrate;                                                                    /* The average bitrate in kbit/s, also used as maximum; 0 uses `crf`. Default is 0. */
+    int crf;                                                                        /* The constant rate factor when `bitrate` is 0; lower is better. Default is 23. */
+    int keyint;                                                                     /* The maximum number of frames between two key frames; 0 is two seconds. Default is 0. */
+    int threads;                                                                    /* The number of threads of this encoder; 0 uses `encoder_get_thread_budget(num_cameras)`. Default is 0. */
+    int num_cameras;                                                                /* The number of cameras that are encoded at the same time; used when `threads` is 0. Default is 1. */
+  };
+
+  struct EncodedFrame {                                                             /* A frame that `VideoEncoder::encode()` returns. */
+    DataChunk chunks[CA_ENCODER_MAX_CHUNKS];                                        /* The NAL units with their lengths; adjacent NAL units are one chunk. */
+    int num_chunks;                                                                 /* The number of chunks. */
+    uint64_t timestamp;                                                             /* The timestamp that was passed with the picture. */
+    bool keyframe;                                                                  /* Is true for IDR frames. */
+  };
+
+  class VideoEncoder {
+  public:
+    VideoEncoder();
+    virtual ~VideoEncoder();
+    virtual int open(int width, int height, int fps, int fmt, const EncoderSettings& cfg) = 0; /* Creates the encoder for pictures of the given size and format (see `canEncode()`) at `fps` (CA_FPS_*) and sets `codec_private`. Returns 0 on success, < 0 on error. */
+    virtual int close() = 0;                                                        /* Destroys the encoder; delayed frames that weren't flushed are lost. */
+    virtual int encode(const PixelBuffer* pic, uint64_t timestamp, EncodedFrame& out) = 0; /* Encodes `pic`, or flushes when it's NULL. Returns 1 when `out` holds a frame, 0 when there is none (yet), < 0 on error. */
+    virtual bool canEncode(int fmt) = 0;                                            /* Returns true when we take pictures of `fmt` as they are. */
+    virtual int getNumThreads() = 0;                                                /* The number of threads the encoder was configured with. */
+
+  public:
+    std::vector<uint8_t> codec_private;                                             /* The decoder configuration (avcC or hvcC) for the container. */
+  };
+
+  bool encoder_is_available(int codec);                                             /* Returns true when we're compiled with an encoder for `codec` (CA_H264 or CA_H265). */
+  int encoder_get_thread_budget(int numcameras);                                    /* The number of cores divided by `numcameras`, at least 1. */
+  int encoder_get_keyint(const EncoderSettings& cfg, int fps);                      /* The key frame interval for `cfg`: `cfg.keyint` or two seconds of frames at `fps` (CA_FPS_*). */
+  int encoder_add_chunk(EncodedFrame& out, const uint8_t* data, size_t nbytes);     /* Appends the memory to `out`, joining it with the last chunk when it follows it. Returns 0 on success, < 0 when there are too many chunks. */
+
+} /* namespace ca */
+
+#endif
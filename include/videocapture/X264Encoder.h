@@ -0,0 +1,49 @@
+/*
+
+  X264Encoder
+  -----------
+
+  Encodes CA_H264 with x264; see VideoEncoder.h for the interface. Only
+  available when the library is compiled with USE_X264 (see
+  build/CMakeLists.txt); without it `open()` fails.
+
+  Takes I420 (CA_YUV420P, CA_YUVJ420P) and NV12 (CA_YUV420BP,
+  CA_YUVJ420BP) pictures; the J formats are marked as full range in the
+  stream. x264 uses `EncoderSettings.threads` frame threads, or slice
+  threads with the zerolatency tune, plus a few lookahead threads that
+  mostly wait for the frame threads.
+
+ */
+#ifndef VIDEO_CAPTURE_X264_ENCODER_H
+#define VIDEO_CAPTURE_X264_ENCODER_H
+
+#include <videocapture/VideoEncoder.h>
+
+namespace ca {
+
+  struct X264EncoderState;                                                          /* The x264 state, see X264Encoder.cpp. */
+
+  class X264Encoder : public VideoEncoder {
+  public:
+    X264Encoder();
+    ~X264Encoder();
+    int open(int width, int height, int fps, int fmt, const EncoderSettings& cfg);
+    int close();
+    int encode(const PixelBuffer* pic, uint64_t timestamp, EncodedFrame& out);
+    bool canEncode(int fmt);
+    int getNumThreads();
+
+  private:
+    int createCodecPrivate();                                                       /* Creates the avcC from the SPS and PPS of the encoder. */
+
+  private:
+    X264EncoderState* state;                                                        /* The encoder; NULL when not open. */
+    int width;                                                                      /* The picture width. */
+    int height;                                                                     /* The picture height. */
+    int pixel_format;                                                               /* The format of the pictures we take. */
+    int num_threads;                                                                /* The number of threads we configured. */
+  };
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,49 @@
+/*
+
+  X265Encoder
+  -----------
+
+  Encodes CA_H265 (HEVC) with x265; see VideoEncoder.h for the interface.
+  Only available when the library is compiled with USE_X265 (see
+  build/CMakeLists.txt); without it `open()` fails.
+
+  Takes I420 pictures (CA_YUV420P, CA_YUVJ420P); x265 can't read NV12, so
+  the encoder sink converts those. All x265 threads, including the
+  lookahead, come from one thread pool of `EncoderSettings.threads`
+  threads. Key frames are IDR frames (closed GOPs) so every cluster or
+  fragment of the file can be decoded on its own.
+
+ */
+#ifndef VIDEO_CAPTURE_X265_ENCODER_H
+#define VIDEO_CAPTURE_X265_ENCODER_H
+
+#include <videocapture/VideoEncoder.h>
+
+namespace ca {
+
+  struct X265EncoderState;                                                          /* The x265 state, see X265Encoder.cpp. */
+
+  class X265Encoder : public VideoEncoder {
+  public:
+    X265Encoder();
+    ~X265Encoder();
+    int open(int width, int height, int fps, int fmt, const EncoderSettings& cfg);
+    int close();
+    int encode(const PixelBuffer* pic, uint64_t timestamp, EncodedFrame& out);
+    bool canEncode(int fmt);
+    int getNumThreads();
+
+  private:
+    int createCodecPrivate();                                                       /* Creates the hvcC from the VPS, SPS and PPS of the encoder. */
+
+  private:
+    X265EncoderState* state;                                                        /* The encoder; NULL when not open. */
+    int width;                                                                      /* The picture width. */
+    int height;                                                                     /* The picture height. */
+    int pixel_format;                                                               /* The format of the pictures we take. */
+    int num_threads;                                                                /* The number of threads in the pool of the encoder. */
+  };
+
+} /* namespace ca */
+
+#endif
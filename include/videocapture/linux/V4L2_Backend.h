@@ -0,0 +1,66 @@
+/*
+
+  V4L2_Backend
+  ------------
+
+  The system calls `V4L2_Capture` makes: opening and closing devices,
+  ioctl() and mapping the buffers, plus the device list. By default
+  these go to the kernel (`V4L2_SystemBackend`); a test or benchmark can
+  replace them with e.g. `V4L2_FakeDevice` (see V4L2_FakeDevice.h) to
+  run the capture code against a device it controls:
+
+     V4L2_FakeDevice fake;
+     fake.init(fake_settings);
+
+     Capture cap(on_frame, NULL, CA_V4L2);
+     ((V4L2_Capture*)cap.cap)->setBackend(&fake);
+
+  or, for every V4L2_Capture that's created after it:
+
+     v4l2_set_default_backend(&fake);
+
+  The functions behave like the system calls they're named after: they
+  return -1 (or MAP_FAILED) and set `errno` on error.
+
+ */
+#ifndef VIDEO_CAPTURE_V4L2_BACKEND_H
+#define VIDEO_CAPTURE_V4L2_BACKEND_H
+
+#include <sys/types.h>
+#include <vector>
+#include <videocapture/linux/V4L2_Types.h>
+
+namespace ca {
+
+  class V4L2_Backend {
+  public:
+    virtual ~V4L2_Backend();
+    virtual std::vector<V4L2_Device> getDevices() = 0;                              /* The capture devices. */
+    virtual int open(const char* path, int flags) = 0;                              /* Opens a device; returns the descriptor. */
+    virtual int close(int fd) = 0;
+    virtual int ioctl(int fd, unsigned long request, void* arg) = 0;                /* VIDIOC_*. */
+    virtual void* mmap(size_t length, int prot, int flags, int fd, off_t offset) = 0;
+    virtual int munmap(void* addr, size_t length) = 0;
+  };
+
+  /* -------------------------------------- */
+
+  class V4L2_SystemBackend : public V4L2_Backend {                                  /* The kernel; ioctl() calls that are interrupted are retried. */
+  public:
+    std::vector<V4L2_Device> getDevices();
+    int open(const char* path, int flags);
+    int close(int fd);
+    int ioctl(int fd, unsigned long request, void* arg);
+    void* mmap(size_t length, int prot, int flags, int fd, off_t offset);
+    int munmap(void* addr, size_t length);
+  };
+
+  /* -------------------------------------- */
+
+  V4L2_Backend* v4l2_get_system_backend();                                          /* Returns the shared `V4L2_SystemBackend`. */
+  V4L2_Backend* v4l2_get_default_backend();                                         /* Returns the backend new `V4L2_Capture` instances use. */
+  void v4l2_set_default_backend(V4L2_Backend* backend);                             /* Sets the backend for new `V4L2_Capture` instances; NULL means the system. Not thread safe; call it before you create them. */
+
+} /* namespace ca */
+
+#endif
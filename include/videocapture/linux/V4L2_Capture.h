@@ -4,6 +4,37 @@
   ------------
 
   Video4Linux2 Capture wrapper. 
+
+  V4L2 itself doesn't convert between pixel formats, so we do that
+  ourself: `getOutputFormats()` returns the formats that our conversion
+  kernels and MJPEG decoder can produce (see ConvertPlan.h and
+  MjpegDecoder.h). When you set `Settings.format`
+  and/or `Settings.rotation` we convert and rotate every frame on the
+  capture thread using a `FramePipeline` and pass the result to the frame
+  callback. MJPEG captures can be decoded on multiple threads, see
+  `Settings.decode_threads`; the frames are still delivered in order from
+  `update()`.
+
+  All system calls go through a `V4L2_Backend`, so the capture code can
+  be tested and benchmarked against a `V4L2_FakeDevice` instead of a
+  camera; see `setBackend()` and V4L2_Backend.h.
+
+  Some (UVC) cameras stop delivering frames while their descriptor
+  stays fine: DQBUF returns EAGAIN forever. A watchdog in `update()`
+  notices when we didn't get a frame for CA_V4L2_WATCHDOG_FRAMES frame
+  intervals (but at least CA_V4L2_WATCHDOG_MIN_NS) and tries to recover,
+  one step further every time the stream stays stalled:
+
+     1. Restart the stream: STREAMOFF and STREAMON.
+     2. Reallocate the buffers: STREAMOFF, REQBUFS, STREAMON.
+     3. Close the device and open it again with the same settings; when
+        that fails (e.g. it was unplugged), we try again every timeout.
+        Meanwhile `stop()` and `close()` succeed as usual.
+
+  A frame resets the steps. Every step is counted and timestamped in
+  the stats, see `StreamStats.num_recoveries` in CaptureStats.h, and
+  logged as a warning. Use `setWatchdogTimeout()` to change the timeout
+  or to turn the watchdog off, e.g. for an externally triggered camera.
   
  */
 #ifndef VIDEO_CAPTURE_V4L2_CAPTURE_H
@@ -29,9 +60,15 @@ extern "C" {
 #include <videocapture/Base.h>
 #include <videocapture/Types.h>
 #include <videocapture/Utils.h>
+#include <videocapture/FramePipeline.h>
 #include <videocapture/linux/V4L2_Types.h>
 #include <videocapture/linux/V4L2_Utils.h>
 #include <videocapture/linux/V4L2_Devices.h>
+#include <videocapture/linux/V4L2_Backend.h>
+
+#define CA_V4L2_WATCHDOG_AUTO 0xFFFFFFFFFFFFFFFFull                                  /* The default timeout of the watchdog: CA_V4L2_WATCHDOG_FRAMES frame intervals, at least CA_V4L2_WATCHDOG_MIN_NS. */
+#define CA_V4L2_WATCHDOG_FRAMES 10                                                  /* The number of frame intervals without a frame after which we think the stream stalled. */
+#define CA_V4L2_WATCHDOG_MIN_NS 2000000000ull                                       /* The minimum timeout of CA_V4L2_WATCHDOG_AUTO; cameras can take a while to deliver the first frame. */
 
 namespace ca {
 
@@ -53,7 +90,7 @@ namespace ca {
     /* Capabilities */
     std::vector<Capability> getCapabilities(int device);                               /* Get all the capabilities for the given device number  */
     std::vector<Device> getDevices();                                                  /* We query the udev USB devices. */
-    std::vector<Format> getOutputFormats();                                            /* Get the supported output formats. For V4L2 this is empty. */
+    std::vector<Format> getOutputFormats();                                            /* Get the formats we can convert or decode into; for each of them there is at least one capture format we can convert from. */
 
     /* IO Methods */
     int initializeMMAP(int fd);                                                        /* Initialize MMAP I/O for the given file descriptor */
@@ -67,13 +104,44 @@ namespace ca {
     int setCaptureFormat(int fd, int width, int height, int pixfmt);                   /* Set the pixel format for the given fd, widht, height and pixfmt. */
     int getDeviceV4L2(int dx, V4L2_Device& result);                                    /* Get the device for the given index */
     int getCapabilityV4L2(int fd, struct v4l2_capability* caps);                       /* Get a v4l2_capability object for the given fd. */
+    int setupPixelBuffer(int width, int height, int pixfmt);                           /* Sets up `pixel_buffer` for the negotiated format, using the stride the driver returned. */
+
+    /* Testing */
+    int setBackend(V4L2_Backend* b);                                                   /* Makes the system calls through `b`, e.g. a `V4L2_FakeDevice`; NULL means the kernel. Call it before `open()`. */
+    uint64_t getNumCorrupt();                                                          /* The number of buffers the driver returned with V4L2_BUF_FLAG_ERROR; we don't deliver those. */
+    int setNumBuffers(int n);                                                          /* The number of buffers we ask the driver for (REQBUFS); default is 4, the driver may give us more or less. Call it before `open()`. */
+
+    /* Watchdog */
+    int setWatchdogTimeout(uint64_t ns);                                               /* We recover a stream that didn't deliver a frame for `ns` nanoseconds; 0 turns the watchdog off. Default is CA_V4L2_WATCHDOG_AUTO. */
+
+  private:
+    void checkWatchdog();                                                              /* Recovers the stream when it stalled; called by `update()`. */
+    int restartStream();                                                               /* CA_RECOVER_RESTART: STREAMOFF and STREAMON. */
+    int reallocateBuffers();                                                           /* CA_RECOVER_REALLOCATE: STREAMOFF, new buffers and STREAMON. */
+    int reopen();                                                                      /* CA_RECOVER_REOPEN: closes the device, opens it with `open_settings` and starts it. */
 
   private:
     int state;                                                                         /* We keep track of the open/capture state so we know when to stop/close the device */
     int capture_device_fd;                                                             /* File descriptor for the capture device. */
     std::vector<V4L2_Buffer*> buffers;                                                 /* The buffer that are used to store the frames from the capture device . */                                      
     PixelBuffer pixel_buffer;                                                          /* The object we pass to the callback. */
+    size_t bytes_per_line;                                                             /* The stride of the first plane, as returned by VIDIOC_S_FMT. */
+    FramePipeline pipeline;                                                            /* Decodes, converts and rotates the frames, see `Settings.format`, `Settings.rotation` and `Settings.decode_threads`. */
+    V4L2_Backend* backend;                                                             /* Makes the system calls, see V4L2_Backend.h. */
+    uint64_t num_corrupt;                                                              /* See `getNumCorrupt()`. */
+    int num_buffers;                                                                   /* See `setNumBuffers()`. */
+    int num_queued;                                                                    /* The buffers the driver owns (queued with QBUF and not dequeued yet), see `Base::stats`. */
+    Settings open_settings;                                                            /* The settings of `open()`, for `reopen()`. */
+    uint64_t frame_interval;                                                           /* The frame interval of the opened capability in nanoseconds; 0 when unknown. */
+    uint64_t watchdog_timeout;                                                         /* See `setWatchdogTimeout()`. */
+    uint64_t last_frame_time;                                                          /* `time_now_ns()` when we last dequeued a buffer, started streaming or tried to recover. */
+    int recover_step;                                                                  /* The CA_RECOVER_* the watchdog tries next. */
+    int lost_state;                                                                    /* When `reopen()` failed: the state (CA_STATE_*) the application thinks we're in; 0 otherwise. */
   };
+
+  inline uint64_t V4L2_Capture::getNumCorrupt() {
+    return num_corrupt;
+  }
 }; // namespace ca
 
 #endif
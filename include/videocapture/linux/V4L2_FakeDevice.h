@@ -0,0 +1,194 @@
+/*
+
+  V4L2_FakeDevice
+  ---------------
+
+  An in-process V4L2 capture device, for testing and benchmarking
+  `V4L2_Capture` (the dequeue/requeue path, format negotiation, error
+  recovery) without a camera, deterministically. It's a `V4L2_Backend`
+  that has one device and implements the ioctls the capture code uses:
+  QUERYCAP, ENUM_FMT, ENUM_FRAMESIZES, ENUM_FRAMEINTERVALS, G_FMT,
+  TRY_FMT, S_FMT, REQBUFS, QUERYBUF, QBUF, DQBUF, STREAMON and STREAMOFF.
+
+     V4L2_FakeSettings cfg;
+     cfg.formats.push_back(V4L2_FakeFormat(V4L2_PIX_FMT_YUYV, 1280, 720, 1, 30));
+     cfg.padding = 64;                  // bytes at the end of every row
+     cfg.eio_period = 100;              // every 100th DQBUF fails with EIO
+     cfg.manual_clock = true;
+
+     V4L2_FakeDevice fake;
+     fake.init(cfg);
+
+     Capture cap(on_frame, NULL, CA_V4L2);
+     ((V4L2_Capture*)cap.cap)->setBackend(&fake);
+     ...
+     cap.start();
+
+     for (int i = 0; i < 300; ++i) {
+       fake.advanceClock(33333333);     // one frame
+       cap.update();
+     }
+
+  Timing: after STREAMON frame `n` is captured at `(n + 1) * interval`
+  plus a random delay of up to `jitter` nanoseconds, on the clock of
+  `time_now_ns()` or, with `manual_clock`, on a clock you advance. A
+  captured frame goes into the oldest queued buffer; when no buffer is
+  queued the frame is dropped, like a driver does, and the sequence has
+  a gap. DQBUF returns the oldest filled buffer or EAGAIN.
+
+  Faults are scripted by period so every run is the same: every
+  `eagain_period`th DQBUF starts a burst of `eagain_burst` calls that
+  return EAGAIN even when a frame is ready, every `eio_period`th DQBUF
+  fails with EIO, and every `error_period`th frame is returned with
+  V4L2_BUF_FLAG_ERROR. Jitter uses a fixed seed.
+
+  A stall, like a UVC camera that stops delivering while its descriptor
+  stays fine, starts after `stall_after` frames since STREAMON: DQBUF
+  returns EAGAIN until what `stall_until` says (CA_V4L2_FAKE_STALL_*)
+  happened, e.g. the buffers were requested again. Every STREAMON
+  starts counting again, so a stream stalls again after the next
+  `stall_after` frames.
+
+  Raw frames contain a synthetic pattern (see SyntheticPattern.h) with
+  the sequence number as frame counter, so a test can check what it got;
+  compressed formats (MJPEG, H264) return `compressed_frame` for every
+  frame. Set `fill_frames` to false to benchmark without the copies.
+
+  The fake isn't thread safe, just like a V4L2_Capture.
+
+ */
+#ifndef VIDEO_CAPTURE_V4L2_FAKE_DEVICE_H
+#define VIDEO_CAPTURE_V4L2_FAKE_DEVICE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <linux/videodev2.h>
+#include <videocapture/linux/V4L2_Backend.h>
+#include <videocapture/synthetic/SyntheticPattern.h>
+
+#define CA_V4L2_FAKE_FD 0x40000000                                                  /* The descriptors of the fake start here, far away from real ones. */
+
+#define CA_V4L2_FAKE_STALL_STREAMOFF 1                                              /* A stall ends with STREAMOFF. */
+#define CA_V4L2_FAKE_STALL_REQBUFS 2                                                /* A stall ends when the buffers are requested again (REQBUFS). */
+#define CA_V4L2_FAKE_STALL_CLOSE 3                                                  /* A stall ends when every descriptor was closed. */
+#define CA_V4L2_FAKE_STALL_NEVER 4                                                  /* A stall never ends. */
+
+namespace ca {
+
+  struct V4L2_FakeFormat {                                                          /* A mode of the fake device. */
+    V4L2_FakeFormat(uint32_t pixel_format, int width, int height, uint32_t numerator, uint32_t denominator);
+    uint32_t pixel_format;                                                          /* V4L2_PIX_FMT_*. */
+    int width;
+    int height;
+    uint32_t numerator;                                                             /* The frame interval in seconds, e.g. 1/30 or 1001/30000. */
+    uint32_t denominator;
+  };
+
+  struct V4L2_FakeSettings {                                                        /* What the fake device looks like and how it misbehaves. */
+    V4L2_FakeSettings();
+    std::string path;                                                               /* The device path; default is "/dev/video-fake0". */
+    std::string card;                                                               /* The name; default is "Fake camera". */
+    std::vector<V4L2_FakeFormat> formats;                                           /* The modes, in the order we enumerate them. */
+    std::vector<uint8_t> compressed_frame;                                          /* The frame we return for MJPEG and H264 modes. */
+    uint32_t max_buffers;                                                           /* REQBUFS gives at most this many buffers; default is 8. */
+    uint32_t padding;                                                               /* Extra bytes per row (bytesperline); default is 0. */
+    uint64_t jitter;                                                                /* Frames are captured up to this many nanoseconds late; default is 0. */
+    uint32_t eagain_period;                                                         /* Every nth DQBUF starts an EAGAIN burst; 0 (default) is never. */
+    uint32_t eagain_burst;                                                          /* The number of DQBUF calls in a burst; default is 3. */
+    uint32_t eio_period;                                                            /* Every nth DQBUF fails with EIO; 0 (default) is never. */
+    uint32_t error_period;                                                          /* Every nth frame has V4L2_BUF_FLAG_ERROR; 0 (default) is never. */
+    uint32_t stall_after;                                                           /* We stop capturing after this many frames since STREAMON; 0 (default) is never. */
+    int stall_until;                                                                /* What ends a stall, one of CA_V4L2_FAKE_STALL_*; default is CA_V4L2_FAKE_STALL_STREAMOFF. */
+    uint32_t seed;                                                                  /* The seed of the jitter. */
+    bool manual_clock;                                                              /* When true the time only moves with `advanceClock()`; default is false. */
+    bool fill_frames;                                                               /* When true (default) we write the frames; false leaves the buffers as they are. */
+  };
+
+  struct V4L2_FakeBuffer {                                                          /* A buffer of REQBUFS. */
+    std::vector<uint8_t> data;                                                      /* The memory we hand out with mmap(). */
+    struct v4l2_buffer info;                                                        /* What we return with QUERYBUF and DQBUF. */
+    bool is_queued;                                                                 /* Is true from QBUF until DQBUF. */
+  };
+
+  class V4L2_FakeDevice : public V4L2_Backend {
+  public:
+    V4L2_FakeDevice();
+    ~V4L2_FakeDevice();
+    int init(const V4L2_FakeSettings& cfg);                                         /* Validates and copies the settings. Returns 0 on success, < 0 on error. */
+    void advanceClock(uint64_t ns);                                                 /* Moves the manual clock. */
+    uint64_t getNumCaptured();                                                      /* The number of frames captured since STREAMON, including the dropped ones. */
+    uint64_t getNumDropped();                                                       /* The number of frames dropped because no buffer was queued. */
+    uint64_t getNumDequeued();                                                      /* The number of buffers DQBUF returned. */
+    bool isStalled();                                                               /* Is true while we don't capture because of `stall_after`. */
+    int getNumOpen();                                                               /* The number of descriptors that are open. */
+
+    /* V4L2_Backend */
+    std::vector<V4L2_Device> getDevices();
+    int open(const char* path, int flags);
+    int close(int fd);
+    int ioctl(int fd, unsigned long request, void* arg);
+    void* mmap(size_t length, int prot, int flags, int fd, off_t offset);
+    int munmap(void* addr, size_t length);
+
+  private:
+    int fail(int err);                                                              /* Sets errno and returns -1. */
+    uint64_t now();                                                                 /* The real or manual clock. */
+    int setFormat(struct v4l2_format* fmt, bool apply);                             /* TRY_FMT and S_FMT. */
+    int requestBuffers(int fd, struct v4l2_requestbuffers* req);
+    int dequeueBuffer(struct v4l2_buffer* buf);
+    void capture();                                                                 /* Captures the frames that are due into the queued buffers. */
+    void fillBuffer(V4L2_FakeBuffer& buffer, uint64_t sequence);                    /* Writes the frame with `sequence` into `buffer`. */
+    void streamOff();                                                               /* Stops streaming; all buffers are dequeued. */
+    void freeBuffers();
+
+  private:
+    V4L2_FakeSettings settings;
+    std::vector<int> fds;                                                           /* The open descriptors. */
+    std::vector<V4L2_FakeBuffer*> buffers;                                          /* The buffers of REQBUFS. */
+    std::deque<uint32_t> queued;                                                    /* The buffers that wait for a frame, oldest first. */
+    std::deque<uint32_t> done;                                                      /* The buffers with a frame, oldest first. */
+    SyntheticPattern pattern;                                                       /* The content of raw frames. */
+    int next_fd;                                                                    /* The descriptor `open()` returns next. */
+    int owner_fd;                                                                   /* The descriptor that requested the buffers. */
+    int current;                                                                    /* The index into `settings.formats` of G_FMT. */
+    uint32_t bytes_per_line;                                                        /* Of the current format. */
+    uint32_t size_image;                                                            /* Of the current format. */
+    bool is_streaming;
+    uint64_t clock;                                                                 /* The manual clock. */
+    uint64_t stream_start;                                                          /* The time of STREAMON. */
+    uint64_t interval;                                                              /* The frame interval of the current format in nanoseconds. */
+    uint64_t next_capture;                                                          /* When the next frame is captured. */
+    uint64_t num_captured;
+    uint64_t num_dropped;
+    uint64_t num_dequeued;
+    uint64_t num_dqbuf_calls;                                                       /* Counts DQBUF calls for the fault periods. */
+    uint32_t eagain_left;                                                           /* The number of calls left in the current EAGAIN burst. */
+    bool is_stalled;                                                                /* See `stall_after`. */
+    uint32_t random;                                                                /* xorshift32 state of the jitter. */
+  };
+
+  inline uint64_t V4L2_FakeDevice::getNumCaptured() {
+    return num_captured;
+  }
+
+  inline uint64_t V4L2_FakeDevice::getNumDropped() {
+    return num_dropped;
+  }
+
+  inline uint64_t V4L2_FakeDevice::getNumDequeued() {
+    return num_dequeued;
+  }
+
+  inline bool V4L2_FakeDevice::isStalled() {
+    return is_stalled;
+  }
+
+  inline int V4L2_FakeDevice::getNumOpen() {
+    return (int)fds.size();
+  }
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,121 @@
+/*
+
+  ReplaySource
+  ------------
+
+  Reads the frames of a recording for `Replay_Capture`, one after another.
+  `replay_source_create()` looks at the first bytes of the file and
+  returns the source that can read it:
+
+     - FrameFileSource      Frame files of `FrameFileWriter` and
+                            `LosslessRecorder` (see FrameFile.h). Any raw
+                            format; the frames keep their timestamps.
+     - Y4mSource            YUV4MPEG2 (.y4m) files as written by ffmpeg,
+                            with 4:2:0 (CA_YUV420P) or 4:2:2 (CA_YUV422P)
+                            frames. The frame rate comes from the header.
+     - MjpegFileSource      Concatenated JPEG frames (.mjpeg, ffmpeg's
+                            `-f mjpeg`), delivered as CA_MJPEG. These have
+                            no timing; we assume CA_FPS_30_00.
+
+  `readFrame()` sets up a `PixelBuffer` that stays valid until the next
+  call. Its `timestamp` is the time of the frame in the recording, in
+  nanoseconds; only the differences between frames are meaningful.
+
+ */
+#ifndef VIDEO_CAPTURE_REPLAY_SOURCE_H
+#define VIDEO_CAPTURE_REPLAY_SOURCE_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <videocapture/Types.h>
+#include <videocapture/FrameFileReader.h>
+
+namespace ca {
+
+  class ReplaySource {
+  public:
+    ReplaySource();
+    virtual ~ReplaySource();
+    virtual int open(const std::string& filepath) = 0;                              /* Opens the file and sets the format members. Returns 0 on success, < 0 on error. */
+    virtual int close() = 0;
+    virtual int rewind() = 0;                                                       /* Goes back to the first frame. */
+    virtual int readFrame(PixelBuffer& buffer) = 0;                                 /* Reads the next frame. Returns 0 on success, 1 at the end of the file, < 0 on error. */
+
+  public:
+    int width;                                                                      /* The frame width. */
+    int height;                                                                     /* The frame height. */
+    int pixel_format;                                                               /* The CA_* format of the frames. */
+    int fps;                                                                        /* The frame rate, CA_FPS_* or fps * 100 when it's not one of them. */
+  };
+
+  /* -------------------------------------- */
+
+  class FrameFileSource : public ReplaySource {
+  public:
+    FrameFileSource();
+    ~FrameFileSource();
+    int open(const std::string& filepath);
+    int close();
+    int rewind();
+    int readFrame(PixelBuffer& buffer);
+
+  private:
+    FrameFileReader reader;                                                         /* Maps the file; raw frames are handed out without copying. */
+    uint64_t next_index;                                                            /* The frame `readFrame()` returns next. */
+  };
+
+  /* -------------------------------------- */
+
+  class Y4mSource : public ReplaySource {
+  public:
+    Y4mSource();
+    ~Y4mSource();
+    int open(const std::string& filepath);
+    int close();
+    int rewind();
+    int readFrame(PixelBuffer& buffer);
+
+  private:
+    int parseHeader(const std::string& line);                                       /* Parses the stream header. */
+
+  private:
+    FILE* fp;                                                                       /* The file handle. */
+    uint64_t data_offset;                                                           /* The offset of the first FRAME header. */
+    uint64_t frame_duration;                                                        /* In nanoseconds. */
+    uint64_t next_index;                                                            /* The number of frames we've read. */
+    std::vector<uint8_t> frame;                                                     /* The frame we hand out. */
+  };
+
+  /* -------------------------------------- */
+
+  class MjpegFileSource : public ReplaySource {
+  public:
+    MjpegFileSource();
+    ~MjpegFileSource();
+    int open(const std::string& filepath);
+    int close();
+    int rewind();
+    int readFrame(PixelBuffer& buffer);
+
+  private:
+    int findFrame(size_t& nbytes);                                                  /* Reads until `buffer` starts with a complete JPEG of `nbytes`. Returns 0 on success, 1 at the end of the file. */
+    bool fill();                                                                    /* Moves the unread bytes to the front and reads more. Returns false at the end of the file. */
+
+  private:
+    FILE* fp;                                                                       /* The file handle. */
+    std::vector<uint8_t> data;                                                      /* Read buffer; grows to hold the largest frame. */
+    size_t data_start;                                                              /* The first unread byte in `data`. */
+    size_t data_end;                                                                /* The end of the bytes read into `data`. */
+    size_t frame_nbytes;                                                            /* The size of the frame we handed out; skipped by the next `readFrame()`. */
+    uint64_t frame_duration;                                                        /* In nanoseconds. */
+    uint64_t next_index;                                                            /* The number of frames we've read. */
+  };
+
+  /* -------------------------------------- */
+
+  ReplaySource* replay_source_create(const std::string& filepath);                  /* Opens `filepath` with the source that can read it. Returns NULL when none can. */
+
+} /* namespace ca */
+
+#endif
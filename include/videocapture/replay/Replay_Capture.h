@@ -0,0 +1,111 @@
+/*
+
+  Replay_Capture
+  --------------
+
+  A capture driver (CA_REPLAY) that plays back recordings instead of
+  capturing from a camera, so the whole pipeline can be benchmarked and
+  regression tested on machines without cameras, with the same frames
+  every run. Every file is a device with one capability: the size,
+  format and frame rate of the recording. Frame files (FrameFile.h),
+  YUV4MPEG2 and MJPEG files are supported, see ReplaySource.h.
+
+  The files come from the CA_REPLAY_FILES environment variable (paths
+  separated by ':', ';' on Windows), so an application can replay
+  without changes, and from `addFile()`:
+
+     Capture cap(on_frame, NULL, CA_REPLAY);
+     Replay_Capture* replay = (Replay_Capture*)cap.cap;
+     replay->addFile("cam0.caf");
+
+     Settings cfg;
+     cfg.device = 0;
+     cfg.capability = 0;
+     cfg.replay_speed = 0;          // as fast as possible
+     cap.open(cfg);
+     cap.start();
+
+     while (false == replay->isFinished()) {
+       cap.update();
+     }
+
+  As with V4L2, `update()` delivers the frames on the calling thread and
+  `Settings.format`, `rotation` and `decode_threads` go through a
+  `FramePipeline`. With `Settings.replay_speed` > 0 a frame is delivered
+  by the first `update()` at or after the time it was recorded, relative
+  to the first frame and scaled by the speed; frames that are late are
+  all delivered (nothing is dropped) so every run sees the same frames.
+  With `replay_speed` 0 every `update()` delivers the next frame.
+
+  The frames get the `timestamp` (time_now_ns() clock) at which they
+  were due, like a camera would give them, and a `sequence` that counts
+  the delivered frames, also across loops (`Settings.replay_loop`).
+
+ */
+#ifndef VIDEO_CAPTURE_REPLAY_CAPTURE_H
+#define VIDEO_CAPTURE_REPLAY_CAPTURE_H
+
+#include <string>
+#include <vector>
+#include <videocapture/Base.h>
+#include <videocapture/Types.h>
+#include <videocapture/FramePipeline.h>
+#include <videocapture/replay/ReplaySource.h>
+
+namespace ca {
+
+  class Replay_Capture : public Base {
+
+  public:
+    Replay_Capture(frame_callback fc, void* user);                                     /* Adds the files of CA_REPLAY_FILES. */
+    ~Replay_Capture();
+
+    /* Interface */
+    int open(Settings settings);                                                       /* Opens the file of `settings.device`; `settings.capability` must be 0. */
+    int close();
+    int start();                                                                       /* Starts (or continues) playing; the timing starts at the next frame. */
+    int stop();                                                                        /* Pauses. */
+    void update();                                                                     /* Delivers the frames that are due. */
+
+    /* Capabilities */
+    std::vector<Capability> getCapabilities(int device);                               /* The size, format and frame rate of the file. */
+    std::vector<Device> getDevices();                                                  /* One device per file. */
+    std::vector<Format> getOutputFormats();                                            /* The formats our pipeline can turn the recordings into. */
+
+    /* Replay */
+    int addFile(const std::string& filepath);                                          /* Adds a recording as a device. Returns its device index. */
+    bool isFinished();                                                                 /* Returns true when the last frame was delivered and we don't loop. */
+    uint64_t getNumDelivered();                                                        /* The number of frames passed to the pipeline since `open()`. */
+
+  private:
+    int state;                                                                         /* CA_STATE_*. */
+    std::vector<std::string> files;                                                    /* The recordings; the device index is the index in here. */
+    ReplaySource* source;                                                              /* Reads the opened file. */
+    PixelBuffer pixel_buffer;                                                          /* The frame we deliver next. */
+    FramePipeline pipeline;                                                            /* Decodes, converts and rotates the frames, see `Settings.format`. */
+    int speed;                                                                         /* `Settings.replay_speed`. */
+    bool loop;                                                                         /* `Settings.replay_loop`. */
+    bool has_frame;                                                                    /* Is true when `pixel_buffer` holds a frame that wasn't delivered yet. */
+    bool must_sync;                                                                    /* Is true when the clock starts at the next frame. */
+    bool is_finished;                                                                  /* See `isFinished()`. */
+    uint64_t frame_time;                                                               /* The recording time of `pixel_buffer` relative to the first frame, including previous loops. */
+    uint64_t first_timestamp;                                                          /* The recording timestamp of the first frame of the file. */
+    uint64_t last_timestamp;                                                           /* The recording timestamp of the last frame we read. */
+    uint64_t loop_offset;                                                              /* The duration of the previous loops. */
+    uint64_t sync_time;                                                                /* time_now_ns() when we started at `sync_frame_time`. */
+    uint64_t sync_frame_time;                                                          /* The `frame_time` of the first frame after `start()`. */
+    uint64_t num_read;                                                                 /* The number of frames we read in this loop. */
+    uint64_t num_delivered;                                                            /* See `getNumDelivered()`. */
+  };
+
+  inline bool Replay_Capture::isFinished() {
+    return is_finished;
+  }
+
+  inline uint64_t Replay_Capture::getNumDelivered() {
+    return num_delivered;
+  }
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,130 @@
+/*
+
+  SIMD Conversion Kernels
+  -----------------------
+
+  The SIMD variants of the conversion kernels from Convert.h. Each
+  instruction set lives in its own translation unit which is compiled with
+  the matching compiler flags (see the build files); never call these
+  directly unless `cpu_supports_level()` returns true for the level. Use
+  `convert_get_kernel()` which selects the best variant for the CPU.
+
+  All variants must produce exactly the same output as the scalar kernels;
+  `convert_selftest()` verifies this. The static inline helpers below are
+  the scalar reference for the pixels at the end of a row that don't fill a
+  complete vector. They are static so every translation unit gets its own
+  copy, compiled for its own instruction set.
+
+ */
+#ifndef VIDEO_CAPTURE_SIMD_CONVERT_H
+#define VIDEO_CAPTURE_SIMD_CONVERT_H
+
+#include <stdint.h>
+#include <videocapture/Types.h>
+
+namespace ca {
+
+  /* SSE2 */
+  void convert_yuyv422_to_yuv420p_sse2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_uyvy422_to_yuv420p_sse2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_yuyv422_to_yuv422p_sse2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_uyvy422_to_yuv422p_sse2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_yuv420p_to_yuv420bp_sse2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_yuv420bp_to_yuv420p_sse2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_yuv420p_to_bgra32_sse2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_yuv420p_to_rgba32_sse2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+
+  /* SSSE3 */
+  void convert_yuyv422_to_yuv420p_ssse3(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_uyvy422_to_yuv420p_ssse3(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_yuyv422_to_yuv422p_ssse3(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_uyvy422_to_yuv422p_ssse3(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+
+  /* AVX2 */
+  void convert_yuyv422_to_yuv420p_avx2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_uyvy422_to_yuv420p_avx2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_yuyv422_to_yuv422p_avx2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_uyvy422_to_yuv422p_avx2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_yuv420p_to_bgra32_avx2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_yuv420p_to_rgba32_avx2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+
+  /* AVX-512 (F + BW) */
+  void convert_yuyv422_to_yuv420p_avx512(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_uyvy422_to_yuv420p_avx512(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_yuyv422_to_yuv422p_avx512(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_uyvy422_to_yuv422p_avx512(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+
+  /* NEON */
+  void convert_yuyv422_to_yuv420p_neon(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_uyvy422_to_yuv420p_neon(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_yuyv422_to_yuv422p_neon(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_uyvy422_to_yuv422p_neon(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_yuv420p_to_yuv420bp_neon(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_yuv420bp_to_yuv420p_neon(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_yuv420p_to_bgra32_neon(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+  void convert_yuv420p_to_rgba32_neon(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1);
+
+  /* ------------------------------------------------------------------------- */
+
+  /* Scalar remainder of a packed 4:2:2 row pair > YUV420P; `yo` and `uo` are the offsets of Y0 and U in a macro pixel. `d1` is NULL when there is no second row, `du`/`dv` are NULL when there is no chroma row. */
+  static inline void simd_packed422_to_yuv420p_tail(const uint8_t* s0, const uint8_t* s1, uint8_t* d0, uint8_t* d1, uint8_t* du, uint8_t* dv, int from, int pairs, int yo, int uo) {
+    for (int x = from; x < pairs; ++x) {
+      d0[2 * x + 0] = s0[4 * x + yo];
+      d0[2 * x + 1] = s0[4 * x + yo + 2];
+      if (NULL != d1) {
+        d1[2 * x + 0] = s1[4 * x + yo];
+        d1[2 * x + 1] = s1[4 * x + yo + 2];
+      }
+      if (NULL != du) {
+        du[x] = (uint8_t)((s0[4 * x + uo] + s1[4 * x + uo] + 1) >> 1);
+        dv[x] = (uint8_t)((s0[4 * x + uo + 2] + s1[4 * x + uo + 2] + 1) >> 1);
+      }
+    }
+  }
+
+  /* Scalar remainder of a packed 4:2:2 row > YUV422P. */
+  static inline void simd_packed422_to_yuv422p_tail(const uint8_t* s, uint8_t* dy, uint8_t* du, uint8_t* dv, int from, int pairs, int yo, int uo) {
+    for (int x = from; x < pairs; ++x) {
+      dy[2 * x + 0] = s[4 * x + yo];
+      dy[2 * x + 1] = s[4 * x + yo + 2];
+      du[x] = s[4 * x + uo];
+      dv[x] = s[4 * x + uo + 2];
+    }
+  }
+
+  /* Scalar remainder of YUV420P > 32bpp RGB, `r`, `g`, `b`, `a` are the component offsets. */
+  static inline void simd_yuv420p_to_rgb32_tail(const uint8_t* sy, const uint8_t* su, const uint8_t* sv, uint8_t* d, int from, int w, int r, int g, int b, int a) {
+    for (int x = from; x < w; ++x) {
+      int c = 298 * (sy[x] - 16) + 128;
+      int e = sv[x / 2] - 128;
+      int f = su[x / 2] - 128;
+      int rv = (c + 409 * e) >> 8;
+      int gv = (c - 100 * f - 208 * e) >> 8;
+      int bv = (c + 516 * f) >> 8;
+      uint8_t* p = d + 4 * x;
+      p[r] = (uint8_t)((rv < 0) ? 0 : ((rv > 255) ? 255 : rv));
+      p[g] = (uint8_t)((gv < 0) ? 0 : ((gv > 255) ? 255 : gv));
+      p[b] = (uint8_t)((bv < 0) ? 0 : ((bv > 255) ? 255 : bv));
+      p[a] = 0xFF;
+    }
+  }
+
+  /* Scalar remainder of interleaving two chroma rows (YUV420P > YUV420BP). */
+  static inline void simd_interleave_tail(const uint8_t* su, const uint8_t* sv, uint8_t* d, int from, int n) {
+    for (int x = from; x < n; ++x) {
+      d[2 * x + 0] = su[x];
+      d[2 * x + 1] = sv[x];
+    }
+  }
+
+  /* Scalar remainder of deinterleaving a chroma row (YUV420BP > YUV420P). */
+  static inline void simd_deinterleave_tail(const uint8_t* s, uint8_t* du, uint8_t* dv, int from, int n) {
+    for (int x = from; x < n; ++x) {
+      du[x] = s[2 * x + 0];
+      dv[x] = s[2 * x + 1];
+    }
+  }
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,50 @@
+/*
+
+  SIMD Transpose Kernels
+  ----------------------
+
+  The block transposes that are used by the rotation kernels in Rotate.h.
+  A transpose copies a region of `w` x `h` elements from `src` into `dst`
+  so that row `y`, column `x` of the source ends up at row `x`, column `y`
+  of the destination. The strides may be negative, which is how the
+  rotation kernels mirror while they transpose.
+
+  The SIMD variants transpose 8x8 (8 and 16 bit elements) or 4x4 (32 bit
+  elements) blocks in registers and use `simd_transpose_tail()` for the
+  edges. Rotate.cpp selects the variant for the level that is returned
+  by `cpu_get_level()` (see Cpu.h).
+
+ */
+#ifndef VIDEO_CAPTURE_SIMD_ROTATE_H
+#define VIDEO_CAPTURE_SIMD_ROTATE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace ca {
+
+  /* SSE2 */
+  void rotate_transpose_u8_sse2(const uint8_t* src, ptrdiff_t sstride, uint8_t* dst, ptrdiff_t dstride, int w, int h);
+  void rotate_transpose_u16_sse2(const uint8_t* src, ptrdiff_t sstride, uint8_t* dst, ptrdiff_t dstride, int w, int h);
+  void rotate_transpose_u32_sse2(const uint8_t* src, ptrdiff_t sstride, uint8_t* dst, ptrdiff_t dstride, int w, int h);
+
+  /* NEON */
+  void rotate_transpose_u8_neon(const uint8_t* src, ptrdiff_t sstride, uint8_t* dst, ptrdiff_t dstride, int w, int h);
+  void rotate_transpose_u32_neon(const uint8_t* src, ptrdiff_t sstride, uint8_t* dst, ptrdiff_t dstride, int w, int h);
+
+  /* ------------------------------------------------------------------------- */
+
+  /* Scalar transpose of the elements in columns [x0, x1) and rows [y0, y1); `bpp` is the size of an element. */
+  static inline void simd_transpose_tail(const uint8_t* src, ptrdiff_t sstride, uint8_t* dst, ptrdiff_t dstride, int bpp, int x0, int x1, int y0, int y1) {
+    for (int y = y0; y < y1; ++y) {
+      const uint8_t* s = src + y * sstride;
+      for (int x = x0; x < x1; ++x) {
+        memcpy(dst + x * dstride + y * bpp, s + x * bpp, bpp);
+      }
+    }
+  }
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,79 @@
+/*
+
+  SyntheticPattern
+  ----------------
+
+  Generates the test patterns of `Synthetic_Capture` in any raw CA_*
+  format: color bars, a moving gradient and noise. Every frame carries
+  its frame counter in the pixels, so a consumer can check that frames
+  arrive complete and in order after conversions, encoders or fan-out:
+
+     uint32_t counter = 0;
+     if (0 == synthetic_read_counter(frame, counter)) {
+       if (counter != expected) { ... a frame was dropped ... }
+     }
+
+  The counter is a row of 32 blocks at the top-left of the frame, least
+  significant bit first; a block is white for a 1 and black for a 0. The
+  block size is `width / 32`, between 2 and 8 pixels. Conversions keep
+  the counter readable, scaling and rotation don't.
+
+  To make the source cheap enough for dozens of 4K cameras we render the
+  pattern once, into a template that is larger than a frame. A frame is
+  a window into the template: moving it gives the gradient its motion
+  and the noise its variation, so a frame costs no more than stamping
+  the counter (restoring the pixels under the previous one). The planes
+  of the frames point into the template with the template strides; you
+  must not write into them.
+
+ */
+#ifndef VIDEO_CAPTURE_SYNTHETIC_PATTERN_H
+#define VIDEO_CAPTURE_SYNTHETIC_PATTERN_H
+
+#include <stdint.h>
+#include <vector>
+#include <videocapture/Types.h>
+
+#define CA_PATTERN_BARS 0                                                           /* 75% color bars. */
+#define CA_PATTERN_GRADIENT 1                                                       /* A gradient that moves to the left. */
+#define CA_PATTERN_NOISE 2                                                          /* Random pixels; every frame is different. */
+#define CA_PATTERN_COUNT 3                                                          /* The number of patterns. */
+
+namespace ca {
+
+  class SyntheticPattern {
+  public:
+    SyntheticPattern();
+    ~SyntheticPattern();
+    int init(int pattern, int width, int height, int fmt);                          /* Renders the template. Returns 0 on success, < 0 on error. */
+    int shutdown();                                                                 /* Frees the template. */
+    int nextFrame(uint32_t counter, PixelBuffer& buffer);                           /* Sets up `buffer` with the frame for `counter`; valid until the next call. Returns 0 on success. */
+
+  private:
+    int render();                                                                   /* Fills the template with the pattern. */
+    void getOrigin(uint32_t counter, int& x, int& y);                               /* The top-left pixel of the frame in the template. */
+    void saveCounter();                                                             /* Copies the pixels under the counter of `frame` into `saved`. */
+    void restoreCounter();                                                          /* Copies `saved` back. */
+    void writeCounter(uint32_t counter);                                            /* Stamps the counter into `frame`. */
+
+  private:
+    int pattern;                                                                    /* CA_PATTERN_*. */
+    int width;                                                                      /* The frame width. */
+    int height;                                                                     /* The frame height. */
+    int pixel_format;                                                               /* The CA_* format. */
+    int margin_x;                                                                   /* The template is this many pixels wider than a frame. */
+    int margin_y;                                                                   /* The template is this many pixels higher than a frame. */
+    int block_size;                                                                 /* The size of a counter bit in pixels. */
+    PixelBuffer templ;                                                              /* The rendered pattern. */
+    PixelBuffer frame;                                                              /* The last frame we handed out; a window into `templ`. */
+    std::vector<uint8_t> data;                                                      /* The pixels of `templ`. */
+    std::vector<uint8_t> saved;                                                     /* The pixels under the counter of `frame`. */
+    bool has_saved;                                                                 /* Is true when `saved` must be restored. */
+  };
+
+  bool synthetic_is_supported(int fmt);                                             /* Returns true when we can generate frames in `fmt`. */
+  int synthetic_read_counter(const PixelBuffer& buffer, uint32_t& counter);         /* Reads the frame counter from a frame. Returns 0 on success, < 0 when the format isn't supported. */
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,106 @@
+/*
+
+  Synthetic_Capture
+  -----------------
+
+  A capture driver (CA_SYNTHETIC) that generates test patterns, to load
+  and scale test the consumer side (converters, encoders, recorders,
+  fan-out) on machines without cameras. The devices are the patterns of
+  SyntheticPattern.h (color bars, a moving gradient, noise); every frame
+  has its frame counter in the pixels, see `synthetic_read_counter()`.
+
+  Every device has the same capabilities: the common sizes up to 4K at
+  30 and 60 fps in every raw format. `addCapability()` adds any other
+  size, format or rate. Every instance is an independent camera, so a
+  stress test creates as many as it needs:
+
+     std::vector<Capture*> cams;
+
+     for (int i = 0; i < 32; ++i) {
+       Capture* cap = new Capture(on_frame, NULL, CA_SYNTHETIC);
+       Settings cfg;
+       cfg.device = CA_PATTERN_NOISE;
+       cfg.capability = cap->findCapability(cfg.device, 3840, 2160, CA_YUV420BP);
+       cap->open(cfg);
+       cap->start();
+       cams.push_back(cap);
+     }
+
+     while (running) {
+       for (size_t i = 0; i < cams.size(); ++i) {
+         cams[i]->update();
+       }
+     }
+
+  The frames point into a pattern that is rendered once (see
+  SyntheticPattern.h), so generating a frame costs nearly nothing and
+  the consumer is what you measure. Don't write into the frames.
+
+  Like V4L2, `update()` delivers the frames that are due on the calling
+  thread, through a `FramePipeline` for `Settings.format` and `rotation`.
+  A camera doesn't wait for a slow consumer: when more than
+  CA_SYNTHETIC_MAX_QUEUED frames are due we skip the oldest ones, which
+  shows as gaps in the `sequence` and the counter; see `getNumDropped()`.
+
+ */
+#ifndef VIDEO_CAPTURE_SYNTHETIC_CAPTURE_H
+#define VIDEO_CAPTURE_SYNTHETIC_CAPTURE_H
+
+#include <vector>
+#include <videocapture/Base.h>
+#include <videocapture/Types.h>
+#include <videocapture/FramePipeline.h>
+#include <videocapture/synthetic/SyntheticPattern.h>
+
+#define CA_SYNTHETIC_MAX_QUEUED 4                                                   /* The number of frames a camera holds for a consumer that is late; the number of V4L2 buffers we request. */
+
+namespace ca {
+
+  class Synthetic_Capture : public Base {
+
+  public:
+    Synthetic_Capture(frame_callback fc, void* user);
+    ~Synthetic_Capture();
+
+    /* Interface */
+    int open(Settings settings);                                                       /* `settings.device` is the CA_PATTERN_*. */
+    int close();
+    int start();
+    int stop();
+    void update();                                                                     /* Delivers the frames that are due. */
+
+    /* Capabilities */
+    std::vector<Capability> getCapabilities(int device);
+    std::vector<Device> getDevices();                                                  /* One device per pattern. */
+    std::vector<Format> getOutputFormats();
+
+    /* Synthetic */
+    int addCapability(int width, int height, int fmt, int fps);                        /* Adds a capability to all devices. `fps` is a CA_FPS_* value or fps * 100. Returns its index or < 0 on error. */
+    uint64_t getNumDelivered();                                                        /* The number of frames passed to the pipeline since `open()`. */
+    uint64_t getNumDropped();                                                          /* The number of frames we skipped because the consumer was late. */
+
+  private:
+    int state;                                                                         /* CA_STATE_*. */
+    std::vector<Capability> capabilities;                                              /* The capabilities of every device. */
+    SyntheticPattern pattern;                                                          /* Generates the frames. */
+    PixelBuffer pixel_buffer;                                                          /* The frame we deliver. */
+    FramePipeline pipeline;                                                            /* Converts and rotates the frames, see `Settings.format`. */
+    bool must_sync;                                                                    /* Is true when the clock starts at the next `update()`. */
+    uint64_t frame_duration;                                                           /* In nanoseconds. */
+    uint64_t next_time;                                                                /* When the next frame is due, on the clock of time_now_ns(). */
+    uint64_t num_frames;                                                               /* The frame counter; includes the dropped frames. */
+    uint64_t num_delivered;                                                            /* See `getNumDelivered()`. */
+    uint64_t num_dropped;                                                              /* See `getNumDropped()`. */
+  };
+
+  inline uint64_t Synthetic_Capture::getNumDelivered() {
+    return num_delivered;
+  }
+
+  inline uint64_t Synthetic_Capture::getNumDropped() {
+    return num_dropped;
+  }
+
+} /* namespace ca */
+
+#endif
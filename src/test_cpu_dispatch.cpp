@@ -0,0 +1,57 @@
+/*
+
+  CPU Dispatch
+  ------------
+
+  Prints the CPU level that was detected and the one that is used to select
+  the conversion kernels. Then verifies that every SIMD kernel the CPU
+  supports produces exactly the same output as the scalar kernel and that
+  the rotate kernels match a per pixel rotate. Run this
+  when you build for a new platform or compiler:
+
+     ./test_cpu_dispatch
+     CA_CPU_LEVEL=ssse3 ./test_cpu_dispatch
+
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <videocapture/Cpu.h>
+#include <videocapture/Utils.h>
+#include <videocapture/Convert.h>
+#include <videocapture/Rotate.h>
+
+using namespace ca;
+
+int main() {
+
+  printf("\nCPU Dispatch Test.\n\n");
+
+  printf("Detected level: %s\n", cpu_level_to_string(cpu_detect_level()).c_str());
+  printf("Used level: %s\n\n", cpu_level_to_string(cpu_get_level()).c_str());
+
+  std::vector<ConvertKernel> kernels = convert_get_kernels();
+
+  for (size_t i = 0; i < kernels.size(); ++i) {
+
+    if (CA_CPU_SCALAR == kernels[i].cpu_level) {
+      continue;
+    }
+
+    printf("%-8s %-16s > %-16s %s\n",
+           cpu_level_to_string(kernels[i].cpu_level).c_str(),
+           format_to_string(kernels[i].src_format).c_str(),
+           format_to_string(kernels[i].dst_format).c_str(),
+           (cpu_supports_level(kernels[i].cpu_level)) ? "" : "(not supported)");
+  }
+
+  int failed = convert_selftest() + rotate_selftest();
+  if (0 != failed) {
+    printf("\nError: %d kernel(s) are not bit exact.\n\n", failed);
+    exit(EXIT_FAILURE);
+  }
+
+  printf("\nAll supported kernels are bit exact.\n\n");
+
+  return 0;
+}
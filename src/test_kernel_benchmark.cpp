@@ -0,0 +1,759 @@
+/*
+
+  Kernel Benchmark
+  ----------------
+
+  Times every pixel kernel of the library on synthetic frames: the
+  conversion kernels (every CPU variant, see Convert.h and Cpu.h), the
+  rotate kernels at every CPU level we can force (Rotate.h), the scale
+  kernels (Scale.h), the copy kernels and, when compiled with USE_JPEG,
+  the MJPEG decoder (MjpegDecoder.h). Every kernel runs on one thread
+  over a whole frame, for at least `--min-time` seconds; we report the
+  median:
+
+     ns/px    nanoseconds per destination pixel.
+     GB/s     source plus destination bytes per second.
+     cyc/px   TSC cycles per destination pixel (x86 only). The TSC runs
+              at a fixed rate, so with turbo this isn't the core clock.
+
+  The output of every SIMD variant is compared with the scalar kernel
+  (and a copy with its source); "ok" means bit exact, "n/a" that there
+  is no other variant to compare with. We exit with an error when a
+  kernel differs. Use it to compare builds, compilers and hosts:
+
+     ./test_kernel_benchmark
+     ./test_kernel_benchmark --sizes 1920x1080 --levels scalar,avx2 --groups convert,rotate
+     ./test_kernel_benchmark --json kernels.json
+
+  Run `./test_kernel_benchmark --help` for all options.
+
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <videocapture/Types.h>
+#include <videocapture/Utils.h>
+#include <videocapture/Cpu.h>
+#include <videocapture/Convert.h>
+#include <videocapture/Rotate.h>
+#include <videocapture/Scale.h>
+#include <videocapture/MjpegDecoder.h>
+
+#if defined(USE_JPEG)
+#  include <jpeglib.h>
+#endif
+
+#if defined(CA_ARCH_X86) && defined(_MSC_VER)
+#  include <intrin.h>
+#elif defined(CA_ARCH_X86)
+#  include <x86intrin.h>
+#endif
+
+using namespace ca;
+
+#define KB_VERIFY_NONE -1                                                           /* There is no reference to compare with. */
+#define KB_VERIFY_MISMATCH 0
+#define KB_VERIFY_OK 1
+
+struct BenchOptions {
+  BenchOptions();
+  std::vector<int> widths;
+  std::vector<int> heights;
+  std::vector<int> levels;                                                          /* The CA_CPU_* levels we run; only the supported ones. */
+  std::vector<std::string> groups;                                                  /* convert, rotate, scale, copy, decode. */
+  std::string json_path;                                                            /* Where we write the results; empty is none. */
+  double min_time;                                                                  /* Seconds we run every kernel. */
+};
+
+struct BenchFrame {                                                                 /* A PixelBuffer with its memory. */
+  int setup(int w, int h, int fmt);
+  std::vector<uint8_t> mem;
+  PixelBuffer buf;
+};
+
+struct BenchResult {
+  BenchResult();
+  std::string group;
+  std::string name;
+  int level;                                                                        /* The CA_CPU_* level or CA_NONE when the kernel doesn't dispatch. */
+  int width;                                                                        /* The source size. */
+  int height;
+  double ns_per_pixel;
+  double gb_per_sec;
+  double cycles_per_pixel;                                                          /* < 0 when we can't read the cycle counter. */
+  int verified;                                                                     /* KB_VERIFY_*. */
+};
+
+static void bench_convert(BenchOptions& opt, int w, int h, std::vector<BenchResult>& results);
+static void bench_rotate(BenchOptions& opt, int w, int h, std::vector<BenchResult>& results);
+static void bench_scale(BenchOptions& opt, int w, int h, std::vector<BenchResult>& results);
+static void bench_copy(BenchOptions& opt, int w, int h, std::vector<BenchResult>& results);
+static void bench_decode(BenchOptions& opt, int w, int h, std::vector<BenchResult>& results);
+static void measure(BenchOptions& opt, pixel_kernel kernel, BenchFrame& src, BenchFrame& dst, BenchResult& result);
+static void finish(BenchOptions& opt, BenchResult& result, double ns, double cycles, size_t nbytes, int npixels);
+static bool has_group(BenchOptions& opt, const char* group);
+static void fill_random(BenchFrame& frame, uint32_t seed);
+static bool compare(BenchFrame& a, BenchFrame& b);
+static uint64_t read_cycles();
+static int parse_args(int argc, char** argv, BenchOptions& opt);
+static int parse_sizes(const char* str, std::vector<int>& widths, std::vector<int>& heights);
+static int parse_list(const char* str, std::vector<std::string>& result);
+static void write_json(FILE* fp, BenchOptions& opt, std::vector<BenchResult>& results);
+static void print_usage();
+
+/* -------------------------------------- */
+
+int main(int argc, char** argv) {
+
+  BenchOptions opt;
+  std::vector<BenchResult> results;
+  int failed = 0;
+
+  if (0 != parse_args(argc, argv, opt)) {
+    print_usage();
+    exit(EXIT_FAILURE);
+  }
+
+  printf("\nKernel Benchmark, detected CPU level: %s.\n\n", cpu_level_to_string(cpu_detect_level()).c_str());
+
+  for (size_t i = 0; i < opt.widths.size(); ++i) {
+
+    size_t first = results.size();
+    int w = opt.widths[i];
+    int h = opt.heights[i];
+
+    if (has_group(opt, "convert")) { bench_convert(opt, w, h, results); }
+    if (has_group(opt, "rotate"))  { bench_rotate(opt, w, h, results);  }
+    if (has_group(opt, "scale"))   { bench_scale(opt, w, h, results);   }
+    if (has_group(opt, "copy"))    { bench_copy(opt, w, h, results);    }
+    if (has_group(opt, "decode"))  { bench_decode(opt, w, h, results);  }
+
+    for (size_t j = first; j < results.size(); ++j) {
+
+      BenchResult& r = results[j];
+
+      printf("%-7s %-34s %-7s %4dx%-4d %8.3f ns/px %8.2f GB/s ",
+             r.group.c_str(), r.name.c_str(),
+             (CA_NONE == r.level) ? "-" : cpu_level_to_string(r.level).c_str(),
+             r.width, r.height, r.ns_per_pixel, r.gb_per_sec);
+
+      if (0 <= r.cycles_per_pixel) {
+        printf("%7.2f cyc/px ", r.cycles_per_pixel);
+      }
+
+      printf("%s\n", (KB_VERIFY_OK == r.verified) ? "ok" : (KB_VERIFY_NONE == r.verified) ? "n/a" : "MISMATCH");
+
+      if (KB_VERIFY_MISMATCH == r.verified) {
+        failed++;
+      }
+    }
+
+    printf("\n");
+  }
+
+  cpu_set_level(CA_NONE);
+
+  if (false == opt.json_path.empty()) {
+
+    FILE* fp = fopen(opt.json_path.c_str(), "w");
+
+    if (NULL == fp) {
+      printf("Error: cannot open %s for writing.\n", opt.json_path.c_str());
+      exit(EXIT_FAILURE);
+    }
+
+    write_json(fp, opt, results);
+    fclose(fp);
+    printf("Wrote %s\n\n", opt.json_path.c_str());
+  }
+
+  if (0 != failed) {
+    printf("Error: %d kernel(s) differ from the scalar reference.\n\n", failed);
+    exit(EXIT_FAILURE);
+  }
+
+  return 0;
+}
+
+/* -------------------------------------- */
+
+/* Every variant of every conversion kernel; each SIMD variant is compared with the scalar one. */
+static void bench_convert(BenchOptions& opt, int w, int h, std::vector<BenchResult>& results) {
+
+  std::vector<ConvertKernel> kernels = convert_get_kernels();
+
+  for (size_t i = 0; i < kernels.size(); ++i) {
+
+    ConvertKernel& k = kernels[i];
+
+    if (false == cpu_supports_level(k.cpu_level)
+        || opt.levels.end() == std::find(opt.levels.begin(), opt.levels.end(), k.cpu_level))
+      {
+        continue;
+      }
+
+    pixel_kernel reference = convert_get_kernel(k.src_format, k.dst_format, CA_CPU_SCALAR);
+    BenchFrame src, dst, ref;
+    BenchResult result;
+
+    if (0 != src.setup(w, h, k.src_format) || 0 != dst.setup(w, h, k.dst_format)) {
+      continue;
+    }
+
+    fill_random(src, (uint32_t)(w * 31 + i));
+
+    result.group = "convert";
+    result.name = format_to_string(k.src_format) + " > " + format_to_string(k.dst_format);
+    result.level = k.cpu_level;
+    result.width = w;
+    result.height = h;
+
+    measure(opt, k.kernel, src, dst, result);
+
+    if (CA_CPU_SCALAR != k.cpu_level && NULL != reference && 0 == ref.setup(w, h, k.dst_format)) {
+      reference(src.buf, ref.buf, 0, h);
+      result.verified = compare(ref, dst) ? KB_VERIFY_OK : KB_VERIFY_MISMATCH;
+    }
+
+    results.push_back(result);
+  }
+}
+
+/* The rotate kernels pick their transpose with `cpu_get_level()`, so we force every level; the scalar level is the reference. */
+static void bench_rotate(BenchOptions& opt, int w, int h, std::vector<BenchResult>& results) {
+
+  static const int formats[] = {
+    CA_YUV420P, CA_YUV420BP, CA_YUV422P, CA_YUYV422, CA_UYVY422,
+    CA_ARGB32, CA_BGRA32, CA_RGBA32, CA_RGB24
+  };
+  static const int degrees[] = { CA_ROTATE_90, CA_ROTATE_180, CA_ROTATE_270 };
+
+  for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f) {
+    for (size_t d = 0; d < sizeof(degrees) / sizeof(degrees[0]); ++d) {
+
+      int fmt = formats[f];
+      int rw = 0;
+      int rh = 0;
+      char name[128];
+      BenchFrame src, ref;
+
+      if (false == rotate_is_supported(fmt, degrees[d])
+          || 0 != rotate_get_size(w, h, degrees[d], rw, rh)
+          || 0 != src.setup(w, h, fmt)
+          || 0 != ref.setup(rw, rh, fmt))
+        {
+          continue;
+        }
+
+      fill_random(src, (uint32_t)(w * 17 + f * 3 + d));
+      snprintf(name, sizeof(name), "%s %d", format_to_string(fmt).c_str(), degrees[d]);
+
+      /* The reference. */
+      cpu_set_level(CA_CPU_SCALAR);
+      rotate_get_kernel(fmt, degrees[d])(src.buf, ref.buf, 0, rh);
+
+      for (size_t l = 0; l < opt.levels.size(); ++l) {
+
+        BenchFrame dst;
+        BenchResult result;
+
+        if (0 != cpu_set_level(opt.levels[l]) || 0 != dst.setup(rw, rh, fmt)) {
+          continue;
+        }
+
+        result.group = "rotate";
+        result.name = name;
+        result.level = opt.levels[l];
+        result.width = w;
+        result.height = h;
+
+        measure(opt, rotate_get_kernel(fmt, degrees[d]), src, dst, result);
+
+        if (CA_CPU_SCALAR != opt.levels[l]) {
+          result.verified = compare(ref, dst) ? KB_VERIFY_OK : KB_VERIFY_MISMATCH;
+        }
+
+        results.push_back(result);
+      }
+
+      cpu_set_level(CA_NONE);
+    }
+  }
+}
+
+/* Bilinear downscale to half the size; there is only a scalar variant. */
+static void bench_scale(BenchOptions& opt, int w, int h, std::vector<BenchResult>& results) {
+
+  static const int formats[] = { CA_YUV420P, CA_YUV422P, CA_YUV420BP, CA_BGRA32, CA_RGB24 };
+
+  for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f) {
+
+    int fmt = formats[f];
+    char name[128];
+    BenchFrame src, dst;
+    BenchResult result;
+
+    if (0 != src.setup(w, h, fmt) || 0 != dst.setup(w / 2, h / 2, fmt)) {
+      continue;
+    }
+
+    fill_random(src, (uint32_t)(w * 13 + f));
+    snprintf(name, sizeof(name), "%s > %dx%d", format_to_string(fmt).c_str(), w / 2, h / 2);
+
+    result.group = "scale";
+    result.name = name;
+    result.level = CA_NONE;
+    result.width = w;
+    result.height = h;
+
+    measure(opt, scale_get_kernel(fmt), src, dst, result);
+    results.push_back(result);
+  }
+}
+
+/* The copy kernels (CA_ROTATE_NONE); the result must equal the source. */
+static void bench_copy(BenchOptions& opt, int w, int h, std::vector<BenchResult>& results) {
+
+  static const int formats[] = { CA_YUV420P, CA_YUV420BP, CA_YUYV422, CA_BGRA32, CA_RGB24 };
+
+  for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f) {
+
+    int fmt = formats[f];
+    pixel_kernel kernel = rotate_get_kernel(fmt, CA_ROTATE_NONE);
+    BenchFrame src, dst;
+    BenchResult result;
+
+    if (NULL == kernel || 0 != src.setup(w, h, fmt) || 0 != dst.setup(w, h, fmt)) {
+      continue;
+    }
+
+    fill_random(src, (uint32_t)(w * 7 + f));
+
+    result.group = "copy";
+    result.name = format_to_string(fmt);
+    result.level = CA_NONE;
+    result.width = w;
+    result.height = h;
+
+    measure(opt, kernel, src, dst, result);
+    result.verified = compare(src, dst) ? KB_VERIFY_OK : KB_VERIFY_MISMATCH;
+    results.push_back(result);
+  }
+}
+
+/* -------------------------------------- */
+
+#if defined(USE_JPEG)
+
+/* Compresses a gradient with some noise (4:2:0, quality 90), like a webcam frame. */
+static int make_jpeg(int w, int h, std::vector<uint8_t>& result) {
+
+  struct jpeg_compress_struct cinfo;
+  struct jpeg_error_mgr jerr;
+  std::vector<uint8_t> rgb((size_t)w * h * 3);
+  unsigned char* out = NULL;
+  unsigned long nout = 0;
+  uint32_t rnd = 0x12345678;
+
+  for (int y = 0; y < h; ++y) {
+    for (int x = 0; x < w; ++x) {
+      uint8_t* p = &rgb[((size_t)y * w + x) * 3];
+      rnd ^= rnd << 13; rnd ^= rnd >> 17; rnd ^= rnd << 5;
+      p[0] = (uint8_t)((x * 255) / w + (rnd & 0x7));
+      p[1] = (uint8_t)((y * 255) / h + ((rnd >> 3) & 0x7));
+      p[2] = (uint8_t)(((x + y) * 127) / (w + h) + ((rnd >> 6) & 0x7));
+    }
+  }
+
+  cinfo.err = jpeg_std_error(&jerr);
+  jpeg_create_compress(&cinfo);
+  jpeg_mem_dest(&cinfo, &out, &nout);
+
+  cinfo.image_width = w;
+  cinfo.image_height = h;
+  cinfo.input_components = 3;
+  cinfo.in_color_space = JCS_RGB;
+  jpeg_set_defaults(&cinfo);
+  jpeg_set_quality(&cinfo, 90, TRUE);
+  jpeg_start_compress(&cinfo, TRUE);
+
+  while (cinfo.next_scanline < cinfo.image_height) {
+    JSAMPROW row = &rgb[(size_t)cinfo.next_scanline * w * 3];
+    jpeg_write_scanlines(&cinfo, &row, 1);
+  }
+
+  jpeg_finish_compress(&cinfo);
+  jpeg_destroy_compress(&cinfo);
+
+  result.assign(out, out + nout);
+  free(out);
+
+  return 0;
+}
+
+#endif
+
+/* Decodes a JPEG into every format the decoder supports; libjpeg does its own dispatch. */
+static void bench_decode(BenchOptions& opt, int w, int h, std::vector<BenchResult>& results) {
+
+#if defined(USE_JPEG)
+
+  std::vector<int> formats = mjpeg_decoder_get_formats();
+  std::vector<uint8_t> jpeg;
+
+  if (0 != make_jpeg(w, h, jpeg)) {
+    return;
+  }
+
+  for (size_t f = 0; f < formats.size(); ++f) {
+
+    MjpegDecoder dec;
+    BenchFrame dst;
+    BenchResult result;
+    std::vector<double> times;
+    std::vector<double> cycles;
+    double elapsed = 0.0;
+
+    if (0 != dec.init(formats[f]) || 0 != dst.setup(w, h, formats[f])) {
+      continue;
+    }
+
+    /* Warm up; allocates the decoder buffers. */
+    if (0 != dec.decode(&jpeg[0], jpeg.size(), dst.buf)) {
+      continue;
+    }
+
+    while (elapsed < opt.min_time || 3 > times.size()) {
+      uint64_t c0 = read_cycles();
+      uint64_t t0 = time_now_ns();
+      dec.decode(&jpeg[0], jpeg.size(), dst.buf);
+      uint64_t t1 = time_now_ns();
+      uint64_t c1 = read_cycles();
+      times.push_back((double)(t1 - t0));
+      cycles.push_back((double)(c1 - c0));
+      elapsed += (double)(t1 - t0) / 1e9;
+    }
+
+    std::sort(times.begin(), times.end());
+    std::sort(cycles.begin(), cycles.end());
+
+    result.group = "decode";
+    result.name = std::string("CA_MJPEG > ") + format_to_string(formats[f]);
+    result.level = CA_NONE;
+    result.width = w;
+    result.height = h;
+
+    finish(opt, result, times[times.size() / 2], cycles[cycles.size() / 2], jpeg.size() + dst.buf.nbytes, w * h);
+    results.push_back(result);
+  }
+
+#else
+
+  /* Compiled without USE_JPEG; there's no decoder. */
+  (void)opt;
+  (void)w;
+  (void)h;
+  (void)results;
+
+#endif
+}
+
+/* -------------------------------------- */
+
+/* Runs the kernel over the whole frame until `min_time` passed (at least 3 times) and keeps the median. */
+static void measure(BenchOptions& opt, pixel_kernel kernel, BenchFrame& src, BenchFrame& dst, BenchResult& result) {
+
+  std::vector<double> times;
+  std::vector<double> cycles;
+  double elapsed = 0.0;
+  int rows = dst.buf.height[0];
+
+  /* Warm up the caches and page in the destination. */
+  kernel(src.buf, dst.buf, 0, rows);
+
+  while (elapsed < opt.min_time || 3 > times.size()) {
+    uint64_t c0 = read_cycles();
+    uint64_t t0 = time_now_ns();
+    kernel(src.buf, dst.buf, 0, rows);
+    uint64_t t1 = time_now_ns();
+    uint64_t c1 = read_cycles();
+    times.push_back((double)(t1 - t0));
+    cycles.push_back((double)(c1 - c0));
+    elapsed += (double)(t1 - t0) / 1e9;
+  }
+
+  std::sort(times.begin(), times.end());
+  std::sort(cycles.begin(), cycles.end());
+
+  finish(opt, result, times[times.size() / 2], cycles[cycles.size() / 2],
+         src.buf.nbytes + dst.buf.nbytes, dst.buf.width[0] * dst.buf.height[0]);
+}
+
+static void finish(BenchOptions& opt, BenchResult& result, double ns, double cycles, size_t nbytes, int npixels) {
+
+  (void)opt;
+
+  result.ns_per_pixel = ns / (double)npixels;
+  result.gb_per_sec = (ns > 0.0) ? (double)nbytes / ns : 0.0;
+  result.cycles_per_pixel = (0 == read_cycles()) ? -1.0 : cycles / (double)npixels;
+}
+
+static uint64_t read_cycles() {
+#if defined(CA_ARCH_X86)
+  return (uint64_t)__rdtsc();
+#else
+  return 0;
+#endif
+}
+
+static bool has_group(BenchOptions& opt, const char* group) {
+  return opt.groups.end() != std::find(opt.groups.begin(), opt.groups.end(), std::string(group));
+}
+
+/* xorshift32; rand() is too slow for 4K frames. */
+static void fill_random(BenchFrame& frame, uint32_t seed) {
+
+  uint32_t x = seed | 1;
+
+  for (size_t i = 0; i < frame.mem.size(); ++i) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    frame.mem[i] = (uint8_t)(x >> 24);
+  }
+}
+
+static bool compare(BenchFrame& a, BenchFrame& b) {
+  return a.mem.size() == b.mem.size() && 0 == memcmp(&a.mem[0], &b.mem[0], a.mem.size());
+}
+
+int BenchFrame::setup(int w, int h, int fmt) {
+
+  if (0 != buf.setup(w, h, fmt)) {
+    return -1;
+  }
+
+  mem.assign(buf.nbytes, 0);
+
+  return buf.setPixels(&mem[0]);
+}
+
+/* -------------------------------------- */
+
+static void write_json(FILE* fp, BenchOptions& opt, std::vector<BenchResult>& results) {
+
+  char date[64] = { 0 };
+  time_t now = time(NULL);
+  struct tm* tm = gmtime(&now);
+
+  if (NULL != tm) {
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", tm);
+  }
+
+  fprintf(fp, "{\n");
+  fprintf(fp, "  \"benchmark\": \"kernels\",\n");
+  fprintf(fp, "  \"date\": \"%s\",\n", date);
+  fprintf(fp, "  \"cpu_level\": \"%s\",\n", cpu_level_to_string(cpu_detect_level()).c_str());
+  fprintf(fp, "  \"min_time\": %.3f,\n", opt.min_time);
+  fprintf(fp, "  \"results\": [");
+
+  for (size_t i = 0; i < results.size(); ++i) {
+
+    BenchResult& r = results[i];
+
+    fprintf(fp, "%s\n    { \"group\": \"%s\", \"name\": \"%s\", \"level\": \"%s\", \"width\": %d, \"height\": %d, "
+            "\"ns_per_pixel\": %.4f, \"gb_per_sec\": %.3f, ",
+            (0 == i) ? "" : ",", r.group.c_str(), r.name.c_str(),
+            (CA_NONE == r.level) ? "none" : cpu_level_to_string(r.level).c_str(),
+            r.width, r.height, r.ns_per_pixel, r.gb_per_sec);
+
+    if (0 <= r.cycles_per_pixel) {
+      fprintf(fp, "\"cycles_per_pixel\": %.3f, ", r.cycles_per_pixel);
+    }
+    else {
+      fprintf(fp, "\"cycles_per_pixel\": null, ");
+    }
+
+    fprintf(fp, "\"verified\": \"%s\" }",
+            (KB_VERIFY_OK == r.verified) ? "ok" : (KB_VERIFY_NONE == r.verified) ? "n/a" : "mismatch");
+  }
+
+  fprintf(fp, "\n  ]\n}\n");
+}
+
+/* -------------------------------------- */
+
+static int parse_args(int argc, char** argv, BenchOptions& opt) {
+
+  std::vector<std::string> levels;
+
+  for (int i = 1; i < argc; ++i) {
+
+    const char* arg = argv[i];
+    const char* val = (i + 1 < argc) ? argv[i + 1] : NULL;
+    int r = 0;
+
+    if (0 == strcmp(arg, "--help") || 0 == strcmp(arg, "-h")) {
+      return -1;
+    }
+
+    if (NULL == val) {
+      printf("Error: %s needs a value.\n", arg);
+      return -2;
+    }
+
+    if (0 == strcmp(arg, "--sizes")) {
+      r = parse_sizes(val, opt.widths, opt.heights);
+    }
+    else if (0 == strcmp(arg, "--levels")) {
+      r = parse_list(val, levels);
+    }
+    else if (0 == strcmp(arg, "--groups")) {
+      r = parse_list(val, opt.groups);
+    }
+    else if (0 == strcmp(arg, "--min-time")) {
+      opt.min_time = atof(val);
+    }
+    else if (0 == strcmp(arg, "--json")) {
+      opt.json_path = val;
+    }
+    else {
+      printf("Error: unknown option: %s.\n", arg);
+      return -3;
+    }
+
+    if (0 != r) {
+      printf("Error: invalid value for %s: %s.\n", arg, val);
+      return -4;
+    }
+
+    ++i;
+  }
+
+  if (0 >= opt.min_time) {
+    printf("Error: invalid minimum time.\n");
+    return -5;
+  }
+
+  if (opt.widths.empty()) {
+    parse_sizes("640x480,1280x720,1920x1080,3840x2160", opt.widths, opt.heights);
+  }
+
+  if (opt.groups.empty()) {
+    parse_list("convert,rotate,scale,copy,decode", opt.groups);
+  }
+
+  /* All levels the CPU supports, unless given. */
+  for (size_t i = 0; i < levels.size(); ++i) {
+
+    int level = cpu_level_from_string(levels[i]);
+
+    if (CA_NONE == level) {
+      printf("Error: unknown CPU level: %s.\n", levels[i].c_str());
+      return -6;
+    }
+
+    if (false == cpu_supports_level(level)) {
+      printf("Warning: the CPU doesn't support %s; skipping it.\n", levels[i].c_str());
+      continue;
+    }
+
+    opt.levels.push_back(level);
+  }
+
+  if (levels.empty()) {
+    for (int level = CA_CPU_SCALAR; level <= CA_CPU_NEON; ++level) {
+      if (cpu_supports_level(level)) {
+        opt.levels.push_back(level);
+      }
+    }
+  }
+
+  return 0;
+}
+
+static int parse_sizes(const char* str, std::vector<int>& widths, std::vector<int>& heights) {
+
+  const char* p = str;
+  int w = 0;
+  int h = 0;
+  int n = 0;
+
+  while ('\0' != *p) {
+
+    /* The kernels need even sizes (4:2:0). */
+    if (2 != sscanf(p, "%dx%d%n", &w, &h, &n) || 2 > w || 2 > h || 0 != (w & 1) || 0 != (h & 1)) {
+      return -1;
+    }
+
+    widths.push_back(w);
+    heights.push_back(h);
+    p += n;
+
+    if (',' == *p) {
+      ++p;
+    }
+  }
+
+  return 0;
+}
+
+static int parse_list(const char* str, std::vector<std::string>& result) {
+
+  std::string item;
+
+  for (const char* p = str; ; ++p) {
+
+    if ('\0' == *p || ',' == *p) {
+
+      if (item.empty()) {
+        return -1;
+      }
+
+      result.push_back(item);
+      item.clear();
+
+      if ('\0' == *p) {
+        break;
+      }
+
+      continue;
+    }
+
+    item.push_back(*p);
+  }
+
+  return 0;
+}
+
+static void print_usage() {
+  printf("\nUsage: test_kernel_benchmark [options]\n\n"
+         "  --sizes WxH,...             the frame sizes (640x480,1280x720,1920x1080,3840x2160)\n"
+         "  --levels l1,l2,...          the CPU levels, e.g. scalar,sse2,ssse3,avx2,avx512,neon (all supported)\n"
+         "  --groups g1,g2,...          the kernels: convert,rotate,scale,copy,decode (all)\n"
+         "  --min-time S                seconds we run every kernel (0.1)\n"
+         "  --json FILE                 also write the results as JSON\n\n");
+}
+
+/* -------------------------------------- */
+
+BenchOptions::BenchOptions()
+  :min_time(0.1)
+{
+}
+
+BenchResult::BenchResult()
+  :level(CA_NONE)
+  ,width(0)
+  ,height(0)
+  ,ns_per_pixel(0.0)
+  ,gb_per_sec(0.0)
+  ,cycles_per_pixel(-1.0)
+  ,verified(KB_VERIFY_NONE)
+{
+}
@@ -0,0 +1,828 @@
+/*
+
+  V4L2 Benchmark
+  --------------
+
+  Measures the V4L2 capture path end to end and writes the results as
+  JSON, so we can compare library versions before we roll them out. For
+  every combination of pixel format, size, output format and buffer
+  count we capture from several devices at once through `V4L2_Capture`
+  and report:
+
+     fps               frames per second we delivered, summed over the devices.
+     dropped           frames missing from the sequence numbers plus corrupt buffers.
+     cpu_us_per_frame  user + system time of this process per delivered frame.
+     latency_ns        dequeue to callback: the time between VIDIOC_DQBUF
+                       returning and our frame callback, as percentiles;
+                       this is the time the library adds.
+     capture_latency_ns
+                       capture to callback: the time between the driver's
+                       timestamp and our frame callback, as percentiles;
+                       this includes the time a frame waited in the driver.
+
+  By default we use the devices of the `vivid` driver (the kernel's
+  virtual video driver, see build/benchmark_v4l2.sh which loads it) and
+  fall back to in-process `V4L2_FakeDevice`s when there are none, e.g.
+  on a build machine. The fake measures our own overhead only: it
+  doesn't write raw frames, and returns the JPEG of `--fake-jpeg` (of
+  the size you benchmark) for MJPEG.
+
+     ./test_v4l2_benchmark
+     ./test_v4l2_benchmark --devices 4 --formats yuyv422,yuv420bp --sizes 640x480,1920x1080 \
+                           --buffers 2,4,8 --outputs none,yuv420p --duration 10 --json results.json
+
+  With `--trace FILE` we record the trace points of the library (when
+  it's built with USE_TRACE, see Trace.h) and save them as a Chrome
+  trace that shows where every capture thread spent its time.
+
+  Run `./test_v4l2_benchmark --help` for all options. We only have
+  mmap() streaming I/O so that is the only I/O mode we report. A
+  combination a device doesn't support is listed with "skipped": true.
+
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/utsname.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <videocapture/Types.h>
+#include <videocapture/Utils.h>
+#include <videocapture/Trace.h>
+#include <videocapture/linux/V4L2_Capture.h>
+#include <videocapture/linux/V4L2_Utils.h>
+#include <videocapture/linux/V4L2_FakeDevice.h>
+
+using namespace ca;
+
+struct BenchOptions {
+  BenchOptions();
+  std::string backend;                                                              /* "auto", "vivid" or "fake". */
+  std::string json_path;                                                            /* Where we write the results; "-" is stdout. */
+  std::string trace_path;                                                           /* When set, we save a trace of the library to this file. */
+  std::vector<int> formats;                                                         /* The capture formats. */
+  std::vector<int> outputs;                                                         /* The output formats; CA_NONE is the raw capture format. */
+  std::vector<int> widths;
+  std::vector<int> heights;
+  std::vector<int> buffers;                                                         /* The buffer counts. */
+  int num_devices;                                                                  /* The number of devices we capture from at the same time. */
+  int fake_fps;                                                                     /* The frame rate of the fake devices, in 1/100 fps. */
+  std::vector<uint8_t> fake_jpeg;                                                   /* The frame of fake MJPEG devices; without it we skip MJPEG on the fakes. */
+  int poll_us;                                                                      /* How long we sleep between two update() rounds. */
+  double duration;                                                                  /* Seconds we measure per combination. */
+  double warmup;                                                                    /* Seconds we capture before we measure. */
+};
+
+struct BenchDevice {                                                                /* One device we capture from during a run. */
+  BenchDevice();
+  V4L2_Capture* cap;
+  V4L2_FakeDevice* fake;                                                            /* When we benchmark the fakes. */
+  std::vector<uint64_t> latencies;                                                  /* Dequeue to callback, in ns. */
+  std::vector<uint64_t> capture_latencies;                                          /* Capture to callback, in ns. */
+  uint64_t num_frames;                                                              /* Delivered frames. */
+  uint64_t num_gaps;                                                                /* Frames missing from the sequence numbers. */
+  uint64_t start_corrupt;                                                           /* getNumCorrupt() when we started to measure. */
+  uint64_t last_sequence;
+  bool has_sequence;
+  bool is_measuring;                                                                /* False during the warm up. */
+};
+
+struct BenchResult {
+  BenchResult();
+  int format;
+  int output;
+  int width;
+  int height;
+  int buffers;
+  int fps;                                                                          /* The nominal frame rate of the capability, in 1/100 fps. */
+  bool skipped;
+  double seconds;
+  uint64_t frames;
+  uint64_t dropped;
+  uint64_t corrupt;
+  double cpu_us_per_frame;
+  double cpu_percent;
+  std::vector<uint64_t> latencies;
+  std::vector<uint64_t> capture_latencies;
+};
+
+static void on_frame(PixelBuffer& buffer);
+static int parse_args(int argc, char** argv, BenchOptions& opt);
+static int parse_formats(const char* str, std::vector<int>& result, bool allow_none);
+static int parse_ints(const char* str, std::vector<int>& result);
+static int parse_sizes(const char* str, std::vector<int>& widths, std::vector<int>& heights);
+static int read_file(const char* path, std::vector<uint8_t>& result);
+static int find_vivid_devices(std::vector<int>& result);
+static int run(BenchOptions& opt, std::vector<int>& devices, bool use_fake, int fmt, int output, int width, int height, int nbuffers, BenchResult& result);
+static int open_device(BenchOptions& opt, std::vector<int>& devices, bool use_fake, int i, int fmt, int output, int width, int height, int nbuffers, BenchDevice* dev, int& fps);
+static uint64_t cpu_time_us();
+static uint64_t percentile(std::vector<uint64_t>& sorted, double p);
+static void write_json(FILE* fp, BenchOptions& opt, bool use_fake, std::vector<BenchResult>& results);
+static void write_percentiles(FILE* fp, const char* name, std::vector<uint64_t>& values, bool last);
+static void print_usage();
+
+/* -------------------------------------- */
+
+int main(int argc, char** argv) {
+
+  BenchOptions opt;
+  std::vector<int> devices;
+  std::vector<BenchResult> results;
+  bool use_fake = false;
+
+  if (0 != parse_args(argc, argv, opt)) {
+    print_usage();
+    exit(EXIT_FAILURE);
+  }
+
+  if ("fake" != opt.backend) {
+    find_vivid_devices(devices);
+  }
+
+  if (devices.empty()) {
+
+    if ("vivid" == opt.backend) {
+      printf("Error: no vivid devices found; load the module with e.g. `sudo modprobe vivid n_devs=4`.\n");
+      exit(EXIT_FAILURE);
+    }
+
+    use_fake = true;
+  }
+  else if ((int)devices.size() < opt.num_devices) {
+    fprintf(stderr, "Warning: we want %d devices but found %d vivid devices.\n", opt.num_devices, (int)devices.size());
+    opt.num_devices = (int)devices.size();
+  }
+  else {
+    devices.resize(opt.num_devices);
+  }
+
+  fprintf(stderr, "Benchmarking %d %s device(s), %.1f seconds per run.\n",
+          opt.num_devices, (use_fake) ? "fake" : "vivid", opt.duration);
+
+  if (false == opt.trace_path.empty() && 0 != trace_start()) {
+    exit(EXIT_FAILURE);
+  }
+
+  for (size_t f = 0; f < opt.formats.size(); ++f) {
+    for (size_t s = 0; s < opt.widths.size(); ++s) {
+      for (size_t o = 0; o < opt.outputs.size(); ++o) {
+        for (size_t b = 0; b < opt.buffers.size(); ++b) {
+
+          BenchResult result;
+
+          if (0 != run(opt, devices, use_fake, opt.formats[f], opt.outputs[o], opt.widths[s], opt.heights[s], opt.buffers[b], result)) {
+            exit(EXIT_FAILURE);
+          }
+
+          if (false == result.skipped) {
+            std::sort(result.latencies.begin(), result.latencies.end());
+            fprintf(stderr, "%-14s %4dx%-4d > %-14s %d buffers: %8.2f fps, %6llu dropped, %7.1f us cpu/frame, p99 latency %.2f ms\n",
+                    format_to_string(result.format).c_str(), result.width, result.height,
+                    (CA_NONE == result.output) ? "raw" : format_to_string(result.output).c_str(),
+                    result.buffers, (double)result.frames / result.seconds,
+                    (unsigned long long)result.dropped, result.cpu_us_per_frame,
+                    (double)percentile(result.latencies, 0.99) / 1e6);
+          }
+
+          results.push_back(result);
+        }
+      }
+    }
+  }
+
+  if (false == opt.trace_path.empty()) {
+    trace_stop();
+    if (0 != trace_save(opt.trace_path)) {
+      exit(EXIT_FAILURE);
+    }
+    fprintf(stderr, "Wrote %s\n", opt.trace_path.c_str());
+  }
+
+  FILE* fp = stdout;
+
+  if ("-" != opt.json_path) {
+    fp = fopen(opt.json_path.c_str(), "w");
+    if (NULL == fp) {
+      printf("Error: cannot open %s for writing.\n", opt.json_path.c_str());
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  write_json(fp, opt, use_fake, results);
+
+  if (stdout != fp) {
+    fclose(fp);
+    fprintf(stderr, "Wrote %s\n", opt.json_path.c_str());
+  }
+
+  return 0;
+}
+
+/* -------------------------------------- */
+
+static void on_frame(PixelBuffer& buffer) {
+
+  uint64_t now = time_now_ns();
+  BenchDevice* dev = (BenchDevice*)buffer.user;
+
+  if (false == dev->is_measuring) {
+    dev->last_sequence = buffer.sequence;
+    dev->has_sequence = true;
+    return;
+  }
+
+  if (dev->has_sequence && buffer.sequence > dev->last_sequence + 1) {
+    dev->num_gaps += buffer.sequence - dev->last_sequence - 1;
+  }
+
+  dev->last_sequence = buffer.sequence;
+  dev->has_sequence = true;
+  dev->num_frames++;
+  dev->latencies.push_back((now > buffer.receive_time) ? now - buffer.receive_time : 0);
+  dev->capture_latencies.push_back((now > buffer.timestamp) ? now - buffer.timestamp : 0);
+}
+
+/* Captures with the given settings from all devices at the same time. */
+static int run(BenchOptions& opt, std::vector<int>& devices, bool use_fake,
+               int fmt, int output, int width, int height, int nbuffers,
+               BenchResult& result)
+{
+  std::vector<BenchDevice*> devs;
+  uint64_t start_time = 0;
+  uint64_t end_time = 0;
+  uint64_t start_cpu = 0;
+  uint64_t end_cpu = 0;
+  int r = 0;
+
+  result.format = fmt;
+  result.output = output;
+  result.width = width;
+  result.height = height;
+  result.buffers = nbuffers;
+  result.skipped = true;
+
+  if (use_fake && CA_NONE == capture_format_to_v4l2_pixel_format(fmt)) {
+    return 0;
+  }
+
+  if (use_fake && CA_MJPEG == fmt && opt.fake_jpeg.empty()) {
+    return 0;
+  }
+
+  if (use_fake && CA_H264 == fmt) {
+    return 0;
+  }
+
+  for (int i = 0; i < opt.num_devices; ++i) {
+
+    BenchDevice* dev = new BenchDevice();
+    devs.push_back(dev);
+
+    r = open_device(opt, devices, use_fake, i, fmt, output, width, height, nbuffers, dev, result.fps);
+
+    if (0 != r) {
+      /* Not supported (1) is not an error. */
+      r = (0 > r) ? r : 0;
+      goto done;
+    }
+  }
+
+  result.skipped = false;
+
+  /* Warm up, then measure. */
+  end_time = time_now_ns() + (uint64_t)(opt.warmup * 1e9);
+
+  while (time_now_ns() < end_time) {
+    for (size_t i = 0; i < devs.size(); ++i) {
+      devs[i]->cap->update();
+    }
+    usleep(opt.poll_us);
+  }
+
+  for (size_t i = 0; i < devs.size(); ++i) {
+    devs[i]->is_measuring = true;
+    devs[i]->latencies.reserve((size_t)(opt.duration * 2 * 240));
+    devs[i]->capture_latencies.reserve((size_t)(opt.duration * 2 * 240));
+    devs[i]->start_corrupt = devs[i]->cap->getNumCorrupt();
+  }
+
+  start_cpu = cpu_time_us();
+  start_time = time_now_ns();
+  end_time = start_time + (uint64_t)(opt.duration * 1e9);
+
+  while (time_now_ns() < end_time) {
+    for (size_t i = 0; i < devs.size(); ++i) {
+      devs[i]->cap->update();
+    }
+    usleep(opt.poll_us);
+  }
+
+  end_cpu = cpu_time_us();
+  result.seconds = (double)(time_now_ns() - start_time) / 1e9;
+
+  for (size_t i = 0; i < devs.size(); ++i) {
+    result.frames += devs[i]->num_frames;
+    result.dropped += devs[i]->num_gaps;
+    result.corrupt += devs[i]->cap->getNumCorrupt() - devs[i]->start_corrupt;
+    result.latencies.insert(result.latencies.end(), devs[i]->latencies.begin(), devs[i]->latencies.end());
+    result.capture_latencies.insert(result.capture_latencies.end(), devs[i]->capture_latencies.begin(), devs[i]->capture_latencies.end());
+  }
+
+  result.dropped += result.corrupt;
+  result.cpu_percent = (100.0 * (double)(end_cpu - start_cpu)) / (result.seconds * 1e6);
+
+  if (0 != result.frames) {
+    result.cpu_us_per_frame = (double)(end_cpu - start_cpu) / (double)result.frames;
+  }
+
+ done:
+
+  for (size_t i = 0; i < devs.size(); ++i) {
+    delete devs[i]->cap;
+    delete devs[i]->fake;
+    delete devs[i];
+  }
+
+  return r;
+}
+
+/* Opens and starts the `i`th device. Returns 0 on success, 1 when the device doesn't support the settings and < 0 on error. */
+static int open_device(BenchOptions& opt, std::vector<int>& devices, bool use_fake, int i,
+                       int fmt, int output, int width, int height, int nbuffers,
+                       BenchDevice* dev, int& fps)
+{
+  int device = (use_fake) ? 0 : devices[i];
+  int capability = -1;
+
+  dev->cap = new V4L2_Capture(on_frame, dev);
+
+  if (use_fake) {
+
+    char path[64];
+    V4L2_FakeSettings cfg;
+
+    snprintf(path, sizeof(path), "/dev/video-fake%d", i);
+    cfg.path = path;
+    cfg.fill_frames = (CA_MJPEG == fmt);                                            /* Raw frames aren't written, the JPEG is. */
+    cfg.compressed_frame = opt.fake_jpeg;
+    cfg.formats.push_back(V4L2_FakeFormat(capture_format_to_v4l2_pixel_format(fmt), width, height, 100, opt.fake_fps));
+
+    dev->fake = new V4L2_FakeDevice();
+
+    if (0 != dev->fake->init(cfg)) {
+      return -1;
+    }
+
+    dev->cap->setBackend(dev->fake);
+  }
+
+  /* Of the capabilities with this size and format we take the one with the highest frame rate. */
+  std::vector<Capability> caps = dev->cap->getCapabilities(device);
+
+  for (size_t k = 0; k < caps.size(); ++k) {
+    if (caps[k].width == width && caps[k].height == height && caps[k].pixel_format == fmt
+        && (-1 == capability || caps[k].fps > caps[capability].fps))
+      {
+        capability = (int)k;
+      }
+  }
+
+  if (-1 == capability) {
+    return 1;
+  }
+
+  Settings settings;
+  settings.device = device;
+  settings.capability = capability;
+  settings.format = output;
+  fps = caps[capability].fps;
+
+  /* E.g. we can't convert into the output format. */
+  if (0 > dev->cap->setNumBuffers(nbuffers) || 0 > dev->cap->open(settings)) {
+    return 1;
+  }
+
+  if (0 > dev->cap->start()) {
+    return -2;
+  }
+
+  return 0;
+}
+
+/* -------------------------------------- */
+
+static uint64_t cpu_time_us() {
+
+  struct rusage usage;
+
+  if (0 != getrusage(RUSAGE_SELF, &usage)) {
+    return 0;
+  }
+
+  return (uint64_t)usage.ru_utime.tv_sec * 1000000ull + (uint64_t)usage.ru_utime.tv_usec
+       + (uint64_t)usage.ru_stime.tv_sec * 1000000ull + (uint64_t)usage.ru_stime.tv_usec;
+}
+
+/* Nearest rank percentile of sorted values. */
+static uint64_t percentile(std::vector<uint64_t>& sorted, double p) {
+
+  if (sorted.empty()) {
+    return 0;
+  }
+
+  size_t dx = (size_t)(p * (double)sorted.size());
+
+  if (dx >= sorted.size()) {
+    dx = sorted.size() - 1;
+  }
+
+  return sorted[dx];
+}
+
+static int find_vivid_devices(std::vector<int>& result) {
+
+  V4L2_Capture cap(NULL, NULL);
+  std::vector<V4L2_Device> devices = v4l2_get_system_backend()->getDevices();
+
+  for (size_t i = 0; i < devices.size(); ++i) {
+
+    if (0 > cap.getDriverInfo(devices[i].path.c_str(), devices[i])) {
+      continue;
+    }
+
+    if ("vivid" == devices[i].driver) {
+      result.push_back((int)i);
+    }
+  }
+
+  return (int)result.size();
+}
+
+/* -------------------------------------- */
+
+static void write_json(FILE* fp, BenchOptions& opt, bool use_fake, std::vector<BenchResult>& results) {
+
+  struct utsname un;
+  char date[64] = { 0 };
+  time_t now = time(NULL);
+  struct tm* tm = gmtime(&now);
+
+  if (NULL != tm) {
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", tm);
+  }
+
+  if (0 != uname(&un)) {
+    memset(&un, 0, sizeof(un));
+  }
+
+  fprintf(fp, "{\n");
+  fprintf(fp, "  \"benchmark\": \"v4l2\",\n");
+  fprintf(fp, "  \"date\": \"%s\",\n", date);
+  fprintf(fp, "  \"host\": { \"system\": \"%s\", \"release\": \"%s\", \"machine\": \"%s\", \"cpus\": %ld },\n",
+          un.sysname, un.release, un.machine, sysconf(_SC_NPROCESSORS_ONLN));
+  fprintf(fp, "  \"backend\": \"%s\",\n", (use_fake) ? "fake" : "vivid");
+  fprintf(fp, "  \"io_mode\": \"mmap\",\n");
+  fprintf(fp, "  \"devices\": %d,\n", opt.num_devices);
+  fprintf(fp, "  \"duration\": %.3f,\n", opt.duration);
+  fprintf(fp, "  \"warmup\": %.3f,\n", opt.warmup);
+  fprintf(fp, "  \"poll_us\": %d,\n", opt.poll_us);
+  fprintf(fp, "  \"results\": [");
+
+  for (size_t i = 0; i < results.size(); ++i) {
+
+    BenchResult& r = results[i];
+
+    fprintf(fp, "%s\n    {\n", (0 == i) ? "" : ",");
+    fprintf(fp, "      \"format\": \"%s\",\n", format_to_string(r.format).c_str());
+    fprintf(fp, "      \"output\": \"%s\",\n", (CA_NONE == r.output) ? "none" : format_to_string(r.output).c_str());
+    fprintf(fp, "      \"width\": %d,\n", r.width);
+    fprintf(fp, "      \"height\": %d,\n", r.height);
+    fprintf(fp, "      \"buffers\": %d,\n", r.buffers);
+
+    if (r.skipped) {
+      fprintf(fp, "      \"skipped\": true\n    }");
+      continue;
+    }
+
+    std::sort(r.latencies.begin(), r.latencies.end());
+    std::sort(r.capture_latencies.begin(), r.capture_latencies.end());
+
+    fprintf(fp, "      \"skipped\": false,\n");
+    fprintf(fp, "      \"nominal_fps\": %.2f,\n", (double)r.fps / 100.0);
+    fprintf(fp, "      \"seconds\": %.3f,\n", r.seconds);
+    fprintf(fp, "      \"frames\": %llu,\n", (unsigned long long)r.frames);
+    fprintf(fp, "      \"fps\": %.2f,\n", (double)r.frames / r.seconds);
+    fprintf(fp, "      \"fps_per_device\": %.2f,\n", (double)r.frames / r.seconds / (double)opt.num_devices);
+    fprintf(fp, "      \"dropped\": %llu,\n", (unsigned long long)r.dropped);
+    fprintf(fp, "      \"corrupt\": %llu,\n", (unsigned long long)r.corrupt);
+    fprintf(fp, "      \"cpu_us_per_frame\": %.2f,\n", r.cpu_us_per_frame);
+    fprintf(fp, "      \"cpu_percent\": %.2f,\n", r.cpu_percent);
+    write_percentiles(fp, "latency_ns", r.latencies, false);
+    write_percentiles(fp, "capture_latency_ns", r.capture_latencies, true);
+    fprintf(fp, "    }");
+  }
+
+  fprintf(fp, "\n  ]\n}\n");
+}
+
+/* Writes the percentiles of sorted values as a JSON member of a result. */
+static void write_percentiles(FILE* fp, const char* name, std::vector<uint64_t>& values, bool last) {
+  fprintf(fp, "      \"%s\": { \"min\": %llu, \"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"p999\": %llu, \"max\": %llu }%s\n",
+          name,
+          (unsigned long long)percentile(values, 0.0),
+          (unsigned long long)percentile(values, 0.50),
+          (unsigned long long)percentile(values, 0.90),
+          (unsigned long long)percentile(values, 0.99),
+          (unsigned long long)percentile(values, 0.999),
+          (unsigned long long)percentile(values, 1.0),
+          (last) ? "" : ",");
+}
+
+/* -------------------------------------- */
+
+static int parse_args(int argc, char** argv, BenchOptions& opt) {
+
+  for (int i = 1; i < argc; ++i) {
+
+    const char* arg = argv[i];
+    const char* val = (i + 1 < argc) ? argv[i + 1] : NULL;
+    int r = 0;
+
+    if (0 == strcmp(arg, "--help") || 0 == strcmp(arg, "-h")) {
+      return -1;
+    }
+
+    if (NULL == val) {
+      printf("Error: %s needs a value.\n", arg);
+      return -2;
+    }
+
+    if (0 == strcmp(arg, "--backend")) {
+      opt.backend = val;
+      if ("auto" != opt.backend && "vivid" != opt.backend && "fake" != opt.backend) {
+        printf("Error: unknown backend: %s.\n", val);
+        return -3;
+      }
+    }
+    else if (0 == strcmp(arg, "--json")) {
+      opt.json_path = val;
+    }
+    else if (0 == strcmp(arg, "--trace")) {
+      opt.trace_path = val;
+    }
+    else if (0 == strcmp(arg, "--formats")) {
+      r = parse_formats(val, opt.formats, false);
+    }
+    else if (0 == strcmp(arg, "--outputs")) {
+      r = parse_formats(val, opt.outputs, true);
+    }
+    else if (0 == strcmp(arg, "--sizes")) {
+      r = parse_sizes(val, opt.widths, opt.heights);
+    }
+    else if (0 == strcmp(arg, "--buffers")) {
+      r = parse_ints(val, opt.buffers);
+    }
+    else if (0 == strcmp(arg, "--devices")) {
+      opt.num_devices = atoi(val);
+    }
+    else if (0 == strcmp(arg, "--fake-fps")) {
+      opt.fake_fps = (int)(atof(val) * 100.0 + 0.5);
+    }
+    else if (0 == strcmp(arg, "--fake-jpeg")) {
+      r = read_file(val, opt.fake_jpeg);
+    }
+    else if (0 == strcmp(arg, "--poll-us")) {
+      opt.poll_us = atoi(val);
+    }
+    else if (0 == strcmp(arg, "--duration")) {
+      opt.duration = atof(val);
+    }
+    else if (0 == strcmp(arg, "--warmup")) {
+      opt.warmup = atof(val);
+    }
+    else {
+      printf("Error: unknown option: %s.\n", arg);
+      return -4;
+    }
+
+    if (0 != r) {
+      printf("Error: invalid value for %s: %s.\n", arg, val);
+      return -5;
+    }
+
+    ++i;
+  }
+
+  if (1 > opt.num_devices || 0 >= opt.fake_fps || 0 > opt.poll_us || 0 >= opt.duration || 0 > opt.warmup) {
+    printf("Error: invalid number of devices, frame rate, poll interval or duration.\n");
+    return -6;
+  }
+
+  for (size_t i = 0; i < opt.buffers.size(); ++i) {
+    if (2 > opt.buffers[i]) {
+      printf("Error: we need at least 2 buffers.\n");
+      return -7;
+    }
+  }
+
+  /* Defaults for what wasn't given. */
+  if (opt.formats.empty()) {
+    parse_formats("yuyv422,yuv420p,rgb24", opt.formats, false);
+  }
+
+  if (opt.outputs.empty()) {
+    opt.outputs.push_back(CA_NONE);
+  }
+
+  if (opt.widths.empty()) {
+    parse_sizes("640x480,1280x720,1920x1080", opt.widths, opt.heights);
+  }
+
+  if (opt.buffers.empty()) {
+    parse_ints("2,4,8", opt.buffers);
+  }
+
+  return 0;
+}
+
+/* A comma separated list of e.g. "yuyv422,yuv420bp"; the names of format_to_string() without "CA_". */
+static int parse_formats(const char* str, std::vector<int>& result, bool allow_none) {
+
+  std::vector<std::string> names;
+  std::string name;
+
+  for (const char* p = str; ; ++p) {
+    if ('\0' == *p || ',' == *p) {
+      names.push_back(name);
+      name.clear();
+      if ('\0' == *p) {
+        break;
+      }
+      continue;
+    }
+    name.push_back((char)toupper(*p));
+  }
+
+  for (size_t i = 0; i < names.size(); ++i) {
+
+    int fmt = CA_NONE;
+
+    if ("NONE" == names[i] && allow_none) {
+      result.push_back(CA_NONE);
+      continue;
+    }
+
+    for (int f = CA_UYVY422; f <= CA_H265; ++f) {
+      if ("CA_" + names[i] == format_to_string(f)) {
+        fmt = f;
+        break;
+      }
+    }
+
+    if (CA_NONE == fmt) {
+      return -1;
+    }
+
+    result.push_back(fmt);
+  }
+
+  return 0;
+}
+
+static int parse_ints(const char* str, std::vector<int>& result) {
+
+  const char* p = str;
+  char* end = NULL;
+
+  while ('\0' != *p) {
+
+    long v = strtol(p, &end, 10);
+
+    if (end == p) {
+      return -1;
+    }
+
+    result.push_back((int)v);
+    p = (',' == *end) ? end + 1 : end;
+  }
+
+  return 0;
+}
+
+static int parse_sizes(const char* str, std::vector<int>& widths, std::vector<int>& heights) {
+
+  const char* p = str;
+  int w = 0;
+  int h = 0;
+  int n = 0;
+
+  while ('\0' != *p) {
+
+    if (2 != sscanf(p, "%dx%d%n", &w, &h, &n) || 0 >= w || 0 >= h) {
+      return -1;
+    }
+
+    widths.push_back(w);
+    heights.push_back(h);
+    p += n;
+
+    if (',' == *p) {
+      ++p;
+    }
+  }
+
+  return 0;
+}
+
+static int read_file(const char* path, std::vector<uint8_t>& result) {
+
+  FILE* fp = fopen(path, "rb");
+  long size = 0;
+
+  if (NULL == fp) {
+    return -1;
+  }
+
+  if (0 != fseek(fp, 0, SEEK_END) || 0 >= (size = ftell(fp)) || 0 != fseek(fp, 0, SEEK_SET)) {
+    fclose(fp);
+    return -2;
+  }
+
+  result.resize((size_t)size);
+
+  if (1 != fread(&result[0], (size_t)size, 1, fp)) {
+    result.clear();
+    fclose(fp);
+    return -3;
+  }
+
+  fclose(fp);
+
+  return 0;
+}
+
+static void print_usage() {
+  printf("\nUsage: test_v4l2_benchmark [options]\n\n"
+         "  --backend auto|vivid|fake   the devices; auto uses vivid when loaded, otherwise fakes (auto)\n"
+         "  --devices N                 the number of devices we capture from at the same time (1)\n"
+         "  --formats f1,f2,...         the capture formats, e.g. yuyv422,uyvy422,yuv420p,yuv420bp,rgb24,mjpeg\n"
+         "                              (yuyv422,yuv420p,rgb24)\n"
+         "  --sizes WxH,...             the capture sizes (640x480,1280x720,1920x1080)\n"
+         "  --outputs f1,f2,...         the output formats; none is the capture format (none)\n"
+         "  --buffers n1,n2,...         the number of buffers we request (2,4,8)\n"
+         "  --duration S                seconds we measure every combination (5)\n"
+         "  --warmup S                  seconds we capture before we measure (1)\n"
+         "  --poll-us N                 microseconds we sleep between two update() calls (500)\n"
+         "  --fake-fps F                the frame rate of the fake devices (60)\n"
+         "  --fake-jpeg FILE            the JPEG fake MJPEG devices return; without it we skip MJPEG on fakes\n"
+         "  --json FILE                 where we write the results, - is stdout (v4l2_benchmark.json)\n"
+         "  --trace FILE                save a Chrome trace of the library; needs a USE_TRACE build\n\n");
+}
+
+/* -------------------------------------- */
+
+BenchOptions::BenchOptions()
+  :backend("auto")
+  ,json_path("v4l2_benchmark.json")
+  ,num_devices(1)
+  ,fake_fps(CA_FPS_60_00)
+  ,poll_us(500)
+  ,duration(5.0)
+  ,warmup(1.0)
+{
+}
+
+BenchDevice::BenchDevice()
+  :cap(NULL)
+  ,fake(NULL)
+  ,num_frames(0)
+  ,num_gaps(0)
+  ,start_corrupt(0)
+  ,last_sequence(0)
+  ,has_sequence(false)
+  ,is_measuring(false)
+{
+}
+
+BenchResult::BenchResult()
+  :format(CA_NONE)
+  ,output(CA_NONE)
+  ,width(0)
+  ,height(0)
+  ,buffers(0)
+  ,fps(0)
+  ,skipped(true)
+  ,seconds(0.0)
+  ,frames(0)
+  ,dropped(0)
+  ,corrupt(0)
+  ,cpu_us_per_frame(0.0)
+  ,cpu_percent(0.0)
+{
+}
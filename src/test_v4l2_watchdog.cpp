@@ -0,0 +1,213 @@
+/*
+
+  V4L2 Watchdog Test
+  ------------------
+
+  Checks that the stall watchdog of `V4L2_Capture` recovers a stream
+  with every step, using a `V4L2_FakeDevice` that stops delivering
+  frames after a while:
+
+     restart      the stall ends with STREAMOFF.
+     reallocate   the stall ends when the buffers are requested again.
+     reopen       the stall ends when the device was closed.
+     reopen fails the stall ends when the device was closed, but the
+                  first reopen fails because S_FMT returns EBUSY; the
+                  next reopen must bring the frames back.
+
+  Every case must deliver frames again after the stall. Exits with
+  EXIT_FAILURE when one doesn't.
+
+     ./test_v4l2_watchdog
+
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <videocapture/Log.h>
+#include <videocapture/Utils.h>
+#include <videocapture/CaptureStats.h>
+#include <videocapture/linux/V4L2_Capture.h>
+#include <videocapture/linux/V4L2_FakeDevice.h>
+
+#define WATCHDOG_TIMEOUT_NS 30000000ull                                             /* 30 ms; the fake captures at 100 fps. */
+#define WATCHDOG_STALL_AFTER 20                                                     /* Frames after STREAMON before the fake stalls. */
+#define WATCHDOG_MAX_NS 3000000000ull                                               /* We give up on a case after 3 seconds. */
+
+using namespace ca;
+
+/* A fake of which S_FMT fails with EBUSY while `num_busy` > 0, like a device another process grabbed while we reopened it. */
+class BusyFakeDevice : public V4L2_FakeDevice {
+public:
+  BusyFakeDevice();
+  int ioctl(int fd, unsigned long request, void* arg);
+
+public:
+  int num_busy;
+};
+
+struct WatchdogCase {
+  const char* name;
+  int stall_until;                                                                  /* CA_V4L2_FAKE_STALL_* */
+  int step;                                                                         /* The CA_RECOVER_* that must recover the stream. */
+  int num_busy;                                                                     /* The number of S_FMT calls that fail once the fake stalled, i.e. during the reopen. */
+};
+
+static uint64_t num_frames = 0;
+
+static void on_frame(PixelBuffer& buffer);
+static int run(const WatchdogCase& tc);
+
+/* -------------------------------------- */
+
+int main(int argc, char** argv) {
+
+  WatchdogCase cases[] = {
+    { "restart",      CA_V4L2_FAKE_STALL_STREAMOFF, CA_RECOVER_RESTART,    0 },
+    { "reallocate",   CA_V4L2_FAKE_STALL_REQBUFS,   CA_RECOVER_REALLOCATE, 0 },
+    { "reopen",       CA_V4L2_FAKE_STALL_CLOSE,     CA_RECOVER_REOPEN,     0 },
+    { "reopen fails", CA_V4L2_FAKE_STALL_CLOSE,     CA_RECOVER_REOPEN,     1 }
+  };
+
+  int num_failed = 0;
+
+  /* The failing steps log errors on purpose. */
+  log_set_level(CA_LOG_LEVEL_NONE);
+
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+    if (0 != run(cases[i])) {
+      num_failed++;
+    }
+  }
+
+  if (0 != num_failed) {
+    printf("%d watchdog test(s) failed.\n", num_failed);
+    exit(EXIT_FAILURE);
+  }
+
+  printf("All watchdog tests passed.\n");
+
+  return 0;
+}
+
+/* -------------------------------------- */
+
+BusyFakeDevice::BusyFakeDevice()
+  :num_busy(0)
+{
+}
+
+int BusyFakeDevice::ioctl(int fd, unsigned long request, void* arg) {
+
+  if (VIDIOC_S_FMT == request && 0 < num_busy) {
+    num_busy--;
+    errno = EBUSY;
+    return -1;
+  }
+
+  return V4L2_FakeDevice::ioctl(fd, request, arg);
+}
+
+/* -------------------------------------- */
+
+static void on_frame(PixelBuffer& buffer) {
+  num_frames++;
+}
+
+/* Captures until the stream stalled, was recovered and delivered frames again. Returns 0 when it did. */
+static int run(const WatchdogCase& tc) {
+
+  BusyFakeDevice fake;
+  V4L2_FakeSettings cfg;
+  V4L2_Capture cap(on_frame, NULL);
+  StreamStats stats;
+  Settings settings;
+  uint64_t frames_at_stall = 0;
+  uint64_t num_recovered = 0;
+  uint64_t end_time = 0;
+  bool has_stalled = false;
+  int r = 0;
+
+  cfg.formats.push_back(V4L2_FakeFormat(V4L2_PIX_FMT_YUYV, 320, 240, 1, 100));
+  cfg.stall_after = WATCHDOG_STALL_AFTER;
+  cfg.stall_until = tc.stall_until;
+
+  if (0 != fake.init(cfg)) {
+    printf("%-14s FAILED: cannot initialize the fake device.\n", tc.name);
+    return -1;
+  }
+
+  num_frames = 0;
+
+  cap.setBackend(&fake);
+  cap.setWatchdogTimeout(WATCHDOG_TIMEOUT_NS);
+
+  settings.device = 0;
+  settings.capability = 0;
+
+  if (0 > cap.open(settings) || 0 > cap.start()) {
+    printf("%-14s FAILED: cannot open and start the fake device.\n", tc.name);
+    return -2;
+  }
+
+  end_time = time_now_ns() + WATCHDOG_MAX_NS;
+
+  /* Done when we got half a stream's worth of frames after the stall. */
+  while (time_now_ns() < end_time) {
+
+    cap.update();
+
+    if (false == has_stalled && true == fake.isStalled()) {
+      has_stalled = true;
+      frames_at_stall = num_frames;
+      fake.num_busy = tc.num_busy;
+    }
+
+    if (true == has_stalled && num_frames >= frames_at_stall + WATCHDOG_STALL_AFTER / 2) {
+      break;
+    }
+
+    usleep(1000);
+  }
+
+  cap.getStats(stats);
+
+  for (int i = 0; i < CA_RECOVER_COUNT; ++i) {
+    num_recovered += stats.num_recoveries[i];
+  }
+
+  if (false == has_stalled) {
+    printf("%-14s FAILED: the fake device didn't stall.\n", tc.name);
+    r = -3;
+  }
+  else if (num_frames < frames_at_stall + WATCHDOG_STALL_AFTER / 2) {
+    printf("%-14s FAILED: no frames after the stall; %llu recoveries.\n", tc.name, (unsigned long long)num_recovered);
+    r = -4;
+  }
+  else if (0 == stats.num_recoveries[tc.step]) {
+    printf("%-14s FAILED: the stream wasn't recovered by the expected step.\n", tc.name);
+    r = -5;
+  }
+  else if (0 != fake.num_busy) {
+    printf("%-14s FAILED: the reopen didn't fail.\n", tc.name);
+    r = -6;
+  }
+
+  cap.stop();
+  cap.close();
+
+  if (0 == r && 0 != fake.getNumOpen()) {
+    printf("%-14s FAILED: %d descriptor(s) still open.\n", tc.name, fake.getNumOpen());
+    r = -7;
+  }
+
+  if (0 == r) {
+    printf("%-14s ok: %llu frames, restart: %llu, reallocate: %llu, reopen: %llu.\n", tc.name,
+           (unsigned long long)num_frames,
+           (unsigned long long)stats.num_recoveries[CA_RECOVER_RESTART],
+           (unsigned long long)stats.num_recoveries[CA_RECOVER_REALLOCATE],
+           (unsigned long long)stats.num_recoveries[CA_RECOVER_REOPEN]);
+  }
+
+  return r;
+}
@@ -0,0 +1,391 @@
+#include <videocapture/Log.h>
+#include <videocapture/AviWriter.h>
+
+#define AVI_MAX_RIFF_SIZE (1024ull * 1024ull * 1024ull)                             /* We start a new RIFF segment before one grows beyond 1 GB. */
+#define AVI_SUPER_INDEX_SIZE 256                                                    /* The number of entries we reserve for the super index; with 1 GB segments that's 256 GB. */
+#define AVI_INDEX_RESERVE (30 * 60 * 10)                                            /* The number of index entries we reserve; about 10 minutes at 30 fps, which is more than a 1 GB segment holds for most cameras. */
+#define AVI_MAX_EMPTY_FRAMES 300                                                    /* The maximum number of empty frames we insert for one gap; a larger gap is a clock jump and restarts the timeline. */
+#define AVIF_HASINDEX 0x00000010                                                    /* avih flag: the file has an 'idx1'. */
+#define AVIIF_KEYFRAME 0x00000010                                                   /* idx1 flag: the chunk is a key frame. */
+#define AVI_INDEX_OF_INDEXES 0x00                                                   /* indx type: a super index. */
+#define AVI_INDEX_OF_CHUNKS 0x01                                                    /* indx type: a standard index. */
+
+namespace ca {
+
+  AviWriter::AviWriter()
+    :width(0)
+    ,height(0)
+    ,rate(0)
+    ,frame_duration(0)
+    ,first_timestamp(0)
+    ,num_frames(0)
+    ,num_first_frames(0)
+    ,max_chunk_size(0)
+    ,riff_offset(0)
+    ,movi_offset(0)
+    ,hdrl_offset(0)
+    ,avih_offset(0)
+    ,strh_offset(0)
+    ,indx_offset(0)
+    ,dmlh_offset(0)
+    ,is_first_segment(true)
+  {
+  }
+
+  AviWriter::~AviWriter() {
+    if (true == file.isOpen()) {
+      close();
+    }
+  }
+
+  int AviWriter::open(const std::string& filepath, int w, int h, int fmt, int fps) {
+
+    if (true == file.isOpen()) {
+      printf("Error: cannot open %s, the AVI writer is already open.\n", filepath.c_str());
+      return -1;
+    }
+
+    if (CA_MJPEG != fmt && CA_JPEG_OPENDML != fmt) {
+      printf("Error: the AVI writer can only store MJPEG frames.\n");
+      return -2;
+    }
+
+    if (0 >= w || 0 >= h) {
+      printf("Error: invalid frame size for the AVI writer: %d x %d.\n", w, h);
+      return -3;
+    }
+
+    if (0 != file.open(filepath)) {
+      return -4;
+    }
+
+    width = w;
+    height = h;
+    rate = (0 < fps) ? (uint32_t)fps : (uint32_t)CA_FPS_30_00;
+    frame_duration = (100ull * 1000000000ull) / rate;
+    first_timestamp = 0;
+    num_frames = 0;
+    num_first_frames = 0;
+    max_chunk_size = 0;
+    is_first_segment = true;
+
+    index.clear();
+    index.reserve(AVI_INDEX_RESERVE);
+    super_index.clear();
+    super_index.reserve(AVI_SUPER_INDEX_SIZE);
+
+    if (0 != writeHeader()) {
+      file.close();
+      return -5;
+    }
+
+    return 0;
+  }
+
+  int AviWriter::close() {
+
+    int r = 0;
+
+    if (false == file.isOpen()) {
+      printf("Error: cannot close the AVI writer, it's not open.\n");
+      return -1;
+    }
+
+    if (0 != endSegment()) {
+      r = -2;
+    }
+
+    /* Now we know the counts and sizes in the header. */
+    uint32_t suggested = max_chunk_size + 8;
+
+    file.patchU32(avih_offset + 16, (uint32_t)num_first_frames);
+    file.patchU32(avih_offset + 28, suggested);
+    file.patchU32(strh_offset + 32, (uint32_t)num_frames);
+    file.patchU32(strh_offset + 36, suggested);
+    file.patchU32(dmlh_offset, (uint32_t)num_frames);
+    file.patchU32(indx_offset + 4, (uint32_t)super_index.size());
+
+    for (size_t i = 0; i < super_index.size(); ++i) {
+      uint64_t entry = indx_offset + 24 + i * 16;
+      file.patchU64(entry, super_index[i].offset);
+      file.patchU32(entry + 8, super_index[i].size);
+      file.patchU32(entry + 12, super_index[i].duration);
+    }
+
+    if (0 != file.close()) {
+      r = -3;
+    }
+
+    index.clear();
+    super_index.clear();
+
+    return r;
+  }
+
+  int AviWriter::writeFrame(const DataChunk* chunks, int nchunks, uint64_t timestamp, bool keyframe) {
+
+    if (false == file.isOpen()) {
+      printf("Error: cannot write a frame, the AVI writer isn't open.\n");
+      return -1;
+    }
+
+    if (0 == num_frames) {
+      first_timestamp = timestamp;
+    }
+    else if (timestamp > first_timestamp) {
+
+      /* The frame number according to the clock; when the camera dropped frames we fill the gap. */
+      uint64_t expected = (timestamp - first_timestamp + frame_duration / 2) / frame_duration;
+
+      if (expected > num_frames + AVI_MAX_EMPTY_FRAMES) {
+
+        /* Too large to be dropped frames; the clock jumped. Continue the timeline from this frame so we don't fill again for every next one. */
+        CA_LOG_WARNING("the timestamp jumped %llu frames ahead, continuing the timeline from here.", (unsigned long long)(expected - num_frames));
+        first_timestamp = timestamp - num_frames * frame_duration;
+      }
+      else {
+        while (num_frames < expected) {
+          if (0 != writeChunk(NULL, 0, false)) {
+            return -2;
+          }
+        }
+      }
+    }
+
+    if (0 != writeChunk(chunks, nchunks, keyframe)) {
+      return -3;
+    }
+
+    return 0;
+  }
+
+  uint64_t AviWriter::getNumFrames() {
+    return num_frames;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  int AviWriter::writeHeader() {
+
+    uint64_t strl_offset = 0;
+    uint64_t odml_offset = 0;
+
+    riff_offset = file.tell();
+    file.writeFourCC("RIFF");
+    file.writeU32(0);
+    file.writeFourCC("AVI ");
+
+    hdrl_offset = file.tell();
+    file.writeFourCC("LIST");
+    file.writeU32(0);
+    file.writeFourCC("hdrl");
+
+    /* Main header, the counts are patched in `close()`. */
+    file.writeFourCC("avih");
+    file.writeU32(56);
+    avih_offset = file.tell();
+    file.writeU32((uint32_t)(frame_duration / 1000));                              /* dwMicroSecPerFrame */
+    file.writeU32(0);                                                               /* dwMaxBytesPerSec */
+    file.writeU32(0);                                                               /* dwPaddingGranularity */
+    file.writeU32(AVIF_HASINDEX);                                                   /* dwFlags */
+    file.writeU32(0);                                                               /* dwTotalFrames, of the first RIFF */
+    file.writeU32(0);                                                               /* dwInitialFrames */
+    file.writeU32(1);                                                               /* dwStreams */
+    file.writeU32(0);                                                               /* dwSuggestedBufferSize */
+    file.writeU32((uint32_t)width);                                                 /* dwWidth */
+    file.writeU32((uint32_t)height);                                                /* dwHeight */
+    file.writeZeros(16);                                                            /* dwReserved[4] */
+
+    strl_offset = file.tell();
+    file.writeFourCC("LIST");
+    file.writeU32(0);
+    file.writeFourCC("strl");
+
+    /* Stream header. */
+    file.writeFourCC("strh");
+    file.writeU32(56);
+    strh_offset = file.tell();
+    file.writeFourCC("vids");                                                       /* fccType */
+    file.writeFourCC("MJPG");                                                       /* fccHandler */
+    file.writeU32(0);                                                               /* dwFlags */
+    file.writeU16(0);                                                               /* wPriority */
+    file.writeU16(0);                                                               /* wLanguage */
+    file.writeU32(0);                                                               /* dwInitialFrames */
+    file.writeU32(100);                                                             /* dwScale */
+    file.writeU32(rate);                                                            /* dwRate */
+    file.writeU32(0);                                                               /* dwStart */
+    file.writeU32(0);                                                               /* dwLength, of all RIFFs */
+    file.writeU32(0);                                                               /* dwSuggestedBufferSize */
+    file.writeU32(0xFFFFFFFF);                                                      /* dwQuality */
+    file.writeU32(0);                                                               /* dwSampleSize */
+    file.writeU16(0);                                                               /* rcFrame */
+    file.writeU16(0);
+    file.writeU16((uint16_t)width);
+    file.writeU16((uint16_t)height);
+
+    /* Stream format: BITMAPINFOHEADER. */
+    file.writeFourCC("strf");
+    file.writeU32(40);
+    file.writeU32(40);                                                              /* biSize */
+    file.writeU32((uint32_t)width);                                                 /* biWidth */
+    file.writeU32((uint32_t)height);                                                /* biHeight */
+    file.writeU16(1);                                                               /* biPlanes */
+    file.writeU16(24);                                                              /* biBitCount */
+    file.writeFourCC("MJPG");                                                       /* biCompression */
+    file.writeU32((uint32_t)(width * height * 3));                                  /* biSizeImage */
+    file.writeZeros(16);                                                            /* biXPelsPerMeter, biYPelsPerMeter, biClrUsed, biClrImportant */
+
+    /* OpenDML super index, the entries are patched in `close()`. */
+    file.writeFourCC("indx");
+    file.writeU32(24 + AVI_SUPER_INDEX_SIZE * 16);
+    indx_offset = file.tell();
+    file.writeU16(4);                                                               /* wLongsPerEntry */
+    file.writeU8(0);                                                                /* bIndexSubType */
+    file.writeU8(AVI_INDEX_OF_INDEXES);                                             /* bIndexType */
+    file.writeU32(0);                                                               /* nEntriesInUse */
+    file.writeFourCC("00dc");                                                       /* dwChunkId */
+    file.writeZeros(12);                                                            /* dwReserved[3] */
+    file.writeZeros(AVI_SUPER_INDEX_SIZE * 16);
+
+    file.patchU32(strl_offset + 4, (uint32_t)(file.tell() - strl_offset - 8));
+
+    /* OpenDML header with the total number of frames. */
+    odml_offset = file.tell();
+    file.writeFourCC("LIST");
+    file.writeU32(0);
+    file.writeFourCC("odml");
+    file.writeFourCC("dmlh");
+    file.writeU32(248);
+    dmlh_offset = file.tell();
+    file.writeZeros(248);
+
+    file.patchU32(odml_offset + 4, (uint32_t)(file.tell() - odml_offset - 8));
+    file.patchU32(hdrl_offset + 4, (uint32_t)(file.tell() - hdrl_offset - 8));
+
+    movi_offset = file.tell();
+    file.writeFourCC("LIST");
+    file.writeU32(0);
+
+    return file.writeFourCC("movi");
+  }
+
+  int AviWriter::writeChunk(const DataChunk* chunks, int nchunks, bool keyframe) {
+
+    AviIndexEntry entry;
+    uint64_t nbytes = 0;
+
+    for (int i = 0; i < nchunks; ++i) {
+      nbytes += chunks[i].nbytes;
+    }
+
+    if (0xFFFFFFF0ull < nbytes) {
+      printf("Error: the frame is too large for AVI.\n");
+      return -1;
+    }
+
+    /* Room for the chunk and the indices (idx1 + ix00) of the segment. */
+    uint64_t needed = 8 + nbytes + 1 + (index.size() + 1) * 24 + 64;
+
+    if (0 != index.size() && file.tell() + needed - riff_offset > AVI_MAX_RIFF_SIZE) {
+
+      if (AVI_SUPER_INDEX_SIZE <= super_index.size() + 1) {
+        printf("Error: the AVI file is full (%d segments).\n", AVI_SUPER_INDEX_SIZE);
+        return -2;
+      }
+
+      if (0 != endSegment() || 0 != beginSegment()) {
+        return -3;
+      }
+    }
+
+    entry.offset = file.tell();
+    entry.size = (uint32_t)nbytes;
+    entry.keyframe = keyframe;
+
+    file.writeFourCC("00dc");
+    file.writeU32((uint32_t)nbytes);
+
+    if (0 != file.write(chunks, nchunks)) {
+      return -4;
+    }
+
+    /* Chunks are word aligned. */
+    if (0 != (nbytes & 1)) {
+      file.writeU8(0);
+    }
+
+    index.push_back(entry);
+    num_frames++;
+
+    if (entry.size > max_chunk_size) {
+      max_chunk_size = entry.size;
+    }
+
+    return 0;
+  }
+
+  int AviWriter::beginSegment() {
+
+    riff_offset = file.tell();
+    file.writeFourCC("RIFF");
+    file.writeU32(0);
+    file.writeFourCC("AVIX");
+
+    movi_offset = file.tell();
+    file.writeFourCC("LIST");
+    file.writeU32(0);
+
+    return file.writeFourCC("movi");
+  }
+
+  int AviWriter::endSegment() {
+
+    AviSuperIndexEntry super;
+
+    /* The standard index, inside the 'movi' list. Offsets are relative to the 'movi' list and point to the chunk data. */
+    super.offset = file.tell();
+    super.size = (uint32_t)(8 + 24 + index.size() * 8);
+    super.duration = (uint32_t)index.size();
+
+    file.writeFourCC("ix00");
+    file.writeU32(super.size - 8);
+    file.writeU16(2);                                                               /* wLongsPerEntry */
+    file.writeU8(0);                                                                /* bIndexSubType */
+    file.writeU8(AVI_INDEX_OF_CHUNKS);                                              /* bIndexType */
+    file.writeU32((uint32_t)index.size());                                          /* nEntriesInUse */
+    file.writeFourCC("00dc");                                                       /* dwChunkId */
+    file.writeU64(movi_offset);                                                     /* qwBaseOffset */
+    file.writeU32(0);                                                               /* dwReserved */
+
+    for (size_t i = 0; i < index.size(); ++i) {
+      file.writeU32((uint32_t)(index[i].offset + 8 - movi_offset));
+      file.writeU32(index[i].size | ((true == index[i].keyframe) ? 0 : 0x80000000));
+    }
+
+    super_index.push_back(super);
+
+    file.patchU32(movi_offset + 4, (uint32_t)(file.tell() - movi_offset - 8));
+
+    /* The legacy index for players without OpenDML support; offsets are relative to the 'movi' fourcc. */
+    if (true == is_first_segment) {
+
+      file.writeFourCC("idx1");
+      file.writeU32((uint32_t)(index.size() * 16));
+
+      for (size_t i = 0; i < index.size(); ++i) {
+        file.writeFourCC("00dc");
+        file.writeU32((true == index[i].keyframe) ? AVIIF_KEYFRAME : 0);
+        file.writeU32((uint32_t)(index[i].offset - (movi_offset + 8)));
+        file.writeU32(index[i].size);
+      }
+
+      num_first_frames = index.size();
+      is_first_segment = false;
+    }
+
+    index.clear();
+
+    return file.patchU32(riff_offset + 4, (uint32_t)(file.tell() - riff_offset - 8));
+  }
+
+} /* namespace ca */
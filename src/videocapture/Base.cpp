@@ -93,4 +93,18 @@ namespace ca {
     return result;
   }
 
+  int Base::getStats(StreamStats& result) {
+    stats.get(result);
+    return 0;
+  }
+
+  int Base::getLatency(int which, LatencyHistogram& result) {
+    return stats.getLatency(which, result);
+  }
+
+  int Base::resetLatency() {
+    stats.resetLatency();
+    return 0;
+  }
+
 }; // namespace ca
@@ -1,3 +1,6 @@
+#include <videocapture/Log.h>
+#include <videocapture/ConvertPlan.h>
+#include <videocapture/FramePipeline.h>
 #include <videocapture/CapabilityFinder.h>
 
 namespace ca {
@@ -24,7 +27,7 @@ namespace ca {
         && CA_RATIO != attribute
         && CA_PIXEL_FORMAT != attribute)
       {
-        printf("Error: invalid attribute.\n");
+        CA_LOG_ERROR("invalid attribute.");
         return -1;
       }
     
@@ -38,30 +41,58 @@ namespace ca {
     result.device = device;
     
     if (0 == filters.size()) {
-      printf("Error: cannot get the best capability because you haven't added any filters.\n");
+      CA_LOG_ERROR("cannot get the best capability because you haven't added any filters.");
       return -1;
     }
     
     std::vector<Capability> capabilities = filterCapabilities(device);
     if (0 == capabilities.size()) {
-      printf("Error: cannot find any capability which conforms the set filters.\n");
+      CA_LOG_ERROR("cannot find any capability which conforms the set filters.");
       return -2;
     }
 
-    Capability best_capability = capabilities[0];
+    /* 
+       Capabilities with the same score and fps are equally good for the user;
+       from those we pick the one that is cheapest to deliver in the requested
+       format: native first, then the cheapest conversion (see ConvertPlan.h).
+    */
+    int best = -1;
+    double best_cost = 0.0;
+
+    for (size_t i = 0; i < capabilities.size(); ++i) {
+
+      Capability& candidate = capabilities[i];
+
+      if (candidate.filter_score != capabilities[0].filter_score
+          || candidate.fps != capabilities[0].fps)
+        {
+          break;
+        }
+
+      double cost = conversionCost(candidate, format);
+      if (cost < 0.0) {
+        continue;
+      }
+
+      if (-1 == best || cost < best_cost) {
+        best = (int)i;
+        best_cost = cost;
+      }
+    }
+
+    if (-1 == best) {
+      return -4;
+    }
+
+    Capability best_capability = capabilities[best];
     if (0 > best_capability.index) {
-      printf("Error: the index value < 0; not supposed to happen.\n");
+      CA_LOG_ERROR("the index value < 0; not supposed to happen.");
       return -3;
     }
 
-    /* Check if the found capability uses the requested format, and if not check if we can convert it*/
+    /* When the capability doesn't use the requested format, the capture SDK or we convert it. */
     if (best_capability.pixel_format != format) {
-      if (0 == cap.hasOutputFormat(format)) {
-        result.format = format;
-      }
-      else {
-        return -4;
-      }
+      result.format = format;
     }
 
     result.capability = best_capability.index;
@@ -69,6 +100,34 @@ namespace ca {
     return 0;
   }
 
+  double CapabilityFinder::conversionCost(const Capability& capability, int format) {
+
+    if (capability.pixel_format == format) {
+      return 0.0;
+    }
+
+    if (0 != cap.hasOutputFormat(format)) {
+      return -1.0;
+    }
+
+    double cost = convert_get_planner().getCost(capability.pixel_format, format);
+
+    if (cost < 0.0) {
+#if defined(__APPLE__) || defined(_WIN32)
+      /* The capture SDK converts but we don't know how expensive that is; prefer our own conversions. */
+      cost = 1000.0;
+#else
+      /* We convert ourselves; without a conversion path only decoding can deliver the format. */
+      if (false == frame_pipeline_can_deliver(capability.pixel_format, format)) {
+        return -1.0;
+      }
+      cost = 1000.0;
+#endif
+    }
+
+    return cost * capability.width * capability.height;
+  }
+
   std::vector<Capability> CapabilityFinder::filterCapabilities(int device) {
 
     float ratio = 0.0;
@@ -111,7 +170,7 @@ namespace ca {
           case CA_RATIO: {
             
             if (0 == capability.width || 0 == capability.height) {
-              printf("Error: the capability is missing a value for it's width and/or height: %d x %d.\n", capability.width, capability.height);
+              CA_LOG_ERROR("the capability is missing a value for it's width and/or height: %d x %d.", capability.width, capability.height);
               continue;
             }
         
@@ -130,7 +189,7 @@ namespace ca {
             break;
           }
           default: {
-            printf("Unhandled capability filter attribute: %d\n", filter.attribute);
+            CA_LOG_WARNING("Unhandled capability filter attribute: %d", filter.attribute);
             break;
           }
         }
@@ -36,6 +36,14 @@ namespace ca {
     }
 #endif
 
+    if(cap == NULL && driver == CA_REPLAY) {
+      cap = new Replay_Capture(fc, user);
+    }
+
+    if(cap == NULL && driver == CA_SYNTHETIC) {
+      cap = new Synthetic_Capture(fc, user);
+    }
+
     if(cap == NULL) {
       printf("Error: no valid capture driver found.\n");
       ::exit(EXIT_FAILURE);
@@ -147,6 +155,21 @@ namespace ca {
     }
     return -1;
   }
+
+  int Capture::getStats(StreamStats& result) {
+    assert(cap != NULL);
+    return cap->getStats(result);
+  }
+
+  int Capture::getLatency(int which, LatencyHistogram& result) {
+    assert(cap != NULL);
+    return cap->getLatency(which, result);
+  }
+
+  int Capture::resetLatency() {
+    assert(cap != NULL);
+    return cap->resetLatency();
+  }
   
   /* ------------------------------------------------------------------------- */
 
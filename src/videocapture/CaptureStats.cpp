@@ -0,0 +1,281 @@
+#include <stdio.h>
+#include <string.h>
+#include <videocapture/CaptureStats.h>
+
+#if defined(_MSC_VER)
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#endif
+
+namespace ca {
+
+  /* The writer's fence orders the counter before (and after) the values, the reader's orders the loads the same way. On x86 both only stop the compiler. */
+  static inline void stats_write_fence() {
+#if defined(_MSC_VER)
+    MemoryBarrier();
+#elif defined(__ATOMIC_RELEASE)
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+#else
+    __sync_synchronize();
+#endif
+  }
+
+  static inline void stats_read_fence() {
+#if defined(_MSC_VER)
+    MemoryBarrier();
+#elif defined(__ATOMIC_ACQUIRE)
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+#else
+    __sync_synchronize();
+#endif
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  StreamStats::StreamStats()
+    :num_captured(0)
+    ,num_delivered(0)
+    ,num_dropped(0)
+    ,fps(0.0)
+    ,jitter_ns(0.0)
+    ,callback_ns(0)
+    ,callback_avg_ns(0.0)
+    ,callback_max_ns(0)
+    ,last_delivered(0)
+    ,num_buffers(0)
+    ,num_queued(0)
+    ,num_held(0)
+    ,num_opened(0)
+  {
+    for (int i = 0; i < CA_RECOVER_COUNT; ++i) {
+      num_recoveries[i] = 0;
+      last_recovery[i] = 0;
+    }
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  CaptureStats::CaptureStats()
+    :version(0)
+    ,must_reset_latency(0)
+    ,last_timestamp(0)
+    ,last_sequence(0)
+    ,has_sequence(false)
+    ,avg_interval(0.0)
+  {
+  }
+
+  void CaptureStats::reset() {
+
+    StreamStats kept = values;
+
+    beginWrite();
+    values = StreamStats();
+    values.num_opened = kept.num_opened + 1;
+
+    for (int i = 0; i < CA_RECOVER_COUNT; ++i) {
+      values.num_recoveries[i] = kept.num_recoveries[i];
+      values.last_recovery[i] = kept.last_recovery[i];
+    }
+
+    clearLatency();
+    endWrite();
+
+    last_timestamp = 0;
+    last_sequence = 0;
+    has_sequence = false;
+    avg_interval = 0.0;
+  }
+
+  void CaptureStats::frameCaptured(uint64_t timestamp, uint64_t sequence) {
+
+    beginWrite();
+
+    /* A sequence that goes back means the driver restarted counting (e.g. STREAMON). */
+    if (true == has_sequence && sequence > last_sequence + 1) {
+      values.num_dropped += sequence - last_sequence - 1;
+    }
+
+    last_sequence = sequence;
+    has_sequence = true;
+    values.num_captured++;
+    addInterval(timestamp);
+
+    endWrite();
+  }
+
+  void CaptureStats::frameCaptured(uint64_t timestamp) {
+
+    beginWrite();
+    values.num_captured++;
+    addInterval(timestamp);
+    endWrite();
+  }
+
+  void CaptureStats::framesDropped(uint64_t n) {
+
+    if (0 == n) {
+      return;
+    }
+
+    beginWrite();
+    values.num_dropped += n;
+    endWrite();
+  }
+
+  void CaptureStats::frameDelivered(uint64_t start, uint64_t end) {
+
+    uint64_t duration = (end > start) ? end - start : 0;
+
+    beginWrite();
+
+    values.num_delivered++;
+    values.callback_ns = duration;
+    values.last_delivered = end;
+
+    if (duration > values.callback_max_ns) {
+      values.callback_max_ns = duration;
+    }
+
+    if (1 == values.num_delivered) {
+      values.callback_avg_ns = (double)duration;
+    }
+    else {
+      values.callback_avg_ns += CA_STATS_EWMA_WEIGHT * ((double)duration - values.callback_avg_ns);
+    }
+
+    if (0 != must_reset_latency) {
+      clearLatency();
+    }
+
+    latency[CA_LATENCY_CALLBACK].record(duration);
+
+    endWrite();
+  }
+
+  void CaptureStats::setBuffers(int total, int queued) {
+
+    beginWrite();
+    values.num_buffers = total;
+    values.num_queued = queued;
+    values.num_held = total - queued;
+    endWrite();
+  }
+
+  void CaptureStats::recoveryStarted(int which, uint64_t time) {
+
+    if (0 > which || CA_RECOVER_COUNT <= which) {
+      return;
+    }
+
+    beginWrite();
+    values.num_recoveries[which]++;
+    values.last_recovery[which] = time;
+    endWrite();
+  }
+
+  void CaptureStats::recordLatency(int which, uint64_t ns) {
+
+    if (0 > which || CA_LATENCY_COUNT <= which) {
+      return;
+    }
+
+    beginWrite();
+
+    if (0 != must_reset_latency) {
+      clearLatency();
+    }
+
+    latency[which].record(ns);
+
+    endWrite();
+  }
+
+  void CaptureStats::get(StreamStats& result) {
+
+    uint32_t before = 0;
+    uint32_t after = 0;
+
+    do {
+      before = version;
+      stats_read_fence();
+      memcpy(&result, &values, sizeof(result));
+      stats_read_fence();
+      after = version;
+    } while (before != after || 0 != (before & 1));
+  }
+
+  int CaptureStats::getLatency(int which, LatencyHistogram& result) {
+
+    uint32_t before = 0;
+    uint32_t after = 0;
+
+    if (0 > which || CA_LATENCY_COUNT <= which) {
+      printf("Error: cannot get the latency histogram, invalid index: %d.\n", which);
+      return -1;
+    }
+
+    do {
+      before = version;
+      stats_read_fence();
+      memcpy(&result, &latency[which], sizeof(result));
+      stats_read_fence();
+      after = version;
+    } while (before != after || 0 != (before & 1));
+
+    /* The writer didn't get to the reset yet. */
+    if (0 != must_reset_latency) {
+      result.reset();
+    }
+
+    return 0;
+  }
+
+  void CaptureStats::resetLatency() {
+    must_reset_latency = 1;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  void CaptureStats::beginWrite() {
+    version = version + 1;
+    stats_write_fence();
+  }
+
+  void CaptureStats::endWrite() {
+    stats_write_fence();
+    version = version + 1;
+  }
+
+  void CaptureStats::clearLatency() {
+
+    /* Cleared before resetting, so a request that comes in while we reset isn't lost. */
+    must_reset_latency = 0;
+
+    for (int i = 0; i < CA_LATENCY_COUNT; ++i) {
+      latency[i].reset();
+    }
+  }
+
+  void CaptureStats::addInterval(uint64_t timestamp) {
+
+    if (0 != last_timestamp && timestamp > last_timestamp) {
+
+      double interval = (double)(timestamp - last_timestamp);
+
+      if (0.0 == avg_interval) {
+        avg_interval = interval;
+      }
+      else {
+        double deviation = interval - avg_interval;
+        avg_interval += CA_STATS_EWMA_WEIGHT * deviation;
+        values.jitter_ns += CA_STATS_EWMA_WEIGHT * (((deviation < 0.0) ? -deviation : deviation) - values.jitter_ns);
+      }
+
+      values.fps = 1e9 / avg_interval;
+    }
+
+    last_timestamp = timestamp;
+  }
+
+} /* namespace ca */
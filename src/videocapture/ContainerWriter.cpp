@@ -0,0 +1,21 @@
+#include <videocapture/ContainerWriter.h>
+
+namespace ca {
+
+  ContainerWriter::ContainerWriter() {
+  }
+
+  ContainerWriter::~ContainerWriter() {
+  }
+
+  void ContainerWriter::setCodecPrivate(const uint8_t* data, size_t nbytes) {
+
+    if (NULL == data || 0 == nbytes) {
+      codec_private.clear();
+      return;
+    }
+
+    codec_private.assign(data, data + nbytes);
+  }
+
+} /* namespace ca */
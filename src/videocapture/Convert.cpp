@@ -0,0 +1,485 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <videocapture/Cpu.h>
+#include <videocapture/Log.h>
+#include <videocapture/Error.h>
+#include <videocapture/Utils.h>
+#include <videocapture/Convert.h>
+#include <videocapture/simd/SIMD_Convert.h>
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  static bool convert_is_usable_at(int kernellevel, int cpulevel);                 /* Returns true when a kernel of `kernellevel` may be used when running at `cpulevel`. */
+  static void convert_setup_padded(PixelBuffer& buf, std::vector<uint8_t>& mem, int w, int h, int fmt, int pad); /* Sets up `buf` with `pad` extra bytes per row, used by the self test. */
+  static bool convert_compare(const PixelBuffer& a, const PixelBuffer& b);         /* Compares the visible pixels of two buffers, ignoring the row padding. */
+
+  /* ------------------------------------------------------------------------- */
+
+  static inline uint8_t clamp255(int v) {
+    return (uint8_t)((v < 0) ? 0 : ((v > 255) ? 255 : v));
+  }
+
+  /* BT.601 video range, 8 bit fixed point; writes the components at the R/G/B offsets. */
+  template<int R, int G, int B>
+  static inline void yuv_to_rgb(int y, int u, int v, uint8_t* out) {
+    int c = 298 * (y - 16) + 128;
+    int d = u - 128;
+    int e = v - 128;
+    out[R] = clamp255((c + 409 * e) >> 8);
+    out[G] = clamp255((c - 100 * d - 208 * e) >> 8);
+    out[B] = clamp255((c + 516 * d) >> 8);
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  /* Packed 4:2:2 (YUYV, UYVY) > YUV420P. The chroma of two rows is averaged. */
+  template<int Y0, int U, int Y1, int V>
+  static void packed422_to_yuv420p(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int pairs = (int)dst.width[0] / 2;
+
+    for (int y = y0; y < y1; y += 2) {
+
+      bool has_next = (y + 1) < y1;
+      const uint8_t* s0 = src.plane[0] + y * src.stride[0];
+      const uint8_t* s1 = (has_next) ? (s0 + src.stride[0]) : s0;
+      uint8_t* d0 = dst.plane[0] + y * dst.stride[0];
+      uint8_t* d1 = d0 + dst.stride[0];
+
+      for (int x = 0; x < pairs; ++x) {
+        d0[2 * x + 0] = s0[4 * x + Y0];
+        d0[2 * x + 1] = s0[4 * x + Y1];
+      }
+
+      if (has_next) {
+        for (int x = 0; x < pairs; ++x) {
+          d1[2 * x + 0] = s1[4 * x + Y0];
+          d1[2 * x + 1] = s1[4 * x + Y1];
+        }
+      }
+
+      if ((size_t)(y / 2) >= dst.height[1]) {
+        continue;
+      }
+
+      uint8_t* du = dst.plane[1] + (y / 2) * dst.stride[1];
+      uint8_t* dv = dst.plane[2] + (y / 2) * dst.stride[2];
+
+      for (int x = 0; x < pairs; ++x) {
+        du[x] = (uint8_t)((s0[4 * x + U] + s1[4 * x + U] + 1) >> 1);
+        dv[x] = (uint8_t)((s0[4 * x + V] + s1[4 * x + V] + 1) >> 1);
+      }
+    }
+  }
+
+  /* Packed 4:2:2 (YUYV, UYVY) > YUV422P */
+  template<int Y0, int U, int Y1, int V>
+  static void packed422_to_yuv422p(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int pairs = (int)dst.width[0] / 2;
+
+    for (int y = y0; y < y1; ++y) {
+
+      const uint8_t* s = src.plane[0] + y * src.stride[0];
+      uint8_t* dy = dst.plane[0] + y * dst.stride[0];
+      uint8_t* du = dst.plane[1] + y * dst.stride[1];
+      uint8_t* dv = dst.plane[2] + y * dst.stride[2];
+
+      for (int x = 0; x < pairs; ++x) {
+        dy[2 * x + 0] = s[4 * x + Y0];
+        dy[2 * x + 1] = s[4 * x + Y1];
+        du[x] = s[4 * x + U];
+        dv[x] = s[4 * x + V];
+      }
+    }
+  }
+
+  /* Packed 4:2:2 (YUYV, UYVY) > RGB with R/G/B/A offsets and BPP bytes per pixel. A < 0 means no alpha. */
+  template<int Y0, int U, int Y1, int V, int R, int G, int B, int A, int BPP>
+  static void packed422_to_rgb(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int pairs = (int)dst.width[0] / 2;
+
+    for (int y = y0; y < y1; ++y) {
+
+      const uint8_t* s = src.plane[0] + y * src.stride[0];
+      uint8_t* d = dst.plane[0] + y * dst.stride[0];
+
+      for (int x = 0; x < pairs; ++x) {
+        yuv_to_rgb<R, G, B>(s[4 * x + Y0], s[4 * x + U], s[4 * x + V], d);
+        yuv_to_rgb<R, G, B>(s[4 * x + Y1], s[4 * x + U], s[4 * x + V], d + BPP);
+        if (A >= 0) {
+          d[A] = 0xFF;
+          d[A + BPP] = 0xFF;
+        }
+        d += 2 * BPP;
+      }
+    }
+  }
+
+  /* YUV420P > RGB with R/G/B/A offsets and BPP bytes per pixel. A < 0 means no alpha. */
+  template<int R, int G, int B, int A, int BPP>
+  static void yuv420p_to_rgb(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int w = (int)dst.width[0];
+
+    for (int y = y0; y < y1; ++y) {
+
+      int cy = y / 2;
+      if ((size_t)cy >= src.height[1]) {
+        cy = (int)src.height[1] - 1;
+      }
+
+      const uint8_t* sy = src.plane[0] + y * src.stride[0];
+      const uint8_t* su = src.plane[1] + cy * src.stride[1];
+      const uint8_t* sv = src.plane[2] + cy * src.stride[2];
+      uint8_t* d = dst.plane[0] + y * dst.stride[0];
+
+      for (int x = 0; x < w; ++x) {
+        yuv_to_rgb<R, G, B>(sy[x], su[x / 2], sv[x / 2], d);
+        if (A >= 0) {
+          d[A] = 0xFF;
+        }
+        d += BPP;
+      }
+    }
+  }
+
+  /* YUV422P > YUV420P. The chroma of two rows is averaged. */
+  static void yuv422p_to_yuv420p(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int w = (int)dst.width[0];
+    int cw = (int)dst.width[1];
+
+    for (int y = y0; y < y1; ++y) {
+      memcpy(dst.plane[0] + y * dst.stride[0], src.plane[0] + y * src.stride[0], w);
+    }
+
+    for (int y = y0; y < y1; y += 2) {
+
+      int cy = y / 2;
+      if ((size_t)cy >= dst.height[1]) {
+        break;
+      }
+
+      int next = ((y + 1) < y1) ? (y + 1) : y;
+
+      for (int p = 1; p < 3; ++p) {
+        const uint8_t* s0 = src.plane[p] + y * src.stride[p];
+        const uint8_t* s1 = src.plane[p] + next * src.stride[p];
+        uint8_t* d = dst.plane[p] + cy * dst.stride[p];
+        for (int x = 0; x < cw; ++x) {
+          d[x] = (uint8_t)((s0[x] + s1[x] + 1) >> 1);
+        }
+      }
+    }
+  }
+
+  /* YUV420P > YUV420BP (NV12) */
+  static void yuv420p_to_yuv420bp(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int w = (int)dst.width[0];
+    int cw = (int)dst.width[1];
+
+    for (int y = y0; y < y1; ++y) {
+      memcpy(dst.plane[0] + y * dst.stride[0], src.plane[0] + y * src.stride[0], w);
+    }
+
+    for (int cy = y0 / 2; cy < (y1 + 1) / 2 && (size_t)cy < dst.height[1]; ++cy) {
+      const uint8_t* su = src.plane[1] + cy * src.stride[1];
+      const uint8_t* sv = src.plane[2] + cy * src.stride[2];
+      uint8_t* d = dst.plane[1] + cy * dst.stride[1];
+      for (int x = 0; x < cw; ++x) {
+        d[2 * x + 0] = su[x];
+        d[2 * x + 1] = sv[x];
+      }
+    }
+  }
+
+  /* YUV420BP (NV12) > YUV420P */
+  static void yuv420bp_to_yuv420p(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int w = (int)dst.width[0];
+    int cw = (int)dst.width[1];
+
+    for (int y = y0; y < y1; ++y) {
+      memcpy(dst.plane[0] + y * dst.stride[0], src.plane[0] + y * src.stride[0], w);
+    }
+
+    for (int cy = y0 / 2; cy < (y1 + 1) / 2 && (size_t)cy < dst.height[1]; ++cy) {
+      const uint8_t* s = src.plane[1] + cy * src.stride[1];
+      uint8_t* du = dst.plane[1] + cy * dst.stride[1];
+      uint8_t* dv = dst.plane[2] + cy * dst.stride[2];
+      for (int x = 0; x < cw; ++x) {
+        du[x] = s[2 * x + 0];
+        dv[x] = s[2 * x + 1];
+      }
+    }
+  }
+
+  /* RGB24 > 32bpp with R/G/B/A offsets. */
+  template<int R, int G, int B, int A>
+  static void rgb24_to_rgb32(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int w = (int)dst.width[0];
+
+    for (int y = y0; y < y1; ++y) {
+      const uint8_t* s = src.plane[0] + y * src.stride[0];
+      uint8_t* d = dst.plane[0] + y * dst.stride[0];
+      for (int x = 0; x < w; ++x) {
+        d[R] = s[0];
+        d[G] = s[1];
+        d[B] = s[2];
+        d[A] = 0xFF;
+        s += 3;
+        d += 4;
+      }
+    }
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  static ConvertKernel convert_kernels[] = {
+    { CA_YUYV422,  CA_YUV420P,  CA_CPU_SCALAR, packed422_to_yuv420p<0, 1, 2, 3> },
+    { CA_UYVY422,  CA_YUV420P,  CA_CPU_SCALAR, packed422_to_yuv420p<1, 0, 3, 2> },
+    { CA_YUYV422,  CA_YUV422P,  CA_CPU_SCALAR, packed422_to_yuv422p<0, 1, 2, 3> },
+    { CA_UYVY422,  CA_YUV422P,  CA_CPU_SCALAR, packed422_to_yuv422p<1, 0, 3, 2> },
+    { CA_YUYV422,  CA_BGRA32,   CA_CPU_SCALAR, packed422_to_rgb<0, 1, 2, 3,  2, 1, 0, 3, 4> },
+    { CA_YUYV422,  CA_RGBA32,   CA_CPU_SCALAR, packed422_to_rgb<0, 1, 2, 3,  0, 1, 2, 3, 4> },
+    { CA_YUYV422,  CA_RGB24,    CA_CPU_SCALAR, packed422_to_rgb<0, 1, 2, 3,  0, 1, 2, -1, 3> },
+    { CA_UYVY422,  CA_BGRA32,   CA_CPU_SCALAR, packed422_to_rgb<1, 0, 3, 2,  2, 1, 0, 3, 4> },
+    { CA_UYVY422,  CA_RGBA32,   CA_CPU_SCALAR, packed422_to_rgb<1, 0, 3, 2,  0, 1, 2, 3, 4> },
+    { CA_UYVY422,  CA_RGB24,    CA_CPU_SCALAR, packed422_to_rgb<1, 0, 3, 2,  0, 1, 2, -1, 3> },
+    { CA_YUV422P,  CA_YUV420P,  CA_CPU_SCALAR, yuv422p_to_yuv420p },
+    { CA_YUV420P,  CA_YUV420BP, CA_CPU_SCALAR, yuv420p_to_yuv420bp },
+    { CA_YUV420BP, CA_YUV420P,  CA_CPU_SCALAR, yuv420bp_to_yuv420p },
+    { CA_YUV420P,  CA_BGRA32,   CA_CPU_SCALAR, yuv420p_to_rgb<2, 1, 0, 3, 4> },
+    { CA_YUV420P,  CA_RGBA32,   CA_CPU_SCALAR, yuv420p_to_rgb<0, 1, 2, 3, 4> },
+    { CA_YUV420P,  CA_RGB24,    CA_CPU_SCALAR, yuv420p_to_rgb<0, 1, 2, -1, 3> },
+    { CA_RGB24,    CA_BGRA32,   CA_CPU_SCALAR, rgb24_to_rgb32<2, 1, 0, 3> },
+    { CA_RGB24,    CA_RGBA32,   CA_CPU_SCALAR, rgb24_to_rgb32<0, 1, 2, 3> }
+#if defined(CA_ARCH_X86)
+    ,{ CA_YUYV422,  CA_YUV420P,  CA_CPU_SSE2,   convert_yuyv422_to_yuv420p_sse2 }
+    ,{ CA_UYVY422,  CA_YUV420P,  CA_CPU_SSE2,   convert_uyvy422_to_yuv420p_sse2 }
+    ,{ CA_YUYV422,  CA_YUV422P,  CA_CPU_SSE2,   convert_yuyv422_to_yuv422p_sse2 }
+    ,{ CA_UYVY422,  CA_YUV422P,  CA_CPU_SSE2,   convert_uyvy422_to_yuv422p_sse2 }
+    ,{ CA_YUV420P,  CA_YUV420BP, CA_CPU_SSE2,   convert_yuv420p_to_yuv420bp_sse2 }
+    ,{ CA_YUV420BP, CA_YUV420P,  CA_CPU_SSE2,   convert_yuv420bp_to_yuv420p_sse2 }
+    ,{ CA_YUV420P,  CA_BGRA32,   CA_CPU_SSE2,   convert_yuv420p_to_bgra32_sse2 }
+    ,{ CA_YUV420P,  CA_RGBA32,   CA_CPU_SSE2,   convert_yuv420p_to_rgba32_sse2 }
+    ,{ CA_YUYV422,  CA_YUV420P,  CA_CPU_SSSE3,  convert_yuyv422_to_yuv420p_ssse3 }
+    ,{ CA_UYVY422,  CA_YUV420P,  CA_CPU_SSSE3,  convert_uyvy422_to_yuv420p_ssse3 }
+    ,{ CA_YUYV422,  CA_YUV422P,  CA_CPU_SSSE3,  convert_yuyv422_to_yuv422p_ssse3 }
+    ,{ CA_UYVY422,  CA_YUV422P,  CA_CPU_SSSE3,  convert_uyvy422_to_yuv422p_ssse3 }
+    /* The AVX2 packed 4:2:2 > planar kernels are memory bound and not faster than SSSE3 at 1080p (see test_kernel_benchmark); add them back when they are. */
+    /* ,{ CA_YUYV422,  CA_YUV420P,  CA_CPU_AVX2,   convert_yuyv422_to_yuv420p_avx2 } */
+    /* ,{ CA_UYVY422,  CA_YUV420P,  CA_CPU_AVX2,   convert_uyvy422_to_yuv420p_avx2 } */
+    /* ,{ CA_YUYV422,  CA_YUV422P,  CA_CPU_AVX2,   convert_yuyv422_to_yuv422p_avx2 } */
+    /* ,{ CA_UYVY422,  CA_YUV422P,  CA_CPU_AVX2,   convert_uyvy422_to_yuv422p_avx2 } */
+    ,{ CA_YUV420P,  CA_BGRA32,   CA_CPU_AVX2,   convert_yuv420p_to_bgra32_avx2 }
+    ,{ CA_YUV420P,  CA_RGBA32,   CA_CPU_AVX2,   convert_yuv420p_to_rgba32_avx2 }
+    ,{ CA_YUYV422,  CA_YUV420P,  CA_CPU_AVX512, convert_yuyv422_to_yuv420p_avx512 }
+    ,{ CA_UYVY422,  CA_YUV420P,  CA_CPU_AVX512, convert_uyvy422_to_yuv420p_avx512 }
+    ,{ CA_YUYV422,  CA_YUV422P,  CA_CPU_AVX512, convert_yuyv422_to_yuv422p_avx512 }
+    ,{ CA_UYVY422,  CA_YUV422P,  CA_CPU_AVX512, convert_uyvy422_to_yuv422p_avx512 }
+#elif defined(CA_ARCH_ARM)
+    ,{ CA_YUYV422,  CA_YUV420P,  CA_CPU_NEON,   convert_yuyv422_to_yuv420p_neon }
+    ,{ CA_UYVY422,  CA_YUV420P,  CA_CPU_NEON,   convert_uyvy422_to_yuv420p_neon }
+    ,{ CA_YUYV422,  CA_YUV422P,  CA_CPU_NEON,   convert_yuyv422_to_yuv422p_neon }
+    ,{ CA_UYVY422,  CA_YUV422P,  CA_CPU_NEON,   convert_uyvy422_to_yuv422p_neon }
+    ,{ CA_YUV420P,  CA_YUV420BP, CA_CPU_NEON,   convert_yuv420p_to_yuv420bp_neon }
+    ,{ CA_YUV420BP, CA_YUV420P,  CA_CPU_NEON,   convert_yuv420bp_to_yuv420p_neon }
+    ,{ CA_YUV420P,  CA_BGRA32,   CA_CPU_NEON,   convert_yuv420p_to_bgra32_neon }
+    ,{ CA_YUV420P,  CA_RGBA32,   CA_CPU_NEON,   convert_yuv420p_to_rgba32_neon }
+#endif
+  };
+
+  /* ------------------------------------------------------------------------- */
+
+  pixel_kernel convert_get_kernel(int srcfmt, int dstfmt) {
+    return convert_get_kernel(srcfmt, dstfmt, cpu_get_level());
+  }
+
+  pixel_kernel convert_get_kernel(int srcfmt, int dstfmt, int cpulevel) {
+
+    size_t n = sizeof(convert_kernels) / sizeof(convert_kernels[0]);
+    int best_level = -1;
+    pixel_kernel best = NULL;
+
+    if (false == cpu_supports_level(cpulevel)) {
+      return NULL;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+
+      const ConvertKernel& k = convert_kernels[i];
+
+      if (k.src_format != srcfmt || k.dst_format != dstfmt) {
+        continue;
+      }
+
+      if (false == convert_is_usable_at(k.cpu_level, cpulevel)) {
+        continue;
+      }
+
+      if (k.cpu_level > best_level) {
+        best_level = k.cpu_level;
+        best = k.kernel;
+      }
+    }
+
+    return best;
+  }
+
+  std::vector<ConvertKernel> convert_get_kernels() {
+    size_t n = sizeof(convert_kernels) / sizeof(convert_kernels[0]);
+    return std::vector<ConvertKernel>(convert_kernels, convert_kernels + n);
+  }
+
+  int convert(const PixelBuffer& src, PixelBuffer& dst, SliceScheduler* scheduler) {
+
+    if (src.width[0] != dst.width[0] || src.height[0] != dst.height[0]) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("cannot convert, the source is %d x %d and the destination is %d x %d.",
+                   (int)src.width[0], (int)src.height[0], (int)dst.width[0], (int)dst.height[0]);
+      return -1;
+    }
+
+    if (NULL == src.plane[0] || NULL == dst.plane[0]) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("cannot convert, the source or destination has no pixels.");
+      return -2;
+    }
+
+    pixel_kernel kernel = convert_get_kernel(src.pixel_format, dst.pixel_format);
+    if (NULL == kernel) {
+      error_set(CA_ERR_NOT_SUPPORTED, 0);
+      CA_LOG_ERROR("cannot convert from %s to %s.",
+                   format_to_string(src.pixel_format).c_str(),
+                   format_to_string(dst.pixel_format).c_str());
+      return -3;
+    }
+
+    if (NULL == scheduler) {
+      kernel(src, dst, 0, (int)dst.height[0]);
+      return 0;
+    }
+
+    return scheduler->run(kernel, src, dst);
+  }
+
+  int convert_selftest() {
+
+    /* Sizes that exercise the vector loops, the scalar tails and odd heights. */
+    static const int sizes[][3] = {
+      { 2, 1, 0 },  { 6, 3, 5 },  { 32, 2, 0 },  { 34, 5, 3 },
+      { 66, 4, 16 }, { 130, 7, 1 }, { 198, 9, 32 }, { 320, 16, 0 }
+    };
+
+    size_t nkernels = sizeof(convert_kernels) / sizeof(convert_kernels[0]);
+    size_t nsizes = sizeof(sizes) / sizeof(sizes[0]);
+    int failed = 0;
+
+    for (size_t i = 0; i < nkernels; ++i) {
+
+      const ConvertKernel& k = convert_kernels[i];
+
+      if (CA_CPU_SCALAR == k.cpu_level || false == cpu_supports_level(k.cpu_level)) {
+        continue;
+      }
+
+      pixel_kernel reference = convert_get_kernel(k.src_format, k.dst_format, CA_CPU_SCALAR);
+      if (NULL == reference) {
+        continue;
+      }
+
+      for (size_t j = 0; j < nsizes; ++j) {
+
+        int w = sizes[j][0];
+        int h = sizes[j][1];
+        int pad = sizes[j][2];
+        std::vector<uint8_t> src_mem, ref_mem, out_mem;
+        PixelBuffer src, ref, out;
+
+        convert_setup_padded(src, src_mem, w, h, k.src_format, pad);
+        convert_setup_padded(ref, ref_mem, w, h, k.dst_format, pad);
+        convert_setup_padded(out, out_mem, w, h, k.dst_format, pad);
+
+        srand((unsigned int)(i * 31 + j));
+        for (size_t b = 0; b < src_mem.size(); ++b) {
+          src_mem[b] = (uint8_t)(rand() & 0xFF);
+        }
+
+        reference(src, ref, 0, h);
+        k.kernel(src, out, 0, h);
+
+        if (false == convert_compare(ref, out)) {
+          printf("Error: the %s kernel for %s > %s differs from the scalar kernel at %d x %d (padding %d).\n",
+                 cpu_level_to_string(k.cpu_level).c_str(),
+                 format_to_string(k.src_format).c_str(),
+                 format_to_string(k.dst_format).c_str(),
+                 w, h, pad);
+          failed++;
+          break;
+        }
+      }
+    }
+
+    return failed;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  static bool convert_is_usable_at(int kernellevel, int cpulevel) {
+
+    if (CA_CPU_SCALAR == kernellevel) {
+      return true;
+    }
+
+    if (CA_CPU_NEON == kernellevel || CA_CPU_NEON == cpulevel) {
+      return kernellevel == cpulevel;
+    }
+
+    return kernellevel <= cpulevel;
+  }
+
+  static void convert_setup_padded(PixelBuffer& buf, std::vector<uint8_t>& mem, int w, int h, int fmt, int pad) {
+
+    size_t offset = 0;
+
+    buf.setup(w, h, fmt);
+
+    for (int i = 0; i < 3; ++i) {
+
+      if (0 == buf.stride[i]) {
+        continue;
+      }
+
+      size_t rows = (0 == buf.height[i]) ? buf.height[0] : buf.height[i];
+
+      buf.stride[i] += pad;
+      buf.offset[i] = offset;
+      offset += buf.stride[i] * rows;
+    }
+
+    buf.nbytes = offset;
+
+    /* Filled with a pattern so writes outside the visible area would show up in a padded compare. */
+    mem.assign(offset, 0xCD);
+    buf.setPixels(&mem[0]);
+  }
+
+  static bool convert_compare(const PixelBuffer& a, const PixelBuffer& b) {
+
+    if (a.nbytes != b.nbytes) {
+      return false;
+    }
+
+    /* The padding is compared as well, kernels must not write outside the rows. */
+    return 0 == memcmp(a.pixels, b.pixels, a.nbytes);
+  }
+
+} /* namespace ca */
@@ -0,0 +1,470 @@
+#include <stdio.h>
+#include <string.h>
+#include <set>
+#include <videocapture/Log.h>
+#include <videocapture/Error.h>
+#include <videocapture/Utils.h>
+#include <videocapture/ConvertPlan.h>
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  static ConvertPlanner default_planner;                                            /* The planner returned by `convert_get_planner()`. */
+
+  /* ------------------------------------------------------------------------- */
+
+  static double convert_bytes_per_pixel(int fmt);                                   /* Returns the average number of bytes per pixel of a frame in the given format. */
+  static void convert_copy(const PixelBuffer& src, PixelBuffer& dst);               /* Copies the rows of all planes; used when the source and destination format are the same. */
+
+  /* ------------------------------------------------------------------------- */
+
+  ConvertPlanner::ConvertPlanner()
+    :is_calibrated(false)
+  {
+    mutex_create(mutex);
+  }
+
+  ConvertPlanner::~ConvertPlanner() {
+    mutex_destroy(mutex);
+  }
+
+  int ConvertPlanner::calibrate(int width, int height) {
+
+    if (0 >= width || 0 >= height) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("cannot calibrate the conversion planner, invalid size: %d x %d.", width, height);
+      return -1;
+    }
+
+    mutex_lock(mutex);
+    {
+      createEdges();
+
+      for (size_t i = 0; i < edges.size(); ++i) {
+
+        ConvertEdge& edge = edges[i];
+        pixel_kernel kernel = convert_get_kernel(edge.src_format, edge.dst_format);
+        PixelBuffer src;
+        PixelBuffer dst;
+
+        if (NULL == kernel
+            || 0 != src.setup(width, height, edge.src_format)
+            || 0 != dst.setup(width, height, edge.dst_format))
+          {
+            continue;
+          }
+
+        std::vector<uint8_t> src_mem(src.nbytes);
+        std::vector<uint8_t> dst_mem(dst.nbytes);
+
+        for (size_t j = 0; j < src_mem.size(); ++j) {
+          src_mem[j] = (uint8_t)((j * 7) & 0xFF);
+        }
+
+        src.setPixels(&src_mem[0]);
+        dst.setPixels(&dst_mem[0]);
+
+        /* The first run warms up the caches; then we use the fastest of a few runs. */
+        uint64_t best = 0;
+
+        for (int run = 0; run < 4; ++run) {
+
+          uint64_t start = time_now_ns();
+          kernel(src, dst, 0, height);
+          uint64_t duration = time_now_ns() - start;
+
+          if (0 == run) {
+            continue;
+          }
+
+          if (0 == best || duration < best) {
+            best = duration;
+          }
+        }
+
+        edge.cost = (double)best / (double(width) * height);
+
+        /* Timers with a coarse resolution may measure 0; every hop must have some cost. */
+        if (edge.cost < 0.001) {
+          edge.cost = 0.001;
+        }
+      }
+
+      paths.clear();
+      unreachable.clear();
+      is_calibrated = true;
+    }
+    mutex_unlock(mutex);
+
+    return 0;
+  }
+
+  int ConvertPlanner::findPath(int srcfmt, int dstfmt, ConvertPath& result) {
+
+    int r = 0;
+    std::pair<int, int> key(srcfmt, dstfmt);
+
+    result.edges.clear();
+    result.cost = 0.0;
+
+    if (srcfmt == dstfmt) {
+      return 0;
+    }
+
+    mutex_lock(mutex);
+    {
+      if (0 == edges.size()) {
+        createEdges();
+      }
+
+      std::map<std::pair<int, int>, ConvertPath>::iterator it = paths.find(key);
+
+      if (it != paths.end()) {
+        result = it->second;
+      }
+      else if (unreachable.count(key)) {
+        r = -1;
+      }
+      else if (0 == dijkstra(srcfmt, dstfmt, result)) {
+        paths[key] = result;
+      }
+      else {
+        unreachable[key] = true;
+        r = -1;
+      }
+    }
+    mutex_unlock(mutex);
+
+    return r;
+  }
+
+  double ConvertPlanner::getCost(int srcfmt, int dstfmt) {
+
+    ConvertPath path;
+
+    if (0 != findPath(srcfmt, dstfmt, path)) {
+      return -1.0;
+    }
+
+    return path.cost;
+  }
+
+  bool ConvertPlanner::canConvert(int srcfmt, int dstfmt) {
+    return getCost(srcfmt, dstfmt) >= 0.0;
+  }
+
+  std::vector<ConvertEdge> ConvertPlanner::getEdges() {
+
+    std::vector<ConvertEdge> result;
+
+    mutex_lock(mutex);
+    {
+      if (0 == edges.size()) {
+        createEdges();
+      }
+      result = edges;
+    }
+    mutex_unlock(mutex);
+
+    return result;
+  }
+
+  void ConvertPlanner::createEdges() {
+
+    if (0 != edges.size()) {
+      return;
+    }
+
+    std::vector<ConvertKernel> kernels = convert_get_kernels();
+    std::set<std::pair<int, int> > added;
+
+    for (size_t i = 0; i < kernels.size(); ++i) {
+
+      std::pair<int, int> key(kernels[i].src_format, kernels[i].dst_format);
+
+      if (added.count(key)) {
+        continue;
+      }
+
+      ConvertEdge edge;
+      edge.src_format = key.first;
+      edge.dst_format = key.second;
+      edge.cost = convert_bytes_per_pixel(key.first) + convert_bytes_per_pixel(key.second);
+
+      edges.push_back(edge);
+      added.insert(key);
+    }
+  }
+
+  /* There are only a handful of formats, so we use the simple O(V^2) variant. */
+  int ConvertPlanner::dijkstra(int srcfmt, int dstfmt, ConvertPath& result) {
+
+    std::map<int, double> dist;
+    std::map<int, int> via;                                                         /* The edge that we used to reach a format. */
+    std::set<int> done;
+
+    dist[srcfmt] = 0.0;
+
+    while (true) {
+
+      int current = CA_NONE;
+      double current_dist = 0.0;
+
+      for (std::map<int, double>::iterator it = dist.begin(); it != dist.end(); ++it) {
+        if (done.count(it->first)) {
+          continue;
+        }
+        if (CA_NONE == current || it->second < current_dist) {
+          current = it->first;
+          current_dist = it->second;
+        }
+      }
+
+      if (CA_NONE == current) {
+        return -1;
+      }
+
+      if (current == dstfmt) {
+        break;
+      }
+
+      done.insert(current);
+
+      for (size_t i = 0; i < edges.size(); ++i) {
+
+        if (edges[i].src_format != current) {
+          continue;
+        }
+
+        int next = edges[i].dst_format;
+        double d = current_dist + edges[i].cost;
+
+        if (0 == dist.count(next) || d < dist[next]) {
+          dist[next] = d;
+          via[next] = (int)i;
+        }
+      }
+    }
+
+    /* Walk back from the destination. */
+    int fmt = dstfmt;
+
+    while (fmt != srcfmt) {
+      int edge = via[fmt];
+      result.edges.insert(result.edges.begin(), edge);
+      fmt = edges[edge].src_format;
+    }
+
+    result.cost = dist[dstfmt];
+
+    return 0;
+  }
+
+  ConvertPlanner& convert_get_planner() {
+    return default_planner;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  ConvertPlan::ConvertPlan()
+    :src_format(CA_NONE)
+    ,dst_format(CA_NONE)
+    ,width(0)
+    ,height(0)
+    ,cost(0.0)
+    ,is_init(false)
+  {
+  }
+
+  ConvertPlan::~ConvertPlan() {
+    shutdown();
+  }
+
+  int ConvertPlan::init(int srcfmt, int dstfmt, int w, int h, ConvertPlanner* planner) {
+
+    ConvertPath path;
+
+    if (true == is_init) {
+      shutdown();
+    }
+
+    if (0 >= w || 0 >= h) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("cannot init the conversion plan, invalid size: %d x %d.", w, h);
+      return -1;
+    }
+
+    if (NULL == planner) {
+      planner = &convert_get_planner();
+    }
+
+    if (0 != planner->findPath(srcfmt, dstfmt, path)) {
+      error_set(CA_ERR_NOT_SUPPORTED, 0);
+      CA_LOG_ERROR("cannot init the conversion plan, there is no way to convert from %s to %s.",
+                   format_to_string(srcfmt).c_str(),
+                   format_to_string(dstfmt).c_str());
+      return -2;
+    }
+
+    std::vector<ConvertEdge> edges = planner->getEdges();
+
+    for (size_t i = 0; i < path.edges.size(); ++i) {
+
+      const ConvertEdge& edge = edges[path.edges[i]];
+      pixel_kernel kernel = convert_get_kernel(edge.src_format, edge.dst_format);
+
+      if (NULL == kernel) {
+        error_set(CA_ERR_NOT_SUPPORTED, 0);
+        CA_LOG_ERROR("cannot init the conversion plan, no kernel for %s > %s.",
+                     format_to_string(edge.src_format).c_str(),
+                     format_to_string(edge.dst_format).c_str());
+        shutdown();
+        return -3;
+      }
+
+      kernels.push_back(kernel);
+
+      /* The last kernel writes into the destination buffer of `execute()`. */
+      if (i + 1 == path.edges.size()) {
+        continue;
+      }
+
+      PixelBuffer buf;
+
+      if (0 != buf.setup(w, h, edge.dst_format)) {
+        error_set(CA_ERR_NO_MEMORY, 0);
+        CA_LOG_ERROR("cannot init the conversion plan, failed to setup the intermediate %s buffer.",
+                     format_to_string(edge.dst_format).c_str());
+        shutdown();
+        return -4;
+      }
+
+      uint8_t* data = new uint8_t[buf.nbytes];
+      buf.setPixels(data);
+
+      memory.push_back(data);
+      intermediates.push_back(buf);
+    }
+
+    src_format = srcfmt;
+    dst_format = dstfmt;
+    width = w;
+    height = h;
+    cost = path.cost;
+    is_init = true;
+
+    return 0;
+  }
+
+  int ConvertPlan::shutdown() {
+
+    for (size_t i = 0; i < memory.size(); ++i) {
+      delete[] memory[i];
+    }
+
+    memory.clear();
+    intermediates.clear();
+    kernels.clear();
+
+    src_format = CA_NONE;
+    dst_format = CA_NONE;
+    width = 0;
+    height = 0;
+    cost = 0.0;
+    is_init = false;
+
+    return 0;
+  }
+
+  int ConvertPlan::execute(const PixelBuffer& src, PixelBuffer& dst, SliceScheduler* scheduler) {
+
+    if (false == is_init) {
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_ERROR("cannot execute the conversion plan, not initialized.");
+      return -1;
+    }
+
+    if (src.pixel_format != src_format || dst.pixel_format != dst_format) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("cannot execute the conversion plan, it converts %s > %s but we got %s > %s.",
+                   format_to_string(src_format).c_str(),
+                   format_to_string(dst_format).c_str(),
+                   format_to_string(src.pixel_format).c_str(),
+                   format_to_string(dst.pixel_format).c_str());
+      return -2;
+    }
+
+    if ((int)src.width[0] != width || (int)src.height[0] != height
+        || (int)dst.width[0] != width || (int)dst.height[0] != height)
+      {
+        error_set(CA_ERR_INVALID_ARGUMENT, 0);
+        CA_LOG_ERROR("cannot execute the conversion plan, it was planned for %d x %d.", width, height);
+        return -3;
+      }
+
+    if (0 == kernels.size()) {
+      convert_copy(src, dst);
+      return 0;
+    }
+
+    const PixelBuffer* in = &src;
+
+    for (size_t i = 0; i < kernels.size(); ++i) {
+
+      PixelBuffer* out = (i + 1 == kernels.size()) ? &dst : &intermediates[i];
+
+      if (NULL == scheduler) {
+        kernels[i](*in, *out, 0, height);
+      }
+      else if (0 != scheduler->run(kernels[i], *in, *out)) {
+        return -4;
+      }
+
+      in = out;
+    }
+
+    return 0;
+  }
+
+  size_t ConvertPlan::getNumSteps() {
+    return kernels.size();
+  }
+
+  double ConvertPlan::getCost() {
+    return cost;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  static double convert_bytes_per_pixel(int fmt) {
+
+    PixelBuffer buf;
+
+    if (0 != buf.setup(16, 16, fmt) || 0 == buf.nbytes) {
+      return 4.0;
+    }
+
+    return (double)buf.nbytes / (16.0 * 16.0);
+  }
+
+  static void convert_copy(const PixelBuffer& src, PixelBuffer& dst) {
+
+    PixelBuffer tight;
+    tight.setup((int)src.width[0], (int)src.height[0], src.pixel_format);
+
+    for (int i = 0; i < 3; ++i) {
+
+      if (NULL == src.plane[i] || NULL == dst.plane[i]) {
+        continue;
+      }
+
+      size_t rows = (0 == src.height[i]) ? src.height[0] : src.height[i];
+
+      for (size_t y = 0; y < rows; ++y) {
+        memcpy(dst.plane[i] + y * dst.stride[i], src.plane[i] + y * src.stride[i], tight.stride[i]);
+      }
+    }
+  }
+
+} /* namespace ca */
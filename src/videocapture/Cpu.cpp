@@ -0,0 +1,220 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <videocapture/Cpu.h>
+
+#if defined(CA_ARCH_X86)
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  else
+#    include <cpuid.h>
+#  endif
+#elif defined(CA_ARCH_ARM) && defined(__linux) && !defined(__aarch64__)
+#  include <sys/auxv.h>
+#  ifndef HWCAP_NEON
+#    define HWCAP_NEON (1 << 12)
+#  endif
+#endif
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  static int cpu_detected_level = CA_NONE;                                          /* Cached result of `cpu_detect_level()`. */
+  static int cpu_used_level = CA_NONE;                                              /* The level used for dispatching; set on first use. */
+
+#if defined(CA_ARCH_X86)
+  static void cpu_cpuid(int leaf, int sub, unsigned int regs[4]);                   /* Executes cpuid and stores eax, ebx, ecx, edx. */
+  static uint64_t cpu_xgetbv();                                                     /* Returns XCR0, which tells what register state the OS saves. */
+#endif
+
+  /* ------------------------------------------------------------------------- */
+
+  int cpu_detect_level() {
+
+    if (CA_NONE != cpu_detected_level) {
+      return cpu_detected_level;
+    }
+
+    int level = CA_CPU_SCALAR;
+
+#if defined(CA_ARCH_X86)
+
+    unsigned int regs[4] = { 0 };
+    unsigned int max_leaf = 0;
+
+    cpu_cpuid(0, 0, regs);
+    max_leaf = regs[0];
+
+    if (max_leaf >= 1) {
+
+      cpu_cpuid(1, 0, regs);
+
+      bool has_sse2 = (regs[3] & (1u << 26)) != 0;
+      bool has_ssse3 = (regs[2] & (1u << 9)) != 0;
+      bool has_osxsave = (regs[2] & (1u << 27)) != 0;
+      bool has_avx = (regs[2] & (1u << 28)) != 0;
+      uint64_t xcr0 = (has_osxsave) ? cpu_xgetbv() : 0;
+      bool os_avx = (xcr0 & 0x06) == 0x06;
+      bool os_avx512 = (xcr0 & 0xE6) == 0xE6;
+
+      if (has_sse2) {
+        level = CA_CPU_SSE2;
+      }
+
+      if (has_sse2 && has_ssse3) {
+        level = CA_CPU_SSSE3;
+      }
+
+      if (CA_CPU_SSSE3 == level && has_avx && os_avx && max_leaf >= 7) {
+
+        cpu_cpuid(7, 0, regs);
+
+        bool has_avx2 = (regs[1] & (1u << 5)) != 0;
+        bool has_avx512f = (regs[1] & (1u << 16)) != 0;
+        bool has_avx512bw = (regs[1] & (1u << 30)) != 0;
+
+        if (has_avx2) {
+          level = CA_CPU_AVX2;
+        }
+
+        if (has_avx2 && has_avx512f && has_avx512bw && os_avx512) {
+          level = CA_CPU_AVX512;
+        }
+      }
+    }
+
+#elif defined(CA_ARCH_ARM)
+
+#  if defined(__aarch64__)
+    level = CA_CPU_NEON;
+#  elif defined(__linux)
+    if (getauxval(AT_HWCAP) & HWCAP_NEON) {
+      level = CA_CPU_NEON;
+    }
+#  endif
+
+#endif
+
+    cpu_detected_level = level;
+
+    return level;
+  }
+
+  int cpu_get_level() {
+
+    if (CA_NONE != cpu_used_level) {
+      return cpu_used_level;
+    }
+
+    int level = cpu_detect_level();
+    const char* env = getenv("CA_CPU_LEVEL");
+
+    if (NULL != env) {
+
+      int forced = cpu_level_from_string(env);
+
+      if (CA_NONE == forced) {
+        printf("Warning: unknown CA_CPU_LEVEL: %s, using: %s.\n", env, cpu_level_to_string(level).c_str());
+      }
+      else if (false == cpu_supports_level(forced)) {
+        printf("Warning: CA_CPU_LEVEL %s is not supported by this CPU, using: %s.\n", env, cpu_level_to_string(level).c_str());
+      }
+      else {
+        level = forced;
+      }
+    }
+
+    cpu_used_level = level;
+
+    return level;
+  }
+
+  int cpu_set_level(int level) {
+
+    if (CA_NONE == level) {
+      cpu_used_level = cpu_detect_level();
+      return 0;
+    }
+
+    if (false == cpu_supports_level(level)) {
+      printf("Error: cannot set the cpu level to %s, not supported by this CPU.\n", cpu_level_to_string(level).c_str());
+      return -1;
+    }
+
+    cpu_used_level = level;
+
+    return 0;
+  }
+
+  bool cpu_supports_level(int level) {
+
+    int detected = cpu_detect_level();
+
+    if (CA_CPU_SCALAR == level) {
+      return true;
+    }
+
+    if (CA_CPU_NEON == level) {
+      return CA_CPU_NEON == detected;
+    }
+
+    if (CA_CPU_NEON == detected || level < 0) {
+      return false;
+    }
+
+    return level <= detected;
+  }
+
+  std::string cpu_level_to_string(int level) {
+    switch (level) {
+      case CA_CPU_SCALAR:   return "scalar";
+      case CA_CPU_SSE2:     return "sse2";
+      case CA_CPU_SSSE3:    return "ssse3";
+      case CA_CPU_AVX2:     return "avx2";
+      case CA_CPU_AVX512:   return "avx512";
+      case CA_CPU_NEON:     return "neon";
+      default:              return "unknown";
+    }
+  }
+
+  int cpu_level_from_string(const std::string& name) {
+    if (name == "scalar") { return CA_CPU_SCALAR; }
+    if (name == "sse2")   { return CA_CPU_SSE2;   }
+    if (name == "ssse3")  { return CA_CPU_SSSE3;  }
+    if (name == "avx2")   { return CA_CPU_AVX2;   }
+    if (name == "avx512") { return CA_CPU_AVX512; }
+    if (name == "neon")   { return CA_CPU_NEON;   }
+    return CA_NONE;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+#if defined(CA_ARCH_X86)
+
+  static void cpu_cpuid(int leaf, int sub, unsigned int regs[4]) {
+#  if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, leaf, sub);
+    regs[0] = r[0];
+    regs[1] = r[1];
+    regs[2] = r[2];
+    regs[3] = r[3];
+#  else
+    __cpuid_count(leaf, sub, regs[0], regs[1], regs[2], regs[3]);
+#  endif
+  }
+
+  static uint64_t cpu_xgetbv() {
+#  if defined(_MSC_VER)
+    return _xgetbv(0);
+#  else
+    unsigned int eax = 0;
+    unsigned int edx = 0;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+#  endif
+  }
+
+#endif
+
+} /* namespace ca */
@@ -0,0 +1,225 @@
+#include <stdio.h>
+#include <videocapture/Utils.h>
+#include <videocapture/Trace.h>
+#include <videocapture/EncoderSink.h>
+#include <videocapture/X264Encoder.h>
+#include <videocapture/X265Encoder.h>
+#include <videocapture/MkvWriter.h>
+#include <videocapture/Mp4Writer.h>
+
+namespace ca {
+
+  EncoderSink::EncoderSink()
+    :scheduler(NULL)
+    ,encoder(NULL)
+    ,writer(NULL)
+    ,input_format(CA_NONE)
+    ,width(0)
+    ,height(0)
+    ,is_zero_copy(false)
+  {
+  }
+
+  EncoderSink::~EncoderSink() {
+    if (NULL != writer) {
+      close();
+    }
+    scheduler = NULL;
+  }
+
+  int EncoderSink::open(const std::string& filepath, int container, int w, int h, int fmt, int fps, const EncoderSettings& cfg) {
+
+    int r = 0;
+
+    if (NULL != writer) {
+      printf("Error: cannot open %s, the encoder sink is already open.\n", filepath.c_str());
+      return -1;
+    }
+
+    if (CA_H264 == cfg.codec) {
+      encoder = new X264Encoder();
+    }
+    else if (CA_H265 == cfg.codec) {
+      encoder = new X265Encoder();
+    }
+    else {
+      printf("Error: the encoder sink can only encode CA_H264 and CA_H265, not %s.\n", format_to_string(cfg.codec).c_str());
+      return -2;
+    }
+
+    if (CA_CONTAINER_MKV == container) {
+      writer = new MkvWriter();
+    }
+    else if (CA_CONTAINER_MP4 == container) {
+      writer = new Mp4Writer();
+    }
+    else {
+      printf("Error: cannot store %s in container %d.\n", format_to_string(cfg.codec).c_str(), container);
+      r = -3;
+      goto error;
+    }
+
+    /* Pass the frames as they are when we can, otherwise convert them into I420. */
+    is_zero_copy = encoder->canEncode(fmt);
+
+    if (false == is_zero_copy) {
+
+      if (0 != convert_plan.init(fmt, CA_YUV420P, w, h)) {
+        printf("Error: cannot convert %s into CA_YUV420P for the encoder.\n", format_to_string(fmt).c_str());
+        r = -4;
+        goto error;
+      }
+
+      if (0 != convert_pool.init(w, h, CA_YUV420P, 1)) {
+        r = -5;
+        goto error;
+      }
+    }
+
+    if (0 != encoder->open(w, h, fps, (true == is_zero_copy) ? fmt : CA_YUV420P, cfg)) {
+      r = -6;
+      goto error;
+    }
+
+    writer->setCodecPrivate(&encoder->codec_private[0], encoder->codec_private.size());
+
+    if (0 != writer->open(filepath, w, h, cfg.codec, fps)) {
+      r = -7;
+      goto error;
+    }
+
+    input_format = fmt;
+    width = w;
+    height = h;
+
+    return 0;
+
+  error:
+
+    convert_plan.shutdown();
+    convert_pool.shutdown();
+
+    delete encoder;
+    encoder = NULL;
+
+    delete writer;
+    writer = NULL;
+
+    return r;
+  }
+
+  int EncoderSink::close() {
+
+    int r = 0;
+
+    if (NULL == writer) {
+      printf("Error: cannot close the encoder sink, it's not open.\n");
+      return -1;
+    }
+
+    /* Get the frames that the encoder still holds. */
+    while (1 == (r = encode(NULL, 0))) {
+    }
+
+    if (0 != writer->close()) {
+      r = -2;
+    }
+
+    encoder->close();
+    convert_plan.shutdown();
+    convert_pool.shutdown();
+
+    delete encoder;
+    encoder = NULL;
+
+    delete writer;
+    writer = NULL;
+
+    input_format = CA_NONE;
+    width = 0;
+    height = 0;
+    is_zero_copy = false;
+
+    return (0 > r) ? r : 0;
+  }
+
+  int EncoderSink::write(PixelBuffer& buffer) {
+
+    PixelBuffer* converted = NULL;
+    uint64_t timestamp = (0 != buffer.timestamp) ? buffer.timestamp : time_now_ns();
+    int r = 0;
+
+    CA_TRACE_SCOPE("sink.write", buffer.sequence);
+
+    if (NULL == writer) {
+      printf("Error: cannot write a frame, the encoder sink isn't open.\n");
+      return -1;
+    }
+
+    if (buffer.pixel_format != input_format || (int)buffer.width[0] != width || (int)buffer.height[0] != height) {
+      printf("Error: the encoder sink expects %d x %d %s frames.\n", width, height, format_to_string(input_format).c_str());
+      return -2;
+    }
+
+    if (true == is_zero_copy) {
+      return (0 > encode(&buffer, timestamp)) ? -3 : 0;
+    }
+
+    converted = convert_pool.acquire();
+    if (NULL == converted) {
+      printf("Error: no free buffer to convert into; dropping a frame.\n");
+      return -4;
+    }
+
+    if (0 != convert_plan.execute(buffer, *converted, scheduler)) {
+      convert_pool.release(converted);
+      return -5;
+    }
+
+    r = encode(converted, timestamp);
+    convert_pool.release(converted);
+
+    return (0 > r) ? -3 : 0;
+  }
+
+  bool EncoderSink::isZeroCopy() {
+    return is_zero_copy;
+  }
+
+  int EncoderSink::getNumThreads() {
+
+    if (NULL == encoder) {
+      return 0;
+    }
+
+    return encoder->getNumThreads();
+  }
+
+  uint64_t EncoderSink::getNumFrames() {
+
+    if (NULL == writer) {
+      return 0;
+    }
+
+    return writer->getNumFrames();
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  /* Without B-frames at most one frame comes out per picture, but when flushing we're called until there's none left. */
+  int EncoderSink::encode(const PixelBuffer* pic, uint64_t timestamp) {
+
+    int r = encoder->encode(pic, timestamp, frame);
+
+    if (1 != r) {
+      return r;
+    }
+
+    if (0 != writer->writeFrame(frame.chunks, frame.num_chunks, frame.timestamp, frame.keyframe)) {
+      return -10;
+    }
+
+    return 1;
+  }
+
+} /* namespace ca */
@@ -0,0 +1,68 @@
+#include <errno.h>
+#include <videocapture/Error.h>
+
+#if defined(_MSC_VER)
+#  define CA_ERROR_THREAD_LOCAL __declspec(thread)
+#else
+#  define CA_ERROR_THREAD_LOCAL __thread
+#endif
+
+namespace ca {
+
+  static CA_ERROR_THREAD_LOCAL int error_code = CA_ERR_NONE;
+  static CA_ERROR_THREAD_LOCAL int error_system = 0;
+
+  /* ------------------------------------------------------------------------- */
+
+  void error_set(int code, int sys_error) {
+    error_code = code;
+    error_system = sys_error;
+  }
+
+  void error_set_system(int sys_error) {
+
+    int code = CA_ERR_SYSTEM;
+
+    switch (sys_error) {
+      case EINVAL: code = CA_ERR_INVALID_ARGUMENT; break;
+      case ENOENT: code = CA_ERR_NOT_FOUND; break;
+      case ENOMEM: code = CA_ERR_NO_MEMORY; break;
+      case EIO: code = CA_ERR_IO; break;
+      case ENODEV: code = CA_ERR_DEVICE_LOST; break;
+      case ENXIO: code = CA_ERR_DEVICE_LOST; break;
+      case EBUSY: code = CA_ERR_BUSY; break;
+      default: break;
+    }
+
+    error_set(code, sys_error);
+  }
+
+  void error_clear() {
+    error_set(CA_ERR_NONE, 0);
+  }
+
+  int error_get_code() {
+    return error_code;
+  }
+
+  int error_get_system() {
+    return error_system;
+  }
+
+  const char* error_to_string(int code) {
+    switch (code) {
+      case CA_ERR_NONE: return "no error";
+      case CA_ERR_INVALID_ARGUMENT: return "invalid argument";
+      case CA_ERR_INVALID_STATE: return "invalid state";
+      case CA_ERR_NOT_FOUND: return "not found";
+      case CA_ERR_NOT_SUPPORTED: return "not supported";
+      case CA_ERR_SYSTEM: return "system call failed";
+      case CA_ERR_IO: return "I/O error";
+      case CA_ERR_DEVICE_LOST: return "device lost";
+      case CA_ERR_NO_MEMORY: return "out of memory";
+      case CA_ERR_BUSY: return "device busy";
+      default: return "unknown error";
+    }
+  }
+
+} /* namespace ca */
@@ -0,0 +1,339 @@
+/* 64 bit file offsets for fseeko() on 32 bit Linux (e.g. the Raspberry PI). */
+#if !defined(_WIN32) && !defined(_FILE_OFFSET_BITS)
+#  define _FILE_OFFSET_BITS 64
+#endif
+
+#include <string.h>
+#include <videocapture/FileWriter.h>
+#include <videocapture/Trace.h>
+
+namespace ca {
+
+  FileWriter::FileWriter()
+    :fp(NULL)
+    ,buffer_used(0)
+    ,buffer_offset(0)
+  {
+  }
+
+  FileWriter::~FileWriter() {
+    if (NULL != fp) {
+      close();
+    }
+  }
+
+  int FileWriter::open(const std::string& filepath, size_t buffersize) {
+
+    if (NULL != fp) {
+      printf("Error: cannot open %s, the file writer already has a file open.\n", filepath.c_str());
+      return -1;
+    }
+
+    if (0 == buffersize) {
+      printf("Error: cannot open %s, invalid buffer size.\n", filepath.c_str());
+      return -2;
+    }
+
+    fp = fopen(filepath.c_str(), "wb");
+    if (NULL == fp) {
+      printf("Error: cannot open %s for writing.\n", filepath.c_str());
+      return -3;
+    }
+
+    /* We do the buffering ourself. */
+    setvbuf(fp, NULL, _IONBF, 0);
+
+    buffer.resize(buffersize);
+    buffer_used = 0;
+    buffer_offset = 0;
+
+    return 0;
+  }
+
+  int FileWriter::close() {
+
+    int r = 0;
+
+    if (NULL == fp) {
+      printf("Error: cannot close the file writer, no file open.\n");
+      return -1;
+    }
+
+    if (0 != flush()) {
+      r = -2;
+    }
+
+    if (0 != fclose(fp)) {
+      printf("Error: failed to close the file.\n");
+      r = -3;
+    }
+
+    fp = NULL;
+    buffer.clear();
+    buffer_used = 0;
+    buffer_offset = 0;
+
+    return r;
+  }
+
+  int FileWriter::write(const void* data, size_t nbytes) {
+
+    if (NULL == fp) {
+      printf("Error: cannot write, no file open.\n");
+      return -1;
+    }
+
+    if (0 == nbytes) {
+      return 0;
+    }
+
+    if (buffer_used + nbytes > buffer.size()) {
+
+      if (0 != flush()) {
+        return -2;
+      }
+
+      /* Too large to buffer: write directly. */
+      if (nbytes > buffer.size()) {
+
+        CA_TRACE_SCOPE("file.write", nbytes);
+
+        if (nbytes != fwrite(data, 1, nbytes, fp)) {
+          printf("Error: failed to write %d bytes.\n", (int)nbytes);
+          return -3;
+        }
+
+        buffer_offset += nbytes;
+
+        return 0;
+      }
+    }
+
+    memcpy(&buffer[buffer_used], data, nbytes);
+    buffer_used += nbytes;
+
+    return 0;
+  }
+
+  int FileWriter::write(const DataChunk* chunks, int nchunks) {
+
+    for (int i = 0; i < nchunks; ++i) {
+      if (0 != write(chunks[i].data, chunks[i].nbytes)) {
+        return -1;
+      }
+    }
+
+    return 0;
+  }
+
+  int FileWriter::writeZeros(size_t nbytes) {
+
+    static const uint8_t zeros[256] = { 0 };
+
+    while (0 != nbytes) {
+
+      size_t n = (nbytes > sizeof(zeros)) ? sizeof(zeros) : nbytes;
+
+      if (0 != write(zeros, n)) {
+        return -1;
+      }
+
+      nbytes -= n;
+    }
+
+    return 0;
+  }
+
+  int FileWriter::writeU8(uint8_t v) {
+    return write(&v, 1);
+  }
+
+  int FileWriter::writeU16(uint16_t v) {
+
+    uint8_t b[2];
+
+    b[0] = (uint8_t)(v & 0xFF);
+    b[1] = (uint8_t)((v >> 8) & 0xFF);
+
+    return write(b, sizeof(b));
+  }
+
+  int FileWriter::writeU32(uint32_t v) {
+
+    uint8_t b[4];
+
+    for (int i = 0; i < 4; ++i) {
+      b[i] = (uint8_t)((v >> (8 * i)) & 0xFF);
+    }
+
+    return write(b, sizeof(b));
+  }
+
+  int FileWriter::writeU64(uint64_t v) {
+
+    uint8_t b[8];
+
+    for (int i = 0; i < 8; ++i) {
+      b[i] = (uint8_t)((v >> (8 * i)) & 0xFF);
+    }
+
+    return write(b, sizeof(b));
+  }
+
+  int FileWriter::writeU16BE(uint16_t v) {
+
+    uint8_t b[2];
+
+    b[0] = (uint8_t)((v >> 8) & 0xFF);
+    b[1] = (uint8_t)(v & 0xFF);
+
+    return write(b, sizeof(b));
+  }
+
+  int FileWriter::writeU32BE(uint32_t v) {
+
+    uint8_t b[4];
+
+    for (int i = 0; i < 4; ++i) {
+      b[i] = (uint8_t)((v >> (24 - 8 * i)) & 0xFF);
+    }
+
+    return write(b, sizeof(b));
+  }
+
+  int FileWriter::writeU64BE(uint64_t v) {
+
+    uint8_t b[8];
+
+    for (int i = 0; i < 8; ++i) {
+      b[i] = (uint8_t)((v >> (56 - 8 * i)) & 0xFF);
+    }
+
+    return write(b, sizeof(b));
+  }
+
+  int FileWriter::writeFourCC(const char* fourcc) {
+    return write(fourcc, 4);
+  }
+
+  int FileWriter::patch(uint64_t offset, const void* data, size_t nbytes) {
+
+    const uint8_t* src = (const uint8_t*)data;
+
+    if (NULL == fp) {
+      printf("Error: cannot patch, no file open.\n");
+      return -1;
+    }
+
+    if (offset + nbytes > tell()) {
+      printf("Error: cannot patch bytes that weren't written yet.\n");
+      return -2;
+    }
+
+    /* The part that's still in the buffer. */
+    if (offset + nbytes > buffer_offset) {
+
+      size_t skip = (offset >= buffer_offset) ? 0 : (size_t)(buffer_offset - offset);
+      size_t pos = (size_t)(offset + skip - buffer_offset);
+
+      memcpy(&buffer[pos], src + skip, nbytes - skip);
+
+      nbytes = skip;
+    }
+
+    /* The part that's on disk. */
+    if (0 != nbytes) {
+
+      if (0 != seek(offset)) {
+        return -3;
+      }
+
+      if (nbytes != fwrite(src, 1, nbytes, fp)) {
+        printf("Error: failed to patch %d bytes.\n", (int)nbytes);
+        seek(buffer_offset);
+        return -4;
+      }
+
+      if (0 != seek(buffer_offset)) {
+        return -5;
+      }
+    }
+
+    return 0;
+  }
+
+  int FileWriter::patchU32(uint64_t offset, uint32_t v) {
+
+    uint8_t b[4];
+
+    for (int i = 0; i < 4; ++i) {
+      b[i] = (uint8_t)((v >> (8 * i)) & 0xFF);
+    }
+
+    return patch(offset, b, sizeof(b));
+  }
+
+  int FileWriter::patchU64(uint64_t offset, uint64_t v) {
+
+    uint8_t b[8];
+
+    for (int i = 0; i < 8; ++i) {
+      b[i] = (uint8_t)((v >> (8 * i)) & 0xFF);
+    }
+
+    return patch(offset, b, sizeof(b));
+  }
+
+  int FileWriter::patchU32BE(uint64_t offset, uint32_t v) {
+
+    uint8_t b[4];
+
+    for (int i = 0; i < 4; ++i) {
+      b[i] = (uint8_t)((v >> (24 - 8 * i)) & 0xFF);
+    }
+
+    return patch(offset, b, sizeof(b));
+  }
+
+  int FileWriter::flush() {
+
+    if (NULL == fp) {
+      return -1;
+    }
+
+    if (0 == buffer_used) {
+      return 0;
+    }
+
+    CA_TRACE_SCOPE("file.write", buffer_used);
+
+    if (buffer_used != fwrite(&buffer[0], 1, buffer_used, fp)) {
+      printf("Error: failed to write %d bytes.\n", (int)buffer_used);
+      return -2;
+    }
+
+    buffer_offset += buffer_used;
+    buffer_used = 0;
+
+    return 0;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  int FileWriter::seek(uint64_t offset) {
+
+#if defined(_WIN32)
+    int r = _fseeki64(fp, (__int64)offset, SEEK_SET);
+#else
+    int r = fseeko(fp, (off_t)offset, SEEK_SET);
+#endif
+
+    if (0 != r) {
+      printf("Error: cannot seek to %llu.\n", (unsigned long long)offset);
+      return -1;
+    }
+
+    return 0;
+  }
+
+} /* namespace ca */
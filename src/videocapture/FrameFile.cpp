@@ -0,0 +1,59 @@
+#include <stdio.h>
+#include <videocapture/Utils.h>
+#include <videocapture/FrameFile.h>
+
+namespace ca {
+
+  FrameFileHeader::FrameFileHeader()
+    :pixel_format(CA_NONE)
+    ,width(0)
+    ,height(0)
+    ,fps(CA_NONE)
+    ,compression(CA_COMPRESS_NONE)
+    ,filter(CA_FILTER_NONE)
+    ,alignment(CA_FRAME_FILE_ALIGNMENT)
+    ,num_planes(0)
+    ,num_frames(0)
+    ,index_offset(0)
+  {
+    for (int i = 0; i < CA_FRAME_FILE_MAX_PLANES; ++i) {
+      plane_stride[i] = 0;
+      plane_height[i] = 0;
+    }
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  int frame_file_get_layout(int width, int height, int fmt, FrameFileHeader& hdr) {
+
+    PixelBuffer layout;
+
+    if (CA_MJPEG == fmt || CA_JPEG_OPENDML == fmt || CA_H264 == fmt || CA_H265 == fmt) {
+      printf("Error: a frame file stores raw frames, not %s.\n", format_to_string(fmt).c_str());
+      return -1;
+    }
+
+    /* The tight strides of `setup()` are exactly how we store the planes. */
+    if (0 != layout.setup(width, height, fmt)) {
+      return -2;
+    }
+
+    hdr.pixel_format = fmt;
+    hdr.width = width;
+    hdr.height = height;
+    hdr.num_planes = 0;
+
+    for (int i = 0; i < CA_FRAME_FILE_MAX_PLANES; ++i) {
+
+      hdr.plane_stride[i] = (uint32_t)layout.stride[i];
+      hdr.plane_height[i] = (0 == layout.stride[i]) ? 0 : (uint32_t)layout.height[i];
+
+      if (0 != layout.stride[i]) {
+        hdr.num_planes++;
+      }
+    }
+
+    return 0;
+  }
+
+} /* namespace ca */
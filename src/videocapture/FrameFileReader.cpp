@@ -0,0 +1,609 @@
+/* 64 bit file offsets for mmap() on 32 bit Linux (e.g. the Raspberry PI). */
+#if !defined(_WIN32) && !defined(_FILE_OFFSET_BITS)
+#  define _FILE_OFFSET_BITS 64
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <videocapture/Log.h>
+#include <videocapture/Error.h>
+#include <videocapture/FrameFileReader.h>
+#include <videocapture/LosslessCodec.h>
+
+#if defined(_WIN32)
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  static uint32_t read_u32(const uint8_t* p);
+  static uint64_t read_u64(const uint8_t* p);
+
+  /* ------------------------------------------------------------------------- */
+
+  FrameFileReader::FrameFileReader()
+    :mapping(NULL)
+    ,mapping_size(0)
+    ,file_handle(NULL)
+    ,mapping_handle(NULL)
+    ,fd(-1)
+    ,frame_nbytes(0)
+    ,decoded_index(0)
+    ,has_decoded(false)
+    ,is_zero_copy(false)
+    ,is_recovered(false)
+  {
+    for (int i = 0; i < CA_FRAME_FILE_MAX_PLANES; ++i) {
+      plane_offset[i] = 0;
+    }
+  }
+
+  FrameFileReader::~FrameFileReader() {
+    if (NULL != mapping) {
+      close();
+    }
+  }
+
+  int FrameFileReader::open(const std::string& filepath) {
+
+    int r = 0;
+
+    if (NULL != mapping) {
+      printf("Error: cannot open %s, the frame file reader is already open.\n", filepath.c_str());
+      return -1;
+    }
+
+#if defined(_WIN32)
+
+    LARGE_INTEGER size;
+
+    file_handle = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (INVALID_HANDLE_VALUE == file_handle) {
+      file_handle = NULL;
+      printf("Error: cannot open %s.\n", filepath.c_str());
+      return -2;
+    }
+
+    if (0 == GetFileSizeEx(file_handle, &size)) {
+      printf("Error: cannot get the size of %s.\n", filepath.c_str());
+      r = -3;
+      goto error;
+    }
+
+    mapping_size = (uint64_t)size.QuadPart;
+
+    if (CA_FRAME_FILE_HEADER_SIZE > mapping_size) {
+      printf("Error: %s is too small to be a frame file.\n", filepath.c_str());
+      r = -4;
+      goto error;
+    }
+
+    /* Copy on write, see the header. */
+    mapping_handle = CreateFileMappingA(file_handle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    if (NULL == mapping_handle) {
+      printf("Error: cannot map %s.\n", filepath.c_str());
+      r = -5;
+      goto error;
+    }
+
+    mapping = (uint8_t*)MapViewOfFile(mapping_handle, FILE_MAP_COPY, 0, 0, 0);
+
+#else
+
+    struct stat st;
+
+    fd = ::open(filepath.c_str(), O_RDONLY);
+    if (0 > fd) {
+      printf("Error: cannot open %s.\n", filepath.c_str());
+      return -2;
+    }
+
+    if (0 != fstat(fd, &st)) {
+      printf("Error: cannot get the size of %s.\n", filepath.c_str());
+      r = -3;
+      goto error;
+    }
+
+    mapping_size = (uint64_t)st.st_size;
+
+    if (CA_FRAME_FILE_HEADER_SIZE > mapping_size) {
+      printf("Error: %s is too small to be a frame file.\n", filepath.c_str());
+      r = -4;
+      goto error;
+    }
+
+    if ((uint64_t)(size_t)mapping_size != mapping_size) {
+      printf("Error: %s is too large to map in a 32 bit process.\n", filepath.c_str());
+      r = -5;
+      goto error;
+    }
+
+    /* Copy on write, see the header. */
+    mapping = (uint8_t*)mmap(NULL, (size_t)mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (MAP_FAILED == (void*)mapping) {
+      mapping = NULL;
+    }
+
+#endif
+
+    if (NULL == mapping) {
+      printf("Error: cannot map %s.\n", filepath.c_str());
+      r = -6;
+      goto error;
+    }
+
+    if (0 != readHeader()) {
+      printf("Error: %s is not a valid frame file.\n", filepath.c_str());
+      r = -7;
+      goto error;
+    }
+
+    is_recovered = (0 == header.index_offset);
+
+    if (true == is_recovered) {
+      printf("Warning: %s has no index, it wasn't closed; looking for the frames.\n", filepath.c_str());
+      r = scanRecords();
+    }
+    else {
+      r = readIndex();
+    }
+
+    if (0 != r) {
+      printf("Error: the index of %s is corrupt.\n", filepath.c_str());
+      r = -8;
+      goto error;
+    }
+
+    is_zero_copy = (CA_COMPRESS_NONE == header.compression && CA_FILTER_NONE == header.filter);
+    has_decoded = false;
+    decoded_index = 0;
+
+    if (false == is_zero_copy) {
+      decoded.resize(frame_nbytes);
+    }
+
+    if (0 != (header.filter & CA_FILTER_FRAME_DELTA)) {
+      scratch.resize(frame_nbytes);
+    }
+
+    return 0;
+
+  error:
+
+    unmap();
+    entries.clear();
+
+    return r;
+  }
+
+  int FrameFileReader::close() {
+
+    if (NULL == mapping) {
+      printf("Error: cannot close the frame file reader, it's not open.\n");
+      return -1;
+    }
+
+    unmap();
+
+    entries.clear();
+    decoded.clear();
+    scratch.clear();
+    has_decoded = false;
+    is_zero_copy = false;
+    is_recovered = false;
+    header = FrameFileHeader();
+
+    return 0;
+  }
+
+  int FrameFileReader::readFrame(uint64_t index, PixelBuffer& buffer) {
+
+    const FrameFileEntry* entry = NULL;
+    uint8_t* pixels = NULL;
+
+    if (NULL == mapping) {
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_ERROR("cannot read a frame, the frame file reader isn't open.");
+      return -1;
+    }
+
+    if (index >= entries.size()) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("cannot read frame %llu, the file has %llu frames.", (unsigned long long)index, (unsigned long long)entries.size());
+      return -2;
+    }
+
+    entry = &entries[(size_t)index];
+
+    if (true == is_zero_copy) {
+
+      /* We hand out the mapping as a whole frame; a corrupt entry must not make the buffer reach past it. */
+      for (int i = 0; i < header.num_planes; ++i) {
+        if ((uint64_t)entry->plane_nbytes[i] != (uint64_t)header.plane_stride[i] * header.plane_height[i]) {
+          error_set(CA_ERR_IO, 0);
+          CA_LOG_ERROR("cannot read frame %llu, plane %d has %u bytes instead of %llu.", (unsigned long long)index, i, entry->plane_nbytes[i],
+                       (unsigned long long)header.plane_stride[i] * header.plane_height[i]);
+          return -6;
+        }
+      }
+
+      pixels = mapping + entry->offset;
+    }
+    else {
+      if (0 != decodeFrame(index)) {
+        return -3;
+      }
+      pixels = &decoded[0];
+    }
+
+    if (0 != buffer.setup(header.width, header.height, header.pixel_format)) {
+      return -4;
+    }
+
+    if (0 != buffer.setPixels(pixels)) {
+      return -5;
+    }
+
+    buffer.sequence = entry->sequence;
+    buffer.timestamp = entry->timestamp;
+
+    return 0;
+  }
+
+  int FrameFileReader::findFrame(uint64_t timestamp, uint64_t& index) {
+
+    size_t lo = 0;
+    size_t hi = entries.size();
+
+    if (true == entries.empty() || timestamp < entries[0].timestamp) {
+      return -1;
+    }
+
+    /* The timestamps only go up, so a binary search for the first frame that is later. */
+    while (lo < hi) {
+      size_t mid = lo + (hi - lo) / 2;
+      if (entries[mid].timestamp <= timestamp) {
+        lo = mid + 1;
+      }
+      else {
+        hi = mid;
+      }
+    }
+
+    index = (uint64_t)(lo - 1);
+
+    return 0;
+  }
+
+  int FrameFileReader::getEntry(uint64_t index, FrameFileEntry& entry) {
+
+    if (index >= entries.size()) {
+      return -1;
+    }
+
+    entry = entries[(size_t)index];
+
+    return 0;
+  }
+
+  int FrameFileReader::prefetch(uint64_t index, uint64_t count) {
+
+    uint64_t start = 0;
+    uint64_t end = 0;
+
+    if (NULL == mapping || index >= entries.size() || 0 == count) {
+      return -1;
+    }
+
+    if (index + count > entries.size()) {
+      count = entries.size() - index;
+    }
+
+    start = entries[(size_t)index].offset;
+    end = entries[(size_t)(index + count - 1)].offset;
+
+    for (int i = 0; i < header.num_planes; ++i) {
+      end += entries[(size_t)(index + count - 1)].plane_nbytes[i];
+    }
+
+#if defined(_WIN32)
+
+    /* The system reads ahead on its own; PrefetchVirtualMemory() needs Windows 8. */
+    (void)start;
+    (void)end;
+
+#else
+
+    long page_size = sysconf(_SC_PAGESIZE);
+
+    if (0 < page_size) {
+      start -= start % (uint64_t)page_size;
+    }
+
+    if (0 != madvise(mapping + start, (size_t)(end - start), MADV_WILLNEED)) {
+      return -2;
+    }
+
+#endif
+
+    return 0;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  int FrameFileReader::readHeader() {
+
+    const uint8_t* p = mapping;
+
+    if (0 != memcmp(p, CA_FRAME_FILE_MAGIC, 8)) {
+      return -1;
+    }
+
+    if (CA_FRAME_FILE_VERSION != read_u32(p + 8)) {
+      printf("Error: unsupported frame file version %u.\n", read_u32(p + 8));
+      return -2;
+    }
+
+    header.pixel_format = (int)read_u32(p + 12);
+    header.width = (int)read_u32(p + 16);
+    header.height = (int)read_u32(p + 20);
+    header.fps = (int)read_u32(p + 24);
+    header.compression = (int)read_u32(p + 28);
+    header.filter = (int)read_u32(p + 32);
+    header.alignment = read_u32(p + 36);
+    header.num_planes = (int)read_u32(p + 40);
+
+    for (int i = 0; i < CA_FRAME_FILE_MAX_PLANES; ++i) {
+      header.plane_stride[i] = read_u32(p + 44 + i * 4);
+      header.plane_height[i] = read_u32(p + 56 + i * 4);
+    }
+
+    header.num_frames = read_u64(p + 72);
+    header.index_offset = read_u64(p + 80);
+
+    if (0 >= header.num_planes || CA_FRAME_FILE_MAX_PLANES < header.num_planes || 0 == header.alignment) {
+      return -3;
+    }
+
+    if (false == lossless_is_available(header.compression)) {
+      printf("Error: the frame file is compressed with method %d which is not available; compile with USE_LZ4 or USE_ZSTD.\n", header.compression);
+      return -4;
+    }
+
+    /* The planes must be what `PixelBuffer::setup()` expects, otherwise we can't hand them out. */
+    FrameFileHeader layout;
+
+    if (0 != frame_file_get_layout(header.width, header.height, header.pixel_format, layout)) {
+      return -5;
+    }
+
+    if (layout.num_planes != header.num_planes) {
+      return -6;
+    }
+
+    frame_nbytes = 0;
+
+    for (int i = 0; i < header.num_planes; ++i) {
+
+      if (layout.plane_stride[i] != header.plane_stride[i] || layout.plane_height[i] != header.plane_height[i]) {
+        return -7;
+      }
+
+      plane_offset[i] = frame_nbytes;
+      frame_nbytes += (size_t)header.plane_stride[i] * header.plane_height[i];
+    }
+
+    return 0;
+  }
+
+  int FrameFileReader::readIndex() {
+
+    const uint8_t* p = NULL;
+    uint64_t count = 0;
+
+    if (header.index_offset < CA_FRAME_FILE_HEADER_SIZE || header.index_offset + 16 > mapping_size) {
+      return -1;
+    }
+
+    p = mapping + header.index_offset;
+
+    if (0 != memcmp(p, "CAIX", 4)) {
+      return -2;
+    }
+
+    count = read_u64(p + 8);
+
+    if (count != header.num_frames || count > (mapping_size - header.index_offset - 16) / CA_FRAME_FILE_ENTRY_SIZE) {
+      return -3;
+    }
+
+    entries.resize((size_t)count);
+    p += 16;
+
+    for (size_t i = 0; i < entries.size(); ++i, p += CA_FRAME_FILE_ENTRY_SIZE) {
+
+      FrameFileEntry& entry = entries[i];
+      uint64_t end = 0;
+
+      entry.offset = read_u64(p);
+      entry.sequence = read_u64(p + 8);
+      entry.timestamp = read_u64(p + 16);
+      entry.flags = read_u32(p + 36);
+      end = entry.offset;
+
+      for (int j = 0; j < CA_FRAME_FILE_MAX_PLANES; ++j) {
+        entry.plane_nbytes[j] = read_u32(p + 24 + j * 4);
+        end += entry.plane_nbytes[j];
+      }
+
+      /* Make sure a corrupt entry can't make us read outside the mapping. */
+      if (entry.offset < CA_FRAME_FILE_HEADER_SIZE || end > header.index_offset) {
+        return -4;
+      }
+    }
+
+    return 0;
+  }
+
+  int FrameFileReader::scanRecords() {
+
+    uint64_t pos = CA_FRAME_FILE_HEADER_SIZE;
+
+    entries.clear();
+
+    while (pos + CA_FRAME_FILE_RECORD_SIZE <= mapping_size) {
+
+      const uint8_t* p = mapping + pos;
+      FrameFileEntry entry;
+      uint64_t end = 0;
+
+      if (0 != memcmp(p, "CAFR", 4)) {
+        break;
+      }
+
+      entry.flags = read_u32(p + 4);
+      entry.sequence = read_u64(p + 8);
+      entry.timestamp = read_u64(p + 16);
+
+      pos += CA_FRAME_FILE_RECORD_SIZE;
+      entry.offset = pos + (header.alignment - (pos % header.alignment)) % header.alignment;
+      end = entry.offset;
+
+      for (int i = 0; i < CA_FRAME_FILE_MAX_PLANES; ++i) {
+        entry.plane_nbytes[i] = read_u32(p + 24 + i * 4);
+        end += entry.plane_nbytes[i];
+      }
+
+      /* The last frame is incomplete when the recording stopped while writing it. */
+      if (end > mapping_size) {
+        break;
+      }
+
+      entries.push_back(entry);
+      pos = end;
+    }
+
+    header.num_frames = entries.size();
+
+    return 0;
+  }
+
+  int FrameFileReader::decodeFrame(uint64_t index) {
+
+    uint64_t start = index;
+
+    if (true == has_decoded && decoded_index == index) {
+      return 0;
+    }
+
+    /* Without the frame delta filter every frame stands on its own; otherwise continue from the frame we have when it's in the same chain. */
+    if (0 != (header.filter & CA_FILTER_FRAME_DELTA)) {
+
+      while (0 < start && 0 == (entries[(size_t)start].flags & CA_FRAME_FLAG_KEY)) {
+        start--;
+      }
+
+      if (true == has_decoded && decoded_index >= start && decoded_index < index) {
+        start = decoded_index + 1;
+      }
+    }
+
+    for (uint64_t i = start; i <= index; ++i) {
+      if (0 != decodeOne(i)) {
+        has_decoded = false;
+        return -1;
+      }
+      decoded_index = i;
+      has_decoded = true;
+    }
+
+    return 0;
+  }
+
+  int FrameFileReader::decodeOne(uint64_t index) {
+
+    const FrameFileEntry& entry = entries[(size_t)index];
+    bool is_delta = (0 != (header.filter & CA_FILTER_FRAME_DELTA) && 0 == (entry.flags & CA_FRAME_FLAG_KEY));
+    uint8_t* dst = (true == is_delta) ? &scratch[0] : &decoded[0];
+    const uint8_t* src = mapping + entry.offset;
+
+    for (int i = 0; i < header.num_planes; ++i) {
+
+      size_t nbytes = (size_t)header.plane_stride[i] * header.plane_height[i];
+      int method = (0 != (entry.flags & CA_FRAME_FLAG_RAW_PLANE(i))) ? CA_COMPRESS_NONE : header.compression;
+
+      if (0 != lossless_decompress(method, src, entry.plane_nbytes[i], dst + plane_offset[i], nbytes)) {
+        error_set(CA_ERR_IO, 0);
+        CA_LOG_ERROR("cannot decompress plane %d of frame %llu.", i, (unsigned long long)index);
+        return -1;
+      }
+
+      if (0 != (header.filter & CA_FILTER_ROW_DELTA)) {
+        lossless_undelta_rows(dst + plane_offset[i], header.plane_stride[i], header.plane_height[i]);
+      }
+
+      src += entry.plane_nbytes[i];
+    }
+
+    if (true == is_delta) {
+      lossless_undelta_frame(&scratch[0], &decoded[0], frame_nbytes);
+    }
+
+    return 0;
+  }
+
+  int FrameFileReader::unmap() {
+
+#if defined(_WIN32)
+
+    if (NULL != mapping) {
+      UnmapViewOfFile(mapping);
+    }
+
+    if (NULL != mapping_handle) {
+      CloseHandle(mapping_handle);
+    }
+
+    if (NULL != file_handle) {
+      CloseHandle(file_handle);
+    }
+
+#else
+
+    if (NULL != mapping) {
+      munmap(mapping, (size_t)mapping_size);
+    }
+
+    if (0 <= fd) {
+      ::close(fd);
+    }
+
+#endif
+
+    mapping = NULL;
+    mapping_size = 0;
+    mapping_handle = NULL;
+    file_handle = NULL;
+    fd = -1;
+
+    return 0;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  static uint32_t read_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+  }
+
+  static uint64_t read_u64(const uint8_t* p) {
+    return (uint64_t)read_u32(p) | ((uint64_t)read_u32(p + 4) << 32);
+  }
+
+} /* namespace ca */
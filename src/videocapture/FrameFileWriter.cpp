@@ -0,0 +1,263 @@
+#include <stdio.h>
+#include <videocapture/Utils.h>
+#include <videocapture/FrameFileWriter.h>
+
+#define FRAME_FILE_INDEX_RESERVE (30 * 60 * 10)                                     /* The number of index entries we reserve; 10 minutes at 30 fps. */
+#define FRAME_FILE_NUM_FRAMES_OFFSET 72                                             /* The offset of `num_frames` in the header. */
+#define FRAME_FILE_INDEX_OFFSET_OFFSET 80                                           /* The offset of `index_offset` in the header. */
+
+namespace ca {
+
+  FrameFileWriter::FrameFileWriter() {
+  }
+
+  FrameFileWriter::~FrameFileWriter() {
+    if (true == file.isOpen()) {
+      close();
+    }
+  }
+
+  int FrameFileWriter::open(const std::string& filepath, const FrameFileHeader& hdr) {
+
+    if (true == file.isOpen()) {
+      printf("Error: cannot open %s, the frame file writer is already open.\n", filepath.c_str());
+      return -1;
+    }
+
+    if (0 >= hdr.num_planes || CA_FRAME_FILE_MAX_PLANES < hdr.num_planes) {
+      printf("Error: invalid number of planes for the frame file writer: %d; use `frame_file_get_layout()`.\n", hdr.num_planes);
+      return -2;
+    }
+
+    /* The alignment must be a power of two. */
+    if (0 == hdr.alignment || 0 != (hdr.alignment & (hdr.alignment - 1))) {
+      printf("Error: the alignment of a frame file must be a power of two, not %u.\n", hdr.alignment);
+      return -3;
+    }
+
+    if (0 != file.open(filepath)) {
+      return -4;
+    }
+
+    header = hdr;
+    header.num_frames = 0;
+    header.index_offset = 0;
+
+    entries.clear();
+    entries.reserve(FRAME_FILE_INDEX_RESERVE);
+
+    file.write(CA_FRAME_FILE_MAGIC, 8);
+    file.writeU32(CA_FRAME_FILE_VERSION);
+    file.writeU32((uint32_t)header.pixel_format);
+    file.writeU32((uint32_t)header.width);
+    file.writeU32((uint32_t)header.height);
+    file.writeU32((uint32_t)header.fps);
+    file.writeU32((uint32_t)header.compression);
+    file.writeU32((uint32_t)header.filter);
+    file.writeU32(header.alignment);
+    file.writeU32((uint32_t)header.num_planes);
+
+    for (int i = 0; i < CA_FRAME_FILE_MAX_PLANES; ++i) {
+      file.writeU32(header.plane_stride[i]);
+    }
+
+    for (int i = 0; i < CA_FRAME_FILE_MAX_PLANES; ++i) {
+      file.writeU32(header.plane_height[i]);
+    }
+
+    file.writeU32(0);                                                               /* reserved */
+    file.writeU64(0);                                                               /* num_frames, patched in `close()` */
+    file.writeU64(0);                                                               /* index_offset, patched in `close()` */
+
+    if (0 != file.writeZeros(CA_FRAME_FILE_HEADER_SIZE - file.tell())) {
+      file.close();
+      return -5;
+    }
+
+    return 0;
+  }
+
+  int FrameFileWriter::close() {
+
+    uint64_t index_offset = 0;
+    int r = 0;
+
+    if (false == file.isOpen()) {
+      printf("Error: cannot close the frame file writer, it's not open.\n");
+      return -1;
+    }
+
+    index_offset = file.tell();
+
+    file.writeFourCC("CAIX");
+    file.writeU32(0);                                                               /* reserved, keeps the entries 8 byte aligned */
+    file.writeU64((uint64_t)entries.size());
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+
+      const FrameFileEntry& entry = entries[i];
+
+      file.writeU64(entry.offset);
+      file.writeU64(entry.sequence);
+      file.writeU64(entry.timestamp);
+
+      for (int j = 0; j < CA_FRAME_FILE_MAX_PLANES; ++j) {
+        file.writeU32(entry.plane_nbytes[j]);
+      }
+
+      file.writeU32(entry.flags);
+
+      if (0 != file.writeZeros(8)) {
+        r = -2;
+        break;
+      }
+    }
+
+    if (0 == r) {
+      file.patchU64(FRAME_FILE_NUM_FRAMES_OFFSET, (uint64_t)entries.size());
+      file.patchU64(FRAME_FILE_INDEX_OFFSET_OFFSET, index_offset);
+    }
+
+    if (0 != file.close()) {
+      r = -3;
+    }
+
+    entries.clear();
+
+    return r;
+  }
+
+  int FrameFileWriter::writeFrame(FrameFileEntry& entry, const DataChunk* planes) {
+
+    if (false == file.isOpen()) {
+      printf("Error: cannot write a frame, the frame file writer isn't open.\n");
+      return -1;
+    }
+
+    if (NULL == planes) {
+      printf("Error: cannot write a frame without planes.\n");
+      return -2;
+    }
+
+    for (int i = 0; i < header.num_planes; ++i) {
+      if (entry.plane_nbytes[i] != planes[i].nbytes) {
+        printf("Error: the size of plane %d doesn't match its index entry.\n", i);
+        return -3;
+      }
+    }
+
+    if (0 != writeRecord(entry)) {
+      return -4;
+    }
+
+    if (0 != file.write(planes, header.num_planes)) {
+      return -5;
+    }
+
+    entries.push_back(entry);
+
+    return 0;
+  }
+
+  int FrameFileWriter::writeFrame(PixelBuffer& buffer) {
+
+    FrameFileEntry entry;
+
+    if (false == file.isOpen()) {
+      printf("Error: cannot write a frame, the frame file writer isn't open.\n");
+      return -1;
+    }
+
+    if (CA_COMPRESS_NONE != header.compression || CA_FILTER_NONE != header.filter) {
+      printf("Error: can only write a PixelBuffer into an uncompressed, unfiltered frame file; see LosslessRecorder.h.\n");
+      return -2;
+    }
+
+    if (buffer.pixel_format != header.pixel_format || (int)buffer.width[0] != header.width || (int)buffer.height[0] != header.height) {
+      printf("Error: the frame file expects %d x %d %s frames.\n", header.width, header.height, format_to_string(header.pixel_format).c_str());
+      return -3;
+    }
+
+    entry.offset = 0;
+    entry.sequence = buffer.sequence;
+    entry.timestamp = (0 != buffer.timestamp) ? buffer.timestamp : time_now_ns();
+    entry.flags = CA_FRAME_FLAG_KEY;
+
+    for (int i = 0; i < CA_FRAME_FILE_MAX_PLANES; ++i) {
+      entry.plane_nbytes[i] = header.plane_stride[i] * header.plane_height[i];
+    }
+
+    if (0 != writeRecord(entry)) {
+      return -4;
+    }
+
+    /* One chunk per plane when the rows are tight, otherwise one per row so the padding stays out. */
+    row_chunks.clear();
+
+    for (int i = 0; i < header.num_planes; ++i) {
+
+      DataChunk chunk;
+
+      if (buffer.stride[i] == header.plane_stride[i]) {
+        chunk.data = buffer.plane[i];
+        chunk.nbytes = entry.plane_nbytes[i];
+        row_chunks.push_back(chunk);
+        continue;
+      }
+
+      for (uint32_t y = 0; y < header.plane_height[i]; ++y) {
+        chunk.data = buffer.plane[i] + y * buffer.stride[i];
+        chunk.nbytes = header.plane_stride[i];
+        row_chunks.push_back(chunk);
+      }
+    }
+
+    if (0 != file.write(&row_chunks[0], (int)row_chunks.size())) {
+      return -5;
+    }
+
+    entries.push_back(entry);
+
+    return 0;
+  }
+
+  uint64_t FrameFileWriter::getNumFrames() {
+    return (uint64_t)entries.size();
+  }
+
+  uint64_t FrameFileWriter::getNumBytes() {
+    return file.tell();
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  int FrameFileWriter::writeRecord(FrameFileEntry& entry) {
+
+    uint64_t padding = 0;
+
+    file.writeFourCC("CAFR");
+    file.writeU32(entry.flags);
+    file.writeU64(entry.sequence);
+    file.writeU64(entry.timestamp);
+
+    for (int i = 0; i < CA_FRAME_FILE_MAX_PLANES; ++i) {
+      file.writeU32(entry.plane_nbytes[i]);
+    }
+
+    if (0 != file.writeZeros(12)) {                                                 /* reserved */
+      return -1;
+    }
+
+    /* Pad so the first plane starts at a multiple of `alignment`. */
+    padding = (header.alignment - (file.tell() % header.alignment)) % header.alignment;
+
+    if (0 != padding && 0 != file.writeZeros((size_t)padding)) {
+      return -2;
+    }
+
+    entry.offset = file.tell();
+
+    return 0;
+  }
+
+} /* namespace ca */
@@ -0,0 +1,529 @@
+#include <stdio.h>
+#include <videocapture/Log.h>
+#include <videocapture/Error.h>
+#include <videocapture/Utils.h>
+#include <videocapture/Trace.h>
+#include <videocapture/Rotate.h>
+#include <videocapture/FramePipeline.h>
+
+/* The callback returns before the next frame is processed, so normally one buffer per step is enough. */
+#define FRAME_PIPELINE_NUM_BUFFERS 2
+
+namespace ca {
+
+  /* Returns the format we decode JPEG frames into to get `outfmt`: the format itself, or the first decoder format we can convert from. */
+  static int frame_pipeline_get_decode_format(int outfmt);
+
+  /* ------------------------------------------------------------------------- */
+
+  FramePipeline::FramePipeline()
+    :scheduler(NULL)
+    ,stats(NULL)
+    ,input_format(CA_NONE)
+    ,decode_format(CA_NONE)
+    ,convert_format(CA_NONE)
+    ,rotate_format(CA_NONE)
+    ,rotation(CA_ROTATE_NONE)
+    ,drop_policy(CA_DROP_NEWEST)
+    ,output_width(0)
+    ,output_height(0)
+    ,requested_format(CA_NONE)
+    ,plan_width(0)
+    ,plan_height(0)
+    ,use_decoder_pool(false)
+    ,use_h264_decoder(false)
+    ,is_init(false)
+  {
+  }
+
+  FramePipeline::~FramePipeline() {
+    shutdown();
+    scheduler = NULL;
+    stats = NULL;
+  }
+
+  int FramePipeline::init(int width, int height, int infmt, int outfmt, int rot, int jpegscale, int decodethreads, int droppolicy, int threadtype) {
+
+    int fmt = infmt;
+    int w = width;
+    int h = height;
+    int r = 0;
+
+    if (true == is_init) {
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_ERROR("cannot initialize the frame pipeline, already initialized.");
+      return -1;
+    }
+
+    input_format = infmt;
+    requested_format = outfmt;
+    rotation = rot;
+    drop_policy = droppolicy;
+
+    /* Compressed frames are decoded when the user wants pixels: straight into the output format when the decoder supports it. */
+    if ((CA_MJPEG == infmt || CA_JPEG_OPENDML == infmt)
+        && (CA_NONE != outfmt || CA_ROTATE_NONE != rot))
+      {
+        decode_format = frame_pipeline_get_decode_format(outfmt);
+        if (CA_NONE == decode_format) {
+          error_set(CA_ERR_NOT_SUPPORTED, 0);
+          CA_LOG_ERROR("cannot decode %s into %s.", format_to_string(infmt).c_str(), format_to_string(outfmt).c_str());
+          shutdown();
+          return -2;
+        }
+
+        if (0 != mjpeg_get_scaled_size(width, height, jpegscale, w, h)) {
+          shutdown();
+          return -3;
+        }
+
+        if (0 < decodethreads) {
+
+          if (0 != decoder_pool.init(width, height, decode_format, jpegscale, decodethreads, 0, droppolicy)) {
+            shutdown();
+            return -2;
+          }
+
+          use_decoder_pool = true;
+        }
+        else {
+
+          if (0 != decoder.init(decode_format, jpegscale)) {
+            shutdown();
+            return -2;
+          }
+
+          if (0 != decode_pool.init(w, h, decode_format, FRAME_PIPELINE_NUM_BUFFERS)) {
+            shutdown();
+            return -4;
+          }
+        }
+
+        fmt = decode_format;
+      }
+
+    /* H.264 pictures are most likely CA_YUV420P; we plan for that and plan again when the first picture is different. */
+    if (CA_H264 == infmt
+        && (CA_NONE != outfmt || CA_ROTATE_NONE != rot))
+      {
+        if (0 != h264_decoder.init(decodethreads, threadtype)) {
+          shutdown();
+          return -2;
+        }
+
+        use_h264_decoder = true;
+        decode_format = CA_YUV420P;
+        fmt = decode_format;
+      }
+
+    r = planSteps(fmt, w, h);
+    if (0 != r) {
+      shutdown();
+      return r;
+    }
+
+    is_init = true;
+
+    return 0;
+  }
+
+  int FramePipeline::planSteps(int fmt, int w, int h) {
+
+    int outfmt = requested_format;
+
+    convert_plan.shutdown();
+    convert_pool.shutdown();
+    rotate_pool.shutdown();
+
+    plan_width = 0;
+    plan_height = 0;
+
+    if (0 != rotate_get_size(w, h, rotation, output_width, output_height)) {
+      return -5;
+    }
+
+    convert_format = (CA_NONE == outfmt || outfmt == fmt) ? CA_NONE : outfmt;
+    rotate_format = (CA_NONE == convert_format) ? fmt : convert_format;
+
+    /* Formats that we can't rotate, e.g. packed 4:2:2 by 90 degrees, are converted into CA_YUV420P first. */
+    if (CA_ROTATE_NONE != rotation
+        && CA_NONE == outfmt
+        && false == rotate_is_supported(rotate_format, rotation)
+        && true == rotate_is_supported(CA_YUV420P, rotation)
+        && true == convert_get_planner().canConvert(fmt, CA_YUV420P))
+      {
+        convert_format = CA_YUV420P;
+        rotate_format = CA_YUV420P;
+      }
+
+    if (CA_ROTATE_NONE != rotation && false == rotate_is_supported(rotate_format, rotation)) {
+      error_set(CA_ERR_NOT_SUPPORTED, 0);
+      CA_LOG_ERROR("cannot rotate %s by %d degrees.", format_to_string(rotate_format).c_str(), rotation);
+      return -6;
+    }
+
+    if (CA_NONE != convert_format) {
+
+      if (0 != convert_plan.init(fmt, convert_format, w, h)) {
+        error_set(CA_ERR_NOT_SUPPORTED, 0);
+        CA_LOG_ERROR("cannot convert from %s to %s.", format_to_string(fmt).c_str(), format_to_string(convert_format).c_str());
+        return -7;
+      }
+
+      if (0 != convert_pool.init(w, h, convert_format, FRAME_PIPELINE_NUM_BUFFERS)) {
+        return -8;
+      }
+    }
+
+    if (CA_ROTATE_NONE != rotation) {
+      if (0 != rotate_pool.init(output_width, output_height, rotate_format, FRAME_PIPELINE_NUM_BUFFERS)) {
+        return -9;
+      }
+    }
+
+    plan_width = w;
+    plan_height = h;
+
+    return 0;
+  }
+
+  int FramePipeline::shutdown() {
+
+    if (true == use_decoder_pool) {
+      decoder_pool.shutdown();
+      use_decoder_pool = false;
+    }
+
+    if (true == use_h264_decoder) {
+      h264_decoder.shutdown();
+      use_h264_decoder = false;
+    }
+
+    decoder.shutdown();
+    decode_pool.shutdown();
+    convert_plan.shutdown();
+    convert_pool.shutdown();
+    rotate_pool.shutdown();
+
+    input_format = CA_NONE;
+    decode_format = CA_NONE;
+    convert_format = CA_NONE;
+    rotate_format = CA_NONE;
+    rotation = CA_ROTATE_NONE;
+    drop_policy = CA_DROP_NEWEST;
+    output_width = 0;
+    output_height = 0;
+    requested_format = CA_NONE;
+    plan_width = 0;
+    plan_height = 0;
+    is_init = false;
+
+    return 0;
+  }
+
+  int FramePipeline::process(PixelBuffer& in, frame_callback cb) {
+
+    if (NULL == stats) {
+      return processFrame(in, cb);
+    }
+
+    stats->frameCaptured(in.timestamp, in.sequence);
+
+    /* The decode threads may drop an older frame to make room for this one. */
+    if (true == use_decoder_pool) {
+      uint64_t dropped = decoder_pool.getNumDropped();
+      int r = processFrame(in, cb);
+      stats->framesDropped(decoder_pool.getNumDropped() - dropped);
+      return r;
+    }
+
+    int r = processFrame(in, cb);
+
+    if (0 > r) {
+      stats->framesDropped(1);
+    }
+
+    return r;
+  }
+
+  int FramePipeline::processFrame(PixelBuffer& in, frame_callback cb) {
+
+    PixelBuffer* decoded = NULL;
+    int r = 0;
+
+    if (NULL == cb) {
+      return -1;
+    }
+
+    if (true == isPassThrough()) {
+      deliver(in, cb);
+      return 0;
+    }
+
+    if (false == is_init) {
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_ERROR("cannot process a frame, the frame pipeline is not initialized.");
+      return -2;
+    }
+
+    if (true == use_decoder_pool) {
+
+      /* Make room by delivering the oldest frame(s); this blocks until they're decoded. */
+      if (CA_DROP_NONE == drop_policy) {
+        while (0 == decoder_pool.getNumFree()) {
+          decoded = decoder_pool.acquireDecoded(true);
+          if (NULL == decoded) {
+            break;
+          }
+          processDecoded(*decoded, cb);
+          decoder_pool.release(decoded);
+        }
+      }
+
+      r = decoder_pool.submit(in);
+      poll(cb);
+
+      return (0 == r) ? 0 : -3;
+    }
+
+    /* With frame threads the picture of this frame comes out of the decoder a few frames later. */
+    if (true == use_h264_decoder) {
+      {
+        CA_TRACE_SCOPE("decode", in.sequence);
+        r = h264_decoder.submit(in);
+      }
+      poll(cb);
+      return (0 == r) ? 0 : -4;
+    }
+
+    if (CA_NONE != decode_format) {
+
+      decoded = decode_pool.acquire();
+      if (NULL == decoded) {
+        CA_LOG_WARNING("no free buffer to decode into; dropping a frame.");
+        return -3;
+      }
+
+      uint64_t start = time_now_ns();
+
+      {
+        CA_TRACE_SCOPE("decode", in.sequence);
+        if (0 != decoder.decode(in.plane[0], in.nbytes, *decoded)) {
+          decode_pool.release(decoded);
+          return -4;
+        }
+      }
+
+      decoded->decode_time = time_now_ns() - start;
+      decoded->sequence = in.sequence;
+      decoded->timestamp = in.timestamp;
+      decoded->receive_time = in.receive_time;
+      decoded->user = in.user;
+
+      r = processDecoded(*decoded, cb);
+      decode_pool.release(decoded);
+
+      return r;
+    }
+
+    return processDecoded(in, cb);
+  }
+
+  int FramePipeline::poll(frame_callback cb) {
+
+    PixelBuffer* decoded = NULL;
+    int n = 0;
+
+    if (NULL == cb) {
+      return 0;
+    }
+
+    if (true == use_h264_decoder) {
+
+      while (NULL != (decoded = h264_decoder.acquireDecoded())) {
+
+        /* The format and size are only known once we have a picture. */
+        if (decoded->pixel_format != decode_format
+            || (int)decoded->width[0] != plan_width
+            || (int)decoded->height[0] != plan_height)
+          {
+            if (0 != planSteps(decoded->pixel_format, (int)decoded->width[0], (int)decoded->height[0])) {
+              error_set(CA_ERR_NOT_SUPPORTED, 0);
+              CA_LOG_ERROR("cannot deliver the decoded H.264 pictures of %d x %d %s.", (int)decoded->width[0], (int)decoded->height[0], format_to_string(decoded->pixel_format).c_str());
+              h264_decoder.release(decoded);
+              continue;
+            }
+            decode_format = decoded->pixel_format;
+          }
+
+        processDecoded(*decoded, cb);
+        h264_decoder.release(decoded);
+        n++;
+      }
+
+      return n;
+    }
+
+    if (false == use_decoder_pool) {
+      return 0;
+    }
+
+    while (NULL != (decoded = decoder_pool.acquireDecoded())) {
+      processDecoded(*decoded, cb);
+      decoder_pool.release(decoded);
+      n++;
+    }
+
+    return n;
+  }
+
+  int FramePipeline::processDecoded(PixelBuffer& in, frame_callback cb) {
+
+    PixelBuffer* converted = NULL;
+    PixelBuffer* rotated = NULL;
+    PixelBuffer* out = &in;
+    uint64_t start = 0;
+    int r = 0;
+
+    if (NULL != stats && (CA_NONE != convert_format || CA_ROTATE_NONE != rotation)) {
+      start = time_now_ns();
+    }
+
+    if (CA_NONE != convert_format) {
+
+      converted = convert_pool.acquire();
+      if (NULL == converted) {
+        CA_LOG_WARNING("no free buffer to convert into; dropping a frame.");
+        r = -5;
+        goto error;
+      }
+
+      {
+        CA_TRACE_SCOPE("convert", in.sequence);
+        if (0 != convert_plan.execute(*out, *converted, scheduler)) {
+          r = -6;
+          goto error;
+        }
+      }
+
+      out = converted;
+    }
+
+    if (CA_ROTATE_NONE != rotation) {
+
+      rotated = rotate_pool.acquire();
+      if (NULL == rotated) {
+        CA_LOG_WARNING("no free buffer to rotate into; dropping a frame.");
+        r = -7;
+        goto error;
+      }
+
+      {
+        CA_TRACE_SCOPE("rotate", in.sequence);
+        if (0 != rotate(*out, *rotated, rotation, scheduler)) {
+          r = -8;
+          goto error;
+        }
+      }
+
+      out = rotated;
+    }
+
+    if (0 != start) {
+      stats->recordLatency(CA_LATENCY_CONVERT, time_now_ns() - start);
+    }
+
+    out->sequence = in.sequence;
+    out->timestamp = in.timestamp;
+    out->decode_time = in.decode_time;
+    out->receive_time = in.receive_time;
+    out->user = in.user;
+    deliver(*out, cb);
+
+  error:
+
+    if (NULL != rotated) {
+      rotate_pool.release(rotated);
+    }
+
+    if (NULL != converted) {
+      convert_pool.release(converted);
+    }
+
+    return r;
+  }
+
+  void FramePipeline::deliver(PixelBuffer& out, frame_callback cb) {
+
+    CA_TRACE_SCOPE("callback", out.sequence);
+
+    if (NULL == stats) {
+      cb(out);
+      return;
+    }
+
+    uint64_t start = time_now_ns();
+
+    if (0 != out.receive_time && start > out.receive_time) {
+      stats->recordLatency(CA_LATENCY_DELIVER, start - out.receive_time);
+    }
+
+    cb(out);
+    stats->frameDelivered(start, time_now_ns());
+  }
+
+  int FramePipeline::getOutputFormat() {
+
+    if (CA_NONE != rotate_format) {
+      return rotate_format;
+    }
+
+    return input_format;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  bool frame_pipeline_can_deliver(int infmt, int outfmt) {
+
+    ConvertPlanner& planner = convert_get_planner();
+
+    if (infmt == outfmt || true == planner.canConvert(infmt, outfmt)) {
+      return true;
+    }
+
+    if (CA_MJPEG == infmt || CA_JPEG_OPENDML == infmt) {
+      return true == mjpeg_decoder_is_available() && CA_NONE != frame_pipeline_get_decode_format(outfmt);
+    }
+
+    if (CA_H264 == infmt) {
+      return true == h264_decoder_is_available() && (CA_YUV420P == outfmt || true == planner.canConvert(CA_YUV420P, outfmt));
+    }
+
+    return false;
+  }
+
+  static int frame_pipeline_get_decode_format(int outfmt) {
+
+    std::vector<int> formats = mjpeg_decoder_get_formats();
+    ConvertPlanner& planner = convert_get_planner();
+
+    /* When we're compiled without a decoder `MjpegDecoder::init()` tells why. */
+    if (CA_NONE == outfmt) {
+      return CA_YUV420P;
+    }
+
+    if (true == mjpeg_decoder_can_decode_into(outfmt)) {
+      return outfmt;
+    }
+
+    /* The formats are ordered by preference; CA_YUV420P is the cheapest to decode. */
+    for (size_t i = 0; i < formats.size(); ++i) {
+      if (true == planner.canConvert(formats[i], outfmt)) {
+        return formats[i];
+      }
+    }
+
+    return CA_NONE;
+  }
+
+} /* namespace ca */
@@ -0,0 +1,414 @@
+#include <stdio.h>
+#include <videocapture/Log.h>
+#include <videocapture/Error.h>
+#include <videocapture/Utils.h>
+#include <videocapture/H264Decoder.h>
+
+#if defined(USE_AVCODEC)
+extern "C" {
+#  include <libavcodec/avcodec.h>
+#  include <libavutil/frame.h>
+}
+#endif
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+#if defined(USE_AVCODEC)
+
+  struct H264DecoderState {
+    AVCodecContext* context;                                                        /* The decoder. */
+    AVPacket* packet;                                                               /* Reused for every submitted frame. */
+    AVFrame* frames[CA_H264_DECODER_MAX_FRAMES];                                    /* Hold the references to the pictures in `H264Decoder::frames`. */
+  };
+
+#endif
+
+  /* ------------------------------------------------------------------------- */
+
+  H264Decoder::H264Decoder()
+    :state(NULL)
+    ,num_submitted(0)
+    ,num_decoded(0)
+    ,num_failed(0)
+    ,num_threads(0)
+  {
+    for (int i = 0; i < CA_H264_DECODER_MAX_FRAMES; ++i) {
+      frame_in_use[i] = false;
+    }
+  }
+
+  H264Decoder::~H264Decoder() {
+    shutdown();
+  }
+
+  int H264Decoder::init(int nthreads, int threadtype) {
+
+    if (NULL != state) {
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_ERROR("cannot initialize the H.264 decoder, already initialized.");
+      return -1;
+    }
+
+    if (false == h264_decoder_is_available()) {
+      error_set(CA_ERR_NOT_SUPPORTED, 0);
+      CA_LOG_ERROR("cannot decode H.264, the library is compiled without USE_AVCODEC.");
+      return -2;
+    }
+
+#if defined(USE_AVCODEC)
+
+    const AVCodec* codec = avcodec_find_decoder(AV_CODEC_ID_H264);
+    if (NULL == codec) {
+      error_set(CA_ERR_NOT_SUPPORTED, 0);
+      CA_LOG_ERROR("cannot decode H.264, libavcodec has no H.264 decoder.");
+      return -3;
+    }
+
+    state = new H264DecoderState();
+    state->context = NULL;
+    state->packet = NULL;
+
+    for (int i = 0; i < CA_H264_DECODER_MAX_FRAMES; ++i) {
+      state->frames[i] = NULL;
+    }
+
+    state->context = avcodec_alloc_context3(codec);
+    if (NULL == state->context) {
+      error_set(CA_ERR_NO_MEMORY, 0);
+      CA_LOG_ERROR("cannot allocate the H.264 decoder context.");
+      shutdown();
+      return -4;
+    }
+
+    state->context->thread_count = (0 < nthreads) ? nthreads : 1;
+    state->context->thread_type = 0;
+
+    if (0 != (threadtype & CA_DECODE_THREAD_FRAME)) {
+      state->context->thread_type |= FF_THREAD_FRAME;
+    }
+
+    if (0 != (threadtype & CA_DECODE_THREAD_SLICE)) {
+      state->context->thread_type |= FF_THREAD_SLICE;
+    }
+
+    /* Without frame threads we want every picture as soon as it's decoded. */
+    if (0 == (threadtype & CA_DECODE_THREAD_FRAME)) {
+      state->context->flags |= AV_CODEC_FLAG_LOW_DELAY;
+    }
+
+    if (0 > avcodec_open2(state->context, codec, NULL)) {
+      error_set(CA_ERR_NOT_SUPPORTED, 0);
+      CA_LOG_ERROR("cannot open the H.264 decoder.");
+      shutdown();
+      return -5;
+    }
+
+    state->packet = av_packet_alloc();
+    if (NULL == state->packet) {
+      error_set(CA_ERR_NO_MEMORY, 0);
+      CA_LOG_ERROR("cannot allocate the H.264 packet.");
+      shutdown();
+      return -6;
+    }
+
+    for (int i = 0; i < CA_H264_DECODER_MAX_FRAMES; ++i) {
+      state->frames[i] = av_frame_alloc();
+      if (NULL == state->frames[i]) {
+        error_set(CA_ERR_NO_MEMORY, 0);
+        CA_LOG_ERROR("cannot allocate a H.264 picture.");
+        shutdown();
+        return -7;
+      }
+    }
+
+    num_threads = state->context->thread_count;
+    num_submitted = 0;
+    num_decoded = 0;
+    num_failed = 0;
+
+#else
+    (void)nthreads;
+    (void)threadtype;
+#endif
+
+    return 0;
+  }
+
+  int H264Decoder::shutdown() {
+
+#if defined(USE_AVCODEC)
+
+    if (NULL == state) {
+      return 0;
+    }
+
+    for (int i = 0; i < CA_H264_DECODER_MAX_FRAMES; ++i) {
+      if (NULL != state->frames[i]) {
+        av_frame_free(&state->frames[i]);
+      }
+      frame_in_use[i] = false;
+    }
+
+    if (NULL != state->packet) {
+      av_packet_free(&state->packet);
+    }
+
+    if (NULL != state->context) {
+      avcodec_free_context(&state->context);
+    }
+
+    delete state;
+    state = NULL;
+
+#endif
+
+    num_threads = 0;
+
+    return 0;
+  }
+
+  int H264Decoder::submit(const PixelBuffer& in) {
+
+    if (NULL == state) {
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_ERROR("cannot decode a H.264 frame, the decoder is not initialized.");
+      return -1;
+    }
+
+    if (NULL == in.plane[0] || 0 == in.nbytes) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("cannot decode a H.264 frame, it's empty.");
+      return -2;
+    }
+
+#if defined(USE_AVCODEC)
+
+    H264PendingFrame& p = pending[num_submitted % CA_H264_DECODER_MAX_PENDING];
+    int r = 0;
+
+    p.sequence = in.sequence;
+    p.timestamp = in.timestamp;
+    p.receive_time = in.receive_time;
+    p.user = in.user;
+    p.submit_time = time_now_ns();
+
+    /* The packet isn't reference counted, so libavcodec copies the data when it needs to keep it. */
+    state->packet->data = in.plane[0];
+    state->packet->size = (int)in.nbytes;
+    state->packet->pts = (int64_t)num_submitted;
+
+    r = avcodec_send_packet(state->context, state->packet);
+
+    state->packet->data = NULL;
+    state->packet->size = 0;
+
+    if (AVERROR(EAGAIN) == r) {
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_WARNING("the H.264 decoder is full, acquire the decoded pictures first; dropping a frame.");
+      num_failed++;
+      return -3;
+    }
+
+    if (0 > r) {
+      num_failed++;
+      return -4;
+    }
+
+    num_submitted++;
+
+#endif
+
+    return 0;
+  }
+
+  PixelBuffer* H264Decoder::acquireDecoded() {
+
+    if (NULL == state) {
+      return NULL;
+    }
+
+#if defined(USE_AVCODEC)
+
+    int slot = -1;
+    int r = 0;
+
+    for (int i = 0; i < CA_H264_DECODER_MAX_FRAMES; ++i) {
+      if (false == frame_in_use[i]) {
+        slot = i;
+        break;
+      }
+    }
+
+    if (-1 == slot) {
+      return NULL;
+    }
+
+    while (true) {
+
+      r = avcodec_receive_frame(state->context, state->frames[slot]);
+      if (0 > r) {
+        if (AVERROR(EAGAIN) != r && AVERROR_EOF != r) {
+          num_failed++;
+        }
+        return NULL;
+      }
+
+      if (0 == wrapFrame(slot)) {
+        break;
+      }
+
+      av_frame_unref(state->frames[slot]);
+      num_failed++;
+    }
+
+    frame_in_use[slot] = true;
+    num_decoded++;
+
+    return &frames[slot];
+
+#else
+    return NULL;
+#endif
+  }
+
+  int H264Decoder::release(PixelBuffer* buf) {
+
+    int slot = -1;
+
+    for (int i = 0; i < CA_H264_DECODER_MAX_FRAMES; ++i) {
+      if (buf == &frames[i]) {
+        slot = i;
+        break;
+      }
+    }
+
+    if (-1 == slot || false == frame_in_use[slot]) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("cannot release a H.264 picture that we didn't hand out.");
+      return -1;
+    }
+
+#if defined(USE_AVCODEC)
+    if (NULL != state) {
+      av_frame_unref(state->frames[slot]);
+    }
+#endif
+
+    frame_in_use[slot] = false;
+
+    return 0;
+  }
+
+  int H264Decoder::getNumThreads() {
+    return num_threads;
+  }
+
+  uint64_t H264Decoder::getNumDecoded() {
+    return num_decoded;
+  }
+
+  uint64_t H264Decoder::getNumFailed() {
+    return num_failed;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  int H264Decoder::wrapFrame(int slot) {
+
+#if defined(USE_AVCODEC)
+
+    AVFrame* f = state->frames[slot];
+    PixelBuffer& buf = frames[slot];
+    int chroma_height = 0;
+
+    switch (f->format) {
+      case AV_PIX_FMT_YUV420P: {
+        buf.pixel_format = (AVCOL_RANGE_JPEG == f->color_range) ? CA_YUVJ420P : CA_YUV420P;
+        chroma_height = (f->height + 1) / 2;
+        break;
+      }
+      case AV_PIX_FMT_YUVJ420P: {
+        buf.pixel_format = CA_YUVJ420P;
+        chroma_height = (f->height + 1) / 2;
+        break;
+      }
+      case AV_PIX_FMT_YUV422P: {
+        buf.pixel_format = CA_YUV422P;
+        chroma_height = f->height;
+        break;
+      }
+      default: {
+        error_set(CA_ERR_NOT_SUPPORTED, 0);
+        CA_LOG_ERROR("cannot use the H.264 picture, unsupported format: %d.", f->format);
+        return -1;
+      }
+    }
+
+    buf.pixels = f->data[0];
+    buf.nbytes = 0;
+
+    for (int i = 0; i < 3; ++i) {
+      buf.plane[i] = f->data[i];
+      buf.stride[i] = (size_t)f->linesize[i];
+      buf.width[i] = (0 == i) ? f->width : (f->width + 1) / 2;
+      buf.height[i] = (0 == i) ? f->height : chroma_height;
+      buf.offset[i] = 0;
+      buf.nbytes += buf.stride[i] * buf.height[i];
+    }
+
+    /* The pts is the number we gave the packet; it's missing for pictures that libavcodec made up, e.g. to conceal a lost frame. */
+    int64_t pts = f->best_effort_timestamp;
+
+    if (AV_NOPTS_VALUE != pts
+        && 0 <= pts
+        && (uint64_t)pts < num_submitted
+        && num_submitted - (uint64_t)pts <= CA_H264_DECODER_MAX_PENDING)
+      {
+        const H264PendingFrame& p = pending[pts % CA_H264_DECODER_MAX_PENDING];
+        buf.sequence = p.sequence;
+        buf.timestamp = p.timestamp;
+        buf.receive_time = p.receive_time;
+        buf.user = p.user;
+        buf.decode_time = time_now_ns() - p.submit_time;
+      }
+    else {
+      buf.sequence = 0;
+      buf.timestamp = 0;
+      buf.receive_time = 0;
+      buf.user = NULL;
+      buf.decode_time = 0;
+    }
+
+#else
+    (void)slot;
+#endif
+
+    return 0;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  bool h264_decoder_is_available() {
+#if defined(USE_AVCODEC)
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  std::vector<int> h264_decoder_get_formats() {
+
+    std::vector<int> result;
+
+#if defined(USE_AVCODEC)
+    result.push_back(CA_YUV420P);
+    result.push_back(CA_YUVJ420P);
+    result.push_back(CA_YUV422P);
+#endif
+
+    return result;
+  }
+
+} /* namespace ca */
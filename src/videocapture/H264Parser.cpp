@@ -0,0 +1,531 @@
+#include <string.h>
+#include <videocapture/H264Parser.h>
+
+#define H264_MAX_RBSP_SIZE 1024                                                     /* We parse at most this many bytes of an SPS; enough for the fields we need, even with scaling lists. */
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  /* Reads the bits of an RBSP, i.e. a NAL unit without the emulation prevention bytes. */
+  struct H264BitReader {
+    const uint8_t* data;
+    size_t nbytes;
+    size_t pos;                                                                     /* The bit position. */
+    bool error;                                                                     /* Is set when we read past the end. */
+  };
+
+  static void h264_bit_reader_init(H264BitReader& br, const uint8_t* data, size_t nbytes);
+  static uint32_t h264_read_bits(H264BitReader& br, int nbits);
+  static uint32_t h264_read_ue(H264BitReader& br);
+  static int32_t h264_read_se(H264BitReader& br);
+  static void h264_skip_scaling_list(H264BitReader& br, int size);
+  static size_t h264_get_rbsp(const uint8_t* nal, size_t nbytes, uint8_t* rbsp, size_t capacity);
+  static int h264_add_unit(const uint8_t* data, size_t start, size_t end, H264FrameInfo& info);
+
+  /* ------------------------------------------------------------------------- */
+
+  int h264_scan_frame(const uint8_t* data, size_t nbytes, H264FrameInfo& info) {
+
+    size_t i = 0;
+    size_t start = 0;
+    bool found = false;
+
+    info.num_units = 0;
+    info.sps_index = -1;
+    info.pps_index = -1;
+    info.is_idr = false;
+    info.has_slice = false;
+
+    if (NULL == data || 4 > nbytes) {
+      return -1;
+    }
+
+    /* Find the start codes; a NAL unit ends where the next start code begins. */
+    while (i + 3 <= nbytes) {
+
+      /* No start code can begin at i, i + 1 or i + 2. */
+      if (0x01 < data[i + 2]) {
+        i += 3;
+        continue;
+      }
+
+      if (0x00 != data[i] || 0x00 != data[i + 1] || 0x01 != data[i + 2]) {
+        i++;
+        continue;
+      }
+
+      if (true == found && 0 != h264_add_unit(data, start, i, info)) {
+        return -2;
+      }
+
+      found = true;
+      i += 3;
+      start = i;
+    }
+
+    if (false == found) {
+      return -3;
+    }
+
+    if (0 != h264_add_unit(data, start, nbytes, info)) {
+      return -2;
+    }
+
+    if (0 == info.num_units) {
+      return -4;
+    }
+
+    return 0;
+  }
+
+  int h264_parse_sps(const uint8_t* nal, size_t nbytes, H264Sps& sps) {
+
+    uint8_t rbsp[H264_MAX_RBSP_SIZE];
+    H264BitReader br;
+    size_t rbsp_size = 0;
+    uint32_t width_in_mbs = 0;
+    uint32_t height_in_map_units = 0;
+    uint32_t crop_left = 0;
+    uint32_t crop_right = 0;
+    uint32_t crop_top = 0;
+    uint32_t crop_bottom = 0;
+    int crop_unit_x = 1;
+    int crop_unit_y = 1;
+    bool separate_colour_plane = false;
+
+    if (NULL == nal || 4 > nbytes || CA_H264_NAL_SPS != (nal[0] & 0x1F)) {
+      return -1;
+    }
+
+    /* Skip the NAL header. */
+    rbsp_size = h264_get_rbsp(nal + 1, nbytes - 1, rbsp, sizeof(rbsp));
+    h264_bit_reader_init(br, rbsp, rbsp_size);
+
+    sps.profile_idc = (int)h264_read_bits(br, 8);
+    sps.constraint_flags = (int)h264_read_bits(br, 8);
+    sps.level_idc = (int)h264_read_bits(br, 8);
+    sps.sps_id = (int)h264_read_ue(br);
+    sps.chroma_format_idc = 1;
+    sps.bit_depth_luma = 8;
+    sps.bit_depth_chroma = 8;
+
+    if (100 == sps.profile_idc || 110 == sps.profile_idc || 122 == sps.profile_idc
+        || 244 == sps.profile_idc || 44 == sps.profile_idc || 83 == sps.profile_idc
+        || 86 == sps.profile_idc || 118 == sps.profile_idc || 128 == sps.profile_idc
+        || 138 == sps.profile_idc || 139 == sps.profile_idc || 134 == sps.profile_idc
+        || 135 == sps.profile_idc)
+    {
+      sps.chroma_format_idc = (int)h264_read_ue(br);
+
+      if (3 == sps.chroma_format_idc) {
+        separate_colour_plane = (1 == h264_read_bits(br, 1));
+      }
+
+      sps.bit_depth_luma = 8 + (int)h264_read_ue(br);
+      sps.bit_depth_chroma = 8 + (int)h264_read_ue(br);
+      h264_read_bits(br, 1);                                                        /* qpprime_y_zero_transform_bypass_flag */
+
+      if (1 == h264_read_bits(br, 1)) {                                             /* seq_scaling_matrix_present_flag */
+        int nlists = (3 != sps.chroma_format_idc) ? 8 : 12;
+        for (int i = 0; i < nlists && false == br.error; ++i) {
+          if (1 == h264_read_bits(br, 1)) {
+            h264_skip_scaling_list(br, (6 > i) ? 16 : 64);
+          }
+        }
+      }
+    }
+
+    h264_read_ue(br);                                                               /* log2_max_frame_num_minus4 */
+
+    uint32_t poc_type = h264_read_ue(br);
+
+    if (0 == poc_type) {
+      h264_read_ue(br);                                                             /* log2_max_pic_order_cnt_lsb_minus4 */
+    }
+    else if (1 == poc_type) {
+
+      h264_read_bits(br, 1);                                                        /* delta_pic_order_always_zero_flag */
+      h264_read_se(br);                                                             /* offset_for_non_ref_pic */
+      h264_read_se(br);                                                             /* offset_for_top_to_bottom_field */
+
+      uint32_t ncycle = h264_read_ue(br);
+
+      for (uint32_t i = 0; i < ncycle && false == br.error; ++i) {
+        h264_read_se(br);                                                           /* offset_for_ref_frame */
+      }
+    }
+
+    h264_read_ue(br);                                                               /* max_num_ref_frames */
+    h264_read_bits(br, 1);                                                          /* gaps_in_frame_num_value_allowed_flag */
+    width_in_mbs = h264_read_ue(br) + 1;
+    height_in_map_units = h264_read_ue(br) + 1;
+    sps.frame_mbs_only = (1 == h264_read_bits(br, 1));
+
+    if (false == sps.frame_mbs_only) {
+      h264_read_bits(br, 1);                                                        /* mb_adaptive_frame_field_flag */
+    }
+
+    h264_read_bits(br, 1);                                                          /* direct_8x8_inference_flag */
+
+    if (1 == h264_read_bits(br, 1)) {                                               /* frame_cropping_flag */
+      crop_left = h264_read_ue(br);
+      crop_right = h264_read_ue(br);
+      crop_top = h264_read_ue(br);
+      crop_bottom = h264_read_ue(br);
+    }
+
+    if (true == br.error) {
+      return -2;
+    }
+
+    /* The crop offsets are in chroma samples (Table 6-1 and 7-19 .. 7-22 of the spec). */
+    int frame_height_factor = (true == sps.frame_mbs_only) ? 1 : 2;
+
+    if (0 == sps.chroma_format_idc || true == separate_colour_plane) {
+      crop_unit_x = 1;
+      crop_unit_y = frame_height_factor;
+    }
+    else {
+      crop_unit_x = (3 == sps.chroma_format_idc) ? 1 : 2;
+      crop_unit_y = ((1 == sps.chroma_format_idc) ? 2 : 1) * frame_height_factor;
+    }
+
+    sps.width = (int)(width_in_mbs * 16) - crop_unit_x * (int)(crop_left + crop_right);
+    sps.height = (int)(height_in_map_units * 16) * frame_height_factor - crop_unit_y * (int)(crop_top + crop_bottom);
+
+    if (0 >= sps.width || 0 >= sps.height) {
+      return -3;
+    }
+
+    return 0;
+  }
+
+  size_t h264_get_avcc(const uint8_t* sps, size_t spsbytes, const uint8_t* pps, size_t ppsbytes, uint8_t* dst, size_t capacity) {
+
+    H264Sps info;
+    size_t nbytes = 11 + spsbytes + ppsbytes;
+    bool has_ext = false;
+    uint8_t* p = dst;
+
+    if (NULL == sps || NULL == pps || NULL == dst || 0 == ppsbytes || 0xFFFF < spsbytes || 0xFFFF < ppsbytes) {
+      return 0;
+    }
+
+    if (0 != h264_parse_sps(sps, spsbytes, info)) {
+      return 0;
+    }
+
+    /* The high profiles have an extension with the chroma format and bit depths. */
+    has_ext = (100 == info.profile_idc || 110 == info.profile_idc || 122 == info.profile_idc || 144 == info.profile_idc);
+
+    if (true == has_ext) {
+      nbytes += 4;
+    }
+
+    if (nbytes > capacity) {
+      return 0;
+    }
+
+    *p++ = 1;                                                                       /* configurationVersion */
+    *p++ = (uint8_t)info.profile_idc;                                               /* AVCProfileIndication */
+    *p++ = (uint8_t)info.constraint_flags;                                          /* profile_compatibility */
+    *p++ = (uint8_t)info.level_idc;                                                 /* AVCLevelIndication */
+    *p++ = 0xFF;                                                                    /* reserved (6 bits), lengthSizeMinusOne = 3 */
+    *p++ = 0xE1;                                                                    /* reserved (3 bits), numOfSequenceParameterSets = 1 */
+    *p++ = (uint8_t)(spsbytes >> 8);
+    *p++ = (uint8_t)(spsbytes & 0xFF);
+    memcpy(p, sps, spsbytes);
+    p += spsbytes;
+    *p++ = 1;                                                                       /* numOfPictureParameterSets */
+    *p++ = (uint8_t)(ppsbytes >> 8);
+    *p++ = (uint8_t)(ppsbytes & 0xFF);
+    memcpy(p, pps, ppsbytes);
+    p += ppsbytes;
+
+    if (true == has_ext) {
+      *p++ = (uint8_t)(0xFC | (info.chroma_format_idc & 0x03));
+      *p++ = (uint8_t)(0xF8 | ((info.bit_depth_luma - 8) & 0x07));
+      *p++ = (uint8_t)(0xF8 | ((info.bit_depth_chroma - 8) & 0x07));
+      *p++ = 0;                                                                     /* numOfSequenceParameterSetExt */
+    }
+
+    return nbytes;
+  }
+
+  int h264_get_chunks(const uint8_t* data, const H264FrameInfo& info, uint8_t* lengths, DataChunk* chunks) {
+
+    int nchunks = 0;
+
+    for (int i = 0; i < info.num_units; ++i) {
+
+      const H264NalUnit& unit = info.units[i];
+      uint8_t* len = lengths + 4 * i;
+
+      if (CA_H264_NAL_AUD == unit.type) {
+        continue;
+      }
+
+      len[0] = (uint8_t)((unit.nbytes >> 24) & 0xFF);
+      len[1] = (uint8_t)((unit.nbytes >> 16) & 0xFF);
+      len[2] = (uint8_t)((unit.nbytes >> 8) & 0xFF);
+      len[3] = (uint8_t)(unit.nbytes & 0xFF);
+
+      chunks[nchunks].data = len;
+      chunks[nchunks].nbytes = 4;
+      nchunks++;
+
+      chunks[nchunks].data = data + unit.offset;
+      chunks[nchunks].nbytes = unit.nbytes;
+      nchunks++;
+    }
+
+    return nchunks;
+  }
+
+  size_t h265_get_hvcc(const uint8_t* vps, size_t vpsbytes, const uint8_t* sps, size_t spsbytes, const uint8_t* pps, size_t ppsbytes, uint8_t* dst, size_t capacity) {
+
+    const uint8_t* units[3] = { vps, sps, pps };
+    size_t sizes[3] = { vpsbytes, spsbytes, ppsbytes };
+    uint8_t rbsp[H264_MAX_RBSP_SIZE];
+    size_t rbsp_size = 0;
+    size_t nbytes = 23;
+    H264BitReader br;
+    uint32_t max_sub_layers = 0;
+    uint32_t temporal_id_nesting = 0;
+    uint32_t sub_layer_flags[8] = { 0 };
+    uint32_t chroma_format_idc = 0;
+    uint32_t bit_depth_luma = 0;
+    uint32_t bit_depth_chroma = 0;
+    uint8_t* p = dst;
+
+    for (int i = 0; i < 3; ++i) {
+      if (NULL == units[i] || 2 >= sizes[i] || 0xFFFF < sizes[i]) {
+        return 0;
+      }
+      nbytes += 5 + sizes[i];
+    }
+
+    if (NULL == dst || nbytes > capacity) {
+      return 0;
+    }
+
+    if (CA_H265_NAL_SPS != ((sps[0] >> 1) & 0x3F)) {
+      return 0;
+    }
+
+    /* The SPS starts with the layer info and the profile_tier_level of 12 bytes, which the hvcC copies. */
+    rbsp_size = h264_get_rbsp(sps + 2, spsbytes - 2, rbsp, sizeof(rbsp));
+    if (13 > rbsp_size) {
+      return 0;
+    }
+
+    max_sub_layers = ((rbsp[0] >> 1) & 0x07) + 1;
+    temporal_id_nesting = rbsp[0] & 0x01;
+
+    /* Skip the sub layer profiles to get the chroma format and bit depths. */
+    h264_bit_reader_init(br, rbsp + 13, rbsp_size - 13);
+
+    for (uint32_t i = 0; i + 1 < max_sub_layers; ++i) {
+      sub_layer_flags[i] = h264_read_bits(br, 2);
+    }
+
+    if (1 < max_sub_layers) {
+      for (uint32_t i = max_sub_layers - 1; i < 8; ++i) {
+        h264_read_bits(br, 2);
+      }
+    }
+
+    for (uint32_t i = 0; i + 1 < max_sub_layers; ++i) {
+      if (0 != (sub_layer_flags[i] & 0x02)) {
+        for (int j = 0; j < 11; ++j) {
+          h264_read_bits(br, 8);
+        }
+      }
+      if (0 != (sub_layer_flags[i] & 0x01)) {
+        h264_read_bits(br, 8);
+      }
+    }
+
+    h264_read_ue(br);                                                               /* sps_seq_parameter_set_id */
+    chroma_format_idc = h264_read_ue(br);
+
+    if (3 == chroma_format_idc) {
+      h264_read_bits(br, 1);                                                        /* separate_colour_plane_flag */
+    }
+
+    h264_read_ue(br);                                                               /* pic_width_in_luma_samples */
+    h264_read_ue(br);                                                               /* pic_height_in_luma_samples */
+
+    if (1 == h264_read_bits(br, 1)) {                                               /* conformance_window_flag */
+      for (int i = 0; i < 4; ++i) {
+        h264_read_ue(br);
+      }
+    }
+
+    bit_depth_luma = h264_read_ue(br);
+    bit_depth_chroma = h264_read_ue(br);
+
+    if (true == br.error || 3 < chroma_format_idc || 7 < bit_depth_luma || 7 < bit_depth_chroma) {
+      return 0;
+    }
+
+    *p++ = 1;                                                                       /* configurationVersion */
+    memcpy(p, rbsp + 1, 12);                                                        /* profile space, tier, profile, compatibility and constraint flags, level */
+    p += 12;
+    *p++ = 0xF0;                                                                    /* reserved (4 bits), min_spatial_segmentation_idc = 0 */
+    *p++ = 0x00;
+    *p++ = 0xFC;                                                                    /* reserved (6 bits), parallelismType = 0, unknown */
+    *p++ = (uint8_t)(0xFC | chroma_format_idc);
+    *p++ = (uint8_t)(0xF8 | bit_depth_luma);
+    *p++ = (uint8_t)(0xF8 | bit_depth_chroma);
+    *p++ = 0x00;                                                                    /* avgFrameRate, unknown */
+    *p++ = 0x00;
+    *p++ = (uint8_t)((max_sub_layers << 3) | (temporal_id_nesting << 2) | 0x03);    /* constantFrameRate = 0, numTemporalLayers, temporalIdNested, lengthSizeMinusOne = 3 */
+    *p++ = 3;                                                                       /* numOfArrays */
+
+    for (int i = 0; i < 3; ++i) {
+      *p++ = (uint8_t)(0x80 | ((units[i][0] >> 1) & 0x3F));                         /* array_completeness, NAL_unit_type */
+      *p++ = 0;                                                                     /* numNalus = 1 */
+      *p++ = 1;
+      *p++ = (uint8_t)(sizes[i] >> 8);
+      *p++ = (uint8_t)(sizes[i] & 0xFF);
+      memcpy(p, units[i], sizes[i]);
+      p += sizes[i];
+    }
+
+    return nbytes;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  static void h264_bit_reader_init(H264BitReader& br, const uint8_t* data, size_t nbytes) {
+    br.data = data;
+    br.nbytes = nbytes;
+    br.pos = 0;
+    br.error = false;
+  }
+
+  static uint32_t h264_read_bits(H264BitReader& br, int nbits) {
+
+    uint32_t v = 0;
+
+    for (int i = 0; i < nbits; ++i) {
+
+      if ((br.pos >> 3) >= br.nbytes) {
+        br.error = true;
+        return 0;
+      }
+
+      v = (v << 1) | ((br.data[br.pos >> 3] >> (7 - (br.pos & 7))) & 0x01);
+      br.pos++;
+    }
+
+    return v;
+  }
+
+  /* Exp-Golomb code: n leading zeros, a one, then n bits. */
+  static uint32_t h264_read_ue(H264BitReader& br) {
+
+    int nzeros = 0;
+
+    while (0 == h264_read_bits(br, 1)) {
+      if (true == br.error || 31 < nzeros) {
+        br.error = true;
+        return 0;
+      }
+      nzeros++;
+    }
+
+    return ((1u << nzeros) - 1) + h264_read_bits(br, nzeros);
+  }
+
+  static int32_t h264_read_se(H264BitReader& br) {
+
+    uint32_t v = h264_read_ue(br);
+
+    if (0 != (v & 1)) {
+      return (int32_t)((v + 1) / 2);
+    }
+
+    return -(int32_t)(v / 2);
+  }
+
+  static void h264_skip_scaling_list(H264BitReader& br, int size) {
+
+    int last_scale = 8;
+    int next_scale = 8;
+
+    for (int i = 0; i < size && false == br.error; ++i) {
+
+      if (0 != next_scale) {
+        int delta = h264_read_se(br);
+        next_scale = (last_scale + delta + 256) % 256;
+      }
+
+      last_scale = (0 == next_scale) ? last_scale : next_scale;
+    }
+  }
+
+  /* Adds the NAL unit between two start codes. */
+  static int h264_add_unit(const uint8_t* data, size_t start, size_t end, H264FrameInfo& info) {
+
+    /* Trailing zeros belong to the next start code (00 00 00 01) or are padding. */
+    while (end > start && 0x00 == data[end - 1]) {
+      end--;
+    }
+
+    if (end == start) {
+      return 0;
+    }
+
+    if (CA_H264_MAX_NAL_UNITS == info.num_units) {
+      return -1;
+    }
+
+    H264NalUnit& unit = info.units[info.num_units];
+    unit.offset = start;
+    unit.nbytes = end - start;
+    unit.type = data[start] & 0x1F;
+    unit.ref_idc = (data[start] >> 5) & 0x03;
+
+    if (CA_H264_NAL_SPS == unit.type && -1 == info.sps_index) {
+      info.sps_index = info.num_units;
+    }
+    else if (CA_H264_NAL_PPS == unit.type && -1 == info.pps_index) {
+      info.pps_index = info.num_units;
+    }
+    else if (CA_H264_NAL_IDR == unit.type) {
+      info.is_idr = true;
+      info.has_slice = true;
+    }
+    else if (CA_H264_NAL_SLICE == unit.type) {
+      info.has_slice = true;
+    }
+
+    info.num_units++;
+
+    return 0;
+  }
+
+  /* Removes the emulation prevention bytes (the 03 in 00 00 03); stops when `rbsp` is full. */
+  static size_t h264_get_rbsp(const uint8_t* nal, size_t nbytes, uint8_t* rbsp, size_t capacity) {
+
+    size_t n = 0;
+    int nzeros = 0;
+
+    for (size_t i = 0; i < nbytes && n < capacity; ++i) {
+
+      if (2 <= nzeros && 0x03 == nal[i]) {
+        nzeros = 0;
+        continue;
+      }
+
+      nzeros = (0x00 == nal[i]) ? nzeros + 1 : 0;
+      rbsp[n++] = nal[i];
+    }
+
+    return n;
+  }
+
+} /* namespace ca */
@@ -0,0 +1,223 @@
+#include <string.h>
+#include <videocapture/JpegMarkers.h>
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  /*
+    The default Huffman tables from ITU T.81, Annex K.3, as one DHT segment.
+    Every table is: class << 4 | id, 16 code counts, the symbols.
+  */
+  static const uint8_t jpeg_default_dht[] = {
+
+    0xFF, 0xC4, 0x01, 0xA2,
+
+    /* Luminance DC */
+    0x00,
+    0x00, 0x01, 0x05, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B,
+
+    /* Luminance AC */
+    0x10,
+    0x00, 0x02, 0x01, 0x03, 0x03, 0x02, 0x04, 0x03, 0x05, 0x05, 0x04, 0x04, 0x00, 0x00, 0x01, 0x7D,
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08, 0x23, 0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0A, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7,
+    0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5,
+    0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2,
+    0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+    0xF9, 0xFA,
+
+    /* Chrominance DC */
+    0x01,
+    0x00, 0x03, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B,
+
+    /* Chrominance AC */
+    0x11,
+    0x00, 0x02, 0x01, 0x02, 0x04, 0x04, 0x03, 0x04, 0x07, 0x05, 0x04, 0x04, 0x00, 0x01, 0x02, 0x77,
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+    0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xA1, 0xB1, 0xC1, 0x09, 0x23, 0x33, 0x52, 0xF0,
+    0x15, 0x62, 0x72, 0xD1, 0x0A, 0x16, 0x24, 0x34, 0xE1, 0x25, 0xF1, 0x17, 0x18, 0x19, 0x1A, 0x26,
+    0x27, 0x28, 0x29, 0x2A, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+    0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5,
+    0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3,
+    0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA,
+    0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+    0xF9, 0xFA
+  };
+
+  static const uint8_t jpeg_eoi[] = { 0xFF, 0xD9 };
+
+  /* ------------------------------------------------------------------------- */
+
+  int jpeg_scan_markers(const uint8_t* data, size_t nbytes, JpegMarkerInfo& info) {
+
+    size_t pos = 2;
+    size_t len = 0;
+    int marker = 0;
+
+    memset(&info, 0, sizeof(info));
+
+    if (NULL == data || 4 > nbytes || 0xFF != data[0] || 0xD8 != data[1]) {
+      return -1;
+    }
+
+    while (pos + 4 <= nbytes) {
+
+      if (0xFF != data[pos]) {
+        return -2;
+      }
+
+      /* Markers may be preceded by any number of 0xFF fill bytes. */
+      while (pos + 1 < nbytes && 0xFF == data[pos + 1]) {
+        pos++;
+      }
+
+      if (pos + 4 > nbytes) {
+        break;
+      }
+
+      marker = data[pos + 1];
+
+      /* TEM and RSTn are the only markers without a length in the header. */
+      if (0x01 == marker || (0xD0 <= marker && 0xD7 >= marker)) {
+        pos += 2;
+        continue;
+      }
+
+      /* A SOI or EOI before the scan: not a single, complete frame. */
+      if (0xD8 == marker || 0xD9 == marker) {
+        return -5;
+      }
+
+      len = ((size_t)data[pos + 2] << 8) | (size_t)data[pos + 3];
+      if (2 > len || pos + 2 + len > nbytes) {
+        return -3;
+      }
+
+      if (0xDA == marker) {
+        info.sos_offset = pos;
+        break;
+      }
+
+      if (0xC4 == marker) {
+        info.has_dht = true;
+      }
+      else if (0xDB == marker) {
+        info.has_dqt = true;
+      }
+      else if (0xC0 <= marker && 0xCF >= marker && 0xC8 != marker && 0xCC != marker) {
+
+        /* SOFn: precision, height, width, number of components. */
+        if (8 > len) {
+          return -4;
+        }
+
+        info.sof_offset = pos;
+        info.sof_marker = marker;
+        info.height = (data[pos + 5] << 8) | data[pos + 6];
+        info.width = (data[pos + 7] << 8) | data[pos + 8];
+        info.num_components = data[pos + 9];
+      }
+
+      pos += 2 + len;
+    }
+
+    if (0 == info.sof_offset || 0 == info.sos_offset) {
+      return -6;
+    }
+
+    /* The EOI is at the end, followed by at most some padding; search backwards so we don't have to walk the scan. */
+    for (pos = nbytes - 2; pos > info.sos_offset; --pos) {
+      if (0xFF == data[pos] && 0xD9 == data[pos + 1]) {
+        info.eoi_offset = pos;
+        break;
+      }
+    }
+
+    return 0;
+  }
+
+  int jpeg_get_chunks(const uint8_t* data, size_t nbytes, const JpegMarkerInfo& info, JpegChunk* chunks) {
+
+    int n = 0;
+
+    if (NULL == data || NULL == chunks || 0 == info.sos_offset || info.sos_offset >= nbytes) {
+      return 0;
+    }
+
+    /* Frames that are complete are passed on as one chunk. */
+    if (true == info.has_dht && 0 != info.eoi_offset) {
+      chunks[0].data = data;
+      chunks[0].nbytes = info.eoi_offset + 2;
+      return 1;
+    }
+
+    /* Any place in front of the SOS is fine for the tables; this keeps the header untouched. */
+    if (false == info.has_dht) {
+      chunks[n].data = data;
+      chunks[n].nbytes = info.sos_offset;
+      n++;
+      chunks[n].data = jpeg_default_dht;
+      chunks[n].nbytes = sizeof(jpeg_default_dht);
+      n++;
+      chunks[n].data = data + info.sos_offset;
+      chunks[n].nbytes = ((0 != info.eoi_offset) ? (info.eoi_offset + 2) : nbytes) - info.sos_offset;
+      n++;
+    }
+    else {
+      chunks[n].data = data;
+      chunks[n].nbytes = nbytes;
+      n++;
+    }
+
+    if (0 == info.eoi_offset) {
+      chunks[n].data = jpeg_eoi;
+      chunks[n].nbytes = sizeof(jpeg_eoi);
+      n++;
+    }
+
+    return n;
+  }
+
+  size_t jpeg_get_chunks_size(const JpegChunk* chunks, int nchunks) {
+
+    size_t result = 0;
+
+    for (int i = 0; i < nchunks; ++i) {
+      result += chunks[i].nbytes;
+    }
+
+    return result;
+  }
+
+  size_t jpeg_copy_chunks(const JpegChunk* chunks, int nchunks, uint8_t* dst, size_t capacity) {
+
+    size_t pos = 0;
+
+    if (NULL == dst || jpeg_get_chunks_size(chunks, nchunks) > capacity) {
+      return 0;
+    }
+
+    for (int i = 0; i < nchunks; ++i) {
+      memcpy(dst + pos, chunks[i].data, chunks[i].nbytes);
+      pos += chunks[i].nbytes;
+    }
+
+    return pos;
+  }
+
+  const uint8_t* jpeg_get_default_dht(size_t& nbytes) {
+    nbytes = sizeof(jpeg_default_dht);
+    return jpeg_default_dht;
+  }
+
+} /* namespace ca */
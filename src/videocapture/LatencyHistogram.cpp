@@ -0,0 +1,128 @@
+#include <string.h>
+#include <videocapture/LatencyHistogram.h>
+
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#endif
+
+namespace ca {
+
+  /* The index of the highest bit that is set; `v` must not be 0. */
+  static inline int latency_histogram_msb(uint64_t v) {
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(v);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long dx = 0;
+    _BitScanReverse64(&dx, v);
+    return (int)dx;
+#else
+    int dx = 0;
+    while (v >>= 1) {
+      dx++;
+    }
+    return dx;
+#endif
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  LatencyHistogram::LatencyHistogram() {
+    reset();
+  }
+
+  void LatencyHistogram::reset() {
+    memset(counts, 0, sizeof(counts));
+    total = 0;
+    min = 0;
+    max = 0;
+    sum = 0;
+  }
+
+  void LatencyHistogram::record(uint64_t ns) {
+
+    counts[latency_histogram_get_bucket(ns)]++;
+
+    if (0 == total || ns < min) {
+      min = ns;
+    }
+
+    if (ns > max) {
+      max = ns;
+    }
+
+    total++;
+    sum += ns;
+  }
+
+  double LatencyHistogram::getMean() {
+    return (0 == total) ? 0.0 : (double)sum / (double)total;
+  }
+
+  uint64_t LatencyHistogram::getPercentile(double p) {
+
+    uint64_t n = 0;
+    uint64_t rank = 0;
+    uint64_t seen = 0;
+
+    /* We count again instead of using `total`, a copy that was made while recording may be off by one. */
+    for (int i = 0; i < CA_LATENCY_NUM_BUCKETS; ++i) {
+      n += counts[i];
+    }
+
+    if (0 == n) {
+      return 0;
+    }
+
+    p = (p < 0.0) ? 0.0 : ((p > 100.0) ? 100.0 : p);
+    rank = (uint64_t)((p / 100.0) * (double)n + 0.5);
+    rank = (0 == rank) ? 1 : rank;
+
+    for (int i = 0; i < CA_LATENCY_NUM_BUCKETS; ++i) {
+
+      seen += counts[i];
+
+      if (seen >= rank) {
+        uint64_t result = latency_histogram_get_bucket_max(i);
+        /* The last bucket also counts everything that's too large for it. */
+        return (result > max || CA_LATENCY_NUM_BUCKETS - 1 == i) ? max : result;
+      }
+    }
+
+    return max;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  int latency_histogram_get_bucket(uint64_t ns) {
+
+    static const uint64_t sub_count = 1ull << CA_LATENCY_SUB_BITS;
+
+    if (ns < 2 * sub_count) {
+      return (int)ns;
+    }
+
+    if (ns >> CA_LATENCY_MAX_BITS) {
+      return CA_LATENCY_NUM_BUCKETS - 1;
+    }
+
+    /* The top CA_LATENCY_SUB_BITS + 1 bits select the bucket within the power of two. */
+    int shift = latency_histogram_msb(ns) - CA_LATENCY_SUB_BITS;
+
+    return (int)(((uint64_t)shift << CA_LATENCY_SUB_BITS) + (ns >> shift));
+  }
+
+  uint64_t latency_histogram_get_bucket_max(int bucket) {
+
+    static const int sub_count = 1 << CA_LATENCY_SUB_BITS;
+
+    if (bucket < 2 * sub_count) {
+      return (uint64_t)bucket;
+    }
+
+    int shift = (bucket >> CA_LATENCY_SUB_BITS) - 1;
+    uint64_t sub = (uint64_t)(bucket - (shift << CA_LATENCY_SUB_BITS));
+
+    return ((sub + 1) << shift) - 1;
+  }
+
+} /* namespace ca */
@@ -0,0 +1,340 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <vector>
+#include <videocapture/Log.h>
+#include <videocapture/Thread.h>
+#include <videocapture/Utils.h>
+
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#  define snprintf _snprintf
+#  define vsnprintf _vsnprintf
+#endif
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  struct LogMessage {
+    int level;
+    char text[CA_LOG_MAX_MESSAGE];
+  };
+
+  struct LogState {
+    LogState();
+    Mutex mutex;                                                                    /* Protects the queue and the async state. */
+    Cond cond;                                                                      /* Signalled when a message was queued or we must stop. */
+    Thread thread;                                                                  /* The log thread. */
+    log_callback cb;                                                                /* Receives the messages. */
+    void* user;                                                                     /* Passed into `cb`. */
+    volatile int level;                                                             /* The most verbose level we log. */
+    bool is_async;                                                                  /* Is true while the log thread runs. */
+    bool must_stop;                                                                 /* Tells the log thread to stop once the queue is empty. */
+    LogMessage queue[CA_LOG_QUEUE_SIZE];                                            /* A ring of messages for the log thread. */
+    size_t queue_head;                                                              /* The oldest message. */
+    size_t queue_count;                                                             /* The number of queued messages. */
+    uint64_t num_dropped;                                                           /* Dropped because the queue was full. */
+    uint64_t num_reported;                                                          /* The drops the log thread reported. */
+    volatile uint64_t num_suppressed;                                               /* Suppressed by the rate limit. */
+  };
+
+  /* ------------------------------------------------------------------------- */
+
+  static LogState log_state;
+
+  static void log_print(int level, const char* message, void* user);
+  static void log_dispatch(int level, const char* text);
+  static void log_thread_main(void* user);
+  static void log_report_dropped(uint64_t ndropped);
+
+  /* ------------------------------------------------------------------------- */
+
+  LogState::LogState()
+    :cb(log_print)
+    ,user(NULL)
+    ,level(CA_LOG_LEVEL_INFO)
+    ,is_async(false)
+    ,must_stop(false)
+    ,queue_head(0)
+    ,queue_count(0)
+    ,num_dropped(0)
+    ,num_reported(0)
+    ,num_suppressed(0)
+  {
+    mutex_create(mutex);
+    cond_create(cond);
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  void log_set_level(int level) {
+    log_state.level = level;
+  }
+
+  int log_get_level() {
+    return log_state.level;
+  }
+
+  void log_set_callback(log_callback cb, void* user) {
+
+    mutex_lock(log_state.mutex);
+    {
+      log_state.cb = (NULL == cb) ? log_print : cb;
+      log_state.user = (NULL == cb) ? NULL : user;
+    }
+    mutex_unlock(log_state.mutex);
+  }
+
+  int log_start_async() {
+
+    int r = 0;
+
+    mutex_lock(log_state.mutex);
+    {
+      if (false == log_state.is_async) {
+
+        log_state.must_stop = false;
+
+        if (0 != thread_create(log_state.thread, log_thread_main, NULL)) {
+          r = -1;
+        }
+        else {
+          log_state.is_async = true;
+        }
+      }
+    }
+    mutex_unlock(log_state.mutex);
+
+    if (0 != r) {
+      CA_LOG_ERROR("cannot create the log thread.");
+    }
+
+    return r;
+  }
+
+  int log_stop_async() {
+
+    std::vector<LogMessage> messages;
+    uint64_t ndropped = 0;
+
+    mutex_lock(log_state.mutex);
+    {
+      if (false == log_state.is_async) {
+        mutex_unlock(log_state.mutex);
+        return 0;
+      }
+
+      log_state.must_stop = true;
+      cond_signal(log_state.cond);
+    }
+    mutex_unlock(log_state.mutex);
+
+    if (0 != thread_join(log_state.thread)) {
+      return -1;
+    }
+
+    /* Write what was queued after the log thread stopped; we're synchronous again, so this is also how a callback that logs is handled. */
+    mutex_lock(log_state.mutex);
+    {
+      log_state.is_async = false;
+
+      while (0 != log_state.queue_count) {
+        messages.push_back(log_state.queue[log_state.queue_head]);
+        log_state.queue_head = (log_state.queue_head + 1) % CA_LOG_QUEUE_SIZE;
+        log_state.queue_count--;
+      }
+
+      ndropped = log_state.num_dropped - log_state.num_reported;
+      log_state.num_reported = log_state.num_dropped;
+    }
+    mutex_unlock(log_state.mutex);
+
+    for (size_t i = 0; i < messages.size(); ++i) {
+      log_dispatch(messages[i].level, messages[i].text);
+    }
+
+    log_report_dropped(ndropped);
+
+    return 0;
+  }
+
+  uint64_t log_get_num_dropped() {
+
+    uint64_t n = 0;
+
+    mutex_lock(log_state.mutex);
+    n = log_state.num_dropped;
+    mutex_unlock(log_state.mutex);
+
+    return n;
+  }
+
+  uint64_t log_get_num_suppressed() {
+    return log_state.num_suppressed;
+  }
+
+  const char* log_level_to_string(int level) {
+    switch (level) {
+      case CA_LOG_LEVEL_NONE: return "none";
+      case CA_LOG_LEVEL_ERROR: return "error";
+      case CA_LOG_LEVEL_WARNING: return "warning";
+      case CA_LOG_LEVEL_INFO: return "info";
+      case CA_LOG_LEVEL_DEBUG: return "debug";
+      default: return "unknown";
+    }
+  }
+
+  void log_write(LogSite* site, int level, const char* fmt, ...) {
+
+    char text[CA_LOG_MAX_MESSAGE];
+    uint32_t nsuppressed = 0;
+    size_t len = 0;
+    va_list args;
+
+    if (CA_LOG_LEVEL_NONE >= level || level > log_state.level) {
+      return;
+    }
+
+    if (NULL != site) {
+
+      uint64_t now = time_now_ns();
+
+      if (0 == site->window_start || now - site->window_start >= CA_LOG_RATE_WINDOW_NS) {
+        nsuppressed = site->suppressed;
+        site->window_start = now;
+        site->count = 0;
+        site->suppressed = 0;
+      }
+
+      if (site->count >= CA_LOG_RATE_LIMIT) {
+        site->suppressed++;
+        log_state.num_suppressed = log_state.num_suppressed + 1;
+        return;
+      }
+
+      site->count++;
+    }
+
+    va_start(args, fmt);
+    vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+
+    text[sizeof(text) - 1] = '\0';
+    len = strlen(text);
+
+    while (0 != len && '\n' == text[len - 1]) {
+      text[--len] = '\0';
+    }
+
+    if (0 != nsuppressed && len < sizeof(text)) {
+      snprintf(text + len, sizeof(text) - len, " (%u similar messages were suppressed)", (unsigned int)nsuppressed);
+      text[sizeof(text) - 1] = '\0';
+    }
+
+    log_dispatch(level, text);
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  static void log_print(int level, const char* message, void* user) {
+
+    (void)user;
+
+    switch (level) {
+      case CA_LOG_LEVEL_ERROR: printf("Error: %s\n", message); break;
+      case CA_LOG_LEVEL_WARNING: printf("Warning: %s\n", message); break;
+      case CA_LOG_LEVEL_DEBUG: printf("Debug: %s\n", message); break;
+      default: printf("%s\n", message); break;
+    }
+  }
+
+  /* Calls the callback, or queues the message for the log thread; we never wait for I/O while the log thread runs. */
+  static void log_dispatch(int level, const char* text) {
+
+    log_callback cb = NULL;
+    void* user = NULL;
+
+    mutex_lock(log_state.mutex);
+
+    if (true == log_state.is_async) {
+
+      if (CA_LOG_QUEUE_SIZE == log_state.queue_count) {
+        log_state.num_dropped++;
+      }
+      else {
+        LogMessage& msg = log_state.queue[(log_state.queue_head + log_state.queue_count) % CA_LOG_QUEUE_SIZE];
+        msg.level = level;
+        memcpy(msg.text, text, strlen(text) + 1);
+        log_state.queue_count++;
+        cond_signal(log_state.cond);
+      }
+
+      mutex_unlock(log_state.mutex);
+      return;
+    }
+
+    cb = log_state.cb;
+    user = log_state.user;
+
+    mutex_unlock(log_state.mutex);
+
+    cb(level, text, user);
+  }
+
+  static void log_thread_main(void* user) {
+
+    LogMessage msg;
+    log_callback cb = NULL;
+    void* cb_user = NULL;
+    uint64_t ndropped = 0;
+
+    (void)user;
+
+    mutex_lock(log_state.mutex);
+
+    while (true) {
+
+      while (false == log_state.must_stop && 0 == log_state.queue_count) {
+        cond_wait(log_state.cond, log_state.mutex);
+      }
+
+      if (0 == log_state.queue_count) {
+        break;
+      }
+
+      msg = log_state.queue[log_state.queue_head];
+      log_state.queue_head = (log_state.queue_head + 1) % CA_LOG_QUEUE_SIZE;
+      log_state.queue_count--;
+
+      ndropped = log_state.num_dropped - log_state.num_reported;
+      log_state.num_reported = log_state.num_dropped;
+      cb = log_state.cb;
+      cb_user = log_state.user;
+
+      /* The callback may block (e.g. on stdout); the capture threads keep queueing meanwhile. */
+      mutex_unlock(log_state.mutex);
+      {
+        cb(msg.level, msg.text, cb_user);
+
+        if (0 != ndropped) {
+          char text[128];
+          snprintf(text, sizeof(text), "the log queue was full; dropped %llu messages.", (unsigned long long)ndropped);
+          cb(CA_LOG_LEVEL_WARNING, text, cb_user);
+        }
+      }
+      mutex_lock(log_state.mutex);
+    }
+
+    mutex_unlock(log_state.mutex);
+  }
+
+  static void log_report_dropped(uint64_t ndropped) {
+
+    if (0 == ndropped) {
+      return;
+    }
+
+    log_write(NULL, CA_LOG_LEVEL_WARNING, "the log queue was full; dropped %llu messages.", (unsigned long long)ndropped);
+  }
+
+} /* namespace ca */
@@ -0,0 +1,248 @@
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <videocapture/LosslessCodec.h>
+
+#if defined(USE_LZ4)
+#  include <lz4.h>
+#endif
+
+#if defined(USE_ZSTD)
+#  include <zstd.h>
+#endif
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  struct LosslessCompressorState {
+#if defined(USE_LZ4)
+    std::vector<char> lz4_state;                                                    /* See LZ4_compress_fast_extState(). */
+#endif
+#if defined(USE_ZSTD)
+    ZSTD_CCtx* zstd_context;
+#endif
+    int unused;                                                                     /* So the struct isn't empty without libraries. */
+  };
+
+  /* ------------------------------------------------------------------------- */
+
+  LosslessCompressor::LosslessCompressor()
+    :state(NULL)
+    ,method(CA_COMPRESS_NONE)
+    ,level(0)
+  {
+  }
+
+  LosslessCompressor::~LosslessCompressor() {
+    shutdown();
+  }
+
+  int LosslessCompressor::init(int m, int l) {
+
+    if (NULL != state) {
+      printf("Error: cannot initialize the lossless compressor, already initialized.\n");
+      return -1;
+    }
+
+    if (false == lossless_is_available(m)) {
+      printf("Error: compression method %d is not available; compile with USE_LZ4 or USE_ZSTD.\n", m);
+      return -2;
+    }
+
+    state = new LosslessCompressorState();
+    state->unused = 0;
+    method = m;
+    level = (0 < l) ? l : 1;
+
+#if defined(USE_LZ4)
+    if (CA_COMPRESS_LZ4 == method) {
+      state->lz4_state.resize(LZ4_sizeofState());
+    }
+#endif
+
+#if defined(USE_ZSTD)
+    state->zstd_context = NULL;
+    if (CA_COMPRESS_ZSTD == method) {
+      state->zstd_context = ZSTD_createCCtx();
+      if (NULL == state->zstd_context) {
+        printf("Error: cannot create the Zstandard context.\n");
+        shutdown();
+        return -3;
+      }
+    }
+#endif
+
+    return 0;
+  }
+
+  int LosslessCompressor::shutdown() {
+
+    if (NULL == state) {
+      return 0;
+    }
+
+#if defined(USE_ZSTD)
+    if (NULL != state->zstd_context) {
+      ZSTD_freeCCtx(state->zstd_context);
+      state->zstd_context = NULL;
+    }
+#endif
+
+    delete state;
+    state = NULL;
+    method = CA_COMPRESS_NONE;
+
+    return 0;
+  }
+
+  size_t LosslessCompressor::compress(const uint8_t* src, size_t nbytes, uint8_t* dst, size_t capacity) {
+
+    if (NULL == state || NULL == src || NULL == dst) {
+      return 0;
+    }
+
+    if (CA_COMPRESS_NONE == method) {
+      if (nbytes > capacity) {
+        return 0;
+      }
+      memcpy(dst, src, nbytes);
+      return nbytes;
+    }
+
+#if defined(USE_LZ4)
+    if (CA_COMPRESS_LZ4 == method) {
+      int r = LZ4_compress_fast_extState(&state->lz4_state[0], (const char*)src, (char*)dst, (int)nbytes, (int)capacity, level);
+      return (0 < r) ? (size_t)r : 0;
+    }
+#endif
+
+#if defined(USE_ZSTD)
+    if (CA_COMPRESS_ZSTD == method) {
+      size_t r = ZSTD_compressCCtx(state->zstd_context, dst, capacity, src, nbytes, level);
+      return (0 == ZSTD_isError(r)) ? r : 0;
+    }
+#endif
+
+    return 0;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  bool lossless_is_available(int method) {
+
+    if (CA_COMPRESS_NONE == method) {
+      return true;
+    }
+
+#if defined(USE_LZ4)
+    if (CA_COMPRESS_LZ4 == method) {
+      return true;
+    }
+#endif
+
+#if defined(USE_ZSTD)
+    if (CA_COMPRESS_ZSTD == method) {
+      return true;
+    }
+#endif
+
+    return false;
+  }
+
+  size_t lossless_get_bound(int method, size_t nbytes) {
+
+#if defined(USE_LZ4)
+    if (CA_COMPRESS_LZ4 == method) {
+      return (size_t)LZ4_compressBound((int)nbytes);
+    }
+#endif
+
+#if defined(USE_ZSTD)
+    if (CA_COMPRESS_ZSTD == method) {
+      return ZSTD_compressBound(nbytes);
+    }
+#endif
+
+    (void)method;
+
+    return nbytes;
+  }
+
+  int lossless_decompress(int method, const uint8_t* src, size_t nbytes, uint8_t* dst, size_t rawbytes) {
+
+    if (NULL == src || NULL == dst) {
+      return -1;
+    }
+
+    if (CA_COMPRESS_NONE == method) {
+      if (nbytes != rawbytes) {
+        return -2;
+      }
+      memcpy(dst, src, nbytes);
+      return 0;
+    }
+
+#if defined(USE_LZ4)
+    if (CA_COMPRESS_LZ4 == method) {
+      int r = LZ4_decompress_safe((const char*)src, (char*)dst, (int)nbytes, (int)rawbytes);
+      return ((int)rawbytes == r) ? 0 : -3;
+    }
+#endif
+
+#if defined(USE_ZSTD)
+    if (CA_COMPRESS_ZSTD == method) {
+      size_t r = ZSTD_decompress(dst, rawbytes, src, nbytes);
+      return (0 == ZSTD_isError(r) && rawbytes == r) ? 0 : -3;
+    }
+#endif
+
+    printf("Error: cannot decompress, compression method %d is not available.\n", method);
+
+    return -4;
+  }
+
+  void lossless_delta_rows(uint8_t* data, size_t stride, size_t height) {
+
+    /* Bottom to top, so the row above still has its original values. */
+    for (size_t y = height - 1; 0 < y && y < height; --y) {
+
+      uint8_t* row = data + y * stride;
+      const uint8_t* above = row - stride;
+
+      for (size_t x = 0; x < stride; ++x) {
+        row[x] = (uint8_t)(row[x] - above[x]);
+      }
+    }
+  }
+
+  void lossless_undelta_rows(uint8_t* data, size_t stride, size_t height) {
+
+    for (size_t y = 1; y < height; ++y) {
+
+      uint8_t* row = data + y * stride;
+      const uint8_t* above = row - stride;
+
+      for (size_t x = 0; x < stride; ++x) {
+        row[x] = (uint8_t)(row[x] + above[x]);
+      }
+    }
+  }
+
+  void lossless_delta_frame(const uint8_t* cur, uint8_t* prev, uint8_t* dst, size_t nbytes) {
+
+    for (size_t i = 0; i < nbytes; ++i) {
+      dst[i] = (uint8_t)(cur[i] - prev[i]);
+      prev[i] = cur[i];
+    }
+  }
+
+  void lossless_undelta_frame(uint8_t* data, uint8_t* prev, size_t nbytes) {
+
+    for (size_t i = 0; i < nbytes; ++i) {
+      data[i] = (uint8_t)(data[i] + prev[i]);
+      prev[i] = data[i];
+    }
+  }
+
+} /* namespace ca */
@@ -0,0 +1,547 @@
+#include <stdio.h>
+#include <string.h>
+#include <videocapture/Utils.h>
+#include <videocapture/Trace.h>
+#include <videocapture/LosslessRecorder.h>
+
+/* The states of a frame; a frame goes from free to filling, queued, compressing, compressed, writing and back to free. */
+#define LOSSLESS_FRAME_FREE 0
+#define LOSSLESS_FRAME_FILLING 1
+#define LOSSLESS_FRAME_QUEUED 2
+#define LOSSLESS_FRAME_COMPRESSING 3
+#define LOSSLESS_FRAME_COMPRESSED 4
+#define LOSSLESS_FRAME_WRITING 5
+
+namespace ca {
+
+  LosslessSettings::LosslessSettings()
+    :compression(CA_COMPRESS_LZ4)
+    ,filter(CA_FILTER_ROW_DELTA)
+    ,level(0)
+    ,threads(0)
+    ,keyint(30)
+    ,max_frames(0)
+    ,alignment(CA_FRAME_FILE_ALIGNMENT)
+  {
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  LosslessRecorder::LosslessRecorder()
+    :frame_nbytes(0)
+    ,next_order(0)
+    ,frames_until_key(0)
+    ,num_written(0)
+    ,num_dropped(0)
+    ,num_failed(0)
+    ,num_bytes_in(0)
+    ,num_bytes_out(0)
+    ,is_open(false)
+    ,is_writing(false)
+    ,must_stop(false)
+  {
+    for (int i = 0; i < CA_FRAME_FILE_MAX_PLANES; ++i) {
+      plane_offset[i] = 0;
+      packed_offset[i] = 0;
+    }
+  }
+
+  LosslessRecorder::~LosslessRecorder() {
+    if (true == is_open) {
+      close();
+    }
+  }
+
+  int LosslessRecorder::open(const std::string& filepath, int w, int h, int fmt, int fps, const LosslessSettings& cfg) {
+
+    size_t packed_nbytes = 0;
+    int nthreads = cfg.threads;
+    int maxframes = cfg.max_frames;
+
+    if (true == is_open) {
+      printf("Error: cannot open %s, the lossless recorder is already open.\n", filepath.c_str());
+      return -1;
+    }
+
+    if (0 > nthreads || 0 > maxframes) {
+      printf("Error: invalid number of compression threads (%d) or frames (%d).\n", nthreads, maxframes);
+      return -2;
+    }
+
+    if (false == lossless_is_available(cfg.compression)) {
+      printf("Error: compression method %d is not available; compile with USE_LZ4 or USE_ZSTD.\n", cfg.compression);
+      return -3;
+    }
+
+    header = FrameFileHeader();
+
+    if (0 != frame_file_get_layout(w, h, fmt, header)) {
+      return -4;
+    }
+
+    header.fps = fps;
+    header.compression = cfg.compression;
+    header.filter = cfg.filter & (CA_FILTER_ROW_DELTA | CA_FILTER_FRAME_DELTA);
+    header.alignment = cfg.alignment;
+
+    if (0 != writer.open(filepath, header)) {
+      return -5;
+    }
+
+    if (0 == nthreads) {
+      nthreads = cpu_count();
+    }
+
+    if (0 == maxframes) {
+      maxframes = 2 * nthreads;
+    }
+
+    /* The planes one after another in `raw`; in `packed` every plane gets room for its worst case. */
+    frame_nbytes = 0;
+
+    for (int i = 0; i < header.num_planes; ++i) {
+      size_t nbytes = (size_t)header.plane_stride[i] * header.plane_height[i];
+      plane_offset[i] = frame_nbytes;
+      packed_offset[i] = packed_nbytes;
+      frame_nbytes += nbytes;
+      packed_nbytes += lossless_get_bound(cfg.compression, nbytes);
+    }
+
+    if (0 != (header.filter & CA_FILTER_FRAME_DELTA)) {
+      previous.assign(frame_nbytes, 0);
+    }
+
+    mutex_create(mutex);
+    cond_create(cond_work);
+    cond_create(cond_done);
+
+    settings = cfg;
+    next_order = 0;
+    frames_until_key = 0;
+    num_written = 0;
+    num_dropped = 0;
+    num_failed = 0;
+    num_bytes_in = 0;
+    num_bytes_out = 0;
+    is_writing = false;
+    must_stop = false;
+    is_open = true;
+
+    for (int i = 0; i < maxframes; ++i) {
+      LosslessFrame* frame = new LosslessFrame();
+      frame->state = LOSSLESS_FRAME_FREE;
+      frame->order = 0;
+      frame->raw.resize(frame_nbytes);
+      if (CA_COMPRESS_NONE != cfg.compression) {
+        frame->packed.resize(packed_nbytes);
+      }
+      memset(&frame->entry, 0x00, sizeof(frame->entry));
+      memset(frame->planes, 0x00, sizeof(frame->planes));
+      frames.push_back(frame);
+    }
+
+    /* The compressors are created before the threads so a failure doesn't leave threads behind. A worker gets its recorder when its thread runs. */
+    for (int i = 0; i < nthreads; ++i) {
+
+      LosslessWorker* worker = new LosslessWorker();
+      worker->recorder = NULL;
+      workers.push_back(worker);
+
+      if (0 != worker->compressor.init(cfg.compression, cfg.level)) {
+        goto error;
+      }
+    }
+
+    for (size_t i = 0; i < workers.size(); ++i) {
+
+      workers[i]->recorder = this;
+
+      if (0 != thread_create(workers[i]->thread, workerMain, workers[i])) {
+        printf("Error: cannot create lossless compression thread %d.\n", (int)i);
+        workers[i]->recorder = NULL;
+        goto error;
+      }
+    }
+
+    return 0;
+
+  error:
+
+    stopWorkers();
+    writer.close();
+    is_open = false;
+
+    return -6;
+  }
+
+  int LosslessRecorder::close() {
+
+    int r = 0;
+
+    if (false == is_open) {
+      printf("Error: cannot close the lossless recorder, it's not open.\n");
+      return -1;
+    }
+
+    /* Wait until every queued frame is in the file. */
+    mutex_lock(mutex);
+    while (NULL != findHead()) {
+      cond_wait(cond_done, mutex);
+    }
+    mutex_unlock(mutex);
+
+    stopWorkers();
+
+    if (0 != writer.close()) {
+      r = -2;
+    }
+
+    previous.clear();
+    is_open = false;
+
+    return r;
+  }
+
+  int LosslessRecorder::write(PixelBuffer& buffer) {
+
+    CA_TRACE_SCOPE("sink.write", buffer.sequence);
+
+    LosslessFrame* frame = NULL;
+    bool is_key = true;
+
+    if (false == is_open) {
+      printf("Error: cannot write a frame, the lossless recorder isn't open.\n");
+      return -1;
+    }
+
+    if (buffer.pixel_format != header.pixel_format || (int)buffer.width[0] != header.width || (int)buffer.height[0] != header.height) {
+      printf("Error: the lossless recorder expects %d x %d %s frames.\n", header.width, header.height, format_to_string(header.pixel_format).c_str());
+      return -2;
+    }
+
+    mutex_lock(mutex);
+    {
+      frame = findOldest(LOSSLESS_FRAME_FREE);
+
+      if (NULL == frame) {
+        num_dropped++;
+      }
+      else {
+        /* Nobody else touches a filling frame, so we can copy without holding the lock. */
+        frame->state = LOSSLESS_FRAME_FILLING;
+      }
+    }
+    mutex_unlock(mutex);
+
+    if (NULL == frame) {
+      return -3;
+    }
+
+    if (0 != (header.filter & CA_FILTER_FRAME_DELTA)) {
+      is_key = (0 == frames_until_key);
+      frames_until_key = (true == is_key) ? (settings.keyint - 1) : (frames_until_key - 1);
+      if (0 > frames_until_key) {
+        frames_until_key = -1;                                                      /* keyint <= 0: only the first frame is a key frame. */
+      }
+    }
+
+    /* Copy the rows without the padding of the capture buffer; with the frame delta filter we store the difference and keep the frame. */
+    for (int i = 0; i < header.num_planes; ++i) {
+
+      size_t row_nbytes = header.plane_stride[i];
+      uint8_t* dst = &frame->raw[plane_offset[i]];
+      uint8_t* prev = (true == previous.empty()) ? NULL : &previous[plane_offset[i]];
+
+      for (uint32_t y = 0; y < header.plane_height[i]; ++y) {
+
+        const uint8_t* src = buffer.plane[i] + y * buffer.stride[i];
+
+        if (NULL == prev) {
+          memcpy(dst, src, row_nbytes);
+        }
+        else if (true == is_key) {
+          memcpy(dst, src, row_nbytes);
+          memcpy(prev, src, row_nbytes);
+        }
+        else {
+          lossless_delta_frame(src, prev, dst, row_nbytes);
+        }
+
+        dst += row_nbytes;
+        if (NULL != prev) {
+          prev += row_nbytes;
+        }
+      }
+    }
+
+    frame->entry.offset = 0;
+    frame->entry.sequence = buffer.sequence;
+    frame->entry.timestamp = (0 != buffer.timestamp) ? buffer.timestamp : time_now_ns();
+    frame->entry.flags = (true == is_key) ? CA_FRAME_FLAG_KEY : 0;
+
+    mutex_lock(mutex);
+    {
+      frame->order = next_order++;
+      frame->state = LOSSLESS_FRAME_QUEUED;
+      cond_signal(cond_work);
+    }
+    mutex_unlock(mutex);
+
+    return 0;
+  }
+
+  int LosslessRecorder::getNumThreads() {
+    return (int)workers.size();
+  }
+
+  uint64_t LosslessRecorder::getNumFrames() {
+
+    uint64_t n = 0;
+
+    if (false == is_open) {
+      return 0;
+    }
+
+    mutex_lock(mutex);
+    n = num_written;
+    mutex_unlock(mutex);
+
+    return n;
+  }
+
+  uint64_t LosslessRecorder::getNumDropped() {
+
+    uint64_t n = 0;
+
+    if (false == is_open) {
+      return 0;
+    }
+
+    mutex_lock(mutex);
+    n = num_dropped;
+    mutex_unlock(mutex);
+
+    return n;
+  }
+
+  uint64_t LosslessRecorder::getNumFailed() {
+
+    uint64_t n = 0;
+
+    if (false == is_open) {
+      return 0;
+    }
+
+    mutex_lock(mutex);
+    n = num_failed;
+    mutex_unlock(mutex);
+
+    return n;
+  }
+
+  uint64_t LosslessRecorder::getNumBytesIn() {
+
+    uint64_t n = 0;
+
+    if (false == is_open) {
+      return 0;
+    }
+
+    mutex_lock(mutex);
+    n = num_bytes_in;
+    mutex_unlock(mutex);
+
+    return n;
+  }
+
+  uint64_t LosslessRecorder::getNumBytesOut() {
+
+    uint64_t n = 0;
+
+    if (false == is_open) {
+      return 0;
+    }
+
+    mutex_lock(mutex);
+    n = num_bytes_out;
+    mutex_unlock(mutex);
+
+    return n;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  void LosslessRecorder::workerMain(void* user) {
+
+    LosslessWorker* worker = (LosslessWorker*)user;
+    LosslessRecorder* recorder = worker->recorder;
+    LosslessFrame* frame = NULL;
+
+    CA_TRACE_THREAD_NAME("lossless compressor");
+
+    mutex_lock(recorder->mutex);
+
+    while (true) {
+
+      frame = NULL;
+
+      while (false == recorder->must_stop && NULL == (frame = recorder->findOldest(LOSSLESS_FRAME_QUEUED))) {
+        cond_wait(recorder->cond_work, recorder->mutex);
+      }
+
+      if (true == recorder->must_stop) {
+        break;
+      }
+
+      frame->state = LOSSLESS_FRAME_COMPRESSING;
+      mutex_unlock(recorder->mutex);
+
+      recorder->compress(worker, frame);
+
+      mutex_lock(recorder->mutex);
+      frame->state = LOSSLESS_FRAME_COMPRESSED;
+
+      if (false == recorder->is_writing) {
+        recorder->writeFrames();
+      }
+    }
+
+    mutex_unlock(recorder->mutex);
+  }
+
+  void LosslessRecorder::compress(LosslessWorker* worker, LosslessFrame* frame) {
+
+    for (int i = 0; i < header.num_planes; ++i) {
+
+      uint8_t* raw = &frame->raw[plane_offset[i]];
+      size_t nbytes = (size_t)header.plane_stride[i] * header.plane_height[i];
+      size_t npacked = 0;
+
+      if (0 != (header.filter & CA_FILTER_ROW_DELTA)) {
+        lossless_delta_rows(raw, header.plane_stride[i], header.plane_height[i]);
+      }
+
+      if (CA_COMPRESS_NONE != header.compression) {
+        npacked = worker->compressor.compress(raw, nbytes, &frame->packed[packed_offset[i]], nbytes - 1);
+      }
+
+      /* A plane that doesn't get smaller (noise) is stored as is; `compress()` returns 0 when it doesn't fit. */
+      if (0 == npacked) {
+        frame->planes[i].data = raw;
+        frame->planes[i].nbytes = nbytes;
+        if (CA_COMPRESS_NONE != header.compression) {
+          frame->entry.flags |= CA_FRAME_FLAG_RAW_PLANE(i);
+        }
+      }
+      else {
+        frame->planes[i].data = &frame->packed[packed_offset[i]];
+        frame->planes[i].nbytes = npacked;
+      }
+
+      frame->entry.plane_nbytes[i] = (uint32_t)frame->planes[i].nbytes;
+    }
+  }
+
+  /* Whoever finishes the oldest frame writes it and the compressed frames after it; the others go back to compressing. */
+  void LosslessRecorder::writeFrames() {
+
+    LosslessFrame* head = NULL;
+    uint64_t nbytes = 0;
+    int r = 0;
+
+    is_writing = true;
+
+    while (NULL != (head = findHead()) && LOSSLESS_FRAME_COMPRESSED == head->state) {
+
+      head->state = LOSSLESS_FRAME_WRITING;
+      mutex_unlock(mutex);
+
+      r = writer.writeFrame(head->entry, head->planes);
+
+      nbytes = 0;
+      for (int i = 0; i < header.num_planes; ++i) {
+        nbytes += head->planes[i].nbytes;
+      }
+
+      mutex_lock(mutex);
+
+      if (0 == r) {
+        num_written++;
+        num_bytes_in += frame_nbytes;
+        num_bytes_out += nbytes;
+      }
+      else {
+        num_failed++;
+      }
+
+      head->state = LOSSLESS_FRAME_FREE;
+      cond_broadcast(cond_done);
+    }
+
+    is_writing = false;
+  }
+
+  LosslessFrame* LosslessRecorder::findOldest(int state) {
+
+    LosslessFrame* result = NULL;
+
+    for (size_t i = 0; i < frames.size(); ++i) {
+      if (state == frames[i]->state && (NULL == result || frames[i]->order < result->order)) {
+        result = frames[i];
+      }
+    }
+
+    return result;
+  }
+
+  LosslessFrame* LosslessRecorder::findHead() {
+
+    LosslessFrame* result = NULL;
+
+    for (size_t i = 0; i < frames.size(); ++i) {
+
+      LosslessFrame* frame = frames[i];
+
+      if (LOSSLESS_FRAME_FREE == frame->state || LOSSLESS_FRAME_FILLING == frame->state) {
+        continue;
+      }
+
+      if (NULL == result || frame->order < result->order) {
+        result = frame;
+      }
+    }
+
+    return result;
+  }
+
+  void LosslessRecorder::stopWorkers() {
+
+    mutex_lock(mutex);
+    must_stop = true;
+    cond_broadcast(cond_work);
+    mutex_unlock(mutex);
+
+    for (size_t i = 0; i < workers.size(); ++i) {
+
+      /* A worker without recorder has no thread. */
+      if (NULL != workers[i]->recorder) {
+        thread_join(workers[i]->thread);
+      }
+
+      workers[i]->compressor.shutdown();
+      delete workers[i];
+    }
+
+    for (size_t i = 0; i < frames.size(); ++i) {
+      delete frames[i];
+    }
+
+    workers.clear();
+    frames.clear();
+
+    cond_destroy(cond_work);
+    cond_destroy(cond_done);
+    mutex_destroy(mutex);
+  }
+
+} /* namespace ca */
@@ -0,0 +1,623 @@
+#include <stdio.h>
+#include <string.h>
+#include <videocapture/Metrics.h>
+#include <videocapture/Capture.h>
+#include <videocapture/Log.h>
+#include <videocapture/Error.h>
+#include <videocapture/Trace.h>
+
+#if defined(USE_METRICS) && !defined(_WIN32)
+#  include <errno.h>
+#  include <unistd.h>
+#  include <poll.h>
+#  include <sys/types.h>
+#  include <sys/socket.h>
+#  include <sys/time.h>
+#  include <sys/un.h>
+#  include <netinet/in.h>
+#  include <arpa/inet.h>
+#  define CA_METRICS_HAS_SERVER 1
+#  if defined(MSG_NOSIGNAL)
+#    define CA_METRICS_SEND_FLAGS MSG_NOSIGNAL
+#  else
+#    define CA_METRICS_SEND_FLAGS 0                                                 /* We set SO_NOSIGPIPE on the client socket instead. */
+#  endif
+#endif
+
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#  define snprintf _snprintf
+#endif
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  static const char* metrics_stage_names[CA_LATENCY_COUNT] = { "dequeue", "deliver", "callback", "convert" };
+  static const char* metrics_recovery_names[CA_RECOVER_COUNT] = { "restart", "reallocate", "reopen" };
+  static const double metrics_quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+
+  static void metrics_write_header(std::string& out, const char* name, const char* type, const char* help);
+  static void metrics_write_value(std::string& out, const char* name, const std::string& labels, double value);
+  static void metrics_write_count(std::string& out, const char* name, const std::string& labels, uint64_t value);
+  static std::string metrics_escape_label(const std::string& value);
+
+#if defined(CA_METRICS_HAS_SERVER)
+  static void metrics_thread_main(void* user);
+  static int metrics_send_all(int fd, const char* data, size_t nbytes);
+#endif
+
+  /* ------------------------------------------------------------------------- */
+
+  MetricsExporter::MetricsExporter()
+    :listen_fd(-1)
+    ,must_stop(0)
+  {
+    mutex_create(mutex);
+  }
+
+  MetricsExporter::~MetricsExporter() {
+    stop();
+    mutex_destroy(mutex);
+  }
+
+  int MetricsExporter::addCapture(const std::string& name, Capture* cap) {
+
+    int r = 0;
+
+    if (NULL == cap) {
+      CA_LOG_ERROR("cannot add the capture to the metrics, it's NULL.");
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      return -1;
+    }
+
+    if (0 == name.size()) {
+      CA_LOG_ERROR("cannot add the capture to the metrics, the name is empty.");
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      return -2;
+    }
+
+    mutex_lock(mutex);
+    {
+      for (size_t i = 0; i < devices.size(); ++i) {
+        if (devices[i].name == name) {
+          r = -3;
+          break;
+        }
+      }
+
+      if (0 == r) {
+        MetricsDevice dev;
+        dev.name = name;
+        dev.cap = cap;
+        devices.push_back(dev);
+      }
+    }
+    mutex_unlock(mutex);
+
+    if (0 != r) {
+      CA_LOG_ERROR("cannot add the capture to the metrics, the name %s is already used.", name.c_str());
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+    }
+
+    return r;
+  }
+
+  int MetricsExporter::removeCapture(const std::string& name) {
+
+    int r = -1;
+
+    mutex_lock(mutex);
+    {
+      for (size_t i = 0; i < devices.size(); ++i) {
+        if (devices[i].name == name) {
+          devices.erase(devices.begin() + i);
+          r = 0;
+          break;
+        }
+      }
+    }
+    mutex_unlock(mutex);
+
+    if (0 != r) {
+      CA_LOG_ERROR("cannot remove the capture %s from the metrics, we don't know it.", name.c_str());
+      error_set(CA_ERR_NOT_FOUND, 0);
+    }
+
+    return r;
+  }
+
+  int MetricsExporter::render(std::string& result) {
+
+    std::vector<std::string> labels;
+    std::vector<StreamStats> stats;
+    std::vector<LatencyHistogram> latency;
+    char quantile[64];
+
+    result.clear();
+
+    /* Copy first; the lock free reads are cheap and we don't want to format while holding the mutex. */
+    mutex_lock(mutex);
+    {
+      stats.resize(devices.size());
+      latency.resize(devices.size() * CA_LATENCY_COUNT);
+
+      for (size_t i = 0; i < devices.size(); ++i) {
+
+        labels.push_back("device=\"" + metrics_escape_label(devices[i].name) + "\"");
+        devices[i].cap->getStats(stats[i]);
+
+        for (int j = 0; j < CA_LATENCY_COUNT; ++j) {
+          if (0 != devices[i].cap->getLatency(j, latency[i * CA_LATENCY_COUNT + j])) {
+            latency[i * CA_LATENCY_COUNT + j].reset();
+          }
+        }
+      }
+    }
+    mutex_unlock(mutex);
+
+    metrics_write_header(result, "videocapture_frames_captured_total", "counter", "Frames received from the device.");
+    for (size_t i = 0; i < stats.size(); ++i) {
+      metrics_write_count(result, "videocapture_frames_captured_total", labels[i], stats[i].num_captured);
+    }
+
+    metrics_write_header(result, "videocapture_frames_delivered_total", "counter", "Frames passed to the frame callback.");
+    for (size_t i = 0; i < stats.size(); ++i) {
+      metrics_write_count(result, "videocapture_frames_delivered_total", labels[i], stats[i].num_delivered);
+    }
+
+    metrics_write_header(result, "videocapture_frames_dropped_total", "counter", "Frames lost by the device or dropped by the pipeline.");
+    for (size_t i = 0; i < stats.size(); ++i) {
+      metrics_write_count(result, "videocapture_frames_dropped_total", labels[i], stats[i].num_dropped);
+    }
+
+    metrics_write_header(result, "videocapture_fps", "gauge", "The moving average of the frame rate.");
+    for (size_t i = 0; i < stats.size(); ++i) {
+      metrics_write_value(result, "videocapture_fps", labels[i], stats[i].fps);
+    }
+
+    metrics_write_header(result, "videocapture_jitter_seconds", "gauge", "The moving average of the frame interval jitter.");
+    for (size_t i = 0; i < stats.size(); ++i) {
+      metrics_write_value(result, "videocapture_jitter_seconds", labels[i], stats[i].jitter_ns * 1e-9);
+    }
+
+    metrics_write_header(result, "videocapture_reconnects_total", "counter", "How often the device was opened again.");
+    for (size_t i = 0; i < stats.size(); ++i) {
+      metrics_write_count(result, "videocapture_reconnects_total", labels[i], (stats[i].num_opened > 1) ? stats[i].num_opened - 1 : 0);
+    }
+
+    metrics_write_header(result, "videocapture_recoveries_total", "counter", "How often the watchdog tried to recover a stalled stream.");
+    for (size_t i = 0; i < stats.size(); ++i) {
+      for (int j = 0; j < CA_RECOVER_COUNT; ++j) {
+        metrics_write_count(result, "videocapture_recoveries_total", labels[i] + ",action=\"" + metrics_recovery_names[j] + "\"", stats[i].num_recoveries[j]);
+      }
+    }
+
+    metrics_write_header(result, "videocapture_buffers", "gauge", "The buffers of the driver.");
+    for (size_t i = 0; i < stats.size(); ++i) {
+      metrics_write_value(result, "videocapture_buffers", labels[i], (double)stats[i].num_buffers);
+    }
+
+    metrics_write_header(result, "videocapture_buffers_queued", "gauge", "The buffers the driver can capture into.");
+    for (size_t i = 0; i < stats.size(); ++i) {
+      metrics_write_value(result, "videocapture_buffers_queued", labels[i], (double)stats[i].num_queued);
+    }
+
+    metrics_write_header(result, "videocapture_buffers_held", "gauge", "The buffers held by the pipeline and frame callback.");
+    for (size_t i = 0; i < stats.size(); ++i) {
+      metrics_write_value(result, "videocapture_buffers_held", labels[i], (double)stats[i].num_held);
+    }
+
+    metrics_write_header(result, "videocapture_latency_seconds", "summary", "The time every stage of a frame takes.");
+    for (size_t i = 0; i < stats.size(); ++i) {
+      for (int j = 0; j < CA_LATENCY_COUNT; ++j) {
+
+        LatencyHistogram& h = latency[i * CA_LATENCY_COUNT + j];
+        std::string stage = labels[i] + ",stage=\"" + metrics_stage_names[j] + "\"";
+
+        for (size_t k = 0; k < sizeof(metrics_quantiles) / sizeof(metrics_quantiles[0]); ++k) {
+          snprintf(quantile, sizeof(quantile), ",quantile=\"%g\"", metrics_quantiles[k]);
+          metrics_write_value(result, "videocapture_latency_seconds", stage + quantile, (double)h.getPercentile(metrics_quantiles[k] * 100.0) * 1e-9);
+        }
+
+        metrics_write_value(result, "videocapture_latency_seconds_sum", stage, h.getMean() * (double)h.getCount() * 1e-9);
+        metrics_write_count(result, "videocapture_latency_seconds_count", stage, h.getCount());
+      }
+    }
+
+    return 0;
+  }
+
+  bool MetricsExporter::isListening() {
+    return -1 != listen_fd;
+  }
+
+#if defined(CA_METRICS_HAS_SERVER)
+
+  int MetricsExporter::listen(int port) {
+
+    struct sockaddr_in addr;
+    int fd = -1;
+    int yes = 1;
+
+    if (-1 != listen_fd) {
+      CA_LOG_ERROR("cannot start the metrics server, it's already running.");
+      error_set(CA_ERR_INVALID_STATE, 0);
+      return -1;
+    }
+
+    if (0 >= port || 65535 < port) {
+      CA_LOG_ERROR("cannot start the metrics server, invalid port: %d.", port);
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      return -2;
+    }
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (-1 == fd) {
+      error_set_system(errno);
+      CA_LOG_ERROR("cannot create the metrics socket: %s.", strerror(errno));
+      return -3;
+    }
+
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (0 != bind(fd, (struct sockaddr*)&addr, sizeof(addr))) {
+      error_set_system(errno);
+      CA_LOG_ERROR("cannot bind the metrics socket to 127.0.0.1:%d: %s.", port, strerror(errno));
+      close(fd);
+      return -4;
+    }
+
+    if (0 != startServer(fd)) {
+      return -5;
+    }
+
+    return 0;
+  }
+
+  int MetricsExporter::listenUnix(const std::string& path) {
+
+    struct sockaddr_un addr;
+    int fd = -1;
+
+    if (-1 != listen_fd) {
+      CA_LOG_ERROR("cannot start the metrics server, it's already running.");
+      error_set(CA_ERR_INVALID_STATE, 0);
+      return -1;
+    }
+
+    if (0 == path.size() || path.size() >= sizeof(addr.sun_path)) {
+      CA_LOG_ERROR("cannot start the metrics server, invalid socket path: %s.", path.c_str());
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      return -2;
+    }
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (-1 == fd) {
+      error_set_system(errno);
+      CA_LOG_ERROR("cannot create the metrics socket: %s.", strerror(errno));
+      return -3;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+    /* A socket file of a previous run would make bind() fail. */
+    unlink(path.c_str());
+
+    if (0 != bind(fd, (struct sockaddr*)&addr, sizeof(addr))) {
+      error_set_system(errno);
+      CA_LOG_ERROR("cannot bind the metrics socket to %s: %s.", path.c_str(), strerror(errno));
+      close(fd);
+      return -4;
+    }
+
+    unix_path = path;
+
+    if (0 != startServer(fd)) {
+      unlink(path.c_str());
+      unix_path.clear();
+      return -5;
+    }
+
+    return 0;
+  }
+
+  int MetricsExporter::stop() {
+
+    if (-1 == listen_fd) {
+      return 0;
+    }
+
+    must_stop = 1;
+
+    if (0 != thread_join(thread)) {
+      CA_LOG_ERROR("cannot join the metrics thread.");
+      error_set(CA_ERR_SYSTEM, 0);
+      return -1;
+    }
+
+    close(listen_fd);
+    listen_fd = -1;
+
+    if (0 != unix_path.size()) {
+      unlink(unix_path.c_str());
+      unix_path.clear();
+    }
+
+    return 0;
+  }
+
+  void MetricsExporter::serve() {
+
+    struct pollfd pfd;
+    int fd = -1;
+
+    while (0 == must_stop) {
+
+      pfd.fd = listen_fd;
+      pfd.events = POLLIN;
+      pfd.revents = 0;
+
+      /* Wake up now and then to see if we must stop. */
+      if (0 >= poll(&pfd, 1, CA_METRICS_POLL_MS)) {
+        continue;
+      }
+
+      fd = accept(listen_fd, NULL, NULL);
+      if (-1 == fd) {
+        if (EINTR != errno && EAGAIN != errno && ECONNABORTED != errno) {
+          CA_LOG_WARNING("cannot accept a metrics connection: %s.", strerror(errno));
+        }
+        continue;
+      }
+
+      handleClient(fd);
+      close(fd);
+    }
+  }
+
+  int MetricsExporter::startServer(int fd) {
+
+    if (0 != ::listen(fd, 16)) {
+      error_set_system(errno);
+      CA_LOG_ERROR("cannot listen on the metrics socket: %s.", strerror(errno));
+      close(fd);
+      return -1;
+    }
+
+    listen_fd = fd;
+    must_stop = 0;
+
+    if (0 != thread_create(thread, metrics_thread_main, this)) {
+      CA_LOG_ERROR("cannot create the metrics thread.");
+      error_set(CA_ERR_SYSTEM, 0);
+      close(fd);
+      listen_fd = -1;
+      return -2;
+    }
+
+    return 0;
+  }
+
+  void MetricsExporter::handleClient(int fd) {
+
+    char request[CA_METRICS_MAX_REQUEST];
+    char header[256];
+    struct timeval tv;
+    size_t nbytes = 0;
+    ssize_t n = 0;
+    std::string body;
+    const char* status = "200 OK";
+    bool is_head = false;
+
+    tv.tv_sec = CA_METRICS_TIMEOUT_SEC;
+    tv.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+#if defined(SO_NOSIGPIPE)
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &yes, sizeof(yes));
+#endif
+
+    /* We only need the request line, but read the headers so the client doesn't get a reset when we close. */
+    while (nbytes < sizeof(request) - 1) {
+
+      n = recv(fd, request + nbytes, sizeof(request) - 1 - nbytes, 0);
+      if (0 >= n) {
+        if (-1 == n && EINTR == errno) {
+          continue;
+        }
+        break;
+      }
+
+      nbytes += (size_t)n;
+      request[nbytes] = '\0';
+
+      if (NULL != strstr(request, "\r\n\r\n") || NULL != strstr(request, "\n\n")) {
+        break;
+      }
+    }
+
+    if (0 == nbytes) {
+      return;
+    }
+
+    request[nbytes] = '\0';
+
+    if (0 == strncmp(request, "GET ", 4)) {
+      is_head = false;
+    }
+    else if (0 == strncmp(request, "HEAD ", 5)) {
+      is_head = true;
+    }
+    else {
+      status = "405 Method Not Allowed";
+    }
+
+    if (0 == strcmp(status, "200 OK")) {
+
+      const char* path = strchr(request, ' ') + 1;
+      size_t len = strcspn(path, " ?\r\n");
+
+      if ((8 == len && 0 == strncmp(path, "/metrics", 8)) || (1 == len && '/' == path[0])) {
+        render(body);
+      }
+      else {
+        status = "404 Not Found";
+      }
+    }
+
+    if (0 != strcmp(status, "200 OK")) {
+      body = std::string(status) + "\n";
+    }
+
+    snprintf(header, sizeof(header),
+             "HTTP/1.0 %s\r\n"
+             "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+             "Content-Length: %lu\r\n"
+             "Connection: close\r\n"
+             "\r\n",
+             status,
+             (unsigned long)body.size());
+
+    if (0 != metrics_send_all(fd, header, strlen(header))) {
+      return;
+    }
+
+    if (false == is_head) {
+      metrics_send_all(fd, body.data(), body.size());
+    }
+  }
+
+#else
+
+  int MetricsExporter::listen(int port) {
+    CA_LOG_ERROR("cannot serve the metrics on port %d, the library was built without USE_METRICS or the server isn't supported on this OS.", port);
+    error_set(CA_ERR_NOT_SUPPORTED, 0);
+    return -1;
+  }
+
+  int MetricsExporter::listenUnix(const std::string& path) {
+    CA_LOG_ERROR("cannot serve the metrics on %s, the library was built without USE_METRICS or the server isn't supported on this OS.", path.c_str());
+    error_set(CA_ERR_NOT_SUPPORTED, 0);
+    return -1;
+  }
+
+  int MetricsExporter::stop() {
+    return 0;
+  }
+
+  void MetricsExporter::serve() {
+  }
+
+  int MetricsExporter::startServer(int fd) {
+    (void)fd;
+    return -1;
+  }
+
+  void MetricsExporter::handleClient(int fd) {
+    (void)fd;
+  }
+
+#endif
+
+  /* ------------------------------------------------------------------------- */
+
+  static void metrics_write_header(std::string& out, const char* name, const char* type, const char* help) {
+    out += "# HELP ";
+    out += name;
+    out += " ";
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += " ";
+    out += type;
+    out += "\n";
+  }
+
+  static void metrics_write_value(std::string& out, const char* name, const std::string& labels, double value) {
+
+    char buf[64];
+
+    snprintf(buf, sizeof(buf), "%.9g", value);
+
+    out += name;
+    out += "{";
+    out += labels;
+    out += "} ";
+    out += buf;
+    out += "\n";
+  }
+
+  static void metrics_write_count(std::string& out, const char* name, const std::string& labels, uint64_t value) {
+
+    char buf[32];
+
+    snprintf(buf, sizeof(buf), "%llu", (unsigned long long)value);
+
+    out += name;
+    out += "{";
+    out += labels;
+    out += "} ";
+    out += buf;
+    out += "\n";
+  }
+
+  /* The text format wants backslashes, quotes and newlines escaped in label values. */
+  static std::string metrics_escape_label(const std::string& value) {
+
+    std::string result;
+
+    for (size_t i = 0; i < value.size(); ++i) {
+      switch (value[i]) {
+        case '\\': result += "\\\\"; break;
+        case '"': result += "\\\""; break;
+        case '\n': result += "\\n"; break;
+        default: result += value[i]; break;
+      }
+    }
+
+    return result;
+  }
+
+#if defined(CA_METRICS_HAS_SERVER)
+
+  static void metrics_thread_main(void* user) {
+
+    MetricsExporter* exporter = static_cast<MetricsExporter*>(user);
+
+    CA_TRACE_THREAD_NAME("metrics");
+    exporter->serve();
+  }
+
+  static int metrics_send_all(int fd, const char* data, size_t nbytes) {
+
+    ssize_t n = 0;
+
+    while (0 != nbytes) {
+
+      n = send(fd, data, nbytes, CA_METRICS_SEND_FLAGS);
+      if (0 >= n) {
+        if (-1 == n && EINTR == errno) {
+          continue;
+        }
+        return -1;
+      }
+
+      data += n;
+      nbytes -= (size_t)n;
+    }
+
+    return 0;
+  }
+
+#endif
+
+} /* namespace ca */
@@ -0,0 +1,481 @@
+#include <stdio.h>
+#include <string.h>
+#include <setjmp.h>
+#include <videocapture/Log.h>
+#include <videocapture/Error.h>
+#include <videocapture/Utils.h>
+#include <videocapture/MjpegDecoder.h>
+
+#if defined(USE_JPEG)
+#  include <jpeglib.h>
+#endif
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+#if defined(USE_JPEG)
+
+  struct MjpegErrorManager {
+    struct jpeg_error_mgr pub;                                                      /* Must be the first member; libjpeg casts the `err` pointer to this struct. */
+    jmp_buf jump;                                                                   /* Where we return to when libjpeg fails. */
+    char message[JMSG_LENGTH_MAX];                                                  /* The last error. */
+  };
+
+  struct MjpegDecoderState {
+    struct jpeg_decompress_struct cinfo;                                            /* Reused for every frame. */
+    MjpegErrorManager error;
+    std::vector<JSAMPROW> rows[3];                                                  /* Row pointers into the raw planes, or into the output for the packed formats. */
+  };
+
+  static void mjpeg_error_exit(j_common_ptr cinfo);                                 /* Jumps back into `decode()` instead of calling exit(). */
+  static void mjpeg_output_message(j_common_ptr cinfo);                             /* Ignores the warnings; many webcams send a few extraneous bytes after every frame. */
+  static int mjpeg_get_dct_scaled_size(jpeg_component_info* comp);                  /* The number of samples per block that are decoded for the component. */
+  static void mjpeg_resample_row(const uint8_t* s0, const uint8_t* s1, uint8_t* dst, int width, int hs, const uint8_t* lut); /* Averages one chroma row (or two when `s0` != `s1`) into `dst`, horizontally subsampling by 2 when `hs` is 1. */
+
+#endif
+
+  /* ------------------------------------------------------------------------- */
+
+  MjpegDecoder::MjpegDecoder()
+    :state(NULL)
+    ,output_format(CA_NONE)
+    ,scale_denom(1)
+  {
+    for (int i = 0; i < 256; ++i) {
+      luma_lut[i] = (uint8_t)i;
+      chroma_lut[i] = (uint8_t)i;
+    }
+  }
+
+  MjpegDecoder::~MjpegDecoder() {
+    shutdown();
+  }
+
+  int MjpegDecoder::init(int outfmt, int scaledenom) {
+
+    int w = 0;
+    int h = 0;
+
+    if (NULL != state) {
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_ERROR("cannot initialize the MJPEG decoder, already initialized.");
+      return -1;
+    }
+
+    if (false == mjpeg_decoder_is_available()) {
+      error_set(CA_ERR_NOT_SUPPORTED, 0);
+      CA_LOG_ERROR("cannot decode MJPEG, the library is compiled without USE_JPEG.");
+      return -2;
+    }
+
+    if (false == mjpeg_decoder_can_decode_into(outfmt)) {
+      error_set(CA_ERR_NOT_SUPPORTED, 0);
+      CA_LOG_ERROR("cannot decode MJPEG into %s.", format_to_string(outfmt).c_str());
+      return -3;
+    }
+
+    if (0 != mjpeg_get_scaled_size(8, 8, scaledenom, w, h)) {
+      return -4;
+    }
+
+    /* JPEG uses the full 0-255 range; CA_YUVJ420P keeps it, the other YUV formats are video range. */
+    for (int i = 0; i < 256; ++i) {
+      if (CA_YUVJ420P == outfmt) {
+        luma_lut[i] = (uint8_t)i;
+        chroma_lut[i] = (uint8_t)i;
+      }
+      else {
+        luma_lut[i] = (uint8_t)(16 + (i * 219 + 127) / 255);
+        chroma_lut[i] = (uint8_t)(16 + (i * 224 + 127) / 255);
+      }
+    }
+
+#if defined(USE_JPEG)
+
+    state = new MjpegDecoderState();
+    state->cinfo.err = jpeg_std_error(&state->error.pub);
+    state->error.pub.error_exit = mjpeg_error_exit;
+    state->error.pub.output_message = mjpeg_output_message;
+
+    if (setjmp(state->error.jump)) {
+      error_set(CA_ERR_NO_MEMORY, 0);
+      CA_LOG_ERROR("cannot create the JPEG decompressor: %s", state->error.message);
+      delete state;
+      state = NULL;
+      return -5;
+    }
+
+    jpeg_create_decompress(&state->cinfo);
+
+#endif
+
+    output_format = outfmt;
+    scale_denom = scaledenom;
+
+    return 0;
+  }
+
+  int MjpegDecoder::shutdown() {
+
+#if defined(USE_JPEG)
+    if (NULL != state) {
+      jpeg_destroy_decompress(&state->cinfo);
+      delete state;
+      state = NULL;
+    }
+#endif
+
+    raw_memory.clear();
+    output_format = CA_NONE;
+    scale_denom = 1;
+
+    return 0;
+  }
+
+  int MjpegDecoder::decode(const uint8_t* data, size_t nbytes, PixelBuffer& out) {
+
+    if (NULL == state) {
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_ERROR("cannot decode, the MJPEG decoder is not initialized.");
+      return -1;
+    }
+
+    if (NULL == data || 0 == nbytes) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("cannot decode, no JPEG data.");
+      return -2;
+    }
+
+    if (out.pixel_format != output_format || NULL == out.plane[0]) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("cannot decode, the output buffer is not set up for %s.", format_to_string(output_format).c_str());
+      return -3;
+    }
+
+#if defined(USE_JPEG)
+
+    int r = 0;
+    j_decompress_ptr cinfo = &state->cinfo;
+
+    /* Nothing between here and the longjmp() may have a destructor. */
+    if (setjmp(state->error.jump)) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("cannot decode the MJPEG frame: %s", state->error.message);
+      jpeg_abort_decompress(cinfo);
+      return -4;
+    }
+
+    jpeg_mem_src(cinfo, (unsigned char*)data, (unsigned long)nbytes);
+    jpeg_read_header(cinfo, TRUE);
+
+    cinfo->scale_num = 1;
+    cinfo->scale_denom = scale_denom;
+    cinfo->dct_method = JDCT_ISLOW;
+
+    if (CA_RGB24 == output_format || CA_BGRA32 == output_format || CA_RGBA32 == output_format || CA_ARGB32 == output_format) {
+      r = decodeColor(out);
+    }
+    else {
+      r = decodeRaw(out);
+    }
+
+    if (r < 0) {
+      jpeg_abort_decompress(cinfo);
+      return r;
+    }
+
+    jpeg_finish_decompress(cinfo);
+
+    return 0;
+
+#else
+    return -5;
+#endif
+  }
+
+  int MjpegDecoder::getOutputFormat() {
+    return output_format;
+  }
+
+  int MjpegDecoder::getScaleDenom() {
+    return scale_denom;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+#if defined(USE_JPEG)
+
+  int MjpegDecoder::decodeRaw(PixelBuffer& out) {
+
+    j_decompress_ptr cinfo = &state->cinfo;
+    int ncomps = cinfo->num_components;
+    int hs[3] = { 1, 1, 1 };
+    int vs[3] = { 1, 1, 1 };
+    int dct[3] = { 0, 0, 0 };
+    int nrows[3] = { 0, 0, 0 };
+    size_t width[3] = { 0, 0, 0 };
+    size_t offset = 0;
+
+    if (3 == ncomps && JCS_YCbCr == cinfo->jpeg_color_space) {
+      cinfo->out_color_space = JCS_YCbCr;
+    }
+    else if (1 == ncomps) {
+      cinfo->out_color_space = JCS_GRAYSCALE;
+    }
+    else {
+      error_set(CA_ERR_NOT_SUPPORTED, 0);
+      CA_LOG_ERROR("cannot decode a JPEG with %d components in color space %d into YUV.", ncomps, (int)cinfo->jpeg_color_space);
+      return -10;
+    }
+
+    cinfo->raw_data_out = TRUE;
+    cinfo->do_fancy_upsampling = FALSE;
+
+    jpeg_start_decompress(cinfo);
+
+    if (cinfo->output_width != out.width[0] || cinfo->output_height != out.height[0]) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("the decoded frame is %u x %u but the output buffer is %d x %d.",
+                   cinfo->output_width, cinfo->output_height, (int)out.width[0], (int)out.height[0]);
+      return -11;
+    }
+
+    /* With raw output every jpeg_read_raw_data() call returns one iMCU row of each component. */
+    int luma_dct = mjpeg_get_dct_scaled_size(&cinfo->comp_info[0]);
+    int lines = cinfo->max_v_samp_factor * luma_dct;
+    int imcu_rows = (cinfo->output_height + lines - 1) / lines;
+
+    for (int i = 0; i < ncomps; ++i) {
+
+      jpeg_component_info* comp = &cinfo->comp_info[i];
+
+      dct[i] = mjpeg_get_dct_scaled_size(comp);
+      nrows[i] = imcu_rows * comp->v_samp_factor * dct[i];
+      width[i] = comp->width_in_blocks * dct[i];
+
+      /* The subsampling of the decoded planes; libjpeg may upsample the chroma in the IDCT when scaling. */
+      hs[i] = (cinfo->max_h_samp_factor * luma_dct) / (comp->h_samp_factor * dct[i]);
+      vs[i] = (cinfo->max_v_samp_factor * luma_dct) / (comp->v_samp_factor * dct[i]);
+
+      if ((1 != hs[i] && 2 != hs[i]) || (1 != vs[i] && 2 != vs[i])) {
+        error_set(CA_ERR_NOT_SUPPORTED, 0);
+        CA_LOG_ERROR("cannot decode a JPEG with %d x %d chroma subsampling.", hs[i], vs[i]);
+        return -12;
+      }
+
+      offset += width[i] * nrows[i];
+    }
+
+    /* Only grows; after the first frame we don't allocate anymore. */
+    if (raw_memory.size() < offset) {
+      raw_memory.resize(offset);
+    }
+
+    offset = 0;
+
+    for (int i = 0; i < ncomps; ++i) {
+
+      state->rows[i].resize(nrows[i]);
+
+      for (int j = 0; j < nrows[i]; ++j) {
+        state->rows[i][j] = &raw_memory[offset];
+        offset += width[i];
+      }
+    }
+
+    for (int row = 0; cinfo->output_scanline < cinfo->output_height; ++row) {
+
+      JSAMPARRAY planes[3];
+
+      for (int i = 0; i < ncomps; ++i) {
+        planes[i] = &state->rows[i][row * cinfo->comp_info[i].v_samp_factor * dct[i]];
+      }
+
+      jpeg_read_raw_data(cinfo, planes, lines);
+    }
+
+    /* Luma */
+    for (size_t y = 0; y < out.height[0]; ++y) {
+
+      const uint8_t* s = state->rows[0][y];
+      uint8_t* d = out.plane[0] + y * out.stride[0];
+
+      for (size_t x = 0; x < out.width[0]; ++x) {
+        d[x] = luma_lut[s[x]];
+      }
+    }
+
+    /* Chroma: every output sample covers 2 x `out_vs` luma samples. */
+    int out_vs = (CA_YUV422P == output_format) ? 1 : 2;
+
+    for (int i = 1; i < 3; ++i) {
+
+      for (size_t cy = 0; cy < out.height[i]; ++cy) {
+
+        uint8_t* d = out.plane[i] + cy * out.stride[i];
+
+        if (1 == ncomps) {
+          memset(d, 128, out.width[i]);
+          continue;
+        }
+
+        int ly0 = (int)cy * out_vs;
+        int ly1 = ly0 + out_vs - 1;
+
+        mjpeg_resample_row(state->rows[i][ly0 / vs[i]], state->rows[i][ly1 / vs[i]], d, (int)out.width[i], hs[i], chroma_lut);
+      }
+    }
+
+    return 0;
+  }
+
+  int MjpegDecoder::decodeColor(PixelBuffer& out) {
+
+    j_decompress_ptr cinfo = &state->cinfo;
+
+    switch (output_format) {
+      case CA_RGB24:  { cinfo->out_color_space = JCS_RGB;      break; }
+#if defined(JCS_ALPHA_EXTENSIONS)
+      case CA_BGRA32: { cinfo->out_color_space = JCS_EXT_BGRA; break; }
+      case CA_RGBA32: { cinfo->out_color_space = JCS_EXT_RGBA; break; }
+      case CA_ARGB32: { cinfo->out_color_space = JCS_EXT_ARGB; break; }
+#endif
+      default: {
+        error_set(CA_ERR_NOT_SUPPORTED, 0);
+        CA_LOG_ERROR("cannot decode into %s with this libjpeg.", format_to_string(output_format).c_str());
+        return -20;
+      }
+    }
+
+    jpeg_start_decompress(cinfo);
+
+    if (cinfo->output_width != out.width[0] || cinfo->output_height != out.height[0]) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("the decoded frame is %u x %u but the output buffer is %d x %d.",
+                   cinfo->output_width, cinfo->output_height, (int)out.width[0], (int)out.height[0]);
+      return -21;
+    }
+
+    std::vector<JSAMPROW>& rows = state->rows[0];
+    rows.resize(cinfo->output_height);
+
+    for (size_t y = 0; y < rows.size(); ++y) {
+      rows[y] = out.plane[0] + y * out.stride[0];
+    }
+
+    while (cinfo->output_scanline < cinfo->output_height) {
+      jpeg_read_scanlines(cinfo, &rows[cinfo->output_scanline], cinfo->output_height - cinfo->output_scanline);
+    }
+
+    return 0;
+  }
+
+#else
+
+  int MjpegDecoder::decodeRaw(PixelBuffer&) {
+    return -1;
+  }
+
+  int MjpegDecoder::decodeColor(PixelBuffer&) {
+    return -1;
+  }
+
+#endif
+
+  /* ------------------------------------------------------------------------- */
+
+  bool mjpeg_decoder_is_available() {
+#if defined(USE_JPEG)
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  std::vector<int> mjpeg_decoder_get_formats() {
+
+    std::vector<int> result;
+
+#if defined(USE_JPEG)
+    result.push_back(CA_YUV420P);
+    result.push_back(CA_YUVJ420P);
+    result.push_back(CA_YUV422P);
+    result.push_back(CA_RGB24);
+#  if defined(JCS_ALPHA_EXTENSIONS)
+    result.push_back(CA_BGRA32);
+    result.push_back(CA_RGBA32);
+    result.push_back(CA_ARGB32);
+#  endif
+#endif
+
+    return result;
+  }
+
+  bool mjpeg_decoder_can_decode_into(int fmt) {
+
+    std::vector<int> formats = mjpeg_decoder_get_formats();
+
+    for (size_t i = 0; i < formats.size(); ++i) {
+      if (formats[i] == fmt) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  int mjpeg_get_scaled_size(int width, int height, int scaledenom, int& outwidth, int& outheight) {
+
+    if (1 != scaledenom && 2 != scaledenom && 4 != scaledenom && 8 != scaledenom) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("invalid JPEG scale denominator: %d, use 1, 2, 4 or 8.", scaledenom);
+      return -1;
+    }
+
+    /* Same rounding as libjpeg. */
+    outwidth = (width + scaledenom - 1) / scaledenom;
+    outheight = (height + scaledenom - 1) / scaledenom;
+
+    return 0;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+#if defined(USE_JPEG)
+
+  static void mjpeg_resample_row(const uint8_t* s0, const uint8_t* s1, uint8_t* dst, int width, int hs, const uint8_t* lut) {
+
+    if (2 == hs) {
+      for (int x = 0; x < width; ++x) {
+        dst[x] = lut[(s0[x] + s1[x] + 1) >> 1];
+      }
+      return;
+    }
+
+    for (int x = 0; x < width; ++x) {
+      dst[x] = lut[(s0[2 * x] + s0[2 * x + 1] + s1[2 * x] + s1[2 * x + 1] + 2) >> 2];
+    }
+  }
+
+  static void mjpeg_error_exit(j_common_ptr cinfo) {
+    MjpegErrorManager* err = (MjpegErrorManager*)cinfo->err;
+    (*cinfo->err->format_message)(cinfo, err->message);
+    longjmp(err->jump, 1);
+  }
+
+  static void mjpeg_output_message(j_common_ptr cinfo) {
+    (void)cinfo;
+  }
+
+  static int mjpeg_get_dct_scaled_size(jpeg_component_info* comp) {
+#if JPEG_LIB_VERSION >= 70
+    return comp->DCT_v_scaled_size;
+#else
+    return comp->DCT_scaled_size;
+#endif
+  }
+
+#endif
+
+} /* namespace ca */
@@ -0,0 +1,494 @@
+#include <stdio.h>
+#include <string.h>
+#include <videocapture/Log.h>
+#include <videocapture/Error.h>
+#include <videocapture/Utils.h>
+#include <videocapture/Trace.h>
+#include <videocapture/MjpegDecoderPool.h>
+
+/* The states of a frame; a frame goes from free to filling, queued, decoding, decoded (or failed), acquired and back to free. */
+#define MJPEG_FRAME_FREE 0
+#define MJPEG_FRAME_FILLING 1
+#define MJPEG_FRAME_QUEUED 2
+#define MJPEG_FRAME_DECODING 3
+#define MJPEG_FRAME_DECODED 4
+#define MJPEG_FRAME_FAILED 5
+#define MJPEG_FRAME_ACQUIRED 6
+
+namespace ca {
+
+  MjpegDecoderPool::MjpegDecoderPool()
+    :drop_policy(CA_DROP_NEWEST)
+    ,next_order(0)
+    ,num_decoded(0)
+    ,num_dropped(0)
+    ,num_failed(0)
+    ,is_init(false)
+    ,must_stop(false)
+  {
+  }
+
+  MjpegDecoderPool::~MjpegDecoderPool() {
+    if (true == is_init) {
+      shutdown();
+    }
+  }
+
+  int MjpegDecoderPool::init(int width, int height, int outfmt, int scaledenom, int nthreads, int maxframes, int droppolicy) {
+
+    int w = 0;
+    int h = 0;
+
+    if (true == is_init) {
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_ERROR("the MJPEG decoder pool is already initialized.");
+      return -1;
+    }
+
+    if (0 > nthreads || 0 > maxframes) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("invalid number of decode threads (%d) or frames (%d).", nthreads, maxframes);
+      return -2;
+    }
+
+    if (CA_DROP_NEWEST != droppolicy && CA_DROP_OLDEST != droppolicy && CA_DROP_NONE != droppolicy) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("invalid drop policy: %d.", droppolicy);
+      return -3;
+    }
+
+    if (0 != mjpeg_get_scaled_size(width, height, scaledenom, w, h)) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("invalid scale denominator for the MJPEG decoder pool: %d.", scaledenom);
+      return -4;
+    }
+
+    if (0 == nthreads) {
+      nthreads = cpu_count();
+    }
+
+    if (0 == maxframes) {
+      maxframes = 2 * nthreads;
+    }
+
+    if (0 != output_pool.init(w, h, outfmt, maxframes)) {
+      return -5;
+    }
+
+    mutex_create(mutex);
+    cond_create(cond_work);
+    cond_create(cond_done);
+
+    drop_policy = droppolicy;
+    next_order = 0;
+    num_decoded = 0;
+    num_dropped = 0;
+    num_failed = 0;
+    must_stop = false;
+    is_init = true;
+
+    for (int i = 0; i < maxframes; ++i) {
+      MjpegDecodeFrame* frame = new MjpegDecodeFrame();
+      frame->state = MJPEG_FRAME_FREE;
+      frame->order = 0;
+      frame->nbytes = 0;
+      frame->output = output_pool.acquire();
+      frame->sequence = 0;
+      frame->timestamp = 0;
+      frame->receive_time = 0;
+      frame->decode_time = 0;
+      frame->user = NULL;
+      frames.push_back(frame);
+    }
+
+    /* The decoders are created before the threads so a failure doesn't leave threads behind. A worker gets its pool when its thread runs. */
+    for (int i = 0; i < nthreads; ++i) {
+
+      MjpegDecodeWorker* worker = new MjpegDecodeWorker();
+      worker->pool = NULL;
+      workers.push_back(worker);
+
+      if (0 != worker->decoder.init(outfmt, scaledenom)) {
+        shutdown();
+        return -6;
+      }
+    }
+
+    for (size_t i = 0; i < workers.size(); ++i) {
+
+      workers[i]->pool = this;
+
+      if (0 != thread_create(workers[i]->thread, workerMain, workers[i])) {
+        error_set(CA_ERR_SYSTEM, 0);
+        CA_LOG_ERROR("cannot create MJPEG decode thread %d.", (int)i);
+        workers[i]->pool = NULL;
+        shutdown();
+        return -7;
+      }
+    }
+
+    return 0;
+  }
+
+  int MjpegDecoderPool::shutdown() {
+
+    if (false == is_init) {
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_ERROR("cannot shutdown the MJPEG decoder pool; not initialized.");
+      return -1;
+    }
+
+    mutex_lock(mutex);
+    must_stop = true;
+    cond_broadcast(cond_work);
+    mutex_unlock(mutex);
+
+    for (size_t i = 0; i < workers.size(); ++i) {
+
+      /* A worker without pool has no thread. */
+      if (NULL != workers[i]->pool) {
+        thread_join(workers[i]->thread);
+      }
+
+      workers[i]->decoder.shutdown();
+      delete workers[i];
+    }
+
+    for (size_t i = 0; i < frames.size(); ++i) {
+
+      if (MJPEG_FRAME_ACQUIRED == frames[i]->state) {
+        CA_LOG_WARNING("shutting down the MJPEG decoder pool while a frame is acquired.");
+      }
+
+      output_pool.release(frames[i]->output);
+      delete frames[i];
+    }
+
+    workers.clear();
+    frames.clear();
+    output_pool.shutdown();
+
+    cond_destroy(cond_work);
+    cond_destroy(cond_done);
+    mutex_destroy(mutex);
+
+    is_init = false;
+
+    return 0;
+  }
+
+  int MjpegDecoderPool::submit(PixelBuffer& in) {
+
+    MjpegDecodeFrame* frame = NULL;
+    int r = 0;
+
+    if (false == is_init) {
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_ERROR("cannot submit a frame, the MJPEG decoder pool is not initialized.");
+      return -1;
+    }
+
+    if (NULL == in.plane[0] || 0 == in.nbytes) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("cannot submit an empty frame to the MJPEG decoder pool.");
+      return -2;
+    }
+
+    mutex_lock(mutex);
+    {
+      frame = findOldest(MJPEG_FRAME_FREE);
+
+      /* All frames are in flight: drop the oldest frame that's not being decoded (or acquired); the order of the others stays the same. */
+      if (NULL == frame && CA_DROP_OLDEST == drop_policy) {
+
+        frame = findOldest(MJPEG_FRAME_QUEUED);
+
+        MjpegDecodeFrame* decoded = findOldest(MJPEG_FRAME_DECODED);
+        if (NULL == frame || (NULL != decoded && decoded->order < frame->order)) {
+          frame = decoded;
+        }
+
+        if (NULL != frame) {
+          r = -3;
+        }
+      }
+
+      if (NULL == frame) {
+        r = -4;
+      }
+      else {
+        /* Nobody else touches a filling frame, so we can copy without holding the lock. */
+        frame->state = MJPEG_FRAME_FILLING;
+      }
+
+      if (0 != r) {
+        num_dropped++;
+      }
+    }
+    mutex_unlock(mutex);
+
+    if (NULL == frame) {
+      return r;
+    }
+
+    if (frame->data.size() < in.nbytes) {
+      frame->data.resize(in.nbytes);
+    }
+
+    memcpy(&frame->data[0], in.plane[0], in.nbytes);
+
+    frame->nbytes = in.nbytes;
+    frame->sequence = in.sequence;
+    frame->timestamp = in.timestamp;
+    frame->receive_time = in.receive_time;
+    frame->decode_time = 0;
+    frame->user = in.user;
+
+    mutex_lock(mutex);
+    {
+      frame->order = next_order++;
+      frame->state = MJPEG_FRAME_QUEUED;
+      cond_signal(cond_work);
+    }
+    mutex_unlock(mutex);
+
+    return r;
+  }
+
+  PixelBuffer* MjpegDecoderPool::acquireDecoded(bool wait) {
+
+    PixelBuffer* result = NULL;
+
+    if (false == is_init) {
+      return NULL;
+    }
+
+    mutex_lock(mutex);
+
+    while (true) {
+
+      MjpegDecodeFrame* head = findHead();
+
+      if (NULL == head) {
+        break;
+      }
+
+      /* A frame that couldn't be decoded is skipped; the decoder already logged why. */
+      if (MJPEG_FRAME_FAILED == head->state) {
+        head->state = MJPEG_FRAME_FREE;
+        continue;
+      }
+
+      if (MJPEG_FRAME_DECODED == head->state) {
+        head->state = MJPEG_FRAME_ACQUIRED;
+        result = head->output;
+        result->sequence = head->sequence;
+        result->timestamp = head->timestamp;
+        result->receive_time = head->receive_time;
+        result->decode_time = head->decode_time;
+        result->user = head->user;
+        break;
+      }
+
+      if (false == wait) {
+        break;
+      }
+
+      cond_wait(cond_done, mutex);
+    }
+
+    mutex_unlock(mutex);
+
+    return result;
+  }
+
+  int MjpegDecoderPool::release(PixelBuffer* buffer) {
+
+    int r = -1;
+
+    if (NULL == buffer) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("cannot release a NULL frame into the MJPEG decoder pool.");
+      return -2;
+    }
+
+    mutex_lock(mutex);
+    {
+      for (size_t i = 0; i < frames.size(); ++i) {
+        if (buffer == frames[i]->output && MJPEG_FRAME_ACQUIRED == frames[i]->state) {
+          frames[i]->state = MJPEG_FRAME_FREE;
+          r = 0;
+          break;
+        }
+      }
+    }
+    mutex_unlock(mutex);
+
+    if (0 != r) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("cannot release a frame that wasn't acquired from the MJPEG decoder pool.");
+    }
+
+    return r;
+  }
+
+  int MjpegDecoderPool::getNumFree() {
+
+    int n = 0;
+
+    if (false == is_init) {
+      return 0;
+    }
+
+    mutex_lock(mutex);
+    {
+      for (size_t i = 0; i < frames.size(); ++i) {
+        if (MJPEG_FRAME_FREE == frames[i]->state) {
+          n++;
+        }
+      }
+    }
+    mutex_unlock(mutex);
+
+    return n;
+  }
+
+  int MjpegDecoderPool::getNumThreads() {
+    return (int)workers.size();
+  }
+
+  uint64_t MjpegDecoderPool::getNumDecoded() {
+
+    uint64_t n = 0;
+
+    if (false == is_init) {
+      return 0;
+    }
+
+    mutex_lock(mutex);
+    n = num_decoded;
+    mutex_unlock(mutex);
+
+    return n;
+  }
+
+  uint64_t MjpegDecoderPool::getNumDropped() {
+
+    uint64_t n = 0;
+
+    if (false == is_init) {
+      return 0;
+    }
+
+    mutex_lock(mutex);
+    n = num_dropped;
+    mutex_unlock(mutex);
+
+    return n;
+  }
+
+  uint64_t MjpegDecoderPool::getNumFailed() {
+
+    uint64_t n = 0;
+
+    if (false == is_init) {
+      return 0;
+    }
+
+    mutex_lock(mutex);
+    n = num_failed;
+    mutex_unlock(mutex);
+
+    return n;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  MjpegDecodeFrame* MjpegDecoderPool::findOldest(int state) {
+
+    MjpegDecodeFrame* result = NULL;
+
+    for (size_t i = 0; i < frames.size(); ++i) {
+      if (state == frames[i]->state && (NULL == result || frames[i]->order < result->order)) {
+        result = frames[i];
+      }
+    }
+
+    return result;
+  }
+
+  MjpegDecodeFrame* MjpegDecoderPool::findHead() {
+
+    MjpegDecodeFrame* result = NULL;
+
+    for (size_t i = 0; i < frames.size(); ++i) {
+
+      MjpegDecodeFrame* frame = frames[i];
+
+      if (MJPEG_FRAME_FREE == frame->state
+          || MJPEG_FRAME_FILLING == frame->state
+          || MJPEG_FRAME_ACQUIRED == frame->state)
+        {
+          continue;
+        }
+
+      if (NULL == result || frame->order < result->order) {
+        result = frame;
+      }
+    }
+
+    return result;
+  }
+
+  void MjpegDecoderPool::workerMain(void* user) {
+
+    MjpegDecodeWorker* worker = (MjpegDecodeWorker*)user;
+    MjpegDecoderPool* pool = worker->pool;
+    MjpegDecodeFrame* frame = NULL;
+    uint64_t start = 0;
+    int r = 0;
+
+    CA_TRACE_THREAD_NAME("mjpeg decoder");
+
+    mutex_lock(pool->mutex);
+
+    while (true) {
+
+      frame = NULL;
+
+      while (false == pool->must_stop && NULL == (frame = pool->findOldest(MJPEG_FRAME_QUEUED))) {
+        cond_wait(pool->cond_work, pool->mutex);
+      }
+
+      if (true == pool->must_stop) {
+        break;
+      }
+
+      frame->state = MJPEG_FRAME_DECODING;
+      mutex_unlock(pool->mutex);
+
+      start = time_now_ns();
+      {
+        CA_TRACE_SCOPE("decode", frame->sequence);
+        r = worker->decoder.decode(&frame->data[0], frame->nbytes, *frame->output);
+      }
+      frame->decode_time = time_now_ns() - start;
+
+      mutex_lock(pool->mutex);
+
+      if (0 == r) {
+        frame->state = MJPEG_FRAME_DECODED;
+        pool->num_decoded++;
+      }
+      else {
+        frame->state = MJPEG_FRAME_FAILED;
+        pool->num_failed++;
+      }
+
+      cond_broadcast(pool->cond_done);
+    }
+
+    mutex_unlock(pool->mutex);
+  }
+
+} /* namespace ca */
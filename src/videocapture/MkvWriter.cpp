@@ -0,0 +1,496 @@
+#include <string.h>
+#include <videocapture/MkvWriter.h>
+#include <videocapture/Utils.h>
+
+#define MKV_CLUSTER_DURATION 1000                                                   /* We start a new Cluster at the first key frame after this many milliseconds. */
+#define MKV_CLUSTER_MAX_TIME 32767                                                  /* The maximum relative timecode of a SimpleBlock (int16). */
+#define MKV_CLUSTER_MAX_SIZE (32 * 1024 * 1024)                                     /* We start a new Cluster when the current one grows beyond this size. */
+#define MKV_CUES_RESERVE 3600                                                       /* The number of CuePoints we reserve; one hour with a Cluster per second. */
+
+/* Element IDs. */
+#define MKV_EBML 0x1A45DFA3
+#define MKV_EBML_VERSION 0x4286
+#define MKV_EBML_READ_VERSION 0x42F7
+#define MKV_EBML_MAX_ID_LENGTH 0x42F2
+#define MKV_EBML_MAX_SIZE_LENGTH 0x42F3
+#define MKV_DOC_TYPE 0x4282
+#define MKV_DOC_TYPE_VERSION 0x4287
+#define MKV_DOC_TYPE_READ_VERSION 0x4285
+#define MKV_SEGMENT 0x18538067
+#define MKV_SEEK_HEAD 0x114D9B74
+#define MKV_SEEK 0x4DBB
+#define MKV_SEEK_ID 0x53AB
+#define MKV_SEEK_POSITION 0x53AC
+#define MKV_INFO 0x1549A966
+#define MKV_TIMECODE_SCALE 0x2AD7B1
+#define MKV_DURATION 0x4489
+#define MKV_MUXING_APP 0x4D80
+#define MKV_WRITING_APP 0x5741
+#define MKV_TRACKS 0x1654AE6B
+#define MKV_TRACK_ENTRY 0xAE
+#define MKV_TRACK_NUMBER 0xD7
+#define MKV_TRACK_UID 0x73C5
+#define MKV_TRACK_TYPE 0x83
+#define MKV_FLAG_LACING 0x9C
+#define MKV_CODEC_ID 0x86
+#define MKV_CODEC_PRIVATE 0x63A2
+#define MKV_DEFAULT_DURATION 0x23E383
+#define MKV_VIDEO 0xE0
+#define MKV_PIXEL_WIDTH 0xB0
+#define MKV_PIXEL_HEIGHT 0xBA
+#define MKV_CLUSTER 0x1F43B675
+#define MKV_TIMECODE 0xE7
+#define MKV_SIMPLE_BLOCK 0xA3
+#define MKV_CUES 0x1C53BB6B
+#define MKV_CUE_POINT 0xBB
+#define MKV_CUE_TIME 0xB3
+#define MKV_CUE_TRACK_POSITIONS 0xB7
+#define MKV_CUE_TRACK 0xF7
+#define MKV_CUE_CLUSTER_POSITION 0xF1
+
+namespace ca {
+
+  /* The number of bytes of an unsigned integer element value. */
+  static int mkv_get_uint_size(uint64_t v);
+
+  /* ------------------------------------------------------------------------- */
+
+  MkvWriter::MkvWriter()
+    :width(0)
+    ,height(0)
+    ,fps(0)
+    ,pixel_format(CA_NONE)
+    ,first_timestamp(0)
+    ,last_time(0)
+    ,num_frames(0)
+    ,segment_offset(0)
+    ,segment_data_offset(0)
+    ,duration_offset(0)
+    ,cues_seek_offset(0)
+    ,cluster_offset(0)
+    ,cluster_time(0)
+    ,has_cluster(false)
+  {
+  }
+
+  MkvWriter::~MkvWriter() {
+    if (true == file.isOpen()) {
+      close();
+    }
+  }
+
+  int MkvWriter::open(const std::string& filepath, int w, int h, int fmt, int framerate) {
+
+    if (true == file.isOpen()) {
+      printf("Error: cannot open %s, the MKV writer is already open.\n", filepath.c_str());
+      return -1;
+    }
+
+    if (CA_MJPEG != fmt && CA_JPEG_OPENDML != fmt && CA_H264 != fmt && CA_H265 != fmt) {
+      printf("Error: the MKV writer can only store MJPEG, H.264 and H.265 frames.\n");
+      return -2;
+    }
+
+    if ((CA_H264 == fmt || CA_H265 == fmt) && 0 == codec_private.size()) {
+      printf("Error: cannot store %s in MKV without the decoder configuration, call setCodecPrivate() first.\n", format_to_string(fmt).c_str());
+      return -2;
+    }
+
+    if (0 >= w || 0 >= h) {
+      printf("Error: invalid frame size for the MKV writer: %d x %d.\n", w, h);
+      return -3;
+    }
+
+    if (0 != file.open(filepath)) {
+      return -4;
+    }
+
+    width = w;
+    height = h;
+    fps = (0 < framerate) ? framerate : CA_FPS_30_00;
+    pixel_format = fmt;
+    first_timestamp = 0;
+    last_time = 0;
+    num_frames = 0;
+    has_cluster = false;
+
+    cues.clear();
+    cues.reserve(MKV_CUES_RESERVE);
+
+    if (0 != writeHeader()) {
+      file.close();
+      return -5;
+    }
+
+    return 0;
+  }
+
+  int MkvWriter::close() {
+
+    int r = 0;
+    uint64_t duration = 0;
+    double duration_ms = 0.0;
+    uint64_t bits = 0;
+
+    if (false == file.isOpen()) {
+      printf("Error: cannot close the MKV writer, it's not open.\n");
+      return -1;
+    }
+
+    if (true == has_cluster && 0 != endCluster()) {
+      r = -2;
+    }
+
+    if (0 != writeCues()) {
+      r = -3;
+    }
+
+    /* The duration includes the last frame. */
+    if (0 != num_frames) {
+      duration = last_time + (100000ull / fps);
+    }
+
+    duration_ms = (double)duration;
+    memcpy(&bits, &duration_ms, sizeof(bits));
+    patchBigEndian(duration_offset, bits);
+
+    patchSize(segment_offset, file.tell() - segment_data_offset);
+
+    if (0 != file.close()) {
+      r = -4;
+    }
+
+    cues.clear();
+
+    return r;
+  }
+
+  int MkvWriter::writeFrame(const DataChunk* chunks, int nchunks, uint64_t timestamp, bool keyframe) {
+
+    uint64_t nbytes = 0;
+    uint64_t time = 0;
+    uint64_t rel = 0;
+
+    if (false == file.isOpen()) {
+      printf("Error: cannot write a frame, the MKV writer isn't open.\n");
+      return -1;
+    }
+
+    for (int i = 0; i < nchunks; ++i) {
+      nbytes += chunks[i].nbytes;
+    }
+
+    if (0 == num_frames) {
+      first_timestamp = timestamp;
+    }
+
+    /* Milliseconds since the first frame; timestamps must not go back. */
+    if (timestamp > first_timestamp) {
+      time = (timestamp - first_timestamp) / 1000000ull;
+    }
+
+    if (time < last_time) {
+      time = last_time;
+    }
+
+    if (false == has_cluster
+        || (time - cluster_time) > MKV_CLUSTER_MAX_TIME
+        || (file.tell() - cluster_offset) > MKV_CLUSTER_MAX_SIZE
+        || (true == keyframe && (time - cluster_time) >= MKV_CLUSTER_DURATION))
+    {
+      if (true == has_cluster && 0 != endCluster()) {
+        return -2;
+      }
+      if (0 != beginCluster(time, keyframe)) {
+        return -3;
+      }
+    }
+
+    rel = time - cluster_time;
+
+    /* SimpleBlock: track number, relative timecode and flags, then the frame. */
+    writeId(MKV_SIMPLE_BLOCK);
+    writeSize(4 + nbytes);
+    file.writeU8(0x81);
+    writeBigEndian(rel, 2);
+    file.writeU8((true == keyframe) ? 0x80 : 0x00);
+
+    if (0 != file.write(chunks, nchunks)) {
+      return -4;
+    }
+
+    last_time = time;
+    num_frames++;
+
+    return 0;
+  }
+
+  uint64_t MkvWriter::getNumFrames() {
+    return num_frames;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  int MkvWriter::writeHeader() {
+
+    uint64_t ebml_offset = 0;
+    uint64_t seek_head_offset = 0;
+    uint64_t info_seek_offset = 0;
+    uint64_t tracks_seek_offset = 0;
+    uint64_t info_offset = 0;
+    uint64_t tracks_offset = 0;
+    uint64_t entry_offset = 0;
+    uint64_t video_offset = 0;
+    uint32_t seek_ids[3] = { MKV_INFO, MKV_TRACKS, MKV_CUES };
+    uint64_t* seek_offsets[3] = { &info_seek_offset, &tracks_seek_offset, &cues_seek_offset };
+
+    /* EBML header. */
+    writeId(MKV_EBML);
+    ebml_offset = file.tell();
+    writeUnknownSize();
+    writeUInt(MKV_EBML_VERSION, 1);
+    writeUInt(MKV_EBML_READ_VERSION, 1);
+    writeUInt(MKV_EBML_MAX_ID_LENGTH, 4);
+    writeUInt(MKV_EBML_MAX_SIZE_LENGTH, 8);
+    writeString(MKV_DOC_TYPE, "matroska");
+    writeUInt(MKV_DOC_TYPE_VERSION, 4);
+    writeUInt(MKV_DOC_TYPE_READ_VERSION, 2);
+    patchSize(ebml_offset, file.tell() - ebml_offset - 8);
+
+    writeId(MKV_SEGMENT);
+    segment_offset = file.tell();
+    writeUnknownSize();
+    segment_data_offset = file.tell();
+
+    /* SeekHead; the positions are 8 bytes so we can patch them. */
+    writeId(MKV_SEEK_HEAD);
+    seek_head_offset = file.tell();
+    writeUnknownSize();
+
+    for (int i = 0; i < 3; ++i) {
+      writeId(MKV_SEEK);
+      writeSize(7 + 11);
+      writeId(MKV_SEEK_ID);
+      writeSize(4);
+      writeBigEndian(seek_ids[i], 4);
+      writeId(MKV_SEEK_POSITION);
+      writeSize(8);
+      *seek_offsets[i] = file.tell();
+      writeBigEndian(0, 8);
+    }
+
+    patchSize(seek_head_offset, file.tell() - seek_head_offset - 8);
+
+    /* Info; the duration is patched in `close()`. */
+    info_offset = file.tell();
+    writeId(MKV_INFO);
+    writeUnknownSize();
+    writeUInt(MKV_TIMECODE_SCALE, 1000000);
+    writeString(MKV_MUXING_APP, "videocapture");
+    writeString(MKV_WRITING_APP, "videocapture");
+    writeFloat(MKV_DURATION, 0.0);
+    duration_offset = file.tell() - 8;
+    patchSize(info_offset + 4, file.tell() - info_offset - 12);
+
+    /* Tracks. */
+    tracks_offset = file.tell();
+    writeId(MKV_TRACKS);
+    writeUnknownSize();
+    writeId(MKV_TRACK_ENTRY);
+    entry_offset = file.tell();
+    writeUnknownSize();
+    writeUInt(MKV_TRACK_NUMBER, 1);
+    writeUInt(MKV_TRACK_UID, 1);
+    writeUInt(MKV_TRACK_TYPE, 1);
+    writeUInt(MKV_FLAG_LACING, 0);
+
+    if (CA_H264 == pixel_format || CA_H265 == pixel_format) {
+      writeString(MKV_CODEC_ID, (CA_H264 == pixel_format) ? "V_MPEG4/ISO/AVC" : "V_MPEGH/ISO/HEVC");
+      writeId(MKV_CODEC_PRIVATE);
+      writeSize(codec_private.size());
+      file.write(&codec_private[0], codec_private.size());
+    }
+    else {
+      writeString(MKV_CODEC_ID, "V_MJPEG");
+    }
+
+    writeUInt(MKV_DEFAULT_DURATION, (100ull * 1000000000ull) / fps);
+    writeId(MKV_VIDEO);
+    video_offset = file.tell();
+    writeUnknownSize();
+    writeUInt(MKV_PIXEL_WIDTH, (uint64_t)width);
+    writeUInt(MKV_PIXEL_HEIGHT, (uint64_t)height);
+    patchSize(video_offset, file.tell() - video_offset - 8);
+    patchSize(entry_offset, file.tell() - entry_offset - 8);
+    patchSize(tracks_offset + 4, file.tell() - tracks_offset - 12);
+
+    patchBigEndian(info_seek_offset, info_offset - segment_data_offset);
+
+    return patchBigEndian(tracks_seek_offset, tracks_offset - segment_data_offset);
+  }
+
+  int MkvWriter::beginCluster(uint64_t time, bool keyframe) {
+
+    MkvCuePoint cue;
+
+    /* A player can only start decoding at a key frame. */
+    if (true == keyframe) {
+      cue.time = time;
+      cue.position = file.tell() - segment_data_offset;
+      cues.push_back(cue);
+    }
+
+    writeId(MKV_CLUSTER);
+    cluster_offset = file.tell();
+    writeUnknownSize();
+    writeUInt(MKV_TIMECODE, time);
+
+    cluster_time = time;
+    has_cluster = true;
+
+    return 0;
+  }
+
+  int MkvWriter::endCluster() {
+    has_cluster = false;
+    return patchSize(cluster_offset, file.tell() - cluster_offset - 8);
+  }
+
+  int MkvWriter::writeCues() {
+
+    uint64_t cues_offset = file.tell();
+
+    if (0 == cues.size()) {
+      return 0;
+    }
+
+    writeId(MKV_CUES);
+    writeUnknownSize();
+
+    for (size_t i = 0; i < cues.size(); ++i) {
+
+      int time_size = mkv_get_uint_size(cues[i].time);
+      int pos_size = mkv_get_uint_size(cues[i].position);
+      uint64_t track_positions_size = 3 + 2 + pos_size;
+
+      writeId(MKV_CUE_POINT);
+      writeSize(2 + time_size + 2 + track_positions_size);
+      writeUInt(MKV_CUE_TIME, cues[i].time);
+      writeId(MKV_CUE_TRACK_POSITIONS);
+      writeSize(track_positions_size);
+      writeUInt(MKV_CUE_TRACK, 1);
+      writeUInt(MKV_CUE_CLUSTER_POSITION, cues[i].position);
+    }
+
+    patchSize(cues_offset + 4, file.tell() - cues_offset - 12);
+
+    return patchBigEndian(cues_seek_offset, cues_offset - segment_data_offset);
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  int MkvWriter::writeId(uint32_t id) {
+
+    int nbytes = 1;
+
+    if (id > 0xFFFFFF) {
+      nbytes = 4;
+    }
+    else if (id > 0xFFFF) {
+      nbytes = 3;
+    }
+    else if (id > 0xFF) {
+      nbytes = 2;
+    }
+
+    return writeBigEndian(id, nbytes);
+  }
+
+  int MkvWriter::writeSize(uint64_t size) {
+
+    /* A length of n bytes holds 7 * n bits; all ones is reserved for "unknown". */
+    int nbytes = 1;
+
+    while (nbytes < 8 && size >= ((1ull << (7 * nbytes)) - 1)) {
+      nbytes++;
+    }
+
+    return writeBigEndian(size | (1ull << (7 * nbytes)), nbytes);
+  }
+
+  int MkvWriter::writeUnknownSize() {
+    return writeBigEndian(0x01FFFFFFFFFFFFFFull, 8);
+  }
+
+  int MkvWriter::patchSize(uint64_t offset, uint64_t size) {
+    return patchBigEndian(offset, size | (1ull << 56));
+  }
+
+  int MkvWriter::patchBigEndian(uint64_t offset, uint64_t v) {
+
+    uint8_t b[8];
+
+    for (int i = 0; i < 8; ++i) {
+      b[i] = (uint8_t)((v >> (56 - 8 * i)) & 0xFF);
+    }
+
+    return file.patch(offset, b, sizeof(b));
+  }
+
+  int MkvWriter::writeUInt(uint32_t id, uint64_t v) {
+
+    int nbytes = mkv_get_uint_size(v);
+
+    writeId(id);
+    writeSize(nbytes);
+
+    return writeBigEndian(v, nbytes);
+  }
+
+  int MkvWriter::writeString(uint32_t id, const char* str) {
+
+    size_t nbytes = strlen(str);
+
+    writeId(id);
+    writeSize(nbytes);
+
+    return file.write(str, nbytes);
+  }
+
+  int MkvWriter::writeFloat(uint32_t id, double v) {
+
+    uint64_t bits = 0;
+
+    memcpy(&bits, &v, sizeof(bits));
+
+    writeId(id);
+    writeSize(8);
+
+    return writeBigEndian(bits, 8);
+  }
+
+  int MkvWriter::writeBigEndian(uint64_t v, int nbytes) {
+
+    uint8_t b[8];
+
+    for (int i = 0; i < nbytes; ++i) {
+      b[i] = (uint8_t)((v >> (8 * (nbytes - 1 - i))) & 0xFF);
+    }
+
+    return file.write(b, nbytes);
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  static int mkv_get_uint_size(uint64_t v) {
+
+    int nbytes = 1;
+
+    while (nbytes < 8 && (v >> (8 * nbytes)) != 0) {
+      nbytes++;
+    }
+
+    return nbytes;
+  }
+
+} /* namespace ca */
@@ -0,0 +1,408 @@
+#include <string.h>
+#include <videocapture/Mp4Writer.h>
+#include <videocapture/Utils.h>
+
+#define MP4_TIMESCALE 90000                                                         /* Ticks per second of the video track. */
+#define MP4_FRAGMENT_DURATION MP4_TIMESCALE                                         /* We start a new fragment at the first key frame after this many ticks. */
+#define MP4_FRAGMENT_MAX_SIZE (32 * 1024 * 1024)                                    /* We start a new fragment when the current one would grow beyond this size. */
+#define MP4_FRAGMENT_RESERVE (1024 * 1024)                                          /* The number of bytes we reserve for the frames of a fragment. */
+#define MP4_SAMPLES_RESERVE 256                                                     /* The number of samples we reserve for a fragment. */
+#define MP4_SAMPLE_FLAGS_KEYFRAME 0x02000000                                        /* sample_depends_on = 2 (no other sample). */
+#define MP4_SAMPLE_FLAGS_DELTA 0x01010000                                           /* sample_depends_on = 1 and sample_is_non_sync_sample. */
+#define MP4_TFHD_DEFAULT_BASE_IS_MOOF 0x020000
+#define MP4_TRUN_FLAGS 0x000701                                                     /* data-offset, sample-duration, sample-size and sample-flags present. */
+
+namespace ca {
+
+  static const uint32_t mp4_unity_matrix[9] = {
+    0x00010000, 0, 0,
+    0, 0x00010000, 0,
+    0, 0, 0x40000000
+  };
+
+  /* ------------------------------------------------------------------------- */
+
+  Mp4Writer::Mp4Writer()
+    :fragment_used(0)
+    ,width(0)
+    ,height(0)
+    ,pixel_format(CA_NONE)
+    ,frame_duration(0)
+    ,first_timestamp(0)
+    ,last_time(0)
+    ,num_frames(0)
+    ,sequence_number(0)
+  {
+  }
+
+  Mp4Writer::~Mp4Writer() {
+    if (true == file.isOpen()) {
+      close();
+    }
+  }
+
+  int Mp4Writer::open(const std::string& filepath, int w, int h, int fmt, int fps) {
+
+    if (true == file.isOpen()) {
+      printf("Error: cannot open %s, the MP4 writer is already open.\n", filepath.c_str());
+      return -1;
+    }
+
+    if (CA_H264 != fmt && CA_H265 != fmt) {
+      printf("Error: the MP4 writer can only store H.264 and H.265 frames.\n");
+      return -2;
+    }
+
+    if (0 == codec_private.size()) {
+      printf("Error: cannot store %s in MP4 without the decoder configuration, call setCodecPrivate() first.\n", format_to_string(fmt).c_str());
+      return -2;
+    }
+
+    if (0 >= w || 0 >= h || 0xFFFF < w || 0xFFFF < h) {
+      printf("Error: invalid frame size for the MP4 writer: %d x %d.\n", w, h);
+      return -3;
+    }
+
+    if (0 != file.open(filepath)) {
+      return -4;
+    }
+
+    width = w;
+    height = h;
+    pixel_format = fmt;
+    frame_duration = (uint32_t)((100ull * MP4_TIMESCALE) / ((0 < fps) ? fps : CA_FPS_30_00));
+    first_timestamp = 0;
+    last_time = 0;
+    num_frames = 0;
+    sequence_number = 0;
+
+    samples.clear();
+    samples.reserve(MP4_SAMPLES_RESERVE);
+    fragment.resize(MP4_FRAGMENT_RESERVE);
+    fragment_used = 0;
+
+    if (0 != writeHeader()) {
+      file.close();
+      return -5;
+    }
+
+    return 0;
+  }
+
+  int Mp4Writer::close() {
+
+    int r = 0;
+
+    if (false == file.isOpen()) {
+      printf("Error: cannot close the MP4 writer, it's not open.\n");
+      return -1;
+    }
+
+    if (0 != samples.size() && 0 != writeFragment(last_time + frame_duration)) {
+      r = -2;
+    }
+
+    if (0 != file.close()) {
+      r = -3;
+    }
+
+    samples.clear();
+    fragment.clear();
+    fragment_used = 0;
+
+    return r;
+  }
+
+  int Mp4Writer::writeFrame(const DataChunk* chunks, int nchunks, uint64_t timestamp, bool keyframe) {
+
+    Mp4Sample sample;
+    size_t nbytes = 0;
+    uint64_t time = 0;
+
+    if (false == file.isOpen()) {
+      printf("Error: cannot write a frame, the MP4 writer isn't open.\n");
+      return -1;
+    }
+
+    for (int i = 0; i < nchunks; ++i) {
+      nbytes += chunks[i].nbytes;
+    }
+
+    if (0xFFFFFFFF < (uint64_t)nbytes) {
+      printf("Error: the frame is too large for MP4.\n");
+      return -2;
+    }
+
+    if (0 == num_frames) {
+      first_timestamp = timestamp;
+    }
+
+    /* Ticks since the first frame; every frame needs a duration, so time must go forward. */
+    if (timestamp > first_timestamp) {
+      time = ((timestamp - first_timestamp) * 9 + 50000) / 100000;
+    }
+
+    if (0 != num_frames && time <= last_time) {
+      time = last_time + 1;
+    }
+
+    if (0 != samples.size()
+        && ((true == keyframe && (time - samples[0].time) >= MP4_FRAGMENT_DURATION)
+            || (fragment_used + nbytes) > MP4_FRAGMENT_MAX_SIZE))
+    {
+      if (0 != writeFragment(time)) {
+        return -3;
+      }
+    }
+
+    if (fragment_used + nbytes > fragment.size()) {
+      fragment.resize(((fragment_used + nbytes) > (2 * fragment.size())) ? (fragment_used + nbytes) : (2 * fragment.size()));
+    }
+
+    for (int i = 0; i < nchunks; ++i) {
+      if (0 != chunks[i].nbytes) {
+        memcpy(&fragment[fragment_used], chunks[i].data, chunks[i].nbytes);
+        fragment_used += chunks[i].nbytes;
+      }
+    }
+
+    sample.time = time;
+    sample.size = (uint32_t)nbytes;
+    sample.keyframe = keyframe;
+    samples.push_back(sample);
+
+    last_time = time;
+    num_frames++;
+
+    return 0;
+  }
+
+  uint64_t Mp4Writer::getNumFrames() {
+    return num_frames;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  int Mp4Writer::writeHeader() {
+
+    uint64_t moov, trak, tkhd, mdia, minf, dinf, dref, stbl, stsd, entry, config, mvex, box;
+
+    box = beginBox("ftyp");
+    file.writeFourCC("isom");                                                       /* major_brand */
+    file.writeU32BE(0x200);                                                         /* minor_version */
+    file.writeFourCC("isom");                                                       /* compatible_brands */
+    file.writeFourCC("iso5");
+    file.writeFourCC("iso6");
+    file.writeFourCC("avc1");
+    file.writeFourCC("mp41");
+    endBox(box);
+
+    moov = beginBox("moov");
+
+    box = beginFullBox("mvhd", 0, 0);
+    file.writeU32BE(0);                                                             /* creation_time */
+    file.writeU32BE(0);                                                             /* modification_time */
+    file.writeU32BE(1000);                                                          /* timescale */
+    file.writeU32BE(0);                                                             /* duration; unknown, see the fragments */
+    file.writeU32BE(0x00010000);                                                    /* rate */
+    file.writeU16BE(0x0100);                                                        /* volume */
+    file.writeZeros(10);                                                            /* reserved */
+    for (int i = 0; i < 9; ++i) {
+      file.writeU32BE(mp4_unity_matrix[i]);
+    }
+    file.writeZeros(24);                                                            /* pre_defined */
+    file.writeU32BE(2);                                                             /* next_track_ID */
+    endBox(box);
+
+    trak = beginBox("trak");
+
+    tkhd = beginFullBox("tkhd", 0, 0x000003);                                       /* enabled, in movie */
+    file.writeU32BE(0);                                                             /* creation_time */
+    file.writeU32BE(0);                                                             /* modification_time */
+    file.writeU32BE(1);                                                             /* track_ID */
+    file.writeU32BE(0);                                                             /* reserved */
+    file.writeU32BE(0);                                                             /* duration */
+    file.writeZeros(8);                                                             /* reserved */
+    file.writeU16BE(0);                                                             /* layer */
+    file.writeU16BE(0);                                                             /* alternate_group */
+    file.writeU16BE(0);                                                             /* volume */
+    file.writeU16BE(0);                                                             /* reserved */
+    for (int i = 0; i < 9; ++i) {
+      file.writeU32BE(mp4_unity_matrix[i]);
+    }
+    file.writeU32BE((uint32_t)width << 16);                                         /* width, 16.16 */
+    file.writeU32BE((uint32_t)height << 16);                                        /* height, 16.16 */
+    endBox(tkhd);
+
+    mdia = beginBox("mdia");
+
+    box = beginFullBox("mdhd", 0, 0);
+    file.writeU32BE(0);                                                             /* creation_time */
+    file.writeU32BE(0);                                                             /* modification_time */
+    file.writeU32BE(MP4_TIMESCALE);                                                 /* timescale */
+    file.writeU32BE(0);                                                             /* duration */
+    file.writeU16BE(0x55C4);                                                        /* language, 'und' */
+    file.writeU16BE(0);                                                             /* pre_defined */
+    endBox(box);
+
+    box = beginFullBox("hdlr", 0, 0);
+    file.writeU32BE(0);                                                             /* pre_defined */
+    file.writeFourCC("vide");                                                       /* handler_type */
+    file.writeZeros(12);                                                            /* reserved */
+    file.write("VideoHandler", 13);                                                 /* name, including the terminating zero */
+    endBox(box);
+
+    minf = beginBox("minf");
+
+    box = beginFullBox("vmhd", 0, 0x000001);
+    file.writeU16BE(0);                                                             /* graphicsmode */
+    file.writeZeros(6);                                                             /* opcolor */
+    endBox(box);
+
+    dinf = beginBox("dinf");
+    dref = beginFullBox("dref", 0, 0);
+    file.writeU32BE(1);                                                             /* entry_count */
+    endBox(beginFullBox("url ", 0, 0x000001));                                      /* the data is in this file */
+    endBox(dref);
+    endBox(dinf);
+
+    stbl = beginBox("stbl");
+
+    stsd = beginFullBox("stsd", 0, 0);
+    file.writeU32BE(1);                                                             /* entry_count */
+
+    /* The sample entry and decoder configuration: avc1/avcC or hvc1/hvcC. */
+    entry = beginBox((CA_H265 == pixel_format) ? "hvc1" : "avc1");
+    file.writeZeros(6);                                                             /* reserved */
+    file.writeU16BE(1);                                                             /* data_reference_index */
+    file.writeZeros(16);                                                            /* pre_defined, reserved */
+    file.writeU16BE((uint16_t)width);
+    file.writeU16BE((uint16_t)height);
+    file.writeU32BE(0x00480000);                                                    /* horizresolution, 72 dpi */
+    file.writeU32BE(0x00480000);                                                    /* vertresolution, 72 dpi */
+    file.writeU32BE(0);                                                             /* reserved */
+    file.writeU16BE(1);                                                             /* frame_count */
+    file.writeZeros(32);                                                            /* compressorname */
+    file.writeU16BE(0x0018);                                                        /* depth */
+    file.writeU16BE(0xFFFF);                                                        /* pre_defined */
+
+    config = beginBox((CA_H265 == pixel_format) ? "hvcC" : "avcC");
+    file.write(&codec_private[0], codec_private.size());
+    endBox(config);
+
+    endBox(entry);
+    endBox(stsd);
+
+    /* The sample tables are empty; the samples are in the fragments. */
+    box = beginFullBox("stts", 0, 0);
+    file.writeU32BE(0);
+    endBox(box);
+
+    box = beginFullBox("stsc", 0, 0);
+    file.writeU32BE(0);
+    endBox(box);
+
+    box = beginFullBox("stsz", 0, 0);
+    file.writeU32BE(0);                                                             /* sample_size */
+    file.writeU32BE(0);                                                             /* sample_count */
+    endBox(box);
+
+    box = beginFullBox("stco", 0, 0);
+    file.writeU32BE(0);
+    endBox(box);
+
+    endBox(stbl);
+    endBox(minf);
+    endBox(mdia);
+    endBox(trak);
+
+    mvex = beginBox("mvex");
+    box = beginFullBox("trex", 0, 0);
+    file.writeU32BE(1);                                                             /* track_ID */
+    file.writeU32BE(1);                                                             /* default_sample_description_index */
+    file.writeU32BE(0);                                                             /* default_sample_duration */
+    file.writeU32BE(0);                                                             /* default_sample_size */
+    file.writeU32BE(0);                                                             /* default_sample_flags */
+    endBox(box);
+    endBox(mvex);
+
+    return endBox(moov);
+  }
+
+  int Mp4Writer::writeFragment(uint64_t endtime) {
+
+    uint64_t moof, traf, box;
+    uint64_t data_offset = 0;
+
+    moof = beginBox("moof");
+
+    box = beginFullBox("mfhd", 0, 0);
+    file.writeU32BE(++sequence_number);
+    endBox(box);
+
+    traf = beginBox("traf");
+
+    box = beginFullBox("tfhd", 0, MP4_TFHD_DEFAULT_BASE_IS_MOOF);
+    file.writeU32BE(1);                                                             /* track_ID */
+    endBox(box);
+
+    box = beginFullBox("tfdt", 1, 0);
+    file.writeU64BE(samples[0].time);                                               /* baseMediaDecodeTime */
+    endBox(box);
+
+    box = beginFullBox("trun", 0, MP4_TRUN_FLAGS);
+    file.writeU32BE((uint32_t)samples.size());                                      /* sample_count */
+    data_offset = file.tell();
+    file.writeU32BE(0);                                                             /* data_offset; patched below */
+
+    for (size_t i = 0; i < samples.size(); ++i) {
+      uint64_t next = (i + 1 < samples.size()) ? samples[i + 1].time : endtime;
+      file.writeU32BE((uint32_t)(next - samples[i].time));
+      file.writeU32BE(samples[i].size);
+      file.writeU32BE((true == samples[i].keyframe) ? MP4_SAMPLE_FLAGS_KEYFRAME : MP4_SAMPLE_FLAGS_DELTA);
+    }
+
+    endBox(box);
+    endBox(traf);
+    endBox(moof);
+
+    /* The data offset is relative to the 'moof'; the samples start after the 'mdat' header. */
+    file.patchU32BE(data_offset, (uint32_t)(file.tell() - moof + 8));
+
+    file.writeU32BE((uint32_t)(8 + fragment_used));
+    file.writeFourCC("mdat");
+
+    if (0 != file.write(&fragment[0], fragment_used)) {
+      return -1;
+    }
+
+    samples.clear();
+    fragment_used = 0;
+
+    return 0;
+  }
+
+  uint64_t Mp4Writer::beginBox(const char* type) {
+
+    uint64_t offset = file.tell();
+
+    file.writeU32BE(0);
+    file.writeFourCC(type);
+
+    return offset;
+  }
+
+  uint64_t Mp4Writer::beginFullBox(const char* type, uint8_t version, uint32_t flags) {
+
+    uint64_t offset = beginBox(type);
+
+    file.writeU32BE(((uint32_t)version << 24) | (flags & 0x00FFFFFF));
+
+    return offset;
+  }
+
+  int Mp4Writer::endBox(uint64_t offset) {
+    return file.patchU32BE(offset, (uint32_t)(file.tell() - offset));
+  }
+
+} /* namespace ca */
@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <algorithm>
+#include <videocapture/Log.h>
+#include <videocapture/Error.h>
+#include <videocapture/Utils.h>
+#include <videocapture/PixelBufferPool.h>
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  PixelBufferPool::PixelBufferPool()
+    :is_init(false)
+  {
+    mutex_create(mutex);
+  }
+
+  PixelBufferPool::~PixelBufferPool() {
+    shutdown();
+    mutex_destroy(mutex);
+  }
+
+  int PixelBufferPool::init(int width, int height, int fmt, int count) {
+
+    if (true == is_init) {
+      printf("Error: cannot init the pixel buffer pool, already initialized.\n");
+      return -1;
+    }
+
+    if (0 >= count) {
+      printf("Error: cannot init the pixel buffer pool, invalid count: %d.\n", count);
+      return -2;
+    }
+
+    for (int i = 0; i < count; ++i) {
+
+      PixelBuffer* buf = new PixelBuffer();
+
+      if (0 != buf->setup(width, height, fmt)) {
+        printf("Error: cannot init the pixel buffer pool for %s, %d x %d.\n", format_to_string(fmt).c_str(), width, height);
+        delete buf;
+        shutdown();
+        return -3;
+      }
+
+      uint8_t* data = new uint8_t[buf->nbytes + 63];
+      uint8_t* aligned = (uint8_t*)(((uintptr_t)data + 63) & ~(uintptr_t)63);
+
+      buf->setPixels(aligned);
+
+      memory.push_back(data);
+      buffers.push_back(buf);
+      free_buffers.push_back(buf);
+    }
+
+    is_init = true;
+
+    return 0;
+  }
+
+  int PixelBufferPool::shutdown() {
+
+    mutex_lock(mutex);
+    {
+      if (free_buffers.size() != buffers.size()) {
+        printf("Warning: shutting down the pixel buffer pool while %d buffer(s) are in use.\n",
+               (int)(buffers.size() - free_buffers.size()));
+      }
+
+      for (size_t i = 0; i < buffers.size(); ++i) {
+        delete buffers[i];
+      }
+
+      for (size_t i = 0; i < memory.size(); ++i) {
+        delete[] memory[i];
+      }
+
+      buffers.clear();
+      free_buffers.clear();
+      memory.clear();
+      is_init = false;
+    }
+    mutex_unlock(mutex);
+
+    return 0;
+  }
+
+  PixelBuffer* PixelBufferPool::acquire() {
+
+    PixelBuffer* result = NULL;
+
+    mutex_lock(mutex);
+    {
+      if (0 != free_buffers.size()) {
+        result = free_buffers.back();
+        free_buffers.pop_back();
+      }
+    }
+    mutex_unlock(mutex);
+
+    return result;
+  }
+
+  int PixelBufferPool::release(PixelBuffer* buffer) {
+
+    int r = 0;
+
+    if (NULL == buffer) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("cannot release a NULL buffer into the pool.");
+      return -1;
+    }
+
+    mutex_lock(mutex);
+    {
+      if (buffers.end() == std::find(buffers.begin(), buffers.end(), buffer)) {
+        error_set(CA_ERR_INVALID_ARGUMENT, 0);
+        CA_LOG_ERROR("cannot release a buffer that isn't part of the pool.");
+        r = -2;
+      }
+      else if (free_buffers.end() != std::find(free_buffers.begin(), free_buffers.end(), buffer)) {
+        error_set(CA_ERR_INVALID_ARGUMENT, 0);
+        CA_LOG_ERROR("the buffer was already released.");
+        r = -3;
+      }
+      else {
+        free_buffers.push_back(buffer);
+      }
+    }
+    mutex_unlock(mutex);
+
+    return r;
+  }
+
+  int PixelBufferPool::getNumFree() {
+
+    int n = 0;
+
+    mutex_lock(mutex);
+    n = (int)free_buffers.size();
+    mutex_unlock(mutex);
+
+    return n;
+  }
+
+  int PixelBufferPool::getNumBuffers() {
+
+    int n = 0;
+
+    mutex_lock(mutex);
+    n = (int)buffers.size();
+    mutex_unlock(mutex);
+
+    return n;
+  }
+
+} /* namespace ca */
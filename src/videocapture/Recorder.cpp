@@ -0,0 +1,229 @@
+#include <videocapture/Recorder.h>
+#include <videocapture/AviWriter.h>
+#include <videocapture/MkvWriter.h>
+#include <videocapture/Mp4Writer.h>
+#include <videocapture/JpegMarkers.h>
+#include <videocapture/Log.h>
+#include <videocapture/Error.h>
+#include <videocapture/Utils.h>
+#include <videocapture/Trace.h>
+
+namespace ca {
+
+  Recorder::Recorder()
+    :writer(NULL)
+    ,pixel_format(CA_NONE)
+    ,fps(0)
+    ,is_writer_open(false)
+    ,num_corrupt(0)
+    ,num_skipped(0)
+  {
+  }
+
+  Recorder::~Recorder() {
+    if (NULL != writer) {
+      close();
+    }
+  }
+
+  int Recorder::open(const std::string& path, int container, int width, int height, int fmt, int framerate) {
+
+    if (NULL != writer) {
+      printf("Error: cannot open %s, the recorder is already open.\n", path.c_str());
+      return -1;
+    }
+
+    if (CA_MJPEG != fmt && CA_JPEG_OPENDML != fmt && CA_H264 != fmt) {
+      printf("Error: the recorder can only store MJPEG and H.264 frames.\n");
+      return -2;
+    }
+
+    if (CA_CONTAINER_AVI == container && CA_H264 != fmt) {
+      writer = new AviWriter();
+    }
+    else if (CA_CONTAINER_MKV == container) {
+      writer = new MkvWriter();
+    }
+    else if (CA_CONTAINER_MP4 == container && CA_H264 == fmt) {
+      writer = new Mp4Writer();
+    }
+    else {
+      printf("Error: cannot store %s in container %d.\n", format_to_string(fmt).c_str(), container);
+      return -3;
+    }
+
+    filepath = path;
+    pixel_format = fmt;
+    fps = framerate;
+    is_writer_open = false;
+    num_corrupt = 0;
+    num_skipped = 0;
+
+    /* H.264 is opened when we have the parameter sets, see `openH264()`. */
+    if (CA_H264 == fmt) {
+      return 0;
+    }
+
+    if (0 != writer->open(filepath, width, height, fmt, fps)) {
+      delete writer;
+      writer = NULL;
+      return -4;
+    }
+
+    is_writer_open = true;
+
+    return 0;
+  }
+
+  int Recorder::close() {
+
+    int r = 0;
+
+    if (NULL == writer) {
+      printf("Error: cannot close the recorder, it's not open.\n");
+      return -1;
+    }
+
+    if (true == is_writer_open) {
+      r = writer->close();
+    }
+    else {
+      printf("Error: %s wasn't created; we never received a key frame.\n", filepath.c_str());
+      r = -2;
+    }
+
+    delete writer;
+    writer = NULL;
+    is_writer_open = false;
+
+    return r;
+  }
+
+  int Recorder::write(PixelBuffer& buffer) {
+
+    CA_TRACE_SCOPE("sink.write", buffer.sequence);
+
+    if (NULL == writer) {
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_ERROR("cannot write a frame, the recorder isn't open.");
+      return -1;
+    }
+
+    if (buffer.pixel_format != pixel_format) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("the recorder expects frames in %s, got %s.", format_to_string(pixel_format).c_str(), format_to_string(buffer.pixel_format).c_str());
+      return -2;
+    }
+
+    if (CA_H264 == pixel_format) {
+      return writeH264(buffer);
+    }
+
+    return writeJpeg(buffer);
+  }
+
+  uint64_t Recorder::getNumFrames() {
+
+    if (NULL == writer) {
+      return 0;
+    }
+
+    return writer->getNumFrames();
+  }
+
+  uint64_t Recorder::getNumCorrupt() {
+    return num_corrupt;
+  }
+
+  uint64_t Recorder::getNumSkipped() {
+    return num_skipped;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  int Recorder::writeJpeg(PixelBuffer& buffer) {
+
+    JpegMarkerInfo info;
+    JpegChunk chunks[CA_JPEG_MAX_CHUNKS];
+    int nchunks = 0;
+
+    if (0 != jpeg_scan_markers(buffer.plane[0], buffer.nbytes, info)) {
+      num_corrupt++;
+      return 1;
+    }
+
+    nchunks = jpeg_get_chunks(buffer.plane[0], buffer.nbytes, info, chunks);
+
+    if (0 != writer->writeFrame(chunks, nchunks, (0 != buffer.timestamp) ? buffer.timestamp : time_now_ns(), true)) {
+      return -3;
+    }
+
+    return 0;
+  }
+
+  int Recorder::writeH264(PixelBuffer& buffer) {
+
+    uint8_t lengths[CA_H264_MAX_NAL_UNITS * 4];
+    DataChunk chunks[CA_H264_MAX_CHUNKS];
+    int nchunks = 0;
+
+    if (0 != h264_scan_frame(buffer.plane[0], buffer.nbytes, h264_info)
+        || false == h264_info.has_slice)
+    {
+      num_corrupt++;
+      return 1;
+    }
+
+    if (false == is_writer_open) {
+
+      if (false == h264_info.is_idr || -1 == h264_info.sps_index || -1 == h264_info.pps_index) {
+        num_skipped++;
+        return 1;
+      }
+
+      if (0 != openH264(buffer.plane[0], h264_info)) {
+        return -3;
+      }
+    }
+
+    nchunks = h264_get_chunks(buffer.plane[0], h264_info, lengths, chunks);
+
+    if (0 != writer->writeFrame(chunks, nchunks, (0 != buffer.timestamp) ? buffer.timestamp : time_now_ns(), h264_info.is_idr)) {
+      return -4;
+    }
+
+    return 0;
+  }
+
+  int Recorder::openH264(const uint8_t* data, const H264FrameInfo& info) {
+
+    const H264NalUnit& sps = info.units[info.sps_index];
+    const H264NalUnit& pps = info.units[info.pps_index];
+    H264Sps sps_info;
+    size_t nbytes = 0;
+
+    if (0 != h264_parse_sps(data + sps.offset, sps.nbytes, sps_info)) {
+      printf("Error: cannot parse the SPS of the H.264 stream.\n");
+      return -1;
+    }
+
+    avcc.resize(sps.nbytes + pps.nbytes + 32);
+    nbytes = h264_get_avcc(data + sps.offset, sps.nbytes, data + pps.offset, pps.nbytes, &avcc[0], avcc.size());
+
+    if (0 == nbytes) {
+      printf("Error: cannot create the avcC of the H.264 stream.\n");
+      return -2;
+    }
+
+    writer->setCodecPrivate(&avcc[0], nbytes);
+
+    if (0 != writer->open(filepath, sps_info.width, sps_info.height, CA_H264, fps)) {
+      return -3;
+    }
+
+    is_writer_open = true;
+
+    return 0;
+  }
+
+} /* namespace ca */
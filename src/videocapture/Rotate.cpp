@@ -0,0 +1,542 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <videocapture/Cpu.h>
+#include <videocapture/Log.h>
+#include <videocapture/Error.h>
+#include <videocapture/Utils.h>
+#include <videocapture/Rotate.h>
+#include <videocapture/simd/SIMD_Rotate.h>
+
+/* Tiles are this many elements wide and high. The rows of a source and destination tile stay in L1 and within the reach of the L1 TLB; 64 was slower on 1080p BGRA. */
+#define ROTATE_TILE_SIZE 32
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  typedef void(*rotate_transpose_func)(const uint8_t* src, ptrdiff_t sstride, uint8_t* dst, ptrdiff_t dstride, int w, int h);
+
+  struct RotatePlanes {                                                             /* The planes of a format that we rotate. */
+    int num;                                                                        /* Number of planes. */
+    int bpp[3];                                                                     /* Bytes per element for each plane, e.g. 2 for the interleaved Cb/Cr plane of CA_YUV420BP. */
+  };
+
+  static int rotate_get_planes(int fmt, RotatePlanes& planes);                     /* Sets the planes for the given format. Returns 0 on success, < 0 when we can't rotate the format per plane. */
+  static rotate_transpose_func rotate_get_transpose(int bpp, int cpulevel);        /* Returns the best transpose for `bpp` at the given CA_CPU_* level. */
+  static void rotate_plane(const uint8_t* src, size_t sstride, int sw, int sh, uint8_t* dst, size_t dstride, int bpp, int degrees, int dy0, int dy1); /* Rotates the destination rows [dy0, dy1) of one plane. */
+  static void rotate_setup_padded(PixelBuffer& buf, std::vector<uint8_t>& mem, int w, int h, int fmt, int pad); /* Sets up `buf` with `pad` extra bytes per row, used by the self test. */
+  static void rotate_reference(const PixelBuffer& src, PixelBuffer& dst, int degrees); /* Per pixel rotate, used by the self test. */
+
+  /* ------------------------------------------------------------------------- */
+
+  template<int BPP>
+  static void rotate_transpose_c(const uint8_t* src, ptrdiff_t sstride, uint8_t* dst, ptrdiff_t dstride, int w, int h) {
+    simd_transpose_tail(src, sstride, dst, dstride, BPP, 0, w, 0, h);
+  }
+
+  template<int BPP>
+  static void rotate_plane_180(const uint8_t* src, size_t sstride, int sw, int sh, uint8_t* dst, size_t dstride, int dy0, int dy1) {
+
+    for (int y = dy0; y < dy1; ++y) {
+
+      const uint8_t* s = src + (sh - 1 - y) * sstride + (sw - 1) * BPP;
+      uint8_t* d = dst + y * dstride;
+
+      for (int x = 0; x < sw; ++x) {
+        memcpy(d + x * BPP, s - x * BPP, BPP);
+      }
+    }
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  /* Rotates every plane of the formats that `rotate_get_planes()` knows. */
+  template<int DEGREES>
+  static void rotate_planar(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    RotatePlanes planes;
+    if (0 != rotate_get_planes(dst.pixel_format, planes)) {
+      return;
+    }
+
+    int vsub = format_vertical_subsampling(dst.pixel_format);
+
+    for (int i = 0; i < planes.num; ++i) {
+
+      int sw = (int)((0 == src.width[i]) ? src.width[0] : src.width[i]);
+      int sh = (int)((0 == src.height[i]) ? src.height[0] : src.height[i]);
+      int dh = (int)((0 == dst.height[i]) ? dst.height[0] : dst.height[i]);
+      int r0 = y0;
+      int r1 = y1;
+
+      /* The chroma rows of the band; bands start at a multiple of `vsub`, see SliceScheduler. */
+      if (i > 0 && vsub > 1) {
+        r0 = y0 / vsub;
+        r1 = (y1 == (int)dst.height[0]) ? dh : (y1 / vsub);
+      }
+
+      if (r1 > dh) {
+        r1 = dh;
+      }
+
+      if (r0 >= r1) {
+        continue;
+      }
+
+      rotate_plane(src.plane[i], src.stride[i], sw, sh, dst.plane[i], dst.stride[i], planes.bpp[i], DEGREES, r0, r1);
+    }
+  }
+
+  /* Packed 4:2:2 by 180 degrees: the pairs are reversed and the two luma samples in a pair swap places. */
+  template<int Y0, int U, int Y1, int V>
+  static void rotate_packed422_180(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int pairs = (int)src.width[0] / 2;
+    int h = (int)src.height[0];
+
+    for (int y = y0; y < y1; ++y) {
+
+      const uint8_t* s = src.plane[0] + (h - 1 - y) * src.stride[0] + (pairs - 1) * 4;
+      uint8_t* d = dst.plane[0] + y * dst.stride[0];
+
+      for (int x = 0; x < pairs; ++x) {
+        d[4 * x + Y0] = s[Y1 - 4 * x];
+        d[4 * x + U] = s[U - 4 * x];
+        d[4 * x + Y1] = s[Y0 - 4 * x];
+        d[4 * x + V] = s[V - 4 * x];
+      }
+    }
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  pixel_kernel rotate_get_kernel(int fmt, int degrees) {
+
+    RotatePlanes planes;
+
+    if (CA_ROTATE_180 == degrees) {
+      if (CA_YUYV422 == fmt) {
+        return rotate_packed422_180<0, 1, 2, 3>;
+      }
+      if (CA_UYVY422 == fmt) {
+        return rotate_packed422_180<1, 0, 3, 2>;
+      }
+    }
+
+    if (0 != rotate_get_planes(fmt, planes)) {
+      return NULL;
+    }
+
+    /* CA_YUV422P rotated by 90 degrees would have vertically subsampled chroma, which we can't represent. */
+    if (CA_YUV422P == fmt && (CA_ROTATE_90 == degrees || CA_ROTATE_270 == degrees)) {
+      return NULL;
+    }
+
+    switch (degrees) {
+      case CA_ROTATE_NONE: { return rotate_planar<CA_ROTATE_NONE>; }
+      case CA_ROTATE_90:   { return rotate_planar<CA_ROTATE_90>;   }
+      case CA_ROTATE_180:  { return rotate_planar<CA_ROTATE_180>;  }
+      case CA_ROTATE_270:  { return rotate_planar<CA_ROTATE_270>;  }
+      default:             { return NULL;                          }
+    }
+  }
+
+  bool rotate_is_supported(int fmt, int degrees) {
+    return NULL != rotate_get_kernel(fmt, degrees);
+  }
+
+  int rotate_get_size(int width, int height, int degrees, int& outwidth, int& outheight) {
+
+    switch (degrees) {
+
+      case CA_ROTATE_NONE:
+      case CA_ROTATE_180: {
+        outwidth = width;
+        outheight = height;
+        return 0;
+      }
+
+      case CA_ROTATE_90:
+      case CA_ROTATE_270: {
+        outwidth = height;
+        outheight = width;
+        return 0;
+      }
+
+      default: {
+        error_set(CA_ERR_INVALID_ARGUMENT, 0);
+        CA_LOG_ERROR("invalid rotation: %d, use one of the CA_ROTATE_* values.", degrees);
+        return -1;
+      }
+    }
+  }
+
+  int rotate(const PixelBuffer& src, PixelBuffer& dst, int degrees, SliceScheduler* scheduler) {
+
+    int w = 0;
+    int h = 0;
+
+    if (0 != rotate_get_size((int)src.width[0], (int)src.height[0], degrees, w, h)) {
+      return -1;
+    }
+
+    if (w != (int)dst.width[0] || h != (int)dst.height[0]) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("cannot rotate %d x %d by %d degrees into %d x %d.",
+                   (int)src.width[0], (int)src.height[0], degrees, (int)dst.width[0], (int)dst.height[0]);
+      return -2;
+    }
+
+    if (src.pixel_format != dst.pixel_format) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("cannot rotate, the source and destination have a different pixel format.");
+      return -3;
+    }
+
+    if (NULL == src.plane[0] || NULL == dst.plane[0]) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("cannot rotate, the source or destination has no pixels.");
+      return -4;
+    }
+
+    pixel_kernel kernel = rotate_get_kernel(src.pixel_format, degrees);
+    if (NULL == kernel) {
+      error_set(CA_ERR_NOT_SUPPORTED, 0);
+      CA_LOG_ERROR("cannot rotate %s by %d degrees.", format_to_string(src.pixel_format).c_str(), degrees);
+      return -5;
+    }
+
+    if (NULL == scheduler) {
+      kernel(src, dst, 0, (int)dst.height[0]);
+      return 0;
+    }
+
+    return scheduler->run(kernel, src, dst);
+  }
+
+  int rotate_selftest() {
+
+    /* Sizes that exercise the blocks, the tile edges and the scalar tails. */
+    static const int sizes[][3] = {
+      { 2, 2, 0 },  { 6, 4, 5 },  { 16, 8, 0 },  { 34, 10, 3 },
+      { 66, 18, 16 }, { 130, 70, 1 }, { 24, 136, 32 }
+    };
+
+    static const int formats[] = {
+      CA_YUV420P, CA_YUV420BP, CA_YUV422P, CA_YUYV422, CA_UYVY422,
+      CA_ARGB32, CA_BGRA32, CA_RGBA32, CA_RGB24
+    };
+
+    static const int degrees[] = { CA_ROTATE_NONE, CA_ROTATE_90, CA_ROTATE_180, CA_ROTATE_270 };
+    static const int bpps[] = { 1, 2, 4 };
+
+    size_t nsizes = sizeof(sizes) / sizeof(sizes[0]);
+    size_t nformats = sizeof(formats) / sizeof(formats[0]);
+    size_t ndegrees = sizeof(degrees) / sizeof(degrees[0]);
+    int failed = 0;
+
+    /* The SIMD transposes, with a negative source stride like the 90 degree kernels use. */
+    for (size_t i = 0; i < 3; ++i) {
+
+      int level = cpu_get_level();
+      int bpp = bpps[i];
+      rotate_transpose_func reference = rotate_get_transpose(bpp, CA_CPU_SCALAR);
+      rotate_transpose_func transpose = rotate_get_transpose(bpp, level);
+
+      if (transpose == reference) {
+        continue;
+      }
+
+      for (size_t j = 0; j < nsizes; ++j) {
+
+        int w = sizes[j][0];
+        int h = sizes[j][1];
+        size_t sstride = w * bpp + sizes[j][2];
+        size_t dstride = h * bpp + sizes[j][2];
+        std::vector<uint8_t> src(sstride * h);
+        std::vector<uint8_t> ref(dstride * w, 0xCD);
+        std::vector<uint8_t> out(dstride * w, 0xCD);
+
+        srand((unsigned int)(i * 31 + j));
+        for (size_t b = 0; b < src.size(); ++b) {
+          src[b] = (uint8_t)(rand() & 0xFF);
+        }
+
+        reference(&src[0] + (h - 1) * sstride, -(ptrdiff_t)sstride, &ref[0], dstride, w, h);
+        transpose(&src[0] + (h - 1) * sstride, -(ptrdiff_t)sstride, &out[0], dstride, w, h);
+
+        if (ref != out) {
+          printf("Error: the transpose for %d byte elements at CPU level %s differs from the scalar one at %d x %d.\n",
+                 bpp, cpu_level_to_string(level).c_str(), w, h);
+          failed++;
+          break;
+        }
+      }
+    }
+
+    /* All kernels, in two bands, with a per pixel reference. */
+    for (size_t i = 0; i < nformats; ++i) {
+
+      for (size_t d = 0; d < ndegrees; ++d) {
+
+        int fmt = formats[i];
+        pixel_kernel kernel = rotate_get_kernel(fmt, degrees[d]);
+
+        if (NULL == kernel) {
+          continue;
+        }
+
+        for (size_t j = 0; j < nsizes; ++j) {
+
+          int w = sizes[j][0];
+          int h = sizes[j][1];
+          int rw = 0;
+          int rh = 0;
+          int vsub = format_vertical_subsampling(fmt);
+          std::vector<uint8_t> src_mem, ref_mem, out_mem;
+          PixelBuffer src, ref, out;
+
+          rotate_get_size(w, h, degrees[d], rw, rh);
+          rotate_setup_padded(src, src_mem, w, h, fmt, sizes[j][2]);
+          rotate_setup_padded(ref, ref_mem, rw, rh, fmt, sizes[j][2]);
+          rotate_setup_padded(out, out_mem, rw, rh, fmt, sizes[j][2]);
+
+          srand((unsigned int)(i * 31 + j));
+          for (size_t b = 0; b < src_mem.size(); ++b) {
+            src_mem[b] = (uint8_t)(rand() & 0xFF);
+          }
+
+          int mid = ((rh / 2) / vsub) * vsub;
+
+          rotate_reference(src, ref, degrees[d]);
+          kernel(src, out, 0, mid);
+          kernel(src, out, mid, rh);
+
+          /* Both have the same layout, so this compares the padding too. */
+          if (ref_mem != out_mem) {
+            printf("Error: the rotate kernel for %s by %d degrees differs from the reference at %d x %d (padding %d).\n",
+                   format_to_string(fmt).c_str(), degrees[d], w, h, sizes[j][2]);
+            failed++;
+            break;
+          }
+        }
+      }
+    }
+
+    return failed;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  static int rotate_get_planes(int fmt, RotatePlanes& planes) {
+
+    switch (fmt) {
+
+      case CA_YUV420P:
+      case CA_YUVJ420P:
+      case CA_YUV422P: {
+        planes.num = 3;
+        planes.bpp[0] = 1;
+        planes.bpp[1] = 1;
+        planes.bpp[2] = 1;
+        return 0;
+      }
+
+      case CA_YUV420BP:
+      case CA_YUVJ420BP: {
+        planes.num = 2;
+        planes.bpp[0] = 1;
+        planes.bpp[1] = 2;
+        planes.bpp[2] = 0;
+        return 0;
+      }
+
+      case CA_ARGB32:
+      case CA_BGRA32:
+      case CA_RGBA32: {
+        planes.num = 1;
+        planes.bpp[0] = 4;
+        planes.bpp[1] = 0;
+        planes.bpp[2] = 0;
+        return 0;
+      }
+
+      case CA_RGB24: {
+        planes.num = 1;
+        planes.bpp[0] = 3;
+        planes.bpp[1] = 0;
+        planes.bpp[2] = 0;
+        return 0;
+      }
+
+      default: {
+        return -1;
+      }
+    }
+  }
+
+  static rotate_transpose_func rotate_get_transpose(int bpp, int cpulevel) {
+
+#if defined(CA_ARCH_X86)
+    if (CA_CPU_SSE2 <= cpulevel && CA_CPU_NEON != cpulevel) {
+      switch (bpp) {
+        case 1: { return rotate_transpose_u8_sse2;  }
+        case 2: { return rotate_transpose_u16_sse2; }
+        case 4: { return rotate_transpose_u32_sse2; }
+        default: { break; }
+      }
+    }
+#elif defined(CA_ARCH_ARM)
+    if (CA_CPU_NEON == cpulevel) {
+      switch (bpp) {
+        case 1: { return rotate_transpose_u8_neon;  }
+        case 4: { return rotate_transpose_u32_neon; }
+        default: { break; }
+      }
+    }
+#endif
+
+    switch (bpp) {
+      case 1:  { return rotate_transpose_c<1>; }
+      case 2:  { return rotate_transpose_c<2>; }
+      case 3:  { return rotate_transpose_c<3>; }
+      default: { return rotate_transpose_c<4>; }
+    }
+  }
+
+  /*
+    For 90 degrees (clockwise) destination pixel (x, y) is source pixel
+    (y, sh - 1 - x): destination rows are source columns, read bottom up. So
+    we transpose while walking the source rows with a negative stride. For
+    270 degrees destination pixel (x, y) is source pixel (sw - 1 - y, x),
+    here we write the destination rows of a tile bottom up.
+  */
+  static void rotate_plane(const uint8_t* src, size_t sstride, int sw, int sh, uint8_t* dst, size_t dstride, int bpp, int degrees, int dy0, int dy1) {
+
+    if (CA_ROTATE_NONE == degrees) {
+      for (int y = dy0; y < dy1; ++y) {
+        memcpy(dst + y * dstride, src + y * sstride, sw * bpp);
+      }
+      return;
+    }
+
+    if (CA_ROTATE_180 == degrees) {
+      switch (bpp) {
+        case 1:  { rotate_plane_180<1>(src, sstride, sw, sh, dst, dstride, dy0, dy1); break; }
+        case 2:  { rotate_plane_180<2>(src, sstride, sw, sh, dst, dstride, dy0, dy1); break; }
+        case 3:  { rotate_plane_180<3>(src, sstride, sw, sh, dst, dstride, dy0, dy1); break; }
+        default: { rotate_plane_180<4>(src, sstride, sw, sh, dst, dstride, dy0, dy1); break; }
+      }
+      return;
+    }
+
+    rotate_transpose_func transpose = rotate_get_transpose(bpp, cpu_get_level());
+    ptrdiff_t ss = (ptrdiff_t)sstride;
+    ptrdiff_t ds = (ptrdiff_t)dstride;
+
+    for (int ty = dy0; ty < dy1; ty += ROTATE_TILE_SIZE) {
+
+      int th = (dy1 - ty < ROTATE_TILE_SIZE) ? (dy1 - ty) : ROTATE_TILE_SIZE;
+
+      for (int tx = 0; tx < sh; tx += ROTATE_TILE_SIZE) {
+
+        int tw = (sh - tx < ROTATE_TILE_SIZE) ? (sh - tx) : ROTATE_TILE_SIZE;
+
+        if (CA_ROTATE_90 == degrees) {
+          transpose(src + (sh - 1 - tx) * ss + ty * bpp, -ss,
+                    dst + ty * ds + tx * bpp, ds,
+                    th, tw);
+        }
+        else {
+          transpose(src + tx * ss + (sw - ty - th) * bpp, ss,
+                    dst + (ty + th - 1) * ds + tx * bpp, -ds,
+                    th, tw);
+        }
+      }
+    }
+  }
+
+  static void rotate_setup_padded(PixelBuffer& buf, std::vector<uint8_t>& mem, int w, int h, int fmt, int pad) {
+
+    size_t offset = 0;
+
+    buf.setup(w, h, fmt);
+
+    for (int i = 0; i < 3; ++i) {
+
+      if (0 == buf.stride[i]) {
+        continue;
+      }
+
+      size_t rows = (0 == buf.height[i]) ? buf.height[0] : buf.height[i];
+
+      buf.stride[i] += pad;
+      buf.offset[i] = offset;
+      offset += buf.stride[i] * rows;
+    }
+
+    buf.nbytes = offset;
+
+    /* Filled with a pattern so writes into the padding would show up. */
+    mem.assign(offset, 0xCD);
+    buf.setPixels(&mem[0]);
+  }
+
+  static void rotate_reference(const PixelBuffer& src, PixelBuffer& dst, int degrees) {
+
+    RotatePlanes planes;
+
+    /* Packed 4:2:2 is only rotated by 180 degrees; per pixel the luma moves and the chroma moves per pair. */
+    if (CA_YUYV422 == src.pixel_format || CA_UYVY422 == src.pixel_format) {
+
+      int yoff = (CA_YUYV422 == src.pixel_format) ? 0 : 1;
+      int coff = 1 - yoff;
+      int w = ((int)src.width[0] / 2) * 2;
+      int h = (int)src.height[0];
+
+      for (int y = 0; y < h; ++y) {
+        const uint8_t* s = src.plane[0] + (h - 1 - y) * src.stride[0];
+        uint8_t* d = dst.plane[0] + y * dst.stride[0];
+        for (int x = 0; x < w; ++x) {
+          d[2 * x + yoff] = s[2 * (w - 1 - x) + yoff];
+        }
+        for (int x = 0; x < w / 2; ++x) {
+          d[4 * x + coff] = s[4 * (w / 2 - 1 - x) + coff];
+          d[4 * x + coff + 2] = s[4 * (w / 2 - 1 - x) + coff + 2];
+        }
+      }
+      return;
+    }
+
+    rotate_get_planes(src.pixel_format, planes);
+
+    for (int i = 0; i < planes.num; ++i) {
+
+      int bpp = planes.bpp[i];
+      int sw = (int)((0 == src.width[i]) ? src.width[0] : src.width[i]);
+      int sh = (int)((0 == src.height[i]) ? src.height[0] : src.height[i]);
+      int dw = (int)((0 == dst.width[i]) ? dst.width[0] : dst.width[i]);
+      int dh = (int)((0 == dst.height[i]) ? dst.height[0] : dst.height[i]);
+
+      for (int y = 0; y < dh; ++y) {
+        for (int x = 0; x < dw; ++x) {
+
+          int sx = x;
+          int sy = y;
+
+          switch (degrees) {
+            case CA_ROTATE_90:  { sx = y;          sy = sh - 1 - x; break; }
+            case CA_ROTATE_180: { sx = sw - 1 - x; sy = sh - 1 - y; break; }
+            case CA_ROTATE_270: { sx = sw - 1 - y; sy = x;          break; }
+            default:            {                                   break; }
+          }
+
+          memcpy(dst.plane[i] + y * dst.stride[i] + x * bpp, src.plane[i] + sy * src.stride[i] + sx * bpp, bpp);
+        }
+      }
+    }
+  }
+
+} /* namespace ca */
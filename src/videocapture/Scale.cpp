@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <videocapture/Utils.h>
+#include <videocapture/Scale.h>
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  /*
+     Bilinear scale of the destination rows [y0, y1) of one plane. Positions
+     are 16.16 fixed point, weights are 8 bit. `bpp` is the number of
+     interleaved components per sample.
+  */
+  static void scale_plane_bilinear(const uint8_t* src, int sw, int sh, size_t sstride,
+                                   uint8_t* dst, int dw, int dh, size_t dstride,
+                                   int bpp, int y0, int y1)
+  {
+    int step_x = (int)(((int64_t)sw << 16) / dw);
+    int step_y = (int)(((int64_t)sh << 16) / dh);
+    int start_x = step_x / 2 - 32768;
+    int start_y = step_y / 2 - 32768;
+
+    for (int y = y0; y < y1 && y < dh; ++y) {
+
+      int fy = start_y + y * step_y;
+      if (fy < 0) {
+        fy = 0;
+      }
+
+      int sy = fy >> 16;
+      int wy = (fy >> 8) & 0xFF;
+
+      if (sy >= (sh - 1)) {
+        sy = sh - 1;
+        wy = 0;
+      }
+
+      const uint8_t* row0 = src + sy * sstride;
+      const uint8_t* row1 = (wy > 0) ? (row0 + sstride) : row0;
+      uint8_t* d = dst + y * dstride;
+      int fx = start_x;
+
+      for (int x = 0; x < dw; ++x, fx += step_x) {
+
+        int cx = (fx < 0) ? 0 : fx;
+        int sx = cx >> 16;
+        int wx = (cx >> 8) & 0xFF;
+
+        if (sx >= (sw - 1)) {
+          sx = sw - 1;
+          wx = 0;
+        }
+
+        int i0 = sx * bpp;
+        int i1 = (wx > 0) ? (i0 + bpp) : i0;
+
+        for (int c = 0; c < bpp; ++c) {
+          int top = row0[i0 + c] * (256 - wx) + row0[i1 + c] * wx;
+          int bot = row1[i0 + c] * (256 - wx) + row1[i1 + c] * wx;
+          d[c] = (uint8_t)((top * (256 - wy) + bot * wy + 32768) >> 16);
+        }
+
+        d += bpp;
+      }
+    }
+  }
+
+  /* Scales one plane for the given luma rows; `shift` is the vertical subsampling shift of the plane. */
+  static void scale_plane_rows(const PixelBuffer& src, PixelBuffer& dst, int plane, int bpp, int shift, int y0, int y1) {
+
+    int py0 = y0 >> shift;
+    int py1 = (y1 + (1 << shift) - 1) >> shift;
+
+    scale_plane_bilinear(src.plane[plane], (int)src.width[plane], (int)src.height[plane], src.stride[plane],
+                         dst.plane[plane], (int)dst.width[plane], (int)dst.height[plane], dst.stride[plane],
+                         bpp, py0, py1);
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  static void scale_yuv420p(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    scale_plane_rows(src, dst, 0, 1, 0, y0, y1);
+    scale_plane_rows(src, dst, 1, 1, 1, y0, y1);
+    scale_plane_rows(src, dst, 2, 1, 1, y0, y1);
+  }
+
+  static void scale_yuv422p(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    scale_plane_rows(src, dst, 0, 1, 0, y0, y1);
+    scale_plane_rows(src, dst, 1, 1, 0, y0, y1);
+    scale_plane_rows(src, dst, 2, 1, 0, y0, y1);
+  }
+
+  static void scale_yuv420bp(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    scale_plane_rows(src, dst, 0, 1, 0, y0, y1);
+    scale_plane_rows(src, dst, 1, 2, 1, y0, y1);
+  }
+
+  static void scale_rgb32(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    scale_plane_rows(src, dst, 0, 4, 0, y0, y1);
+  }
+
+  static void scale_rgb24(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    scale_plane_rows(src, dst, 0, 3, 0, y0, y1);
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  pixel_kernel scale_get_kernel(int fmt) {
+    switch (fmt) {
+      case CA_YUV420P:
+      case CA_YUVJ420P:   return scale_yuv420p;
+      case CA_YUV422P:    return scale_yuv422p;
+      case CA_YUV420BP:
+      case CA_YUVJ420BP:  return scale_yuv420bp;
+      case CA_ARGB32:
+      case CA_BGRA32:
+      case CA_RGBA32:     return scale_rgb32;
+      case CA_RGB24:      return scale_rgb24;
+      default:            return NULL;
+    }
+  }
+
+  int scale(const PixelBuffer& src, PixelBuffer& dst, SliceScheduler* scheduler) {
+
+    if (src.pixel_format != dst.pixel_format) {
+      printf("Error: cannot scale, the source and destination pixel formats differ. Convert first.\n");
+      return -1;
+    }
+
+    if (0 == src.width[0] || 0 == src.height[0] || 0 == dst.width[0] || 0 == dst.height[0]) {
+      printf("Error: cannot scale, the source or destination has no size.\n");
+      return -2;
+    }
+
+    if (NULL == src.plane[0] || NULL == dst.plane[0]) {
+      printf("Error: cannot scale, the source or destination has no pixels.\n");
+      return -3;
+    }
+
+    pixel_kernel kernel = scale_get_kernel(src.pixel_format);
+    if (NULL == kernel) {
+      printf("Error: cannot scale %s.\n", format_to_string(src.pixel_format).c_str());
+      return -4;
+    }
+
+    if (NULL == scheduler) {
+      kernel(src, dst, 0, (int)dst.height[0]);
+      return 0;
+    }
+
+    return scheduler->run(kernel, src, dst);
+  }
+
+} /* namespace ca */
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <videocapture/Utils.h>
+#include <videocapture/SliceScheduler.h>
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  struct SliceJob {                                                                 /* The state that is shared with the pool jobs for one `run()`. */
+    pixel_kernel kernel;
+    const PixelBuffer* src;
+    PixelBuffer* dst;
+    int rows;
+    int band;
+  };
+
+  /* ------------------------------------------------------------------------- */
+
+  SliceScheduler::SliceScheduler()
+    :min_pixels(320 * 240)
+    ,slices_per_thread(2)
+    ,is_init(false)
+  {
+  }
+
+  SliceScheduler::~SliceScheduler() {
+    if (true == is_init) {
+      shutdown();
+    }
+  }
+
+  int SliceScheduler::init(int nthreads, std::vector<int> cpus) {
+
+    if (true == is_init) {
+      printf("Error: the slice scheduler is already initialized.\n");
+      return -1;
+    }
+
+    if (0 != pool.init(nthreads, cpus)) {
+      return -2;
+    }
+
+    is_init = true;
+
+    return 0;
+  }
+
+  int SliceScheduler::shutdown() {
+
+    if (false == is_init) {
+      printf("Error: cannot shutdown the slice scheduler; not initialized.\n");
+      return -1;
+    }
+
+    is_init = false;
+
+    return pool.shutdown();
+  }
+
+  int SliceScheduler::run(pixel_kernel kernel, const PixelBuffer& src, PixelBuffer& dst) {
+
+    if (NULL == kernel) {
+      printf("Error: cannot run the slice scheduler, kernel is NULL.\n");
+      return -1;
+    }
+
+    int rows = (int)dst.height[0];
+    int nthreads = (true == is_init) ? pool.getNumThreads() : 1;
+
+    if (0 >= rows) {
+      printf("Error: cannot run the slice scheduler, the destination has no rows.\n");
+      return -2;
+    }
+
+    if (1 == nthreads || (dst.width[0] * dst.height[0]) < (size_t)min_pixels) {
+      kernel(src, dst, 0, rows);
+      return 0;
+    }
+
+    /* Bands must start at a chroma row boundary of both buffers. */
+    int align = format_vertical_subsampling(src.pixel_format);
+    int dst_align = format_vertical_subsampling(dst.pixel_format);
+    if (dst_align > align) {
+      align = dst_align;
+    }
+
+    int nslices = nthreads * ((slices_per_thread > 0) ? slices_per_thread : 1);
+    int band = (rows + nslices - 1) / nslices;
+    band = ((band + align - 1) / align) * align;
+    nslices = (rows + band - 1) / band;
+
+    SliceJob job;
+    job.kernel = kernel;
+    job.src = &src;
+    job.dst = &dst;
+    job.rows = rows;
+    job.band = band;
+
+    return pool.run(executeSlice, &job, nslices);
+  }
+
+  int SliceScheduler::getNumThreads() {
+    return (true == is_init) ? pool.getNumThreads() : 1;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  void SliceScheduler::executeSlice(void* user, int index) {
+
+    SliceJob* job = (SliceJob*)user;
+    int y0 = index * job->band;
+    int y1 = y0 + job->band;
+
+    if (y1 > job->rows) {
+      y1 = job->rows;
+    }
+
+    if (y0 < y1) {
+      job->kernel(*job->src, *job->dst, y0, y1);
+    }
+  }
+
+} /* namespace ca */
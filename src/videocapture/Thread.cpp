@@ -0,0 +1,223 @@
+#if defined(__linux)
+#  ifndef _GNU_SOURCE
+#    define _GNU_SOURCE
+#  endif
+#  include <sched.h>
+#endif
+
+#include <stdio.h>
+#include <videocapture/Thread.h>
+
+#if !defined(_WIN32)
+#  include <unistd.h>
+#endif
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+#if defined(_WIN32)
+  static DWORD WINAPI thread_main(LPVOID user);
+#else
+  static void* thread_main(void* user);
+#endif
+
+  /* ------------------------------------------------------------------------- */
+
+#if defined(_WIN32)
+
+  int mutex_create(Mutex& m) {
+    InitializeCriticalSection(&m.handle);
+    return 0;
+  }
+
+  int mutex_destroy(Mutex& m) {
+    DeleteCriticalSection(&m.handle);
+    return 0;
+  }
+
+  int mutex_lock(Mutex& m) {
+    EnterCriticalSection(&m.handle);
+    return 0;
+  }
+
+  int mutex_unlock(Mutex& m) {
+    LeaveCriticalSection(&m.handle);
+    return 0;
+  }
+
+  int cond_create(Cond& c) {
+    InitializeConditionVariable(&c.handle);
+    return 0;
+  }
+
+  int cond_destroy(Cond& c) {
+    return 0;
+  }
+
+  int cond_wait(Cond& c, Mutex& m) {
+    if (0 == SleepConditionVariableCS(&c.handle, &m.handle, INFINITE)) {
+      return -1;
+    }
+    return 0;
+  }
+
+  int cond_signal(Cond& c) {
+    WakeConditionVariable(&c.handle);
+    return 0;
+  }
+
+  int cond_broadcast(Cond& c) {
+    WakeAllConditionVariable(&c.handle);
+    return 0;
+  }
+
+  int thread_create(Thread& t, thread_function func, void* user) {
+
+    t.func = func;
+    t.user = user;
+    t.handle = CreateThread(NULL, 0, thread_main, &t, 0, NULL);
+
+    if (NULL == t.handle) {
+      printf("Error: failed to create a thread.\n");
+      return -1;
+    }
+
+    return 0;
+  }
+
+  int thread_join(Thread& t) {
+
+    if (WAIT_OBJECT_0 != WaitForSingleObject(t.handle, INFINITE)) {
+      printf("Error: failed to join a thread.\n");
+      return -1;
+    }
+
+    CloseHandle(t.handle);
+    t.handle = NULL;
+
+    return 0;
+  }
+
+  int thread_set_affinity(Thread& t, int cpu) {
+
+    if (0 > cpu || cpu >= (int)(sizeof(DWORD_PTR) * 8)) {
+      return -1;
+    }
+
+    if (0 == SetThreadAffinityMask(t.handle, ((DWORD_PTR)1) << cpu)) {
+      return -2;
+    }
+
+    return 0;
+  }
+
+  int cpu_count() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (info.dwNumberOfProcessors > 0) ? (int)info.dwNumberOfProcessors : 1;
+  }
+
+  static DWORD WINAPI thread_main(LPVOID user) {
+    Thread* t = (Thread*)user;
+    t->func(t->user);
+    return 0;
+  }
+
+#else
+
+  int mutex_create(Mutex& m) {
+    return (0 == pthread_mutex_init(&m.handle, NULL)) ? 0 : -1;
+  }
+
+  int mutex_destroy(Mutex& m) {
+    return (0 == pthread_mutex_destroy(&m.handle)) ? 0 : -1;
+  }
+
+  int mutex_lock(Mutex& m) {
+    return (0 == pthread_mutex_lock(&m.handle)) ? 0 : -1;
+  }
+
+  int mutex_unlock(Mutex& m) {
+    return (0 == pthread_mutex_unlock(&m.handle)) ? 0 : -1;
+  }
+
+  int cond_create(Cond& c) {
+    return (0 == pthread_cond_init(&c.handle, NULL)) ? 0 : -1;
+  }
+
+  int cond_destroy(Cond& c) {
+    return (0 == pthread_cond_destroy(&c.handle)) ? 0 : -1;
+  }
+
+  int cond_wait(Cond& c, Mutex& m) {
+    return (0 == pthread_cond_wait(&c.handle, &m.handle)) ? 0 : -1;
+  }
+
+  int cond_signal(Cond& c) {
+    return (0 == pthread_cond_signal(&c.handle)) ? 0 : -1;
+  }
+
+  int cond_broadcast(Cond& c) {
+    return (0 == pthread_cond_broadcast(&c.handle)) ? 0 : -1;
+  }
+
+  int thread_create(Thread& t, thread_function func, void* user) {
+
+    t.func = func;
+    t.user = user;
+
+    if (0 != pthread_create(&t.handle, NULL, thread_main, &t)) {
+      printf("Error: failed to create a thread.\n");
+      return -1;
+    }
+
+    return 0;
+  }
+
+  int thread_join(Thread& t) {
+
+    if (0 != pthread_join(t.handle, NULL)) {
+      printf("Error: failed to join a thread.\n");
+      return -1;
+    }
+
+    return 0;
+  }
+
+  int thread_set_affinity(Thread& t, int cpu) {
+
+#if defined(__linux)
+    if (0 > cpu || cpu >= CPU_SETSIZE) {
+      return -1;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    if (0 != pthread_setaffinity_np(t.handle, sizeof(set), &set)) {
+      return -2;
+    }
+
+    return 0;
+#else
+    /* Mac has no way to pin a thread to a core. */
+    return -1;
+#endif
+  }
+
+  int cpu_count() {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (int)n : 1;
+  }
+
+  static void* thread_main(void* user) {
+    Thread* t = (Thread*)user;
+    t->func(t->user);
+    return NULL;
+  }
+
+#endif
+
+} /* namespace ca */
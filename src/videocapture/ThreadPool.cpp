@@ -0,0 +1,202 @@
+#include <stdio.h>
+#include <videocapture/ThreadPool.h>
+#include <videocapture/Trace.h>
+
+namespace ca {
+
+  ThreadPool::ThreadPool()
+    :job(NULL)
+    ,job_user(NULL)
+    ,job_count(0)
+    ,job_next(0)
+    ,job_done(0)
+    ,generation(0)
+    ,is_init(false)
+    ,must_stop(false)
+  {
+  }
+
+  ThreadPool::~ThreadPool() {
+    if (true == is_init) {
+      shutdown();
+    }
+  }
+
+  int ThreadPool::init(int nthreads, std::vector<int> cpus) {
+
+    if (true == is_init) {
+      printf("Error: the thread pool is already initialized.\n");
+      return -1;
+    }
+
+    if (0 > nthreads) {
+      printf("Error: invalid number of threads: %d.\n", nthreads);
+      return -2;
+    }
+
+    if (0 == nthreads) {
+      nthreads = cpu_count();
+    }
+
+    mutex_create(mutex);
+    mutex_create(run_mutex);
+    cond_create(cond_work);
+    cond_create(cond_done);
+
+    job = NULL;
+    job_user = NULL;
+    job_count = 0;
+    job_next = 0;
+    job_done = 0;
+    generation = 0;
+    must_stop = false;
+    is_init = true;
+
+    for (int i = 0; i < (nthreads - 1); ++i) {
+
+      Thread* t = new Thread();
+      if (0 != thread_create(*t, workerMain, this)) {
+        delete t;
+        shutdown();
+        return -3;
+      }
+
+      threads.push_back(t);
+
+      if (0 != cpus.size()) {
+        int cpu = cpus[i % cpus.size()];
+        if (0 != thread_set_affinity(*t, cpu)) {
+          printf("Warning: cannot pin worker %d to cpu %d.\n", i, cpu);
+        }
+      }
+    }
+
+    return 0;
+  }
+
+  int ThreadPool::shutdown() {
+
+    if (false == is_init) {
+      printf("Error: cannot shutdown the thread pool; not initialized.\n");
+      return -1;
+    }
+
+    mutex_lock(mutex);
+    must_stop = true;
+    cond_broadcast(cond_work);
+    mutex_unlock(mutex);
+
+    for (size_t i = 0; i < threads.size(); ++i) {
+      thread_join(*threads[i]);
+      delete threads[i];
+    }
+
+    threads.clear();
+
+    cond_destroy(cond_work);
+    cond_destroy(cond_done);
+    mutex_destroy(mutex);
+    mutex_destroy(run_mutex);
+
+    is_init = false;
+
+    return 0;
+  }
+
+  int ThreadPool::run(pool_job fn, void* user, int njobs) {
+
+    if (NULL == fn) {
+      printf("Error: cannot run the thread pool, the job is NULL.\n");
+      return -1;
+    }
+
+    if (0 >= njobs) {
+      return 0;
+    }
+
+    /* Not initialized or nothing to share the work with: execute inline. */
+    if (false == is_init || 0 == threads.size()) {
+      for (int i = 0; i < njobs; ++i) {
+        fn(user, i);
+      }
+      return 0;
+    }
+
+    mutex_lock(run_mutex);
+    mutex_lock(mutex);
+    {
+      job = fn;
+      job_user = user;
+      job_count = njobs;
+      job_next = 0;
+      job_done = 0;
+      generation++;
+      cond_broadcast(cond_work);
+
+      executeJobs();
+
+      while (job_done < job_count) {
+        cond_wait(cond_done, mutex);
+      }
+
+      job = NULL;
+      job_user = NULL;
+    }
+    mutex_unlock(mutex);
+    mutex_unlock(run_mutex);
+
+    return 0;
+  }
+
+  int ThreadPool::getNumThreads() {
+    return (int)threads.size() + 1;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  void ThreadPool::executeJobs() {
+
+    while (job_next < job_count) {
+
+      int index = job_next++;
+      pool_job fn = job;
+      void* user = job_user;
+
+      mutex_unlock(mutex);
+      fn(user, index);
+      mutex_lock(mutex);
+
+      job_done++;
+      if (job_done == job_count) {
+        cond_signal(cond_done);
+      }
+    }
+  }
+
+  void ThreadPool::workerMain(void* user) {
+
+    ThreadPool* pool = (ThreadPool*)user;
+    uint64_t seen = 0;
+
+    CA_TRACE_THREAD_NAME("thread pool");
+
+    mutex_lock(pool->mutex);
+
+    while (true) {
+
+      while (false == pool->must_stop && seen == pool->generation) {
+        cond_wait(pool->cond_work, pool->mutex);
+      }
+
+      if (true == pool->must_stop) {
+        break;
+      }
+
+      seen = pool->generation;
+      pool->executeJobs();
+    }
+
+    mutex_unlock(pool->mutex);
+  }
+
+} /* namespace ca */
@@ -0,0 +1,479 @@
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <videocapture/Trace.h>
+
+#if defined(USE_TRACE)
+
+#include <videocapture/Thread.h>
+#include <videocapture/Utils.h>
+
+#if defined(_WIN32)
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#  define CA_TRACE_THREAD_LOCAL __declspec(thread)
+#else
+#  include <pthread.h>
+#  include <unistd.h>
+#  if defined(__linux)
+#    include <sys/syscall.h>
+#  endif
+#  define CA_TRACE_THREAD_LOCAL __thread
+#endif
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  struct TraceEvent {
+    uint64_t time;                                                                  /* When the event started, see `time_now_ns()`. */
+    uint64_t duration;                                                              /* In nanoseconds; 0 for CA_TRACE_INSTANT. */
+    const char* name;                                                               /* Not owned; a string literal. */
+    int64_t arg;                                                                    /* The argument of the trace point. */
+    int type;                                                                       /* CA_TRACE_COMPLETE or CA_TRACE_INSTANT. */
+  };
+
+  struct TraceThread {                                                              /* The ring buffer of a thread. */
+    TraceEvent events[CA_TRACE_MAX_EVENTS];
+    volatile uint64_t num_events;                                                   /* The number of events this thread recorded; the next one goes into `events[num_events % CA_TRACE_MAX_EVENTS]`. Only written by the thread. */
+    uint64_t first_event;                                                           /* Events before this one were cleared; set by `trace_clear()`. */
+    uint64_t thread_id;                                                             /* The id of the OS. */
+    char name[CA_TRACE_MAX_NAME];                                                   /* Empty when the thread wasn't named. */
+    int is_retired;                                                                 /* 1 when the thread exited; the buffer is freed by the next `trace_save()` or `trace_clear()`. */
+    TraceThread* next;
+  };
+
+  struct TraceRegistry {                                                            /* All ring buffers. */
+    TraceRegistry();
+    Mutex mutex;                                                                    /* Protects `threads`, `free_threads` and the thread names. */
+    TraceThread* threads;                                                           /* The ring buffers, newest first. */
+    TraceThread* free_threads;                                                      /* The ring buffers of retired threads that were saved or cleared; reused by new threads. */
+    int num_threads;                                                                /* The number of ring buffers we allocated; at most CA_TRACE_MAX_THREADS. */
+    volatile uint64_t num_freed;                                                    /* Incremented when buffers are freed, so a thread that didn't get one tries again. */
+    volatile int is_recording;                                                      /* 1 between `trace_start()` and `trace_stop()`. */
+#if defined(_WIN32)
+    DWORD exit_key;                                                                 /* Calls `trace_thread_exit()` when a thread with a ring buffer exits. */
+#else
+    pthread_key_t exit_key;
+#endif
+  };
+
+  /* ------------------------------------------------------------------------- */
+
+  static TraceRegistry trace_registry;
+  static CA_TRACE_THREAD_LOCAL TraceThread* trace_thread = NULL;
+  static CA_TRACE_THREAD_LOCAL char trace_thread_name[CA_TRACE_MAX_NAME] = { 0 };
+  static CA_TRACE_THREAD_LOCAL uint64_t trace_thread_denied = 0;                    /* `num_freed` + 1 when we didn't get a ring buffer; 0 otherwise. */
+
+  static TraceThread* trace_get_thread();
+  static void trace_free_retired();
+#if defined(_WIN32)
+  static void WINAPI trace_thread_exit(void* user);
+#else
+  static void trace_thread_exit(void* user);
+#endif
+  static uint64_t trace_get_thread_id();
+  static uint64_t trace_get_process_id();
+  static void trace_add(int type, const char* name, uint64_t time, uint64_t duration, int64_t arg);
+  static void trace_write_string(FILE* fp, const char* str);
+
+  /* Orders the stores of an event before the store of `num_events`, and the loads of a reader the other way around. On x86 this only stops the compiler. */
+  static inline void trace_fence() {
+#if defined(_MSC_VER)
+    MemoryBarrier();
+#elif defined(__ATOMIC_SEQ_CST)
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#else
+    __sync_synchronize();
+#endif
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  TraceRegistry::TraceRegistry()
+    :threads(NULL)
+    ,free_threads(NULL)
+    ,num_threads(0)
+    ,num_freed(0)
+    ,is_recording(0)
+  {
+    mutex_create(mutex);
+#if defined(_WIN32)
+    exit_key = FlsAlloc(trace_thread_exit);
+#else
+    pthread_key_create(&exit_key, trace_thread_exit);
+#endif
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  bool trace_is_available() {
+    return true;
+  }
+
+  int trace_start() {
+    trace_registry.is_recording = 1;
+    return 0;
+  }
+
+  int trace_stop() {
+    trace_registry.is_recording = 0;
+    return 0;
+  }
+
+  void trace_clear() {
+
+    mutex_lock(trace_registry.mutex);
+    {
+      for (TraceThread* t = trace_registry.threads; NULL != t; t = t->next) {
+        t->first_event = t->num_events;
+      }
+      trace_free_retired();
+    }
+    mutex_unlock(trace_registry.mutex);
+  }
+
+  int trace_save(const std::string& filepath) {
+
+    std::vector<TraceEvent> events;
+    uint64_t pid = trace_get_process_id();
+    uint64_t begin = 0;
+    uint64_t end = 0;
+    bool is_first = true;
+    int r = 0;
+
+    FILE* fp = fopen(filepath.c_str(), "wb");
+    if (NULL == fp) {
+      printf("Error: cannot open the trace file %s.\n", filepath.c_str());
+      return -1;
+    }
+
+    fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+    mutex_lock(trace_registry.mutex);
+
+    for (TraceThread* t = trace_registry.threads; NULL != t; t = t->next) {
+
+      if ('\0' != t->name[0]) {
+        fprintf(fp, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%llu,\"tid\":%llu,\"args\":{\"name\":", (true == is_first) ? "" : ",\n", (unsigned long long)pid, (unsigned long long)t->thread_id);
+        trace_write_string(fp, t->name);
+        fprintf(fp, "}}");
+        is_first = false;
+      }
+
+      /* Copy first; the thread may overwrite the oldest events while we do. */
+      end = t->num_events;
+      trace_fence();
+
+      begin = (end > CA_TRACE_MAX_EVENTS) ? end - CA_TRACE_MAX_EVENTS : 0;
+      begin = (begin < t->first_event) ? t->first_event : begin;
+
+      events.clear();
+      for (uint64_t i = begin; i < end; ++i) {
+        events.push_back(t->events[i % CA_TRACE_MAX_EVENTS]);
+      }
+
+      trace_fence();
+
+      /* Skip what was overwritten while we copied, including the event that is being written. */
+      uint64_t now = t->num_events;
+      uint64_t skip = 0;
+      if (now + 1 > begin + CA_TRACE_MAX_EVENTS) {
+        skip = now + 1 - (begin + CA_TRACE_MAX_EVENTS);
+      }
+
+      for (size_t i = (size_t)skip; i < events.size(); ++i) {
+
+        const TraceEvent& e = events[i];
+
+        fprintf(fp, "%s{\"ph\":\"%s\",\"name\":", (true == is_first) ? "" : ",\n", (CA_TRACE_INSTANT == e.type) ? "i" : "X");
+        trace_write_string(fp, e.name);
+        fprintf(fp, ",\"pid\":%llu,\"tid\":%llu,\"ts\":%llu.%03u",
+                (unsigned long long)pid,
+                (unsigned long long)t->thread_id,
+                (unsigned long long)(e.time / 1000),
+                (unsigned int)(e.time % 1000));
+
+        if (CA_TRACE_INSTANT == e.type) {
+          fprintf(fp, ",\"s\":\"t\"");
+        }
+        else {
+          fprintf(fp, ",\"dur\":%llu.%03u", (unsigned long long)(e.duration / 1000), (unsigned int)(e.duration % 1000));
+        }
+
+        fprintf(fp, ",\"args\":{\"arg\":%lld}}", (long long)e.arg);
+        is_first = false;
+      }
+    }
+
+    /* The events of the threads that exited are saved; their buffers can be reused. */
+    trace_free_retired();
+
+    mutex_unlock(trace_registry.mutex);
+
+    fprintf(fp, "\n]}\n");
+
+    if (0 != ferror(fp)) {
+      printf("Error: failed to write the trace file %s.\n", filepath.c_str());
+      r = -2;
+    }
+
+    if (0 != fclose(fp)) {
+      printf("Error: failed to close the trace file %s.\n", filepath.c_str());
+      r = -3;
+    }
+
+    return r;
+  }
+
+  void trace_set_thread_name(const char* name) {
+
+    if (NULL == name) {
+      return;
+    }
+
+    strncpy(trace_thread_name, name, CA_TRACE_MAX_NAME - 1);
+    trace_thread_name[CA_TRACE_MAX_NAME - 1] = '\0';
+
+    if (NULL == trace_thread) {
+      return;
+    }
+
+    mutex_lock(trace_registry.mutex);
+    memcpy(trace_thread->name, trace_thread_name, CA_TRACE_MAX_NAME);
+    mutex_unlock(trace_registry.mutex);
+  }
+
+  uint64_t trace_begin() {
+    return (0 == trace_registry.is_recording) ? 0 : time_now_ns();
+  }
+
+  void trace_end(uint64_t start, const char* name, int64_t arg) {
+
+    if (0 == start) {
+      return;
+    }
+
+    uint64_t now = time_now_ns();
+    trace_add(CA_TRACE_COMPLETE, name, start, (now > start) ? now - start : 0, arg);
+  }
+
+  void trace_instant(const char* name, int64_t arg) {
+
+    if (0 == trace_registry.is_recording) {
+      return;
+    }
+
+    trace_add(CA_TRACE_INSTANT, name, time_now_ns(), 0, arg);
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  static void trace_add(int type, const char* name, uint64_t time, uint64_t duration, int64_t arg) {
+
+    TraceThread* t = trace_get_thread();
+    if (NULL == t) {
+      return;
+    }
+
+    uint64_t n = t->num_events;
+    TraceEvent& e = t->events[n % CA_TRACE_MAX_EVENTS];
+
+    e.time = time;
+    e.duration = duration;
+    e.name = name;
+    e.arg = arg;
+    e.type = type;
+
+    trace_fence();
+    t->num_events = n + 1;
+  }
+
+  static TraceThread* trace_get_thread() {
+
+    TraceThread* t = NULL;
+
+    if (NULL != trace_thread) {
+      return trace_thread;
+    }
+
+    /* We hit CA_TRACE_MAX_THREADS before; don't take the lock for every event until buffers were freed. */
+    if (0 != trace_thread_denied && trace_thread_denied == trace_registry.num_freed + 1) {
+      return NULL;
+    }
+
+    mutex_lock(trace_registry.mutex);
+    {
+      if (NULL != trace_registry.free_threads) {
+        t = trace_registry.free_threads;
+        trace_registry.free_threads = t->next;
+      }
+      else if (trace_registry.num_threads < CA_TRACE_MAX_THREADS) {
+        t = new TraceThread();
+        trace_registry.num_threads++;
+      }
+
+      if (NULL != t) {
+        t->num_events = 0;
+        t->first_event = 0;
+        t->thread_id = trace_get_thread_id();
+        t->is_retired = 0;
+        memcpy(t->name, trace_thread_name, CA_TRACE_MAX_NAME);
+        t->next = trace_registry.threads;
+        trace_registry.threads = t;
+      }
+      else {
+        trace_thread_denied = trace_registry.num_freed + 1;
+      }
+    }
+    mutex_unlock(trace_registry.mutex);
+
+    if (NULL == t) {
+      return NULL;
+    }
+
+#if defined(_WIN32)
+    FlsSetValue(trace_registry.exit_key, t);
+#else
+    pthread_setspecific(trace_registry.exit_key, t);
+#endif
+
+    trace_thread_denied = 0;
+    trace_thread = t;
+
+    return t;
+  }
+
+  /* Moves the buffers of retired threads to the free list; the registry must be locked. */
+  static void trace_free_retired() {
+
+    TraceThread** link = &trace_registry.threads;
+    bool freed = false;
+
+    while (NULL != *link) {
+
+      TraceThread* t = *link;
+      if (0 == t->is_retired) {
+        link = &t->next;
+        continue;
+      }
+
+      *link = t->next;
+      t->next = trace_registry.free_threads;
+      trace_registry.free_threads = t;
+      freed = true;
+    }
+
+    if (true == freed) {
+      trace_registry.num_freed++;
+    }
+  }
+
+  /* Called when a thread that recorded events exits; its events stay until the next save or clear. */
+#if defined(_WIN32)
+  static void WINAPI trace_thread_exit(void* user) {
+#else
+  static void trace_thread_exit(void* user) {
+#endif
+
+    TraceThread* t = (TraceThread*)user;
+    if (NULL == t) {
+      return;
+    }
+
+    mutex_lock(trace_registry.mutex);
+    t->is_retired = 1;
+    mutex_unlock(trace_registry.mutex);
+  }
+
+  static uint64_t trace_get_thread_id() {
+#if defined(_WIN32)
+    return (uint64_t)GetCurrentThreadId();
+#elif defined(__linux)
+    return (uint64_t)syscall(SYS_gettid);
+#elif defined(__APPLE__)
+    uint64_t id = 0;
+    pthread_threadid_np(NULL, &id);
+    return id;
+#else
+    return (uint64_t)(uintptr_t)pthread_self();
+#endif
+  }
+
+  static uint64_t trace_get_process_id() {
+#if defined(_WIN32)
+    return (uint64_t)GetCurrentProcessId();
+#else
+    return (uint64_t)getpid();
+#endif
+  }
+
+  static void trace_write_string(FILE* fp, const char* str) {
+
+    fputc('"', fp);
+
+    for (const char* c = str; NULL != c && '\0' != *c; ++c) {
+      if ('"' == *c || '\\' == *c) {
+        fputc('\\', fp);
+        fputc(*c, fp);
+      }
+      else if ((unsigned char)*c < 0x20) {
+        fprintf(fp, "\\u%04x", (unsigned int)(unsigned char)*c);
+      }
+      else {
+        fputc(*c, fp);
+      }
+    }
+
+    fputc('"', fp);
+  }
+
+} /* namespace ca */
+
+#else
+
+namespace ca {
+
+  bool trace_is_available() {
+    return false;
+  }
+
+  int trace_start() {
+    printf("Error: cannot start tracing, the library was built without USE_TRACE.\n");
+    return -1;
+  }
+
+  int trace_stop() {
+    return 0;
+  }
+
+  void trace_clear() {
+  }
+
+  int trace_save(const std::string& filepath) {
+    printf("Error: cannot save the trace to %s, the library was built without USE_TRACE.\n", filepath.c_str());
+    return -1;
+  }
+
+  void trace_set_thread_name(const char* name) {
+    (void)name;
+  }
+
+  uint64_t trace_begin() {
+    return 0;
+  }
+
+  void trace_end(uint64_t start, const char* name, int64_t arg) {
+    (void)start;
+    (void)name;
+    (void)arg;
+  }
+
+  void trace_instant(const char* name, int64_t arg) {
+    (void)name;
+    (void)arg;
+  }
+
+} /* namespace ca */
+
+#endif
@@ -23,6 +23,10 @@ namespace ca {
     offset[1] = 0;
     offset[2] = 0;
     pixel_format = CA_NONE;
+    sequence = 0;
+    timestamp = 0;
+    decode_time = 0;
+    receive_time = 0;
     user = NULL;
   }
    
@@ -34,12 +38,21 @@ namespace ca {
     }
 
     pixel_format = fmt;
+
+    for (int i = 0; i < 3; ++i) {
+      stride[i] = 0;
+      width[i] = 0;
+      height[i] = 0;
+      offset[i] = 0;
+    }
+
     width[0] = w;
     height[0] = h;
 
     switch (fmt) {
 
-      case CA_YUV420P: {
+      case CA_YUV420P:
+      case CA_YUVJ420P: {
         stride[0] = w;
         stride[1] = w / 2;
         stride[2] = w / 2;
@@ -56,17 +69,63 @@ namespace ca {
         offset[1] = (size_t)(w * h);
         offset[2] = (size_t)(offset[1] + (w / 2) * (h / 2));
 
+        nbytes = offset[2] + (w / 2) * (h / 2);
         break;
       }
-        /*
-      case CA_YUYV422: 
-      case CA_UYVY422: {
+
+      case CA_YUV422P: {
         stride[0] = w;
         stride[1] = w / 2;
         stride[2] = w / 2;
+
+        width[1] = w / 2;
+        width[2] = w / 2;
+
+        height[1] = h;
+        height[2] = h;
+
+        offset[1] = (size_t)(w * h);
+        offset[2] = (size_t)(offset[1] + (w / 2) * h);
+
+        nbytes = offset[2] + (w / 2) * h;
+        break;
+      }
+
+      /* Bi-planar: the second plane has interleaved Cb/Cr samples; its width is the number of Cb/Cr pairs. */
+      case CA_YUV420BP:
+      case CA_YUVJ420BP: {
+        stride[0] = w;
+        stride[1] = (w / 2) * 2;
+
+        width[1] = w / 2;
+        height[1] = h / 2;
+
+        offset[1] = (size_t)(w * h);
+
+        nbytes = offset[1] + stride[1] * height[1];
+        break;
+      }
+
+      case CA_YUYV422: 
+      case CA_UYVY422: {
+        stride[0] = w * 2;
+        nbytes = stride[0] * h;
+        break;
+      }
+
+      case CA_ARGB32:
+      case CA_BGRA32:
+      case CA_RGBA32: {
+        stride[0] = w * 4;
+        nbytes = stride[0] * h;
+        break;
+      }
+
+      case CA_RGB24: {
+        stride[0] = w * 3;
+        nbytes = stride[0] * h;
         break;
       }
-        */
 
       default: {
         printf("error: cannot setup the PixelBuffer for the given fmt: %d\n", fmt);
@@ -77,6 +136,27 @@ namespace ca {
     return 0;
   }
 
+  int PixelBuffer::setPixels(uint8_t* data) {
+
+    if (NULL == data) {
+      printf("error: cannot set the pixels of the PixelBuffer, data is NULL.\n");
+      return -1;
+    }
+
+    if (0 == nbytes) {
+      printf("error: cannot set the pixels of the PixelBuffer, call setup() first.\n");
+      return -2;
+    }
+
+    pixels = data;
+
+    for (int i = 0; i < 3; ++i) {
+      plane[i] = (0 == stride[i]) ? NULL : (data + offset[i]);
+    }
+
+    return 0;
+  }
+
   /* CAPABILITY */
   /* -------------------------------------- */
   Capability::Capability() {
@@ -171,6 +251,13 @@ namespace ca {
     capability = CA_NONE;
     device = CA_NONE;
     format = CA_NONE;
+    rotation = CA_ROTATE_NONE;
+    jpeg_scale = 1;
+    decode_threads = 0;
+    decode_thread_type = CA_DECODE_THREAD_FRAME | CA_DECODE_THREAD_SLICE;
+    drop_policy = CA_DROP_NEWEST;
+    replay_speed = 100;
+    replay_loop = 0;
   }
 
   /* Frame */
@@ -1,5 +1,14 @@
 #include <videocapture/Utils.h>
 
+#if defined(_WIN32)
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#elif defined(__APPLE__)
+#  include <mach/mach_time.h>
+#else
+#  include <time.h>
+#endif
+
 namespace ca {
 
   int fps_from_rational(uint64_t num, uint64_t den) {
@@ -46,13 +55,60 @@ namespace ca {
       case CA_YUVJ420BP:        return "CA_YUVJ420BP";
       case CA_ARGB32:           return "CA_ARGB32";
       case CA_BGRA32:           return "CA_BGRA32";
+      case CA_RGBA32:           return "CA_RGBA32";
       case CA_RGB24:            return "CA_RGB24";
       case CA_JPEG_OPENDML:     return "CA_JPEG_OPENDML";
       case CA_H264:             return "CA_H264";
       case CA_MJPEG:            return "CA_MJPEG";
+      case CA_H265:             return "CA_H265";
       case CA_NONE:             return "CA_NONE";
       default:                  return "UNKNOWN_FORMAT";
     }
   }
 
+  int format_vertical_subsampling(int fmt) {
+    switch(fmt) {
+      case CA_YUV420P:          return 2;
+      case CA_YUV420BP:         return 2;
+      case CA_YUVJ420P:         return 2;
+      case CA_YUVJ420BP:        return 2;
+      default:                  return 1;
+    }
+  }
+
+  uint64_t time_now_ns() {
+
+#if defined(_WIN32)
+
+    static LARGE_INTEGER freq = { 0 };
+    LARGE_INTEGER now;
+
+    if (0 == freq.QuadPart) {
+      QueryPerformanceFrequency(&freq);
+    }
+
+    QueryPerformanceCounter(&now);
+
+    return (uint64_t)((double)now.QuadPart * (1e9 / (double)freq.QuadPart));
+
+#elif defined(__APPLE__)
+
+    static mach_timebase_info_data_t info = { 0, 0 };
+
+    if (0 == info.denom) {
+      mach_timebase_info(&info);
+    }
+
+    return (mach_absolute_time() * info.numer) / info.denom;
+
+#else
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+
+#endif
+  }
+
 } // namespace ca
@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <videocapture/Thread.h>
+#include <videocapture/VideoEncoder.h>
+
+namespace ca {
+
+  EncoderSettings::EncoderSettings()
+    :codec(CA_H264)
+    ,preset("veryfast")
+    ,bitrate(0)
+    ,crf(23)
+    ,keyint(0)
+    ,threads(0)
+    ,num_cameras(1)
+  {
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  VideoEncoder::VideoEncoder() {
+  }
+
+  VideoEncoder::~VideoEncoder() {
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  bool encoder_is_available(int codec) {
+
+#if defined(USE_X264)
+    if (CA_H264 == codec) {
+      return true;
+    }
+#endif
+
+#if defined(USE_X265)
+    if (CA_H265 == codec) {
+      return true;
+    }
+#endif
+
+    (void)codec;
+
+    return false;
+  }
+
+  int encoder_get_thread_budget(int numcameras) {
+
+    int n = cpu_count() / ((0 < numcameras) ? numcameras : 1);
+
+    return (0 < n) ? n : 1;
+  }
+
+  int encoder_get_keyint(const EncoderSettings& cfg, int fps) {
+
+    int n = 0;
+
+    if (0 < cfg.keyint) {
+      return cfg.keyint;
+    }
+
+    n = (2 * ((0 < fps) ? fps : CA_FPS_30_00)) / 100;
+
+    return (0 < n) ? n : 1;
+  }
+
+  int encoder_add_chunk(EncodedFrame& out, const uint8_t* data, size_t nbytes) {
+
+    DataChunk* last = NULL;
+
+    if (0 < out.num_chunks) {
+      last = &out.chunks[out.num_chunks - 1];
+      if (last->data + last->nbytes == data) {
+        last->nbytes += nbytes;
+        return 0;
+      }
+    }
+
+    if (CA_ENCODER_MAX_CHUNKS == out.num_chunks) {
+      printf("Error: the encoded frame has too many NAL units.\n");
+      return -1;
+    }
+
+    out.chunks[out.num_chunks].data = data;
+    out.chunks[out.num_chunks].nbytes = nbytes;
+    out.num_chunks++;
+
+    return 0;
+  }
+
+} /* namespace ca */
@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <videocapture/Utils.h>
+#include <videocapture/H264Parser.h>
+#include <videocapture/X264Encoder.h>
+
+#if defined(USE_X264)
+#  include <stdint.h>
+extern "C" {
+#  include <x264.h>
+}
+#endif
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+#if defined(USE_X264)
+
+  struct X264EncoderState {
+    x264_t* encoder;
+    x264_param_t param;                                                             /* The settings, as passed into x264_encoder_open(). */
+  };
+
+#endif
+
+  /* ------------------------------------------------------------------------- */
+
+  X264Encoder::X264Encoder()
+    :state(NULL)
+    ,width(0)
+    ,height(0)
+    ,pixel_format(CA_NONE)
+    ,num_threads(0)
+  {
+  }
+
+  X264Encoder::~X264Encoder() {
+    close();
+  }
+
+  int X264Encoder::open(int w, int h, int fps, int fmt, const EncoderSettings& cfg) {
+
+    if (NULL != state) {
+      printf("Error: cannot open the x264 encoder, already open.\n");
+      return -1;
+    }
+
+    if (false == encoder_is_available(CA_H264)) {
+      printf("Error: cannot encode H.264, the library is compiled without USE_X264.\n");
+      return -2;
+    }
+
+    if (false == canEncode(fmt)) {
+      printf("Error: the x264 encoder cannot encode %s.\n", format_to_string(fmt).c_str());
+      return -3;
+    }
+
+    if (0 >= w || 0 >= h || 0 != (w & 1) || 0 != (h & 1)) {
+      printf("Error: invalid frame size for the x264 encoder: %d x %d; must be even.\n", w, h);
+      return -4;
+    }
+
+#if defined(USE_X264)
+
+    state = new X264EncoderState();
+    state->encoder = NULL;
+
+    x264_param_t& p = state->param;
+
+    if (0 > x264_param_default_preset(&p, cfg.preset.c_str(), (0 == cfg.tune.size()) ? NULL : cfg.tune.c_str())) {
+      printf("Error: invalid x264 preset or tune: %s, %s.\n", cfg.preset.c_str(), cfg.tune.c_str());
+      close();
+      return -5;
+    }
+
+    num_threads = (0 < cfg.threads) ? cfg.threads : encoder_get_thread_budget(cfg.num_cameras);
+
+    p.i_threads = num_threads;
+    p.i_width = w;
+    p.i_height = h;
+    p.i_csp = (CA_YUV420BP == fmt || CA_YUVJ420BP == fmt) ? X264_CSP_NV12 : X264_CSP_I420;
+    p.i_fps_num = (0 < fps) ? fps : CA_FPS_30_00;
+    p.i_fps_den = 100;
+    p.i_keyint_max = encoder_get_keyint(cfg, fps);
+    p.i_bframe = 0;                                                                 /* The writers store frames in decode order. */
+    p.b_annexb = 0;                                                                 /* 4 byte NAL lengths, as the containers want. */
+    p.b_repeat_headers = 0;                                                         /* The SPS and PPS are in the avcC. */
+    p.i_log_level = X264_LOG_WARNING;
+    p.vui.b_fullrange = (CA_YUVJ420P == fmt || CA_YUVJ420BP == fmt) ? 1 : 0;
+
+    if (0 < cfg.bitrate) {
+      p.rc.i_rc_method = X264_RC_ABR;
+      p.rc.i_bitrate = cfg.bitrate;
+      p.rc.i_vbv_max_bitrate = cfg.bitrate;
+      p.rc.i_vbv_buffer_size = cfg.bitrate;
+    }
+    else {
+      p.rc.i_rc_method = X264_RC_CRF;
+      p.rc.f_rf_constant = (float)cfg.crf;
+    }
+
+    state->encoder = x264_encoder_open(&p);
+    if (NULL == state->encoder) {
+      printf("Error: cannot open the x264 encoder.\n");
+      close();
+      return -6;
+    }
+
+    width = w;
+    height = h;
+    pixel_format = fmt;
+
+    if (0 != createCodecPrivate()) {
+      close();
+      return -7;
+    }
+
+#else
+    (void)fps;
+    (void)cfg;
+#endif
+
+    return 0;
+  }
+
+  int X264Encoder::close() {
+
+#if defined(USE_X264)
+
+    if (NULL == state) {
+      return 0;
+    }
+
+    if (NULL != state->encoder) {
+      x264_encoder_close(state->encoder);
+      state->encoder = NULL;
+    }
+
+    delete state;
+    state = NULL;
+
+#endif
+
+    width = 0;
+    height = 0;
+    pixel_format = CA_NONE;
+    num_threads = 0;
+    codec_private.clear();
+
+    return 0;
+  }
+
+  int X264Encoder::encode(const PixelBuffer* pic, uint64_t timestamp, EncodedFrame& out) {
+
+    out.num_chunks = 0;
+    out.timestamp = 0;
+    out.keyframe = false;
+
+    if (NULL == state) {
+      printf("Error: cannot encode, the x264 encoder is not open.\n");
+      return -1;
+    }
+
+#if defined(USE_X264)
+
+    x264_picture_t in;
+    x264_picture_t encoded;
+    x264_nal_t* nals = NULL;
+    int num_nals = 0;
+    int r = 0;
+
+    if (NULL != pic) {
+
+      if (pic->pixel_format != pixel_format || (int)pic->width[0] != width || (int)pic->height[0] != height) {
+        printf("Error: the x264 encoder expects %d x %d %s pictures.\n", width, height, format_to_string(pixel_format).c_str());
+        return -2;
+      }
+
+      /* x264 copies the picture into its own frame; we only pass the planes. */
+      x264_picture_init(&in);
+      in.img.i_csp = state->param.i_csp;
+      in.img.i_plane = (X264_CSP_NV12 == state->param.i_csp) ? 2 : 3;
+      in.i_pts = (int64_t)timestamp;
+
+      for (int i = 0; i < in.img.i_plane; ++i) {
+        in.img.plane[i] = pic->plane[i];
+        in.img.i_stride[i] = (int)pic->stride[i];
+      }
+    }
+
+    r = x264_encoder_encode(state->encoder, &nals, &num_nals, (NULL == pic) ? NULL : &in, &encoded);
+    if (0 > r) {
+      printf("Error: x264 failed to encode a frame.\n");
+      return -3;
+    }
+
+    if (0 == r || 0 == num_nals) {
+      return 0;
+    }
+
+    for (int i = 0; i < num_nals; ++i) {
+      if (0 != encoder_add_chunk(out, nals[i].p_payload, (size_t)nals[i].i_payload)) {
+        return -4;
+      }
+    }
+
+    out.timestamp = (uint64_t)encoded.i_pts;
+    out.keyframe = (0 != encoded.b_keyframe);
+
+    return 1;
+
+#else
+    (void)pic;
+    (void)timestamp;
+    return -1;
+#endif
+  }
+
+  bool X264Encoder::canEncode(int fmt) {
+    return CA_YUV420P == fmt || CA_YUVJ420P == fmt || CA_YUV420BP == fmt || CA_YUVJ420BP == fmt;
+  }
+
+  int X264Encoder::getNumThreads() {
+    return num_threads;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  int X264Encoder::createCodecPrivate() {
+
+#if defined(USE_X264)
+
+    x264_nal_t* nals = NULL;
+    x264_nal_t* sps = NULL;
+    x264_nal_t* pps = NULL;
+    int num_nals = 0;
+    size_t nbytes = 0;
+
+    if (0 > x264_encoder_headers(state->encoder, &nals, &num_nals)) {
+      printf("Error: cannot get the headers of the x264 encoder.\n");
+      return -1;
+    }
+
+    for (int i = 0; i < num_nals; ++i) {
+      if (NAL_SPS == nals[i].i_type) {
+        sps = &nals[i];
+      }
+      else if (NAL_PPS == nals[i].i_type) {
+        pps = &nals[i];
+      }
+    }
+
+    if (NULL == sps || NULL == pps) {
+      printf("Error: the x264 encoder didn't give us a SPS and PPS.\n");
+      return -2;
+    }
+
+    /* The payloads start with the 4 byte length. */
+    codec_private.resize(sps->i_payload + pps->i_payload + 32);
+    nbytes = h264_get_avcc(sps->p_payload + 4, sps->i_payload - 4, pps->p_payload + 4, pps->i_payload - 4, &codec_private[0], codec_private.size());
+
+    if (0 == nbytes) {
+      printf("Error: cannot create the avcC of the x264 encoder.\n");
+      return -3;
+    }
+
+    codec_private.resize(nbytes);
+
+#endif
+
+    return 0;
+  }
+
+} /* namespace ca */
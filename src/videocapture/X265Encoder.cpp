@@ -0,0 +1,316 @@
+#include <stdio.h>
+#include <videocapture/Utils.h>
+#include <videocapture/H264Parser.h>
+#include <videocapture/X265Encoder.h>
+
+#if defined(USE_X265)
+#  include <stdint.h>
+extern "C" {
+#  include <x265.h>
+}
+#endif
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+#if defined(USE_X265)
+
+  struct X265EncoderState {
+    x265_param* param;                                                              /* The settings, as passed into x265_encoder_open(). */
+    x265_encoder* encoder;
+    x265_picture* input;                                                            /* Reused for every picture; only points to the planes. */
+    x265_picture* output;                                                           /* Describes the frame that came out. */
+  };
+
+#endif
+
+  /* ------------------------------------------------------------------------- */
+
+  X265Encoder::X265Encoder()
+    :state(NULL)
+    ,width(0)
+    ,height(0)
+    ,pixel_format(CA_NONE)
+    ,num_threads(0)
+  {
+  }
+
+  X265Encoder::~X265Encoder() {
+    close();
+  }
+
+  int X265Encoder::open(int w, int h, int fps, int fmt, const EncoderSettings& cfg) {
+
+    if (NULL != state) {
+      printf("Error: cannot open the x265 encoder, already open.\n");
+      return -1;
+    }
+
+    if (false == encoder_is_available(CA_H265)) {
+      printf("Error: cannot encode H.265, the library is compiled without USE_X265.\n");
+      return -2;
+    }
+
+    if (false == canEncode(fmt)) {
+      printf("Error: the x265 encoder cannot encode %s.\n", format_to_string(fmt).c_str());
+      return -3;
+    }
+
+    if (0 >= w || 0 >= h || 0 != (w & 1) || 0 != (h & 1)) {
+      printf("Error: invalid frame size for the x265 encoder: %d x %d; must be even.\n", w, h);
+      return -4;
+    }
+
+#if defined(USE_X265)
+
+    char pools[16];
+
+    state = new X265EncoderState();
+    state->encoder = NULL;
+    state->input = NULL;
+    state->output = NULL;
+    state->param = x265_param_alloc();
+
+    if (NULL == state->param) {
+      printf("Error: cannot allocate the x265 parameters.\n");
+      close();
+      return -5;
+    }
+
+    x265_param* p = state->param;
+
+    if (0 > x265_param_default_preset(p, cfg.preset.c_str(), (0 == cfg.tune.size()) ? NULL : cfg.tune.c_str())) {
+      printf("Error: invalid x265 preset or tune: %s, %s.\n", cfg.preset.c_str(), cfg.tune.c_str());
+      close();
+      return -5;
+    }
+
+    num_threads = (0 < cfg.threads) ? cfg.threads : encoder_get_thread_budget(cfg.num_cameras);
+
+    /* One pool of `num_threads` threads; x265 sizes the frame threads and lookahead to it. */
+    sprintf(pools, "%d", num_threads);
+    if (0 != x265_param_parse(p, "pools", pools)) {
+      printf("Error: cannot set the x265 thread pool to %s threads.\n", pools);
+      close();
+      return -5;
+    }
+
+    p->sourceWidth = w;
+    p->sourceHeight = h;
+    p->internalCsp = X265_CSP_I420;
+    p->fpsNum = (uint32_t)((0 < fps) ? fps : CA_FPS_30_00);
+    p->fpsDenom = 100;
+    p->keyframeMax = encoder_get_keyint(cfg, fps);
+    p->bOpenGOP = 0;                                                                /* Key frames are IDR frames. */
+    p->bframes = 0;                                                                 /* The writers store frames in decode order. */
+    p->bAnnexB = 0;                                                                 /* 4 byte NAL lengths, as the containers want. */
+    p->bRepeatHeaders = 0;                                                          /* The parameter sets are in the hvcC. */
+    p->logLevel = X265_LOG_WARNING;
+    p->vui.bEnableVideoFullRangeFlag = (CA_YUVJ420P == fmt) ? 1 : 0;
+
+    if (0 < cfg.bitrate) {
+      p->rc.rateControlMode = X265_RC_ABR;
+      p->rc.bitrate = cfg.bitrate;
+      p->rc.vbvMaxBitrate = cfg.bitrate;
+      p->rc.vbvBufferSize = cfg.bitrate;
+    }
+    else {
+      p->rc.rateControlMode = X265_RC_CRF;
+      p->rc.rfConstant = (double)cfg.crf;
+    }
+
+    state->encoder = x265_encoder_open(p);
+    if (NULL == state->encoder) {
+      printf("Error: cannot open the x265 encoder.\n");
+      close();
+      return -6;
+    }
+
+    state->input = x265_picture_alloc();
+    state->output = x265_picture_alloc();
+
+    if (NULL == state->input || NULL == state->output) {
+      printf("Error: cannot allocate the x265 pictures.\n");
+      close();
+      return -7;
+    }
+
+    x265_picture_init(p, state->input);
+    x265_picture_init(p, state->output);
+
+    width = w;
+    height = h;
+    pixel_format = fmt;
+
+    if (0 != createCodecPrivate()) {
+      close();
+      return -8;
+    }
+
+#else
+    (void)fps;
+    (void)cfg;
+#endif
+
+    return 0;
+  }
+
+  int X265Encoder::close() {
+
+#if defined(USE_X265)
+
+    if (NULL == state) {
+      return 0;
+    }
+
+    if (NULL != state->encoder) {
+      x265_encoder_close(state->encoder);
+      state->encoder = NULL;
+    }
+
+    if (NULL != state->input) {
+      x265_picture_free(state->input);
+      state->input = NULL;
+    }
+
+    if (NULL != state->output) {
+      x265_picture_free(state->output);
+      state->output = NULL;
+    }
+
+    if (NULL != state->param) {
+      x265_param_free(state->param);
+      state->param = NULL;
+    }
+
+    delete state;
+    state = NULL;
+
+#endif
+
+    width = 0;
+    height = 0;
+    pixel_format = CA_NONE;
+    num_threads = 0;
+    codec_private.clear();
+
+    return 0;
+  }
+
+  int X265Encoder::encode(const PixelBuffer* pic, uint64_t timestamp, EncodedFrame& out) {
+
+    out.num_chunks = 0;
+    out.timestamp = 0;
+    out.keyframe = false;
+
+    if (NULL == state) {
+      printf("Error: cannot encode, the x265 encoder is not open.\n");
+      return -1;
+    }
+
+#if defined(USE_X265)
+
+    x265_nal* nals = NULL;
+    uint32_t num_nals = 0;
+    int r = 0;
+
+    if (NULL != pic) {
+
+      if (pic->pixel_format != pixel_format || (int)pic->width[0] != width || (int)pic->height[0] != height) {
+        printf("Error: the x265 encoder expects %d x %d %s pictures.\n", width, height, format_to_string(pixel_format).c_str());
+        return -2;
+      }
+
+      /* x265 copies the picture into its own frame; we only pass the planes. */
+      for (int i = 0; i < 3; ++i) {
+        state->input->planes[i] = pic->plane[i];
+        state->input->stride[i] = (int)pic->stride[i];
+      }
+
+      state->input->pts = (int64_t)timestamp;
+    }
+
+    r = x265_encoder_encode(state->encoder, &nals, &num_nals, (NULL == pic) ? NULL : state->input, state->output);
+    if (0 > r) {
+      printf("Error: x265 failed to encode a frame.\n");
+      return -3;
+    }
+
+    if (0 == r || 0 == num_nals) {
+      return 0;
+    }
+
+    for (uint32_t i = 0; i < num_nals; ++i) {
+      if (0 != encoder_add_chunk(out, nals[i].payload, (size_t)nals[i].sizeBytes)) {
+        return -4;
+      }
+    }
+
+    out.timestamp = (uint64_t)state->output->pts;
+    out.keyframe = (X265_TYPE_IDR == state->output->sliceType);
+
+    return 1;
+
+#else
+    (void)pic;
+    (void)timestamp;
+    return -1;
+#endif
+  }
+
+  bool X265Encoder::canEncode(int fmt) {
+    return CA_YUV420P == fmt || CA_YUVJ420P == fmt;
+  }
+
+  int X265Encoder::getNumThreads() {
+    return num_threads;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  int X265Encoder::createCodecPrivate() {
+
+#if defined(USE_X265)
+
+    x265_nal* nals = NULL;
+    x265_nal* units[3] = { NULL, NULL, NULL };
+    uint32_t num_nals = 0;
+    size_t nbytes = 0;
+
+    if (0 > x265_encoder_headers(state->encoder, &nals, &num_nals)) {
+      printf("Error: cannot get the headers of the x265 encoder.\n");
+      return -1;
+    }
+
+    for (uint32_t i = 0; i < num_nals; ++i) {
+      if (CA_H265_NAL_VPS <= nals[i].type && CA_H265_NAL_PPS >= nals[i].type) {
+        units[nals[i].type - CA_H265_NAL_VPS] = &nals[i];
+      }
+    }
+
+    if (NULL == units[0] || NULL == units[1] || NULL == units[2]) {
+      printf("Error: the x265 encoder didn't give us a VPS, SPS and PPS.\n");
+      return -2;
+    }
+
+    /* The payloads start with the 4 byte length. */
+    codec_private.resize(units[0]->sizeBytes + units[1]->sizeBytes + units[2]->sizeBytes + 32);
+    nbytes = h265_get_hvcc(units[0]->payload + 4, units[0]->sizeBytes - 4,
+                           units[1]->payload + 4, units[1]->sizeBytes - 4,
+                           units[2]->payload + 4, units[2]->sizeBytes - 4,
+                           &codec_private[0], codec_private.size());
+
+    if (0 == nbytes) {
+      printf("Error: cannot create the hvcC of the x265 encoder.\n");
+      return -3;
+    }
+
+    codec_private.resize(nbytes);
+
+#endif
+
+    return 0;
+  }
+
+} /* namespace ca */
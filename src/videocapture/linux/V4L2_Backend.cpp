@@ -0,0 +1,67 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <videocapture/linux/V4L2_Devices.h>
+#include <videocapture/linux/V4L2_Backend.h>
+
+namespace ca {
+
+  static V4L2_SystemBackend v4l2_system_backend;
+  static V4L2_Backend* v4l2_default_backend = NULL;
+
+  /* -------------------------------------- */
+
+  V4L2_Backend::~V4L2_Backend() {
+  }
+
+  /* -------------------------------------- */
+
+  std::vector<V4L2_Device> V4L2_SystemBackend::getDevices() {
+    return v4l2_get_devices();
+  }
+
+  int V4L2_SystemBackend::open(const char* path, int flags) {
+    return ::open(path, flags, 0);
+  }
+
+  int V4L2_SystemBackend::close(int fd) {
+    return ::close(fd);
+  }
+
+  // See: https://gist.github.com/maxlapshin/1253534
+  int V4L2_SystemBackend::ioctl(int fd, unsigned long request, void* arg) {
+
+    int r;
+
+    do {
+      r = ::ioctl(fd, request, arg);
+    } while (-1 == r && EINTR == errno);
+
+    return r;
+  }
+
+  void* V4L2_SystemBackend::mmap(size_t length, int prot, int flags, int fd, off_t offset) {
+    return ::mmap(NULL, length, prot, flags, fd, offset);
+  }
+
+  int V4L2_SystemBackend::munmap(void* addr, size_t length) {
+    return ::munmap(addr, length);
+  }
+
+  /* -------------------------------------- */
+
+  V4L2_Backend* v4l2_get_system_backend() {
+    return &v4l2_system_backend;
+  }
+
+  V4L2_Backend* v4l2_get_default_backend() {
+    return (NULL == v4l2_default_backend) ? &v4l2_system_backend : v4l2_default_backend;
+  }
+
+  void v4l2_set_default_backend(V4L2_Backend* backend) {
+    v4l2_default_backend = backend;
+  }
+
+} /* namespace ca */
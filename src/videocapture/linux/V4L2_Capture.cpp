@@ -1,16 +1,13 @@
 #include <videocapture/linux/V4L2_Capture.h>
+#include <videocapture/Log.h>
+#include <videocapture/Error.h>
+#include <videocapture/Trace.h>
 
 namespace ca {
 
   // WRAPPER - see: https://gist.github.com/maxlapshin/1253534
   int v4l2_ioctl(int fh, int request, void* arg) {
-    int r;
-
-    do {
-      r = ioctl(fh, request, arg);
-    } while(-1 == r && EINTR == errno);
-
-    return r;
+    return v4l2_get_system_backend()->ioctl(fh, (unsigned long)(unsigned int)request, arg);
   }
 
 
@@ -20,8 +17,19 @@ namespace ca {
     :Base(fc, user)
     ,state(CA_STATE_NONE)
     ,capture_device_fd(-1)
+    ,bytes_per_line(0)
+    ,backend(v4l2_get_default_backend())
+    ,num_corrupt(0)
+    ,num_buffers(4)
+    ,num_queued(0)
+    ,frame_interval(0)
+    ,watchdog_timeout(CA_V4L2_WATCHDOG_AUTO)
+    ,last_frame_time(0)
+    ,recover_step(CA_RECOVER_RESTART)
+    ,lost_state(0)
   {
     pixel_buffer.user = user;
+    pipeline.stats = &stats;
   }
 
   V4L2_Capture::~V4L2_Capture() {
@@ -43,19 +51,22 @@ namespace ca {
 
     // Already open?
     if(capture_device_fd > 0) {
-      printf("Error: device already opened. First close it.\n");
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_ERROR("device already opened. First close it.");
       return -1;
     }
 
-    if(state & CA_STATE_OPENED) {
-      printf("Error: already openend.\n");
+    if((state | lost_state) & CA_STATE_OPENED) {
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_ERROR("already openend.");
       return -2;
     }
 
     // Get all devices (we select the one set in `settings`).
-    std::vector<V4L2_Device> v4l2_devices = v4l2_get_devices(); 
+    std::vector<V4L2_Device> v4l2_devices = backend->getDevices();
     if(settings.device >= v4l2_devices.size()) {
-      printf("Error: device index is invalid.\n");
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("device index is invalid.");
       return -3;
     }
 
@@ -63,7 +74,8 @@ namespace ca {
     std::vector<Capability> capabilities = getCapabilities(settings.device);
 
     if(settings.capability >= capabilities.size()) {
-      printf("Error: Invalid capability index.\n");
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("Invalid capability index.");
       return -4;
     }
 
@@ -74,8 +86,9 @@ namespace ca {
     capture_device_fd = openDevice(v4l2_device.path);
 
     if(capture_device_fd < 0) {
-      printf("Error: cannot open the device: %d\n", capture_device_fd);
+      CA_LOG_ERROR("cannot open the device: %d", capture_device_fd);
       closeDevice(capture_device_fd);
+      capture_device_fd = -1;
       return -5;
     }
 
@@ -84,14 +97,17 @@ namespace ca {
 
     if(pix_fmt == CA_NONE) {
       std::string str = format_to_string(cap.pixel_format).c_str();
-      printf("Error: cannot find the v4l2 pixel format for the capture format: %s\n", str.c_str());
+      error_set(CA_ERR_NOT_SUPPORTED, 0);
+      CA_LOG_ERROR("cannot find the v4l2 pixel format for the capture format: %s", str.c_str());
       closeDevice(capture_device_fd);
+      capture_device_fd = -1;
       return -6;
     }
 
     if(setCaptureFormat(capture_device_fd, cap.width, cap.height, pix_fmt) < 0) {
-      printf("Error: cannot set the capture format.\n");
+      CA_LOG_ERROR("cannot set the capture format.");
       closeDevice(capture_device_fd);
+      capture_device_fd = -1;
       return -7;
     }
 
@@ -100,12 +116,15 @@ namespace ca {
 
     if(!getCapabilityV4L2(capture_device_fd, &caps)) {
       closeDevice(capture_device_fd);
+      capture_device_fd = -1;
       return -8;
     }
 
     if(!(caps.capabilities & V4L2_CAP_VIDEO_CAPTURE)) {
-      printf("Error: Not a video capture device; we only support video capture devices.\n");
+      error_set(CA_ERR_NOT_SUPPORTED, 0);
+      CA_LOG_ERROR("Not a video capture device; we only support video capture devices.");
       closeDevice(capture_device_fd);
+      capture_device_fd = -1;
       return -9;
     }
 
@@ -114,37 +133,70 @@ namespace ca {
     bool can_io_stream = (caps.capabilities & V4L2_CAP_STREAMING) == V4L2_CAP_STREAMING;
 
     if(!can_io_readwrite && !can_io_stream) {
-      printf("Error: Cannot use read() or memory streaming with this device.\n");
+      error_set(CA_ERR_NOT_SUPPORTED, 0);
+      CA_LOG_ERROR("Cannot use read() or memory streaming with this device.");
       closeDevice(capture_device_fd);
+      capture_device_fd = -1;
       return -10;
     }
 
     if(!can_io_stream) {
-      printf("Error: The device cannot memory stream; we only support this method for now.\n");
+      error_set(CA_ERR_NOT_SUPPORTED, 0);
+      CA_LOG_ERROR("The device cannot memory stream; we only support this method for now.");
       closeDevice(capture_device_fd);
+      capture_device_fd = -1;
       return -11;
     }
     
     if(initializeMMAP(capture_device_fd) < 0) {
+      closeDevice(capture_device_fd);
+      capture_device_fd = -1;
       return -12;
     }
 
-    state |= CA_STATE_OPENED;
+    if(setupPixelBuffer(cap.width, cap.height, cap.pixel_format) < 0) {
+      shutdownMMAP();
+      closeDevice(capture_device_fd);
+      capture_device_fd = -1;
+      return -13;
+    }
 
-    pixel_buffer.pixel_format = cap.pixel_format;
+    if(pipeline.init(cap.width, cap.height, cap.pixel_format, settings.format, settings.rotation,
+                     settings.jpeg_scale, settings.decode_threads, settings.drop_policy, settings.decode_thread_type) < 0) {
+      shutdownMMAP();
+      closeDevice(capture_device_fd);
+      capture_device_fd = -1;
+      return -14;
+    }
+
+    num_corrupt = 0;
+    num_queued = 0;
+    open_settings = settings;
+    frame_interval = (cap.fps > 0) ? 100000000000ull / (uint64_t)cap.fps : 0;
+    stats.reset();
+    stats.setBuffers((int)buffers.size(), 0);
+    state |= CA_STATE_OPENED;
 
     return 1;
   }
 
   int V4L2_Capture::close() {
 
+    /* The watchdog closed the device already. */
+    if(lost_state & CA_STATE_OPENED) {
+      lost_state = 0;
+      return 1;
+    }
+
     if(capture_device_fd < 0) {
-      printf("Error: cannot close capture because it's not opened. Invalid fd.\n");
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_ERROR("cannot close capture because it's not opened. Invalid fd.");
       return -1;
     }
 
     if( (state & CA_STATE_OPENED) != CA_STATE_OPENED) {
-      printf("Error: cannot close a capture device because it's not opened.\n");
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_ERROR("cannot close a capture device because it's not opened.");
       return -2;
     }
 
@@ -159,6 +211,9 @@ namespace ca {
       return -5;
     }
 
+    pipeline.shutdown();
+    capture_device_fd = -1;
+
     state &= ~CA_STATE_OPENED;
     return 1;
   }
@@ -166,18 +221,33 @@ namespace ca {
   // Start streaming.
   int V4L2_Capture::start() {
 
+    /* The watchdog tries to open the device again while we're capturing. */
+    if(lost_state & CA_STATE_OPENED) {
+      if(lost_state & CA_STATE_CAPTUREING) {
+        error_set(CA_ERR_INVALID_STATE, 0);
+        CA_LOG_ERROR("we are already captureing. Cannot start again.");
+        return -2;
+      }
+      lost_state |= CA_STATE_CAPTUREING;
+      last_frame_time = time_now_ns();
+      return 1;
+    }
+
     if(capture_device_fd < 0) {
-      printf("Error: cannot start capture as the device descriptor is invalid.\n");
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_ERROR("cannot start capture as the device descriptor is invalid.");
       return -1;
     }
 
     if(state & CA_STATE_CAPTUREING) {
-      printf("Error: we are already captureing. Cannot start again.\n");
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_ERROR("we are already captureing. Cannot start again.");
       return -2;
     }
 
     if((state & CA_STATE_OPENED) != CA_STATE_OPENED) {
-      printf("Error: not yet opened.\n");
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_ERROR("not yet opened.");
       return -3;
     }
   
@@ -189,43 +259,62 @@ namespace ca {
       buf.memory = V4L2_MEMORY_MMAP;
       buf.index = i;
     
-      if(v4l2_ioctl(capture_device_fd, VIDIOC_QBUF, &buf) == -1) {
-        printf("Error: VIDIO_QBUF failed - invalid mmap buffer.\n");
+      if(backend->ioctl(capture_device_fd, VIDIOC_QBUF, &buf) == -1) {
+        error_set_system(errno);
+        CA_LOG_ERROR("VIDIO_QBUF failed - invalid mmap buffer.");
         return -4;
       }
+
+      num_queued++;
     }
 
+    stats.setBuffers((int)buffers.size(), num_queued);
+
     // stream on!
     enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    if(v4l2_ioctl(capture_device_fd, VIDIOC_STREAMON, &type) == -1) {
-      printf("Error: Failed to start the video capture stream, VIDIOC_STREAMON failed.\n");
+    if(backend->ioctl(capture_device_fd, VIDIOC_STREAMON, &type) == -1) {
+      error_set_system(errno);
+      CA_LOG_ERROR("Failed to start the video capture stream, VIDIOC_STREAMON failed.");
       return -5;
     }
 
     state |= CA_STATE_CAPTUREING;
+    last_frame_time = time_now_ns();
 
     return 1;
   }
 
   int V4L2_Capture::stop() {
 
+    if(lost_state & CA_STATE_CAPTUREING) {
+      lost_state &= ~CA_STATE_CAPTUREING;
+      return 1;
+    }
+
     if(capture_device_fd < 0) {
-      printf("Error: cannot stop captureing becuause the device descriptor is invalid.\n");
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_ERROR("cannot stop captureing becuause the device descriptor is invalid.");
       return -1;
     }
 
     if( (state & CA_STATE_CAPTUREING) != CA_STATE_CAPTUREING) {
-      printf("Error: cannot stop captureing because we didn't start captureing yet.\n");
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_ERROR("cannot stop captureing because we didn't start captureing yet.");
       return -2;
     }
 
     // stream off!
     enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    if(v4l2_ioctl(capture_device_fd, VIDIOC_STREAMOFF, &type) == -1) {
-      printf("Error: cannot stop captureing because of an ioctl error. (did you really start capturing before?).\n");
+    if(backend->ioctl(capture_device_fd, VIDIOC_STREAMOFF, &type) == -1) {
+      error_set_system(errno);
+      CA_LOG_ERROR("cannot stop captureing because of an ioctl error. (did you really start capturing before?).");
       return -3;
     }
 
+    /* STREAMOFF dequeues all buffers. */
+    num_queued = 0;
+    stats.setBuffers((int)buffers.size(), num_queued);
+
     state &= ~CA_STATE_CAPTUREING;
 
     return 1;
@@ -233,14 +322,33 @@ namespace ca {
 
   void V4L2_Capture::update() {
 
-    readFrame();
+    /* The device is closed until the watchdog manages to open it again. */
+    if(lost_state) {
+      checkWatchdog();
+      return;
+    }
+
+    /* Dequeue every frame that's ready; after a hiccup (EAGAIN, EIO) we'd otherwise stay behind until the driver drops frames. */
+    for(size_t i = 0; i < buffers.size(); ++i) {
+      if(readFrame() < 0) {
+        break;
+      }
+    }
+
+    /* Deliver the frames that our decode threads finished since the last frame, see `Settings.decode_threads`. */
+    if(cb_frame) {
+      pipeline.poll(cb_frame);
+    }
+
+    checkWatchdog();
   }
 
   // Read one more frame.
   int V4L2_Capture::readFrame() {
     
     if(capture_device_fd < 0) {
-      printf("Error: cannot readFrame() because the capture device descriptor is invalid.\n");
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_ERROR("cannot readFrame() because the capture device descriptor is invalid.");
       return -1;
     }
 
@@ -249,35 +357,83 @@ namespace ca {
     memset(&buf, 0, sizeof(buf));
     buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     buf.memory = V4L2_MEMORY_MMAP;
-  
-    if(v4l2_ioctl(capture_device_fd, VIDIOC_DQBUF, &buf) == -1) {
+
+    CA_TRACE_BEGIN(trace_dqbuf);
+
+    if(backend->ioctl(capture_device_fd, VIDIOC_DQBUF, &buf) == -1) {
       if(errno == EAGAIN) {
         return -2; /* everything ok; just not ready yet */
       }
       else if(errno == EIO) {
-        printf("Error: IO error.\n");
+        error_set_system(errno);
+        CA_LOG_ERROR("IO error.");
         return -3; /* we could handle this as an error. */
       }
       else {
-        printf("Error: with reading the memory buffer: %s.\n", strerror(errno));
+        error_set_system(errno);
+        CA_LOG_ERROR("with reading the memory buffer: %s.", strerror(errno));
         return -4;
       }
     }
 
     assert(buf.index < buffers.size());
 
-    if(cb_frame) {
-      pixel_buffer.pixels = (uint8_t*)buffers[buf.index]->start;
-      pixel_buffer.plane[0] = pixel_buffer.pixels;
-      pixel_buffer.nbytes = buf.bytesused;
-      cb_frame(pixel_buffer);
+    CA_TRACE_END(trace_dqbuf, "v4l2.dqbuf", buf.sequence);
+
+    num_queued--;
+    stats.setBuffers((int)buffers.size(), num_queued);
+
+    /* Even a corrupt buffer means the device is alive. */
+    last_frame_time = time_now_ns();
+    recover_step = CA_RECOVER_RESTART;
+
+    /* Prefer the time the driver captured the frame; it's not affected by how late we dequeue it. */
+    uint64_t dequeue_time = time_now_ns();
+    uint64_t capture_time = dequeue_time;
+
+    if ((buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC) {
+      capture_time = (uint64_t)buf.timestamp.tv_sec * 1000000000ull + (uint64_t)buf.timestamp.tv_usec * 1000ull;
+      if (dequeue_time > capture_time) {
+        stats.recordLatency(CA_LATENCY_DEQUEUE, dequeue_time - capture_time);
+      }
+    }
+
+    /* The driver hands back buffers it failed to fill (e.g. a USB transfer error); we skip them. */
+    if(buf.flags & V4L2_BUF_FLAG_ERROR) {
+      CA_TRACE_INSTANT_EVENT("v4l2.corrupt", buf.sequence);
+      num_corrupt++;
+    }
+    else if(cb_frame) {
+
+      if(pixel_buffer.stride[0] != 0) {
+        pixel_buffer.setPixels((uint8_t*)buffers[buf.index]->start);
+      }
+      else {
+        pixel_buffer.pixels = (uint8_t*)buffers[buf.index]->start;
+        pixel_buffer.plane[0] = pixel_buffer.pixels;
+        pixel_buffer.nbytes = buf.bytesused;
+      }
+
+      pixel_buffer.sequence = buf.sequence;
+      pixel_buffer.timestamp = capture_time;
+      pixel_buffer.receive_time = dequeue_time;
+
+      pipeline.process(pixel_buffer, cb_frame);
     }
 
-    if(v4l2_ioctl(capture_device_fd, VIDIOC_QBUF, &buf) == -1) {
-      printf("Error: with queueing the buffer again: %s.\n", strerror(errno));
+    CA_TRACE_BEGIN(trace_qbuf);
+
+    if(backend->ioctl(capture_device_fd, VIDIOC_QBUF, &buf) == -1) {
+      error_set_system(errno);
+      CA_LOG_ERROR("with queueing the buffer again: %s.", strerror(errno));
       return -5;
     }
 
+    CA_TRACE_END(trace_qbuf, "v4l2.qbuf", buf.sequence);
+
+    num_queued++;
+    stats.setBuffers((int)buffers.size(), num_queued);
+
     return 1;
   }
 
@@ -295,7 +451,8 @@ namespace ca {
     V4L2_Device v4l2_device;
 
     if(getDeviceV4L2(device, v4l2_device) < 0) {
-      printf("Error: Cannot find the input device to list capabilities.\n");
+      error_set(CA_ERR_NOT_FOUND, 0);
+      CA_LOG_ERROR("Cannot find the input device to list capabilities.");
       return result;
     }
 
@@ -305,8 +462,10 @@ namespace ca {
       return result;
     }
 
-    if(v4l2_ioctl(fd, VIDIOC_QUERYCAP, &cap) == -1) {
-      printf("Error: Cannot query the device capabilities.\n");
+    if(backend->ioctl(fd, VIDIOC_QUERYCAP, &cap) == -1) {
+      error_set_system(errno);
+      CA_LOG_ERROR("Cannot query the device capabilities.");
+      closeDevice(fd);
       return result;
     }
 
@@ -319,8 +478,9 @@ namespace ca {
         fmtdesc.index = i;
         fmtdesc.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
 
-        if(v4l2_ioctl(fd, VIDIOC_ENUM_FMT, &fmtdesc) == -1) {
-          return result;
+        /* The end of the list; we still have to close the device. */
+        if(backend->ioctl(fd, VIDIOC_ENUM_FMT, &fmtdesc) == -1) {
+          break;
         }
 
         Capability capability;
@@ -331,7 +491,7 @@ namespace ca {
         frames.index = 0;
         frames.pixel_format = fmtdesc.pixelformat;
 
-        while(!v4l2_ioctl(fd, VIDIOC_ENUM_FRAMESIZES, &frames)) {
+        while(!backend->ioctl(fd, VIDIOC_ENUM_FRAMESIZES, &frames)) {
 
           if(frames.type == V4L2_FRMSIZE_TYPE_DISCRETE) {
             struct v4l2_frmivalenum fpse;
@@ -341,7 +501,7 @@ namespace ca {
             fpse.width = frames.discrete.width;
             fpse.height = frames.discrete.height;
 
-            while(!v4l2_ioctl(fd, VIDIOC_ENUM_FRAMEINTERVALS, &fpse)) {
+            while(!backend->ioctl(fd, VIDIOC_ENUM_FRAMEINTERVALS, &fpse)) {
               if(fpse.type == V4L2_FRMIVAL_TYPE_DISCRETE) {
                 capability.fps = fps_from_rational((uint64_t)fpse.discrete.numerator, (uint64_t)fpse.discrete.denominator);
                 capability.width = frames.discrete.width;
@@ -368,7 +528,7 @@ namespace ca {
   std::vector<Device> V4L2_Capture::getDevices() {
 
     std::vector<Device> result;
-    std::vector<V4L2_Device> devs = v4l2_get_devices();
+    std::vector<V4L2_Device> devs = backend->getDevices();
 
     for(size_t i = 0; i < devs.size(); ++i) {
       
@@ -376,7 +536,7 @@ namespace ca {
       Device dev;
 
       if (getDriverInfo(v4l2_dev.path.c_str(), v4l2_dev) < 0) {
-        printf("We didn't find any driver info for the device: %s.\n", v4l2_dev.path.c_str());
+        CA_LOG_WARNING("We didn't find any driver info for the device: %s.", v4l2_dev.path.c_str());
         continue;
       }
       
@@ -390,7 +550,35 @@ namespace ca {
   }
 
   std::vector<Format> V4L2_Capture::getOutputFormats() {
+
+    /* Every format a V4L2 device can deliver and every format our kernels or the MJPEG decoder can produce. */
+    static const int formats[] = {
+      CA_YUYV422, CA_UYVY422, CA_YUV422P, CA_YUV420P, CA_YUVJ420P, CA_YUV420BP,
+      CA_RGB24, CA_BGRA32, CA_RGBA32, CA_ARGB32, CA_MJPEG, CA_H264
+    };
+
     std::vector<Format> result;
+    size_t n = sizeof(formats) / sizeof(formats[0]);
+
+    for (size_t dst = 0; dst < n; ++dst) {
+
+      for (size_t src = 0; src < n; ++src) {
+
+        if (src == dst
+            || capture_format_to_v4l2_pixel_format(formats[src]) == CA_NONE
+            || false == frame_pipeline_can_deliver(formats[src], formats[dst]))
+          {
+            continue;
+          }
+
+        Format fmt;
+        fmt.format = formats[dst];
+        fmt.index = result.size();
+        result.push_back(fmt);
+        break;
+      }
+    }
+
     return result;
   }
 
@@ -402,17 +590,19 @@ namespace ca {
 
     struct v4l2_requestbuffers req;
     memset(&req, 0, sizeof(req));
-    req.count = 4;
+    req.count = num_buffers;
     req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     req.memory = V4L2_MEMORY_MMAP;
 
-    if(v4l2_ioctl(fd, VIDIOC_REQBUFS, &req) == -1) {
-      printf("Error: Cannot use mmap().\n");
+    if(backend->ioctl(fd, VIDIOC_REQBUFS, &req) == -1) {
+      error_set_system(errno);
+      CA_LOG_ERROR("Cannot use mmap().");
       return -1;
     }
 
     if(req.count < 2) {
-      printf("Error: Insufficient buffer memory.\n");
+      error_set(CA_ERR_NO_MEMORY, 0);
+      CA_LOG_ERROR("Insufficient buffer memory.");
       return -2;
     }
 
@@ -422,7 +612,8 @@ namespace ca {
       V4L2_Buffer* buffer = new V4L2_Buffer();
 
       if(!buffer) {
-        printf("Error: Cannot allocate the V4L2 buffer for mmap'd IO.\n");
+        error_set(CA_ERR_NO_MEMORY, 0);
+        CA_LOG_ERROR("Cannot allocate the V4L2 buffer for mmap'd IO.");
         goto error;
       }
 
@@ -436,30 +627,31 @@ namespace ca {
       vbuf.index = i;
 
       // map the buffer.
-      if(v4l2_ioctl(fd, VIDIOC_QUERYBUF, &vbuf) == -1) {
-        printf("Error: Cannot query the buffer for index: %d.\n", vbuf.index);
+      if(backend->ioctl(fd, VIDIOC_QUERYBUF, &vbuf) == -1) {
+        error_set_system(errno);
+        CA_LOG_ERROR("Cannot query the buffer for index: %d.", vbuf.index);
         goto error;
       }
 
       buffer->length = vbuf.length;
-      buffer->start = mmap(NULL, /* start anywhere */
-                           vbuf.length,
-                           PROT_READ | PROT_WRITE,
-                           MAP_SHARED,
-                           fd, vbuf.m.offset);
+      buffer->start = backend->mmap(vbuf.length,
+                                    PROT_READ | PROT_WRITE,
+                                    MAP_SHARED,
+                                    fd, vbuf.m.offset);
 
       if(buffer->start == MAP_FAILED) {
+        error_set_system(errno);
         if(errno == EBADF) {
-          printf("Error: cannot map memory, fd is not a valid descriptor. (EBADF).\n");
+          CA_LOG_ERROR("cannot map memory, fd is not a valid descriptor. (EBADF).");
         }
         else if(errno == EACCES) {
-          printf("Error: cannot map memory, fd is open for reading and writing. (EACCESS).\n");
+          CA_LOG_ERROR("cannot map memory, fd is open for reading and writing. (EACCESS).");
         }
         else if(errno == EINVAL) {
-          printf("Error: cannot map memory, the start or length offset are not suitable. Flags or prot value is not supported. No buffers have been allocated. (EINVAL).\n");
+          CA_LOG_ERROR("cannot map memory, the start or length offset are not suitable. Flags or prot value is not supported. No buffers have been allocated. (EINVAL).");
         }
         else {
-          printf("Error: MMAP failed.\n");
+          CA_LOG_ERROR("MMAP failed.");
         }
         goto error;
       }
@@ -478,8 +670,9 @@ namespace ca {
 
     for(std::vector<V4L2_Buffer*>::iterator it = buffers.begin(); it != buffers.end(); ++it) {
       V4L2_Buffer* buf = *it;
-      if(munmap(buf->start, buf->length) == -1) {
-        printf("Error: cannot unmap a memory buffer (?)\n");
+      if(backend->munmap(buf->start, buf->length) == -1) {
+        error_set_system(errno);
+        CA_LOG_ERROR("cannot unmap a memory buffer (?)");
       }
       delete buf;
     }
@@ -492,7 +685,8 @@ namespace ca {
   int V4L2_Capture::setCaptureFormat(int fd, int width, int height, int pixfmt) { 
 
     if(fd <= 0) {
-      printf("Error: cannot set capture format, invalid fd.\n");
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("cannot set capture format, invalid fd.");
       return -1;
     }
 
@@ -504,8 +698,9 @@ namespace ca {
 
     fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
 
-    if(v4l2_ioctl(fd, VIDIOC_G_FMT, &fmt) == -1) {
-      printf("Error: cannot retrieve the current format that we need to change/set it.\n");
+    if(backend->ioctl(fd, VIDIOC_G_FMT, &fmt) == -1) {
+      error_set_system(errno);
+      CA_LOG_ERROR("cannot retrieve the current format that we need to change/set it.");
       return -2;
     }
 
@@ -514,31 +709,79 @@ namespace ca {
     fmt.fmt.pix.pixelformat = pixfmt;
 
     if(fmt.fmt.pix.pixelformat == 0) {
-      printf("Error: cannot find a v4l2 pixel format for the given a LibAV PixelFormat.\n");
+      error_set(CA_ERR_NOT_SUPPORTED, 0);
+      CA_LOG_ERROR("cannot find a v4l2 pixel format for the given a LibAV PixelFormat.");
       return -3;
     }
    
     // try the new format
-    if(v4l2_ioctl(fd, VIDIOC_TRY_FMT, &fmt) == -1) {
-      printf("Error: the video capture device doesnt support the given format.\n");
+    if(backend->ioctl(fd, VIDIOC_TRY_FMT, &fmt) == -1) {
+      error_set(CA_ERR_NOT_SUPPORTED, errno);
+      CA_LOG_ERROR("the video capture device doesnt support the given format.");
       return -4;
     }
 
     // set the new format
-    if(v4l2_ioctl(fd, VIDIOC_S_FMT, &fmt) == -1) {
-      printf("Error: cannot set the given format %d x %d, (%s).\n", width, height, strerror(errno));
+    if(backend->ioctl(fd, VIDIOC_S_FMT, &fmt) == -1) {
+      error_set_system(errno);
+      CA_LOG_ERROR("cannot set the given format %d x %d, (%s).", width, height, strerror(errno));
       return -5;
     }
 
+    bytes_per_line = fmt.fmt.pix.bytesperline;
+
+    return 1;
+  }
+
+  // Setup the buffer that we pass to the callback; compressed formats only get a size and format.
+  int V4L2_Capture::setupPixelBuffer(int width, int height, int pixfmt) {
+
+    pixel_buffer.pixel_format = pixfmt;
+
+    if(pixfmt == CA_MJPEG || pixfmt == CA_H264 || pixfmt == CA_JPEG_OPENDML) {
+      pixel_buffer.width[0] = width;
+      pixel_buffer.height[0] = height;
+      return 1;
+    }
+
+    if(pixel_buffer.setup(width, height, pixfmt) < 0) {
+      error_set(CA_ERR_NOT_SUPPORTED, 0);
+      CA_LOG_ERROR("cannot setup the pixel buffer for %s.", format_to_string(pixfmt).c_str());
+      return -1;
+    }
+
+    // The driver may pad the rows; V4L2 planar formats scale the chroma stride accordingly.
+    if(bytes_per_line != 0 && bytes_per_line != pixel_buffer.stride[0]) {
+
+      size_t tight = pixel_buffer.stride[0];
+      size_t offset = 0;
+
+      for(int i = 0; i < 3; ++i) {
+
+        if(pixel_buffer.stride[i] == 0) {
+          continue;
+        }
+
+        size_t rows = (pixel_buffer.height[i] == 0) ? pixel_buffer.height[0] : pixel_buffer.height[i];
+
+        pixel_buffer.stride[i] = (pixel_buffer.stride[i] * bytes_per_line) / tight;
+        pixel_buffer.offset[i] = offset;
+        offset += pixel_buffer.stride[i] * rows;
+      }
+
+      pixel_buffer.nbytes = offset;
+    }
+
     return 1;
   }
 
   int V4L2_Capture::getDeviceV4L2(int dx, V4L2_Device& result) {
 
-    std::vector<V4L2_Device> devices = v4l2_get_devices();
+    std::vector<V4L2_Device> devices = backend->getDevices();
 
     if(dx > (int)devices.size()-1) {
-      printf("Error: Device not found for index %d. Are you sure you're using a valid index?\n", dx);
+      error_set(CA_ERR_NOT_FOUND, 0);
+      CA_LOG_ERROR("Device not found for index %d. Are you sure you're using a valid index?", dx);
       return -1;
     }
 
@@ -550,13 +793,15 @@ namespace ca {
   int V4L2_Capture::getCapabilityV4L2(int fd, struct v4l2_capability* caps) {
 
     if(fd == 0 || fd < 0) {
-      printf("Error: cannot get capablity; invalid fd.\n");
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("cannot get capablity; invalid fd.");
       return -1;
     }
 
     memset(caps, 0, sizeof(*caps));
-    if(v4l2_ioctl(fd, VIDIOC_QUERYCAP, caps) == -1) {
-      printf("Cannot query capability for: %d.\n", fd);
+    if(backend->ioctl(fd, VIDIOC_QUERYCAP, caps) == -1) {
+      error_set_system(errno);
+      CA_LOG_ERROR("Cannot query capability for: %d.", fd);
       return -2;
     }
 
@@ -567,13 +812,15 @@ namespace ca {
   int V4L2_Capture::openDevice(std::string path) {
 
     if(!path.size()) {
-      printf("Error: cannot open the V4L2 Device, Wrong path.\n");
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("cannot open the V4L2 Device, Wrong path.");
       return -1;
     }
 
-    int fd = ::open(path.c_str(), O_RDWR | O_NONBLOCK, 0);
+    int fd = backend->open(path.c_str(), O_RDWR | O_NONBLOCK);
     if(fd == -1) {
-      printf("Error: Cannot open V4L2 Device: %s", path.c_str());
+      error_set_system(errno);
+      CA_LOG_ERROR("Cannot open V4L2 Device: %s", path.c_str());
       return -2;
     }
 
@@ -583,12 +830,13 @@ namespace ca {
   int V4L2_Capture::closeDevice(int fd) {
 
     if(fd < 0) {
-      printf("Error: wrong file descriptor; cannot close device.\n");
+      CA_LOG_ERROR("wrong file descriptor; cannot close device.");
       return fd;
     }
 
-    if(::close(fd) == -1) {
-      printf("Error: something went wrong while trying to close the device.\n");
+    if(backend->close(fd) == -1) {
+      error_set_system(errno);
+      CA_LOG_ERROR("something went wrong while trying to close the device.");
       return -1;
     }
 
@@ -607,8 +855,9 @@ namespace ca {
     struct v4l2_capability cap;
     memset(&cap, 0, sizeof(cap));
 
-    if(v4l2_ioctl(fd, VIDIOC_QUERYCAP, &cap) == -1) {
-      printf("Error: Cannot query the device capabilities.\n");
+    if(backend->ioctl(fd, VIDIOC_QUERYCAP, &cap) == -1) {
+      error_set_system(errno);
+      CA_LOG_ERROR("Cannot query the device capabilities.");
       closeDevice(fd);
       return -2;
     }
@@ -623,4 +872,192 @@ namespace ca {
     closeDevice(fd);
     return 1;
   }
+
+  int V4L2_Capture::setBackend(V4L2_Backend* b) {
+
+    if(capture_device_fd >= 0) {
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_ERROR("cannot change the backend of an opened device.");
+      return -1;
+    }
+
+    backend = (b == NULL) ? v4l2_get_system_backend() : b;
+
+    return 1;
+  }
+
+  int V4L2_Capture::setNumBuffers(int n) {
+
+    if(capture_device_fd >= 0) {
+      error_set(CA_ERR_INVALID_STATE, 0);
+      CA_LOG_ERROR("cannot change the number of buffers of an opened device.");
+      return -1;
+    }
+
+    if(n < 2) {
+      error_set(CA_ERR_INVALID_ARGUMENT, 0);
+      CA_LOG_ERROR("we need at least 2 buffers, got: %d.", n);
+      return -2;
+    }
+
+    num_buffers = n;
+
+    return 1;
+  }
+
+  int V4L2_Capture::setWatchdogTimeout(uint64_t ns) {
+    watchdog_timeout = ns;
+    return 1;
+  }
+
+  /* WATCHDOG */
+  /* -------------------------------------- */
+
+  void V4L2_Capture::checkWatchdog() {
+
+    static const char* step_names[CA_RECOVER_COUNT] = { "restarting the stream", "reallocating the buffers", "reopening the device" };
+
+    if(0 == watchdog_timeout) {
+      return;
+    }
+
+    if(!((state | lost_state) & CA_STATE_CAPTUREING)) {
+      return;
+    }
+
+    uint64_t timeout = watchdog_timeout;
+
+    if(CA_V4L2_WATCHDOG_AUTO == timeout) {
+      timeout = CA_V4L2_WATCHDOG_FRAMES * frame_interval;
+      if(timeout < CA_V4L2_WATCHDOG_MIN_NS) {
+        timeout = CA_V4L2_WATCHDOG_MIN_NS;
+      }
+    }
+
+    uint64_t now = time_now_ns();
+
+    if(now - last_frame_time < timeout) {
+      return;
+    }
+
+    int step = (lost_state) ? CA_RECOVER_REOPEN : recover_step;
+
+    CA_LOG_WARNING("no frame for %llu ms, the stream stalled; %s.", (unsigned long long)((now - last_frame_time) / 1000000ull), step_names[step]);
+    CA_TRACE_INSTANT_EVENT("v4l2.recover", step);
+
+    stats.recoveryStarted(step, now);
+
+    int r = 0;
+
+    switch(step) {
+      case CA_RECOVER_RESTART: r = restartStream(); break;
+      case CA_RECOVER_REALLOCATE: r = reallocateBuffers(); break;
+      default: r = reopen(); break;
+    }
+
+    /* The stream is stopped or has no buffers now; only a reopen can bring it back. */
+    if(r < 0 && CA_RECOVER_REOPEN != step) {
+      CA_LOG_ERROR("failed %s: %d; reopening the device.", step_names[step], r);
+      stats.recoveryStarted(CA_RECOVER_REOPEN, time_now_ns());
+      step = CA_RECOVER_REOPEN;
+      recover_step = CA_RECOVER_REOPEN;
+      r = reopen();
+    }
+
+    if(r < 0) {
+      CA_LOG_ERROR("failed %s: %d; we try again in %llu ms.", step_names[step], r, (unsigned long long)(timeout / 1000000ull));
+    }
+
+    /* The next step when the stream is still stalled after another timeout. */
+    if(recover_step < CA_RECOVER_REOPEN) {
+      recover_step++;
+    }
+
+    last_frame_time = time_now_ns();
+  }
+
+  int V4L2_Capture::restartStream() {
+
+    if(stop() < 0) {
+      return -1;
+    }
+
+    if(start() < 0) {
+      return -2;
+    }
+
+    return 1;
+  }
+
+  int V4L2_Capture::reallocateBuffers() {
+
+    if(stop() < 0) {
+      return -1;
+    }
+
+    if(shutdownMMAP() < 0) {
+      return -2;
+    }
+
+    /* Frees the buffers of the driver; REQBUFS in initializeMMAP() allocates new ones. */
+    struct v4l2_requestbuffers req;
+    memset(&req, 0, sizeof(req));
+    req.count = 0;
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+
+    if(backend->ioctl(capture_device_fd, VIDIOC_REQBUFS, &req) == -1) {
+      error_set_system(errno);
+      CA_LOG_ERROR("cannot free the buffers: %s.", strerror(errno));
+      return -3;
+    }
+
+    if(initializeMMAP(capture_device_fd) < 0) {
+      return -4;
+    }
+
+    stats.setBuffers((int)buffers.size(), 0);
+
+    if(start() < 0) {
+      return -5;
+    }
+
+    return 1;
+  }
+
+  int V4L2_Capture::reopen() {
+
+    /* The watchdog only runs while the application captures. */
+    int wanted = CA_STATE_OPENED | CA_STATE_CAPTUREING;
+
+    lost_state = 0;
+
+    /* Both may fail when the device is gone; we only need the descriptor closed and our state cleared. */
+    if(state & CA_STATE_CAPTUREING) {
+      stop();
+      state &= ~CA_STATE_CAPTUREING;
+    }
+
+    if(state & CA_STATE_OPENED) {
+      if(close() < 0) {
+        pipeline.shutdown();
+        shutdownMMAP();
+        capture_device_fd = -1;
+        state &= ~CA_STATE_OPENED;
+      }
+    }
+
+    if(open(open_settings) < 0) {
+      lost_state = wanted;
+      return -1;
+    }
+
+    if(start() < 0) {
+      close();
+      lost_state = wanted;
+      return -2;
+    }
+
+    return 1;
+  }
 } // namespace ca
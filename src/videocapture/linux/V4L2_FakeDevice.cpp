@@ -0,0 +1,725 @@
+#include <errno.h>
+#include <algorithm>
+#include <string.h>
+#include <sys/mman.h>
+#include <videocapture/Utils.h>
+#include <videocapture/linux/V4L2_Utils.h>
+#include <videocapture/linux/V4L2_FakeDevice.h>
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  static bool v4l2_fake_is_compressed(uint32_t pixfmt);
+  static int v4l2_fake_get_layout(uint32_t pixfmt, int width, int height, uint32_t padding, PixelBuffer& layout);
+
+  /* ------------------------------------------------------------------------- */
+
+  V4L2_FakeFormat::V4L2_FakeFormat(uint32_t pixfmt, int w, int h, uint32_t num, uint32_t den)
+    :pixel_format(pixfmt)
+    ,width(w)
+    ,height(h)
+    ,numerator(num)
+    ,denominator(den)
+  {
+  }
+
+  V4L2_FakeSettings::V4L2_FakeSettings()
+    :path("/dev/video-fake0")
+    ,card("Fake camera")
+    ,max_buffers(8)
+    ,padding(0)
+    ,jitter(0)
+    ,eagain_period(0)
+    ,eagain_burst(3)
+    ,eio_period(0)
+    ,error_period(0)
+    ,stall_after(0)
+    ,stall_until(CA_V4L2_FAKE_STALL_STREAMOFF)
+    ,seed(0x9E3779B9)
+    ,manual_clock(false)
+    ,fill_frames(true)
+  {
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  V4L2_FakeDevice::V4L2_FakeDevice()
+    :next_fd(CA_V4L2_FAKE_FD)
+    ,owner_fd(-1)
+    ,current(0)
+    ,bytes_per_line(0)
+    ,size_image(0)
+    ,is_streaming(false)
+    ,clock(0)
+    ,stream_start(0)
+    ,interval(0)
+    ,next_capture(0)
+    ,num_captured(0)
+    ,num_dropped(0)
+    ,num_dequeued(0)
+    ,num_dqbuf_calls(0)
+    ,eagain_left(0)
+    ,is_stalled(false)
+    ,random(1)
+  {
+  }
+
+  V4L2_FakeDevice::~V4L2_FakeDevice() {
+    streamOff();
+    freeBuffers();
+    pattern.shutdown();
+  }
+
+  int V4L2_FakeDevice::init(const V4L2_FakeSettings& cfg) {
+
+    if (0 != fds.size()) {
+      printf("Error: cannot initialize the fake V4L2 device while it's open.\n");
+      return -1;
+    }
+
+    if (0 == cfg.formats.size()) {
+      printf("Error: the fake V4L2 device needs at least one format.\n");
+      return -2;
+    }
+
+    /* The chroma rows of planar formats are half as long, padding included. */
+    if (0 != (cfg.padding & 1) || 2 > cfg.max_buffers) {
+      printf("Error: invalid fake V4L2 settings; the padding must be even and max_buffers >= 2.\n");
+      return -3;
+    }
+
+    if (CA_V4L2_FAKE_STALL_STREAMOFF > cfg.stall_until || CA_V4L2_FAKE_STALL_NEVER < cfg.stall_until) {
+      printf("Error: invalid fake V4L2 settings; stall_until must be one of CA_V4L2_FAKE_STALL_*.\n");
+      return -7;
+    }
+
+    for (size_t i = 0; i < cfg.formats.size(); ++i) {
+
+      const V4L2_FakeFormat& f = cfg.formats[i];
+      PixelBuffer layout;
+
+      if (0 >= f.width || 0 >= f.height || 0 == f.numerator || 0 == f.denominator) {
+        printf("Error: invalid fake V4L2 format %d: %dx%d @ %u/%u.\n", (int)i, f.width, f.height, f.numerator, f.denominator);
+        return -4;
+      }
+
+      if (true == v4l2_fake_is_compressed(f.pixel_format)) {
+        if (true == cfg.fill_frames && 0 == cfg.compressed_frame.size()) {
+          printf("Error: the fake V4L2 device needs a `compressed_frame` for %s.\n", v4l2_pixel_format_to_string(f.pixel_format).c_str());
+          return -5;
+        }
+      }
+      else if (0 != v4l2_fake_get_layout(f.pixel_format, f.width, f.height, cfg.padding, layout)) {
+        printf("Error: the fake V4L2 device doesn't support %s.\n", v4l2_pixel_format_to_string(f.pixel_format).c_str());
+        return -6;
+      }
+    }
+
+    settings = cfg;
+    current = 0;
+    is_stalled = false;
+    random = (0 == cfg.seed) ? 1 : cfg.seed;
+
+    return 0;
+  }
+
+  void V4L2_FakeDevice::advanceClock(uint64_t ns) {
+    clock += ns;
+  }
+
+  /* V4L2_Backend */
+  /* -------------------------------------- */
+
+  std::vector<V4L2_Device> V4L2_FakeDevice::getDevices() {
+
+    std::vector<V4L2_Device> result;
+    V4L2_Device dev;
+
+    if (0 == settings.formats.size()) {
+      return result;
+    }
+
+    dev.path = settings.path;
+    dev.driver = "v4l2_fake";
+    dev.card = settings.card;
+    dev.bus_info = "fake:0";
+    result.push_back(dev);
+
+    return result;
+  }
+
+  int V4L2_FakeDevice::open(const char* path, int flags) {
+
+    (void)flags;
+
+    if (NULL == path || 0 == settings.formats.size() || settings.path != path) {
+      return fail(ENOENT);
+    }
+
+    fds.push_back(next_fd);
+
+    return next_fd++;
+  }
+
+  int V4L2_FakeDevice::close(int fd) {
+
+    for (size_t i = 0; i < fds.size(); ++i) {
+
+      if (fds[i] != fd) {
+        continue;
+      }
+
+      fds.erase(fds.begin() + i);
+
+      if (fd == owner_fd) {
+        streamOff();
+        freeBuffers();
+      }
+
+      if (0 == fds.size() && CA_V4L2_FAKE_STALL_CLOSE >= settings.stall_until) {
+        is_stalled = false;
+      }
+
+      return 0;
+    }
+
+    return fail(EBADF);
+  }
+
+  int V4L2_FakeDevice::ioctl(int fd, unsigned long request, void* arg) {
+
+    bool is_open = false;
+
+    for (size_t i = 0; i < fds.size(); ++i) {
+      if (fds[i] == fd) {
+        is_open = true;
+        break;
+      }
+    }
+
+    if (false == is_open) {
+      return fail(EBADF);
+    }
+
+    if (NULL == arg) {
+      return fail(EFAULT);
+    }
+
+    switch (request) {
+
+      case VIDIOC_QUERYCAP: {
+        struct v4l2_capability* cap = (struct v4l2_capability*)arg;
+        memset(cap, 0, sizeof(*cap));
+        strncpy((char*)cap->driver, "v4l2_fake", sizeof(cap->driver) - 1);
+        strncpy((char*)cap->card, settings.card.c_str(), sizeof(cap->card) - 1);
+        strncpy((char*)cap->bus_info, "fake:0", sizeof(cap->bus_info) - 1);
+        cap->version = (1 << 16);
+        cap->device_caps = V4L2_CAP_VIDEO_CAPTURE | V4L2_CAP_STREAMING;
+        cap->capabilities = cap->device_caps | V4L2_CAP_DEVICE_CAPS;
+        return 0;
+      }
+
+      case VIDIOC_ENUM_FMT: {
+        struct v4l2_fmtdesc* desc = (struct v4l2_fmtdesc*)arg;
+        std::vector<uint32_t> unique;
+        if (V4L2_BUF_TYPE_VIDEO_CAPTURE != desc->type) {
+          return fail(EINVAL);
+        }
+        for (size_t i = 0; i < settings.formats.size(); ++i) {
+          uint32_t pixfmt = settings.formats[i].pixel_format;
+          if (unique.end() == std::find(unique.begin(), unique.end(), pixfmt)) {
+            unique.push_back(pixfmt);
+          }
+        }
+        if (desc->index >= unique.size()) {
+          return fail(EINVAL);
+        }
+        desc->pixelformat = unique[desc->index];
+        desc->flags = (true == v4l2_fake_is_compressed(desc->pixelformat)) ? V4L2_FMT_FLAG_COMPRESSED : 0;
+        strncpy((char*)desc->description, v4l2_pixel_format_to_string(desc->pixelformat).c_str(), sizeof(desc->description) - 1);
+        return 0;
+      }
+
+      case VIDIOC_ENUM_FRAMESIZES: {
+        struct v4l2_frmsizeenum* size = (struct v4l2_frmsizeenum*)arg;
+        std::vector<std::pair<int, int> > unique;
+        for (size_t i = 0; i < settings.formats.size(); ++i) {
+          const V4L2_FakeFormat& f = settings.formats[i];
+          std::pair<int, int> wh(f.width, f.height);
+          if (f.pixel_format == size->pixel_format && unique.end() == std::find(unique.begin(), unique.end(), wh)) {
+            unique.push_back(wh);
+          }
+        }
+        if (size->index >= unique.size()) {
+          return fail(EINVAL);
+        }
+        size->type = V4L2_FRMSIZE_TYPE_DISCRETE;
+        size->discrete.width = unique[size->index].first;
+        size->discrete.height = unique[size->index].second;
+        return 0;
+      }
+
+      case VIDIOC_ENUM_FRAMEINTERVALS: {
+        struct v4l2_frmivalenum* ival = (struct v4l2_frmivalenum*)arg;
+        uint32_t n = 0;
+        for (size_t i = 0; i < settings.formats.size(); ++i) {
+          const V4L2_FakeFormat& f = settings.formats[i];
+          if (f.pixel_format != ival->pixel_format || (uint32_t)f.width != ival->width || (uint32_t)f.height != ival->height) {
+            continue;
+          }
+          if (n++ == ival->index) {
+            ival->type = V4L2_FRMIVAL_TYPE_DISCRETE;
+            ival->discrete.numerator = f.numerator;
+            ival->discrete.denominator = f.denominator;
+            return 0;
+          }
+        }
+        return fail(EINVAL);
+      }
+
+      case VIDIOC_G_FMT: {
+        struct v4l2_format* fmt = (struct v4l2_format*)arg;
+        const V4L2_FakeFormat& f = settings.formats[current];
+        if (V4L2_BUF_TYPE_VIDEO_CAPTURE != fmt->type) {
+          return fail(EINVAL);
+        }
+        fmt->fmt.pix.width = f.width;
+        fmt->fmt.pix.height = f.height;
+        fmt->fmt.pix.pixelformat = f.pixel_format;
+        return setFormat(fmt, false);
+      }
+
+      case VIDIOC_TRY_FMT: {
+        return setFormat((struct v4l2_format*)arg, false);
+      }
+
+      case VIDIOC_S_FMT: {
+        return setFormat((struct v4l2_format*)arg, true);
+      }
+
+      case VIDIOC_REQBUFS: {
+        return requestBuffers(fd, (struct v4l2_requestbuffers*)arg);
+      }
+
+      case VIDIOC_QUERYBUF: {
+        struct v4l2_buffer* buf = (struct v4l2_buffer*)arg;
+        if (buf->index >= buffers.size()) {
+          return fail(EINVAL);
+        }
+        *buf = buffers[buf->index]->info;
+        return 0;
+      }
+
+      case VIDIOC_QBUF: {
+        struct v4l2_buffer* buf = (struct v4l2_buffer*)arg;
+        if (fd != owner_fd || buf->index >= buffers.size() || true == buffers[buf->index]->is_queued) {
+          return fail(EINVAL);
+        }
+        buffers[buf->index]->is_queued = true;
+        buffers[buf->index]->info.flags = V4L2_BUF_FLAG_MAPPED | V4L2_BUF_FLAG_QUEUED;
+        queued.push_back(buf->index);
+        return 0;
+      }
+
+      case VIDIOC_DQBUF: {
+        if (fd != owner_fd) {
+          return fail(EINVAL);
+        }
+        return dequeueBuffer((struct v4l2_buffer*)arg);
+      }
+
+      case VIDIOC_STREAMON: {
+        if (fd != owner_fd || 0 == buffers.size()) {
+          return fail(EINVAL);
+        }
+        if (true == is_streaming) {
+          return 0;
+        }
+        is_streaming = true;
+        stream_start = now();
+        num_captured = 0;
+        num_dropped = 0;
+        num_dequeued = 0;
+        num_dqbuf_calls = 0;
+        eagain_left = 0;
+        next_capture = stream_start + interval + ((0 == settings.jitter) ? 0 : (random % (settings.jitter + 1)));
+        return 0;
+      }
+
+      case VIDIOC_STREAMOFF: {
+        if (fd != owner_fd) {
+          return fail(EINVAL);
+        }
+        streamOff();
+        if (CA_V4L2_FAKE_STALL_STREAMOFF >= settings.stall_until) {
+          is_stalled = false;
+        }
+        return 0;
+      }
+
+      default: {
+        return fail(ENOTTY);
+      }
+    }
+  }
+
+  void* V4L2_FakeDevice::mmap(size_t length, int prot, int flags, int fd, off_t offset) {
+
+    (void)prot;
+    (void)flags;
+
+    if (fd != owner_fd) {
+      errno = EBADF;
+      return MAP_FAILED;
+    }
+
+    for (size_t i = 0; i < buffers.size(); ++i) {
+      if ((off_t)buffers[i]->info.m.offset == offset && length <= buffers[i]->data.size()) {
+        return &buffers[i]->data[0];
+      }
+    }
+
+    errno = EINVAL;
+    return MAP_FAILED;
+  }
+
+  /* The memory belongs to the buffers; it's freed with REQBUFS(0) or close(). */
+  int V4L2_FakeDevice::munmap(void* addr, size_t length) {
+
+    (void)addr;
+    (void)length;
+
+    return 0;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  int V4L2_FakeDevice::fail(int err) {
+    errno = err;
+    return -1;
+  }
+
+  uint64_t V4L2_FakeDevice::now() {
+    return (true == settings.manual_clock) ? clock : time_now_ns();
+  }
+
+  /* Like a driver we adjust a size we don't have to one we do; an unknown pixel format is an error. */
+  int V4L2_FakeDevice::setFormat(struct v4l2_format* fmt, bool apply) {
+
+    int found = -1;
+    PixelBuffer layout;
+
+    if (V4L2_BUF_TYPE_VIDEO_CAPTURE != fmt->type) {
+      return fail(EINVAL);
+    }
+
+    for (size_t i = 0; i < settings.formats.size(); ++i) {
+
+      const V4L2_FakeFormat& f = settings.formats[i];
+
+      if (f.pixel_format != fmt->fmt.pix.pixelformat) {
+        continue;
+      }
+
+      if ((uint32_t)f.width == fmt->fmt.pix.width && (uint32_t)f.height == fmt->fmt.pix.height) {
+        found = (int)i;
+        break;
+      }
+
+      if (0 > found) {
+        found = (int)i;
+      }
+    }
+
+    if (0 > found) {
+      return fail(EINVAL);
+    }
+
+    if (true == apply && 0 != buffers.size()) {
+      return fail(EBUSY);
+    }
+
+    const V4L2_FakeFormat& f = settings.formats[found];
+
+    fmt->fmt.pix.width = f.width;
+    fmt->fmt.pix.height = f.height;
+    fmt->fmt.pix.field = V4L2_FIELD_NONE;
+
+    if (true == v4l2_fake_is_compressed(f.pixel_format)) {
+      fmt->fmt.pix.bytesperline = 0;
+      fmt->fmt.pix.sizeimage = (uint32_t)(f.width * f.height * 2);
+      if (fmt->fmt.pix.sizeimage < settings.compressed_frame.size()) {
+        fmt->fmt.pix.sizeimage = (uint32_t)settings.compressed_frame.size();
+      }
+    }
+    else {
+      v4l2_fake_get_layout(f.pixel_format, f.width, f.height, settings.padding, layout);
+      fmt->fmt.pix.bytesperline = (uint32_t)layout.stride[0];
+      fmt->fmt.pix.sizeimage = (uint32_t)layout.nbytes;
+    }
+
+    if (false == apply) {
+      return 0;
+    }
+
+    current = found;
+    bytes_per_line = fmt->fmt.pix.bytesperline;
+    size_image = fmt->fmt.pix.sizeimage;
+    interval = ((uint64_t)f.numerator * 1000000000ull) / f.denominator;
+
+    /* Raw frames show a moving gradient with the sequence number as frame counter. */
+    pattern.shutdown();
+
+    if (false == v4l2_fake_is_compressed(f.pixel_format)) {
+      pattern.init(CA_PATTERN_GRADIENT, f.width, f.height, v4l2_pixel_format_to_capture_format(f.pixel_format));
+    }
+
+    return 0;
+  }
+
+  int V4L2_FakeDevice::requestBuffers(int fd, struct v4l2_requestbuffers* req) {
+
+    uint32_t count = req->count;
+    uint32_t length = (size_image + 4095) & ~4095u;
+
+    if (V4L2_BUF_TYPE_VIDEO_CAPTURE != req->type || V4L2_MEMORY_MMAP != req->memory) {
+      return fail(EINVAL);
+    }
+
+    if (true == is_streaming || (0 <= owner_fd && fd != owner_fd)) {
+      return fail(EBUSY);
+    }
+
+    freeBuffers();
+
+    if (CA_V4L2_FAKE_STALL_REQBUFS >= settings.stall_until) {
+      is_stalled = false;
+    }
+
+    if (0 == count) {
+      return 0;
+    }
+
+    if (count > settings.max_buffers) {
+      count = settings.max_buffers;
+    }
+
+    if (2 > count) {
+      count = 2;
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+      V4L2_FakeBuffer* buf = new V4L2_FakeBuffer();
+      buf->data.resize(size_image);
+      memset(&buf->info, 0, sizeof(buf->info));
+      buf->info.index = i;
+      buf->info.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+      buf->info.memory = V4L2_MEMORY_MMAP;
+      buf->info.length = size_image;
+      buf->info.m.offset = i * length;
+      buf->info.flags = V4L2_BUF_FLAG_MAPPED;
+      buf->is_queued = false;
+      buffers.push_back(buf);
+    }
+
+    owner_fd = fd;
+    req->count = count;
+
+    return 0;
+  }
+
+  int V4L2_FakeDevice::dequeueBuffer(struct v4l2_buffer* buf) {
+
+    if (false == is_streaming) {
+      return fail(EINVAL);
+    }
+
+    num_dqbuf_calls++;
+
+    if (0 != settings.eio_period && 0 == (num_dqbuf_calls % settings.eio_period)) {
+      return fail(EIO);
+    }
+
+    if (0 < eagain_left) {
+      eagain_left--;
+      return fail(EAGAIN);
+    }
+
+    if (0 != settings.eagain_period && 0 != settings.eagain_burst && 0 == (num_dqbuf_calls % settings.eagain_period)) {
+      eagain_left = settings.eagain_burst - 1;
+      return fail(EAGAIN);
+    }
+
+    capture();
+
+    if (0 == done.size()) {
+      return fail(EAGAIN);
+    }
+
+    V4L2_FakeBuffer* fb = buffers[done.front()];
+    done.pop_front();
+
+    fb->is_queued = false;
+    fb->info.flags &= ~V4L2_BUF_FLAG_DONE;
+    *buf = fb->info;
+    num_dequeued++;
+
+    return 0;
+  }
+
+  void V4L2_FakeDevice::capture() {
+
+    uint64_t t = now();
+
+    while (true == is_streaming && next_capture <= t) {
+
+      /* A stalled device doesn't capture, nor drop; time just passes. */
+      if (0 != settings.stall_after && num_captured >= settings.stall_after) {
+        is_stalled = true;
+      }
+
+      if (true == is_stalled) {
+        break;
+      }
+
+      uint64_t sequence = num_captured;
+
+      if (0 == queued.size()) {
+        num_dropped++;
+      }
+      else {
+
+        V4L2_FakeBuffer* fb = buffers[queued.front()];
+        queued.pop_front();
+
+        if (true == settings.fill_frames) {
+          fillBuffer(*fb, sequence);
+        }
+
+        fb->info.sequence = (uint32_t)sequence;
+        fb->info.timestamp.tv_sec = next_capture / 1000000000ull;
+        fb->info.timestamp.tv_usec = (next_capture % 1000000000ull) / 1000ull;
+        fb->info.field = V4L2_FIELD_NONE;
+        fb->info.bytesused = (true == v4l2_fake_is_compressed(settings.formats[current].pixel_format)) ? (uint32_t)settings.compressed_frame.size() : size_image;
+        fb->info.flags = V4L2_BUF_FLAG_MAPPED | V4L2_BUF_FLAG_DONE | V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC;
+
+        if (0 != settings.error_period && 0 == ((sequence + 1) % settings.error_period)) {
+          fb->info.flags |= V4L2_BUF_FLAG_ERROR;
+        }
+
+        done.push_back(fb->info.index);
+      }
+
+      num_captured++;
+
+      /* The next frame; jitter only delays frames, and never before the previous one. */
+      uint64_t next = stream_start + (num_captured + 1) * interval;
+
+      if (0 != settings.jitter) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        next += random % (settings.jitter + 1);
+      }
+
+      next_capture = (next > next_capture) ? next : next_capture;
+    }
+  }
+
+  void V4L2_FakeDevice::fillBuffer(V4L2_FakeBuffer& buffer, uint64_t sequence) {
+
+    const V4L2_FakeFormat& f = settings.formats[current];
+    PixelBuffer src;
+    PixelBuffer dst;
+    PixelBuffer tight;
+
+    if (true == v4l2_fake_is_compressed(f.pixel_format)) {
+      memcpy(&buffer.data[0], &settings.compressed_frame[0], settings.compressed_frame.size());
+      return;
+    }
+
+    if (0 != pattern.nextFrame((uint32_t)sequence, src)
+        || 0 != v4l2_fake_get_layout(f.pixel_format, f.width, f.height, settings.padding, dst)
+        || 0 != tight.setup(f.width, f.height, src.pixel_format))
+      {
+        return;
+      }
+
+    dst.setPixels(&buffer.data[0]);
+
+    for (int i = 0; i < 3; ++i) {
+
+      if (0 == dst.stride[i]) {
+        continue;
+      }
+
+      size_t rows = (0 == dst.height[i]) ? dst.height[0] : dst.height[i];
+
+      for (size_t r = 0; r < rows; ++r) {
+        memcpy(dst.plane[i] + r * dst.stride[i], src.plane[i] + r * src.stride[i], tight.stride[i]);
+      }
+    }
+  }
+
+  void V4L2_FakeDevice::streamOff() {
+
+    is_streaming = false;
+    queued.clear();
+    done.clear();
+
+    for (size_t i = 0; i < buffers.size(); ++i) {
+      buffers[i]->is_queued = false;
+      buffers[i]->info.flags = V4L2_BUF_FLAG_MAPPED;
+    }
+  }
+
+  void V4L2_FakeDevice::freeBuffers() {
+
+    for (size_t i = 0; i < buffers.size(); ++i) {
+      delete buffers[i];
+    }
+
+    buffers.clear();
+    queued.clear();
+    done.clear();
+    owner_fd = -1;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  static bool v4l2_fake_is_compressed(uint32_t pixfmt) {
+    return V4L2_PIX_FMT_MJPEG == pixfmt || V4L2_PIX_FMT_H264 == pixfmt;
+  }
+
+  /* The layout of a raw V4L2 frame: the planes follow each other and the chroma rows are padded like the luma rows. */
+  static int v4l2_fake_get_layout(uint32_t pixfmt, int width, int height, uint32_t padding, PixelBuffer& layout) {
+
+    int fmt = v4l2_pixel_format_to_capture_format(pixfmt);
+
+    if (CA_NONE == fmt || true == v4l2_fake_is_compressed(pixfmt) || 0 != layout.setup(width, height, fmt)) {
+      return -1;
+    }
+
+    size_t tight = layout.stride[0];
+    size_t offset = 0;
+
+    for (int i = 0; i < 3; ++i) {
+
+      if (0 == layout.stride[i]) {
+        continue;
+      }
+
+      size_t rows = (0 == layout.height[i]) ? layout.height[0] : layout.height[i];
+
+      layout.stride[i] = (layout.stride[i] * (tight + padding)) / tight;
+      layout.offset[i] = offset;
+      offset += layout.stride[i] * rows;
+    }
+
+    layout.nbytes = offset;
+
+    return 0;
+  }
+
+} /* namespace ca */
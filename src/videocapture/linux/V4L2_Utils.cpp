@@ -7,8 +7,10 @@ namespace ca {
     switch(fmt) {
       case CA_RGB24:       return V4L2_PIX_FMT_RGB24;
       case CA_YUYV422:     return V4L2_PIX_FMT_YUYV;
+      case CA_UYVY422:     return V4L2_PIX_FMT_UYVY;
       case CA_YUV420P:     return V4L2_PIX_FMT_YUV420;
       case CA_YUV422P:     return V4L2_PIX_FMT_YUV422P;
+      case CA_YUV420BP:    return V4L2_PIX_FMT_NV12;
       case CA_H264:        return V4L2_PIX_FMT_H264;
       case CA_MJPEG:       return V4L2_PIX_FMT_MJPEG;
       default:             return CA_NONE;
@@ -19,8 +21,10 @@ namespace ca {
     switch(fmt) {
       case V4L2_PIX_FMT_RGB24:           return CA_RGB24;
       case V4L2_PIX_FMT_YUYV:            return CA_YUYV422;
+      case V4L2_PIX_FMT_UYVY:            return CA_UYVY422;
       case V4L2_PIX_FMT_YUV420:          return CA_YUV420P;
       case V4L2_PIX_FMT_YUV422P:         return CA_YUV422P; 
+      case V4L2_PIX_FMT_NV12:            return CA_YUV420BP;
       case V4L2_PIX_FMT_H264:            return CA_H264; 
       case V4L2_PIX_FMT_MJPEG:           return CA_MJPEG; 
       default:                           return CA_NONE;
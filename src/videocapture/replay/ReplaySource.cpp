@@ -0,0 +1,644 @@
+/* 64 bit file offsets for fseeko() on 32 bit Linux (e.g. the Raspberry PI). */
+#if !defined(_WIN32) && !defined(_FILE_OFFSET_BITS)
+#  define _FILE_OFFSET_BITS 64
+#endif
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <videocapture/Utils.h>
+#include <videocapture/JpegMarkers.h>
+#include <videocapture/replay/ReplaySource.h>
+
+#define MJPEG_READ_SIZE (1024 * 1024)                                               /* The initial size of the read buffer of `MjpegFileSource`; it grows to fit the largest frame. */
+#define MJPEG_MAX_FRAME_SIZE (64 * 1024 * 1024)                                     /* We give up on a frame without EOI when it grows beyond this. */
+#define Y4M_MAX_LINE 1024                                                           /* The longest header line we accept. */
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  static int replay_seek(FILE* fp, uint64_t offset);
+  static int replay_read_line(FILE* fp, std::string& line);
+  static int replay_fps_from_rate(uint64_t num, uint64_t den);
+
+  /* ------------------------------------------------------------------------- */
+
+  ReplaySource::ReplaySource()
+    :width(0)
+    ,height(0)
+    ,pixel_format(CA_NONE)
+    ,fps(CA_NONE)
+  {
+  }
+
+  ReplaySource::~ReplaySource() {
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  FrameFileSource::FrameFileSource()
+    :next_index(0)
+  {
+  }
+
+  FrameFileSource::~FrameFileSource() {
+    close();
+  }
+
+  int FrameFileSource::open(const std::string& filepath) {
+
+    if (0 != reader.open(filepath)) {
+      return -1;
+    }
+
+    const FrameFileHeader& hdr = reader.getHeader();
+
+    width = hdr.width;
+    height = hdr.height;
+    pixel_format = hdr.pixel_format;
+    fps = (0 < hdr.fps) ? hdr.fps : CA_FPS_30_00;
+    next_index = 0;
+
+    return 0;
+  }
+
+  int FrameFileSource::close() {
+
+    if (0 == width) {
+      return 0;
+    }
+
+    reader.close();
+    width = 0;
+    height = 0;
+
+    return 0;
+  }
+
+  int FrameFileSource::rewind() {
+    next_index = 0;
+    return 0;
+  }
+
+  int FrameFileSource::readFrame(PixelBuffer& buffer) {
+
+    if (next_index >= reader.getNumFrames()) {
+      return 1;
+    }
+
+    /* Read ahead a bit so the pages are there when the frame after this one is processed. */
+    if (true == reader.isZeroCopy()) {
+      reader.prefetch(next_index + 1, 2);
+    }
+
+    if (0 != reader.readFrame(next_index, buffer)) {
+      return -1;
+    }
+
+    next_index++;
+
+    return 0;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  Y4mSource::Y4mSource()
+    :fp(NULL)
+    ,data_offset(0)
+    ,frame_duration(0)
+    ,next_index(0)
+  {
+  }
+
+  Y4mSource::~Y4mSource() {
+    close();
+  }
+
+  int Y4mSource::open(const std::string& filepath) {
+
+    std::string line;
+    PixelBuffer layout;
+
+    fp = fopen(filepath.c_str(), "rb");
+    if (NULL == fp) {
+      printf("Error: cannot open %s.\n", filepath.c_str());
+      return -1;
+    }
+
+    if (0 != replay_read_line(fp, line) || 0 != parseHeader(line)) {
+      printf("Error: %s is not a YUV4MPEG2 file we can read.\n", filepath.c_str());
+      close();
+      return -2;
+    }
+
+    if (0 != layout.setup(width, height, pixel_format)) {
+      close();
+      return -3;
+    }
+
+    frame.resize(layout.nbytes);
+    data_offset = (uint64_t)ftell(fp);
+    next_index = 0;
+
+    return 0;
+  }
+
+  int Y4mSource::close() {
+
+    if (NULL != fp) {
+      fclose(fp);
+      fp = NULL;
+    }
+
+    frame.clear();
+
+    return 0;
+  }
+
+  int Y4mSource::rewind() {
+
+    if (NULL == fp) {
+      return -1;
+    }
+
+    next_index = 0;
+
+    return replay_seek(fp, data_offset);
+  }
+
+  int Y4mSource::readFrame(PixelBuffer& buffer) {
+
+    std::string line;
+
+    if (NULL == fp) {
+      return -1;
+    }
+
+    if (0 != replay_read_line(fp, line)) {
+      return 1;
+    }
+
+    if (0 != line.compare(0, 5, "FRAME")) {
+      printf("Error: expected a FRAME header in the YUV4MPEG2 file.\n");
+      return -2;
+    }
+
+    /* A cut off frame is the end of the file. */
+    if (frame.size() != fread(&frame[0], 1, frame.size(), fp)) {
+      return 1;
+    }
+
+    if (0 != buffer.setup(width, height, pixel_format) || 0 != buffer.setPixels(&frame[0])) {
+      return -3;
+    }
+
+    buffer.sequence = next_index;
+    buffer.timestamp = next_index * frame_duration;
+    next_index++;
+
+    return 0;
+  }
+
+  int Y4mSource::parseHeader(const std::string& line) {
+
+    uint64_t rate_num = 30;
+    uint64_t rate_den = 1;
+    size_t pos = 0;
+
+    if (0 != line.compare(0, 9, "YUV4MPEG2")) {
+      return -1;
+    }
+
+    width = 0;
+    height = 0;
+    pixel_format = CA_YUV420P;
+
+    /* The parameters are separated by spaces and start with a letter that tells what they are. */
+    while (std::string::npos != (pos = line.find(' ', pos))) {
+
+      std::string param;
+      size_t end = line.find(' ', pos + 1);
+
+      param = line.substr(pos + 1, (std::string::npos == end) ? std::string::npos : end - pos - 1);
+      pos = pos + 1;
+
+      if (true == param.empty()) {
+        continue;
+      }
+
+      switch (param[0]) {
+
+        case 'W': {
+          width = atoi(param.c_str() + 1);
+          break;
+        }
+
+        case 'H': {
+          height = atoi(param.c_str() + 1);
+          break;
+        }
+
+        case 'F': {
+          unsigned long long num = 0;
+          unsigned long long den = 0;
+          if (2 == sscanf(param.c_str() + 1, "%llu:%llu", &num, &den) && 0 != num && 0 != den) {
+            rate_num = num;
+            rate_den = den;
+          }
+          break;
+        }
+
+        case 'C': {
+          /* 420, 420jpeg, 420mpeg2 and 420paldv only differ in chroma siting; 420p10 etc. have more than 8 bits. */
+          if (0 == param.compare(1, 3, "420") && (5 >= param.size() || 'p' != param[4] || 0 == isdigit(param[5]))) {
+            pixel_format = CA_YUV420P;
+          }
+          else if (param == "C422") {
+            pixel_format = CA_YUV422P;
+          }
+          else {
+            printf("Error: we can't replay YUV4MPEG2 files with colorspace %s.\n", param.c_str() + 1);
+            return -2;
+          }
+          break;
+        }
+
+        case 'I': {
+          if (param != "Ip" && param != "I?") {
+            printf("Warning: the YUV4MPEG2 file is interlaced; we replay the frames as they are.\n");
+          }
+          break;
+        }
+
+        default: {
+          break;
+        }
+      }
+    }
+
+    if (0 >= width || 0 >= height || 0 != (width & 1) || 0 != (height & 1)) {
+      printf("Error: invalid YUV4MPEG2 frame size %d x %d; we need an even width and height.\n", width, height);
+      return -3;
+    }
+
+    fps = replay_fps_from_rate(rate_num, rate_den);
+    frame_duration = (rate_den * 1000000000ull) / rate_num;
+
+    return 0;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  MjpegFileSource::MjpegFileSource()
+    :fp(NULL)
+    ,data_start(0)
+    ,data_end(0)
+    ,frame_nbytes(0)
+    ,frame_duration(0)
+    ,next_index(0)
+  {
+  }
+
+  MjpegFileSource::~MjpegFileSource() {
+    close();
+  }
+
+  int MjpegFileSource::open(const std::string& filepath) {
+
+    JpegMarkerInfo info;
+    size_t nbytes = 0;
+
+    fp = fopen(filepath.c_str(), "rb");
+    if (NULL == fp) {
+      printf("Error: cannot open %s.\n", filepath.c_str());
+      return -1;
+    }
+
+    data.resize(MJPEG_READ_SIZE);
+    data_start = 0;
+    data_end = 0;
+    frame_nbytes = 0;
+
+    /* The size of the frames comes from the first one. */
+    if (0 != findFrame(nbytes) || 0 != jpeg_scan_markers(&data[data_start], nbytes, info)) {
+      printf("Error: %s doesn't start with a JPEG frame we can read.\n", filepath.c_str());
+      close();
+      return -2;
+    }
+
+    width = info.width;
+    height = info.height;
+    pixel_format = CA_MJPEG;
+    fps = CA_FPS_30_00;
+    frame_duration = 1000000000ull * 100ull / (uint64_t)fps;
+
+    return rewind();
+  }
+
+  int MjpegFileSource::close() {
+
+    if (NULL != fp) {
+      fclose(fp);
+      fp = NULL;
+    }
+
+    data.clear();
+    data_start = 0;
+    data_end = 0;
+
+    return 0;
+  }
+
+  int MjpegFileSource::rewind() {
+
+    if (NULL == fp) {
+      return -1;
+    }
+
+    data_start = 0;
+    data_end = 0;
+    frame_nbytes = 0;
+    next_index = 0;
+
+    return replay_seek(fp, 0);
+  }
+
+  int MjpegFileSource::readFrame(PixelBuffer& buffer) {
+
+    size_t nbytes = 0;
+    int r = 0;
+
+    if (NULL == fp) {
+      return -1;
+    }
+
+    /* The frame we handed out last time is done. */
+    data_start += frame_nbytes;
+    frame_nbytes = 0;
+
+    r = findFrame(nbytes);
+    if (0 != r) {
+      return r;
+    }
+
+    frame_nbytes = nbytes;
+
+    for (int i = 0; i < 3; ++i) {
+      buffer.plane[i] = NULL;
+      buffer.stride[i] = 0;
+      buffer.width[i] = 0;
+      buffer.height[i] = 0;
+      buffer.offset[i] = 0;
+    }
+
+    buffer.pixel_format = CA_MJPEG;
+    buffer.width[0] = width;
+    buffer.height[0] = height;
+    buffer.pixels = &data[data_start];
+    buffer.plane[0] = buffer.pixels;
+    buffer.nbytes = nbytes;
+    buffer.sequence = next_index;
+    buffer.timestamp = next_index * frame_duration;
+    next_index++;
+
+    return 0;
+  }
+
+  /* Walks the marker segments so an FFD9 inside e.g. an EXIF thumbnail isn't taken for the end of the frame. */
+  int MjpegFileSource::findFrame(size_t& nbytes) {
+
+    size_t pos = 0;
+
+  restart:
+
+    /* Skip anything up to the next SOI. */
+    while (true) {
+
+      const uint8_t* p = &data[data_start];
+      size_t avail = data_end - data_start;
+      size_t i = 0;
+
+      for (i = 0; i + 1 < avail; ++i) {
+        if (0xFF == p[i] && 0xD8 == p[i + 1]) {
+          break;
+        }
+      }
+
+      data_start += i;
+
+      if (i + 1 < avail) {
+        break;
+      }
+
+      if (false == fill()) {
+        return 1;
+      }
+    }
+
+    pos = 2;
+
+    while (true) {
+
+      int marker = 0;
+
+      if (MJPEG_MAX_FRAME_SIZE < pos) {
+        printf("Warning: a frame in the MJPEG file has no end; looking for the next frame.\n");
+        data_start += 2;
+        goto restart;
+      }
+
+      /* The EOI can be the last two bytes of the file; other markers have a length after them. */
+      while (data_end - data_start < pos + 2) {
+        if (false == fill()) {
+          return 1;
+        }
+      }
+
+      if (0xD9 != data[data_start + pos + 1]) {
+        while (data_end - data_start < pos + 4) {
+          if (false == fill()) {
+            return 1;
+          }
+        }
+      }
+
+      const uint8_t* p = &data[data_start];
+
+      if (0xFF != p[pos]) {
+        printf("Warning: invalid JPEG segment in the MJPEG file; looking for the next frame.\n");
+        data_start += 2;
+        goto restart;
+      }
+
+      marker = p[pos + 1];
+
+      if (0xFF == marker) {
+        pos++;
+        continue;
+      }
+
+      if (0xD9 == marker) {
+        nbytes = pos + 2;
+        return 0;
+      }
+
+      if (0x01 == marker || (0xD0 <= marker && 0xD7 >= marker)) {
+        pos += 2;
+        continue;
+      }
+
+      pos += 2 + (((size_t)p[pos + 2] << 8) | p[pos + 3]);
+
+      if (0xDA != marker) {
+        continue;
+      }
+
+      /* The entropy coded data ends at the first marker that isn't a stuffed 0xFF or a restart marker. */
+      while (true) {
+
+        while (data_end - data_start < pos + 2) {
+          if (false == fill()) {
+            return 1;
+          }
+        }
+
+        const uint8_t* q = &data[data_start];
+        const uint8_t* ff = (const uint8_t*)memchr(q + pos, 0xFF, data_end - data_start - pos - 1);
+
+        if (NULL == ff) {
+          pos = data_end - data_start - 1;
+          if (MJPEG_MAX_FRAME_SIZE < pos) {
+            break;
+          }
+          continue;
+        }
+
+        pos = ff - q;
+
+        if (0x00 == ff[1] || (0xD0 <= ff[1] && 0xD7 >= ff[1])) {
+          pos += 2;
+          continue;
+        }
+
+        break;
+      }
+    }
+
+    return 1;
+  }
+
+  bool MjpegFileSource::fill() {
+
+    size_t n = 0;
+
+    if (0 < data_start) {
+      memmove(&data[0], &data[data_start], data_end - data_start);
+      data_end -= data_start;
+      data_start = 0;
+    }
+
+    if (data_end == data.size()) {
+      data.resize(data.size() * 2);
+    }
+
+    n = fread(&data[data_end], 1, data.size() - data_end, fp);
+    data_end += n;
+
+    return 0 != n;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  ReplaySource* replay_source_create(const std::string& filepath) {
+
+    ReplaySource* source = NULL;
+    uint8_t magic[9] = { 0 };
+    FILE* fp = fopen(filepath.c_str(), "rb");
+
+    if (NULL == fp) {
+      printf("Error: cannot open %s for replay.\n", filepath.c_str());
+      return NULL;
+    }
+
+    if (sizeof(magic) != fread(magic, 1, sizeof(magic), fp)) {
+      memset(magic, 0x00, sizeof(magic));
+    }
+
+    fclose(fp);
+
+    if (0 == memcmp(magic, CA_FRAME_FILE_MAGIC, 8)) {
+      source = new FrameFileSource();
+    }
+    else if (0 == memcmp(magic, "YUV4MPEG2", 9)) {
+      source = new Y4mSource();
+    }
+    else if (0xFF == magic[0] && 0xD8 == magic[1]) {
+      source = new MjpegFileSource();
+    }
+    else {
+      printf("Error: %s is not a frame file, YUV4MPEG2 or MJPEG file.\n", filepath.c_str());
+      return NULL;
+    }
+
+    if (0 != source->open(filepath)) {
+      delete source;
+      return NULL;
+    }
+
+    return source;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  static int replay_seek(FILE* fp, uint64_t offset) {
+
+#if defined(_WIN32)
+    int r = _fseeki64(fp, (__int64)offset, SEEK_SET);
+#else
+    int r = fseeko(fp, (off_t)offset, SEEK_SET);
+#endif
+
+    if (0 != r) {
+      printf("Error: cannot seek to %llu.\n", (unsigned long long)offset);
+      return -1;
+    }
+
+    return 0;
+  }
+
+  /* Reads up to and without the newline. Returns 0 on success, < 0 at the end of the file or when the line is too long. */
+  static int replay_read_line(FILE* fp, std::string& line) {
+
+    int c = 0;
+
+    line.clear();
+
+    while (EOF != (c = fgetc(fp))) {
+
+      if ('\n' == c) {
+        return 0;
+      }
+
+      if (Y4M_MAX_LINE < line.size()) {
+        return -1;
+      }
+
+      line.push_back((char)c);
+    }
+
+    return -2;
+  }
+
+  static int replay_fps_from_rate(uint64_t num, uint64_t den) {
+
+    int fps = fps_from_rational(den, num);
+
+    if (CA_NONE == fps) {
+      fps = (int)((num * 100 + den / 2) / den);
+    }
+
+    return fps;
+  }
+
+} /* namespace ca */
@@ -0,0 +1,361 @@
+#include <stdlib.h>
+#include <videocapture/Log.h>
+#include <videocapture/Utils.h>
+#include <videocapture/replay/Replay_Capture.h>
+
+#if defined(_WIN32)
+#  define REPLAY_PATH_SEPARATOR ';'
+#else
+#  define REPLAY_PATH_SEPARATOR ':'
+#endif
+
+namespace ca {
+
+  /* INTERFACE IMPLEMENTATION */
+  /* -------------------------------------- */
+  Replay_Capture::Replay_Capture(frame_callback fc, void* user)
+    :Base(fc, user)
+    ,state(CA_STATE_NONE)
+    ,source(NULL)
+    ,speed(100)
+    ,loop(false)
+    ,has_frame(false)
+    ,must_sync(true)
+    ,is_finished(false)
+    ,frame_time(0)
+    ,first_timestamp(0)
+    ,last_timestamp(0)
+    ,loop_offset(0)
+    ,sync_time(0)
+    ,sync_frame_time(0)
+    ,num_read(0)
+    ,num_delivered(0)
+  {
+    pixel_buffer.user = user;
+    pipeline.stats = &stats;
+
+    const char* env = getenv("CA_REPLAY_FILES");
+    if (NULL == env) {
+      return;
+    }
+
+    std::string paths = env;
+    size_t start = 0;
+
+    while (start <= paths.size()) {
+
+      size_t end = paths.find(REPLAY_PATH_SEPARATOR, start);
+      if (std::string::npos == end) {
+        end = paths.size();
+      }
+
+      if (end > start) {
+        addFile(paths.substr(start, end - start));
+      }
+
+      start = end + 1;
+    }
+  }
+
+  Replay_Capture::~Replay_Capture() {
+
+    if (state & CA_STATE_CAPTUREING) {
+      stop();
+    }
+
+    if (state & CA_STATE_OPENED) {
+      close();
+    }
+
+    state = CA_STATE_NONE;
+    pixel_buffer.user = NULL;
+  }
+
+  int Replay_Capture::open(Settings settings) {
+
+    if (state & CA_STATE_OPENED) {
+      printf("Error: already opened.\n");
+      return -1;
+    }
+
+    if (0 > settings.device || settings.device >= (int)files.size()) {
+      printf("Error: device index is invalid, we have %d replay files (see CA_REPLAY_FILES).\n", (int)files.size());
+      return -2;
+    }
+
+    if (0 != settings.capability) {
+      printf("Error: a replay file has one capability; use capability 0.\n");
+      return -3;
+    }
+
+    if (0 > settings.replay_speed) {
+      printf("Error: invalid replay speed: %d.\n", settings.replay_speed);
+      return -4;
+    }
+
+    source = replay_source_create(files[settings.device]);
+    if (NULL == source) {
+      printf("Error: cannot replay %s.\n", files[settings.device].c_str());
+      return -5;
+    }
+
+    if (pipeline.init(source->width, source->height, source->pixel_format, settings.format, settings.rotation,
+                      settings.jpeg_scale, settings.decode_threads, settings.drop_policy, settings.decode_thread_type) < 0)
+      {
+        delete source;
+        source = NULL;
+        return -6;
+      }
+
+    speed = settings.replay_speed;
+    loop = (0 != settings.replay_loop);
+    has_frame = false;
+    must_sync = true;
+    is_finished = false;
+    frame_time = 0;
+    first_timestamp = 0;
+    last_timestamp = 0;
+    loop_offset = 0;
+    num_read = 0;
+    num_delivered = 0;
+    stats.reset();
+
+    state |= CA_STATE_OPENED;
+
+    return 1;
+  }
+
+  int Replay_Capture::close() {
+
+    if ((state & CA_STATE_OPENED) != CA_STATE_OPENED) {
+      printf("Error: cannot close the replay because it's not opened.\n");
+      return -1;
+    }
+
+    pipeline.shutdown();
+
+    if (NULL != source) {
+      delete source;
+      source = NULL;
+    }
+
+    has_frame = false;
+    state &= ~CA_STATE_OPENED;
+
+    return 1;
+  }
+
+  int Replay_Capture::start() {
+
+    if (state & CA_STATE_CAPTUREING) {
+      printf("Error: we are already replaying. Cannot start again.\n");
+      return -1;
+    }
+
+    if ((state & CA_STATE_OPENED) != CA_STATE_OPENED) {
+      printf("Error: not yet opened.\n");
+      return -2;
+    }
+
+    /* The clock starts at the next frame, so a pause doesn't make us rush the frames after it. */
+    must_sync = true;
+    state |= CA_STATE_CAPTUREING;
+
+    return 1;
+  }
+
+  int Replay_Capture::stop() {
+
+    if ((state & CA_STATE_CAPTUREING) != CA_STATE_CAPTUREING) {
+      printf("Error: cannot stop replaying because we didn't start yet.\n");
+      return -1;
+    }
+
+    state &= ~CA_STATE_CAPTUREING;
+
+    return 1;
+  }
+
+  void Replay_Capture::update() {
+
+    if ((state & CA_STATE_CAPTUREING) != CA_STATE_CAPTUREING) {
+      return;
+    }
+
+    while (false == is_finished) {
+
+      if (false == has_frame) {
+
+        int r = source->readFrame(pixel_buffer);
+
+        if (1 == r && true == loop && 0 < num_read) {
+          /* The next loop starts one frame duration (fps is in 1/100 frames per second) after the last frame. */
+          loop_offset += (last_timestamp - first_timestamp) + ((0 < source->fps) ? (100000000000ull / (uint64_t)source->fps) : 0);
+          num_read = 0;
+          if (0 == source->rewind()) {
+            r = source->readFrame(pixel_buffer);
+          }
+        }
+
+        if (0 != r) {
+          is_finished = true;
+          if (0 > r) {
+            CA_LOG_ERROR("failed to read a frame of the replay file, stopping.");
+          }
+          break;
+        }
+
+        if (0 == num_read && 0 == loop_offset) {
+          first_timestamp = pixel_buffer.timestamp;
+        }
+
+        /* Clamp timestamps that go back, so the delivered ones are monotonic. */
+        if (pixel_buffer.timestamp < first_timestamp) {
+          pixel_buffer.timestamp = first_timestamp;
+        }
+
+        frame_time = (pixel_buffer.timestamp - first_timestamp) + loop_offset;
+        last_timestamp = pixel_buffer.timestamp;
+        has_frame = true;
+        num_read++;
+      }
+
+      uint64_t now = time_now_ns();
+      uint64_t due = now;
+
+      if (true == must_sync) {
+        sync_time = now;
+        sync_frame_time = frame_time;
+        must_sync = false;
+      }
+
+      if (0 < speed) {
+        due = sync_time + ((frame_time - sync_frame_time) * 100) / (uint64_t)speed;
+        if (now < due) {
+          break;
+        }
+      }
+
+      pixel_buffer.timestamp = due;
+      pixel_buffer.receive_time = now;
+      pixel_buffer.sequence = num_delivered;
+
+      if (cb_frame) {
+        pipeline.process(pixel_buffer, cb_frame);
+      }
+
+      has_frame = false;
+      num_delivered++;
+
+      /* As fast as possible means one frame per update(), so the caller stays in control. */
+      if (0 == speed) {
+        break;
+      }
+    }
+
+    /* Deliver the frames that our decode threads finished, see `Settings.decode_threads`. */
+    if (cb_frame) {
+      pipeline.poll(cb_frame);
+    }
+  }
+
+  std::vector<Capability> Replay_Capture::getCapabilities(int device) {
+
+    std::vector<Capability> result;
+
+    if (0 > device || device >= (int)files.size()) {
+      printf("Error: invalid replay device index: %d.\n", device);
+      return result;
+    }
+
+    ReplaySource* src = replay_source_create(files[device]);
+    if (NULL == src) {
+      return result;
+    }
+
+    Capability cap(src->width, src->height, src->pixel_format);
+    cap.fps = src->fps;
+    cap.capability_index = 0;
+    cap.fps_index = 0;
+    cap.pixel_format_index = 0;
+    cap.description = "Replay of " + files[device];
+    result.push_back(cap);
+
+    delete src;
+
+    return result;
+  }
+
+  std::vector<Device> Replay_Capture::getDevices() {
+
+    std::vector<Device> result;
+
+    for (size_t i = 0; i < files.size(); ++i) {
+      Device dev;
+      dev.index = i;
+      dev.name = files[i];
+      result.push_back(dev);
+    }
+
+    return result;
+  }
+
+  std::vector<Format> Replay_Capture::getOutputFormats() {
+
+    /* Every format our kernels or the MJPEG decoder can produce. */
+    static const int formats[] = {
+      CA_YUYV422, CA_UYVY422, CA_YUV422P, CA_YUV420P, CA_YUVJ420P, CA_YUV420BP,
+      CA_RGB24, CA_BGRA32, CA_RGBA32, CA_ARGB32, CA_MJPEG
+    };
+
+    std::vector<Format> result;
+    std::vector<int> inputs;
+    size_t n = sizeof(formats) / sizeof(formats[0]);
+
+    /* The formats of the recordings; the opened one or all of them. */
+    if (NULL != source) {
+      inputs.push_back(source->pixel_format);
+    }
+    else {
+      for (size_t i = 0; i < files.size(); ++i) {
+        std::vector<Capability> caps = getCapabilities(i);
+        if (false == caps.empty()) {
+          inputs.push_back(caps[0].pixel_format);
+        }
+      }
+    }
+
+    for (size_t dst = 0; dst < n; ++dst) {
+      for (size_t src = 0; src < inputs.size(); ++src) {
+
+        if (false == frame_pipeline_can_deliver(inputs[src], formats[dst])) {
+          continue;
+        }
+
+        Format fmt;
+        fmt.format = formats[dst];
+        fmt.index = result.size();
+        result.push_back(fmt);
+        break;
+      }
+    }
+
+    return result;
+  }
+
+  /* REPLAY */
+  /* -------------------------------------- */
+
+  int Replay_Capture::addFile(const std::string& filepath) {
+
+    if (0 == filepath.size()) {
+      printf("Error: cannot add a replay file with an empty path.\n");
+      return -1;
+    }
+
+    files.push_back(filepath);
+
+    return (int)files.size() - 1;
+  }
+
+} /* namespace ca */
@@ -0,0 +1,227 @@
+#include <videocapture/Cpu.h>
+
+#if defined(CA_ARCH_X86)
+
+#include <immintrin.h>
+#include <videocapture/simd/SIMD_Convert.h>
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  /* Per 128 bit lane: shuffles 8 packed 4:2:2 pixels into [Y0..Y7 | U0..U3 | V0..V3]. */
+  template<bool UYVY>
+  static inline __m256i avx2_shuffle_mask() {
+    return (UYVY)
+      ? _mm256_setr_epi8(1, 3, 5, 7, 9, 11, 13, 15, 0, 4, 8, 12, 2, 6, 10, 14,
+                         1, 3, 5, 7, 9, 11, 13, 15, 0, 4, 8, 12, 2, 6, 10, 14)
+      : _mm256_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 5, 9, 13, 3, 7, 11, 15,
+                         0, 2, 4, 6, 8, 10, 12, 14, 1, 5, 9, 13, 3, 7, 11, 15);
+  }
+
+  /* Loads 32 packed 4:2:2 pixels into two vectors with the lanes [0..7 | 16..23] and [8..15 | 24..31], so the split doesn't have to cross lanes. */
+  static inline void avx2_load_packed422(const uint8_t* p, __m256i& a, __m256i& b) {
+    a = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(p))), _mm_loadu_si128((const __m128i*)(p + 32)), 1);
+    b = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(p + 16))), _mm_loadu_si128((const __m128i*)(p + 48)), 1);
+  }
+
+  /* Splits the vectors of `avx2_load_packed422()` into 32 luma bytes and [U0..U7 V0..V7 | U8..U15 V8..V15]. */
+  template<bool UYVY>
+  static inline void avx2_split_packed422(__m256i a, __m256i b, __m256i& y, __m256i& uv) {
+    const __m256i mask = avx2_shuffle_mask<UYVY>();
+    a = _mm256_shuffle_epi8(a, mask);
+    b = _mm256_shuffle_epi8(b, mask);
+    y = _mm256_unpacklo_epi64(a, b);
+    uv = _mm256_unpackhi_epi32(a, b);
+  }
+
+  /* Stores the 16 Cb and 16 Cr bytes of a split `uv`. */
+  static inline void avx2_store_uv(__m256i uv, uint8_t* du, uint8_t* dv) {
+    __m128i lo = _mm256_castsi256_si128(uv);
+    __m128i hi = _mm256_extracti128_si256(uv, 1);
+    _mm_storeu_si128((__m128i*)du, _mm_unpacklo_epi64(lo, hi));
+    _mm_storeu_si128((__m128i*)dv, _mm_unpackhi_epi64(lo, hi));
+  }
+
+  template<bool UYVY>
+  static void avx2_packed422_to_yuv420p(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int pairs = (int)dst.width[0] / 2;
+    int vec = pairs & ~15;
+    int yo = (UYVY) ? 1 : 0;
+    int uo = (UYVY) ? 0 : 1;
+
+    for (int y = y0; y < y1; y += 2) {
+
+      bool has_next = (y + 1) < y1;
+      bool has_chroma = (size_t)(y / 2) < dst.height[1];
+      const uint8_t* s0 = src.plane[0] + y * src.stride[0];
+      const uint8_t* s1 = (has_next) ? (s0 + src.stride[0]) : s0;
+      uint8_t* d0 = dst.plane[0] + y * dst.stride[0];
+      uint8_t* d1 = (has_next) ? (d0 + dst.stride[0]) : NULL;
+      uint8_t* du = (has_chroma) ? (dst.plane[1] + (y / 2) * dst.stride[1]) : NULL;
+      uint8_t* dv = (has_chroma) ? (dst.plane[2] + (y / 2) * dst.stride[2]) : NULL;
+
+      for (int x = 0; x < vec; x += 16) {
+
+        __m256i a0, a1, b0, b1;
+        __m256i ya, yb, uva, uvb;
+
+        avx2_load_packed422(s0 + 4 * x, a0, a1);
+        avx2_load_packed422(s1 + 4 * x, b0, b1);
+        avx2_split_packed422<UYVY>(a0, a1, ya, uva);
+        avx2_split_packed422<UYVY>(b0, b1, yb, uvb);
+        _mm256_storeu_si256((__m256i*)(d0 + 2 * x), ya);
+
+        if (NULL != d1) {
+          _mm256_storeu_si256((__m256i*)(d1 + 2 * x), yb);
+        }
+
+        if (NULL != du) {
+          avx2_store_uv(_mm256_avg_epu8(uva, uvb), du + x, dv + x);
+        }
+      }
+
+      simd_packed422_to_yuv420p_tail(s0, s1, d0, d1, du, dv, vec, pairs, yo, uo);
+    }
+
+    _mm256_zeroupper();
+  }
+
+  template<bool UYVY>
+  static void avx2_packed422_to_yuv422p(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int pairs = (int)dst.width[0] / 2;
+    int vec = pairs & ~15;
+    int yo = (UYVY) ? 1 : 0;
+    int uo = (UYVY) ? 0 : 1;
+
+    for (int y = y0; y < y1; ++y) {
+
+      const uint8_t* s = src.plane[0] + y * src.stride[0];
+      uint8_t* dy = dst.plane[0] + y * dst.stride[0];
+      uint8_t* du = dst.plane[1] + y * dst.stride[1];
+      uint8_t* dv = dst.plane[2] + y * dst.stride[2];
+
+      for (int x = 0; x < vec; x += 16) {
+
+        __m256i a, b, yy, uv;
+
+        avx2_load_packed422(s + 4 * x, a, b);
+        avx2_split_packed422<UYVY>(a, b, yy, uv);
+        _mm256_storeu_si256((__m256i*)(dy + 2 * x), yy);
+        avx2_store_uv(uv, du + x, dv + x);
+      }
+
+      simd_packed422_to_yuv422p_tail(s, dy, du, dv, vec, pairs, yo, uo);
+    }
+
+    _mm256_zeroupper();
+  }
+
+  /* 8 pixels (two lanes of 4): returns (c + coef_a * a + coef_b * b) >> 8 as int32. */
+  static inline __m256i avx2_madd_shift(__m256i c, __m256i ab, __m256i coefs) {
+    return _mm256_srai_epi32(_mm256_add_epi32(c, _mm256_madd_epi16(ab, coefs)), 8);
+  }
+
+  /* Packs 16 int32 values (as produced by the unpacklo/unpackhi pairs) into 16 bytes, in pixel order. */
+  static inline __m128i avx2_pack_bytes(__m256i lo, __m256i hi) {
+    __m256i w = _mm256_packs_epi32(lo, hi);
+    __m256i b = _mm256_packus_epi16(w, w);
+    return _mm256_castsi256_si128(_mm256_permute4x64_epi64(b, _MM_SHUFFLE(3, 1, 2, 0)));
+  }
+
+  /* YUV420P > 32bpp; R, G, B, A are the byte offsets of the components. */
+  template<int R, int G, int B, int A>
+  static void avx2_yuv420p_to_rgb32(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int w = (int)dst.width[0];
+    int vec = w & ~15;
+    const __m256i y_coefs = _mm256_set1_epi32((128 << 16) | 298);
+    const __m256i r_coefs = _mm256_set1_epi32((409 << 16) | 0);
+    const __m256i g_coefs = _mm256_set1_epi32(((-208 & 0xFFFF) << 16) | (-100 & 0xFFFF));
+    const __m256i b_coefs = _mm256_set1_epi32((0 << 16) | 516);
+    const __m256i off_y = _mm256_set1_epi16(16);
+    const __m256i off_c = _mm256_set1_epi16(128);
+    const __m256i one = _mm256_set1_epi16(1);
+    const __m128i alpha = _mm_set1_epi8((char)0xFF);
+
+    for (int y = y0; y < y1; ++y) {
+
+      int cy = y / 2;
+      if ((size_t)cy >= src.height[1]) {
+        cy = (int)src.height[1] - 1;
+      }
+
+      const uint8_t* sy = src.plane[0] + y * src.stride[0];
+      const uint8_t* su = src.plane[1] + cy * src.stride[1];
+      const uint8_t* sv = src.plane[2] + cy * src.stride[2];
+      uint8_t* d = dst.plane[0] + y * dst.stride[0];
+
+      for (int x = 0; x < vec; x += 16) {
+
+        __m128i u8 = _mm_loadl_epi64((const __m128i*)(su + x / 2));
+        __m128i v8 = _mm_loadl_epi64((const __m128i*)(sv + x / 2));
+        __m256i yy = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(sy + x))), off_y);
+        __m256i uu = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_unpacklo_epi8(u8, u8)), off_c);
+        __m256i vv = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_unpacklo_epi8(v8, v8)), off_c);
+
+        __m256i c_lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(yy, one), y_coefs);
+        __m256i c_hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(yy, one), y_coefs);
+        __m256i uv_lo = _mm256_unpacklo_epi16(uu, vv);
+        __m256i uv_hi = _mm256_unpackhi_epi16(uu, vv);
+
+        __m128i r = avx2_pack_bytes(avx2_madd_shift(c_lo, uv_lo, r_coefs), avx2_madd_shift(c_hi, uv_hi, r_coefs));
+        __m128i g = avx2_pack_bytes(avx2_madd_shift(c_lo, uv_lo, g_coefs), avx2_madd_shift(c_hi, uv_hi, g_coefs));
+        __m128i b = avx2_pack_bytes(avx2_madd_shift(c_lo, uv_lo, b_coefs), avx2_madd_shift(c_hi, uv_hi, b_coefs));
+
+        __m128i c0 = (0 == R) ? r : ((0 == G) ? g : ((0 == B) ? b : alpha));
+        __m128i c1 = (1 == R) ? r : ((1 == G) ? g : ((1 == B) ? b : alpha));
+        __m128i c2 = (2 == R) ? r : ((2 == G) ? g : ((2 == B) ? b : alpha));
+        __m128i c3 = (3 == R) ? r : ((3 == G) ? g : ((3 == B) ? b : alpha));
+        __m128i c01_lo = _mm_unpacklo_epi8(c0, c1);
+        __m128i c01_hi = _mm_unpackhi_epi8(c0, c1);
+        __m128i c23_lo = _mm_unpacklo_epi8(c2, c3);
+        __m128i c23_hi = _mm_unpackhi_epi8(c2, c3);
+
+        _mm_storeu_si128((__m128i*)(d + 4 * x + 0), _mm_unpacklo_epi16(c01_lo, c23_lo));
+        _mm_storeu_si128((__m128i*)(d + 4 * x + 16), _mm_unpackhi_epi16(c01_lo, c23_lo));
+        _mm_storeu_si128((__m128i*)(d + 4 * x + 32), _mm_unpacklo_epi16(c01_hi, c23_hi));
+        _mm_storeu_si128((__m128i*)(d + 4 * x + 48), _mm_unpackhi_epi16(c01_hi, c23_hi));
+      }
+
+      simd_yuv420p_to_rgb32_tail(sy, su, sv, d, vec, w, R, G, B, A);
+    }
+
+    _mm256_zeroupper();
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  void convert_yuyv422_to_yuv420p_avx2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    avx2_packed422_to_yuv420p<false>(src, dst, y0, y1);
+  }
+
+  void convert_uyvy422_to_yuv420p_avx2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    avx2_packed422_to_yuv420p<true>(src, dst, y0, y1);
+  }
+
+  void convert_yuyv422_to_yuv422p_avx2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    avx2_packed422_to_yuv422p<false>(src, dst, y0, y1);
+  }
+
+  void convert_uyvy422_to_yuv422p_avx2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    avx2_packed422_to_yuv422p<true>(src, dst, y0, y1);
+  }
+
+  void convert_yuv420p_to_bgra32_avx2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    avx2_yuv420p_to_rgb32<2, 1, 0, 3>(src, dst, y0, y1);
+  }
+
+  void convert_yuv420p_to_rgba32_avx2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    avx2_yuv420p_to_rgb32<0, 1, 2, 3>(src, dst, y0, y1);
+  }
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,138 @@
+#include <videocapture/Cpu.h>
+
+#if defined(CA_ARCH_X86)
+
+#include <immintrin.h>
+#include <videocapture/simd/SIMD_Convert.h>
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  /* Per 128 bit lane: shuffles 8 packed 4:2:2 pixels into [Y0..Y7 | U0..U3 | V0..V3]. */
+  template<bool UYVY>
+  static inline __m512i avx512_shuffle_mask() {
+    return (UYVY)
+      ? _mm512_set4_epi32(0x0E0A0602, 0x0C080400, 0x0F0D0B09, 0x07050301)
+      : _mm512_set4_epi32(0x0F0B0703, 0x0D090501, 0x0E0C0A08, 0x06040200);
+  }
+
+  /* Splits 64 packed 4:2:2 pixels (two vectors) into 64 luma, 32 Cb and 32 Cr bytes. */
+  template<bool UYVY>
+  static inline void avx512_split_packed422(__m512i a, __m512i b, __m512i& y, __m256i& u, __m256i& v) {
+    const __m512i mask = avx512_shuffle_mask<UYVY>();
+    const __m512i y_idx = _mm512_setr_epi32(0, 1, 4, 5, 8, 9, 12, 13, 16, 17, 20, 21, 24, 25, 28, 29);
+    const __m512i uv_idx = _mm512_setr_epi32(2, 6, 10, 14, 18, 22, 26, 30, 3, 7, 11, 15, 19, 23, 27, 31);
+    __m512i sa = _mm512_shuffle_epi8(a, mask);
+    __m512i sb = _mm512_shuffle_epi8(b, mask);
+    __m512i uv = _mm512_permutex2var_epi32(sa, uv_idx, sb);
+    y = _mm512_permutex2var_epi32(sa, y_idx, sb);
+    u = _mm512_castsi512_si256(uv);
+    v = _mm512_extracti64x4_epi64(uv, 1);
+  }
+
+  template<bool UYVY>
+  static void avx512_packed422_to_yuv420p(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int pairs = (int)dst.width[0] / 2;
+    int vec = pairs & ~31;
+    int yo = (UYVY) ? 1 : 0;
+    int uo = (UYVY) ? 0 : 1;
+
+    for (int y = y0; y < y1; y += 2) {
+
+      bool has_next = (y + 1) < y1;
+      bool has_chroma = (size_t)(y / 2) < dst.height[1];
+      const uint8_t* s0 = src.plane[0] + y * src.stride[0];
+      const uint8_t* s1 = (has_next) ? (s0 + src.stride[0]) : s0;
+      uint8_t* d0 = dst.plane[0] + y * dst.stride[0];
+      uint8_t* d1 = (has_next) ? (d0 + dst.stride[0]) : NULL;
+      uint8_t* du = (has_chroma) ? (dst.plane[1] + (y / 2) * dst.stride[1]) : NULL;
+      uint8_t* dv = (has_chroma) ? (dst.plane[2] + (y / 2) * dst.stride[2]) : NULL;
+
+      for (int x = 0; x < vec; x += 32) {
+
+        __m512i a0 = _mm512_loadu_si512((const void*)(s0 + 4 * x));
+        __m512i a1 = _mm512_loadu_si512((const void*)(s0 + 4 * x + 64));
+        __m512i b0 = _mm512_loadu_si512((const void*)(s1 + 4 * x));
+        __m512i b1 = _mm512_loadu_si512((const void*)(s1 + 4 * x + 64));
+        __m512i yy;
+        __m256i u, v;
+
+        avx512_split_packed422<UYVY>(a0, a1, yy, u, v);
+        _mm512_storeu_si512((void*)(d0 + 2 * x), yy);
+
+        if (NULL != d1) {
+          avx512_split_packed422<UYVY>(b0, b1, yy, u, v);
+          _mm512_storeu_si512((void*)(d1 + 2 * x), yy);
+        }
+
+        if (NULL != du) {
+          avx512_split_packed422<UYVY>(_mm512_avg_epu8(a0, b0), _mm512_avg_epu8(a1, b1), yy, u, v);
+          _mm256_storeu_si256((__m256i*)(du + x), u);
+          _mm256_storeu_si256((__m256i*)(dv + x), v);
+        }
+      }
+
+      simd_packed422_to_yuv420p_tail(s0, s1, d0, d1, du, dv, vec, pairs, yo, uo);
+    }
+
+    _mm256_zeroupper();
+  }
+
+  template<bool UYVY>
+  static void avx512_packed422_to_yuv422p(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int pairs = (int)dst.width[0] / 2;
+    int vec = pairs & ~31;
+    int yo = (UYVY) ? 1 : 0;
+    int uo = (UYVY) ? 0 : 1;
+
+    for (int y = y0; y < y1; ++y) {
+
+      const uint8_t* s = src.plane[0] + y * src.stride[0];
+      uint8_t* dy = dst.plane[0] + y * dst.stride[0];
+      uint8_t* du = dst.plane[1] + y * dst.stride[1];
+      uint8_t* dv = dst.plane[2] + y * dst.stride[2];
+
+      for (int x = 0; x < vec; x += 32) {
+
+        __m512i yy;
+        __m256i u, v;
+
+        avx512_split_packed422<UYVY>(_mm512_loadu_si512((const void*)(s + 4 * x)),
+                                     _mm512_loadu_si512((const void*)(s + 4 * x + 64)),
+                                     yy, u, v);
+
+        _mm512_storeu_si512((void*)(dy + 2 * x), yy);
+        _mm256_storeu_si256((__m256i*)(du + x), u);
+        _mm256_storeu_si256((__m256i*)(dv + x), v);
+      }
+
+      simd_packed422_to_yuv422p_tail(s, dy, du, dv, vec, pairs, yo, uo);
+    }
+
+    _mm256_zeroupper();
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  void convert_yuyv422_to_yuv420p_avx512(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    avx512_packed422_to_yuv420p<false>(src, dst, y0, y1);
+  }
+
+  void convert_uyvy422_to_yuv420p_avx512(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    avx512_packed422_to_yuv420p<true>(src, dst, y0, y1);
+  }
+
+  void convert_yuyv422_to_yuv422p_avx512(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    avx512_packed422_to_yuv422p<false>(src, dst, y0, y1);
+  }
+
+  void convert_uyvy422_to_yuv422p_avx512(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    avx512_packed422_to_yuv422p<true>(src, dst, y0, y1);
+  }
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,242 @@
+#include <videocapture/Cpu.h>
+
+#if defined(CA_ARCH_ARM)
+
+#include <string.h>
+#include <arm_neon.h>
+#include <videocapture/simd/SIMD_Convert.h>
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  /* vld4q_u8 deinterleaves a packed 4:2:2 row into Y0, U, Y1, V (YUYV) or U, Y0, V, Y1 (UYVY). */
+  template<bool UYVY>
+  static void neon_packed422_to_yuv420p(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int pairs = (int)dst.width[0] / 2;
+    int vec = pairs & ~15;
+    int yo = (UYVY) ? 1 : 0;
+    int uo = (UYVY) ? 0 : 1;
+    const int iy0 = (UYVY) ? 1 : 0;
+    const int iy1 = (UYVY) ? 3 : 2;
+    const int iu = (UYVY) ? 0 : 1;
+    const int iv = (UYVY) ? 2 : 3;
+
+    for (int y = y0; y < y1; y += 2) {
+
+      bool has_next = (y + 1) < y1;
+      bool has_chroma = (size_t)(y / 2) < dst.height[1];
+      const uint8_t* s0 = src.plane[0] + y * src.stride[0];
+      const uint8_t* s1 = (has_next) ? (s0 + src.stride[0]) : s0;
+      uint8_t* d0 = dst.plane[0] + y * dst.stride[0];
+      uint8_t* d1 = (has_next) ? (d0 + dst.stride[0]) : NULL;
+      uint8_t* du = (has_chroma) ? (dst.plane[1] + (y / 2) * dst.stride[1]) : NULL;
+      uint8_t* dv = (has_chroma) ? (dst.plane[2] + (y / 2) * dst.stride[2]) : NULL;
+
+      for (int x = 0; x < vec; x += 16) {
+
+        uint8x16x4_t a = vld4q_u8(s0 + 4 * x);
+        uint8x16x4_t b = vld4q_u8(s1 + 4 * x);
+        uint8x16x2_t luma;
+
+        luma.val[0] = a.val[iy0];
+        luma.val[1] = a.val[iy1];
+        vst2q_u8(d0 + 2 * x, luma);
+
+        if (NULL != d1) {
+          luma.val[0] = b.val[iy0];
+          luma.val[1] = b.val[iy1];
+          vst2q_u8(d1 + 2 * x, luma);
+        }
+
+        if (NULL != du) {
+          vst1q_u8(du + x, vrhaddq_u8(a.val[iu], b.val[iu]));
+          vst1q_u8(dv + x, vrhaddq_u8(a.val[iv], b.val[iv]));
+        }
+      }
+
+      simd_packed422_to_yuv420p_tail(s0, s1, d0, d1, du, dv, vec, pairs, yo, uo);
+    }
+  }
+
+  template<bool UYVY>
+  static void neon_packed422_to_yuv422p(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int pairs = (int)dst.width[0] / 2;
+    int vec = pairs & ~15;
+    int yo = (UYVY) ? 1 : 0;
+    int uo = (UYVY) ? 0 : 1;
+    const int iy0 = (UYVY) ? 1 : 0;
+    const int iy1 = (UYVY) ? 3 : 2;
+    const int iu = (UYVY) ? 0 : 1;
+    const int iv = (UYVY) ? 2 : 3;
+
+    for (int y = y0; y < y1; ++y) {
+
+      const uint8_t* s = src.plane[0] + y * src.stride[0];
+      uint8_t* dy = dst.plane[0] + y * dst.stride[0];
+      uint8_t* du = dst.plane[1] + y * dst.stride[1];
+      uint8_t* dv = dst.plane[2] + y * dst.stride[2];
+
+      for (int x = 0; x < vec; x += 16) {
+
+        uint8x16x4_t a = vld4q_u8(s + 4 * x);
+        uint8x16x2_t luma;
+
+        luma.val[0] = a.val[iy0];
+        luma.val[1] = a.val[iy1];
+        vst2q_u8(dy + 2 * x, luma);
+        vst1q_u8(du + x, a.val[iu]);
+        vst1q_u8(dv + x, a.val[iv]);
+      }
+
+      simd_packed422_to_yuv422p_tail(s, dy, du, dv, vec, pairs, yo, uo);
+    }
+  }
+
+  /* (c + ka * a + kb * b) >> 8 for 4 pixels, narrowed to int16. */
+  static inline int16x4_t neon_madd_shift(int32x4_t c, int16x4_t a, int16_t ka, int16x4_t b, int16_t kb) {
+    int32x4_t r = vmlal_n_s16(vmlal_n_s16(c, a, ka), b, kb);
+    return vqmovn_s32(vshrq_n_s32(r, 8));
+  }
+
+  /* Converts 8 pixels; `u` and `v` hold the chroma samples already duplicated per pixel. */
+  template<int R, int G, int B, int A>
+  static inline void neon_yuv_to_rgb32_8(uint8x8_t y, uint8x8_t u, uint8x8_t v, uint8_t* d) {
+
+    int16x8_t yy = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(y)), vdupq_n_s16(16));
+    int16x8_t dd = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(u)), vdupq_n_s16(128));
+    int16x8_t ee = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(v)), vdupq_n_s16(128));
+    int32x4_t c_lo = vmlal_n_s16(vdupq_n_s32(128), vget_low_s16(yy), 298);
+    int32x4_t c_hi = vmlal_n_s16(vdupq_n_s32(128), vget_high_s16(yy), 298);
+    int16x4_t d_lo = vget_low_s16(dd);
+    int16x4_t d_hi = vget_high_s16(dd);
+    int16x4_t e_lo = vget_low_s16(ee);
+    int16x4_t e_hi = vget_high_s16(ee);
+    uint8x8x4_t out;
+
+    out.val[R] = vqmovun_s16(vcombine_s16(neon_madd_shift(c_lo, e_lo, 409, d_lo, 0), neon_madd_shift(c_hi, e_hi, 409, d_hi, 0)));
+    out.val[G] = vqmovun_s16(vcombine_s16(neon_madd_shift(c_lo, d_lo, -100, e_lo, -208), neon_madd_shift(c_hi, d_hi, -100, e_hi, -208)));
+    out.val[B] = vqmovun_s16(vcombine_s16(neon_madd_shift(c_lo, d_lo, 516, e_lo, 0), neon_madd_shift(c_hi, d_hi, 516, e_hi, 0)));
+    out.val[A] = vdup_n_u8(0xFF);
+
+    vst4_u8(d, out);
+  }
+
+  template<int R, int G, int B, int A>
+  static void neon_yuv420p_to_rgb32(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int w = (int)dst.width[0];
+    int vec = w & ~15;
+
+    for (int y = y0; y < y1; ++y) {
+
+      int cy = y / 2;
+      if ((size_t)cy >= src.height[1]) {
+        cy = (int)src.height[1] - 1;
+      }
+
+      const uint8_t* sy = src.plane[0] + y * src.stride[0];
+      const uint8_t* su = src.plane[1] + cy * src.stride[1];
+      const uint8_t* sv = src.plane[2] + cy * src.stride[2];
+      uint8_t* d = dst.plane[0] + y * dst.stride[0];
+
+      for (int x = 0; x < vec; x += 16) {
+
+        uint8x16_t luma = vld1q_u8(sy + x);
+        uint8x8_t u = vld1_u8(su + x / 2);
+        uint8x8_t v = vld1_u8(sv + x / 2);
+        uint8x8x2_t uu = vzip_u8(u, u);
+        uint8x8x2_t vv = vzip_u8(v, v);
+
+        neon_yuv_to_rgb32_8<R, G, B, A>(vget_low_u8(luma), uu.val[0], vv.val[0], d + 4 * x);
+        neon_yuv_to_rgb32_8<R, G, B, A>(vget_high_u8(luma), uu.val[1], vv.val[1], d + 4 * x + 32);
+      }
+
+      simd_yuv420p_to_rgb32_tail(sy, su, sv, d, vec, w, R, G, B, A);
+    }
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  void convert_yuyv422_to_yuv420p_neon(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    neon_packed422_to_yuv420p<false>(src, dst, y0, y1);
+  }
+
+  void convert_uyvy422_to_yuv420p_neon(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    neon_packed422_to_yuv420p<true>(src, dst, y0, y1);
+  }
+
+  void convert_yuyv422_to_yuv422p_neon(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    neon_packed422_to_yuv422p<false>(src, dst, y0, y1);
+  }
+
+  void convert_uyvy422_to_yuv422p_neon(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    neon_packed422_to_yuv422p<true>(src, dst, y0, y1);
+  }
+
+  void convert_yuv420p_to_yuv420bp_neon(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int w = (int)dst.width[0];
+    int cw = (int)dst.width[1];
+    int vec = cw & ~15;
+
+    for (int y = y0; y < y1; ++y) {
+      memcpy(dst.plane[0] + y * dst.stride[0], src.plane[0] + y * src.stride[0], w);
+    }
+
+    for (int cy = y0 / 2; cy < (y1 + 1) / 2 && (size_t)cy < dst.height[1]; ++cy) {
+
+      const uint8_t* su = src.plane[1] + cy * src.stride[1];
+      const uint8_t* sv = src.plane[2] + cy * src.stride[2];
+      uint8_t* d = dst.plane[1] + cy * dst.stride[1];
+
+      for (int x = 0; x < vec; x += 16) {
+        uint8x16x2_t uv;
+        uv.val[0] = vld1q_u8(su + x);
+        uv.val[1] = vld1q_u8(sv + x);
+        vst2q_u8(d + 2 * x, uv);
+      }
+
+      simd_interleave_tail(su, sv, d, vec, cw);
+    }
+  }
+
+  void convert_yuv420bp_to_yuv420p_neon(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int w = (int)dst.width[0];
+    int cw = (int)dst.width[1];
+    int vec = cw & ~15;
+
+    for (int y = y0; y < y1; ++y) {
+      memcpy(dst.plane[0] + y * dst.stride[0], src.plane[0] + y * src.stride[0], w);
+    }
+
+    for (int cy = y0 / 2; cy < (y1 + 1) / 2 && (size_t)cy < dst.height[1]; ++cy) {
+
+      const uint8_t* s = src.plane[1] + cy * src.stride[1];
+      uint8_t* du = dst.plane[1] + cy * dst.stride[1];
+      uint8_t* dv = dst.plane[2] + cy * dst.stride[2];
+
+      for (int x = 0; x < vec; x += 16) {
+        uint8x16x2_t uv = vld2q_u8(s + 2 * x);
+        vst1q_u8(du + x, uv.val[0]);
+        vst1q_u8(dv + x, uv.val[1]);
+      }
+
+      simd_deinterleave_tail(s, du, dv, vec, cw);
+    }
+  }
+
+  void convert_yuv420p_to_bgra32_neon(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    neon_yuv420p_to_rgb32<2, 1, 0, 3>(src, dst, y0, y1);
+  }
+
+  void convert_yuv420p_to_rgba32_neon(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    neon_yuv420p_to_rgb32<0, 1, 2, 3>(src, dst, y0, y1);
+  }
+
+} /* namespace ca */
+
+#endif
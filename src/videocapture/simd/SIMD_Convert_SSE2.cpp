@@ -0,0 +1,279 @@
+#include <videocapture/Cpu.h>
+
+#if defined(CA_ARCH_X86)
+
+#include <string.h>
+#include <emmintrin.h>
+#include <videocapture/simd/SIMD_Convert.h>
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  /* Splits 16 packed 4:2:2 pixels (two vectors) into 16 luma bytes and 8 Cb/Cr pairs. */
+  template<bool UYVY>
+  static inline void sse2_split_packed422(__m128i a, __m128i b, __m128i& y, __m128i& uv) {
+    const __m128i mask = _mm_set1_epi16(0x00FF);
+    __m128i even = _mm_packus_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask));
+    __m128i odd = _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));
+    y = (UYVY) ? odd : even;
+    uv = (UYVY) ? even : odd;
+  }
+
+  /* Splits 16 interleaved Cb/Cr pairs (two vectors) into 16 Cb and 16 Cr bytes. */
+  static inline void sse2_split_uv(__m128i uv0, __m128i uv1, __m128i& u, __m128i& v) {
+    const __m128i mask = _mm_set1_epi16(0x00FF);
+    u = _mm_packus_epi16(_mm_and_si128(uv0, mask), _mm_and_si128(uv1, mask));
+    v = _mm_packus_epi16(_mm_srli_epi16(uv0, 8), _mm_srli_epi16(uv1, 8));
+  }
+
+  template<bool UYVY>
+  static void sse2_packed422_to_yuv420p(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int pairs = (int)dst.width[0] / 2;
+    int vec = pairs & ~15;
+    int yo = (UYVY) ? 1 : 0;
+    int uo = (UYVY) ? 0 : 1;
+
+    for (int y = y0; y < y1; y += 2) {
+
+      bool has_next = (y + 1) < y1;
+      bool has_chroma = (size_t)(y / 2) < dst.height[1];
+      const uint8_t* s0 = src.plane[0] + y * src.stride[0];
+      const uint8_t* s1 = (has_next) ? (s0 + src.stride[0]) : s0;
+      uint8_t* d0 = dst.plane[0] + y * dst.stride[0];
+      uint8_t* d1 = (has_next) ? (d0 + dst.stride[0]) : NULL;
+      uint8_t* du = (has_chroma) ? (dst.plane[1] + (y / 2) * dst.stride[1]) : NULL;
+      uint8_t* dv = (has_chroma) ? (dst.plane[2] + (y / 2) * dst.stride[2]) : NULL;
+
+      for (int x = 0; x < vec; x += 16) {
+
+        const uint8_t* p0 = s0 + 4 * x;
+        const uint8_t* p1 = s1 + 4 * x;
+        __m128i a0 = _mm_loadu_si128((const __m128i*)(p0 + 0));
+        __m128i a1 = _mm_loadu_si128((const __m128i*)(p0 + 16));
+        __m128i a2 = _mm_loadu_si128((const __m128i*)(p0 + 32));
+        __m128i a3 = _mm_loadu_si128((const __m128i*)(p0 + 48));
+        __m128i b0 = _mm_loadu_si128((const __m128i*)(p1 + 0));
+        __m128i b1 = _mm_loadu_si128((const __m128i*)(p1 + 16));
+        __m128i b2 = _mm_loadu_si128((const __m128i*)(p1 + 32));
+        __m128i b3 = _mm_loadu_si128((const __m128i*)(p1 + 48));
+        __m128i ya, yb, uv0, uv1, u, v;
+
+        sse2_split_packed422<UYVY>(a0, a1, ya, uv0);
+        sse2_split_packed422<UYVY>(a2, a3, yb, uv1);
+        _mm_storeu_si128((__m128i*)(d0 + 2 * x), ya);
+        _mm_storeu_si128((__m128i*)(d0 + 2 * x + 16), yb);
+
+        if (NULL != d1) {
+          sse2_split_packed422<UYVY>(b0, b1, ya, uv0);
+          sse2_split_packed422<UYVY>(b2, b3, yb, uv1);
+          _mm_storeu_si128((__m128i*)(d1 + 2 * x), ya);
+          _mm_storeu_si128((__m128i*)(d1 + 2 * x + 16), yb);
+        }
+
+        if (NULL != du) {
+          sse2_split_packed422<UYVY>(_mm_avg_epu8(a0, b0), _mm_avg_epu8(a1, b1), ya, uv0);
+          sse2_split_packed422<UYVY>(_mm_avg_epu8(a2, b2), _mm_avg_epu8(a3, b3), yb, uv1);
+          sse2_split_uv(uv0, uv1, u, v);
+          _mm_storeu_si128((__m128i*)(du + x), u);
+          _mm_storeu_si128((__m128i*)(dv + x), v);
+        }
+      }
+
+      simd_packed422_to_yuv420p_tail(s0, s1, d0, d1, du, dv, vec, pairs, yo, uo);
+    }
+  }
+
+  template<bool UYVY>
+  static void sse2_packed422_to_yuv422p(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int pairs = (int)dst.width[0] / 2;
+    int vec = pairs & ~15;
+    int yo = (UYVY) ? 1 : 0;
+    int uo = (UYVY) ? 0 : 1;
+
+    for (int y = y0; y < y1; ++y) {
+
+      const uint8_t* s = src.plane[0] + y * src.stride[0];
+      uint8_t* dy = dst.plane[0] + y * dst.stride[0];
+      uint8_t* du = dst.plane[1] + y * dst.stride[1];
+      uint8_t* dv = dst.plane[2] + y * dst.stride[2];
+
+      for (int x = 0; x < vec; x += 16) {
+
+        const uint8_t* p = s + 4 * x;
+        __m128i ya, yb, uv0, uv1, u, v;
+
+        sse2_split_packed422<UYVY>(_mm_loadu_si128((const __m128i*)(p + 0)), _mm_loadu_si128((const __m128i*)(p + 16)), ya, uv0);
+        sse2_split_packed422<UYVY>(_mm_loadu_si128((const __m128i*)(p + 32)), _mm_loadu_si128((const __m128i*)(p + 48)), yb, uv1);
+        sse2_split_uv(uv0, uv1, u, v);
+
+        _mm_storeu_si128((__m128i*)(dy + 2 * x), ya);
+        _mm_storeu_si128((__m128i*)(dy + 2 * x + 16), yb);
+        _mm_storeu_si128((__m128i*)(du + x), u);
+        _mm_storeu_si128((__m128i*)(dv + x), v);
+      }
+
+      simd_packed422_to_yuv422p_tail(s, dy, du, dv, vec, pairs, yo, uo);
+    }
+  }
+
+  /* 4 pixels: returns (c + coef_a * a + coef_b * b) >> 8 as int32, where c = 298 * (y - 16) + 128 is passed in. */
+  static inline __m128i sse2_madd_shift(__m128i c, __m128i ab, __m128i coefs) {
+    return _mm_srai_epi32(_mm_add_epi32(c, _mm_madd_epi16(ab, coefs)), 8);
+  }
+
+  /* YUV420P > 32bpp; R, G, B, A are the byte offsets of the components. */
+  template<int R, int G, int B, int A>
+  static void sse2_yuv420p_to_rgb32(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int w = (int)dst.width[0];
+    int vec = w & ~7;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i y_coefs = _mm_set1_epi32((128 << 16) | 298);                     /* (y - 16, 1) * (298, 128) */
+    const __m128i r_coefs = _mm_set1_epi32((409 << 16) | 0);                       /* (u - 128, v - 128) * (0, 409) */
+    const __m128i g_coefs = _mm_set1_epi32(((-208 & 0xFFFF) << 16) | (-100 & 0xFFFF));
+    const __m128i b_coefs = _mm_set1_epi32((0 << 16) | 516);
+    const __m128i off_y = _mm_set1_epi16(16);
+    const __m128i off_c = _mm_set1_epi16(128);
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i alpha = _mm_set1_epi8((char)0xFF);
+
+    for (int y = y0; y < y1; ++y) {
+
+      int cy = y / 2;
+      if ((size_t)cy >= src.height[1]) {
+        cy = (int)src.height[1] - 1;
+      }
+
+      const uint8_t* sy = src.plane[0] + y * src.stride[0];
+      const uint8_t* su = src.plane[1] + cy * src.stride[1];
+      const uint8_t* sv = src.plane[2] + cy * src.stride[2];
+      uint8_t* d = dst.plane[0] + y * dst.stride[0];
+
+      for (int x = 0; x < vec; x += 8) {
+
+        int32_t u4;
+        int32_t v4;
+        memcpy(&u4, su + x / 2, 4);
+        memcpy(&v4, sv + x / 2, 4);
+
+        __m128i yy = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(sy + x)), zero), off_y);
+        __m128i uu = _mm_cvtsi32_si128(u4);
+        __m128i vv = _mm_cvtsi32_si128(v4);
+        uu = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_unpacklo_epi8(uu, uu), zero), off_c);
+        vv = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_unpacklo_epi8(vv, vv), zero), off_c);
+
+        __m128i c_lo = _mm_madd_epi16(_mm_unpacklo_epi16(yy, one), y_coefs);
+        __m128i c_hi = _mm_madd_epi16(_mm_unpackhi_epi16(yy, one), y_coefs);
+        __m128i uv_lo = _mm_unpacklo_epi16(uu, vv);
+        __m128i uv_hi = _mm_unpackhi_epi16(uu, vv);
+
+        __m128i r = _mm_packs_epi32(sse2_madd_shift(c_lo, uv_lo, r_coefs), sse2_madd_shift(c_hi, uv_hi, r_coefs));
+        __m128i g = _mm_packs_epi32(sse2_madd_shift(c_lo, uv_lo, g_coefs), sse2_madd_shift(c_hi, uv_hi, g_coefs));
+        __m128i b = _mm_packs_epi32(sse2_madd_shift(c_lo, uv_lo, b_coefs), sse2_madd_shift(c_hi, uv_hi, b_coefs));
+
+        r = _mm_packus_epi16(r, r);
+        g = _mm_packus_epi16(g, g);
+        b = _mm_packus_epi16(b, b);
+
+        /* Interleave in memory order; the template offsets tell which component goes where. */
+        __m128i c0 = (0 == R) ? r : ((0 == G) ? g : ((0 == B) ? b : alpha));
+        __m128i c1 = (1 == R) ? r : ((1 == G) ? g : ((1 == B) ? b : alpha));
+        __m128i c2 = (2 == R) ? r : ((2 == G) ? g : ((2 == B) ? b : alpha));
+        __m128i c3 = (3 == R) ? r : ((3 == G) ? g : ((3 == B) ? b : alpha));
+        __m128i c01 = _mm_unpacklo_epi8(c0, c1);
+        __m128i c23 = _mm_unpacklo_epi8(c2, c3);
+
+        _mm_storeu_si128((__m128i*)(d + 4 * x), _mm_unpacklo_epi16(c01, c23));
+        _mm_storeu_si128((__m128i*)(d + 4 * x + 16), _mm_unpackhi_epi16(c01, c23));
+      }
+
+      simd_yuv420p_to_rgb32_tail(sy, su, sv, d, vec, w, R, G, B, A);
+    }
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  void convert_yuyv422_to_yuv420p_sse2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    sse2_packed422_to_yuv420p<false>(src, dst, y0, y1);
+  }
+
+  void convert_uyvy422_to_yuv420p_sse2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    sse2_packed422_to_yuv420p<true>(src, dst, y0, y1);
+  }
+
+  void convert_yuyv422_to_yuv422p_sse2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    sse2_packed422_to_yuv422p<false>(src, dst, y0, y1);
+  }
+
+  void convert_uyvy422_to_yuv422p_sse2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    sse2_packed422_to_yuv422p<true>(src, dst, y0, y1);
+  }
+
+  void convert_yuv420p_to_yuv420bp_sse2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int w = (int)dst.width[0];
+    int cw = (int)dst.width[1];
+    int vec = cw & ~15;
+
+    for (int y = y0; y < y1; ++y) {
+      memcpy(dst.plane[0] + y * dst.stride[0], src.plane[0] + y * src.stride[0], w);
+    }
+
+    for (int cy = y0 / 2; cy < (y1 + 1) / 2 && (size_t)cy < dst.height[1]; ++cy) {
+
+      const uint8_t* su = src.plane[1] + cy * src.stride[1];
+      const uint8_t* sv = src.plane[2] + cy * src.stride[2];
+      uint8_t* d = dst.plane[1] + cy * dst.stride[1];
+
+      for (int x = 0; x < vec; x += 16) {
+        __m128i u = _mm_loadu_si128((const __m128i*)(su + x));
+        __m128i v = _mm_loadu_si128((const __m128i*)(sv + x));
+        _mm_storeu_si128((__m128i*)(d + 2 * x), _mm_unpacklo_epi8(u, v));
+        _mm_storeu_si128((__m128i*)(d + 2 * x + 16), _mm_unpackhi_epi8(u, v));
+      }
+
+      simd_interleave_tail(su, sv, d, vec, cw);
+    }
+  }
+
+  void convert_yuv420bp_to_yuv420p_sse2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int w = (int)dst.width[0];
+    int cw = (int)dst.width[1];
+    int vec = cw & ~15;
+
+    for (int y = y0; y < y1; ++y) {
+      memcpy(dst.plane[0] + y * dst.stride[0], src.plane[0] + y * src.stride[0], w);
+    }
+
+    for (int cy = y0 / 2; cy < (y1 + 1) / 2 && (size_t)cy < dst.height[1]; ++cy) {
+
+      const uint8_t* s = src.plane[1] + cy * src.stride[1];
+      uint8_t* du = dst.plane[1] + cy * dst.stride[1];
+      uint8_t* dv = dst.plane[2] + cy * dst.stride[2];
+
+      for (int x = 0; x < vec; x += 16) {
+        __m128i u, v;
+        sse2_split_uv(_mm_loadu_si128((const __m128i*)(s + 2 * x)), _mm_loadu_si128((const __m128i*)(s + 2 * x + 16)), u, v);
+        _mm_storeu_si128((__m128i*)(du + x), u);
+        _mm_storeu_si128((__m128i*)(dv + x), v);
+      }
+
+      simd_deinterleave_tail(s, du, dv, vec, cw);
+    }
+  }
+
+  void convert_yuv420p_to_bgra32_sse2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    sse2_yuv420p_to_rgb32<2, 1, 0, 3>(src, dst, y0, y1);
+  }
+
+  void convert_yuv420p_to_rgba32_sse2(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    sse2_yuv420p_to_rgb32<0, 1, 2, 3>(src, dst, y0, y1);
+  }
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,125 @@
+#include <videocapture/Cpu.h>
+
+#if defined(CA_ARCH_X86)
+
+#include <tmmintrin.h>
+#include <videocapture/simd/SIMD_Convert.h>
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  /* Shuffles 8 packed 4:2:2 pixels into [Y0..Y7 | U0..U3 | V0..V3]. */
+  template<bool UYVY>
+  static inline __m128i ssse3_shuffle_mask() {
+    return (UYVY)
+      ? _mm_setr_epi8(1, 3, 5, 7, 9, 11, 13, 15, 0, 4, 8, 12, 2, 6, 10, 14)
+      : _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 5, 9, 13, 3, 7, 11, 15);
+  }
+
+  /* Splits 16 pixels that were shuffled with `ssse3_shuffle_mask()` into 16 luma, 8 Cb and 8 Cr bytes (Cb in the low, Cr in the high half of `uv`). */
+  static inline void ssse3_split(__m128i a, __m128i b, __m128i& y, __m128i& uv) {
+    y = _mm_unpacklo_epi64(a, b);
+    uv = _mm_unpackhi_epi32(a, b);                                                   /* [Ua, Ub, Va, Vb] */
+  }
+
+  template<bool UYVY>
+  static void ssse3_packed422_to_yuv420p(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int pairs = (int)dst.width[0] / 2;
+    int vec = pairs & ~7;
+    int yo = (UYVY) ? 1 : 0;
+    int uo = (UYVY) ? 0 : 1;
+    const __m128i mask = ssse3_shuffle_mask<UYVY>();
+
+    for (int y = y0; y < y1; y += 2) {
+
+      bool has_next = (y + 1) < y1;
+      bool has_chroma = (size_t)(y / 2) < dst.height[1];
+      const uint8_t* s0 = src.plane[0] + y * src.stride[0];
+      const uint8_t* s1 = (has_next) ? (s0 + src.stride[0]) : s0;
+      uint8_t* d0 = dst.plane[0] + y * dst.stride[0];
+      uint8_t* d1 = (has_next) ? (d0 + dst.stride[0]) : NULL;
+      uint8_t* du = (has_chroma) ? (dst.plane[1] + (y / 2) * dst.stride[1]) : NULL;
+      uint8_t* dv = (has_chroma) ? (dst.plane[2] + (y / 2) * dst.stride[2]) : NULL;
+
+      for (int x = 0; x < vec; x += 8) {
+
+        __m128i a0 = _mm_loadu_si128((const __m128i*)(s0 + 4 * x));
+        __m128i a1 = _mm_loadu_si128((const __m128i*)(s0 + 4 * x + 16));
+        __m128i b0 = _mm_loadu_si128((const __m128i*)(s1 + 4 * x));
+        __m128i b1 = _mm_loadu_si128((const __m128i*)(s1 + 4 * x + 16));
+        __m128i yy, uv;
+
+        ssse3_split(_mm_shuffle_epi8(a0, mask), _mm_shuffle_epi8(a1, mask), yy, uv);
+        _mm_storeu_si128((__m128i*)(d0 + 2 * x), yy);
+
+        if (NULL != d1) {
+          ssse3_split(_mm_shuffle_epi8(b0, mask), _mm_shuffle_epi8(b1, mask), yy, uv);
+          _mm_storeu_si128((__m128i*)(d1 + 2 * x), yy);
+        }
+
+        if (NULL != du) {
+          ssse3_split(_mm_shuffle_epi8(_mm_avg_epu8(a0, b0), mask), _mm_shuffle_epi8(_mm_avg_epu8(a1, b1), mask), yy, uv);
+          _mm_storel_epi64((__m128i*)(du + x), uv);
+          _mm_storel_epi64((__m128i*)(dv + x), _mm_unpackhi_epi64(uv, uv));
+        }
+      }
+
+      simd_packed422_to_yuv420p_tail(s0, s1, d0, d1, du, dv, vec, pairs, yo, uo);
+    }
+  }
+
+  template<bool UYVY>
+  static void ssse3_packed422_to_yuv422p(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+
+    int pairs = (int)dst.width[0] / 2;
+    int vec = pairs & ~7;
+    int yo = (UYVY) ? 1 : 0;
+    int uo = (UYVY) ? 0 : 1;
+    const __m128i mask = ssse3_shuffle_mask<UYVY>();
+
+    for (int y = y0; y < y1; ++y) {
+
+      const uint8_t* s = src.plane[0] + y * src.stride[0];
+      uint8_t* dy = dst.plane[0] + y * dst.stride[0];
+      uint8_t* du = dst.plane[1] + y * dst.stride[1];
+      uint8_t* dv = dst.plane[2] + y * dst.stride[2];
+
+      for (int x = 0; x < vec; x += 8) {
+
+        __m128i a0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(s + 4 * x)), mask);
+        __m128i a1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(s + 4 * x + 16)), mask);
+        __m128i yy, uv;
+
+        ssse3_split(a0, a1, yy, uv);
+        _mm_storeu_si128((__m128i*)(dy + 2 * x), yy);
+        _mm_storel_epi64((__m128i*)(du + x), uv);
+        _mm_storel_epi64((__m128i*)(dv + x), _mm_unpackhi_epi64(uv, uv));
+      }
+
+      simd_packed422_to_yuv422p_tail(s, dy, du, dv, vec, pairs, yo, uo);
+    }
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  void convert_yuyv422_to_yuv420p_ssse3(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    ssse3_packed422_to_yuv420p<false>(src, dst, y0, y1);
+  }
+
+  void convert_uyvy422_to_yuv420p_ssse3(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    ssse3_packed422_to_yuv420p<true>(src, dst, y0, y1);
+  }
+
+  void convert_yuyv422_to_yuv422p_ssse3(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    ssse3_packed422_to_yuv422p<false>(src, dst, y0, y1);
+  }
+
+  void convert_uyvy422_to_yuv422p_ssse3(const PixelBuffer& src, PixelBuffer& dst, int y0, int y1) {
+    ssse3_packed422_to_yuv422p<true>(src, dst, y0, y1);
+  }
+
+} /* namespace ca */
+
+#endif
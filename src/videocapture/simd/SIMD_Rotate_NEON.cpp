@@ -0,0 +1,86 @@
+#include <videocapture/Cpu.h>
+
+#if defined(CA_ARCH_ARM)
+
+#include <arm_neon.h>
+#include <videocapture/simd/SIMD_Rotate.h>
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  void rotate_transpose_u8_neon(const uint8_t* src, ptrdiff_t sstride, uint8_t* dst, ptrdiff_t dstride, int w, int h) {
+
+    int w8 = w & ~7;
+    int h8 = h & ~7;
+
+    for (int y = 0; y < h8; y += 8) {
+
+      const uint8_t* s = src + y * sstride;
+
+      for (int x = 0; x < w8; x += 8) {
+
+        uint8x8x2_t b0 = vtrn_u8(vld1_u8(s + 0 * sstride + x), vld1_u8(s + 1 * sstride + x));
+        uint8x8x2_t b1 = vtrn_u8(vld1_u8(s + 2 * sstride + x), vld1_u8(s + 3 * sstride + x));
+        uint8x8x2_t b2 = vtrn_u8(vld1_u8(s + 4 * sstride + x), vld1_u8(s + 5 * sstride + x));
+        uint8x8x2_t b3 = vtrn_u8(vld1_u8(s + 6 * sstride + x), vld1_u8(s + 7 * sstride + x));
+
+        uint16x4x2_t c0 = vtrn_u16(vreinterpret_u16_u8(b0.val[0]), vreinterpret_u16_u8(b1.val[0]));   /* Columns 0 and 4, 2 and 6 of rows 0-3. */
+        uint16x4x2_t c1 = vtrn_u16(vreinterpret_u16_u8(b0.val[1]), vreinterpret_u16_u8(b1.val[1]));   /* Columns 1 and 5, 3 and 7 of rows 0-3. */
+        uint16x4x2_t c2 = vtrn_u16(vreinterpret_u16_u8(b2.val[0]), vreinterpret_u16_u8(b3.val[0]));
+        uint16x4x2_t c3 = vtrn_u16(vreinterpret_u16_u8(b2.val[1]), vreinterpret_u16_u8(b3.val[1]));
+
+        uint32x2x2_t d0 = vtrn_u32(vreinterpret_u32_u16(c0.val[0]), vreinterpret_u32_u16(c2.val[0]));   /* Columns 0 and 4. */
+        uint32x2x2_t d1 = vtrn_u32(vreinterpret_u32_u16(c1.val[0]), vreinterpret_u32_u16(c3.val[0]));   /* Columns 1 and 5. */
+        uint32x2x2_t d2 = vtrn_u32(vreinterpret_u32_u16(c0.val[1]), vreinterpret_u32_u16(c2.val[1]));   /* Columns 2 and 6. */
+        uint32x2x2_t d3 = vtrn_u32(vreinterpret_u32_u16(c1.val[1]), vreinterpret_u32_u16(c3.val[1]));   /* Columns 3 and 7. */
+
+        uint8_t* d = dst + x * dstride + y;
+
+        vst1_u8(d + 0 * dstride, vreinterpret_u8_u32(d0.val[0]));
+        vst1_u8(d + 1 * dstride, vreinterpret_u8_u32(d1.val[0]));
+        vst1_u8(d + 2 * dstride, vreinterpret_u8_u32(d2.val[0]));
+        vst1_u8(d + 3 * dstride, vreinterpret_u8_u32(d3.val[0]));
+        vst1_u8(d + 4 * dstride, vreinterpret_u8_u32(d0.val[1]));
+        vst1_u8(d + 5 * dstride, vreinterpret_u8_u32(d1.val[1]));
+        vst1_u8(d + 6 * dstride, vreinterpret_u8_u32(d2.val[1]));
+        vst1_u8(d + 7 * dstride, vreinterpret_u8_u32(d3.val[1]));
+      }
+    }
+
+    simd_transpose_tail(src, sstride, dst, dstride, 1, w8, w, 0, h);
+    simd_transpose_tail(src, sstride, dst, dstride, 1, 0, w8, h8, h);
+  }
+
+  void rotate_transpose_u32_neon(const uint8_t* src, ptrdiff_t sstride, uint8_t* dst, ptrdiff_t dstride, int w, int h) {
+
+    int w4 = w & ~3;
+    int h4 = h & ~3;
+
+    for (int y = 0; y < h4; y += 4) {
+
+      const uint8_t* s = src + y * sstride;
+
+      for (int x = 0; x < w4; x += 4) {
+
+        uint32x4x2_t t0 = vtrnq_u32(vld1q_u32((const uint32_t*)(s + 0 * sstride + 4 * x)),
+                                    vld1q_u32((const uint32_t*)(s + 1 * sstride + 4 * x)));
+        uint32x4x2_t t1 = vtrnq_u32(vld1q_u32((const uint32_t*)(s + 2 * sstride + 4 * x)),
+                                    vld1q_u32((const uint32_t*)(s + 3 * sstride + 4 * x)));
+
+        uint8_t* d = dst + x * dstride + 4 * y;
+
+        vst1q_u32((uint32_t*)(d + 0 * dstride), vcombine_u32(vget_low_u32(t0.val[0]), vget_low_u32(t1.val[0])));
+        vst1q_u32((uint32_t*)(d + 1 * dstride), vcombine_u32(vget_low_u32(t0.val[1]), vget_low_u32(t1.val[1])));
+        vst1q_u32((uint32_t*)(d + 2 * dstride), vcombine_u32(vget_high_u32(t0.val[0]), vget_high_u32(t1.val[0])));
+        vst1q_u32((uint32_t*)(d + 3 * dstride), vcombine_u32(vget_high_u32(t0.val[1]), vget_high_u32(t1.val[1])));
+      }
+    }
+
+    simd_transpose_tail(src, sstride, dst, dstride, 4, w4, w, 0, h);
+    simd_transpose_tail(src, sstride, dst, dstride, 4, 0, w4, h4, h);
+  }
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,153 @@
+#include <videocapture/Cpu.h>
+
+#if defined(CA_ARCH_X86)
+
+#include <emmintrin.h>
+#include <videocapture/simd/SIMD_Rotate.h>
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  static inline void sse2_store_halves(uint8_t* d0, uint8_t* d1, __m128i v) {
+    _mm_storel_epi64((__m128i*)d0, v);
+    _mm_storel_epi64((__m128i*)d1, _mm_unpackhi_epi64(v, v));
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  void rotate_transpose_u8_sse2(const uint8_t* src, ptrdiff_t sstride, uint8_t* dst, ptrdiff_t dstride, int w, int h) {
+
+    int w8 = w & ~7;
+    int h8 = h & ~7;
+
+    for (int y = 0; y < h8; y += 8) {
+
+      const uint8_t* s = src + y * sstride;
+
+      for (int x = 0; x < w8; x += 8) {
+
+        __m128i r0 = _mm_loadl_epi64((const __m128i*)(s + 0 * sstride + x));
+        __m128i r1 = _mm_loadl_epi64((const __m128i*)(s + 1 * sstride + x));
+        __m128i r2 = _mm_loadl_epi64((const __m128i*)(s + 2 * sstride + x));
+        __m128i r3 = _mm_loadl_epi64((const __m128i*)(s + 3 * sstride + x));
+        __m128i r4 = _mm_loadl_epi64((const __m128i*)(s + 4 * sstride + x));
+        __m128i r5 = _mm_loadl_epi64((const __m128i*)(s + 5 * sstride + x));
+        __m128i r6 = _mm_loadl_epi64((const __m128i*)(s + 6 * sstride + x));
+        __m128i r7 = _mm_loadl_epi64((const __m128i*)(s + 7 * sstride + x));
+
+        __m128i a0 = _mm_unpacklo_epi8(r0, r1);
+        __m128i a1 = _mm_unpacklo_epi8(r2, r3);
+        __m128i a2 = _mm_unpacklo_epi8(r4, r5);
+        __m128i a3 = _mm_unpacklo_epi8(r6, r7);
+
+        __m128i b0 = _mm_unpacklo_epi16(a0, a1);                                     /* Columns 0-3 of rows 0-3. */
+        __m128i b1 = _mm_unpackhi_epi16(a0, a1);                                     /* Columns 4-7 of rows 0-3. */
+        __m128i b2 = _mm_unpacklo_epi16(a2, a3);
+        __m128i b3 = _mm_unpackhi_epi16(a2, a3);
+
+        uint8_t* d = dst + x * dstride + y;
+
+        sse2_store_halves(d + 0 * dstride, d + 1 * dstride, _mm_unpacklo_epi32(b0, b2));
+        sse2_store_halves(d + 2 * dstride, d + 3 * dstride, _mm_unpackhi_epi32(b0, b2));
+        sse2_store_halves(d + 4 * dstride, d + 5 * dstride, _mm_unpacklo_epi32(b1, b3));
+        sse2_store_halves(d + 6 * dstride, d + 7 * dstride, _mm_unpackhi_epi32(b1, b3));
+      }
+    }
+
+    simd_transpose_tail(src, sstride, dst, dstride, 1, w8, w, 0, h);
+    simd_transpose_tail(src, sstride, dst, dstride, 1, 0, w8, h8, h);
+  }
+
+  void rotate_transpose_u16_sse2(const uint8_t* src, ptrdiff_t sstride, uint8_t* dst, ptrdiff_t dstride, int w, int h) {
+
+    int w8 = w & ~7;
+    int h8 = h & ~7;
+
+    for (int y = 0; y < h8; y += 8) {
+
+      const uint8_t* s = src + y * sstride;
+
+      for (int x = 0; x < w8; x += 8) {
+
+        __m128i r0 = _mm_loadu_si128((const __m128i*)(s + 0 * sstride + 2 * x));
+        __m128i r1 = _mm_loadu_si128((const __m128i*)(s + 1 * sstride + 2 * x));
+        __m128i r2 = _mm_loadu_si128((const __m128i*)(s + 2 * sstride + 2 * x));
+        __m128i r3 = _mm_loadu_si128((const __m128i*)(s + 3 * sstride + 2 * x));
+        __m128i r4 = _mm_loadu_si128((const __m128i*)(s + 4 * sstride + 2 * x));
+        __m128i r5 = _mm_loadu_si128((const __m128i*)(s + 5 * sstride + 2 * x));
+        __m128i r6 = _mm_loadu_si128((const __m128i*)(s + 6 * sstride + 2 * x));
+        __m128i r7 = _mm_loadu_si128((const __m128i*)(s + 7 * sstride + 2 * x));
+
+        __m128i a0 = _mm_unpacklo_epi16(r0, r1);
+        __m128i a1 = _mm_unpackhi_epi16(r0, r1);
+        __m128i a2 = _mm_unpacklo_epi16(r2, r3);
+        __m128i a3 = _mm_unpackhi_epi16(r2, r3);
+        __m128i a4 = _mm_unpacklo_epi16(r4, r5);
+        __m128i a5 = _mm_unpackhi_epi16(r4, r5);
+        __m128i a6 = _mm_unpacklo_epi16(r6, r7);
+        __m128i a7 = _mm_unpackhi_epi16(r6, r7);
+
+        __m128i b0 = _mm_unpacklo_epi32(a0, a2);                                     /* Columns 0-1 of rows 0-3. */
+        __m128i b1 = _mm_unpackhi_epi32(a0, a2);                                     /* Columns 2-3 of rows 0-3. */
+        __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+        __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+        __m128i b4 = _mm_unpacklo_epi32(a4, a6);                                     /* Columns 0-1 of rows 4-7. */
+        __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+        __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+        __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+        uint8_t* d = dst + x * dstride + 2 * y;
+
+        _mm_storeu_si128((__m128i*)(d + 0 * dstride), _mm_unpacklo_epi64(b0, b4));
+        _mm_storeu_si128((__m128i*)(d + 1 * dstride), _mm_unpackhi_epi64(b0, b4));
+        _mm_storeu_si128((__m128i*)(d + 2 * dstride), _mm_unpacklo_epi64(b1, b5));
+        _mm_storeu_si128((__m128i*)(d + 3 * dstride), _mm_unpackhi_epi64(b1, b5));
+        _mm_storeu_si128((__m128i*)(d + 4 * dstride), _mm_unpacklo_epi64(b2, b6));
+        _mm_storeu_si128((__m128i*)(d + 5 * dstride), _mm_unpackhi_epi64(b2, b6));
+        _mm_storeu_si128((__m128i*)(d + 6 * dstride), _mm_unpacklo_epi64(b3, b7));
+        _mm_storeu_si128((__m128i*)(d + 7 * dstride), _mm_unpackhi_epi64(b3, b7));
+      }
+    }
+
+    simd_transpose_tail(src, sstride, dst, dstride, 2, w8, w, 0, h);
+    simd_transpose_tail(src, sstride, dst, dstride, 2, 0, w8, h8, h);
+  }
+
+  void rotate_transpose_u32_sse2(const uint8_t* src, ptrdiff_t sstride, uint8_t* dst, ptrdiff_t dstride, int w, int h) {
+
+    int w4 = w & ~3;
+    int h4 = h & ~3;
+
+    for (int y = 0; y < h4; y += 4) {
+
+      const uint8_t* s = src + y * sstride;
+
+      for (int x = 0; x < w4; x += 4) {
+
+        __m128i r0 = _mm_loadu_si128((const __m128i*)(s + 0 * sstride + 4 * x));
+        __m128i r1 = _mm_loadu_si128((const __m128i*)(s + 1 * sstride + 4 * x));
+        __m128i r2 = _mm_loadu_si128((const __m128i*)(s + 2 * sstride + 4 * x));
+        __m128i r3 = _mm_loadu_si128((const __m128i*)(s + 3 * sstride + 4 * x));
+
+        __m128i a0 = _mm_unpacklo_epi32(r0, r1);                                     /* Columns 0-1 of rows 0-1. */
+        __m128i a1 = _mm_unpacklo_epi32(r2, r3);
+        __m128i a2 = _mm_unpackhi_epi32(r0, r1);                                     /* Columns 2-3 of rows 0-1. */
+        __m128i a3 = _mm_unpackhi_epi32(r2, r3);
+
+        uint8_t* d = dst + x * dstride + 4 * y;
+
+        _mm_storeu_si128((__m128i*)(d + 0 * dstride), _mm_unpacklo_epi64(a0, a1));
+        _mm_storeu_si128((__m128i*)(d + 1 * dstride), _mm_unpackhi_epi64(a0, a1));
+        _mm_storeu_si128((__m128i*)(d + 2 * dstride), _mm_unpacklo_epi64(a2, a3));
+        _mm_storeu_si128((__m128i*)(d + 3 * dstride), _mm_unpackhi_epi64(a2, a3));
+      }
+    }
+
+    simd_transpose_tail(src, sstride, dst, dstride, 4, w4, w, 0, h);
+    simd_transpose_tail(src, sstride, dst, dstride, 4, 0, w4, h4, h);
+  }
+
+} /* namespace ca */
+
+#endif
@@ -0,0 +1,552 @@
+#include <string.h>
+#include <videocapture/synthetic/SyntheticPattern.h>
+
+#define SYNTHETIC_MARGIN_X 256                                                      /* The horizontal room the gradient and noise move in; the gradient repeats every 256 pixels. */
+#define SYNTHETIC_MARGIN_Y 64                                                       /* The vertical room the noise moves in. */
+#define SYNTHETIC_GRADIENT_STEP 4                                                   /* The number of pixels the gradient moves per frame. */
+#define SYNTHETIC_COUNTER_BITS 32                                                   /* The number of blocks in the counter. */
+
+namespace ca {
+
+  /* ------------------------------------------------------------------------- */
+
+  static int synthetic_num_planes(int fmt);
+  static int synthetic_row_divisor(int fmt, int plane);
+  static size_t synthetic_column_offset(int fmt, int plane, int x);
+  static int synthetic_block_size(int width);
+  static bool synthetic_is_full_range(int fmt);
+  static bool synthetic_is_rgb(int fmt);
+  static uint32_t synthetic_hash(uint32_t v);
+
+  /* ------------------------------------------------------------------------- */
+
+  SyntheticPattern::SyntheticPattern()
+    :pattern(CA_NONE)
+    ,width(0)
+    ,height(0)
+    ,pixel_format(CA_NONE)
+    ,margin_x(0)
+    ,margin_y(0)
+    ,block_size(0)
+    ,has_saved(false)
+  {
+  }
+
+  SyntheticPattern::~SyntheticPattern() {
+    shutdown();
+  }
+
+  int SyntheticPattern::init(int ptrn, int w, int h, int fmt) {
+
+    size_t nsaved = 0;
+
+    if (0 != data.size()) {
+      printf("Error: the synthetic pattern is already initialized.\n");
+      return -1;
+    }
+
+    if (0 > ptrn || CA_PATTERN_COUNT <= ptrn) {
+      printf("Error: invalid synthetic pattern: %d.\n", ptrn);
+      return -2;
+    }
+
+    if (false == synthetic_is_supported(fmt)) {
+      printf("Error: we can't generate frames in %d.\n", fmt);
+      return -3;
+    }
+
+    /* Chroma is subsampled in pairs and the counter must fit. */
+    if (64 > w || 0 != (w & 1) || 8 > h || 0 != (h & 1)) {
+      printf("Error: invalid size for a synthetic frame: %dx%d; it must be even and at least 64x8.\n", w, h);
+      return -4;
+    }
+
+    pattern = ptrn;
+    width = w;
+    height = h;
+    pixel_format = fmt;
+    block_size = synthetic_block_size(w);
+    margin_x = (CA_PATTERN_BARS == ptrn) ? 0 : SYNTHETIC_MARGIN_X;
+    margin_y = (CA_PATTERN_NOISE == ptrn) ? SYNTHETIC_MARGIN_Y : 0;
+
+    if (0 != frame.setup(width, height, fmt)
+        || 0 != templ.setup(width + margin_x, height + margin_y, fmt))
+      {
+        shutdown();
+        return -5;
+      }
+
+    data.resize(templ.nbytes);
+    templ.setPixels(&data[0]);
+
+    for (int i = 0; i < synthetic_num_planes(fmt); ++i) {
+      nsaved += synthetic_column_offset(fmt, i, SYNTHETIC_COUNTER_BITS * block_size) * (block_size / synthetic_row_divisor(fmt, i));
+    }
+
+    saved.resize(nsaved);
+    has_saved = false;
+
+    return render();
+  }
+
+  int SyntheticPattern::shutdown() {
+
+    data.clear();
+    saved.clear();
+    has_saved = false;
+    pattern = CA_NONE;
+    width = 0;
+    height = 0;
+
+    return 0;
+  }
+
+  int SyntheticPattern::nextFrame(uint32_t counter, PixelBuffer& buffer) {
+
+    int x = 0;
+    int y = 0;
+    void* user = buffer.user;
+
+    if (0 == data.size()) {
+      printf("Error: the synthetic pattern is not initialized.\n");
+      return -1;
+    }
+
+    if (true == has_saved) {
+      restoreCounter();
+    }
+
+    getOrigin(counter, x, y);
+
+    for (int i = 0; i < synthetic_num_planes(pixel_format); ++i) {
+      frame.stride[i] = templ.stride[i];
+      frame.plane[i] = templ.plane[i]
+        + (y / synthetic_row_divisor(pixel_format, i)) * templ.stride[i]
+        + synthetic_column_offset(pixel_format, i, x);
+      frame.offset[i] = frame.plane[i] - frame.plane[0];
+    }
+
+    frame.pixels = frame.plane[0];
+
+    saveCounter();
+    writeCounter(counter);
+    has_saved = true;
+
+    buffer = frame;
+    buffer.user = user;
+    buffer.sequence = counter;
+    buffer.timestamp = 0;
+    buffer.decode_time = 0;
+    buffer.receive_time = 0;
+
+    return 0;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  /*
+    We render a row of RGB and pack it into the format. The loops are plain
+    integer math over contiguous arrays, which the compiler vectorizes; this
+    only runs in `init()` anyway.
+   */
+  int SyntheticPattern::render() {
+
+    int tw = width + margin_x;
+    int th = height + margin_y;
+    bool full = synthetic_is_full_range(pixel_format);
+    uint32_t seed = 0x2545F491;
+    std::vector<uint8_t> rgb(tw * 3);
+    std::vector<uint8_t> luma(tw);
+    std::vector<uint8_t> cb(tw / 2);
+    std::vector<uint8_t> cr(tw / 2);
+
+    /* 75% bars: white, yellow, cyan, green, magenta, red, blue, black. */
+    static const uint8_t bars[8][3] = {
+      { 191, 191, 191 }, { 191, 191, 0 }, { 0, 191, 191 }, { 0, 191, 0 },
+      { 191, 0, 191 }, { 191, 0, 0 }, { 0, 0, 191 }, { 0, 0, 0 }
+    };
+
+    for (int y = 0; y < th; ++y) {
+
+      uint8_t* p = &rgb[0];
+
+      if (CA_PATTERN_BARS == pattern) {
+        for (int x = 0; x < tw; ++x) {
+          int bar = (x * 8) / width;
+          p[3 * x + 0] = bars[bar][0];
+          p[3 * x + 1] = bars[bar][1];
+          p[3 * x + 2] = bars[bar][2];
+        }
+      }
+      else if (CA_PATTERN_GRADIENT == pattern) {
+        uint8_t g = (uint8_t)((y * 255) / (th - 1));
+        for (int x = 0; x < tw; ++x) {
+          p[3 * x + 0] = (uint8_t)(x & 0xFF);
+          p[3 * x + 1] = g;
+          p[3 * x + 2] = (uint8_t)(255 - (x & 0xFF));
+        }
+      }
+      else {
+        /* xorshift32 */
+        for (int x = 0; x < tw; ++x) {
+          seed ^= seed << 13;
+          seed ^= seed >> 17;
+          seed ^= seed << 5;
+          p[3 * x + 0] = (uint8_t)(seed);
+          p[3 * x + 1] = (uint8_t)(seed >> 8);
+          p[3 * x + 2] = (uint8_t)(seed >> 16);
+        }
+      }
+
+      if (true == synthetic_is_rgb(pixel_format)) {
+
+        uint8_t* dst = templ.plane[0] + y * templ.stride[0];
+
+        for (int x = 0; x < tw; ++x) {
+          uint8_t r = p[3 * x + 0];
+          uint8_t g = p[3 * x + 1];
+          uint8_t b = p[3 * x + 2];
+          switch (pixel_format) {
+            case CA_RGB24:  { dst[3 * x + 0] = r; dst[3 * x + 1] = g; dst[3 * x + 2] = b; break; }
+            case CA_BGRA32: { dst[4 * x + 0] = b; dst[4 * x + 1] = g; dst[4 * x + 2] = r; dst[4 * x + 3] = 255; break; }
+            case CA_RGBA32: { dst[4 * x + 0] = r; dst[4 * x + 1] = g; dst[4 * x + 2] = b; dst[4 * x + 3] = 255; break; }
+            case CA_ARGB32: { dst[4 * x + 0] = 255; dst[4 * x + 1] = r; dst[4 * x + 2] = g; dst[4 * x + 3] = b; break; }
+          }
+        }
+
+        continue;
+      }
+
+      /* BT.601; the chroma of a pair is computed from the average of its two pixels. */
+      for (int x = 0; x < tw; ++x) {
+        int r = p[3 * x + 0];
+        int g = p[3 * x + 1];
+        int b = p[3 * x + 2];
+        luma[x] = (true == full)
+          ? (uint8_t)((77 * r + 150 * g + 29 * b + 128) >> 8)
+          : (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+      }
+
+      for (int x = 0; x < tw / 2; ++x) {
+        int r = (p[6 * x + 0] + p[6 * x + 3] + 1) >> 1;
+        int g = (p[6 * x + 1] + p[6 * x + 4] + 1) >> 1;
+        int b = (p[6 * x + 2] + p[6 * x + 5] + 1) >> 1;
+        if (true == full) {
+          cb[x] = (uint8_t)(((-43 * r - 85 * g + 128 * b + 128) >> 8) + 128);
+          cr[x] = (uint8_t)(((128 * r - 107 * g - 21 * b + 128) >> 8) + 128);
+        }
+        else {
+          cb[x] = (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+          cr[x] = (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+      }
+
+      switch (pixel_format) {
+
+        case CA_YUYV422:
+        case CA_UYVY422: {
+          uint8_t* dst = templ.plane[0] + y * templ.stride[0];
+          int yo = (CA_YUYV422 == pixel_format) ? 0 : 1;
+          int co = (CA_YUYV422 == pixel_format) ? 1 : 0;
+          for (int x = 0; x < tw / 2; ++x) {
+            dst[4 * x + yo] = luma[2 * x];
+            dst[4 * x + yo + 2] = luma[2 * x + 1];
+            dst[4 * x + co] = cb[x];
+            dst[4 * x + co + 2] = cr[x];
+          }
+          break;
+        }
+
+        case CA_YUV420BP:
+        case CA_YUVJ420BP: {
+          memcpy(templ.plane[0] + y * templ.stride[0], &luma[0], tw);
+          if (0 == (y & 1)) {
+            uint8_t* dst = templ.plane[1] + (y / 2) * templ.stride[1];
+            for (int x = 0; x < tw / 2; ++x) {
+              dst[2 * x + 0] = cb[x];
+              dst[2 * x + 1] = cr[x];
+            }
+          }
+          break;
+        }
+
+        default: {
+          int div = synthetic_row_divisor(pixel_format, 1);
+          memcpy(templ.plane[0] + y * templ.stride[0], &luma[0], tw);
+          if (0 == (y % div)) {
+            memcpy(templ.plane[1] + (y / div) * templ.stride[1], &cb[0], tw / 2);
+            memcpy(templ.plane[2] + (y / div) * templ.stride[2], &cr[0], tw / 2);
+          }
+          break;
+        }
+      }
+    }
+
+    return 0;
+  }
+
+  void SyntheticPattern::getOrigin(uint32_t counter, int& x, int& y) {
+
+    uint32_t h = 0;
+
+    x = 0;
+    y = 0;
+
+    if (CA_PATTERN_GRADIENT == pattern) {
+      x = (int)((counter * SYNTHETIC_GRADIENT_STEP) % (uint32_t)margin_x);
+    }
+    else if (CA_PATTERN_NOISE == pattern) {
+      /* Even, so the chroma of 4:2:x formats stays aligned. */
+      h = synthetic_hash(counter);
+      x = (int)((h & 0xFFFF) % (uint32_t)margin_x) & ~1;
+      y = (int)((h >> 16) % (uint32_t)margin_y) & ~1;
+    }
+  }
+
+  void SyntheticPattern::saveCounter() {
+
+    uint8_t* dst = &saved[0];
+
+    for (int i = 0; i < synthetic_num_planes(pixel_format); ++i) {
+      size_t nbytes = synthetic_column_offset(pixel_format, i, SYNTHETIC_COUNTER_BITS * block_size);
+      int rows = block_size / synthetic_row_divisor(pixel_format, i);
+      for (int r = 0; r < rows; ++r) {
+        memcpy(dst, frame.plane[i] + r * frame.stride[i], nbytes);
+        dst += nbytes;
+      }
+    }
+  }
+
+  void SyntheticPattern::restoreCounter() {
+
+    const uint8_t* src = &saved[0];
+
+    for (int i = 0; i < synthetic_num_planes(pixel_format); ++i) {
+      size_t nbytes = synthetic_column_offset(pixel_format, i, SYNTHETIC_COUNTER_BITS * block_size);
+      int rows = block_size / synthetic_row_divisor(pixel_format, i);
+      for (int r = 0; r < rows; ++r) {
+        memcpy(frame.plane[i] + r * frame.stride[i], src, nbytes);
+        src += nbytes;
+      }
+    }
+
+    has_saved = false;
+  }
+
+  /* White and black blocks with neutral chroma, so the counter survives conversions. */
+  void SyntheticPattern::writeCounter(uint32_t counter) {
+
+    bool rgb = synthetic_is_rgb(pixel_format);
+    bool full = (true == rgb || true == synthetic_is_full_range(pixel_format));
+    uint8_t white = (true == full) ? 255 : 235;
+    uint8_t black = (true == full) ? 0 : 16;
+    int nplanes = synthetic_num_planes(pixel_format);
+    int b = block_size;
+
+    /* The chroma planes of planar formats. */
+    for (int i = 1; i < nplanes; ++i) {
+      size_t nbytes = synthetic_column_offset(pixel_format, i, SYNTHETIC_COUNTER_BITS * b);
+      int rows = b / synthetic_row_divisor(pixel_format, i);
+      for (int r = 0; r < rows; ++r) {
+        memset(frame.plane[i] + r * frame.stride[i], 128, nbytes);
+      }
+    }
+
+    for (int bit = 0; bit < SYNTHETIC_COUNTER_BITS; ++bit) {
+
+      uint8_t v = ((counter >> bit) & 1) ? white : black;
+      int x0 = bit * b;
+
+      for (int r = 0; r < b; ++r) {
+
+        uint8_t* row = frame.plane[0] + r * frame.stride[0];
+
+        switch (pixel_format) {
+          case CA_YUYV422: {
+            for (int x = x0; x < x0 + b; x += 2) {
+              row[2 * x + 0] = v; row[2 * x + 1] = 128; row[2 * x + 2] = v; row[2 * x + 3] = 128;
+            }
+            break;
+          }
+          case CA_UYVY422: {
+            for (int x = x0; x < x0 + b; x += 2) {
+              row[2 * x + 0] = 128; row[2 * x + 1] = v; row[2 * x + 2] = 128; row[2 * x + 3] = v;
+            }
+            break;
+          }
+          case CA_RGB24: {
+            memset(row + 3 * x0, v, 3 * b);
+            break;
+          }
+          case CA_BGRA32:
+          case CA_RGBA32:
+          case CA_ARGB32: {
+            int alpha = (CA_ARGB32 == pixel_format) ? 0 : 3;
+            memset(row + 4 * x0, v, 4 * b);
+            for (int x = x0; x < x0 + b; ++x) {
+              row[4 * x + alpha] = 255;
+            }
+            break;
+          }
+          default: {
+            memset(row + x0, v, b);
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  bool synthetic_is_supported(int fmt) {
+
+    switch (fmt) {
+      case CA_UYVY422:
+      case CA_YUYV422:
+      case CA_YUV422P:
+      case CA_YUV420P:
+      case CA_YUV420BP:
+      case CA_YUVJ420P:
+      case CA_YUVJ420BP:
+      case CA_ARGB32:
+      case CA_BGRA32:
+      case CA_RGBA32:
+      case CA_RGB24: {
+        return true;
+      }
+      default: {
+        return false;
+      }
+    }
+  }
+
+  int synthetic_read_counter(const PixelBuffer& buffer, uint32_t& counter) {
+
+    int fmt = buffer.pixel_format;
+    int b = synthetic_block_size((int)buffer.width[0]);
+    size_t step = 1;
+    size_t offset = 0;
+    const uint8_t* row = buffer.plane[0];
+
+    counter = 0;
+
+    if (false == synthetic_is_supported(fmt) || NULL == row || 64 > buffer.width[0] || (size_t)b > buffer.height[0]) {
+      return -1;
+    }
+
+    /* The byte we sample: luma for YUV, green for RGB. */
+    switch (fmt) {
+      case CA_YUYV422: { step = 2; offset = 0; break; }
+      case CA_UYVY422: { step = 2; offset = 1; break; }
+      case CA_RGB24:   { step = 3; offset = 1; break; }
+      case CA_ARGB32:  { step = 4; offset = 2; break; }
+      case CA_BGRA32:
+      case CA_RGBA32:  { step = 4; offset = 1; break; }
+      default:         { step = 1; offset = 0; break; }
+    }
+
+    row += (b / 2) * buffer.stride[0];
+
+    for (int bit = 0; bit < SYNTHETIC_COUNTER_BITS; ++bit) {
+      size_t x = bit * b + b / 2;
+      if (128 <= row[x * step + offset]) {
+        counter |= (1u << bit);
+      }
+    }
+
+    return 0;
+  }
+
+  /* ------------------------------------------------------------------------- */
+
+  static int synthetic_num_planes(int fmt) {
+
+    switch (fmt) {
+      case CA_YUV420P:
+      case CA_YUVJ420P:
+      case CA_YUV422P: {
+        return 3;
+      }
+      case CA_YUV420BP:
+      case CA_YUVJ420BP: {
+        return 2;
+      }
+      default: {
+        return 1;
+      }
+    }
+  }
+
+  /* The number of rows that share a row of the plane. */
+  static int synthetic_row_divisor(int fmt, int plane) {
+
+    if (0 == plane || CA_YUV422P == fmt) {
+      return 1;
+    }
+
+    return (1 < synthetic_num_planes(fmt)) ? 2 : 1;
+  }
+
+  /* The byte offset of pixel `x` (even) in a row of `plane`. */
+  static size_t synthetic_column_offset(int fmt, int plane, int x) {
+
+    switch (fmt) {
+      case CA_YUYV422:
+      case CA_UYVY422: {
+        return (size_t)x * 2;
+      }
+      case CA_RGB24: {
+        return (size_t)x * 3;
+      }
+      case CA_ARGB32:
+      case CA_BGRA32:
+      case CA_RGBA32: {
+        return (size_t)x * 4;
+      }
+      case CA_YUV420BP:
+      case CA_YUVJ420BP: {
+        return (size_t)x;
+      }
+      default: {
+        return (0 == plane) ? (size_t)x : (size_t)(x / 2);
+      }
+    }
+  }
+
+  static int synthetic_block_size(int width) {
+
+    int b = width / SYNTHETIC_COUNTER_BITS;
+
+    if (8 < b) {
+      b = 8;
+    }
+
+    if (2 > b) {
+      b = 2;
+    }
+
+    return b & ~1;
+  }
+
+  static bool synthetic_is_full_range(int fmt) {
+    return CA_YUVJ420P == fmt || CA_YUVJ420BP == fmt;
+  }
+
+  static bool synthetic_is_rgb(int fmt) {
+    return CA_RGB24 == fmt || CA_BGRA32 == fmt || CA_RGBA32 == fmt || CA_ARGB32 == fmt;
+  }
+
+  /* Spreads the frame counter over all bits, so the noise jumps around. */
+  static uint32_t synthetic_hash(uint32_t v) {
+
+    v ^= v >> 16;
+    v *= 0x7FEB352D;
+    v ^= v >> 15;
+    v *= 0x846CA68B;
+    v ^= v >> 16;
+
+    return v;
+  }
+
+} /* namespace ca */
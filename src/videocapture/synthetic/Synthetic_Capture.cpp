@@ -0,0 +1,261 @@
+#include <videocapture/Utils.h>
+#include <videocapture/synthetic/Synthetic_Capture.h>
+
+namespace ca {
+
+  /* INTERFACE IMPLEMENTATION */
+  /* -------------------------------------- */
+  Synthetic_Capture::Synthetic_Capture(frame_callback fc, void* user)
+    :Base(fc, user)
+    ,state(CA_STATE_NONE)
+    ,must_sync(true)
+    ,frame_duration(0)
+    ,next_time(0)
+    ,num_frames(0)
+    ,num_delivered(0)
+    ,num_dropped(0)
+  {
+    static const int sizes[][2] = { { 640, 480 }, { 1280, 720 }, { 1920, 1080 }, { 3840, 2160 } };
+    static const int rates[] = { CA_FPS_30_00, CA_FPS_60_00 };
+    static const int formats[] = {
+      CA_YUYV422, CA_UYVY422, CA_YUV422P, CA_YUV420P, CA_YUVJ420P, CA_YUV420BP,
+      CA_YUVJ420BP, CA_RGB24, CA_BGRA32, CA_RGBA32, CA_ARGB32
+    };
+
+    pixel_buffer.user = user;
+    pipeline.stats = &stats;
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+      for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f) {
+        for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); ++r) {
+          addCapability(sizes[s][0], sizes[s][1], formats[f], rates[r]);
+        }
+      }
+    }
+  }
+
+  Synthetic_Capture::~Synthetic_Capture() {
+
+    if (state & CA_STATE_CAPTUREING) {
+      stop();
+    }
+
+    if (state & CA_STATE_OPENED) {
+      close();
+    }
+
+    state = CA_STATE_NONE;
+    pixel_buffer.user = NULL;
+  }
+
+  int Synthetic_Capture::open(Settings settings) {
+
+    if (state & CA_STATE_OPENED) {
+      printf("Error: already opened.\n");
+      return -1;
+    }
+
+    if (0 > settings.device || CA_PATTERN_COUNT <= settings.device) {
+      printf("Error: device index is invalid.\n");
+      return -2;
+    }
+
+    if (0 > settings.capability || settings.capability >= (int)capabilities.size()) {
+      printf("Error: capability index is invalid.\n");
+      return -3;
+    }
+
+    Capability& cap = capabilities[settings.capability];
+
+    if (0 != pattern.init(settings.device, cap.width, cap.height, cap.pixel_format)) {
+      return -4;
+    }
+
+    if (pipeline.init(cap.width, cap.height, cap.pixel_format, settings.format, settings.rotation,
+                      settings.jpeg_scale, settings.decode_threads, settings.drop_policy, settings.decode_thread_type) < 0)
+      {
+        pattern.shutdown();
+        return -5;
+      }
+
+    frame_duration = 100000000000ull / (uint64_t)cap.fps;
+    must_sync = true;
+    num_frames = 0;
+    num_delivered = 0;
+    num_dropped = 0;
+    stats.reset();
+
+    state |= CA_STATE_OPENED;
+
+    return 1;
+  }
+
+  int Synthetic_Capture::close() {
+
+    if ((state & CA_STATE_OPENED) != CA_STATE_OPENED) {
+      printf("Error: cannot close the synthetic capture because it's not opened.\n");
+      return -1;
+    }
+
+    pipeline.shutdown();
+    pattern.shutdown();
+
+    state &= ~CA_STATE_OPENED;
+
+    return 1;
+  }
+
+  int Synthetic_Capture::start() {
+
+    if (state & CA_STATE_CAPTUREING) {
+      printf("Error: we are already captureing. Cannot start again.\n");
+      return -1;
+    }
+
+    if ((state & CA_STATE_OPENED) != CA_STATE_OPENED) {
+      printf("Error: not yet opened.\n");
+      return -2;
+    }
+
+    must_sync = true;
+    state |= CA_STATE_CAPTUREING;
+
+    return 1;
+  }
+
+  int Synthetic_Capture::stop() {
+
+    if ((state & CA_STATE_CAPTUREING) != CA_STATE_CAPTUREING) {
+      printf("Error: cannot stop captureing because we didn't start captureing yet.\n");
+      return -1;
+    }
+
+    state &= ~CA_STATE_CAPTUREING;
+
+    return 1;
+  }
+
+  void Synthetic_Capture::update() {
+
+    if ((state & CA_STATE_CAPTUREING) != CA_STATE_CAPTUREING) {
+      return;
+    }
+
+    uint64_t now = time_now_ns();
+
+    if (true == must_sync) {
+      next_time = now;
+      must_sync = false;
+    }
+
+    if (now >= next_time) {
+
+      /* Like a camera with CA_SYNTHETIC_MAX_QUEUED buffers: the older frames were overwritten. */
+      uint64_t ndue = (now - next_time) / frame_duration + 1;
+
+      if (CA_SYNTHETIC_MAX_QUEUED < ndue) {
+        uint64_t nskip = ndue - CA_SYNTHETIC_MAX_QUEUED;
+        num_frames += nskip;
+        num_dropped += nskip;
+        next_time += nskip * frame_duration;
+      }
+
+      while (now >= next_time) {
+
+        if (cb_frame && 0 == pattern.nextFrame((uint32_t)num_frames, pixel_buffer)) {
+          pixel_buffer.sequence = num_frames;
+          pixel_buffer.timestamp = next_time;
+          pixel_buffer.receive_time = now;
+          stats.recordLatency(CA_LATENCY_DEQUEUE, now - next_time);
+          pipeline.process(pixel_buffer, cb_frame);
+          num_delivered++;
+        }
+
+        num_frames++;
+        next_time += frame_duration;
+      }
+    }
+
+    /* Deliver the frames that our worker threads finished, see `Settings.decode_threads`. */
+    if (cb_frame) {
+      pipeline.poll(cb_frame);
+    }
+  }
+
+  std::vector<Capability> Synthetic_Capture::getCapabilities(int device) {
+
+    if (0 > device || CA_PATTERN_COUNT <= device) {
+      printf("Error: invalid synthetic device index: %d.\n", device);
+      return std::vector<Capability>();
+    }
+
+    return capabilities;
+  }
+
+  std::vector<Device> Synthetic_Capture::getDevices() {
+
+    static const char* names[] = { "Synthetic: color bars", "Synthetic: moving gradient", "Synthetic: noise" };
+    std::vector<Device> result;
+
+    for (int i = 0; i < CA_PATTERN_COUNT; ++i) {
+      Device dev;
+      dev.index = i;
+      dev.name = names[i];
+      result.push_back(dev);
+    }
+
+    return result;
+  }
+
+  std::vector<Format> Synthetic_Capture::getOutputFormats() {
+
+    /* We generate every raw format ourself; the pipeline adds nothing to that. */
+    static const int formats[] = {
+      CA_YUYV422, CA_UYVY422, CA_YUV422P, CA_YUV420P, CA_YUVJ420P, CA_YUV420BP,
+      CA_YUVJ420BP, CA_RGB24, CA_BGRA32, CA_RGBA32, CA_ARGB32
+    };
+
+    std::vector<Format> result;
+
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); ++i) {
+      Format fmt;
+      fmt.format = formats[i];
+      fmt.index = result.size();
+      result.push_back(fmt);
+    }
+
+    return result;
+  }
+
+  /* SYNTHETIC */
+  /* -------------------------------------- */
+
+  int Synthetic_Capture::addCapability(int width, int height, int fmt, int fps) {
+
+    if (false == synthetic_is_supported(fmt)) {
+      printf("Error: we can't generate frames in %s.\n", format_to_string(fmt).c_str());
+      return -1;
+    }
+
+    if (64 > width || 0 != (width & 1) || 8 > height || 0 != (height & 1)) {
+      printf("Error: invalid size for a synthetic capability: %dx%d; it must be even and at least 64x8.\n", width, height);
+      return -2;
+    }
+
+    if (0 >= fps) {
+      printf("Error: invalid frame rate for a synthetic capability: %d.\n", fps);
+      return -3;
+    }
+
+    Capability cap(width, height, fmt);
+    cap.fps = fps;
+    cap.capability_index = capabilities.size();
+    cap.fps_index = 0;
+    cap.pixel_format_index = 0;
+    cap.description = "Synthetic";
+    capabilities.push_back(cap);
+
+    return cap.capability_index;
+  }
+
+} /* namespace ca */
@@ -69,6 +69,9 @@ namespace ca {
       DWORD count = 0;
       sample->GetBufferCount(&count);
 
+      /* The sample time is in 100 ns units; Media Foundation has no sequence numbers so we can't count drops. */
+      cap->stats.frameCaptured((uint64_t)timestamp * 100ull);
+
       for(DWORD i = 0; i < count; ++i) {
 
         hr = sample->GetBufferByIndex(i, &buffer);
@@ -85,7 +88,9 @@ namespace ca {
           cap->pixel_buffer.plane[0] = data;
           cap->pixel_buffer.plane[1] = data + cap->pixel_buffer.offset[1];
           cap->pixel_buffer.plane[2] = data + cap->pixel_buffer.offset[2];
+          uint64_t start = time_now_ns();
           cap->cb_frame(cap->pixel_buffer);
+          cap->stats.frameDelivered(start, time_now_ns());
 
           buffer->Unlock();
           buffer->Release();
@@ -138,6 +138,7 @@ namespace ca {
 
     pixel_buffer.user = cb_user;
 
+    stats.reset();
     state |= CA_STATE_OPENED;
 
     return 1;